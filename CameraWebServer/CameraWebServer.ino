@@ -1,10 +1,21 @@
 #include "esp_camera.h"
+#include "esp_heap_caps.h"
 #include <WiFi.h>
 
 // ===========================
 // Select camera model in board_config.h
 // ===========================
 #include "board_config.h"
+#include "drone_pose.h"
+#include "frame_stream.h"
+#include "frame_pipeline.h"
+#include "still_capture.h"
+#include "memory_stats.h"
+#include "jpeg_pool.h"
+#include "wifi_link.h"
+#include "sd_recorder.h"
+#include "sensor_profile.h"
+#include "control_channel.h"
 
 // ===========================
 // Enter your WiFi credentials
@@ -15,11 +26,35 @@ const char *password = "12345678";
 void startCameraServer();
 void setupLedFlash();
 
+#if CAMERA_FB_INTERNAL
+// Initializes the camera with its frame buffers in internal RAM (see board_config.h).
+static esp_err_t initCameraInternal(const camera_config_t *psram_config) {
+  camera_config_t config = *psram_config;
+  config.frame_size = CAMERA_FB_INTERNAL_FRAMESIZE;
+  config.fb_location = CAMERA_FB_IN_DRAM;
+  esp_err_t err = esp_camera_init(&config);
+  if (err == ESP_OK && heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) < CAMERA_FB_INTERNAL_HEADROOM) {
+    esp_camera_deinit();
+    err = ESP_ERR_NO_MEM;
+  }
+  if (err != ESP_OK) {
+    Serial.println("Frame buffers do not fit in internal RAM, using PSRAM");
+    return err;
+  }
+  framePipelineSetMaxFramesize(CAMERA_FB_INTERNAL_FRAMESIZE);
+  Serial.println("Frame buffers in internal RAM");
+  return ESP_OK;
+}
+#endif
+
 void setup() {
   Serial.begin(115200);
   Serial.setDebugOutput(true);
   Serial.println();
 
+  // associates while the camera initializes
+  startWifiLink(ssid, password);
+
   camera_config_t config;
   config.ledc_channel = LEDC_CHANNEL_0;
   config.ledc_timer = LEDC_TIMER_0;
@@ -52,8 +87,10 @@ void setup() {
   //                      for larger pre-allocated frame buffer.
   if (config.pixel_format == PIXFORMAT_JPEG) {
     if (psramFound()) {
+      // buffers sized for UXGA so ROI crops fit, the stream drops to QVGA after init
+      config.frame_size = FRAMESIZE_UXGA;
       config.jpeg_quality = 10;
-      config.fb_count = 2;
+      config.fb_count = CAMERA_FB_COUNT;
       config.grab_mode = CAMERA_GRAB_LATEST;
     } else {
       // Limit the frame size when PSRAM is not available
@@ -74,7 +111,15 @@ void setup() {
 #endif
 
   // camera init
-  esp_err_t err = esp_camera_init(&config);
+  esp_err_t err = ESP_FAIL;
+#if CAMERA_FB_INTERNAL
+  if (config.pixel_format == PIXFORMAT_JPEG && config.fb_location == CAMERA_FB_IN_PSRAM) {
+    err = initCameraInternal(&config);
+  }
+#endif
+  if (err != ESP_OK) {
+    err = esp_camera_init(&config);
+  }
   if (err != ESP_OK) {
     Serial.printf("Camera init failed with error 0x%x", err);
     return;
@@ -89,7 +134,7 @@ void setup() {
   }
   // drop down frame size for higher initial frame rate
   if (config.pixel_format == PIXFORMAT_JPEG) {
-    s->set_framesize(s, FRAMESIZE_QVGA);
+    s->set_framesize(s, framePipelineMaxFramesize() < FRAMESIZE_QVGA ? framePipelineMaxFramesize() : FRAMESIZE_QVGA);
   }
 
 #if defined(CAMERA_MODEL_M5STACK_WIDE) || defined(CAMERA_MODEL_M5STACK_ESP32CAM)
@@ -106,23 +151,25 @@ void setup() {
   setupLedFlash();
 #endif
 
-  WiFi.begin(ssid, password);
-  WiFi.setSleep(false);
-
-  Serial.print("WiFi connecting");
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
+  startMemoryStats();
+  if (config.pixel_format != PIXFORMAT_JPEG) {
+    startJpegPool();
   }
-  Serial.println("");
-  Serial.println("WiFi connected");
-
+  setupDronePose();
+  startFramePipeline();
+  startSensorProfiles();
+#if SD_RECORDER_ENABLED
+  startSdRecorder();
+#endif
   startCameraServer();
-
-  Serial.print("Camera Ready! Use 'http://");
-  Serial.print(WiFi.localIP());
-  Serial.print(":81/stream");
-  Serial.println("' to connect");
+  startFrameStreamServer();
+  startStillTrigger();
+  startControlChannel();
+
+  // the servers listen on all interfaces, they serve as soon as the link is up
+  Serial.println("Camera Ready! Use 'http://<camera ip>:81/stream' to connect once WiFi is connected");
+  Serial.print("Raw frame stream on tcp port ");
+  Serial.println(FRAME_STREAM_PORT);
 }
 
 void loop() {
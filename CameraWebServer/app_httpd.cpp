@@ -12,14 +12,28 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "esp_http_server.h"
+#include "esp_idf_version.h"
 #include "esp_timer.h"
 #include "esp_camera.h"
+#include "freertos/semphr.h"
 #include "img_converters.h"
 #include "fb_gfx.h"
 #include "esp32-hal-ledc.h"
 #include "sdkconfig.h"
 #include "camera_index.h"
 #include "board_config.h"
+#include "drone_pose.h"
+#include "frame_pipeline.h"
+#include "color_prefilter.h"
+#include "attitude_filter.h"
+#include "quality_control.h"
+#include "still_capture.h"
+#include "camera_status.h"
+#include "memory_stats.h"
+#include "jpeg_pool.h"
+#include "sd_recorder.h"
+#include "sensor_profile.h"
+#include "control_channel.h"
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
@@ -40,9 +54,23 @@ typedef struct {
 } jpg_chunking_t;
 
 #define PART_BOUNDARY "123456789000000000000987654321"
+// Frames up to this size are sent together with their boundary and part header in a single chunk
+#define STREAM_COALESCE_MAX (32 * 1024)
 static const char *_STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" PART_BOUNDARY;
 static const char *_STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
-static const char *_STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %d.%06d\r\n\r\n";
+static const char *_STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %d.%06d\r\nX-Frame-Seq: %u\r\n";
+static const char *_STREAM_POSE = "X-Pose: %.3f,%.3f,%.3f,%.2f,%.2f,%.2f\r\nX-Pose-Seq: %u\r\nX-Pose-Timestamp: %llu\r\nX-Pose-Age: %lld\r\n";
+static const char *_STREAM_LATENCY = "X-Prev-Frame-Seq: %u\r\nX-Prev-Send-Latency: %lld\r\n";
+static const char *_STREAM_COLOR = "X-Color-Ratio: %d\r\n";
+static const char *_STREAM_TILTED = "X-Tilted: 1\r\n";
+static const char *_STREAM_ROI = "X-Roi: %u,%u,%u,%u\r\n";
+static const char *_STREAM_PART_END = "\r\n";
+
+// Frame sequence number, shared by all stream clients so gaps reveal dropped frames
+static uint32_t frame_seq = 0;
+
+// Serializes the sensor settings of /control and of the control channel
+static SemaphoreHandle_t control_lock = NULL;
 
 httpd_handle_t stream_httpd = NULL;
 httpd_handle_t camera_httpd = NULL;
@@ -106,7 +134,9 @@ static esp_err_t bmp_handler(httpd_req_t *req) {
 #if ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_INFO
   uint64_t fr_start = esp_timer_get_time();
 #endif
-  fb = esp_camera_fb_get();
+  int sub = framePipelineSubscribe();
+  fb = framePipelineGet(sub, FRAME_GET_TIMEOUT);
+  framePipelineUnsubscribe(sub);
   if (!fb) {
     log_e("Camera capture failed");
     httpd_resp_send_500(req);
@@ -124,7 +154,7 @@ static esp_err_t bmp_handler(httpd_req_t *req) {
   uint8_t *buf = NULL;
   size_t buf_len = 0;
   bool converted = frame2bmp(fb, &buf, &buf_len);
-  esp_camera_fb_return(fb);
+  framePipelineReturn(fb);
   if (!converted) {
     log_e("BMP Conversion failed");
     httpd_resp_send_500(req);
@@ -158,20 +188,16 @@ static esp_err_t capture_handler(httpd_req_t *req) {
   int64_t fr_start = esp_timer_get_time();
 #endif
 
-#if defined(LED_GPIO_NUM)
-  enable_led(true);
-  vTaskDelay(150 / portTICK_PERIOD_MS);  // The LED needs to be turned on ~150ms before the call to esp_camera_fb_get()
-  fb = esp_camera_fb_get();              // or it won't be visible in the frame. A better way to do this is needed.
-  enable_led(false);
-#else
-  fb = esp_camera_fb_get();
-#endif
+  // Waits for the LED to settle only if it was not armed beforehand through /arm
+  int64_t trigger_us;
+  fb = stillCapture(true, &trigger_us);
 
   if (!fb) {
     log_e("Camera capture failed");
     httpd_resp_send_500(req);
     return ESP_FAIL;
   }
+  stillStore(fb, trigger_us);
 
   httpd_resp_set_type(req, "image/jpeg");
   httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=capture.jpg");
@@ -180,6 +206,9 @@ static esp_err_t capture_handler(httpd_req_t *req) {
   char ts[32];
   snprintf(ts, 32, "%lld.%06ld", fb->timestamp.tv_sec, fb->timestamp.tv_usec);
   httpd_resp_set_hdr(req, "X-Timestamp", (const char *)ts);
+  char trigger_ts[32];
+  snprintf(trigger_ts, 32, "%lld.%06lld", trigger_us / 1000000, trigger_us % 1000000);
+  httpd_resp_set_hdr(req, "X-Trigger-Timestamp", (const char *)trigger_ts);
 
 #if ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_INFO
   size_t fb_len = 0;
@@ -197,7 +226,7 @@ static esp_err_t capture_handler(httpd_req_t *req) {
     fb_len = jchunk.len;
 #endif
   }
-  esp_camera_fb_return(fb);
+  framePipelineReturn(fb);
 #if ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_INFO
   int64_t fr_end = esp_timer_get_time();
 #endif
@@ -205,18 +234,58 @@ static esp_err_t capture_handler(httpd_req_t *req) {
   return res;
 }
 
-static esp_err_t stream_handler(httpd_req_t *req) {
+// Stream viewers: each one runs in its own task, all fed by the frame pipeline
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+#define STREAM_ASYNC 1
+#endif
+
+typedef struct {
+  httpd_req_t *req;
+  int sub;
+} stream_job_t;
+
+static portMUX_TYPE stream_mux = portMUX_INITIALIZER_UNLOCKED;
+static int active_streams = 0;
+
+// Also called by the raw frame stream (frame_stream.cpp)
+void stream_started(bool started) {
+  portENTER_CRITICAL(&stream_mux);
+  active_streams += started ? 1 : -1;
+  bool first_or_last = started ? active_streams == 1 : active_streams == 0;
+  isStreaming = active_streams > 0;
+  portEXIT_CRITICAL(&stream_mux);
+#if defined(LED_GPIO_NUM)
+  if (first_or_last) {
+    enable_led(started);
+  }
+#else
+  (void)first_or_last;
+#endif
+}
+
+static esp_err_t stream_frames(httpd_req_t *req, int sub) {
   camera_fb_t *fb = NULL;
   struct timeval _timestamp;
   esp_err_t res = ESP_OK;
   size_t _jpg_buf_len = 0;
   uint8_t *_jpg_buf = NULL;
-  char *part_buf[128];
-
-  static int64_t last_frame = 0;
-  if (!last_frame) {
-    last_frame = esp_timer_get_time();
-  }
+  char part_buf[320];
+  size_t hlen = 0;
+  // Staging buffer for boundary + part header + small frames, allocated on first use
+  uint8_t *send_buf = NULL;
+  drone_pose_t pose;
+  int color_ratio = -1;
+  frame_roi_t roi;
+  bool is_roi = false;
+  bool tilted = false;
+  // Time from taking the frame to the end of the body send is only known once the
+  // part is out, so each part reports the figure of the previous part on this connection
+  int64_t fb_get_us = 0;
+  int64_t prev_send_us = -1;
+  uint32_t seq = 0;
+  uint32_t prev_seq = 0;
+
+  int64_t last_frame = esp_timer_get_time();
 
   res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
   if (res != ESP_OK) {
@@ -226,22 +295,27 @@ static esp_err_t stream_handler(httpd_req_t *req) {
   httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
   httpd_resp_set_hdr(req, "X-Framerate", "60");
 
-#if defined(LED_GPIO_NUM)
-  isStreaming = true;
-  enable_led(true);
-#endif
+  stream_started(true);
 
   while (true) {
-    fb = esp_camera_fb_get();
+    fb = framePipelineGet(sub, FRAME_GET_TIMEOUT);
+    fb_get_us = esp_timer_get_time();
+    if (!fb && colorPrefilterMode() == PREFILTER_SKIP) {
+      // nothing passed the color prefilter yet, keep waiting
+      continue;
+    }
     if (!fb) {
       log_e("Camera capture failed");
       res = ESP_FAIL;
     } else {
       _timestamp.tv_sec = fb->timestamp.tv_sec;
       _timestamp.tv_usec = fb->timestamp.tv_usec;
+      color_ratio = framePipelineColorRatio(fb);
+      is_roi = framePipelineFrameRoi(fb, &roi);
+      tilted = framePipelineFrameTilted(fb);
       if (fb->format != PIXFORMAT_JPEG) {
-        bool jpeg_converted = frame2jpg(fb, 80, &_jpg_buf, &_jpg_buf_len);
-        esp_camera_fb_return(fb);
+        bool jpeg_converted = jpegPoolEncode(fb, 80, &_jpg_buf, &_jpg_buf_len);
+        framePipelineReturn(fb);
         fb = NULL;
         if (!jpeg_converted) {
           log_e("JPEG compression failed");
@@ -253,21 +327,50 @@ static esp_err_t stream_handler(httpd_req_t *req) {
       }
     }
     if (res == ESP_OK) {
-      res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
-    }
-    if (res == ESP_OK) {
-      size_t hlen = snprintf((char *)part_buf, 128, _STREAM_PART, _jpg_buf_len, _timestamp.tv_sec, _timestamp.tv_usec);
-      res = httpd_resp_send_chunk(req, (const char *)part_buf, hlen);
-    }
-    if (res == ESP_OK) {
-      res = httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len);
+      hlen = snprintf(part_buf, sizeof(part_buf), "%s", _STREAM_BOUNDARY);
+      hlen += snprintf(part_buf + hlen, sizeof(part_buf) - hlen, _STREAM_PART, _jpg_buf_len, _timestamp.tv_sec, _timestamp.tv_usec, seq = frame_seq++);
+      if (prev_send_us >= 0) {
+        hlen += snprintf(part_buf + hlen, sizeof(part_buf) - hlen, _STREAM_LATENCY, prev_seq, prev_send_us);
+      }
+      if (getDronePose(&pose)) {
+        // age of the pose at capture time, negative if received after the capture
+        int64_t capture_us = (int64_t)_timestamp.tv_sec * 1000000 + _timestamp.tv_usec;
+        hlen += snprintf(
+          part_buf + hlen, sizeof(part_buf) - hlen, _STREAM_POSE, pose.x, pose.y, pose.z, pose.roll, pose.pitch, pose.yaw, pose.seq, pose.timestamp,
+          capture_us - pose.received_us
+        );
+      }
+      if (color_ratio >= 0) {
+        hlen += snprintf(part_buf + hlen, sizeof(part_buf) - hlen, _STREAM_COLOR, color_ratio);
+      }
+      if (tilted) {
+        hlen += snprintf(part_buf + hlen, sizeof(part_buf) - hlen, "%s", _STREAM_TILTED);
+      }
+      if (is_roi) {
+        hlen += snprintf(part_buf + hlen, sizeof(part_buf) - hlen, _STREAM_ROI, roi.x, roi.y, roi.w, roi.h);
+      }
+      hlen += snprintf(part_buf + hlen, sizeof(part_buf) - hlen, "%s", _STREAM_PART_END);
+      if (!send_buf && _jpg_buf_len <= STREAM_COALESCE_MAX) {
+        send_buf = (uint8_t *)malloc(sizeof(part_buf) + STREAM_COALESCE_MAX);
+      }
+      if (send_buf && _jpg_buf_len <= STREAM_COALESCE_MAX) {
+        // one chunk per frame: the copy is cheaper than the framing and socket write it saves
+        memcpy(send_buf, part_buf, hlen);
+        memcpy(send_buf + hlen, _jpg_buf, _jpg_buf_len);
+        res = httpd_resp_send_chunk(req, (const char *)send_buf, hlen + _jpg_buf_len);
+      } else {
+        res = httpd_resp_send_chunk(req, (const char *)part_buf, hlen);
+        if (res == ESP_OK) {
+          res = httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len);
+        }
+      }
     }
     if (fb) {
-      esp_camera_fb_return(fb);
+      framePipelineReturn(fb);
       fb = NULL;
       _jpg_buf = NULL;
     } else if (_jpg_buf) {
-      free(_jpg_buf);
+      jpegPoolRelease(_jpg_buf);
       _jpg_buf = NULL;
     }
     if (res != ESP_OK) {
@@ -275,6 +378,11 @@ static esp_err_t stream_handler(httpd_req_t *req) {
       break;
     }
     int64_t fr_end = esp_timer_get_time();
+    prev_send_us = fr_end - fb_get_us;
+    if (!is_roi) {
+      qualityControlUpdate(prev_send_us);
+    }
+    prev_seq = seq;
 
     int64_t frame_time = fr_end - last_frame;
     last_frame = fr_end;
@@ -284,17 +392,56 @@ static esp_err_t stream_handler(httpd_req_t *req) {
     uint32_t avg_frame_time = ra_filter_run(&ra_filter, frame_time);
 #endif
     log_i(
-      "MJPG: %uB %ums (%.1ffps), AVG: %ums (%.1ffps)", (uint32_t)(_jpg_buf_len), (uint32_t)frame_time, 1000.0 / (uint32_t)frame_time, avg_frame_time,
-      1000.0 / avg_frame_time
+      "MJPG: #%u %uB %ums (%.1ffps), AVG: %ums (%.1ffps), SEND: %lldus, DROPPED: %u, FILTERED: %u", seq, (uint32_t)(_jpg_buf_len), (uint32_t)frame_time,
+      1000.0 / (uint32_t)frame_time, avg_frame_time, 1000.0 / avg_frame_time, prev_send_us, framePipelineDroppedFrames(sub),
+      framePipelineFilteredFrames()
     );
   }
 
-#if defined(LED_GPIO_NUM)
-  isStreaming = false;
-  enable_led(false);
+  free(send_buf);
+  stream_started(false);
+
+  return res;
+}
+
+#ifdef STREAM_ASYNC
+static void stream_task(void *arg) {
+  stream_job_t *job = (stream_job_t *)arg;
+  stream_frames(job->req, job->sub);
+  framePipelineUnsubscribe(job->sub);
+  httpd_req_async_handler_complete(job->req);
+  free(job);
+  vTaskDelete(NULL);
+}
 #endif
 
+static esp_err_t stream_handler(httpd_req_t *req) {
+  int sub = framePipelineSubscribe();
+  if (sub < 0) {
+    log_e("Too many stream viewers");
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, NULL, 0);
+  }
+
+#ifdef STREAM_ASYNC
+  // hand the request to a task of its own so the server keeps accepting viewers
+  stream_job_t *job = (stream_job_t *)malloc(sizeof(stream_job_t));
+  if (job && httpd_req_async_handler_begin(req, &job->req) == ESP_OK) {
+    job->sub = sub;
+    if (xTaskCreatePinnedToCore(stream_task, "stream", STREAM_HTTPD_STACK, job, STREAM_HTTPD_PRIORITY, NULL, STREAM_HTTPD_CORE) == pdPASS) {
+      return ESP_OK;
+    }
+    httpd_req_async_handler_complete(job->req);
+  }
+  free(job);
+  framePipelineUnsubscribe(sub);
+  log_e("Stream task start failed");
+  return httpd_resp_send_500(req);
+#else
+  esp_err_t res = stream_frames(req, sub);
+  framePipelineUnsubscribe(sub);
   return res;
+#endif
 }
 
 static esp_err_t parse_get(httpd_req_t *req, char **obuf) {
@@ -318,32 +465,23 @@ static esp_err_t parse_get(httpd_req_t *req, char **obuf) {
   return ESP_FAIL;
 }
 
-static esp_err_t cmd_handler(httpd_req_t *req) {
-  char *buf = NULL;
-  char variable[32];
-  char value[32];
-
-  if (parse_get(req, &buf) != ESP_OK) {
-    return ESP_FAIL;
-  }
-  if (httpd_query_key_value(buf, "var", variable, sizeof(variable)) != ESP_OK || httpd_query_key_value(buf, "val", value, sizeof(value)) != ESP_OK) {
-    free(buf);
-    httpd_resp_send_404(req);
-    return ESP_FAIL;
-  }
-  free(buf);
-
-  int val = atoi(value);
-  log_i("%s = %d", variable, val);
+int setCameraControl(const char *variable, int val) {
   sensor_t *s = esp_camera_sensor_get();
   int res = 0;
 
+  // the HTTP control server and the control channel run on different tasks
+  xSemaphoreTake(control_lock, portMAX_DELAY);
   if (!strcmp(variable, "framesize")) {
-    if (s->pixformat == PIXFORMAT_JPEG) {
+    if (val > framePipelineMaxFramesize()) {
+      // larger than the frame buffers
+      res = -1;
+    } else if (s->pixformat == PIXFORMAT_JPEG) {
       res = s->set_framesize(s, (framesize_t)val);
+      setQualityControlLimits(val, -1);
     }
   } else if (!strcmp(variable, "quality")) {
     res = s->set_quality(s, val);
+    setQualityControlLimits(-1, val);
   } else if (!strcmp(variable, "contrast")) {
     res = s->set_contrast(s, val);
   } else if (!strcmp(variable, "brightness")) {
@@ -388,6 +526,12 @@ static esp_err_t cmd_handler(httpd_req_t *req) {
     res = s->set_wb_mode(s, val);
   } else if (!strcmp(variable, "ae_level")) {
     res = s->set_ae_level(s, val);
+  } else if (!strncmp(variable, "pf_", 3)) {
+    res = setColorPrefilterParam(variable, val);
+  } else if (!strncmp(variable, "qc_", 3)) {
+    res = setQualityControlParam(variable, val);
+  } else if (!strncmp(variable, "att_", 4)) {
+    res = setAttitudeFilterParam(variable, val);
   }
 #if defined(LED_GPIO_NUM)
   else if (!strcmp(variable, "led_intensity")) {
@@ -401,8 +545,28 @@ static esp_err_t cmd_handler(httpd_req_t *req) {
     log_i("Unknown command: %s", variable);
     res = -1;
   }
+  xSemaphoreGive(control_lock);
+  return res;
+}
 
-  if (res < 0) {
+static esp_err_t cmd_handler(httpd_req_t *req) {
+  char *buf = NULL;
+  char variable[32];
+  char value[32];
+
+  if (parse_get(req, &buf) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  if (httpd_query_key_value(buf, "var", variable, sizeof(variable)) != ESP_OK || httpd_query_key_value(buf, "val", value, sizeof(value)) != ESP_OK) {
+    free(buf);
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+  }
+  free(buf);
+
+  int val = atoi(value);
+  log_i("%s = %d", variable, val);
+  if (setCameraControl(variable, val) < 0) {
     return httpd_resp_send_500(req);
   }
 
@@ -415,7 +579,7 @@ static int print_reg(char *p, sensor_t *s, uint16_t reg, uint32_t mask) {
 }
 
 static esp_err_t status_handler(httpd_req_t *req) {
-  static char json_response[1024];
+  static char json_response[1536];
 
   sensor_t *s = esp_camera_sensor_get();
   char *p = json_response;
@@ -450,6 +614,11 @@ static esp_err_t status_handler(httpd_req_t *req) {
     p += print_reg(p, s, 0x132, 0xFF);
   }
 
+  p += printColorPrefilterStatus(p);
+  p += printQualityControlStatus(p);
+  p += printAttitudeFilterStatus(p);
+  p += printMemoryStatus(p);
+  p += printSensorProfileStatus(p);
   p += sprintf(p, "\"xclk\":%u,", s->xclk_freq_hz / 1000000);
   p += sprintf(p, "\"pixformat\":%u,", s->pixformat);
   p += sprintf(p, "\"framesize\":%u,", s->status.framesize);
@@ -489,6 +658,16 @@ static esp_err_t status_handler(httpd_req_t *req) {
   return httpd_resp_send(req, json_response, strlen(json_response));
 }
 
+static esp_err_t status_bin_handler(httpd_req_t *req) {
+  camera_status_t status;
+  if (!getCameraStatus(&status)) {
+    return httpd_resp_send_500(req);
+  }
+  httpd_resp_set_type(req, "application/octet-stream");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_send(req, (const char *)&status, sizeof(status));
+}
+
 static esp_err_t xclk_handler(httpd_req_t *req) {
   char *buf = NULL;
   char _xclk[32];
@@ -516,6 +695,33 @@ static esp_err_t xclk_handler(httpd_req_t *req) {
   return httpd_resp_send(req, NULL, 0);
 }
 
+static esp_err_t profile_handler(httpd_req_t *req) {
+  char *buf = NULL;
+  char name[SENSOR_PROFILE_NAME_MAX];
+
+  if (parse_get(req, &buf) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  if (httpd_query_key_value(buf, "name", name, sizeof(name)) != ESP_OK) {
+    free(buf);
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+  }
+  free(buf);
+
+  log_i("Set profile: %s", name);
+  sensor_profile_result_t res = applySensorProfile(name);
+  if (res == SENSOR_PROFILE_UNKNOWN) {
+    return httpd_resp_send_404(req);
+  }
+  if (res != SENSOR_PROFILE_OK) {
+    return httpd_resp_send_500(req);
+  }
+
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_send(req, NULL, 0);
+}
+
 static esp_err_t reg_handler(httpd_req_t *req) {
   char *buf = NULL;
   char _reg[32];
@@ -649,6 +855,191 @@ static esp_err_t win_handler(httpd_req_t *req) {
   return httpd_resp_send(req, NULL, 0);
 }
 
+static esp_err_t arm_handler(httpd_req_t *req) {
+  char *buf = NULL;
+
+  if (parse_get(req, &buf) != ESP_OK) {
+    return ESP_FAIL;
+  }
+  bool led = parse_get_var(buf, "led", 1) == 1;
+  bool disarm = parse_get_var(buf, "disarm", 0) == 1;
+  free(buf);
+
+  if (disarm) {
+    stillDisarm();
+  } else {
+    stillArm(led);
+  }
+
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_send(req, NULL, 0);
+}
+
+static esp_err_t still_handler(httpd_req_t *req) {
+  const uint8_t *buf;
+  size_t len;
+  int64_t trigger_us, capture_us;
+
+  if (!stillLockLast(&buf, &len, &trigger_us, &capture_us)) {
+    return httpd_resp_send_404(req);
+  }
+
+  char capture_ts[32];
+  char trigger_ts[32];
+  snprintf(capture_ts, 32, "%lld.%06lld", capture_us / 1000000, capture_us % 1000000);
+  snprintf(trigger_ts, 32, "%lld.%06lld", trigger_us / 1000000, trigger_us % 1000000);
+  httpd_resp_set_type(req, "image/jpeg");
+  httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=still.jpg");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  httpd_resp_set_hdr(req, "X-Timestamp", (const char *)capture_ts);
+  httpd_resp_set_hdr(req, "X-Trigger-Timestamp", (const char *)trigger_ts);
+  esp_err_t res = httpd_resp_send(req, (const char *)buf, len);
+  stillUnlock();
+  return res;
+}
+
+#if SD_RECORDER_ENABLED
+// Index records listed per /record?from=&to= request
+#define RECORD_LIST_MAX 64
+
+static bool record_send(void *arg, const uint8_t *data, size_t len) {
+  return httpd_resp_send_chunk((httpd_req_t *)arg, (const char *)data, len) == ESP_OK;
+}
+
+static esp_err_t record_handler(httpd_req_t *req) {
+  char *buf = NULL;
+  char value[24];
+
+  if (parse_get(req, &buf) != ESP_OK) {
+    return ESP_FAIL;
+  }
+
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  if (httpd_query_key_value(buf, "ts", value, sizeof(value)) == ESP_OK) {
+    free(buf);
+    record_entry_t entry;
+    if (!recorderFind(atoll(value), &entry)) {
+      return httpd_resp_send_404(req);
+    }
+    char ts[32];
+    char seq[12];
+    snprintf(ts, 32, "%llu.%06llu", entry.capture_us / 1000000, entry.capture_us % 1000000);
+    snprintf(seq, 12, "%u", entry.seq);
+    httpd_resp_set_type(req, "image/jpeg");
+    httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=record.jpg");
+    httpd_resp_set_hdr(req, "X-Timestamp", (const char *)ts);
+    httpd_resp_set_hdr(req, "X-Frame-Seq", (const char *)seq);
+    if (!recorderCopy(entry.offset, entry.len, record_send, req)) {
+      log_e("Recorded frame read failed");
+      return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+  }
+
+  int64_t from_us = 0;
+  int64_t to_us = INT64_MAX;
+  if (httpd_query_key_value(buf, "from", value, sizeof(value)) == ESP_OK) {
+    from_us = atoll(value);
+  }
+  if (httpd_query_key_value(buf, "to", value, sizeof(value)) == ESP_OK) {
+    to_us = atoll(value);
+  }
+  free(buf);
+
+  record_entry_t *entries = (record_entry_t *)malloc(RECORD_LIST_MAX * sizeof(record_entry_t));
+  if (!entries) {
+    return httpd_resp_send_500(req);
+  }
+  int n = recorderEntries(from_us, to_us, entries, RECORD_LIST_MAX);
+
+  // one chunk per record, the list is capped at RECORD_LIST_MAX records
+  char json[128];
+  esp_err_t res = httpd_resp_set_type(req, "application/json");
+  for (int i = 0; i < n && res == ESP_OK; i++) {
+    int len = snprintf(
+      json, sizeof(json), "%s{\"seq\":%u,\"ts\":%llu,\"offset\":%u,\"len\":%u,\"flags\":%u}", i ? "," : "[", entries[i].seq,
+      entries[i].capture_us, entries[i].offset, entries[i].len, entries[i].flags
+    );
+    res = httpd_resp_send_chunk(req, json, len);
+  }
+  free(entries);
+  if (res == ESP_OK) {
+    res = httpd_resp_send_chunk(req, n ? "]" : "[]", HTTPD_RESP_USE_STRLEN);
+  }
+  if (res == ESP_OK) {
+    res = httpd_resp_send_chunk(req, NULL, 0);
+  }
+  return res;
+}
+
+static esp_err_t record_data_handler(httpd_req_t *req) {
+  uint32_t size = recorderSize();
+  uint32_t start = 0;
+  uint32_t end = size ? size - 1 : 0;
+  char range[48];
+  char content_range[48];
+
+  httpd_resp_set_type(req, "application/octet-stream");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
+  if (httpd_req_get_hdr_value_str(req, "Range", range, sizeof(range)) == ESP_OK) {
+    unsigned long first, last;
+    int fields = sscanf(range, "bytes=%lu-%lu", &first, &last);
+    if (fields < 1 || first >= size || (fields == 2 && last < first)) {
+      snprintf(content_range, sizeof(content_range), "bytes */%u", size);
+      httpd_resp_set_status(req, "416 Range Not Satisfiable");
+      httpd_resp_set_hdr(req, "Content-Range", content_range);
+      return httpd_resp_send(req, NULL, 0);
+    }
+    start = first;
+    if (fields == 2 && last < end) {
+      end = last;
+    }
+    snprintf(content_range, sizeof(content_range), "bytes %u-%u/%u", start, end, size);
+    httpd_resp_set_status(req, "206 Partial Content");
+    httpd_resp_set_hdr(req, "Content-Range", content_range);
+  }
+
+  if (!size) {
+    return httpd_resp_send(req, NULL, 0);
+  }
+  if (!recorderCopy(start, end - start + 1, record_send, req)) {
+    log_e("Recording read failed");
+    return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+#endif
+
+static esp_err_t roi_handler(httpd_req_t *req) {
+  char *buf = NULL;
+
+  if (parse_get(req, &buf) != ESP_OK) {
+    return ESP_FAIL;
+  }
+
+  frame_roi_t roi;
+  roi.x = parse_get_var(buf, "x", 0);
+  roi.y = parse_get_var(buf, "y", 0);
+  roi.w = parse_get_var(buf, "w", 0);
+  roi.h = parse_get_var(buf, "h", 0);
+  int every = parse_get_var(buf, "every", 4);
+  free(buf);
+
+  if (roi.w == 0 || roi.h == 0) {
+    log_i("ROI cleared");
+    framePipelineClearRoi();
+  } else {
+    log_i("Set ROI: %u %u %ux%u every %d frames", roi.x, roi.y, roi.w, roi.h, every);
+    if (!framePipelineSetRoi(&roi, every)) {
+      return httpd_resp_send_500(req);
+    }
+  }
+
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_send(req, NULL, 0);
+}
+
 static esp_err_t index_handler(httpd_req_t *req) {
   httpd_resp_set_type(req, "text/html");
   httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
@@ -668,8 +1059,16 @@ static esp_err_t index_handler(httpd_req_t *req) {
 }
 
 void startCameraServer() {
+  control_lock = xSemaphoreCreateMutex();
+
   httpd_config_t config = HTTPD_DEFAULT_CONFIG();
   config.max_uri_handlers = 16;
+  config.task_priority = CONTROL_HTTPD_PRIORITY;
+  config.core_id = CONTROL_HTTPD_CORE;
+  config.stack_size = CONTROL_HTTPD_STACK;
+  config.max_open_sockets = CONTROL_HTTPD_MAX_SOCKETS;
+  // a new client replaces the least recently used one instead of being refused
+  config.lru_purge_enable = true;
 
   httpd_uri_t index_uri = {
     .uri = "/",
@@ -762,6 +1161,19 @@ void startCameraServer() {
 #endif
   };
 
+  httpd_uri_t profile_uri = {
+    .uri = "/profile",
+    .method = HTTP_GET,
+    .handler = profile_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
   httpd_uri_t reg_uri = {
     .uri = "/reg",
     .method = HTTP_GET,
@@ -814,6 +1226,86 @@ void startCameraServer() {
 #endif
   };
 
+  httpd_uri_t status_bin_uri = {
+    .uri = "/status.bin",
+    .method = HTTP_GET,
+    .handler = status_bin_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
+  httpd_uri_t arm_uri = {
+    .uri = "/arm",
+    .method = HTTP_GET,
+    .handler = arm_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
+  httpd_uri_t still_uri = {
+    .uri = "/still",
+    .method = HTTP_GET,
+    .handler = still_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
+#if SD_RECORDER_ENABLED
+  httpd_uri_t record_uri = {
+    .uri = "/record",
+    .method = HTTP_GET,
+    .handler = record_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
+  httpd_uri_t record_data_uri = {
+    .uri = "/record_data",
+    .method = HTTP_GET,
+    .handler = record_data_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+#endif
+
+  httpd_uri_t roi_uri = {
+    .uri = "/roi",
+    .method = HTTP_GET,
+    .handler = roi_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
   ra_filter_init(&ra_filter, 20);
 
   log_i("Starting web server on port: '%d'", config.server_port);
@@ -821,18 +1313,33 @@ void startCameraServer() {
     // httpd_register_uri_handler(camera_httpd, &index_uri);
     httpd_register_uri_handler(camera_httpd, &cmd_uri);
     httpd_register_uri_handler(camera_httpd, &status_uri);
-    // httpd_register_uri_handler(camera_httpd, &capture_uri);
+    httpd_register_uri_handler(camera_httpd, &status_bin_uri);
+    httpd_register_uri_handler(camera_httpd, &capture_uri);
     // httpd_register_uri_handler(camera_httpd, &bmp_uri);
 
     httpd_register_uri_handler(camera_httpd, &xclk_uri);
+    httpd_register_uri_handler(camera_httpd, &profile_uri);
     httpd_register_uri_handler(camera_httpd, &reg_uri);
     httpd_register_uri_handler(camera_httpd, &greg_uri);
     httpd_register_uri_handler(camera_httpd, &pll_uri);
     httpd_register_uri_handler(camera_httpd, &win_uri);
+    httpd_register_uri_handler(camera_httpd, &roi_uri);
+    httpd_register_uri_handler(camera_httpd, &arm_uri);
+    httpd_register_uri_handler(camera_httpd, &still_uri);
+#if SD_RECORDER_ENABLED
+    httpd_register_uri_handler(camera_httpd, &record_uri);
+    httpd_register_uri_handler(camera_httpd, &record_data_uri);
+#endif
   }
 
   config.server_port += 1;
   config.ctrl_port += 1;
+  config.task_priority = STREAM_HTTPD_PRIORITY;
+  config.core_id = STREAM_HTTPD_CORE;
+  config.stack_size = STREAM_HTTPD_STACK;
+  config.max_open_sockets = STREAM_HTTPD_MAX_SOCKETS;
+  // viewers hold their socket for the whole stream, none is purged
+  config.lru_purge_enable = false;
   log_i("Starting stream server on port: '%d'", config.server_port);
   if (httpd_start(&stream_httpd, &config) == ESP_OK) {
     httpd_register_uri_handler(stream_httpd, &stream_uri);
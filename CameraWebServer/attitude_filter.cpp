@@ -0,0 +1,40 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "drone_pose.h"
+#include "attitude_filter.h"
+
+static int mode = ATTITUDE_OFF;
+static int max_tilt = ATTITUDE_DEFAULT_MAX;
+
+int setAttitudeFilterParam(const char *var, int val) {
+  if (!strcmp(var, "att_mode") && val >= ATTITUDE_OFF && val <= ATTITUDE_SKIP) {
+    mode = val;
+  } else if (!strcmp(var, "att_max") && val > 0 && val <= 90) {
+    max_tilt = val;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+int printAttitudeFilterStatus(char *p) {
+  return sprintf(p, "\"att_mode\":%d,\"att_max\":%d,", mode, max_tilt);
+}
+
+int attitudeFilterMode() {
+  return mode;
+}
+
+bool attitudeFilterTilted(int64_t capture_us) {
+  drone_pose_t pose;
+  if (mode == ATTITUDE_OFF || !getDronePose(&pose)) {
+    return false;
+  }
+  int64_t age = capture_us - pose.received_us;
+  if (age > ATTITUDE_POSE_MAX_AGE || age < -ATTITUDE_POSE_MAX_AGE) {
+    return false;
+  }
+  return fabsf(pose.roll) > max_tilt || fabsf(pose.pitch) > max_tilt;
+}
@@ -0,0 +1,36 @@
+#ifndef ATTITUDE_FILTER_H
+#define ATTITUDE_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//
+// Attitude filter: uses the drone pose received over ESP-NOW to flag or drop
+// frames taken while the drone is tilted, since their ground projection is
+// wrong. Frames without a recent pose always pass untagged.
+//
+// Parameters are set through /control with these vars:
+//   att_mode                      ATTITUDE_OFF / ATTITUDE_FLAG / ATTITUDE_SKIP
+//   att_max                       maximum |roll| and |pitch| (deg)
+//
+
+#define ATTITUDE_OFF  0
+#define ATTITUDE_FLAG 1  // tag tilted frames, send every frame
+#define ATTITUDE_SKIP 2  // do not publish tilted frames
+
+#define ATTITUDE_DEFAULT_MAX  10
+#define ATTITUDE_POSE_MAX_AGE 200000  // poses older than this (us) are not used
+
+// Sets an att_* parameter. Returns 0 on success, -1 for an unknown var or bad value.
+int setAttitudeFilterParam(const char *var, int val);
+
+// Appends the filter parameters to a JSON status object, each entry followed by a comma.
+int printAttitudeFilterStatus(char *p);
+
+int attitudeFilterMode();
+
+// Whether the drone was tilted past att_max at capture_us. False if the filter
+// is off or no recent pose is available.
+bool attitudeFilterTilted(int64_t capture_us);
+
+#endif  // ATTITUDE_FILTER_H
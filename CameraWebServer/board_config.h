@@ -31,4 +31,47 @@
 //#define CAMERA_MODEL_DFRobot_Romeo_ESP32S3 // Has PSRAM
 #include "camera_pins.h"
 
+// ===================
+// HTTP servers
+// ===================
+// Task priority, core (tskNO_AFFINITY for none), stack size and open socket
+// limit of the control server (port 80) and of the stream server (port 81).
+// The camera capture task runs at priority 6 on core 1 and WiFi/lwIP on
+// core 0: the control server preempts the stream so settings and stills stay
+// responsive while frames are sent, the stream server and its viewer tasks
+// stay on the network core with a socket per viewer.
+#define CONTROL_HTTPD_PRIORITY     6
+#define CONTROL_HTTPD_CORE         tskNO_AFFINITY
+#define CONTROL_HTTPD_STACK        4096
+#define CONTROL_HTTPD_MAX_SOCKETS  4
+
+#define STREAM_HTTPD_PRIORITY      5
+#define STREAM_HTTPD_CORE          0
+#define STREAM_HTTPD_STACK         4096
+#define STREAM_HTTPD_MAX_SOCKETS   3  // one per viewer, see FRAME_MAX_SUBSCRIBERS
+
+// ===================
+// Frame buffers
+// ===================
+// With PSRAM, the frame buffers are first tried in internal DMA-capable RAM,
+// sized for CAMERA_FB_INTERNAL_FRAMESIZE: the camera DMA and the sends then
+// skip the PSRAM cache, for a higher frame rate at small resolutions. Larger
+// frame sizes and ROI crops are refused in that mode. It falls back to UXGA
+// buffers in PSRAM when the allocation fails or would leave less than
+// CAMERA_FB_INTERNAL_HEADROOM bytes of internal RAM to WiFi and lwIP.
+#define CAMERA_FB_INTERNAL           0
+#define CAMERA_FB_INTERNAL_FRAMESIZE FRAMESIZE_QVGA
+#define CAMERA_FB_INTERNAL_HEADROOM  (48 * 1024)
+
+// ===================
+// SD card recorder
+// ===================
+// Records every frame to the SD card slot (see sd_recorder.h), 0 for boards
+// without one. Takes one frame pipeline consumer and one frame buffer.
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S3
+#define SD_RECORDER_ENABLED 1
+#else
+#define SD_RECORDER_ENABLED 0  // no SDMMC host
+#endif
+
 #endif  // BOARD_CONFIG_H
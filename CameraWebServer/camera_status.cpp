@@ -0,0 +1,57 @@
+#include <string.h>
+#include "esp_camera.h"
+#include "board_config.h"
+#include "color_prefilter.h"
+#include "quality_control.h"
+#include "camera_status.h"
+
+#if defined(LED_GPIO_NUM)
+extern int led_duty;
+#endif
+
+bool getCameraStatus(camera_status_t *status) {
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s) {
+    return false;
+  }
+
+  memset(status, 0, sizeof(*status));
+  memcpy(status->magic, "ST", sizeof(status->magic));
+  status->version = CAMERA_STATUS_VERSION;
+  status->xclk = s->xclk_freq_hz / 1000000;
+  status->pixformat = s->pixformat;
+  status->framesize = s->status.framesize;
+  status->quality = s->status.quality;
+  status->brightness = s->status.brightness;
+  status->contrast = s->status.contrast;
+  status->saturation = s->status.saturation;
+  status->sharpness = s->status.sharpness;
+  status->special_effect = s->status.special_effect;
+  status->wb_mode = s->status.wb_mode;
+  status->awb = s->status.awb;
+  status->awb_gain = s->status.awb_gain;
+  status->aec = s->status.aec;
+  status->aec2 = s->status.aec2;
+  status->ae_level = s->status.ae_level;
+  status->aec_value = s->status.aec_value;
+  status->agc = s->status.agc;
+  status->agc_gain = s->status.agc_gain;
+  status->gainceiling = s->status.gainceiling;
+  status->bpc = s->status.bpc;
+  status->wpc = s->status.wpc;
+  status->raw_gma = s->status.raw_gma;
+  status->lenc = s->status.lenc;
+  status->hmirror = s->status.hmirror;
+  status->vflip = s->status.vflip;
+  status->dcw = s->status.dcw;
+  status->colorbar = s->status.colorbar;
+#if defined(LED_GPIO_NUM)
+  status->led_intensity = led_duty;
+#else
+  status->led_intensity = -1;
+#endif
+  status->pf_mode = colorPrefilterMode();
+  status->qc_enable = qualityControlEnabled();
+  status->qc_fps = qualityControlTargetFps();
+  return true;
+}
@@ -0,0 +1,54 @@
+#ifndef CAMERA_STATUS_H
+#define CAMERA_STATUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//
+// Compact binary camera status: the sensor settings of the /status JSON plus
+// the LED, color prefilter and quality controller state, served by
+// /status.bin and pushed on the raw frame stream whenever it changes.
+//
+
+#define CAMERA_STATUS_VERSION 1
+
+typedef struct __attribute__((packed)) {
+  char magic[2];     // "ST"
+  uint8_t version;   // CAMERA_STATUS_VERSION
+  uint8_t xclk;      // MHz
+  uint8_t pixformat;
+  uint8_t framesize;
+  uint8_t quality;
+  int8_t brightness;
+  int8_t contrast;
+  int8_t saturation;
+  int8_t sharpness;
+  uint8_t special_effect;
+  uint8_t wb_mode;
+  uint8_t awb;
+  uint8_t awb_gain;
+  uint8_t aec;
+  uint8_t aec2;
+  int8_t ae_level;
+  uint16_t aec_value;
+  uint8_t agc;
+  uint8_t agc_gain;
+  uint8_t gainceiling;
+  uint8_t bpc;
+  uint8_t wpc;
+  uint8_t raw_gma;
+  uint8_t lenc;
+  uint8_t hmirror;
+  uint8_t vflip;
+  uint8_t dcw;
+  uint8_t colorbar;
+  int16_t led_intensity;  // -1 without a flash LED
+  uint8_t pf_mode;
+  uint8_t qc_enable;
+  uint8_t qc_fps;
+} camera_status_t;
+
+// Fills the current status. Returns false if the sensor is not available.
+bool getCameraStatus(camera_status_t *status);
+
+#endif  // CAMERA_STATUS_H
@@ -0,0 +1,151 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "img_converters.h"
+#include "color_prefilter.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+// Frames are measured on a 1/PREFILTER_SCALE copy in each dimension
+#define PREFILTER_SCALE 8
+
+typedef struct {
+  int mode;
+  int h1_min, h1_max;
+  int h2_min, h2_max;
+  int s_min, v_min;
+  int ratio;  // per mille
+} prefilter_params_t;
+
+// Defaults match the "red" entry of COLOR_DETECTION_COLORS
+static prefilter_params_t params = {PREFILTER_OFF, 0, 10, 160, 180, 80, 50, 5};
+
+// Scaled RGB565 copy of the last measured JPEG frame, grown on demand
+static uint8_t *rgb_buf = NULL;
+static size_t rgb_buf_len = 0;
+
+static bool in_range(int v, int min, int max) {
+  return min <= max && v >= min && v <= max;
+}
+
+// Matches a big-endian RGB565 pixel against the HSV ranges (OpenCV scale)
+static bool match_pixel(const uint8_t *px) {
+  uint16_t c = (px[0] << 8) | px[1];
+  int r = ((c >> 11) & 0x1F) << 3;
+  int g = ((c >> 5) & 0x3F) << 2;
+  int b = (c & 0x1F) << 3;
+
+  int max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+  int min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+  int delta = max - min;
+  if (max < params.v_min || max == 0 || delta * 255 < params.s_min * max) {
+    return false;
+  }
+  if (delta == 0) {
+    return false;
+  }
+
+  int h;
+  if (max == r) {
+    h = 30 * (g - b) / delta;
+  } else if (max == g) {
+    h = 60 + 30 * (b - r) / delta;
+  } else {
+    h = 120 + 30 * (r - g) / delta;
+  }
+  if (h < 0) {
+    h += 180;
+  }
+  return in_range(h, params.h1_min, params.h1_max) || in_range(h, params.h2_min, params.h2_max);
+}
+
+static int measure(const uint8_t *pixels, size_t width, size_t height, size_t step) {
+  size_t matched = 0;
+  size_t total = 0;
+  for (size_t y = 0; y < height; y += step) {
+    const uint8_t *row = pixels + y * width * 2;
+    for (size_t x = 0; x < width; x += step) {
+      matched += match_pixel(row + x * 2);
+      total++;
+    }
+  }
+  return total ? (int)(matched * 1000 / total) : -1;
+}
+
+int setColorPrefilterParam(const char *var, int val) {
+  int *field = NULL;
+  int max = 255;
+
+  if (!strcmp(var, "pf_mode")) {
+    field = &params.mode;
+    max = PREFILTER_SKIP;
+  } else if (!strcmp(var, "pf_h1_min")) {
+    field = &params.h1_min;
+    max = 180;
+  } else if (!strcmp(var, "pf_h1_max")) {
+    field = &params.h1_max;
+    max = 180;
+  } else if (!strcmp(var, "pf_h2_min")) {
+    field = &params.h2_min;
+    max = 180;
+  } else if (!strcmp(var, "pf_h2_max")) {
+    field = &params.h2_max;
+    max = 180;
+  } else if (!strcmp(var, "pf_s_min")) {
+    field = &params.s_min;
+  } else if (!strcmp(var, "pf_v_min")) {
+    field = &params.v_min;
+  } else if (!strcmp(var, "pf_ratio")) {
+    field = &params.ratio;
+    max = 1000;
+  }
+
+  if (!field || val < 0 || val > max) {
+    return -1;
+  }
+  *field = val;
+  return 0;
+}
+
+int printColorPrefilterStatus(char *p) {
+  return sprintf(
+    p, "\"pf_mode\":%d,\"pf_h1_min\":%d,\"pf_h1_max\":%d,\"pf_h2_min\":%d,\"pf_h2_max\":%d,\"pf_s_min\":%d,\"pf_v_min\":%d,\"pf_ratio\":%d,", params.mode,
+    params.h1_min, params.h1_max, params.h2_min, params.h2_max, params.s_min, params.v_min, params.ratio
+  );
+}
+
+int colorPrefilterMode() {
+  return params.mode;
+}
+
+int colorPrefilterRatio(const camera_fb_t *fb) {
+  if (params.mode == PREFILTER_OFF || !fb) {
+    return -1;
+  }
+  if (fb->format == PIXFORMAT_RGB565) {
+    return measure(fb->buf, fb->width, fb->height, PREFILTER_SCALE);
+  }
+  if (fb->format != PIXFORMAT_JPEG) {
+    return -1;
+  }
+
+  // the JPEG decoder scales down while decoding, which is far cheaper than a full decode
+  size_t width = fb->width / PREFILTER_SCALE;
+  size_t height = fb->height / PREFILTER_SCALE;
+  size_t len = width * height * 2;
+  if (len > rgb_buf_len) {
+    free(rgb_buf);
+    rgb_buf = (uint8_t *)malloc(len);
+    rgb_buf_len = rgb_buf ? len : 0;
+  }
+  if (!rgb_buf || !jpg2rgb565(fb->buf, fb->len, rgb_buf, JPG_SCALE_8X)) {
+    return -1;
+  }
+  return measure(rgb_buf, width, height, 1);
+}
+
+bool colorPrefilterPass(int ratio) {
+  return params.mode != PREFILTER_SKIP || ratio < 0 || ratio >= params.ratio;
+}
@@ -0,0 +1,42 @@
+#ifndef COLOR_PREFILTER_H
+#define COLOR_PREFILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_camera.h"
+
+//
+// On-camera color prefilter: measures the share of pixels inside the target
+// HSV ranges on a 1/8 scale copy of each frame, so frames without the target
+// color can be flagged or not sent at all. HSV uses the OpenCV scale
+// (H 0-180, S/V 0-255), matching COLOR_DETECTION_COLORS on the ground station.
+//
+// Parameters are set through /control with these vars:
+//   pf_mode                       PREFILTER_OFF / PREFILTER_FLAG / PREFILTER_SKIP
+//   pf_h1_min, pf_h1_max          first hue range
+//   pf_h2_min, pf_h2_max          second hue range (hue wraps for red), min > max disables it
+//   pf_s_min, pf_v_min            minimum saturation and value
+//   pf_ratio                      minimum color ratio for a frame to pass (per mille)
+//
+
+#define PREFILTER_OFF  0  // no measurement
+#define PREFILTER_FLAG 1  // measure and report the ratio, send every frame
+#define PREFILTER_SKIP 2  // measure and only publish frames above pf_ratio, /capture included
+
+// Sets a pf_* parameter. Returns 0 on success, -1 for an unknown var or bad value.
+int setColorPrefilterParam(const char *var, int val);
+
+// Appends the prefilter parameters to a JSON status object, each entry followed by a comma.
+int printColorPrefilterStatus(char *p);
+
+// Current prefilter mode.
+int colorPrefilterMode();
+
+// Color ratio of the frame in per mille, or -1 if the prefilter is off or the frame can't be measured.
+// Not reentrant: only the frame pipeline capture task calls it.
+int colorPrefilterRatio(const camera_fb_t *fb);
+
+// Whether a frame with this ratio must be sent. Unmeasured frames always pass.
+bool colorPrefilterPass(int ratio);
+
+#endif  // COLOR_PREFILTER_H
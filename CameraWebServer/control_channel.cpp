@@ -0,0 +1,93 @@
+#include <string.h>
+#include "lwip/sockets.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "board_config.h"
+#include "frame_pipeline.h"
+#include "control_channel.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+// Indexed by control_cmd_t.var: only append, the host numbers them the same way
+static const char *const control_vars[] = {
+  "framesize", "quality", "contrast", "brightness", "saturation", "gainceiling",
+  "colorbar", "awb", "agc", "aec", "hmirror", "vflip", "awb_gain", "agc_gain",
+  "aec_value", "aec2", "dcw", "bpc", "wpc", "raw_gma", "lenc", "special_effect",
+  "wb_mode", "ae_level", "led_intensity",
+  "pf_mode", "pf_h1_min", "pf_h1_max", "pf_h2_min", "pf_h2_max", "pf_s_min", "pf_v_min", "pf_ratio",
+  "qc_enable", "qc_fps", "att_mode", "att_max",
+};
+
+#define CONTROL_VAR_COUNT (sizeof(control_vars) / sizeof(control_vars[0]))
+
+static void answer_sync(int sock, const control_sync_t *sync, int64_t receive_us, struct sockaddr_in *source, socklen_t source_len) {
+  control_sync_ack_t ack;
+  memcpy(ack.magic, "SYA", sizeof(ack.magic));
+  ack.version = CONTROL_VERSION;
+  ack.host_send_us = sync->host_send_us;
+  ack.receive_us = receive_us;
+  ack.send_us = esp_timer_get_time();
+  sendto(sock, &ack, sizeof(ack), 0, (struct sockaddr *)source, source_len);
+}
+
+static void control_task(void *arg) {
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+  if (sock < 0) {
+    log_e("Control channel socket failed");
+    vTaskDelete(NULL);
+    return;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(CONTROL_PORT);
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    log_e("Control channel bind failed");
+    close(sock);
+    vTaskDelete(NULL);
+    return;
+  }
+
+  while (true) {
+    union {
+      control_cmd_t cmd;
+      control_sync_t sync;
+    } msg;
+    struct sockaddr_in source;
+    socklen_t source_len = sizeof(source);
+    int len = recvfrom(sock, &msg, sizeof(msg), 0, (struct sockaddr *)&source, &source_len);
+    int64_t receive_us = esp_timer_get_time();
+    if (len == sizeof(msg.sync) && !memcmp(msg.sync.magic, "SYN", sizeof(msg.sync.magic)) && msg.sync.version == CONTROL_VERSION) {
+      answer_sync(sock, &msg.sync, receive_us, &source, source_len);
+      continue;
+    }
+    const control_cmd_t &cmd = msg.cmd;
+    if (len != sizeof(cmd) || memcmp(cmd.magic, "CTL", sizeof(cmd.magic)) || cmd.version != CONTROL_VERSION) {
+      continue;
+    }
+
+    control_ack_t ack;
+    memcpy(ack.magic, "CTA", sizeof(ack.magic));
+    ack.version = CONTROL_VERSION;
+    ack.var = cmd.var;
+    ack.id = cmd.id;
+    if (cmd.var >= CONTROL_VAR_COUNT) {
+      ack.status = CONTROL_STATUS_UNKNOWN;
+    } else {
+      log_i("%s = %d", control_vars[cmd.var], cmd.val);
+      ack.status = setCameraControl(control_vars[cmd.var], cmd.val) < 0 ? CONTROL_STATUS_FAILED : CONTROL_STATUS_OK;
+    }
+    sendto(sock, &ack, sizeof(ack), 0, (struct sockaddr *)&source, source_len);
+  }
+}
+
+void startControlChannel() {
+  log_i("Starting control channel on udp port: '%d'", CONTROL_PORT);
+  // above the stream servers, a flash command must not wait behind a frame
+  xTaskCreatePinnedToCore(control_task, "control", 4096, NULL, CONTROL_HTTPD_PRIORITY, NULL, FRAME_NETWORK_CORE);
+}
@@ -0,0 +1,69 @@
+#ifndef CONTROL_CHANNEL_H
+#define CONTROL_CHANNEL_H
+
+#include <stdint.h>
+
+//
+// Binary control channel: /control settings sent as control_cmd_t datagrams
+// on CONTROL_PORT, each answered with a control_ack_t. The host keeps one
+// socket open for the whole flight, so changing the flash or a sensor setting
+// costs one datagram each way instead of a new TCP connection and an HTTP
+// query string, and does not disturb the frame stream.
+//
+// Settings are numbered CONTROL_VAR_*, in the order of control_vars in
+// control_channel.cpp. Commands are idempotent: the host retries a command
+// whose ack was lost with the same id.
+//
+// The same port answers control_sync_t time exchanges with the esp_timer
+// times the request was received and the answer sent, the clock of the frame
+// capture timestamps, so the host maps them onto its own clock within half
+// a round trip.
+//
+
+#define CONTROL_PORT    84
+#define CONTROL_VERSION 1
+
+#define CONTROL_STATUS_OK      0
+#define CONTROL_STATUS_FAILED  1
+#define CONTROL_STATUS_UNKNOWN 2  // no such var
+
+typedef struct __attribute__((packed)) {
+  char magic[3];    // "CTL"
+  uint8_t version;  // CONTROL_VERSION
+  uint8_t var;      // index in control_vars
+  uint8_t reserved;
+  uint16_t id;      // echoed in the ack
+  int32_t val;
+} control_cmd_t;
+
+typedef struct __attribute__((packed)) {
+  char magic[3];    // "CTA"
+  uint8_t version;  // CONTROL_VERSION
+  uint8_t var;
+  uint8_t status;   // CONTROL_STATUS_*
+  uint16_t id;
+} control_ack_t;
+
+typedef struct __attribute__((packed)) {
+  char magic[3];          // "SYN"
+  uint8_t version;        // CONTROL_VERSION
+  uint64_t host_send_us;  // echoed in the answer
+} control_sync_t;
+
+typedef struct __attribute__((packed)) {
+  char magic[3];          // "SYA"
+  uint8_t version;        // CONTROL_VERSION
+  uint64_t host_send_us;
+  int64_t receive_us;     // esp_timer time the request was received
+  int64_t send_us;        // esp_timer time the answer was sent
+} control_sync_ack_t;
+
+// Starts the control channel listener. WiFi must be started and the camera
+// server too, it owns the settings.
+void startControlChannel();
+
+// Applies a /control setting (see cmd_handler in app_httpd.cpp). Returns a
+// negative value if the var is unknown or the setting failed.
+int setCameraControl(const char *variable, int val);
+
+#endif  // CONTROL_CHANNEL_H
@@ -0,0 +1,82 @@
+#include <string.h>
+#include "esp_now.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "drone_pose.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+// Must match the ESP-NOW pose packet of the esp-drone firmware
+#define POSE_MAGIC   "POS"
+#define POSE_VERSION 1
+
+typedef struct __attribute__((packed)) {
+  char magic[3];
+  uint8_t version;
+  uint16_t seq;
+  uint64_t timestamp;
+  float x, y, z;
+  float roll, pitch, yaw;
+} pose_packet_t;
+
+static portMUX_TYPE pose_mux = portMUX_INITIALIZER_UNLOCKED;
+static drone_pose_t latest_pose;
+static bool pose_valid = false;
+
+static void on_pose_packet(const uint8_t *data, int len) {
+  if (len != sizeof(pose_packet_t)) {
+    return;
+  }
+  pose_packet_t packet;
+  memcpy(&packet, data, sizeof(packet));
+  if (memcmp(packet.magic, POSE_MAGIC, sizeof(packet.magic)) || packet.version != POSE_VERSION) {
+    return;
+  }
+
+  drone_pose_t pose;
+  pose.seq = packet.seq;
+  pose.timestamp = packet.timestamp;
+  pose.received_us = esp_timer_get_time();
+  pose.x = packet.x;
+  pose.y = packet.y;
+  pose.z = packet.z;
+  pose.roll = packet.roll;
+  pose.pitch = packet.pitch;
+  pose.yaw = packet.yaw;
+
+  portENTER_CRITICAL(&pose_mux);
+  latest_pose = pose;
+  pose_valid = true;
+  portEXIT_CRITICAL(&pose_mux);
+}
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+static void espnow_recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+  on_pose_packet(data, len);
+}
+#else
+static void espnow_recv_cb(const uint8_t *mac, const uint8_t *data, int len) {
+  on_pose_packet(data, len);
+}
+#endif
+
+void setupDronePose() {
+  if (esp_now_init() != ESP_OK) {
+    log_e("ESP-NOW init failed, drone pose disabled");
+    return;
+  }
+  esp_now_register_recv_cb(espnow_recv_cb);
+  log_i("Listening for drone pose over ESP-NOW");
+}
+
+bool getDronePose(drone_pose_t *pose) {
+  portENTER_CRITICAL(&pose_mux);
+  bool valid = pose_valid;
+  if (valid) {
+    *pose = latest_pose;
+  }
+  portEXIT_CRITICAL(&pose_mux);
+  return valid;
+}
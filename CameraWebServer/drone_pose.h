@@ -0,0 +1,26 @@
+#ifndef DRONE_POSE_H
+#define DRONE_POSE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//
+// Latest drone pose, pushed by the drone over ESP-NOW
+// (CONFIG_TELEMETRY_ESPNOW_POSE in the esp-drone firmware).
+//
+
+typedef struct {
+  uint16_t seq;         // drone pose sequence number
+  uint64_t timestamp;   // drone sample time (us since drone boot)
+  int64_t received_us;  // local esp_timer time the pose was received
+  float x, y, z;        // position (m)
+  float roll, pitch, yaw;  // orientation (deg)
+} drone_pose_t;
+
+// Starts listening for drone pose packets. WiFi must be started.
+void setupDronePose();
+
+// Copies the latest drone pose. Returns false if none was received yet.
+bool getDronePose(drone_pose_t *pose);
+
+#endif  // DRONE_POSE_H
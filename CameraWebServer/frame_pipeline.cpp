@@ -0,0 +1,400 @@
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "color_prefilter.h"
+#include "attitude_filter.h"
+#include "frame_pipeline.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+// Per-consumer handoff: each subscriber has its own newest-frame slot, so a
+// slow consumer only ever drops its own frames
+typedef struct {
+  std::atomic<bool> active;
+  std::atomic<camera_fb_t *> slot;
+  SemaphoreHandle_t ready;
+  uint32_t dropped;
+} subscriber_t;
+
+static subscriber_t subscribers[FRAME_MAX_SUBSCRIBERS];
+static bool running = false;
+static uint32_t filtered_frames = 0;
+static uint32_t captured_frames = 0;
+
+// Sensor reconfiguration waiting to run in the capture task, one at a time
+static SemaphoreHandle_t reconfigure_lock = NULL;
+static SemaphoreHandle_t reconfigure_done = NULL;
+static bool (*reconfigure_fn)(void *arg) = NULL;  // published last, with release ordering
+static void *reconfigure_arg = NULL;
+static bool reconfigure_result = false;
+
+// Metadata and reference count for each frame buffer out of the driver.
+// A frame goes back to the driver when its last reference is released, and
+// its tag is only reused after that, so consumers holding the frame always
+// read its own metadata.
+typedef struct {
+  std::atomic<camera_fb_t *> fb;
+  std::atomic<int> refs;
+  int ratio;
+  bool tilted;
+  bool is_roi;
+  frame_roi_t roi;
+} frame_tag_t;
+
+static frame_tag_t tags[CAMERA_FB_COUNT];
+
+// ROI requested by the host, guarded by roi_mux
+static portMUX_TYPE roi_mux = portMUX_INITIALIZER_UNLOCKED;
+static frame_roi_t roi_request;
+static int roi_every = 0;  // 0: ROI mode off
+
+// Largest frame size the frame buffers hold, FRAMESIZE_INVALID if not limited
+static framesize_t max_framesize = FRAMESIZE_INVALID;
+
+static frame_tag_t *find_tag(const camera_fb_t *fb) {
+  for (int i = 0; i < CAMERA_FB_COUNT; i++) {
+    if (fb && tags[i].fb.load() == fb) {
+      return &tags[i];
+    }
+  }
+  return NULL;
+}
+
+// Tags a new frame with one reference, owned by the capture task
+static frame_tag_t *tag_frame(camera_fb_t *fb, int ratio, bool tilted, const frame_roi_t *roi) {
+  for (int i = 0; i < CAMERA_FB_COUNT; i++) {
+    frame_tag_t *tag = &tags[i];
+    if (!tag->fb.load()) {
+      tag->ratio = ratio;
+      tag->tilted = tilted;
+      tag->is_roi = roi != NULL;
+      if (roi) {
+        tag->roi = *roi;
+      }
+      tag->refs.store(1);
+      tag->fb.store(fb);
+      return tag;
+    }
+  }
+  return NULL;
+}
+
+static void release(camera_fb_t *fb) {
+  frame_tag_t *tag = find_tag(fb);
+  if (!tag) {
+    esp_camera_fb_return(fb);
+    return;
+  }
+  if (tag->refs.fetch_sub(1) == 1) {
+    // clear the tag before the driver can hand the buffer out again
+    tag->fb.store(nullptr);
+    esp_camera_fb_return(fb);
+  }
+}
+
+static void drain(subscriber_t *sub) {
+  camera_fb_t *fb = sub->slot.exchange(nullptr);
+  if (fb) {
+    release(fb);
+  }
+}
+
+static int64_t capture_time(const camera_fb_t *fb) {
+  return (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+}
+
+static void publish(camera_fb_t *fb, int ratio, bool tilted, const frame_roi_t *roi) {
+  frame_tag_t *tag = tag_frame(fb, ratio, tilted, roi);
+  if (!tag) {
+    esp_camera_fb_return(fb);
+    return;
+  }
+  for (int i = 0; i < FRAME_MAX_SUBSCRIBERS; i++) {
+    subscriber_t *sub = &subscribers[i];
+    if (!sub->active.load()) {
+      continue;
+    }
+    tag->refs.fetch_add(1);
+    camera_fb_t *stale = sub->slot.exchange(fb);
+    if (stale) {
+      // this consumer did not take it in time, a newer frame replaces it
+      release(stale);
+      sub->dropped++;
+    }
+    xSemaphoreGive(sub->ready);
+    if (!sub->active.load()) {
+      // unsubscribed meanwhile, don't leave the frame pinned in its slot
+      drain(sub);
+    }
+  }
+  release(fb);
+}
+
+static void discard_frames(int count) {
+  for (int i = 0; i < count; i++) {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (fb) {
+      esp_camera_fb_return(fb);
+    }
+  }
+}
+
+// Switches the sensor window to the ROI, publishes one crop frame and restores the full view
+static void capture_roi(const frame_roi_t *roi) {
+  sensor_t *s = esp_camera_sensor_get();
+  framesize_t full = s->status.framesize;
+  int full_w = resolution[full].width;
+  int full_h = resolution[full].height;
+  int sensor_w = resolution[FRAMESIZE_UXGA].width;
+  int sensor_h = resolution[FRAMESIZE_UXGA].height;
+
+  // full view pixels to native sensor pixels, aligned to 8
+  int off_x = (roi->x * sensor_w / full_w) & ~7;
+  int off_y = (roi->y * sensor_h / full_h) & ~7;
+  int total_x = (roi->w * sensor_w / full_w) & ~7;
+  int total_y = (roi->h * sensor_h / full_h) & ~7;
+  if (off_x + total_x > sensor_w) {
+    total_x = (sensor_w - off_x) & ~7;
+  }
+  if (off_y + total_y > sensor_h) {
+    total_y = (sensor_h - off_y) & ~7;
+  }
+  int out_x = total_x;
+  int out_y = total_y;
+  if (out_x > ROI_MAX_WIDTH || out_y > ROI_MAX_HEIGHT) {
+    if (out_x * ROI_MAX_HEIGHT > out_y * ROI_MAX_WIDTH) {
+      out_y = out_y * ROI_MAX_WIDTH / out_x;
+      out_x = ROI_MAX_WIDTH;
+    } else {
+      out_x = out_x * ROI_MAX_HEIGHT / out_y;
+      out_y = ROI_MAX_HEIGHT;
+    }
+  }
+  out_x &= ~7;
+  out_y &= ~7;
+  if (out_x < 8 || out_y < 8) {
+    return;
+  }
+
+  // OV2640: startX selects the sensor mode, 0 is the native UXGA one
+  if (s->set_res_raw(s, 0, 0, 0, 0, off_x, off_y, total_x, total_y, out_x, out_y, false, false)) {
+    log_e("ROI window failed");
+    return;
+  }
+  discard_frames(ROI_SWITCH_DISCARD);
+  camera_fb_t *fb = esp_camera_fb_get();
+  if (fb) {
+    publish(fb, -1, attitudeFilterTilted(capture_time(fb)), roi);
+  }
+  s->set_framesize(s, full);
+  discard_frames(ROI_SWITCH_DISCARD);
+}
+
+static bool has_subscribers() {
+  for (int i = 0; i < FRAME_MAX_SUBSCRIBERS; i++) {
+    if (subscribers[i].active.load()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Runs the pending reconfiguration between two captures, then drops the
+// frames still queued with the previous settings
+static void run_reconfigure() {
+  bool (*fn)(void *arg) = __atomic_load_n(&reconfigure_fn, __ATOMIC_ACQUIRE);
+  if (!fn) {
+    return;
+  }
+  reconfigure_result = fn(reconfigure_arg);
+  discard_frames(ROI_SWITCH_DISCARD);
+  __atomic_store_n(&reconfigure_fn, NULL, __ATOMIC_RELAXED);
+  xSemaphoreGive(reconfigure_done);
+}
+
+static void capture_task(void *arg) {
+  int full_frames = 0;
+  while (true) {
+    run_reconfigure();
+    if (!has_subscribers()) {
+      vTaskDelay(20 / portTICK_PERIOD_MS);
+      continue;
+    }
+
+    frame_roi_t roi;
+    portENTER_CRITICAL(&roi_mux);
+    int every = roi_every;
+    roi = roi_request;
+    portEXIT_CRITICAL(&roi_mux);
+    if (every > 0 && full_frames >= every) {
+      full_frames = 0;
+      capture_roi(&roi);
+    }
+
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+      log_e("Camera capture failed");
+      vTaskDelay(10 / portTICK_PERIOD_MS);
+      continue;
+    }
+    __atomic_add_fetch(&captured_frames, 1, __ATOMIC_RELAXED);
+    // filtered here, off the network core, and before anyone waits on the frame
+    bool tilted = attitudeFilterTilted(capture_time(fb));
+    if (tilted && attitudeFilterMode() == ATTITUDE_SKIP) {
+      esp_camera_fb_return(fb);
+      filtered_frames++;
+      continue;
+    }
+    int ratio = colorPrefilterRatio(fb);
+    if (!colorPrefilterPass(ratio)) {
+      esp_camera_fb_return(fb);
+      filtered_frames++;
+      continue;
+    }
+    publish(fb, ratio, tilted, NULL);
+    full_frames++;
+  }
+}
+
+void startFramePipeline() {
+  for (int i = 0; i < FRAME_MAX_SUBSCRIBERS; i++) {
+    subscribers[i].ready = xSemaphoreCreateBinary();
+    if (!subscribers[i].ready) {
+      log_e("Frame pipeline init failed, capturing inline");
+      return;
+    }
+  }
+  reconfigure_lock = xSemaphoreCreateMutex();
+  reconfigure_done = xSemaphoreCreateBinary();
+  if (!reconfigure_lock || !reconfigure_done) {
+    log_e("Frame pipeline init failed, capturing inline");
+    return;
+  }
+  running = true;
+  xTaskCreatePinnedToCore(capture_task, "frame_capture", 3072, NULL, 6, NULL, FRAME_CAPTURE_CORE);
+  log_i("Frame pipeline started on core %d", FRAME_CAPTURE_CORE);
+}
+
+bool framePipelineReconfigure(bool (*fn)(void *arg), void *arg) {
+  if (!running) {
+    return fn(arg);
+  }
+  xSemaphoreTake(reconfigure_lock, portMAX_DELAY);
+  reconfigure_arg = arg;
+  __atomic_store_n(&reconfigure_fn, fn, __ATOMIC_RELEASE);
+  // the capture task always comes back between captures, fb_get times out on its own
+  xSemaphoreTake(reconfigure_done, portMAX_DELAY);
+  bool ok = reconfigure_result;
+  xSemaphoreGive(reconfigure_lock);
+  return ok;
+}
+
+uint32_t framePipelineCapturedFrames() {
+  return __atomic_load_n(&captured_frames, __ATOMIC_RELAXED);
+}
+
+int framePipelineSubscribe() {
+  if (!running) {
+    return FRAME_SUBSCRIBER_INLINE;
+  }
+  for (int i = 0; i < FRAME_MAX_SUBSCRIBERS; i++) {
+    bool expected = false;
+    if (subscribers[i].active.compare_exchange_strong(expected, true)) {
+      subscribers[i].dropped = 0;
+      xSemaphoreTake(subscribers[i].ready, 0);
+      return i;
+    }
+  }
+  return -1;
+}
+
+void framePipelineUnsubscribe(int sub) {
+  if (sub < 0 || sub >= FRAME_MAX_SUBSCRIBERS) {
+    return;
+  }
+  subscribers[sub].active.store(false);
+  drain(&subscribers[sub]);
+}
+
+camera_fb_t *framePipelineGet(int sub, TickType_t timeout) {
+  if (sub < 0 || sub >= FRAME_MAX_SUBSCRIBERS) {
+    return sub == FRAME_SUBSCRIBER_INLINE ? esp_camera_fb_get() : NULL;
+  }
+  TimeOut_t time_out;
+  vTaskSetTimeOutState(&time_out);
+  while (true) {
+    camera_fb_t *fb = subscribers[sub].slot.exchange(nullptr);
+    if (fb) {
+      return fb;
+    }
+    if (xTaskCheckForTimeOut(&time_out, &timeout) == pdTRUE || xSemaphoreTake(subscribers[sub].ready, timeout) != pdTRUE) {
+      return NULL;
+    }
+  }
+}
+
+void framePipelineReturn(camera_fb_t *fb) {
+  if (fb) {
+    release(fb);
+  }
+}
+
+uint32_t framePipelineDroppedFrames(int sub) {
+  if (sub < 0 || sub >= FRAME_MAX_SUBSCRIBERS) {
+    return 0;
+  }
+  return subscribers[sub].dropped;
+}
+
+uint32_t framePipelineFilteredFrames() {
+  return filtered_frames;
+}
+
+int framePipelineColorRatio(const camera_fb_t *fb) {
+  frame_tag_t *tag = find_tag(fb);
+  return tag ? tag->ratio : -1;
+}
+
+bool framePipelineSetRoi(const frame_roi_t *roi, int every) {
+  sensor_t *s = esp_camera_sensor_get();
+  // crops are up to ROI_MAX_WIDTH x ROI_MAX_HEIGHT (SVGA)
+  if (!s || s->id.PID != OV2640_PID || !running || max_framesize < FRAMESIZE_SVGA || roi->w == 0 || roi->h == 0 || every < 1) {
+    return false;
+  }
+  portENTER_CRITICAL(&roi_mux);
+  roi_request = *roi;
+  roi_every = every;
+  portEXIT_CRITICAL(&roi_mux);
+  return true;
+}
+
+void framePipelineClearRoi() {
+  portENTER_CRITICAL(&roi_mux);
+  roi_every = 0;
+  portEXIT_CRITICAL(&roi_mux);
+}
+
+void framePipelineSetMaxFramesize(framesize_t framesize) {
+  max_framesize = framesize;
+}
+
+framesize_t framePipelineMaxFramesize() {
+  return max_framesize;
+}
+
+bool framePipelineFrameTilted(const camera_fb_t *fb) {
+  frame_tag_t *tag = find_tag(fb);
+  return tag && tag->tilted;
+}
+
+bool framePipelineFrameRoi(const camera_fb_t *fb, frame_roi_t *roi) {
+  frame_tag_t *tag = find_tag(fb);
+  if (!tag || !tag->is_roi) {
+    return false;
+  }
+  *roi = tag->roi;
+  return true;
+}
@@ -0,0 +1,106 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "esp_camera.h"
+#include "freertos/FreeRTOS.h"
+#include "board_config.h"
+
+//
+// Capture pipeline: a capture task pinned to its own core keeps grabbing
+// frames and fans each one out to every subscribed consumer through a
+// per-consumer lock-free slot holding the newest frame. Frames are reference
+// counted and go back to the driver once every consumer released them, so
+// a slow consumer only drops its own frames and never stalls the sensor or
+// the other consumers. The color prefilter runs in the capture task, so
+// filtered frames are never published; so does the attitude filter.
+//
+// ROI mode: once a region of interest is set, every `every` full view frames
+// the capture task switches the sensor window to that region at native sensor
+// resolution, publishes one crop frame and switches back. Only the OV2640
+// windowing is supported.
+//
+
+// Concurrent consumers (stream viewers, raw frame stream, stills, SD recorder)
+#define FRAME_MAX_SUBSCRIBERS (3 + SD_RECORDER_ENABLED)
+
+// Frame buffers allocated in PSRAM: one being captured, the newest published
+// one, and one being sent by each consumer
+#define CAMERA_FB_COUNT (FRAME_MAX_SUBSCRIBERS + 2)
+
+// Subscriber id returned when the pipeline is not running: frames are grabbed inline
+#define FRAME_SUBSCRIBER_INLINE FRAME_MAX_SUBSCRIBERS
+
+#define FRAME_CAPTURE_CORE 1  // capture task, away from the WiFi/lwIP core
+#define FRAME_NETWORK_CORE 0  // frame stream task
+
+// Crop frames are scaled down to fit this output size
+#define ROI_MAX_WIDTH  800
+#define ROI_MAX_HEIGHT 600
+
+// Frames discarded after each sensor window switch: every buffer already queued
+// in the driver still holds the old window, plus one frame for the sensor to settle
+#define ROI_SWITCH_DISCARD (CAMERA_FB_COUNT + 1)
+
+// Region of interest, in pixels of the full view frame
+typedef struct {
+  uint16_t x, y, w, h;
+} frame_roi_t;
+
+// How long consumers wait for a frame before reporting a capture failure
+#define FRAME_GET_TIMEOUT pdMS_TO_TICKS(1000)
+
+// Starts the capture task. The camera must be initialized.
+void startFramePipeline();
+
+// Registers a consumer. Returns its subscriber id, or -1 if there are already
+// FRAME_MAX_SUBSCRIBERS consumers.
+int framePipelineSubscribe();
+
+void framePipelineUnsubscribe(int sub);
+
+// Takes the newest frame for this subscriber, waiting up to `timeout` ticks for one.
+// Falls back to esp_camera_fb_get() if the pipeline is not running.
+camera_fb_t *framePipelineGet(int sub, TickType_t timeout);
+
+// Releases a frame obtained with framePipelineGet().
+void framePipelineReturn(camera_fb_t *fb);
+
+// Number of frames this subscriber missed because a newer one was captured before it took them.
+uint32_t framePipelineDroppedFrames(int sub);
+
+// Number of frames dropped by the color prefilter or the attitude filter.
+uint32_t framePipelineFilteredFrames();
+
+// Number of frames grabbed by the capture task, filtered ones included.
+uint32_t framePipelineCapturedFrames();
+
+// Runs fn(arg) in the capture task between two captures and discards the frames
+// queued with the previous settings, so sensor settings changed together never
+// show up half applied in a published frame. Waits for it and returns its result.
+// Runs it at once if the pipeline is not running.
+bool framePipelineReconfigure(bool (*fn)(void *arg), void *arg);
+
+// Color ratio (per mille) measured for a frame taken from the pipeline, -1 if not measured.
+int framePipelineColorRatio(const camera_fb_t *fb);
+
+// Sets the region of interest and how many full view frames go between crops.
+// Returns false if the sensor has no supported windowing or the region is empty.
+bool framePipelineSetRoi(const frame_roi_t *roi, int every);
+
+// Stops interleaving crop frames.
+void framePipelineClearRoi();
+
+// Records the largest frame size the frame buffers were allocated for, when
+// smaller than the crops: larger frame sizes and ROI mode are then refused.
+void framePipelineSetMaxFramesize(framesize_t framesize);
+
+// Largest frame size the frame buffers hold, FRAMESIZE_INVALID if not limited.
+framesize_t framePipelineMaxFramesize();
+
+// Whether a frame was taken while the drone was tilted (see attitude_filter.h).
+bool framePipelineFrameTilted(const camera_fb_t *fb);
+
+// Whether a frame taken from the pipeline is a crop, and of which region.
+bool framePipelineFrameRoi(const camera_fb_t *fb, frame_roi_t *roi);
+
+#endif  // FRAME_PIPELINE_H
@@ -0,0 +1,180 @@
+#include <string.h>
+#include "lwip/sockets.h"
+#include "esp_timer.h"
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "drone_pose.h"
+#include "frame_pipeline.h"
+#include "color_prefilter.h"
+#include "quality_control.h"
+#include "camera_status.h"
+#include "jpeg_pool.h"
+#include "frame_stream.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+// Counts the client as a stream for the flash LED (app_httpd.cpp)
+void stream_started(bool started);
+
+static bool send_all(int sock, const void *data, size_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  while (len > 0) {
+    int sent = send(sock, p, len, 0);
+    if (sent <= 0) {
+      return false;
+    }
+    p += sent;
+    len -= sent;
+  }
+  return true;
+}
+
+static void stream_frames(int sock, int sub) {
+  frame_header_t header;
+  drone_pose_t pose;
+  uint32_t seq = 0;
+  uint32_t prev_send_us = 0;
+  camera_status_t status;
+  camera_status_t sent_status;
+  memset(&sent_status, 0, sizeof(sent_status));
+
+  memcpy(header.magic, "FR", sizeof(header.magic));
+  header.version = FRAME_STREAM_VERSION;
+
+  while (true) {
+    if (getCameraStatus(&status) && memcmp(&status, &sent_status, sizeof(status))) {
+      if (!send_all(sock, &status, sizeof(status))) {
+        return;
+      }
+      sent_status = status;
+    }
+
+    camera_fb_t *fb = framePipelineGet(sub, FRAME_GET_TIMEOUT);
+    int64_t fb_get_us = esp_timer_get_time();
+    if (!fb && colorPrefilterMode() == PREFILTER_SKIP) {
+      continue;
+    }
+    if (!fb) {
+      log_e("Camera capture failed");
+      return;
+    }
+
+    uint8_t *jpg_buf = fb->buf;
+    size_t jpg_len = fb->len;
+    int64_t capture_us = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+    int ratio = framePipelineColorRatio(fb);
+    frame_roi_t roi;
+    bool is_roi = framePipelineFrameRoi(fb, &roi);
+    bool tilted = framePipelineFrameTilted(fb);
+    uint32_t encode_us = 0;
+    if (fb->format != PIXFORMAT_JPEG) {
+      int64_t encode_start_us = esp_timer_get_time();
+      bool jpeg_converted = jpegPoolEncode(fb, 80, &jpg_buf, &jpg_len);
+      encode_us = (uint32_t)(esp_timer_get_time() - encode_start_us);
+      framePipelineReturn(fb);
+      fb = NULL;
+      if (!jpeg_converted) {
+        log_e("JPEG compression failed");
+        return;
+      }
+    }
+
+    header.flags = 0;
+    header.seq = seq++;
+    header.capture_us = capture_us;
+    header.prev_send_us = prev_send_us;
+    header.len = jpg_len;
+    header.color_ratio = ratio;
+    header.queue_us = fb_get_us > capture_us ? (uint32_t)(fb_get_us - capture_us) : 0;
+    header.encode_us = encode_us;
+    if (tilted) {
+      header.flags |= FRAME_FLAG_TILTED;
+    }
+    if (is_roi) {
+      header.flags |= FRAME_FLAG_ROI;
+      header.roi_x = roi.x;
+      header.roi_y = roi.y;
+      header.roi_w = roi.w;
+      header.roi_h = roi.h;
+    }
+    if (getDronePose(&pose)) {
+      header.flags |= FRAME_FLAG_POSE;
+      header.pose_seq = pose.seq;
+      header.pose_timestamp = pose.timestamp;
+      header.pose_age_us = (int32_t)(capture_us - pose.received_us);
+      header.x = pose.x;
+      header.y = pose.y;
+      header.z = pose.z;
+      header.roll = pose.roll;
+      header.pitch = pose.pitch;
+      header.yaw = pose.yaw;
+    }
+
+    bool ok = send_all(sock, &header, sizeof(header)) && send_all(sock, jpg_buf, jpg_len);
+
+    if (fb) {
+      framePipelineReturn(fb);
+    } else {
+      jpegPoolRelease(jpg_buf);
+    }
+    if (!ok) {
+      log_i("Frame stream client disconnected");
+      return;
+    }
+    prev_send_us = (uint32_t)(esp_timer_get_time() - fb_get_us);
+    if (!is_roi) {
+      qualityControlUpdate(prev_send_us);
+    }
+  }
+}
+
+static void frame_stream_task(void *arg) {
+  int listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+  if (listen_sock < 0) {
+    log_e("Frame stream socket failed");
+    vTaskDelete(NULL);
+    return;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(FRAME_STREAM_PORT);
+  if (bind(listen_sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_sock, 1) != 0) {
+    log_e("Frame stream bind/listen failed");
+    close(listen_sock);
+    vTaskDelete(NULL);
+    return;
+  }
+
+  while (true) {
+    int sock = accept(listen_sock, NULL, NULL);
+    if (sock < 0) {
+      continue;
+    }
+    // frames are written as soon as they are ready, never held back for coalescing
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    int sub = framePipelineSubscribe();
+    if (sub < 0) {
+      log_e("Frame stream refused, too many consumers");
+    } else {
+      log_i("Frame stream client connected");
+      stream_started(true);
+      stream_frames(sock, sub);
+      stream_started(false);
+      framePipelineUnsubscribe(sub);
+    }
+    close(sock);
+  }
+}
+
+void startFrameStreamServer() {
+  log_i("Starting frame stream server on port: '%d'", FRAME_STREAM_PORT);
+  xTaskCreatePinnedToCore(frame_stream_task, "frame_stream", 4096, NULL, 5, NULL, FRAME_NETWORK_CORE);
+}
@@ -0,0 +1,46 @@
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include <stdint.h>
+
+//
+// Bare TCP frame stream: every frame is a frame_header_t followed by
+// `len` bytes of JPEG, with no HTTP framing. One client at a time.
+// A camera_status_t is sent when the client connects and before the
+// next frame whenever the status changed; records are told apart by
+// their two magic bytes.
+//
+// A connected client counts as a stream for the flash LED, as /stream
+// viewers do: led_intensity lights it while the client is connected.
+//
+
+#define FRAME_STREAM_PORT    82
+#define FRAME_STREAM_VERSION 4
+
+#define FRAME_FLAG_POSE   (1 << 0)  // pose fields are valid
+#define FRAME_FLAG_ROI    (1 << 1)  // frame is a crop of the roi_* region (full view pixels)
+#define FRAME_FLAG_TILTED (1 << 2)  // drone was tilted past att_max at capture
+
+typedef struct __attribute__((packed)) {
+  char magic[2];           // "FR"
+  uint8_t version;         // FRAME_STREAM_VERSION
+  uint8_t flags;           // FRAME_FLAG_*
+  uint32_t seq;            // frame sequence number
+  uint64_t capture_us;     // sensor capture time (us)
+  uint32_t prev_send_us;   // previous frame, fb_get to end of send (us), 0 if unknown
+  uint32_t len;            // JPEG length
+  uint16_t pose_seq;       // drone pose sequence number
+  uint64_t pose_timestamp; // drone sample time (us since drone boot)
+  int32_t pose_age_us;     // pose age at capture time, negative if received after it
+  float x, y, z;           // position (m)
+  float roll, pitch, yaw;  // orientation (deg)
+  int16_t color_ratio;     // color prefilter ratio (per mille), -1 if not measured
+  uint16_t roi_x, roi_y, roi_w, roi_h;  // crop region, valid with FRAME_FLAG_ROI
+  uint32_t queue_us;       // capture to fb_get, waiting in the pipeline (us)
+  uint32_t encode_us;      // JPEG encoding (us), 0 if the sensor output JPEG
+} frame_header_t;
+
+// Starts the frame stream server task. WiFi must be started.
+void startFrameStreamServer();
+
+#endif  // FRAME_STREAM_H
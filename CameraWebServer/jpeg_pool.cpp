@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "img_converters.h"
+#include "freertos/FreeRTOS.h"
+#include "jpeg_pool.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+static portMUX_TYPE pool_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t *buffers[JPEG_POOL_BUFFERS] = {NULL};
+static uint32_t free_mask = 0;  // bit i set when buffers[i] is free
+static uint32_t fallbacks = 0;
+
+typedef struct {
+  uint8_t *buf;
+  size_t len;
+} pool_writer_t;
+
+// Encoder output callback: appends to the pool buffer, a short count aborts the encoding
+static size_t poolWrite(void *arg, size_t index, const void *data, size_t len) {
+  pool_writer_t *writer = (pool_writer_t *)arg;
+  if (index + len > JPEG_POOL_BUFFER_SIZE) {
+    return 0;
+  }
+  memcpy(writer->buf + index, data, len);
+  writer->len = index + len;
+  return len;
+}
+
+static int poolIndex(const uint8_t *buf) {
+  for (int i = 0; i < JPEG_POOL_BUFFERS; i++) {
+    if (buffers[i] && buffers[i] == buf) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool startJpegPool() {
+  uint32_t caps = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+  uint32_t mask = 0;
+  for (int i = 0; i < JPEG_POOL_BUFFERS; i++) {
+    buffers[i] = (uint8_t *)heap_caps_malloc(JPEG_POOL_BUFFER_SIZE, caps);
+    if (!buffers[i]) {
+      log_e("JPEG pool buffer %d allocation failed", i);
+      break;
+    }
+    mask |= 1u << i;
+  }
+  portENTER_CRITICAL(&pool_mux);
+  free_mask = mask;
+  portEXIT_CRITICAL(&pool_mux);
+  log_i("JPEG pool: %d buffers of %u B", __builtin_popcount(mask), JPEG_POOL_BUFFER_SIZE);
+  return mask != 0;
+}
+
+bool jpegPoolEncode(camera_fb_t *fb, uint8_t quality, uint8_t **buf, size_t *len) {
+  int index = -1;
+  portENTER_CRITICAL(&pool_mux);
+  if (free_mask) {
+    index = __builtin_ctz(free_mask);
+    free_mask &= ~(1u << index);
+  }
+  portEXIT_CRITICAL(&pool_mux);
+
+  if (index >= 0) {
+    pool_writer_t writer = {buffers[index], 0};
+    if (frame2jpg_cb(fb, quality, poolWrite, &writer)) {
+      *buf = writer.buf;
+      *len = writer.len;
+      return true;
+    }
+    jpegPoolRelease(buffers[index]);
+  }
+
+  __atomic_add_fetch(&fallbacks, 1, __ATOMIC_RELAXED);
+  return frame2jpg(fb, quality, buf, len);
+}
+
+void jpegPoolRelease(uint8_t *buf) {
+  int index = poolIndex(buf);
+  if (index < 0) {
+    free(buf);
+    return;
+  }
+  portENTER_CRITICAL(&pool_mux);
+  free_mask |= 1u << index;
+  portEXIT_CRITICAL(&pool_mux);
+}
+
+uint32_t jpegPoolFallbacks() {
+  return __atomic_load_n(&fallbacks, __ATOMIC_RELAXED);
+}
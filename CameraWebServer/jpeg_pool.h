@@ -0,0 +1,35 @@
+#ifndef JPEG_POOL_H
+#define JPEG_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_camera.h"
+
+//
+// Pool of JPEG encode buffers for frames the sensor does not deliver as JPEG
+// (e.g. RGB565). frame2jpg mallocs a 128 kB output buffer per frame, freed
+// once the frame is sent, which fragments the PSRAM and adds jitter to every
+// frame. The pool allocates JPEG_POOL_BUFFERS buffers once and the encoder
+// writes its output straight into a free one. When the pool is not started,
+// all its buffers are in use or a frame does not fit, the frame falls back
+// to frame2jpg; jpegPoolRelease() tells the two apart.
+//
+
+#define JPEG_POOL_BUFFERS     3             // one per concurrent stream client and the still
+#define JPEG_POOL_BUFFER_SIZE (128 * 1024)  // as allocated by frame2jpg
+
+// Allocates the buffers in PSRAM, or in internal RAM without PSRAM.
+bool startJpegPool();
+
+// Encodes a frame into a pool buffer (or a malloc'ed one, see above).
+// Release the buffer with jpegPoolRelease().
+bool jpegPoolEncode(camera_fb_t *fb, uint8_t quality, uint8_t **buf, size_t *len);
+
+// Returns a buffer from jpegPoolEncode() to the pool, or frees it.
+void jpegPoolRelease(uint8_t *buf);
+
+// Number of frames encoded outside of the pool since boot.
+uint32_t jpegPoolFallbacks();
+
+#endif  // JPEG_POOL_H
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "memory_stats.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static memory_stats_t stats;
+static esp_timer_handle_t sample_timer = NULL;
+// Written by the allocating tasks, read by the sampling
+static uint32_t alloc_failures = 0;
+static uint32_t last_failed_size = 0;
+static bool low_block_warned = false;
+
+static void allocFailedHook(size_t size, uint32_t caps, const char *function_name) {
+  __atomic_add_fetch(&alloc_failures, 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&last_failed_size, (uint32_t)size, __ATOMIC_RELAXED);
+}
+
+static void sampleRegion(memory_region_stats_t *region, uint32_t caps) {
+  uint32_t free_size = heap_caps_get_free_size(caps);
+  uint32_t largest_block = heap_caps_get_largest_free_block(caps);
+  uint32_t min_free_size = heap_caps_get_minimum_free_size(caps);
+  uint32_t min_largest_block = region->min_largest_block;
+  if (min_largest_block == 0 || largest_block < min_largest_block) {
+    min_largest_block = largest_block;
+  }
+
+  portENTER_CRITICAL(&stats_mux);
+  region->free_size = free_size;
+  region->min_free_size = min_free_size;
+  region->largest_block = largest_block;
+  region->min_largest_block = min_largest_block;
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+static void sampleMemory(void *arg) {
+  uint32_t failures_before = stats.alloc_failures;
+
+  sampleRegion(&stats.internal, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM)) {
+    sampleRegion(&stats.psram, MALLOC_CAP_SPIRAM);
+  }
+  portENTER_CRITICAL(&stats_mux);
+  stats.alloc_failures = __atomic_load_n(&alloc_failures, __ATOMIC_RELAXED);
+  stats.last_failed_size = __atomic_load_n(&last_failed_size, __ATOMIC_RELAXED);
+  portEXIT_CRITICAL(&stats_mux);
+
+  if (stats.alloc_failures != failures_before) {
+    log_w("%u allocations failed, the last of %u B; internal free %u B, largest block %u B",
+          stats.alloc_failures - failures_before, stats.last_failed_size, stats.internal.free_size,
+          stats.internal.largest_block);
+  }
+  // Warned once per crossing of the threshold
+  bool low_block = stats.internal.largest_block < MEMORY_STATS_LOW_BLOCK;
+  if (low_block && !low_block_warned) {
+    log_w("Internal heap fragmented: largest block %u B of %u B free", stats.internal.largest_block,
+          stats.internal.free_size);
+  }
+  low_block_warned = low_block;
+}
+
+void startMemoryStats() {
+  if (sample_timer) {
+    return;
+  }
+  heap_caps_register_failed_alloc_callback(allocFailedHook);
+
+  const esp_timer_create_args_t timer_args = {
+    .callback = sampleMemory,
+    .arg = NULL,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "memory_stats",
+    .skip_unhandled_events = true,
+  };
+  if (esp_timer_create(&timer_args, &sample_timer) != ESP_OK) {
+    log_e("Memory stats timer creation failed");
+    return;
+  }
+  sampleMemory(NULL);
+  esp_timer_start_periodic(sample_timer, MEMORY_STATS_PERIOD_MS * 1000);
+}
+
+void getMemoryStats(memory_stats_t *out) {
+  portENTER_CRITICAL(&stats_mux);
+  *out = stats;
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+int printMemoryStatus(char *p) {
+  memory_stats_t s;
+  getMemoryStats(&s);
+  return sprintf(p,
+                 "\"heap_free\":%u,\"heap_min_free\":%u,\"heap_largest\":%u,\"heap_min_largest\":%u,"
+                 "\"psram_free\":%u,\"psram_min_free\":%u,\"psram_largest\":%u,\"psram_min_largest\":%u,"
+                 "\"alloc_failures\":%u,\"alloc_failed_size\":%u,",
+                 s.internal.free_size, s.internal.min_free_size, s.internal.largest_block, s.internal.min_largest_block,
+                 s.psram.free_size, s.psram.min_free_size, s.psram.largest_block, s.psram.min_largest_block,
+                 s.alloc_failures, s.last_failed_size);
+}
@@ -0,0 +1,43 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <stdint.h>
+
+//
+// Heap monitor: samples the free space and the largest free block of the
+// internal RAM and of the PSRAM every MEMORY_STATS_PERIOD_MS, keeps their
+// low watermarks since boot and counts the failed allocations. The frame
+// buffers live in PSRAM, the WiFi and lwIP buffers in internal RAM: a largest
+// block shrinking while the free space holds is fragmentation, which ends in
+// failed allocations, warned about on the console.
+//
+
+#define MEMORY_STATS_PERIOD_MS 1000
+// Largest internal block under which a warning is printed, the WiFi driver
+// allocates its rx/tx buffers of about 1.6 kB on the fly
+#define MEMORY_STATS_LOW_BLOCK 4096
+
+typedef struct {
+  uint32_t free_size;
+  uint32_t min_free_size;       // low watermark since boot
+  uint32_t largest_block;
+  uint32_t min_largest_block;   // low watermark since boot
+} memory_region_stats_t;
+
+typedef struct {
+  memory_region_stats_t internal;
+  memory_region_stats_t psram;  // all zero without PSRAM
+  uint32_t alloc_failures;      // since boot
+  uint32_t last_failed_size;    // bytes, 0 if none failed
+} memory_stats_t;
+
+// Registers the failed allocation hook and starts the periodic sampling.
+void startMemoryStats();
+
+// Copies the last sample.
+void getMemoryStats(memory_stats_t *stats);
+
+// Appends the memory stats to a JSON status object, each entry followed by a comma.
+int printMemoryStatus(char *p);
+
+#endif  // MEMORY_STATS_H
@@ -0,0 +1,122 @@
+#include <string.h>
+#include <stdio.h>
+#include "esp_camera.h"
+#include "freertos/FreeRTOS.h"
+#include "quality_control.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+// Smallest frame size the controller falls back to
+#define QC_FRAMESIZE_MIN FRAMESIZE_QQVGA
+
+typedef enum {
+  QC_HOLD,
+  QC_DEGRADE,
+  QC_IMPROVE
+} qc_action_t;
+
+static portMUX_TYPE qc_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool enabled = true;
+static int target_fps = QC_DEFAULT_FPS;
+static int max_framesize = -1;  // ceiling, -1 until read from the sensor
+static int min_quality = -1;
+static int64_t avg_send_us = 0;  // exponential moving average, 1/8 weight
+static int frames = 0;
+
+int setQualityControlParam(const char *var, int val) {
+  int res = 0;
+  portENTER_CRITICAL(&qc_mux);
+  if (!strcmp(var, "qc_enable") && (val == 0 || val == 1)) {
+    enabled = val;
+  } else if (!strcmp(var, "qc_fps") && val > 0 && val <= 60) {
+    target_fps = val;
+  } else {
+    res = -1;
+  }
+  frames = 0;
+  portEXIT_CRITICAL(&qc_mux);
+  return res;
+}
+
+void setQualityControlLimits(int framesize, int quality) {
+  portENTER_CRITICAL(&qc_mux);
+  if (framesize >= 0) {
+    max_framesize = framesize;
+  }
+  if (quality >= 0) {
+    min_quality = quality;
+  }
+  frames = 0;
+  portEXIT_CRITICAL(&qc_mux);
+}
+
+int printQualityControlStatus(char *p) {
+  portENTER_CRITICAL(&qc_mux);
+  int en = enabled;
+  int fps = target_fps;
+  uint32_t send_ms = avg_send_us / 1000;
+  portEXIT_CRITICAL(&qc_mux);
+  return sprintf(p, "\"qc_enable\":%d,\"qc_fps\":%d,\"qc_send_ms\":%u,", en, fps, send_ms);
+}
+
+bool qualityControlEnabled() {
+  return enabled;
+}
+
+int qualityControlTargetFps() {
+  return target_fps;
+}
+
+void qualityControlUpdate(int64_t send_us) {
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s || s->pixformat != PIXFORMAT_JPEG) {
+    return;
+  }
+
+  qc_action_t action = QC_HOLD;
+  portENTER_CRITICAL(&qc_mux);
+  avg_send_us = avg_send_us ? avg_send_us + (send_us - avg_send_us) / 8 : send_us;
+  if (max_framesize < 0) {
+    max_framesize = s->status.framesize;
+    min_quality = s->status.quality;
+  }
+  if (enabled && ++frames >= QC_PERIOD) {
+    frames = 0;
+    int64_t budget_us = 1000000 / target_fps;
+    if (avg_send_us > budget_us + budget_us / 10) {
+      action = QC_DEGRADE;
+    } else if (avg_send_us < budget_us * 6 / 10) {
+      action = QC_IMPROVE;
+    }
+  }
+  int ceiling_framesize = max_framesize;
+  int ceiling_quality = min_quality;
+  portEXIT_CRITICAL(&qc_mux);
+
+  int framesize = s->status.framesize;
+  int quality = s->status.quality;
+  if (action == QC_DEGRADE) {
+    if (quality + QC_QUALITY_STEP <= QC_QUALITY_MAX) {
+      quality += QC_QUALITY_STEP;
+    } else if (framesize > QC_FRAMESIZE_MIN) {
+      framesize--;
+    }
+  } else if (action == QC_IMPROVE) {
+    // size first: a bigger frame at lower quality is worth more than the reverse
+    if (framesize < ceiling_framesize) {
+      framesize++;
+    } else if (quality > ceiling_quality) {
+      quality = quality - QC_QUALITY_STEP > ceiling_quality ? quality - QC_QUALITY_STEP : ceiling_quality;
+    }
+  }
+
+  if (framesize != s->status.framesize) {
+    log_i("QC: framesize %d -> %d (send %lldms)", s->status.framesize, framesize, avg_send_us / 1000);
+    s->set_framesize(s, (framesize_t)framesize);
+  } else if (quality != s->status.quality) {
+    log_i("QC: quality %d -> %d (send %lldms)", s->status.quality, quality, avg_send_us / 1000);
+    s->set_quality(s, quality);
+  }
+}
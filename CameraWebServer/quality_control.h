@@ -0,0 +1,40 @@
+#ifndef QUALITY_CONTROL_H
+#define QUALITY_CONTROL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//
+// Closed-loop JPEG quality / frame size controller. Streams report how long
+// each frame took from grab to end of send; when the smoothed send time does
+// not fit the target frame period the controller first lowers the JPEG
+// quality, then the frame size, and raises them back once the link recovers,
+// never above the framesize/quality last set through /control.
+//
+// Parameters are set through /control with these vars:
+//   qc_enable                     0 / 1
+//   qc_fps                        target frames per second
+//
+
+#define QC_DEFAULT_FPS  15
+#define QC_PERIOD       15  // frames between two adjustments
+#define QC_QUALITY_STEP 4   // JPEG quality step (higher value, lower quality)
+#define QC_QUALITY_MAX  40  // worst JPEG quality used before shrinking the frame
+
+// Sets a qc_* parameter. Returns 0 on success, -1 for an unknown var or bad value.
+int setQualityControlParam(const char *var, int val);
+
+// Records the framesize/quality requested by the user as the controller ceiling.
+void setQualityControlLimits(int framesize, int quality);
+
+// Appends the controller state to a JSON status object, each entry followed by a comma.
+int printQualityControlStatus(char *p);
+
+bool qualityControlEnabled();
+
+int qualityControlTargetFps();
+
+// Feeds the grab-to-send time of one streamed frame.
+void qualityControlUpdate(int64_t send_us);
+
+#endif  // QUALITY_CONTROL_H
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_camera.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "board_config.h"
+#include "frame_pipeline.h"
+#include "frame_stream.h"
+#include "jpeg_pool.h"
+#include "sd_recorder.h"
+
+#if SD_RECORDER_ENABLED
+#include "FS.h"
+#include "SD_MMC.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+static char data_path[32];
+static char index_path[32];
+static FILE *data_file = NULL;
+static FILE *index_file = NULL;
+
+// Written by the recorder task on each flush, read by the HTTP handlers
+static uint32_t synced_entries = 0;
+static uint32_t synced_bytes = 0;
+
+static bool readEntry(FILE *f, uint32_t i, record_entry_t *entry) {
+  return fseek(f, (long)i * sizeof(record_entry_t), SEEK_SET) == 0 && fread(entry, sizeof(*entry), 1, f) == 1;
+}
+
+// Index of the first entry captured at or after capture_us, count if none
+static uint32_t lowerBound(FILE *f, uint32_t count, int64_t capture_us) {
+  uint32_t lo = 0, hi = count;
+  record_entry_t entry;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (!readEntry(f, mid, &entry)) {
+      return count;
+    }
+    if ((int64_t)entry.capture_us < capture_us) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static bool flushFiles() {
+  if (fflush(data_file) || fflush(index_file) || fsync(fileno(data_file)) || fsync(fileno(index_file))) {
+    return false;
+  }
+  return true;
+}
+
+static void recorder_task(void *arg) {
+  int sub = framePipelineSubscribe();
+  if (sub < 0) {
+    log_e("SD recorder refused, too many consumers");
+    vTaskDelete(NULL);
+    return;
+  }
+
+  record_entry_t entry;
+  uint32_t entries = 0;
+  uint32_t offset = 0;
+  int unsynced = 0;
+  while (true) {
+    camera_fb_t *fb = framePipelineGet(sub, FRAME_GET_TIMEOUT);
+    if (!fb) {
+      continue;
+    }
+
+    uint8_t *jpg_buf = fb->buf;
+    size_t jpg_len = fb->len;
+    if (fb->format != PIXFORMAT_JPEG && !jpegPoolEncode(fb, 90, &jpg_buf, &jpg_len)) {
+      framePipelineReturn(fb);
+      continue;
+    }
+    if (offset + jpg_len > SD_RECORD_MAX_BYTES) {
+      if (jpg_buf != fb->buf) {
+        jpegPoolRelease(jpg_buf);
+      }
+      framePipelineReturn(fb);
+      log_w("SD recording full after %u frames", entries);
+      break;
+    }
+
+    frame_roi_t roi;
+    entry.seq = entries;
+    entry.capture_us = (uint64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+    entry.offset = offset;
+    entry.len = jpg_len;
+    entry.flags = (framePipelineFrameRoi(fb, &roi) ? FRAME_FLAG_ROI : 0) | (framePipelineFrameTilted(fb) ? FRAME_FLAG_TILTED : 0);
+    bool ok = fwrite(jpg_buf, 1, jpg_len, data_file) == jpg_len && fwrite(&entry, sizeof(entry), 1, index_file) == 1;
+
+    if (jpg_buf != fb->buf) {
+      jpegPoolRelease(jpg_buf);
+    }
+    framePipelineReturn(fb);
+    if (!ok) {
+      log_e("SD recording write failed after %u frames", entries);
+      break;
+    }
+    entries++;
+    offset += jpg_len;
+
+    if (++unsynced >= SD_RECORD_SYNC_FRAMES) {
+      unsynced = 0;
+      if (!flushFiles()) {
+        log_e("SD recording flush failed after %u frames", entries);
+        break;
+      }
+      __atomic_store_n(&synced_bytes, offset, __ATOMIC_RELEASE);
+      __atomic_store_n(&synced_entries, entries, __ATOMIC_RELEASE);
+    }
+  }
+
+  if (flushFiles()) {
+    __atomic_store_n(&synced_bytes, offset, __ATOMIC_RELEASE);
+    __atomic_store_n(&synced_entries, entries, __ATOMIC_RELEASE);
+  }
+  framePipelineUnsubscribe(sub);
+  vTaskDelete(NULL);
+}
+
+bool startSdRecorder() {
+  // 1-bit mode leaves GPIO 4, the flash LED on most boards, to the LED
+  if (!SD_MMC.begin(SD_RECORD_MOUNT, true) || SD_MMC.cardType() == CARD_NONE) {
+    log_w("No SD card, recording disabled");
+    return false;
+  }
+
+  struct stat st;
+  for (int n = 0; n < 10000; n++) {
+    snprintf(data_path, sizeof(data_path), SD_RECORD_MOUNT "/rec%04d.mjpg", n);
+    if (stat(data_path, &st) != 0) {
+      snprintf(index_path, sizeof(index_path), SD_RECORD_MOUNT "/rec%04d.idx", n);
+      break;
+    }
+  }
+  data_file = fopen(data_path, "wb");
+  index_file = data_file ? fopen(index_path, "wb") : NULL;
+  if (!index_file) {
+    log_e("SD recording files could not be created");
+    if (data_file) {
+      fclose(data_file);
+      data_file = NULL;
+    }
+    return false;
+  }
+  // fewer, larger writes to the card
+  setvbuf(data_file, NULL, _IOFBF, SD_RECORD_WRITE_BUFFER);
+
+  log_i("Recording to %s, %llu MB free", data_path, (SD_MMC.totalBytes() - SD_MMC.usedBytes()) / (1024 * 1024));
+  // below the capture task on its core, the card is only written between captures
+  xTaskCreatePinnedToCore(recorder_task, "sd_recorder", 4096, NULL, 2, NULL, FRAME_CAPTURE_CORE);
+  return true;
+}
+
+bool recorderFind(int64_t capture_us, record_entry_t *entry) {
+  uint32_t count = __atomic_load_n(&synced_entries, __ATOMIC_ACQUIRE);
+  if (!count) {
+    return false;
+  }
+  FILE *f = fopen(index_path, "rb");
+  if (!f) {
+    return false;
+  }
+  uint32_t i = lowerBound(f, count, capture_us);
+  record_entry_t before, after;
+  bool found = false;
+  if (i < count && readEntry(f, i, &after)) {
+    *entry = after;
+    found = true;
+  }
+  if (i > 0 && readEntry(f, i - 1, &before) && (!found || capture_us - (int64_t)before.capture_us < (int64_t)after.capture_us - capture_us)) {
+    *entry = before;
+    found = true;
+  }
+  fclose(f);
+  return found;
+}
+
+int recorderEntries(int64_t from_us, int64_t to_us, record_entry_t *entries, int max) {
+  uint32_t count = __atomic_load_n(&synced_entries, __ATOMIC_ACQUIRE);
+  FILE *f = count ? fopen(index_path, "rb") : NULL;
+  if (!f) {
+    return 0;
+  }
+  int n = 0;
+  for (uint32_t i = lowerBound(f, count, from_us); i < count && n < max; i++) {
+    if (!readEntry(f, i, &entries[n]) || (int64_t)entries[n].capture_us > to_us) {
+      break;
+    }
+    n++;
+  }
+  fclose(f);
+  return n;
+}
+
+bool recorderCopy(uint32_t offset, uint32_t len, record_out_cb out, void *arg) {
+  if (offset > recorderSize() || len > recorderSize() - offset) {
+    return false;
+  }
+  uint8_t *chunk = (uint8_t *)malloc(SD_RECORD_READ_CHUNK);
+  FILE *f = chunk ? fopen(data_path, "rb") : NULL;
+  bool ok = f && fseek(f, offset, SEEK_SET) == 0;
+  while (ok && len > 0) {
+    size_t n = fread(chunk, 1, len < SD_RECORD_READ_CHUNK ? len : SD_RECORD_READ_CHUNK, f);
+    ok = n > 0 && out(arg, chunk, n);
+    len -= n;
+  }
+  if (f) {
+    fclose(f);
+  }
+  free(chunk);
+  return ok;
+}
+
+uint32_t recorderSize() {
+  return __atomic_load_n(&synced_bytes, __ATOMIC_ACQUIRE);
+}
+
+#endif  // SD_RECORDER_ENABLED
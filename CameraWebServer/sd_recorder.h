@@ -0,0 +1,57 @@
+#ifndef SD_RECORDER_H
+#define SD_RECORDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+//
+// SD card recorder: a frame pipeline consumer that appends the JPEG of every
+// frame, as captured and never recompressed, to an append-only data file on
+// the SD card, and an index record per frame to an index file. The files of
+// a boot are /sdcard/recNNNN.mjpg and /sdcard/recNNNN.idx, NNNN being the
+// first unused number. The recorder runs below the capture task on the
+// capture core and only drops its own frames when the card is slow, so the
+// live stream is not affected.
+//
+// Recorded frames are served by the control server: /record?ts=<us> returns
+// the frame captured closest to a time, /record?from=<us>&to=<us> lists the
+// index records of a time range as JSON, and /record_data serves the data
+// file with HTTP Range requests, for fetching many frames at once.
+//
+
+#define SD_RECORD_MOUNT        "/sdcard"
+#define SD_RECORD_SYNC_FRAMES  30                    // frames between flushes, lost on a power cut
+#define SD_RECORD_MAX_BYTES    (3800UL * 1024 * 1024)  // under the FAT32 file size limit
+#define SD_RECORD_WRITE_BUFFER (32 * 1024)           // stdio buffer of the data file
+#define SD_RECORD_READ_CHUNK   (8 * 1024)            // chunk of the data file sent per HTTP write
+
+typedef struct __attribute__((packed)) {
+  uint32_t seq;         // recorded frame number
+  uint64_t capture_us;  // sensor capture time (us)
+  uint32_t offset;      // JPEG offset in the data file
+  uint32_t len;         // JPEG length
+  uint8_t flags;        // FRAME_FLAG_ROI and FRAME_FLAG_TILTED (see frame_stream.h)
+} record_entry_t;
+
+// Mounts the SD card (1-bit mode, the flash LED shares a 4-bit data line),
+// creates the files of this boot and starts the recorder task.
+bool startSdRecorder();
+
+// Finds the recorded frame captured closest to capture_us.
+bool recorderFind(int64_t capture_us, record_entry_t *entry);
+
+// Copies the index records of the frames captured between from_us and to_us,
+// at most max of them. Returns their number.
+int recorderEntries(int64_t from_us, int64_t to_us, record_entry_t *entries, int max);
+
+// Output callback of recorderCopy(), returns false to stop the copy.
+typedef bool (*record_out_cb)(void *arg, const uint8_t *data, size_t len);
+
+// Reads len bytes of the data file from offset, passing them to out in chunks.
+bool recorderCopy(uint32_t offset, uint32_t len, record_out_cb out, void *arg);
+
+// Size of the data file flushed so far, which can be read.
+uint32_t recorderSize();
+
+#endif  // SD_RECORDER_H
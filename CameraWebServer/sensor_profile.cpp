@@ -0,0 +1,183 @@
+#include <string.h>
+#include <stdio.h>
+#include <Preferences.h>
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "sensor_profile.h"
+#include "frame_pipeline.h"
+#include "quality_control.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+// Masked register write: reg is the driver address (bank << 8 | register on the OV2640)
+typedef struct {
+  uint16_t reg;
+  uint8_t mask;
+  uint8_t val;
+} sensor_reg_t;
+
+typedef struct {
+  const char *name;
+  uint16_t pid;               // sensor it is tuned for, 0 for any
+  int xclk_mhz;
+  framesize_t framesize;
+  int quality;
+  const sensor_reg_t *regs;   // written last, set_framesize rewrites the clock registers
+  int reg_count;
+} sensor_profile_t;
+
+// OV2640 CLKRC: no clock doubler, no divider, the sensor runs at XCLK. At
+// 20 MHz the CIF mode then gives 5/6 of its 60 fps rated at 24 MHz.
+static const sensor_reg_t ov2640_clk_direct[] = {
+  {0x111, 0xBF, 0x00},
+};
+
+static const sensor_profile_t profiles[] = {
+  {"qvga_low_latency", 0, 20, FRAMESIZE_QVGA, 15, NULL, 0},
+  {"ov2640_cif_50fps", OV2640_PID, 20, FRAMESIZE_CIF, 12, ov2640_clk_direct, 1},
+  {"ov2640_svga_25fps", OV2640_PID, 20, FRAMESIZE_SVGA, 12, ov2640_clk_direct, 1},
+};
+
+#define PROFILE_COUNT ((int)(sizeof(profiles) / sizeof(profiles[0])))
+
+static portMUX_TYPE profile_mux = portMUX_INITIALIZER_UNLOCKED;
+static int active = -1;
+static int fps_x10[PROFILE_COUNT];  // 0 until measured, 1/4 weight moving average
+static uint32_t last_captured = 0;
+static bool settling = true;        // first sample after a switch spans both profiles
+static esp_timer_handle_t sample_timer = NULL;
+
+static const sensor_profile_t *find_profile(const char *name, uint16_t pid) {
+  for (int i = 0; i < PROFILE_COUNT; i++) {
+    if (!strcmp(profiles[i].name, name) && (profiles[i].pid == 0 || profiles[i].pid == pid)) {
+      return &profiles[i];
+    }
+  }
+  return NULL;
+}
+
+// Runs in the capture task, see framePipelineReconfigure
+static bool apply_settings(void *arg) {
+  const sensor_profile_t *profile = (const sensor_profile_t *)arg;
+  sensor_t *s = esp_camera_sensor_get();
+  int res = s->set_xclk(s, LEDC_TIMER_0, profile->xclk_mhz);
+  if (s->pixformat == PIXFORMAT_JPEG) {
+    res |= s->set_framesize(s, profile->framesize);
+    res |= s->set_quality(s, profile->quality);
+  }
+  // DSP night mode lowers the frame rate in the dark
+  res |= s->set_aec2(s, 0);
+  for (int i = 0; i < profile->reg_count; i++) {
+    const sensor_reg_t *r = &profile->regs[i];
+    res |= s->set_reg(s, r->reg, r->mask, r->val);
+  }
+  return res == 0;
+}
+
+static void store_profile(const char *name) {
+  Preferences prefs;
+  if (!prefs.begin(SENSOR_PROFILE_NVS_NAMESPACE, false)) {
+    return;
+  }
+  prefs.putString("name", name);
+  prefs.end();
+}
+
+static void sampleRate(void *arg) {
+  uint32_t captured = framePipelineCapturedFrames();
+  int frames = (int)(captured - last_captured);
+  last_captured = captured;
+
+  portENTER_CRITICAL(&profile_mux);
+  if (active >= 0 && frames > 0 && !settling) {
+    int x10 = frames * 10000 / SENSOR_PROFILE_SAMPLE_MS;
+    fps_x10[active] = fps_x10[active] ? (fps_x10[active] * 3 + x10) / 4 : x10;
+  }
+  settling = false;
+  portEXIT_CRITICAL(&profile_mux);
+}
+
+sensor_profile_result_t applySensorProfile(const char *name) {
+  sensor_t *s = esp_camera_sensor_get();
+  const sensor_profile_t *profile = find_profile(name, s->id.PID);
+  if (!profile) {
+    return SENSOR_PROFILE_UNKNOWN;
+  }
+  if (profile->framesize > framePipelineMaxFramesize()) {
+    return SENSOR_PROFILE_TOO_LARGE;
+  }
+  if (!framePipelineReconfigure(apply_settings, (void *)profile)) {
+    log_e("Profile %s not fully applied", profile->name);
+    return SENSOR_PROFILE_FAILED;
+  }
+  setQualityControlLimits(profile->framesize, profile->quality);
+
+  portENTER_CRITICAL(&profile_mux);
+  active = profile - profiles;
+  settling = true;
+  portEXIT_CRITICAL(&profile_mux);
+  store_profile(profile->name);
+  log_i("Sensor profile %s applied", profile->name);
+  return SENSOR_PROFILE_OK;
+}
+
+void startSensorProfiles() {
+  char name[SENSOR_PROFILE_NAME_MAX] = "";
+  Preferences prefs;
+  if (prefs.begin(SENSOR_PROFILE_NVS_NAMESPACE, true)) {
+    prefs.getString("name", name, sizeof(name));
+    prefs.end();
+  }
+  if (name[0] && applySensorProfile(name) != SENSOR_PROFILE_OK) {
+    log_w("Stored sensor profile %s not applied", name);
+  }
+
+  if (sample_timer) {
+    return;
+  }
+  const esp_timer_create_args_t timer_args = {
+    .callback = sampleRate,
+    .arg = NULL,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "sensor_profile",
+    .skip_unhandled_events = true,
+  };
+  if (esp_timer_create(&timer_args, &sample_timer) != ESP_OK) {
+    log_e("Sensor profile timer init failed, capture rate not measured");
+    return;
+  }
+  esp_timer_start_periodic(sample_timer, SENSOR_PROFILE_SAMPLE_MS * 1000);
+}
+
+int printSensorProfileStatus(char *p) {
+  uint16_t pid = esp_camera_sensor_get()->id.PID;
+  int current;
+  int fps[PROFILE_COUNT];
+  portENTER_CRITICAL(&profile_mux);
+  current = active;
+  memcpy(fps, fps_x10, sizeof(fps));
+  portEXIT_CRITICAL(&profile_mux);
+
+  char *start = p;
+  p += sprintf(p, "\"profile\":\"%s\",\"profile_fps\":{", current >= 0 ? profiles[current].name : "");
+  bool first = true;
+  for (int i = 0; i < PROFILE_COUNT; i++) {
+    if (profiles[i].pid && profiles[i].pid != pid) {
+      continue;
+    }
+    if (!first) {
+      *p++ = ',';
+    }
+    first = false;
+    if (fps[i]) {
+      p += sprintf(p, "\"%s\":%d.%d", profiles[i].name, fps[i] / 10, fps[i] % 10);
+    } else {
+      p += sprintf(p, "\"%s\":null", profiles[i].name);
+    }
+  }
+  p += sprintf(p, "},");
+  return p - start;
+}
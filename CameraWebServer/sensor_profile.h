@@ -0,0 +1,42 @@
+#ifndef SENSOR_PROFILE_H
+#define SENSOR_PROFILE_H
+
+#include <stdint.h>
+
+//
+// Named sensor performance profiles. A profile sets the XCLK, the frame size,
+// the JPEG quality and the sensor clock/window registers that go with them in
+// one step, from the capture task between two captures (see
+// framePipelineReconfigure), so no frame is published with half of it
+// applied. The last profile applied is kept in NVS and applied again at boot.
+//
+// The capture rate is sampled every SENSOR_PROFILE_SAMPLE_MS while frames are
+// consumed and smoothed per profile, so the profiles can be compared on the
+// actual link from /status.
+//
+// Applied through /profile?name=<profile>.
+//
+
+#define SENSOR_PROFILE_SAMPLE_MS     1000
+#define SENSOR_PROFILE_NVS_NAMESPACE "sensor_prof"
+#define SENSOR_PROFILE_NAME_MAX      24
+
+typedef enum {
+  SENSOR_PROFILE_OK = 0,
+  SENSOR_PROFILE_UNKNOWN = -1,      // no such profile for this sensor
+  SENSOR_PROFILE_TOO_LARGE = -2,    // frame size larger than the frame buffers
+  SENSOR_PROFILE_FAILED = -3,       // the sensor refused a setting
+} sensor_profile_result_t;
+
+// Applies the profile stored in NVS, if any, and starts measuring the capture
+// rate. The camera must be initialized.
+void startSensorProfiles();
+
+// Applies a profile and stores it in NVS once applied.
+sensor_profile_result_t applySensorProfile(const char *name);
+
+// Appends the active profile and the capture rate measured with each profile
+// to a JSON status object, each entry followed by a comma.
+int printSensorProfileStatus(char *p);
+
+#endif  // SENSOR_PROFILE_H
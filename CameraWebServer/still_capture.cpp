@@ -0,0 +1,231 @@
+#include <string.h>
+#include <stdlib.h>
+#include "lwip/sockets.h"
+#include "esp_timer.h"
+#include "img_converters.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "board_config.h"
+#include "frame_pipeline.h"
+#include "jpeg_pool.h"
+#include "still_capture.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+// Gives up waiting for a frame newer than the trigger after this long
+#define STILL_TIMEOUT_US 2000000
+
+extern bool isStreaming;
+#if defined(LED_GPIO_NUM)
+void enable_led(bool en);
+#endif
+
+static bool armed_led = false;
+static esp_timer_handle_t arm_timer = NULL;
+
+// Last still, guarded by still_lock
+static SemaphoreHandle_t still_lock = NULL;
+static uint8_t *still_buf = NULL;
+static size_t still_buf_size = 0;
+static size_t still_len = 0;
+static int64_t still_trigger_us = 0;
+static int64_t still_capture_us = 0;
+
+static void set_led(bool on) {
+#if defined(LED_GPIO_NUM)
+  // the stream keeps its own LED on
+  if (on || !isStreaming) {
+    enable_led(on);
+  }
+#endif
+}
+
+static void arm_timeout(void *arg) {
+  log_i("Still arm timed out");
+  stillDisarm();
+}
+
+void stillArm(bool led) {
+  if (led && !armed_led) {
+    set_led(true);
+    armed_led = true;
+  }
+  if (arm_timer) {
+    esp_timer_stop(arm_timer);
+    esp_timer_start_once(arm_timer, STILL_ARM_TIMEOUT_MS * 1000ULL);
+  }
+}
+
+void stillDisarm() {
+  if (arm_timer) {
+    esp_timer_stop(arm_timer);
+  }
+  if (armed_led) {
+    set_led(false);
+    armed_led = false;
+  }
+}
+
+camera_fb_t *stillCapture(bool led, int64_t *trigger_us) {
+  int64_t trigger = esp_timer_get_time();
+  int64_t not_before = trigger;
+  *trigger_us = trigger;
+
+  if (led && !armed_led) {
+    set_led(true);
+    armed_led = true;
+    not_before += STILL_LED_SETTLE_MS * 1000;
+  }
+
+  // frames already in flight were exposed before the trigger (or the LED), skip them
+  camera_fb_t *fb = NULL;
+  int sub = framePipelineSubscribe();
+  while (sub >= 0 && esp_timer_get_time() - trigger < STILL_TIMEOUT_US) {
+    fb = framePipelineGet(sub, FRAME_GET_TIMEOUT);
+    if (!fb) {
+      break;
+    }
+    int64_t capture_us = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+    if (capture_us >= not_before) {
+      break;
+    }
+    framePipelineReturn(fb);
+    fb = NULL;
+  }
+  framePipelineUnsubscribe(sub);
+
+  stillDisarm();
+  return fb;
+}
+
+bool stillStore(const camera_fb_t *fb, int64_t trigger_us) {
+  if (!still_lock) {
+    return false;
+  }
+  uint8_t *jpg_buf = fb->buf;
+  size_t jpg_len = fb->len;
+  if (fb->format != PIXFORMAT_JPEG && !jpegPoolEncode((camera_fb_t *)fb, 80, &jpg_buf, &jpg_len)) {
+    return false;
+  }
+
+  bool ok = false;
+  xSemaphoreTake(still_lock, portMAX_DELAY);
+  if (jpg_len > still_buf_size) {
+    free(still_buf);
+    still_buf = (uint8_t *)malloc(jpg_len);
+    still_buf_size = still_buf ? jpg_len : 0;
+  }
+  if (still_buf) {
+    memcpy(still_buf, jpg_buf, jpg_len);
+    still_len = jpg_len;
+    still_trigger_us = trigger_us;
+    still_capture_us = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+    ok = true;
+  }
+  xSemaphoreGive(still_lock);
+
+  if (jpg_buf != fb->buf) {
+    jpegPoolRelease(jpg_buf);
+  }
+  return ok;
+}
+
+bool stillLockLast(const uint8_t **buf, size_t *len, int64_t *trigger_us, int64_t *capture_us) {
+  if (!still_lock) {
+    return false;
+  }
+  xSemaphoreTake(still_lock, portMAX_DELAY);
+  if (!still_len) {
+    xSemaphoreGive(still_lock);
+    return false;
+  }
+  *buf = still_buf;
+  *len = still_len;
+  *trigger_us = still_trigger_us;
+  *capture_us = still_capture_us;
+  return true;
+}
+
+void stillUnlock() {
+  xSemaphoreGive(still_lock);
+}
+
+static void handle_trigger(const still_trigger_t *trigger, still_ack_t *ack) {
+  ack->cmd = trigger->cmd;
+  ack->id = trigger->id;
+  ack->status = STILL_STATUS_OK;
+
+  if (trigger->cmd == STILL_CMD_ARM) {
+    stillArm(trigger->led);
+  } else if (trigger->cmd == STILL_CMD_DISARM) {
+    stillDisarm();
+  } else if (trigger->cmd == STILL_CMD_CAPTURE) {
+    int64_t trigger_us;
+    camera_fb_t *fb = stillCapture(trigger->led, &trigger_us);
+    ack->trigger_us = trigger_us;
+    if (fb && stillStore(fb, trigger_us)) {
+      ack->capture_us = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+      ack->len = still_len;
+    } else {
+      ack->status = STILL_STATUS_FAILED;
+    }
+    framePipelineReturn(fb);
+    log_i("Still #%u: trigger %lld, capture %lld", trigger->id, ack->trigger_us, ack->capture_us);
+  } else {
+    ack->status = STILL_STATUS_FAILED;
+  }
+}
+
+static void still_trigger_task(void *arg) {
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+  if (sock < 0) {
+    log_e("Still trigger socket failed");
+    vTaskDelete(NULL);
+    return;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(STILL_TRIGGER_PORT);
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    log_e("Still trigger bind failed");
+    close(sock);
+    vTaskDelete(NULL);
+    return;
+  }
+
+  while (true) {
+    still_trigger_t trigger;
+    struct sockaddr_in source;
+    socklen_t source_len = sizeof(source);
+    int len = recvfrom(sock, &trigger, sizeof(trigger), 0, (struct sockaddr *)&source, &source_len);
+    if (len != sizeof(trigger) || memcmp(trigger.magic, "TRG", sizeof(trigger.magic)) || trigger.version != STILL_VERSION) {
+      continue;
+    }
+
+    still_ack_t ack;
+    memset(&ack, 0, sizeof(ack));
+    memcpy(ack.magic, "TRA", sizeof(ack.magic));
+    ack.version = STILL_VERSION;
+    handle_trigger(&trigger, &ack);
+    sendto(sock, &ack, sizeof(ack), 0, (struct sockaddr *)&source, source_len);
+  }
+}
+
+void startStillTrigger() {
+  still_lock = xSemaphoreCreateMutex();
+  esp_timer_create_args_t timer_args = {};
+  timer_args.callback = arm_timeout;
+  timer_args.name = "still_arm";
+  if (!still_lock || esp_timer_create(&timer_args, &arm_timer) != ESP_OK) {
+    log_e("Still trigger init failed");
+    return;
+  }
+  log_i("Starting still trigger on udp port: '%d'", STILL_TRIGGER_PORT);
+  xTaskCreatePinnedToCore(still_trigger_task, "still_trigger", 4096, NULL, 5, NULL, FRAME_NETWORK_CORE);
+}
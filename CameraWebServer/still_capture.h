@@ -0,0 +1,72 @@
+#ifndef STILL_CAPTURE_H
+#define STILL_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_camera.h"
+
+//
+// Capture on trigger: returns the first frame whose capture finished after
+// the trigger, with its real sensor timestamp. Arming turns the flash LED on
+// ahead of time, so a still taken while armed needs no LED settle delay;
+// an unarmed still with flash falls back to waiting STILL_LED_SETTLE_MS.
+//
+// Besides HTTP, stills can be triggered with still_trigger_t datagrams on
+// STILL_TRIGGER_PORT (e.g. broadcast by the drone at a waypoint). Every
+// trigger is answered with a still_ack_t, and the JPEG of the last still is
+// served by /still.
+//
+
+#define STILL_TRIGGER_PORT    83
+#define STILL_VERSION         1
+#define STILL_LED_SETTLE_MS   150
+#define STILL_ARM_TIMEOUT_MS  5000  // armed LED is turned off if no still follows
+
+#define STILL_CMD_ARM     0
+#define STILL_CMD_CAPTURE 1
+#define STILL_CMD_DISARM  2
+
+#define STILL_STATUS_OK     0
+#define STILL_STATUS_FAILED 1
+
+typedef struct __attribute__((packed)) {
+  char magic[3];    // "TRG"
+  uint8_t version;  // STILL_VERSION
+  uint8_t cmd;      // STILL_CMD_*
+  uint8_t led;      // arm/capture with the flash LED
+  uint32_t id;      // echoed in the ack
+} still_trigger_t;
+
+typedef struct __attribute__((packed)) {
+  char magic[3];         // "TRA"
+  uint8_t version;       // STILL_VERSION
+  uint8_t cmd;           // command acknowledged
+  uint8_t status;        // STILL_STATUS_*
+  uint32_t id;           // trigger id
+  uint64_t trigger_us;   // local time the trigger was received (us)
+  uint64_t capture_us;   // sensor capture time of the still (us)
+  uint32_t len;          // JPEG length, fetch it from /still
+} still_ack_t;
+
+// Starts the UDP trigger listener. WiFi must be started.
+void startStillTrigger();
+
+// Turns the flash LED on ahead of a still (if led) and marks the camera armed.
+void stillArm(bool led);
+
+// Cancels a previous stillArm().
+void stillDisarm();
+
+// Takes the first frame captured after now. Return it with framePipelineReturn().
+// The trigger time is stored in trigger_us. Turns the armed LED off.
+camera_fb_t *stillCapture(bool led, int64_t *trigger_us);
+
+// Keeps a copy of a JPEG still so it can be fetched later from /still.
+bool stillStore(const camera_fb_t *fb, int64_t trigger_us);
+
+// Locks the last stored still. Returns false if there is none; call stillUnlock() otherwise.
+bool stillLockLast(const uint8_t **buf, size_t *len, int64_t *trigger_us, int64_t *capture_us);
+
+void stillUnlock();
+
+#endif  // STILL_CAPTURE_H
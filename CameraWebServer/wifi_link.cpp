@@ -0,0 +1,117 @@
+#include <WiFi.h>
+#include <Preferences.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "wifi_link.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#endif
+
+#define LINK_UP   BIT0
+#define LINK_DOWN BIT1
+
+static const char *link_ssid = NULL;
+static const char *link_password = NULL;
+static EventGroupHandle_t link_events = NULL;
+
+// Access point of the last connection, as stored in NVS
+static bool cached = false;
+static uint8_t cached_bssid[6];
+static int32_t cached_channel = 0;
+static int cached_failures = 0;
+static int64_t connect_start_us = 0;
+
+static void loadCachedAp() {
+  Preferences prefs;
+  if (!prefs.begin(WIFI_NVS_NAMESPACE, true)) {
+    return;
+  }
+  cached_channel = prefs.getInt("channel", 0);
+  cached = cached_channel > 0 && prefs.getBytes("bssid", cached_bssid, sizeof(cached_bssid)) == sizeof(cached_bssid);
+  prefs.end();
+}
+
+static void storeCachedAp(const uint8_t *bssid, int32_t channel) {
+  if (cached && channel == cached_channel && !memcmp(bssid, cached_bssid, sizeof(cached_bssid))) {
+    return;
+  }
+  Preferences prefs;
+  if (!prefs.begin(WIFI_NVS_NAMESPACE, false)) {
+    return;
+  }
+  prefs.putBytes("bssid", bssid, sizeof(cached_bssid));
+  prefs.putInt("channel", channel);
+  prefs.end();
+  memcpy(cached_bssid, bssid, sizeof(cached_bssid));
+  cached_channel = channel;
+  cached = true;
+  log_i("WiFi access point cached, channel %d", channel);
+}
+
+static void connectAp() {
+  connect_start_us = esp_timer_get_time();
+  if (cached && cached_failures < WIFI_CACHED_ATTEMPTS) {
+    cached_failures++;
+    WiFi.begin(link_ssid, link_password, cached_channel, cached_bssid);
+  } else {
+    // the access point moved or changed channel: scan for it again
+    cached_failures = 0;
+    cached = false;
+    WiFi.begin(link_ssid, link_password);
+  }
+}
+
+static void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      cached_failures = 0;
+      storeCachedAp(WiFi.BSSID(), WiFi.channel());
+      xEventGroupClearBits(link_events, LINK_DOWN);
+      xEventGroupSetBits(link_events, LINK_UP);
+      log_i("WiFi connected in %lld ms, IP %s", (esp_timer_get_time() - connect_start_us) / 1000,
+            WiFi.localIP().toString().c_str());
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      xEventGroupClearBits(link_events, LINK_UP);
+      xEventGroupSetBits(link_events, LINK_DOWN);
+      break;
+    default:
+      break;
+  }
+}
+
+// Retries the association with a growing delay until the link is up again
+static void wifi_link_task(void *arg) {
+  while (true) {
+    xEventGroupWaitBits(link_events, LINK_DOWN, pdTRUE, pdFALSE, portMAX_DELAY);
+    uint32_t delay_ms = WIFI_RETRY_MIN_MS;
+    while (!(xEventGroupWaitBits(link_events, LINK_UP, pdFALSE, pdFALSE, pdMS_TO_TICKS(delay_ms)) & LINK_UP)) {
+      log_w("WiFi link down, reconnecting");
+      connectAp();
+      delay_ms = delay_ms * 2 < WIFI_RETRY_MAX_MS ? delay_ms * 2 : WIFI_RETRY_MAX_MS;
+    }
+    // disconnect events of the failed attempts
+    xEventGroupClearBits(link_events, LINK_DOWN);
+  }
+}
+
+void startWifiLink(const char *ssid, const char *password) {
+  link_ssid = ssid;
+  link_password = password;
+  link_events = xEventGroupCreate();
+  loadCachedAp();
+
+  // credentials are not rewritten to flash on every begin, reconnects are handled here
+  WiFi.persistent(false);
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(false);
+  WiFi.setAutoReconnect(false);
+  WiFi.onEvent(onWifiEvent);
+
+  xTaskCreate(wifi_link_task, "wifi_link", 3072, NULL, 4, NULL);
+  log_i("WiFi connecting to %s%s", ssid, cached ? " (cached access point)" : "");
+  connectAp();
+}
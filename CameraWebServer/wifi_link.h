@@ -0,0 +1,25 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//
+// WiFi station link that never blocks the boot. The BSSID and channel of the
+// last access point are kept in NVS, so after a reset (e.g. a brown-out in
+// flight) the camera associates directly, without scanning every channel.
+// The association runs while the camera initializes, and the servers start
+// without waiting for it. Lost links are retried in the background with an
+// exponential backoff; after WIFI_CACHED_ATTEMPTS failed direct attempts the
+// cached access point is dropped and a full scan is done.
+//
+
+#define WIFI_RETRY_MIN_MS     100
+#define WIFI_RETRY_MAX_MS     2000
+#define WIFI_CACHED_ATTEMPTS  2
+#define WIFI_NVS_NAMESPACE    "wifi_link"
+
+// Starts associating to the access point and returns at once.
+void startWifiLink(const char *ssid, const char *password);
+
+#endif  // WIFI_LINK_H
@@ -0,0 +1,95 @@
+from drone.drone import Drone
+from drone.camera_simulator import CameraSimulator
+from drone.color_detection import ColorDetection
+from drone.telemetry_simulator import TelemetrySimulator
+from drone.movementSimulator.spiral_movement_simulator import SpiralMovementSimulator
+from robotDog.robot_dog_simulator import RobotDogSimulator
+from operation.operation_controller import OperationController
+from operation.operation_benchmark import OperationBenchmark
+from planners.nearest_neighbor_planner import NearestNeighborPlanner
+from planners.local_search_planner import LocalSearchPlanner
+from planners.distance_providers import ObstacleDistanceProvider
+from utils.logs import ColoredFormatter
+from utils import sim_clock
+from glob import glob
+from math import pi
+import argparse
+import logging
+import os
+
+import configuration
+
+PLANNERS = {
+    "nearest_neighbor": lambda distance: NearestNeighborPlanner(distance=distance),
+    "local_search": lambda distance: LocalSearchPlanner(distance=distance),
+}
+
+parser = argparse.ArgumentParser(description="Runs operations headless with simulators and saves benchmark results.")
+parser.add_argument("scenarios", nargs="*", help="Operation files, the BENCHMARK_SCENARIOS files if none.")
+parser.add_argument("--planner", choices=sorted(PLANNERS) + ["ilp"], default="local_search", help="Inspection path planner.")
+parser.add_argument("--inspectors", type=int, default=configuration.robot_dog.ROBOT_DOG_COUNT, help="Number of robot dogs.")
+parser.add_argument("--explorers", type=int, default=1,
+                    help="Number of drones flying interleaved spiral arms, sharing the color detection models and workers.")
+parser.add_argument("--color", default=configuration.color_detection.COLOR_DETECTION_COLOR, help="Color to detect.")
+parser.add_argument("--model", default=configuration.color_detection.YOLO_MODEL_PATH, help="YOLO model of the color detection.")
+parser.add_argument("--exploration-time", type=float, default=configuration.benchmark.BENCHMARK_EXPLORATION_TIME,
+                    help="Exploration time (in simulated seconds) of each mission.")
+parser.add_argument("--runs", type=int, default=1, help="Number of runs of each scenario.")
+parser.add_argument("--speed", type=float, default=configuration.simulation.SIMULATION_SPEED,
+                    help="Simulated seconds per real second.")
+parser.add_argument("--discrete-event", action="store_true", default=configuration.simulation.SIMULATION_DISCRETE_EVENT,
+                    help="Jump from one wake-up to the next instead of running the clock.")
+args = parser.parse_args()
+
+if args.planner == "ilp":
+    from planners.ilp_planner import ILPPlanner
+    PLANNERS["ilp"] = lambda distance: ILPPlanner(distance=distance)
+
+handler = logging.StreamHandler()
+handler.setFormatter(ColoredFormatter("[%(levelname)s] %(name)s: %(message)s"))
+
+logging.basicConfig(
+    level=logging.WARNING,
+    handlers=[handler]
+)
+logging.getLogger("OperationBenchmark").setLevel(logging.INFO)
+
+if args.discrete_event:
+    sim_clock.set_clock(sim_clock.DiscreteEventClock())
+elif args.speed != 1.0:
+    sim_clock.set_clock(sim_clock.SimulationClock(args.speed))
+
+scenarios = args.scenarios or sorted(glob(configuration.benchmark.BENCHMARK_SCENARIOS))
+color_detector = ColorDetection(args.color, args.model)
+if not color_detector.wait_ready():
+    raise SystemExit("Color detection could not load its YOLO model.")
+
+for scenario in scenarios:
+    for run in range(args.runs):
+        # Arms as far apart as the turns of a single spiral, so that the fleet covers the same ground sooner
+        explorers = [Drone(
+            telemetry=TelemetrySimulator(SpiralMovementSimulator(
+                configuration.movement_simulator.SPIRAL_SIMULATOR_RADIAL_GROWTH * args.explorers,
+                configuration.movement_simulator.SPIRAL_SIMULATOR_LINEAR_SPEED,
+                2 * pi * i / args.explorers
+            )),
+            camera=CameraSimulator(),
+            color_detection=color_detector if args.explorers == 1 else color_detector.open_channel(f"ColorDetection{i}"),
+            show_viewer=False,
+        ) for i in range(args.explorers)]
+
+        inspectors = [RobotDogSimulator(configuration.robot_dog.ROBOT_DOG_SPEED) for _ in range(args.inspectors)]
+
+        planner = PLANNERS[args.planner](ObstacleDistanceProvider.from_json(scenario))
+
+        controller = OperationController(
+            explorer_robot=explorers,
+            inspector_robot=inspectors,
+            planner=planner,
+            base_positions_path=scenario
+        )
+
+        name = os.path.splitext(os.path.basename(scenario))[0]
+        benchmark = OperationBenchmark(controller, color_detector, f"{name} {args.planner} x{args.explorers}/{args.inspectors} run {run}")
+        results = benchmark.run(args.exploration_time)
+        benchmark.save(results, f"{name}_{args.planner}_{run}")
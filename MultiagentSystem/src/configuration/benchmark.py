@@ -0,0 +1,66 @@
+from typing import Final
+
+BENCHMARK_SCENARIOS: Final[str] = "input/operation*.json"
+"""Glob pattern of the operation files run by the benchmark by default."""
+
+BENCHMARK_OUTPUT_FOLDER: Final[str] = "results/benchmarks"
+"""Path to the folder where the benchmark results will be saved."""
+
+BENCHMARK_EXPLORATION_TIME: Final[float] = 60.0
+"""Exploration time (in simulated seconds) of each mission of a benchmark run."""
+
+BENCHMARK_TIMEOUT: Final[float] = 3600.0
+"""Longest duration (in simulated seconds) of a benchmark run, the operation is reported as unfinished then."""
+
+BENCHMARK_POLL_TIME: Final[float] = 0.5
+"""Period (in simulated seconds) at which the benchmark checks the progress of the operation."""
+
+PLANNER_BENCHMARK_SIZES: Final[tuple] = (10, 30, 100, 300, 1000)
+"""Numbers of points of the instances of the planner benchmark."""
+
+PLANNER_BENCHMARK_DISTRIBUTIONS: Final[tuple] = ("uniform", "clustered", "lines")
+"""Point distributions of the planner benchmark: "uniform" over the area, "clustered" around a few centres
+and "lines" along a few segments."""
+
+PLANNER_BENCHMARK_AREA: Final[float] = 20.0
+"""Side (in meters) of the square area, centred on the start point, the benchmark points are drawn in."""
+
+PLANNER_BENCHMARK_INSTANCES: Final[int] = 3
+"""Number of instances drawn per distribution and number of points, the results are averaged over them."""
+
+PLANNER_BENCHMARK_ILP_MAX_POINTS: Final[int] = 30
+"""Largest instance (in points) the ILP planner is run on, as its solve time grows exponentially."""
+
+LATENCY_BENCHMARK_TRIALS: Final[int] = 20
+"""Number of stimuli shown to the camera by the latency benchmark."""
+
+LATENCY_BENCHMARK_OFF_TIME: Final[float] = 1.0
+"""Time (in seconds) the stimulus stays off before each trial, for the exposure to settle back."""
+
+LATENCY_BENCHMARK_TIMEOUT: Final[float] = 3.0
+"""Longest wait (in seconds) for the detection of a stimulus, the trial is counted as missed then."""
+
+LATENCY_BENCHMARK_SYNC_TIMEOUT: Final[float] = 10.0
+"""Longest wait (in seconds) for the camera clock to be synchronized before the first trial."""
+
+MODEL_EXPORT_MAX_FRAMES: Final[int] = 500
+"""Largest number of recorded frames, spread evenly over the recordings, labelled for the calibration and
+fine-tuning dataset of the target model."""
+
+MODEL_EXPORT_VAL_FRACTION: Final[float] = 0.2
+"""Fraction of the labelled frames kept for validation rather than training."""
+
+MODEL_EXPORT_EPOCHS: Final[int] = 50
+"""Number of epochs the target model is fine-tuned for, 0 to only write the calibration dataset and export."""
+
+MODEL_BENCHMARK_REFERENCE: Final[str] = "coco"
+"""Detection model the others are compared to by the model benchmark, key of COLOR_DETECTION_MODELS."""
+
+LOAD_BENCHMARK_FPS: Final[tuple] = (5, 20, 50, 100, 200)
+"""Frame rates (in frames per second) the load benchmark serves the camera simulator frame bank at."""
+
+LOAD_BENCHMARK_DURATION: Final[float] = 10.0
+"""Duration (in simulated seconds) of each frame rate of the load benchmark."""
+
+LOAD_BENCHMARK_BANK_SIZE: Final[int] = 300
+"""Number of frames in the camera simulator frame bank of the load benchmark."""
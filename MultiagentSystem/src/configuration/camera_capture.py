@@ -6,9 +6,60 @@ CAMERA_STREAM_URL: Final[str] = "http://192.168.43.44:81/stream"
 CAMERA_FLASH_URL: Final[str] = CAMERA_STREAM_URL.replace("81/stream", "80/control")
 """URL to control the camera flash."""
 
+CAMERA_STATUS_URL: Final[str] = CAMERA_STREAM_URL.replace("81/stream", "80/status.bin")
+"""URL of the camera binary status."""
+
+CAMERA_STATUS_VERSION: Final[int] = 1
+"""Expected version of the camera binary status."""
+
+CAMERA_STATUS_FORMAT: Final[str] = "<2sBBBBBbbbbBBBBBBbHBBBBBBBBBBBhBBB"
+"""Struct format of the camera binary status (camera_status_t)."""
+
+CAMERA_STATUS_FIELDS: Final[tuple] = (
+    "magic", "version", "xclk", "pixformat", "framesize", "quality", "brightness", "contrast",
+    "saturation", "sharpness", "special_effect", "wb_mode", "awb", "awb_gain", "aec", "aec2",
+    "ae_level", "aec_value", "agc", "agc_gain", "gainceiling", "bpc", "wpc", "raw_gma", "lenc",
+    "hmirror", "vflip", "dcw", "colorbar", "led_intensity", "pf_mode", "qc_enable", "qc_fps",
+)
+"""Field names of the camera binary status, in struct order."""
+
+CAMERA_ROI_URL: Final[str] = CAMERA_STREAM_URL.replace("81/stream", "80/roi")
+"""URL to set the region of interest streamed as high resolution crops."""
+
+CAMERA_ROI_EVERY: Final[int] = 4
+"""Number of full view frames the camera sends between two region of interest crops."""
+
+CAMERA_FRAME_STREAM_HOST: Final[str] = "192.168.43.44"
+"""Host of the camera raw TCP frame stream."""
+
+CAMERA_FRAME_STREAM_PORT: Final[int] = 82
+"""Port of the camera raw TCP frame stream."""
+
+CAMERA_FRAME_STREAM_VERSION: Final[int] = 4
+"""Expected frame header version of the raw TCP frame stream."""
+
+CAMERA_FRAME_STREAM_HEADER: Final[str] = "<2sBBIQIIHQi6fh4H2I"
+"""Struct format of the raw TCP frame header: magic, version, flags, seq, capture time, previous send
+latency, JPEG length, pose seq, pose timestamp, pose age, pose (x, y, z, roll, pitch, yaw), color prefilter
+ratio (per mille, -1 if not measured), crop region (x, y, width, height), time waited in the camera
+pipeline and JPEG encoding time (in microseconds)."""
+
+CAMERA_FRAME_STREAM_MAX_FRAME: Final[int] = 512 * 1024
+"""Largest JPEG accepted from the raw TCP frame stream (in bytes); larger lengths mean a desynchronized stream."""
+
 CAMERA_STREAM_RETRY_DELAY: Final[float] = 5.0
 """Delay before retrying to open the camera stream (in seconds)."""
 
+CAMERA_STREAM_RETRY_MIN_DELAY: Final[float] = 0.05
+"""First delay before reconnecting to the multipart stream parsed directly (in seconds), doubled
+after each failed attempt up to CAMERA_STREAM_RETRY_MAX_DELAY."""
+
+CAMERA_STREAM_RETRY_MAX_DELAY: Final[float] = 0.8
+"""Longest delay before reconnecting to the multipart stream parsed directly (in seconds)."""
+
+CAMERA_STREAM_CONNECT_TIMEOUT: Final[float] = 1.0
+"""Timeout for connecting to the multipart stream parsed directly (in seconds)."""
+
 CAMERA_REQUEST_TIMEOUT: Final[float] = 1.0
 """Timeout for camera HTTP requests (in seconds)."""
 
@@ -19,4 +70,36 @@ CAMERA_FLASH_INTENSITY_OFF: Final[int] = 0
 """Flash intensity used to turn the camera flash OFF."""
 
 CAMERA_SLEEP_TIME: Final[float] = 0.01
-"""Sleep duration (in seconds) between camera processing cycles."""
\ No newline at end of file
+"""Sleep duration (in seconds) between camera processing cycles."""
+
+CAMERA_STREAM_METADATA: Final[bool] = True
+"""If True, the stream is parsed directly to read the frame sequence number and the embedded drone pose
+from each part header. If False, frames are read with OpenCV and carry no metadata."""
+
+CAMERA_STREAM_CHUNK_SIZE: Final[int] = 65536
+"""Size (in bytes) of the socket reads of the camera stream when parsing it directly."""
+
+CAMERA_STREAM_TIMEOUT: Final[float] = 5.0
+"""Timeout for reading the camera stream when parsing it directly (in seconds)."""
+
+CAMERA_CONTROL_PORT: Final[int] = 84
+"""UDP port of the camera binary control channel."""
+
+CAMERA_CONTROL_VERSION: Final[int] = 1
+"""Expected version of the camera control channel messages."""
+
+CAMERA_CONTROL_TIMEOUT: Final[float] = 0.05
+"""Time to wait for the camera to acknowledge a control command before sending it again (in seconds)."""
+
+CAMERA_CONTROL_RETRIES: Final[int] = 3
+"""Number of times a control command is sent before falling back to the HTTP control endpoint."""
+
+CAMERA_CONTROL_VARS: Final[tuple] = (
+    "framesize", "quality", "contrast", "brightness", "saturation", "gainceiling",
+    "colorbar", "awb", "agc", "aec", "hmirror", "vflip", "awb_gain", "agc_gain",
+    "aec_value", "aec2", "dcw", "bpc", "wpc", "raw_gma", "lenc", "special_effect",
+    "wb_mode", "ae_level", "led_intensity",
+    "pf_mode", "pf_h1_min", "pf_h1_max", "pf_h2_min", "pf_h2_max", "pf_s_min", "pf_v_min", "pf_ratio",
+    "qc_enable", "qc_fps", "att_mode", "att_max",
+)
+"""Settings of the control channel, numbered in this order (control_vars in the camera firmware)."""
\ No newline at end of file
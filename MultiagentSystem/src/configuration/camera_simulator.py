@@ -31,3 +31,14 @@ CAMERA_SIMULATOR_FRAME_PERIOD: Final[float] = 2.0
 
 CAMERA_SIMULATOR_SLEEP_TIME: Final[float] = 0.01
 """Sleep duration (in seconds) between camera simulator cycles."""
+
+CAMERA_SIMULATOR_BANK_SIZE: Final[int] = 0
+"""Number of frames the camera simulator renders at creation and serves in a loop, 0 to draw each frame when served.
+Served from a bank, frames are cheap enough for frame periods of a few milliseconds, and their objects are known in advance.
+"""
+
+CAMERA_SIMULATOR_BANK_SEED: Final[int] = 0
+"""Seed of the random objects of the frame bank, the same seed gives the same frames."""
+
+CAMERA_SIMULATOR_BANK_JPEG: Final[bool] = True
+"""Whether the frame bank holds JPEG frames, decoded by their readers as the frames of the real camera are."""
@@ -0,0 +1,22 @@
+from typing import Final
+
+CLOCK_OFFSET_DRIFT_US_PER_S: Final[float] = 200.0
+"""Rate (in microseconds per second) at which a clock offset estimate is raised, to follow the drift between the clocks."""
+
+CLOCK_OFFSET_RESET_US: Final[int] = 1_000_000
+"""Backward jump (in microseconds) of a remote clock that resets its offset estimate, as after a reboot."""
+
+CLOCK_SYNC_PERIOD: Final[float] = 0.5
+"""Period (in seconds) of the time exchanges with the drone and the camera."""
+
+CLOCK_SYNC_WINDOW: Final[int] = 40
+"""Number of recent time exchanges the offset and drift are estimated from."""
+
+CLOCK_SYNC_BEST: Final[int] = 10
+"""Number of exchanges of the window with the shortest round trip used for the estimate, the others waited in a queue."""
+
+CLOCK_SYNC_MIN_DRIFT_SPAN_US: Final[int] = 5_000_000
+"""Shortest time span (in microseconds) of the exchanges used before the drift is estimated, rather than assumed zero."""
+
+CLOCK_SYNC_MAX_DRIFT_PPM: Final[float] = 500.0
+"""Largest drift (in parts per million) accepted between two clocks, crystals stay well within it."""
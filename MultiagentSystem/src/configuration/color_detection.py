@@ -1,12 +1,40 @@
 from pathlib import Path
 from typing import Final
+from configuration.operation import DRONE_VISIBILITY
 
 PROJECT_ROOT: Final[Path] = Path(__file__).resolve().parent.parent
 """Absolute path to the project root directory."""
 
-YOLO_MODEL_PATH: Final[Path] = PROJECT_ROOT / "yoloModels" / "yolov8n.pt"
+COLOR_DETECTION_MODELS: Final[dict] = {
+    "coco": {
+        "path": PROJECT_ROOT / "yoloModels" / "yolov8n.pt",
+        "img_size": 256,
+        "int8": False,
+    },
+    "target_int8": {
+        "path": PROJECT_ROOT / "yoloModels" / "target.pt",
+        "img_size": 160,
+        "int8": True,
+    },
+}
+"""Detection models: YOLO model file, input image size (in pixels) and whether its exported backends are
+quantized to INT8. "coco" is the generic COCO model, "target_int8" a single-class model of the targets,
+fine-tuned and exported by model_export.py, which is smaller and faster for the same accuracy."""
+
+COLOR_DETECTION_MODEL: Final[str] = "coco"
+"""Detection model used, key of COLOR_DETECTION_MODELS."""
+
+YOLO_MODEL_PATH: Final[Path] = COLOR_DETECTION_MODELS[COLOR_DETECTION_MODEL]["path"]
 """Absolute path to the YOLO model file."""
 
+COLOR_DETECTION_INT8: Final[bool] = COLOR_DETECTION_MODELS[COLOR_DETECTION_MODEL]["int8"]
+"""If True, the model is exported quantized to INT8 for the "tensorrt" and "openvino" backends, calibrated on
+COLOR_DETECTION_CALIBRATION_DATA. The other backends run it unquantized."""
+
+COLOR_DETECTION_CALIBRATION_DATA: Final[Path] = PROJECT_ROOT / "yoloModels" / "calibration" / "data.yaml"
+"""Absolute path to the dataset description (YOLO data.yaml) of the recorded frames used to calibrate the INT8
+export, written by model_export.py."""
+
 COLOR_DETECTION_COLOR: Final[str] = "red"
 """Target color for detection."""
 
@@ -51,9 +79,13 @@ COLOR_DETECTION_COLORS: Final[dict] = {
 }
 """HSV color ranges used for color segmentation."""
 
-COLOR_DETECTION_IMG_SIZE: Final[int] = 256
+COLOR_DETECTION_IMG_SIZE: Final[int] = COLOR_DETECTION_MODELS[COLOR_DETECTION_MODEL]["img_size"]
 """Input image size (in pixels) used for YOLO inference."""
 
+COLOR_DETECTION_REDUCED_DECODE: Final[bool] = True
+"""If True, JPEG frames are decoded for YOLO at the smallest reduced size (1/2, 1/4 or 1/8) whose longer
+side is still at least COLOR_DETECTION_IMG_SIZE, instead of at full size."""
+
 COLOR_DETECTION_CONF_THRESH: Final[float] = 0.35
 """Confidence threshold for YOLO detections."""
 
@@ -61,11 +93,103 @@ COLOR_DETECTION_IOU_THRESH: Final[float] = 0.45
 """Intersection-over-Union threshold for non-maximum suppression."""
 
 COLOR_DETECTION_MIN_BOX_AREA: Final[int] = 100
-"""Minimum acceptable bounding box area (in pixels) for detected objects."""
+"""Minimum acceptable bounding box area (in pixels of the full size frame) for detected objects."""
+
+COLOR_DETECTION_PREFILTER_MIN_RATIO: Final[float] = 0.005
+"""Frames whose camera-measured color ratio is below this value are skipped without running YOLO.
+Frames the camera did not measure are always processed."""
+
+COLOR_DETECTION_GATE: Final[bool] = True
+"""If True, frames the camera did not measure are measured on the ground station with a downscaled
+HSV pass, and skipped without running YOLO below COLOR_DETECTION_PREFILTER_MIN_RATIO."""
+
+COLOR_DETECTION_GATE_SCALE: Final[float] = 0.25
+"""Scale factor applied to the frames before the ground station HSV gate."""
+
+COLOR_DETECTION_PREFILTER_MODE: Final[int] = 1
+"""Camera color prefilter mode pushed by CameraCapture.set_color_prefilter: 0 off, 1 flag frames, 2 skip frames."""
+
+COLOR_DETECTION_SKIP_TILTED: Final[bool] = True
+"""If True, frames the camera flagged as taken while the drone was tilted are skipped, since their
+detections would be projected to wrong ground positions."""
+
+COLOR_DETECTION_FOOTPRINT_RADIUS: Final[float] = DRONE_VISIBILITY
+"""Radius (in meters) of the ground area seen in a frame. It is set to `DRONE_VISIBILITY`."""
+
+COLOR_DETECTION_MAX_OVERLAP: Final[float] = 0.7
+"""Frames whose footprint overlaps the footprint of the last processed frame by more than this
+fraction are skipped, 1.0 to process every frame."""
+
+COLOR_DETECTION_MAX_SKIP_INTERVAL: Final[float] = 1.0
+"""Longest time (in seconds) frames are skipped for overlap, so a hovering drone still
+processes a frame at this interval."""
 
 COLOR_DETECTION_THRESH: Final[float] = 0.30
 """Final threshold for color-based decision making."""
 
-COLOR_DETECTION_SLEEP_TIME: Final[float] = 0.01
-"""Sleep duration (in seconds) between color detection processing cycles."""
+COLOR_DETECTION_GROUND_PROJECTION: Final[bool] = True
+"""If True, each detected object is located where the ray through its box centre meets the ground, from the
+drone height and attitude and the camera intrinsics. Otherwise it is located at the drone position."""
+
+COLOR_DETECTION_CAMERA_HFOV: Final[float] = 60.0
+"""Horizontal field of view (in degrees) of the camera, which looks straight down with the top of the image
+toward the front of the drone."""
+
+COLOR_DETECTION_CAMERA_VIEW_SIZE: Final[tuple] = (320, 240)
+"""Width and height (in pixels) of the full view frames, whose coordinates the region of crop frames is given in."""
+
+COLOR_DETECTION_BATCH_SIZE: Final[int] = 4
+"""Maximum number of frames run through YOLO in one batch, 1 to process the frames one by one."""
+
+COLOR_DETECTION_BATCH_WINDOW: Final[float] = 0.02
+"""Longest wait (in seconds) for more frames once the first frame of a batch is taken."""
+
+COLOR_DETECTION_BACKENDS: Final[tuple] = ("tensorrt", "cuda", "openvino", "onnx", "cpu")
+"""Inference backends tried at startup: "tensorrt" (CUDA engine, fp16), "cuda" (PyTorch on CUDA, fp16),
+"openvino", "onnx" (ONNX Runtime) and "cpu" (PyTorch). Unavailable backends are skipped; "cpu" is
+always tried last, even if not listed. Exported models are cached next to the YOLO model file."""
+
+COLOR_DETECTION_BACKEND_BENCHMARK: Final[bool] = True
+"""If True, every available backend is benchmarked at startup and the fastest one is used.
+Otherwise, the first available backend of COLOR_DETECTION_BACKENDS is used."""
+
+COLOR_DETECTION_BENCHMARK_RUNS: Final[int] = 5
+"""Number of timed inferences per backend in the startup benchmark, after one warm-up inference."""
+
+COLOR_DETECTION_BACKEND_CACHE: Final[bool] = True
+"""If True, the backend selected at startup is recorded next to the YOLO model file and loaded directly
+on the next runs, without the benchmark. The benchmark runs again if that backend fails to load."""
+
+COLOR_DETECTION_BACKGROUND_LOAD: Final[bool] = True
+"""If True, the YOLO models are loaded and warmed up in a background thread, so creating the color detection
+does not block startup. Frames received before the models are ready wait in the queue."""
+
+COLOR_DETECTION_WORKERS: Final[int] = 2
+"""Number of detection worker threads, each running its own YOLO model instance on batches from the shared queue."""
+
+COLOR_DETECTION_MAILBOX_SIZE: Final[int] = COLOR_DETECTION_BATCH_SIZE * COLOR_DETECTION_WORKERS
+"""If above 0, the color detection receives its frames through a latest-value mailbox of that many frames
+(see utils.frame_mailbox), enough for one batch per worker, instead of a COLOR_DETECTION_MAX_QUEUE_SIZE queue."""
+
+COLOR_DETECTION_TRACK_RADIUS: Final[float] = DRONE_VISIBILITY
+"""Detections closer than this distance (in meters) to a tracked object are associated to it.
+Frames taken closer than this distance to a confirmed object are skipped. It is set to `DRONE_VISIBILITY`."""
+
+COLOR_DETECTION_TRACK_CONFIRM_HITS: Final[int] = 1
+"""Number of detections associated to a tracked object before it is confirmed and reported."""
+
+COLOR_DETECTION_TRACK_TIMEOUT: Final[float] = 2.0
+"""Time (in seconds) after which an unconfirmed tracked object without new detections is dropped."""
+
+COLOR_DETECTION_PROCESS: Final[bool] = False
+"""Whether the color detection runs in its own process (see drone.detection_process), so that decoding
+and inference do not share the interpreter lock with capture, matching and the user interface."""
+
+COLOR_DETECTION_RING_SLOTS: Final[int] = 16
+"""Number of frame slots of the shared memory ring through which the detection process receives its frames."""
+
+COLOR_DETECTION_RING_SLOT_SIZE: Final[int] = 2 * 1024 * 1024
+"""Largest frame (in bytes, JPEG or raw image) a slot of the shared memory ring holds; larger frames are dropped."""
 
+COLOR_DETECTION_PROCESS_TIMEOUT: Final[float] = 5.0
+"""Longest wait (in seconds) for the detection process to stop before it is terminated."""
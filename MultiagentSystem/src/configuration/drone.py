@@ -0,0 +1,31 @@
+from typing import Final
+from configuration.color_detection import COLOR_DETECTION_FOOTPRINT_RADIUS
+
+DRONE_KEEP_WARM: Final[bool] = True
+"""If True, the telemetry and the camera are paused between exploration routines instead of stopped, so that
+the next routine does not wait for their connections, handshakes and clock synchronization again."""
+
+DRONE_ROUTINE_TIMEOUT: Final[float] = 2.0
+"""Longest wait (in seconds) for the subcomponents of the drone, started or stopped together, to be done."""
+
+SPEED_GOVERNOR_ENABLED: Final[bool] = True
+"""If True, the drone ground speed is limited to what the color detection can keep up with (see SpeedGovernor)."""
+
+SPEED_GOVERNOR_PERIOD: Final[float] = 0.5
+"""Period (in simulated seconds) of the speed governor measurements and commands."""
+
+SPEED_GOVERNOR_FRAME_SPACING: Final[float] = COLOR_DETECTION_FOOTPRINT_RADIUS
+"""Longest ground distance (in meters) between handled frames for the coverage to stay complete. It is set to
+`COLOR_DETECTION_FOOTPRINT_RADIUS`, so the footprints of consecutive frames overlap by about 40%."""
+
+SPEED_GOVERNOR_MARGIN: Final[float] = 0.8
+"""Fraction of the sustainable speed commanded, leaving headroom for throughput variations."""
+
+SPEED_GOVERNOR_SMOOTHING: Final[float] = 0.3
+"""Weight (0 to 1) of the last period in the smoothed handled frame rate."""
+
+SPEED_GOVERNOR_MIN_SPEED: Final[float] = 0.05
+"""Lowest speed limit (in m/s) commanded, so that the drone still moves while no frame is handled."""
+
+SPEED_GOVERNOR_HYSTERESIS: Final[float] = 0.05
+"""Relative change of the speed limit below which no new command is sent."""
@@ -1,5 +1,5 @@
 import struct
-from typing import Final
+from typing import Dict, Final, Tuple
 
 DRONE_IP: Final[str] = "192.168.43.42"
 """IP address of the drone telemetry server."""
@@ -10,29 +10,180 @@ DRONE_PORT: Final[int] = 2390
 LOCAL_PORT: Final[int] = 2391
 """Local UDP port used to receive telemetry data."""
 
+TELEMETRY_PACKET_VERSION: Final[int] = 3
+"""Telemetry packet format version expected in every packet header."""
+
 PACKET_ID_BATTERY: Final[int] = 0x01
 """Packet ID for battery telemetry packets."""
 
 PACKET_ID_POSE: Final[int] = 0x02
 """Packet ID for pose telemetry packets."""
 
+PACKET_ID_POSE_BATCH: Final[int] = 0x03
+"""Packet ID for batched pose telemetry packets."""
+
+PACKET_ID_LOOP_TIMING: Final[int] = 0x04
+"""Packet ID for stabilizer loop timing packets."""
+
+PACKET_ID_TASK_LOAD: Final[int] = 0x05
+"""Packet ID for task load packets."""
+
+PACKET_ID_QUEUE_LOAD: Final[int] = 0x06
+"""Packet ID for queue load packets."""
+
+PACKET_ID_TIME_SYNC: Final[int] = 0x07
+"""Packet ID for the answers to time sync requests."""
+
+PACKET_ID_HOTSPOT: Final[int] = 0x08
+"""Packet ID for thermal hotspot events."""
+
+STRUCT_HEADER: Final[struct.Struct] = struct.Struct("<BBHQB")
+"""Struct format for unpacking the packet header (version, type, sequence, timestamp in us, rate divisor the drone
+rate control applies to the stream of the packet)."""
+
+SEQUENCE_MODULO: Final[int] = 1 << 16
+"""Modulo of the per-type packet sequence counter."""
+
+POSE_HISTORY_LENGTH: Final[int] = 256
+"""Number of past pose samples kept to look up the pose at a frame capture time."""
+
+POSE_INTERPOLATION_MAX_GAP_US: Final[int] = 100_000
+"""Largest gap (in microseconds) between two pose samples interpolated, the nearest sample is used beyond."""
+
 STRUCT_BATTERY: Final[struct.Struct] = struct.Struct("<f")
 """Struct format for unpacking battery telemetry packets."""
 
-STRUCT_POSE: Final[struct.Struct] = struct.Struct("<6f")
-"""Struct format for unpacking pose telemetry packets."""
+STRUCT_BATTERY_MODEL: Final[struct.Struct] = struct.Struct("<3f")
+"""Struct format for unpacking the battery model that follows the voltage (compensated voltage, charge in %, remaining flight time in s, negative until measured)."""
+
+STRUCT_POSE: Final[struct.Struct] = struct.Struct("<12f")
+"""Struct format for unpacking pose telemetry packets (position, velocity, acceleration, orientation)."""
+
+STRUCT_BATCH_COUNT: Final[struct.Struct] = struct.Struct("<B")
+"""Struct format for unpacking the number of records of a pose batch packet."""
+
+STRUCT_POSE_RECORD: Final[struct.Struct] = struct.Struct("<I12f")
+"""Struct format for unpacking one pose batch record (offset in us from the header timestamp, then a pose)."""
+
+LOOP_TIMING_STAGES: Final[Tuple[str, ...]] = ("estimator", "setpoint", "controller", "power", "loop", "jitter")
+"""Stabilizer loop timing histograms, in packet order: the stages, the whole iteration and the wake up jitter."""
+
+LOOP_TIMING_BIN_EDGES_US: Final[Tuple[int, ...]] = (25, 50, 100, 200, 300, 500, 1000)
+"""Upper edges (in microseconds) of the loop timing bins, the last bin counts the times of a whole loop period or more."""
+
+STRUCT_STAGE_TIMING: Final[struct.Struct] = struct.Struct("<9H")
+"""Struct format for unpacking one loop timing histogram (iterations per bin since the previous packet, longest time in us)."""
+
+STRUCT_TASK_LOAD: Final[struct.Struct] = struct.Struct("<BBBII")
+"""Struct format for unpacking the task load packet fields (first record index, record count, total tasks, free heap, lowest free heap in bytes)."""
+
+STRUCT_TASK_LOAD_RECORD: Final[struct.Struct] = struct.Struct("<16sHHB")
+"""Struct format for unpacking one task load record (name, CPU load in 0.01 % of one core, unused stack in bytes, priority)."""
+
+STRUCT_QUEUE_LOAD: Final[struct.Struct] = struct.Struct("<BBB")
+"""Struct format for unpacking the queue load packet fields (first record index, record count, total queues)."""
+
+STRUCT_QUEUE_LOAD_RECORD: Final[struct.Struct] = struct.Struct("<20s4H")
+"""Struct format for unpacking one queue load record (name, length, items sent, peak items waiting, items dropped as the queue was full, over the last second)."""
 
-DRONE_UDP_BUFFER_SIZE: Final[int] = 128
+STRUCT_HOTSPOT: Final[struct.Struct] = struct.Struct("<6fhB")
+"""Struct format for unpacking the hotspot packet fields (position, orientation, frame background in 0.25 degrees Celsius, hotspot count)."""
+
+STRUCT_HOTSPOT_RECORD: Final[struct.Struct] = struct.Struct("<BBBh")
+"""Struct format for unpacking one hotspot record (centroid column and row in 1/16 pixel, pixel count, peak in 0.25 degrees Celsius)."""
+
+DRONE_UDP_BUFFER_SIZE: Final[int] = 1500
 """Maximum UDP packet size for telemetry messages."""
 
 DRONE_UDP_TIMEOUT: Final[float] = 0.5
 """Timeout (in seconds) for UDP socket operations."""
 
+DRONE_UDP_RECV_BATCH: Final[int] = 64
+"""Maximum number of datagrams received per wake up of the telemetry listener."""
+
+DRONE_UDP_RCVBUF_SIZE: Final[int] = 1 << 20
+"""Kernel receive buffer size (in bytes) of the telemetry socket, so bursts are queued rather than dropped."""
+
 DRONE_UDP_HANDSHAKE_RETRIES: Final[int] = 1
 """Number of retry attempts during telemetry handshake."""
 
 HANDSHAKE_PACKET: Final[bytes] = b'\x01\x01'
 """Handshake packet sent to initiate telemetry communication."""
 
+HANDSHAKE_HEADER: Final[int] = 0x01
+"""Header byte of the handshake packet, used when building a handshake with a rate divisor."""
+
+TIME_SYNC_HEADER: Final[int] = 0x02
+"""Header byte of the time sync request packet."""
+
+STRUCT_TIME_SYNC_REQUEST: Final[struct.Struct] = struct.Struct("<BQ")
+"""Struct format for packing a time sync request (header, local send time in us), followed by the checksum byte."""
+
+STRUCT_TIME_SYNC: Final[struct.Struct] = struct.Struct("<QQ")
+"""Struct format for unpacking a time sync answer (echoed local send time, drone receive time in us), the header
+timestamp being the drone send time."""
+
+EXT_SAMPLE_HEADER: Final[int] = 0x03
+"""Header byte of the external position/pose packet, enqueued by the drone straight into its state estimator."""
+
+STRUCT_EXT_POSITION: Final[struct.Struct] = struct.Struct("<BIfff")
+"""Struct format for packing an external position (header, sample time on the drone clock in us truncated to
+32 bits or 0 if unknown, x, y, z in m), followed by the checksum byte."""
+
+STRUCT_EXT_POSE: Final[struct.Struct] = struct.Struct("<BIfffI")
+"""Struct format for packing an external pose, an external position followed by the compressed quaternion."""
+
+TELEMETRY_RATE_DIVISOR: Final[int] = 1
+"""Pose telemetry rate divisor requested in the handshake (the drone sends 1 of every N pose packets)."""
+
 DRONE_UDP_HANDSHAKE_RETRY_DELAY: Final[float] = 0.5
-"""Delay (in seconds) between handshake retry attempts."""
\ No newline at end of file
+"""Delay (in seconds) between handshake retry attempts."""
+LOG_LOCAL_PORT: Final[int] = 2392
+"""Local UDP port used by the CRTP log client to receive log packets."""
+
+LOG_BLOCKS: Final[Tuple[Tuple[int, Tuple[str, ...]], ...]] = (
+    (20, ("stateEstimate.x", "stateEstimate.y", "stateEstimate.z",
+          "stateEstimate.roll", "stateEstimate.pitch", "stateEstimate.yaw")),
+    (20, ("stateEstimate.vx", "stateEstimate.vy", "stateEstimate.vz",
+          "stateEstimate.ax", "stateEstimate.ay", "stateEstimate.az")),
+    (1000, ("pm.vbat",)),
+)
+"""Log blocks subscribed by DroneLogTelemetry, as (period in ms, variables). A block holds up to 26 bytes of values."""
+
+LOG_TELEMETRY_FIELDS: Final[Dict[str, str]] = {
+    "stateEstimate.x": "x",
+    "stateEstimate.y": "y",
+    "stateEstimate.z": "z",
+    "stateEstimate.vx": "vx",
+    "stateEstimate.vy": "vy",
+    "stateEstimate.vz": "vz",
+    "stateEstimate.ax": "ax",
+    "stateEstimate.ay": "ay",
+    "stateEstimate.az": "az",
+    "stateEstimate.roll": "roll",
+    "stateEstimate.pitch": "pitch",
+    "stateEstimate.yaw": "yaw",
+    "pm.vbat": "voltage",
+}
+"""Telemetry field updated by each log variable."""
+
+LOG_REQUEST_TIMEOUT: Final[float] = 0.2
+"""Timeout (in seconds) waiting for the answer to a log TOC or control request."""
+
+LOG_REQUEST_RETRIES: Final[int] = 5
+"""Number of attempts of a log TOC or control request."""
+
+LOG_KEEPALIVE_PERIOD: Final[float] = 0.25
+"""Period (in seconds) of the keep-alive packets, the drone stops the log blocks after 1 s without packets."""
+
+LOG_TOC_CACHE_FOLDER: Final[str] = "toc_cache"
+"""Path to the folder where the downloaded log TOCs are kept, one file per TOC CRC, empty to always download it."""
+
+TELEMETRY_SIMULATOR_ALTITUDE: Final[float] = 1.0
+"""Constant altitude (in meters) reported by the telemetry simulator."""
+
+TELEMETRY_SIMULATOR_FLIGHT_TIME: Final[float] = 420.0
+"""Flight time (in seconds) of a full battery in the telemetry simulator, the charge draining linearly while started."""
+
+TELEMETRY_SIMULATOR_VOLTAGE: Final[Tuple[float, float]] = (4.2, 3.0)
+"""Battery voltage (in volts) of the telemetry simulator when full and when empty."""
@@ -0,0 +1,22 @@
+import struct
+from typing import Final
+
+RECORDER_ENABLED: Final[bool] = False
+"""If True, the drone records the frames and telemetry of each exploration routine."""
+
+RECORDER_OUTPUT_FOLDER: Final[str] = "recordings"
+"""Path to the folder where a recording folder is created for each exploration routine."""
+
+RECORDER_SEGMENT_SIZE: Final[int] = 256 * 1024 * 1024
+"""Maximum size (in bytes) of a segment data file, a new segment is started then."""
+
+RECORDER_JPEG_QUALITY: Final[int] = 90
+"""JPEG quality (0 to 100) of the recorded frames."""
+
+RECORDER_MAX_QUEUE_SIZE: Final[int] = 100
+"""Maximum number of frames waiting to be written by the recorder."""
+
+RECORDER_STRUCT_INDEX: Final[struct.Struct] = struct.Struct("<QIqqi14f")
+"""Index record of a recorded frame: data offset and size (in bytes) of the JPEG in the segment data file,
+host capture time and telemetry drone time (in microseconds), camera sequence number, position,
+velocity, acceleration and orientation (12 values), battery voltage and camera color ratio."""
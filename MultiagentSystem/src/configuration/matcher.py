@@ -1,4 +1,4 @@
 from typing import Final
 
-MATCHER_SLEEP_TIME: Final[float] = 0.01
-"""Sleep duration (in seconds) between matcher processing cycles."""
\ No newline at end of file
+MATCHER_FRAME_TIMEOUT: Final[float] = 0.1
+"""Longest wait (in seconds) for a new camera frame, so that the matcher notices when it is stopped."""
\ No newline at end of file
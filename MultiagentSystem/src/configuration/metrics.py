@@ -0,0 +1,16 @@
+from typing import Final
+
+METRICS_ENABLED: Final[bool] = True
+"""If True, the pipeline metrics are logged periodically and served over HTTP (see utils.metrics)."""
+
+METRICS_LOG_PERIOD: Final[float] = 10.0
+"""Period (in seconds) of the pipeline metrics log line."""
+
+METRICS_HTTP_PORT: Final[int] = 9108
+"""Port of the Prometheus text format endpoint (/metrics), 0 to disable it."""
+
+METRICS_PREFIX: Final[str] = "ground_station"
+"""Prefix of the exported metric names."""
+
+METRICS_LATENCY_BUCKETS: Final[tuple] = (0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0)
+"""Upper bounds (in seconds) of the latency histogram buckets, an overflow bucket is added above the last one."""
@@ -7,4 +7,48 @@ BASE_POSITIONS_PATH: Final[str] = "input/operation1.json"
 """Path to the JSON file containing base positions for missions."""
 
 METRICS_OUTPUT_FOLDER: Final[str] = "results"
-"""Path to the folder where operation metrics will be saved."""
\ No newline at end of file
+"""Path to the folder where the operation event logs (.jsonl) and the metrics derived from them (.json) are saved."""
+
+OPERATION_NOTIFIER_MAX_QUEUE_SIZE: Final[int] = 100
+"""Maximum number of point events waiting for delivery to the subscribers."""
+
+OPERATION_AUTO_ADVANCE: Final[bool] = True
+"""If True, the next exploration mission starts automatically once the current one is stopped,
+while the inspection of the previous missions goes on. Otherwise it waits for next_mission."""
+
+OPERATION_MAX_MISSIONS_AHEAD: Final[int] = 1
+"""Maximum number of missions the automatic exploration may run ahead of the finished inspections."""
+
+OPERATION_MIN_BATTERY_CHARGE: Final[float] = 30.0
+"""Minimum explorer battery charge (in percent) to start the next mission automatically."""
+
+OPERATION_MIN_FLIGHT_TIME: Final[float] = 120.0
+"""Minimum explorer flight time left (in seconds) to start the next mission automatically, when measured."""
+
+OPERATION_SCHEDULER_PERIOD: Final[float] = 0.5
+"""Period (in seconds) at which the automatic mission advance is checked."""
+
+EXPLORATION_TARGET_COVERAGE: Final[float] = 0.9
+"""Fraction of the mission area whose ground the explorer camera has seen at which the exploration of the mission
+stops by itself, 0 to only stop it with stop_inspection."""
+
+EXPLORATION_AREA_RADIUS: Final[float] = 5.0
+"""Radius (in meters) of the mission area around its base station, whose coverage is tracked."""
+
+EXPLORATION_COVERAGE_CELL_SIZE: Final[float] = 0.1
+"""Cell side (in meters) of the coverage grid of the mission area."""
+
+INSPECTION_POLL_TIME: Final[float] = 0.1
+"""Longest wait (in seconds) of the idle inspector for new points before checking whether the exploration of its mission finished."""
+
+OPERATION_VISUALIZER_INTERVAL: Final[int] = 100
+"""Period (in milliseconds) of the operation visualizer updates."""
+
+OPERATION_VISUALIZER_MAX_LISTED_POINTS: Final[int] = 8
+"""Number of latest points listed per mission in the operation visualizer, the others are only counted."""
+
+OPERATION_BEEP_FREQUENCY: Final[int] = 1000
+"""Frequency (in hertz) of the beep signaling a point event."""
+
+OPERATION_BEEP_DURATION: Final[int] = 200
+"""Duration (in milliseconds) of the beep signaling a point event."""
\ No newline at end of file
@@ -0,0 +1,28 @@
+from typing import Final
+
+PLANNER_NEIGHBORS: Final[int] = 8
+"""Number of nearest neighbors of each point considered by the local search moves."""
+
+PLANNER_OR_OPT_MAX_SEGMENT: Final[int] = 3
+"""Longest run of consecutive points (Or-opt segment) moved to another place of the path."""
+
+PLANNER_TIME_BUDGET: Final[float] = 0.5
+"""Longest time (in seconds) spent improving a path, the best path found so far is returned then."""
+
+PLANNER_OBSTACLE_MARGIN: Final[float] = 0.3
+"""Clearance (in meters) kept by the planned paths around the obstacles."""
+
+PLANNER_DISTANCE_CACHE_SIZE: Final[int] = 100_000
+"""Maximum number of cached pairwise distances around the obstacles."""
+
+PLANNER_FIELD_CACHE_SIZE: Final[int] = 1024
+"""Maximum number of points whose shortest distances to the obstacle corners are cached."""
+
+PLANNER_ILP_TIME_LIMIT: Final[float] = 10.0
+"""Longest time (in seconds) given to the ILP solver, the best path found so far is returned then."""
+
+PLANNER_PARTITION_ITERATIONS: Final[int] = 10
+"""Number of k-means iterations assigning the points to the inspectors."""
+
+PLANNER_BALANCE_MOVES: Final[int] = 100
+"""Maximum number of points moved from the longest inspector route to another one to balance the routes."""
@@ -3,6 +3,9 @@ from typing import Final
 ROBOT_DOG_SPEED: Final[float] = 0.5
 """Default walking speed (in meters per second) of the robot dog."""
 
+ROBOT_DOG_COUNT: Final[int] = 1
+"""Number of robot dogs sharing the inspection of the detected points."""
+
 ROBOT_DOG_REACHED_TOLERANCE: Final[float] = 0.05
 """Distance threshold (in meters) to consider a target point reached."""
 
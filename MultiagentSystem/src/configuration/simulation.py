@@ -0,0 +1,10 @@
+from typing import Final
+
+SIMULATION_SPEED: Final[float] = 1.0
+"""Number of simulated seconds per real second of the simulators and controllers (1 for real time)."""
+
+SIMULATION_DISCRETE_EVENT: Final[bool] = False
+"""Whether the simulated time jumps from one wake-up to the next instead of flowing (SIMULATION_SPEED is then ignored)."""
+
+SIMULATION_SETTLE_TIME: Final[float] = 0.002
+"""Real time (in seconds) without any thread sleeping or waking up after which the discrete-event clock jumps to the next wake-up."""
@@ -3,9 +3,16 @@ from typing import Final
 VIEWER_MAX_QUEUE_SIZE: Final[int] = 100
 """Maximum number of frames stored in the viewer queue."""
 
+VIEWER_MAILBOX_SIZE: Final[int] = 1
+"""If above 0, the viewer receives its frames through a latest-value mailbox of that many frames
+(see utils.frame_mailbox) instead of a VIEWER_MAX_QUEUE_SIZE queue, so it lags at most that many frames."""
+
 VIEWER_OVERLAY_ALPHA: Final[float] = 0.45
 """Alpha transparency used for overlay rendering."""
 
+VIEWER_MAX_FPS: Final[float] = 30.0
+"""Highest display rate (in frames per second); frames arriving faster are skipped. 0 for no limit."""
+
 VIEWER_BAR_HEIGHT: Final[int] = 75
 """Height (in pixels) of the telemetry overlay bar."""
 
@@ -1,15 +1,37 @@
-from typing import Optional
+from typing import Dict, List, Optional, Tuple
 from configuration import camera_capture as config
 import cv2
 import threading
 import logging
-import requests
+import struct
 from time import sleep
-from copy import deepcopy
 from numpy import ndarray
 
+from drone.camera_control import CameraControl
+from drone.mjpeg_stream import MjpegStream
 from interfaces.interfaces import ICamera
-from structures.structures import Frame
+from structures.structures import ClockEstimate, Frame, Pose, Position, Orientation
+from utils.clock_offset import ClockOffset, local_time_us
+from utils import metrics
+
+_STATUS = struct.Struct(config.CAMERA_STATUS_FORMAT)
+
+def parse_camera_status(data: bytes) -> Optional[Dict[str, int]]:
+    """
+    Parses a camera binary status record (the /status.bin payload).
+
+    Args:
+        data (bytes): Raw status record.
+
+    Returns:
+        Optional[Dict[str, int]]: Status values by field name, or None if the record is invalid.
+    """
+    if len(data) != _STATUS.size:
+        return None
+    status = dict(zip(config.CAMERA_STATUS_FIELDS, _STATUS.unpack(data)))
+    if status.pop("magic") != b"ST" or status["version"] != config.CAMERA_STATUS_VERSION:
+        return None
+    return status
 
 class CameraCapture(ICamera):
     """
@@ -17,7 +39,14 @@ class CameraCapture(ICamera):
 
     This class connects to the camera via a HTTP-based stream, retrieves video frames continuously
     in a background thread, and maintains the most recent frame in a thread-safe manner. Additionally,
-    it supports controlling the integrated camera flash through HTTP requests.
+    it supports controlling the integrated camera flash and settings through a CameraControl.
+
+    When stream metadata is enabled, the multipart stream is parsed directly instead of
+    through OpenCV, so the frame sequence number and the drone pose embedded by the
+    camera in each part header are attached to the frame. The stream is then read on a
+    socket of its own (see MjpegStream), without OpenCV's buffering: when several frames
+    arrive at once only the newest is published, and a dropped stream is reconnected
+    within a second.
     """
 
     def __init__(self, stream_url: str, flash_url: str) -> None:
@@ -30,12 +59,20 @@ class CameraCapture(ICamera):
         """
         self._stream_url: str = stream_url
         self._flash_url: str = flash_url 
+        self._control: CameraControl = CameraControl(flash_url)
 
         self._frame: Optional[Frame] = None
+        self._frame_id: int = -1
+        self._clock: ClockOffset = ClockOffset()
+        self._last_seq: int = -1
+        self._dropped_frames: int = 0
+        self._send_latency_us: int = -1
 
         self._cap: Optional[cv2.VideoCapture] = None
+        self._stream: MjpegStream = MjpegStream(stream_url)
 
         self._lock: threading.Lock = threading.Lock()
+        self._frame_ready: threading.Condition = threading.Condition(self._lock)
         self._running: bool = False
         self._thread: Optional[threading.Thread] = None
 
@@ -58,6 +95,7 @@ class CameraCapture(ICamera):
         self._running = True
         self._thread = threading.Thread(target=self._capture, daemon=True)
         self._thread.start()
+        self._control.start_clock_sync(self._clock)
         self._logger.info("Started.")
 
     def stop(self) -> None:
@@ -73,6 +111,8 @@ class CameraCapture(ICamera):
             return
 
         self._running = False
+        self._stream.close()
+        self._control.close()
         if self._thread:
             self._thread.join(timeout=1.0)
             if self._thread.is_alive():
@@ -89,65 +129,226 @@ class CameraCapture(ICamera):
 
         self._logger.info("Stopped.")
 
-    def get_frame(self) -> Optional[Frame]:
+    def pause(self) -> None:
+        """
+        Pauses the capture between routines. The stream connection and the clock synchronization are kept,
+        so frames keep arriving, unused, and resume is immediate.
         """
-        Returns a deep copy of the latest captured frame.
+        if not self._running:
+            self._logger.warning("Not running.")
+            return
+        self._logger.info("Paused.")
 
-        The returned frame is safe for concurrent access from multiple threads.
+    def resume(self) -> None:
+        """
+        Resumes the capture after pause, or starts it if it is stopped.
+        """
+        if not self._running:
+            self.start()
+            return
+        self._logger.info("Resumed.")
+
+    def get_frame(self, last_frame_id: int = -1) -> Optional[Frame]:
+        """
+        Returns the latest captured frame, without copying it.
+
+        The frame and its read-only data array or JPEG are shared by all callers.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
 
         Returns:
-            Optional[Frame]: The latest captured frame, or None if unavailable.
+            Optional[Frame]: The latest captured frame, or None if unavailable or not newer
+            than last_frame_id.
         """
         with self._lock:
-            return deepcopy(self._frame)
+            frame = self._frame
+        if frame is None or frame.frame_id == last_frame_id:
+            return None
+        return frame
+
+    def wait_frame(self, last_frame_id: int = -1, timeout: Optional[float] = None) -> Optional[Frame]:
+        """
+        Waits until a frame newer than the one with last_frame_id is captured.
+
+        The capture thread wakes the waiting threads as soon as it stores a frame.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
+            timeout (Optional[float]): Longest wait (in seconds), None to wait without limit.
+
+        Returns:
+            Optional[Frame]: The new frame, or None on timeout.
+        """
+        with self._frame_ready:
+            self._frame_ready.wait_for(
+                lambda: self._frame is not None and self._frame.frame_id != last_frame_id, timeout)
+            frame = self._frame
+        if frame is None or frame.frame_id == last_frame_id:
+            return None
+        return frame
 
     def turn_on_flash(self) -> None:
         """
         Activates the camera's integrated flash.
 
-        Sends an HTTP GET request to the camera's flash control with a predefined intensity value.
+        Sends the predefined intensity value through the camera control channel.
         """
-        try:
-            requests.get(
-                self._flash_url,
-                params={"var": "led_intensity", "val": config.CAMERA_FLASH_INTENSITY_ON},
-                timeout=config.CAMERA_REQUEST_TIMEOUT
-            )
+        if self._control.set("led_intensity", config.CAMERA_FLASH_INTENSITY_ON):
             self._logger.debug("Flash turned on.")
-        except Exception:
+        else:
             self._logger.warning("Failed to turn on flash.")
 
     def turn_off_flash(self) -> None:
         """
         Deactivates the camera's integrated flash.
 
-        Sends an HTTP GET request to the camera's flash control endpoint with the intensity set to zero.
+        Sends a zero intensity through the camera control channel.
         """
-        try:
-            requests.get(
-                self._flash_url,
-                params={"var": "led_intensity", "val": config.CAMERA_FLASH_INTENSITY_OFF},
-                timeout=config.CAMERA_REQUEST_TIMEOUT
-            )
+        if self._control.set("led_intensity", config.CAMERA_FLASH_INTENSITY_OFF):
             self._logger.debug("Flash turned off.")
-        except Exception:
+        else:
             self._logger.warning("Failed to turn off flash.")
 
+    def get_status(self) -> Optional[Dict[str, int]]:
+        """
+        Fetches the camera sensor settings from the binary status endpoint.
+
+        Returns:
+            Optional[Dict[str, int]]: Status values by field name, or None on failure.
+        """
+        try:
+            return parse_camera_status(self._control.request(config.CAMERA_STATUS_URL).content)
+        except Exception:
+            self._logger.warning("Failed to get camera status.")
+            return None
+
+    def set_color_prefilter(self, limits: Dict[str, List[int]], min_ratio: float, mode: int) -> None:
+        """
+        Configures the camera color prefilter through the camera control channel.
+
+        Args:
+            limits (Dict[str, List[int]]): HSV ranges, in the COLOR_DETECTION_COLORS format.
+                Only the hue bounds and the lower saturation and value bounds are used.
+            min_ratio (float): Minimum share of matching pixels for a frame to pass.
+            mode (int): Prefilter mode (0 off, 1 flag frames, 2 skip frames).
+        """
+        lower2 = limits.get("lower2", [1, 0, 0])
+        upper2 = limits.get("upper2", [0, 0, 0])
+        params = {
+            "pf_h1_min": limits["lower1"][0], "pf_h1_max": limits["upper1"][0],
+            "pf_h2_min": lower2[0], "pf_h2_max": upper2[0],
+            "pf_s_min": limits["lower1"][1], "pf_v_min": limits["lower1"][2],
+            "pf_ratio": round(min_ratio * 1000),
+            "pf_mode": mode,
+        }
+        if all(self._control.set(var, val) for var, val in params.items()):
+            self._logger.info("Color prefilter configured: %s", params)
+        else:
+            self._logger.warning("Failed to configure color prefilter.")
+
+    def set_roi(self, x: int, y: int, width: int, height: int,
+                every: int = config.CAMERA_ROI_EVERY) -> None:
+        """
+        Asks the camera to interleave high resolution crops of a region with the full view.
+
+        Crop frames carry the region in Frame.roi.
+
+        Args:
+            x (int): Left edge of the region, in pixels of the full view frame.
+            y (int): Top edge of the region, in pixels of the full view frame.
+            width (int): Region width, in pixels of the full view frame.
+            height (int): Region height, in pixels of the full view frame.
+            every (int): Number of full view frames between two crops.
+        """
+        try:
+            self._control.request(config.CAMERA_ROI_URL,
+                                  {"x": x, "y": y, "w": width, "h": height, "every": every})
+            self._logger.info("ROI set to %d,%d %dx%d", x, y, width, height)
+        except Exception:
+            self._logger.warning("Failed to set ROI.")
+
+    def clear_roi(self) -> None:
+        """
+        Stops the camera from sending region of interest crops.
+        """
+        try:
+            self._control.request(config.CAMERA_ROI_URL, {"w": 0, "h": 0})
+            self._logger.info("ROI cleared")
+        except Exception:
+            self._logger.warning("Failed to clear ROI.")
+
+    def get_dropped_frames(self) -> int:
+        """
+        Returns the number of frames skipped by the camera stream, detected from
+        gaps in the frame sequence numbers.
+
+        Returns:
+            int: Number of dropped frames since the capture started.
+        """
+        return self._dropped_frames
+
+    def get_send_latency_us(self) -> int:
+        """
+        Returns the last reported camera-side send latency, from frame grab to the
+        end of the frame transmission.
+
+        Returns:
+            int: Latency in microseconds, or -1 if not reported yet.
+        """
+        return self._send_latency_us
+
+    def get_clock_estimate(self) -> Optional[ClockEstimate]:
+        """
+        Returns the mapping of the camera clock, the clock of the frame capture timestamps,
+        onto the ground station monotonic clock.
+
+        Returns:
+            Optional[ClockEstimate]: Offset, drift and error bound, None until a frame or a time exchange.
+        """
+        return self._clock.get_estimate()
+
     # ----------------------------------------------------------------------
     # Private methods
     # ----------------------------------------------------------------------
-    def _update_frame(self, data: ndarray) -> None:
+    def _update_frame(self, data: Optional[ndarray], seq: int = -1, capture_timestamp_us: int = 0,
+                      pose: Optional[Pose] = None, pose_timestamp_us: int = 0,
+                      color_ratio: float = -1.0,
+                      roi: Optional[Tuple[int, int, int, int]] = None,
+                      tilted: bool = False, host_capture_us: int = 0, jpeg: Optional[bytes] = None,
+                      receive_us: int = 0) -> None:
         """
         Updates the latest captured frame in a thread-safe manner.
 
-        Encapsulates the raw frame array into a Frame object and stores it as the
-        most recent frame.
+        Encapsulates the frame array or JPEG and its metadata into a Frame object and
+        stores it as the most recent frame.
 
         Args:
-            data (ndarray): Raw frame data captured from the camera stream.
+            data (Optional[ndarray]): Decoded frame data, None if the frame is kept as JPEG.
+            seq (int): Frame sequence number assigned by the camera (-1 if unknown).
+            capture_timestamp_us (int): Camera sensor capture time (in microseconds).
+            pose (Optional[Pose]): Drone pose embedded by the camera, if any.
+            pose_timestamp_us (int): Drone time the embedded pose was sampled (in microseconds).
+            color_ratio (float): Color ratio measured by the camera prefilter (-1 if not measured).
+            roi (Optional[Tuple[int, int, int, int]]): Cropped region if the frame is a crop.
+            tilted (bool): Whether the camera flagged the frame as taken while tilted.
+            host_capture_us (int): Capture time on the ground station clock (in microseconds), now if 0.
+            jpeg (Optional[bytes]): JPEG encoded frame, decoded by its consumers on demand.
+            receive_us (int): Time the frame was fully received on the ground station clock (in microseconds), now if 0.
         """
+        if not receive_us:
+            receive_us = local_time_us()
+        if not host_capture_us:
+            host_capture_us = receive_us
+        if data is not None:
+            data.flags.writeable = False
         with self._lock:
-            self._frame = Frame(data=data)
+            self._frame_id += 1
+            self._frame = Frame(data=data, seq=seq, capture_timestamp_us=capture_timestamp_us, pose=pose, pose_timestamp_us=pose_timestamp_us,
+                                color_ratio=color_ratio, roi=roi, tilted=tilted, frame_id=self._frame_id,
+                                host_capture_us=host_capture_us, jpeg=jpeg, receive_us=receive_us)
+            self._frame_ready.notify_all()
+        metrics.inc("frames_total", "captured")
         self._logger.debug("Updated frame.")
 
     def _open_stream(self) -> bool:
@@ -175,14 +376,125 @@ class CameraCapture(ICamera):
             cap.release()
             return False
 
+    def _track_seq(self, seq: int) -> None:
+        """
+        Counts the frames the camera skipped before a frame, from the gap in the sequence numbers.
+
+        Args:
+            seq (int): Frame sequence number (-1 if unknown).
+        """
+        if self._last_seq >= 0 and seq > self._last_seq + 1:
+            self._dropped_frames += seq - self._last_seq - 1
+            metrics.inc("frames_dropped_total", "camera", seq - self._last_seq - 1)
+            self._logger.debug("Dropped %d frames", seq - self._last_seq - 1)
+        self._last_seq = seq
+
+    def _handle_part(self, headers: Dict[str, str], jpeg: bytes) -> None:
+        """
+        Stores a stream part with its metadata as the latest frame.
+
+        The JPEG is kept undecoded: the consumers decode it on demand (see Frame.image),
+        so frames nobody looks at are never decoded.
+
+        Args:
+            headers (Dict[str, str]): Part headers.
+            jpeg (bytes): JPEG encoded frame.
+        """
+        receive_us = local_time_us()
+
+        seq = int(headers.get("x-frame-seq", -1))
+        self._track_seq(seq)
+
+        capture_timestamp_us = 0
+        if "x-timestamp" in headers:
+            sec, _, usec = headers["x-timestamp"].partition(".")
+            capture_timestamp_us = int(sec) * 1_000_000 + int(usec or 0)
+            self._clock.update(capture_timestamp_us, receive_us)
+
+        if "x-prev-send-latency" in headers:
+            self._send_latency_us = int(headers["x-prev-send-latency"])
+            self._logger.debug("Frame %s send latency: %d us",
+                               headers.get("x-prev-frame-seq", "?"), self._send_latency_us)
+
+        pose = None
+        pose_timestamp_us = 0
+        if "x-pose" in headers:
+            try:
+                x, y, z, roll, pitch, yaw = (float(v) for v in headers["x-pose"].split(","))
+                pose = Pose(position=Position(x, y, z), orientation=Orientation(roll, pitch, yaw))
+                pose_timestamp_us = int(headers.get("x-pose-timestamp", 0))
+            except ValueError:
+                self._logger.warning("Malformed pose header: %s", headers["x-pose"])
+
+        color_ratio = int(headers.get("x-color-ratio", -1000)) / 1000
+
+        roi = None
+        if "x-roi" in headers:
+            try:
+                x, y, w, h = (int(v) for v in headers["x-roi"].split(","))
+                roi = (x, y, w, h)
+            except ValueError:
+                self._logger.warning("Malformed ROI header: %s", headers["x-roi"])
+
+        tilted = headers.get("x-tilted") == "1"
+
+        self._logger.debug("Frame %d captured of %d bytes", seq, len(jpeg))
+        host_capture_us = self._clock.to_local(capture_timestamp_us) if capture_timestamp_us else receive_us
+        self._update_frame(None, seq, capture_timestamp_us, pose, pose_timestamp_us, color_ratio, roi, tilted, host_capture_us, jpeg,
+                           receive_us)
+
+    def _read_stream(self) -> bool:
+        """
+        Reads the multipart stream directly, until it ends, fails, or the capture is stopped.
+
+        Of the parts completed by each socket read, only the newest is handed to
+        _handle_part; the older ones are superseded before anyone could read them.
+
+        Returns:
+            bool: True if at least one frame was received.
+        """
+        received = False
+        try:
+            self._stream.open()
+            self._logger.info("Stream URL opened successfully.")
+            while self._running:
+                parts = self._stream.read_parts()
+                if parts is None:
+                    self._logger.warning("Stream ended.")
+                    break
+                if not parts:
+                    continue
+                for headers, _ in parts[:-1]:
+                    self._track_seq(int(headers.get("x-frame-seq", -1)))
+                self._handle_part(*parts[-1])
+                received = True
+        except (OSError, ValueError) as e:
+            if self._running:
+                self._logger.warning("Stream read failed: %s", e)
+        finally:
+            self._stream.close()
+        return received
+
     def _capture(self) -> None:
         """
         Background thread that continuously captures and stores frames.
 
         Repeatedly reads frames from the video stream. On failure to read or open
-        the stream, retries after a configurable delay. Successfully captured frames
-        are decoded, wrapped in a Frame object, and stored as the latest frame.
+        the stream, retries after a configurable delay (a short exponential backoff
+        when parsing the stream directly). Successfully captured frames
+        are wrapped in a Frame object, as JPEG when parsing the stream directly, and stored
+        as the latest frame.
         """
+        if config.CAMERA_STREAM_METADATA:
+            delay = config.CAMERA_STREAM_RETRY_MIN_DELAY
+            while self._running:
+                if self._read_stream():
+                    delay = config.CAMERA_STREAM_RETRY_MIN_DELAY
+                if self._running:
+                    sleep(delay)
+                    delay = min(2 * delay, config.CAMERA_STREAM_RETRY_MAX_DELAY)
+            return
+
         while self._running:
             if not self._cap or not self._cap.isOpened():
                 if not self._open_stream():
@@ -0,0 +1,238 @@
+from typing import Any, Dict, Optional, Tuple
+from configuration import camera_capture as config
+from configuration import clock_offset as clock_config
+import socket
+import struct
+import threading
+import logging
+import requests
+from time import monotonic
+from urllib.parse import urlsplit
+
+from utils.clock_offset import ClockOffset, local_time_us
+
+class CameraControl:
+    """
+    Changes camera settings through the camera binary control channel.
+
+    Each setting is sent as a small datagram on a UDP socket kept open for the whole session,
+    and acknowledged by the camera, so turning the flash on or changing a sensor setting takes
+    a round trip of a few milliseconds and never opens a connection while the frame stream runs.
+    A command whose acknowledgement is lost is sent again with the same id, which the camera
+    applies again harmlessly.
+
+    Settings the channel does not know, and commands the camera never acknowledges (e.g. an
+    older firmware), go to the HTTP control endpoint instead, through a pooled session whose
+    connection is reused from one request to the next. The other HTTP camera endpoints
+    (status, region of interest) are requested through the same session.
+
+    The channel also answers time exchanges, from which a background thread keeps the
+    offset and drift of the camera clock, the clock of the frame capture timestamps, up to date.
+    """
+
+    _COMMAND = struct.Struct("<3sBBxHi")
+    _ACK = struct.Struct("<3sBBBH")
+    _SYNC = struct.Struct("<3sBQ")
+    _SYNC_ACK = struct.Struct("<3sBQqq")
+    _STATUS_OK = 0
+
+    def __init__(self, control_url: str) -> None:
+        """
+        Creates a CameraControl instance.
+
+        Args:
+            control_url (str): HTTP URL of the camera control endpoint, its host also serves the control channel.
+        """
+        self._control_url: str = control_url
+        self._address = (urlsplit(control_url).hostname, config.CAMERA_CONTROL_PORT)
+        self._var_ids: Dict[str, int] = {var: i for i, var in enumerate(config.CAMERA_CONTROL_VARS)}
+
+        self._sock: Optional[socket.socket] = None
+        self._next_id: int = 0
+        self._lock: threading.Lock = threading.Lock()
+        self._session: requests.Session = requests.Session()
+
+        self._sync_stop: threading.Event = threading.Event()
+        self._sync_thread: Optional[threading.Thread] = None
+
+        self._logger: logging.Logger = logging.getLogger("CameraControl")
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def set(self, var: str, val: int) -> bool:
+        """
+        Changes a camera setting, as the var/val pair of the HTTP control endpoint.
+
+        Args:
+            var (str): Setting name.
+            val (int): Setting value.
+
+        Returns:
+            bool: True if the camera applied the setting.
+        """
+        var_id = self._var_ids.get(var)
+        if var_id is not None:
+            status = self._send_command(var_id, int(val))
+            if status is not None:
+                if status != self._STATUS_OK:
+                    self._logger.warning("Camera refused %s = %d.", var, val)
+                return status == self._STATUS_OK
+            self._logger.debug("No acknowledgement for %s, using HTTP.", var)
+
+        try:
+            self.request(self._control_url, {"var": var, "val": val})
+            return True
+        except Exception:
+            return False
+
+    def request(self, url: str, params: Optional[Dict[str, Any]] = None) -> requests.Response:
+        """
+        Sends a GET request to a camera HTTP endpoint through the pooled session.
+
+        Args:
+            url (str): Endpoint URL.
+            params (Optional[Dict[str, Any]]): Query parameters.
+
+        Returns:
+            requests.Response: Successful response.
+
+        Raises:
+            requests.RequestException: If the request failed or the camera returned an error.
+        """
+        response = self._session.get(url, params=params, timeout=config.CAMERA_REQUEST_TIMEOUT)
+        response.raise_for_status()
+        return response
+
+    def start_clock_sync(self, clock: ClockOffset) -> None:
+        """
+        Starts a background thread feeding time exchanges with the camera to a clock offset, every CLOCK_SYNC_PERIOD.
+
+        Args:
+            clock (ClockOffset): Offset of the camera clock, also fed with the frame timestamps.
+        """
+        if self._sync_thread:
+            return
+        self._sync_stop.clear()
+        self._sync_thread = threading.Thread(target=self._sync_clock, args=(clock,), daemon=True)
+        self._sync_thread.start()
+
+    def close(self) -> None:
+        """
+        Stops the clock sync, closes the control channel socket and the HTTP session.
+        """
+        if self._sync_thread:
+            self._sync_stop.set()
+            self._sync_thread.join(timeout=1.0)
+            self._sync_thread = None
+        with self._lock:
+            if self._sock:
+                self._sock.close()
+                self._sock = None
+        self._session.close()
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _send_command(self, var_id: int, val: int) -> Optional[int]:
+        """
+        Sends a command on the control channel and waits for its acknowledgement.
+
+        Args:
+            var_id (int): Index of the setting in CAMERA_CONTROL_VARS.
+            val (int): Setting value.
+
+        Returns:
+            Optional[int]: Status acknowledged by the camera, None if it never answered.
+        """
+        with self._lock:
+            try:
+                if self._sock is None:
+                    self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+                    self._sock.connect(self._address)
+                command_id = self._next_id
+                self._next_id = (self._next_id + 1) & 0xFFFF
+                command = self._COMMAND.pack(b"CTL", config.CAMERA_CONTROL_VERSION, var_id, command_id, val)
+                for _ in range(config.CAMERA_CONTROL_RETRIES):
+                    self._sock.send(command)
+                    status = self._wait_ack(command_id)
+                    if status is not None:
+                        return status
+            except OSError as e:
+                self._logger.debug("Control channel failed: %s", e)
+                if self._sock:
+                    self._sock.close()
+                    self._sock = None
+            return None
+
+    def _sync_clock(self, clock: ClockOffset) -> None:
+        """
+        Background thread exchanging times with the camera until the control is closed.
+
+        Args:
+            clock (ClockOffset): Offset of the camera clock.
+        """
+        while not self._sync_stop.wait(clock_config.CLOCK_SYNC_PERIOD):
+            exchange = self._exchange_time()
+            if exchange:
+                clock.update_exchange(*exchange)
+
+    def _exchange_time(self) -> Optional[Tuple[int, int, int, int]]:
+        """
+        Sends a time sync request on the control channel and waits for its answer.
+
+        Returns:
+            Optional[Tuple[int, int, int, int]]: Local send, camera receive, camera send and local receive
+            times (in microseconds), None if the camera did not answer.
+        """
+        with self._lock:
+            try:
+                if self._sock is None:
+                    self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+                    self._sock.connect(self._address)
+                send_us = local_time_us()
+                self._sock.send(self._SYNC.pack(b"SYN", config.CAMERA_CONTROL_VERSION, send_us))
+                deadline = monotonic() + config.CAMERA_CONTROL_TIMEOUT
+                while (remaining := deadline - monotonic()) > 0:
+                    self._sock.settimeout(remaining)
+                    data = self._sock.recv(self._SYNC_ACK.size)
+                    receive_us = local_time_us()
+                    if len(data) != self._SYNC_ACK.size:
+                        continue
+                    magic, version, echoed_us, camera_receive_us, camera_send_us = self._SYNC_ACK.unpack(data)
+                    if magic == b"SYA" and version == config.CAMERA_CONTROL_VERSION and echoed_us == send_us:
+                        return send_us, camera_receive_us, camera_send_us, receive_us
+            except socket.timeout:
+                pass
+            except OSError as e:
+                self._logger.debug("Time sync failed: %s", e)
+                if self._sock:
+                    self._sock.close()
+                    self._sock = None
+            return None
+
+    def _wait_ack(self, command_id: int) -> Optional[int]:
+        """
+        Receives acknowledgements until the one of the command, skipping late ones of earlier commands.
+
+        Args:
+            command_id (int): Id of the command.
+
+        Returns:
+            Optional[int]: Acknowledged status, None on timeout.
+        """
+        deadline = monotonic() + config.CAMERA_CONTROL_TIMEOUT
+        while True:
+            remaining = deadline - monotonic()
+            if remaining <= 0:
+                return None
+            self._sock.settimeout(remaining)
+            try:
+                data = self._sock.recv(self._ACK.size)
+            except socket.timeout:
+                return None
+            if len(data) != self._ACK.size:
+                continue
+            magic, version, _, status, ack_id = self._ACK.unpack(data)
+            if magic == b"CTA" and version == config.CAMERA_CONTROL_VERSION and ack_id == command_id:
+                return status
@@ -1,14 +1,12 @@
 import logging
 import numpy as np
 import cv2
-import time
-from typing import Optional
-from time import time
-from copy import deepcopy
+from typing import List, Optional, Tuple
 
 from configuration import camera_simulator as config
 from interfaces.interfaces import ICamera
-from structures.structures import Frame
+from structures.structures import Frame, SimulatedObject
+from utils import sim_clock
 
 
 class CameraSimulator(ICamera):
@@ -18,18 +16,35 @@ class CameraSimulator(ICamera):
     This class provides on-demand generation of frames containing a colored stop sign over a black background.  
     The color can be forced to a target color with a specific probability 
     to facilitate evaluation of color-based detection algorithms.
+
+    With a frame bank, the frames are rendered once at creation, from a seeded random generator,
+    and served in a loop: frame id i shows the bank frame i modulo the bank size. Serving a frame
+    costs no drawing, so the frame period can go down to a few milliseconds to load the frame
+    consumers, and the object of every frame is known (see get_ground_truth).
     """
 
-    def __init__(self) -> None:
+    def __init__(self, frame_period: Optional[float] = None, bank_size: Optional[int] = None) -> None:
         """
         Creates a CameraSimulator instance.
+
+        Args:
+            frame_period (Optional[float]): Time (in seconds) between frames, CAMERA_SIMULATOR_FRAME_PERIOD if None.
+            bank_size (Optional[int]): Number of pre-rendered frames, 0 to draw each frame when served,
+                CAMERA_SIMULATOR_BANK_SIZE if None.
         """
+        self._frame_period: float = config.CAMERA_SIMULATOR_FRAME_PERIOD if frame_period is None else frame_period
         self._frame: Optional[Frame] = None
+        self._frame_id: int = -1
         self._frame_time: float = 0.0
+        self._first_id: int = 0
+        self._start_time: float = 0.0
 
         self._active: bool = False
         self._logger: logging.Logger = logging.getLogger("CameraSimulator")
 
+        bank_size = config.CAMERA_SIMULATOR_BANK_SIZE if bank_size is None else bank_size
+        self._bank: List[Tuple[Frame, SimulatedObject]] = self._render_bank(bank_size) if bank_size > 0 else []
+
     # ----------------------------------------------------------------------
     # Public methods
     # ----------------------------------------------------------------------
@@ -45,6 +60,8 @@ class CameraSimulator(ICamera):
         
         self._frame = None
         self._frame_time = 0.0
+        self._first_id = self._frame_id + 1
+        self._start_time = sim_clock.now()
         self._active = True
         self._logger.info("Started.")
 
@@ -61,26 +78,79 @@ class CameraSimulator(ICamera):
         self._frame = None
         self._frame = None
 
-    def get_frame(self) -> Optional[Frame]:
+    def get_frame(self, last_frame_id: int = -1) -> Optional[Frame]:
         """
-        Returns a copy of a new generated frame or the last one if within the frame period.
+        Returns a new generated frame or the last one if within the frame period.
 
         Generates a new frame only if the minimum frame period has elapsed 
         since the last generation. In that case, the generated frame is stored.
-        Otherwise, returns a copy of the previously generated frame.
+        Otherwise, returns the previously generated frame, shared and not copied.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
 
         Returns:
-            Frame: generated frame, or None if the simulator is not active.
+            Frame: generated frame, or None if the simulator is not active or the
+            frame is still the one with last_frame_id.
         """
         if not self._active:
             return None
         
-        now = time()
-        if now - self._frame_time >= config.CAMERA_SIMULATOR_FRAME_PERIOD:
-            frame = self._generate_new_frame()
-            self._frame = frame
+        now = sim_clock.now()
+        if self._bank:
+            # The frame times follow the period from the start, whenever the frames are read
+            index = int((now - self._start_time) / self._frame_period)
+            if self._frame is None or self._first_id + index != self._frame_id:
+                self._frame_id = self._first_id + index
+                self._frame = self._bank_frame(self._frame_id)
+                self._frame_time = self._start_time + index * self._frame_period
+        elif now - self._frame_time >= self._frame_period:
+            self._frame_id += 1
+            self._frame = self._generate_new_frame(self._frame_id)
             self._frame_time = now
-        return deepcopy(self._frame)
+        if self._frame.frame_id == last_frame_id:
+            return None
+        return self._frame
+
+    def wait_frame(self, last_frame_id: int = -1, timeout: Optional[float] = None) -> Optional[Frame]:
+        """
+        Waits until the frame period has elapsed since the frame with last_frame_id,
+        then returns a new generated frame.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
+            timeout (Optional[float]): Longest wait (in seconds), None to wait without limit.
+
+        Returns:
+            Optional[Frame]: The new frame, or None on timeout or if the simulator is not active.
+        """
+        if not self._active:
+            sim_clock.sleep(self._frame_period if timeout is None else timeout)
+            return None
+
+        remaining = 0.0
+        if self._frame is not None and self._frame.frame_id == last_frame_id:
+            remaining = self._frame_period - (sim_clock.now() - self._frame_time)
+        if timeout is not None and remaining > timeout:
+            sim_clock.sleep(timeout)
+            return None
+        if remaining > 0:
+            sim_clock.sleep(remaining)
+        return self.get_frame(last_frame_id)
+
+    def get_ground_truth(self, frame_id: int) -> Optional[SimulatedObject]:
+        """
+        Returns the object drawn in a frame served from the frame bank.
+
+        Args:
+            frame_id (int): Id of the frame.
+
+        Returns:
+            Optional[SimulatedObject]: Object of the frame, None without a frame bank.
+        """
+        if not self._bank:
+            return None
+        return self._bank[frame_id % len(self._bank)][1]
 
     def turn_on_flash(self) -> None:
         """Simulates turning on the camera flash (no-op)."""
@@ -93,24 +163,81 @@ class CameraSimulator(ICamera):
     # ----------------------------------------------------------------------
     # Private methods
     # ----------------------------------------------------------------------
-    def _generate_new_frame(self) -> Frame:
+    def _generate_new_frame(self, frame_id: int) -> Frame:
         """
         Generates a frame containing a stop sign.
 
+        Args:
+            frame_id (int): Id of the new frame.
+
+        Returns:
+            Frame: A  Frame instance containing the generated stop sign image.
+        """
+        image, _ = self._draw_stop_sign(np.random)
+        return Frame(data=image, frame_id=frame_id)
+
+    def _bank_frame(self, frame_id: int) -> Frame:
+        """
+        Serves a frame of the frame bank under a new id.
+
+        The image or JPEG is shared with the bank, each served frame decodes its JPEG once.
+
+        Args:
+            frame_id (int): Id of the new frame.
+
+        Returns:
+            Frame: The bank frame for that id.
+        """
+        frame = self._bank[frame_id % len(self._bank)][0]
+        return Frame(data=frame.data, jpeg=frame.jpeg, frame_id=frame_id)
+
+    def _render_bank(self, size: int) -> List[Tuple[Frame, SimulatedObject]]:
+        """
+        Renders the frame bank, from a generator seeded with CAMERA_SIMULATOR_BANK_SEED.
+
+        Args:
+            size (int): Number of frames.
+
+        Returns:
+            List[Tuple[Frame, SimulatedObject]]: Frames, as arrays or JPEG depending on
+            CAMERA_SIMULATOR_BANK_JPEG, with their objects.
+        """
+        random = np.random.RandomState(config.CAMERA_SIMULATOR_BANK_SEED)
+        bank = []
+        for _ in range(size):
+            image, drawn = self._draw_stop_sign(random)
+            if config.CAMERA_SIMULATOR_BANK_JPEG:
+                frame = Frame(jpeg=cv2.imencode(".jpg", image)[1].tobytes())
+            else:
+                frame = Frame(data=image)
+            bank.append((frame, drawn))
+        self._logger.info("Rendered a bank of %d frames, %d with a %s object.", size,
+                          sum(drawn.target for _, drawn in bank), config.CAMERA_SIMULATOR_TARGET_COLOR)
+        return bank
+
+    @staticmethod
+    def _draw_stop_sign(random) -> Tuple[np.ndarray, SimulatedObject]:
+        """
+        Draws an image containing a stop sign.
+
         The stop sign is drawn as an octagon with the word "STOP" centered. 
         The position and size are random within predefined ranges, and the color of the stop sign is randomized according 
         to the configuration parameters.
 
+        Args:
+            random: Random generator, the numpy.random module or a numpy.random.RandomState.
+
         Returns:
-            Frame: A  Frame instance containing the generated stop sign image.
+            Tuple[np.ndarray, SimulatedObject]: Read-only image and the stop sign drawn in it.
         """
         image = np.zeros((480, 640, 3), dtype=np.uint8)
-        size = np.random.randint(config.CAMERA_SIMULATOR_MIN_RADIUS, config.CAMERA_SIMULATOR_MAX_RADIUS)
-        center = (np.random.randint(size, 640 - size), np.random.randint(size, 480 - size))
-        if np.random.rand() < config.CAMERA_SIMULATOR_COLOR_PROBABILITY:
-            color = config.CAMERA_SIMULATOR_COLOR_DICT[config.CAMERA_SIMULATOR_TARGET_COLOR]
+        size = random.randint(config.CAMERA_SIMULATOR_MIN_RADIUS, config.CAMERA_SIMULATOR_MAX_RADIUS)
+        center = (random.randint(size, 640 - size), random.randint(size, 480 - size))
+        target = random.rand() < config.CAMERA_SIMULATOR_COLOR_PROBABILITY
+        if target:
+            color = tuple(config.CAMERA_SIMULATOR_COLOR_DICT[config.CAMERA_SIMULATOR_TARGET_COLOR])
         else:
-            color = tuple(np.random.randint(0, 256, size=3).tolist())
+            color = tuple(random.randint(0, 256, size=3).tolist())
 
         octagon = []
         for i in range(8):
@@ -126,4 +253,5 @@ class CameraSimulator(ICamera):
         text_x = center[0] - text_size[0] // 2
         text_y = center[1] + text_size[1] // 2
         cv2.putText(image, "STOP", (text_x, text_y), cv2.FONT_HERSHEY_SIMPLEX, font_scale, (255, 255, 255), thickness, cv2.LINE_AA)
-        return Frame(data=image)
\ No newline at end of file
+        image.flags.writeable = False
+        return image, SimulatedObject((int(center[0]), int(center[1])), int(size), color, bool(target))
\ No newline at end of file
@@ -0,0 +1,370 @@
+from typing import Dict, Optional
+from configuration import camera_capture as config
+import socket
+import struct
+import threading
+import logging
+from time import sleep
+
+from drone.camera_capture import parse_camera_status
+from drone.camera_control import CameraControl
+from interfaces.interfaces import ICamera
+from structures.structures import ClockEstimate, Frame, Pose, Position, Orientation
+from utils.clock_offset import ClockOffset, local_time_us
+from utils import metrics
+
+class CameraStreamCapture(ICamera):
+    """
+    Captures frames from the camera raw TCP frame stream and provides access to the latest frame.
+
+    Unlike CameraCapture, no HTTP multipart stream and no OpenCV VideoCapture buffering are involved:
+    the camera writes each frame as a fixed binary header followed by the JPEG bytes, and
+    the frame is published as soon as it is fully received, as JPEG decoded by its consumers on
+    demand (see Frame.image). The header carries the frame sequence
+    number, the sensor capture time, the camera-side send latency of the previous frame, the time
+    the frame waited in the camera pipeline and took to encode, the color prefilter ratio, the crop
+    region of region of interest frames and, when available, the drone pose paired with the frame.
+    The flash is controlled through a CameraControl; the camera only lights it while a stream is open.
+
+    The camera also pushes its binary status on the same connection whenever it changes,
+    so the sensor settings are available from get_status without polling.
+    """
+
+    _MAGIC = b"FR"
+    _STATUS_MAGIC = b"ST"
+    _STATUS_SIZE = struct.calcsize(config.CAMERA_STATUS_FORMAT)
+    _FLAG_POSE = 0x01
+    _FLAG_ROI = 0x02
+    _FLAG_TILTED = 0x04
+
+    def __init__(self, host: str, port: int, flash_url: str) -> None:
+        """
+        Creates a CameraStreamCapture instance.
+
+        Args:
+            host (str): Camera host address.
+            port (int): TCP port of the camera frame stream.
+            flash_url (str): HTTP URL for controlling the camera flash.
+        """
+        self._host: str = host
+        self._port: int = port
+        self._flash_url: str = flash_url
+        self._control: CameraControl = CameraControl(flash_url)
+
+        self._header = struct.Struct(config.CAMERA_FRAME_STREAM_HEADER)
+
+        self._frame: Optional[Frame] = None
+        self._frame_id: int = -1
+        self._clock: ClockOffset = ClockOffset()
+        self._last_seq: int = -1
+        self._dropped_frames: int = 0
+        self._send_latency_us: int = -1
+        self._status: Optional[Dict[str, int]] = None
+
+        self._sock: Optional[socket.socket] = None
+
+        self._lock: threading.Lock = threading.Lock()
+        self._frame_ready: threading.Condition = threading.Condition(self._lock)
+        self._running: bool = False
+        self._thread: Optional[threading.Thread] = None
+
+        self._logger: logging.Logger = logging.getLogger("CameraStreamCapture")
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def start(self) -> None:
+        """
+        Starts the background thread that receives frames from the camera frame stream.
+        """
+        if self._running:
+            self._logger.warning("Already running.")
+            return
+
+        self._running = True
+        self._thread = threading.Thread(target=self._capture, daemon=True)
+        self._thread.start()
+        self._control.start_clock_sync(self._clock)
+        self._logger.info("Started.")
+
+    def stop(self) -> None:
+        """
+        Stops the background capture thread and closes the connection.
+        """
+        if not self._running:
+            self._logger.warning("Already stopped.")
+            return
+
+        self._running = False
+        self._close()
+        self._control.close()
+        if self._thread:
+            self._thread.join(timeout=1.0)
+            if self._thread.is_alive():
+                self._logger.warning("Did not stop in time")
+            self._thread = None
+
+        self._logger.info("Stopped.")
+
+    def pause(self) -> None:
+        """
+        Pauses the capture between routines. The frame stream connection and the clock synchronization are kept,
+        so frames keep arriving, unused, and resume is immediate.
+        """
+        if not self._running:
+            self._logger.warning("Not running.")
+            return
+        self._logger.info("Paused.")
+
+    def resume(self) -> None:
+        """
+        Resumes the capture after pause, or starts it if it is stopped.
+        """
+        if not self._running:
+            self.start()
+            return
+        self._logger.info("Resumed.")
+
+    def get_frame(self, last_frame_id: int = -1) -> Optional[Frame]:
+        """
+        Returns the latest captured frame, without copying it.
+
+        The frame and its JPEG are shared by all callers, which decode it at most once.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
+
+        Returns:
+            Optional[Frame]: The latest captured frame, or None if unavailable or not newer
+            than last_frame_id.
+        """
+        with self._lock:
+            frame = self._frame
+        if frame is None or frame.frame_id == last_frame_id:
+            return None
+        return frame
+
+    def wait_frame(self, last_frame_id: int = -1, timeout: Optional[float] = None) -> Optional[Frame]:
+        """
+        Waits until a frame newer than the one with last_frame_id is captured.
+
+        The capture thread wakes the waiting threads as soon as it stores a frame.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
+            timeout (Optional[float]): Longest wait (in seconds), None to wait without limit.
+
+        Returns:
+            Optional[Frame]: The new frame, or None on timeout.
+        """
+        with self._frame_ready:
+            self._frame_ready.wait_for(
+                lambda: self._frame is not None and self._frame.frame_id != last_frame_id, timeout)
+            frame = self._frame
+        if frame is None or frame.frame_id == last_frame_id:
+            return None
+        return frame
+
+    def turn_on_flash(self) -> None:
+        """
+        Activates the camera's integrated flash.
+        """
+        self._set_flash(config.CAMERA_FLASH_INTENSITY_ON)
+
+    def turn_off_flash(self) -> None:
+        """
+        Deactivates the camera's integrated flash.
+        """
+        self._set_flash(config.CAMERA_FLASH_INTENSITY_OFF)
+
+    def get_dropped_frames(self) -> int:
+        """
+        Returns the number of frames skipped by the camera, detected from gaps in the frame
+        sequence numbers.
+
+        Returns:
+            int: Number of dropped frames since the capture started.
+        """
+        return self._dropped_frames
+
+    def get_send_latency_us(self) -> int:
+        """
+        Returns the last reported camera-side send latency, from frame grab to the
+        end of the frame transmission.
+
+        Returns:
+            int: Latency in microseconds, or -1 if not reported yet.
+        """
+        return self._send_latency_us
+
+    def get_clock_estimate(self) -> Optional[ClockEstimate]:
+        """
+        Returns the mapping of the camera clock, the clock of the frame capture timestamps,
+        onto the ground station monotonic clock.
+
+        Returns:
+            Optional[ClockEstimate]: Offset, drift and error bound, None until a frame or a time exchange.
+        """
+        return self._clock.get_estimate()
+
+    def get_status(self) -> Optional[Dict[str, int]]:
+        """
+        Returns the last camera status pushed on the frame stream.
+
+        Returns:
+            Optional[Dict[str, int]]: Status values by field name, or None if not received yet.
+        """
+        with self._lock:
+            return self._status
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _set_flash(self, intensity: int) -> None:
+        """
+        Sets the flash intensity through the camera control channel.
+
+        Args:
+            intensity (int): Flash intensity.
+        """
+        if self._control.set("led_intensity", intensity):
+            self._logger.debug("Flash intensity set to %d.", intensity)
+        else:
+            self._logger.warning("Failed to set flash intensity.")
+
+    def _close(self) -> None:
+        """Closes the frame stream connection, if open."""
+        sock, self._sock = self._sock, None
+        if sock:
+            try:
+                sock.close()
+            except OSError:
+                pass
+
+    def _recv_exact(self, size: int) -> Optional[bytearray]:
+        """
+        Receives exactly size bytes from the frame stream.
+
+        Args:
+            size (int): Number of bytes to receive.
+
+        Returns:
+            Optional[bytearray]: Received bytes, or None if the connection was closed.
+        """
+        buffer = bytearray(size)
+        view = memoryview(buffer)
+        received = 0
+        while received < size:
+            n = self._sock.recv_into(view[received:], size - received)
+            if n == 0:
+                return None
+            received += n
+        return buffer
+
+    def _read_record(self) -> bool:
+        """
+        Receives one record from the stream, either a frame or a status update.
+
+        Returns:
+            bool: False if the connection was closed or the stream is desynchronized.
+        """
+        magic = self._recv_exact(len(self._MAGIC))
+        if magic is None:
+            return False
+
+        if magic == self._STATUS_MAGIC:
+            rest = self._recv_exact(self._STATUS_SIZE - len(magic))
+            if rest is None:
+                return False
+            status = parse_camera_status(bytes(magic + rest))
+            if status is None:
+                self._logger.warning("Invalid status record, reconnecting.")
+                return False
+            with self._lock:
+                self._status = status
+            self._logger.debug("Camera status updated: %s", status)
+            return True
+
+        rest = self._recv_exact(self._header.size - len(magic))
+        if rest is None:
+            return False
+        return self._read_frame(magic + rest)
+
+    def _read_frame(self, raw: bytearray) -> bool:
+        """
+        Receives the JPEG of a frame and stores it as the latest frame.
+
+        Args:
+            raw (bytearray): Frame header.
+
+        Returns:
+            bool: False if the connection was closed or the stream is desynchronized.
+        """
+        (magic, version, flags, seq, capture_us, prev_send_us, length,
+         pose_seq, pose_timestamp, pose_age_us, x, y, z, roll, pitch, yaw, color_ratio,
+         roi_x, roi_y, roi_w, roi_h, queue_us, encode_us) = self._header.unpack(raw)
+        if magic != self._MAGIC or version != config.CAMERA_FRAME_STREAM_VERSION \
+                or length > config.CAMERA_FRAME_STREAM_MAX_FRAME:
+            self._logger.warning("Invalid frame header, reconnecting.")
+            return False
+
+        jpeg = self._recv_exact(length)
+        if jpeg is None:
+            return False
+        receive_us = local_time_us()
+
+        if self._last_seq >= 0 and seq > self._last_seq + 1:
+            self._dropped_frames += seq - self._last_seq - 1
+            metrics.inc("frames_dropped_total", "camera", seq - self._last_seq - 1)
+            self._logger.debug("Dropped %d frames", seq - self._last_seq - 1)
+        self._last_seq = seq
+        if prev_send_us:
+            self._send_latency_us = prev_send_us
+
+        pose = None
+        if flags & self._FLAG_POSE:
+            pose = Pose(position=Position(x, y, z), orientation=Orientation(roll, pitch, yaw))
+
+        host_capture_us = receive_us
+        if capture_us:
+            self._clock.update(capture_us, receive_us)
+            host_capture_us = self._clock.to_local(capture_us)
+
+        with self._lock:
+            self._frame_id += 1
+            self._frame = Frame(jpeg=bytes(jpeg), seq=seq, capture_timestamp_us=capture_us, pose=pose,
+                                pose_timestamp_us=pose_timestamp if pose else 0,
+                                color_ratio=color_ratio / 1000 if color_ratio >= 0 else -1.0,
+                                roi=(roi_x, roi_y, roi_w, roi_h) if flags & self._FLAG_ROI else None,
+                                tilted=bool(flags & self._FLAG_TILTED), frame_id=self._frame_id,
+                                host_capture_us=host_capture_us, receive_us=receive_us,
+                                camera_queue_us=queue_us, encode_us=encode_us)
+            self._frame_ready.notify_all()
+        metrics.inc("frames_total", "captured")
+        self._logger.debug("Frame %d captured of %d bytes", seq, length)
+        return True
+
+    def _capture(self) -> None:
+        """
+        Background thread that continuously receives and stores frames.
+
+        Connects to the camera frame stream and reads frames until the connection drops,
+        then retries after a configurable delay.
+        """
+        while self._running:
+            try:
+                self._sock = socket.create_connection((self._host, self._port),
+                                                      timeout=config.CAMERA_STREAM_TIMEOUT)
+                self._sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+                self._logger.info("Frame stream opened successfully.")
+                self._last_seq = -1
+                while self._running and self._read_record():
+                    pass
+            except (OSError, AttributeError) as e:
+                if self._running:
+                    self._logger.warning("Frame stream failed: %s", e)
+            finally:
+                self._close()
+
+            if self._running:
+                sleep(config.CAMERA_STREAM_RETRY_DELAY)
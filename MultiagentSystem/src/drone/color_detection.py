@@ -1,179 +1,1193 @@
-from typing import Optional, Callable
+from typing import Dict, List, Optional, Callable, Tuple
 from configuration import color_detection as config
 import threading
 import logging
+import math
 import cv2
 import numpy as np
+from dataclasses import dataclass
+from pathlib import Path
 from queue import Queue, Empty
 from ultralytics import YOLO
-from time import sleep
+from time import monotonic, perf_counter
 
 from interfaces.interfaces import AFrameConsumer
-from structures.structures import FrameWithTelemetry, Position
+from structures.structures import DetectionTrace, Frame, FrameWithTelemetry, Position
+from utils.clock_offset import local_time_us
+from utils.frame_mailbox import FrameMailbox
+from utils import metrics
+from utils.jpeg import reduced_scale
 
 
+@dataclass
+class _Track:
+    """Object of the target color tracked on the ground.
+
+    Attributes:
+        x (float): Mean X coordinate of the associated detections (in meters).
+        y (float): Mean Y coordinate of the associated detections (in meters).
+        z (float): Mean Z coordinate of the associated detections (in meters).
+        hits (int): Number of associated detections.
+        last_us (int): Time of the last associated detection (in microseconds, see utils.clock_offset).
+        confirmed (bool): True once the object has been reported.
+        first_us (int): Time of the first associated detection (in microseconds, see utils.clock_offset).
+    """
+    x: float
+    y: float
+    z: float
+    hits: int
+    last_us: int
+    confirmed: bool = False
+    first_us: int = 0
+
 class ColorDetection(AFrameConsumer):
     """
     Detects a specific color in objects within frames that include telemetry data.
 
-    This class consumes FrameWithTelemetry objects from an internal queue and processes each frame
-    in a background thread. For every frame, it applies a YOLO model to detect 
-    objects of an specified color.
+    This class consumes FrameWithTelemetry objects from an internal queue and processes them
+    in COLOR_DETECTION_WORKERS background threads. The frames queued together are run through
+    the YOLO model in one batch, which detects the objects; their color is then checked against
+    the specified color. Each worker owns its model instance; inference and the OpenCV color
+    checks release the GIL, so the workers run in parallel on separate cores.
 
-    When a detection occurs, an optional callback function can be invoked with the position associated 
-    with the frame.
+    Each object is located on the ground by projecting its box centre with the camera geometry
+    (see COLOR_DETECTION_GROUND_PROJECTION). Detections are associated across frames to tracked
+    objects by distance. An optional callback
+    function is invoked once per object, with the position associated with its frames, when the object
+    is confirmed. Frames taken over confirmed objects are not processed again.
+
+    The inference backend is selected at startup among COLOR_DETECTION_BACKENDS, falling back
+    to the CPU when no accelerator is available, or taken from the choice cached by an earlier run.
+    The models are loaded and warmed up in a background thread (see COLOR_DETECTION_BACKGROUND_LOAD);
+    the workers wait for them, so the first frames do not pay for loading or graph building.
+
+    Several drones can share the models and the workers through channels (see open_channel), each with
+    its own queue, tracked objects and callbacks. The instance itself consumes frames through a default
+    channel, so a single drone uses it as is.
     """
 
+    # Backend name: (export format, device, half precision)
+    _BACKENDS: Dict[str, Tuple[Optional[str], object, bool]] = {
+        "tensorrt": ("engine", 0, True),
+        "cuda": (None, 0, True),
+        "openvino": ("openvino", "cpu", False),
+        "onnx": ("onnx", "cpu", False),
+        "cpu": (None, "cpu", False),
+    }
+
     def __init__(self,
                  color: str,
                  yolo_model_path: str) -> None:
         """
         Creates a ColorDetection instance.
 
-        It initializes the YOLO model, sets up the color limits based on the configuration,
-        and creates the internal queue. 
+        It sets up the color limits based on the configuration and creates the internal queue, then
+        selects the inference backend and loads the YOLO models on it, in a background thread
+        with COLOR_DETECTION_BACKGROUND_LOAD.
 
         Args:
             color (str): Name of the color to detect.
             yolo_model_path (str): Path to the YOLO model file.
         """
         self._color: str = color
-        self._model: YOLO = YOLO(yolo_model_path)
-
-        self._callback: Optional[Callable[[Position], None]] = None
 
         self._colorLimits = config.COLOR_DETECTION_COLORS.get(color)
         if self._colorLimits is None:
             raise ValueError(f"Color '{color}' not defined in configuration.")
-
-        self._queue = Queue(maxsize=config.COLOR_DETECTION_MAX_QUEUE_SIZE)
+        self._colorRanges = [(np.array(self._colorLimits[f"lower{i}"]), np.array(self._colorLimits[f"upper{i}"]))
+                             for i in (1, 2) if f"lower{i}" in self._colorLimits and f"upper{i}" in self._colorLimits]
 
         self._running: bool = False
-        self._thread: Optional[threading.Thread] = None
+        self._threads: List[threading.Thread] = []
+        self._callback_lock: threading.Lock = threading.Lock()
+        self._coverage_lock: threading.Lock = threading.Lock()
+
+        # Running channels, replaced as a whole so that the workers read them without a lock
+        self._channels: Tuple[DetectionChannel, ...] = ()
+        self._channels_lock: threading.Lock = threading.Lock()
+        self._next_channel: int = 0
+        self._wake: threading.Event = threading.Event()
+
+        self._channel: DetectionChannel = DetectionChannel(self, "ColorDetection")
+        self._queue = self._channel._queue
+
+        self._stats_lock: threading.Lock = threading.Lock()
+        self._processed_frames: int = 0
+        self._skipped_frames: int = 0
 
         self._logger: logging.Logger = logging.getLogger("ColorDetection")
 
+        self._backend: str = ""
+        self._device: object = "cpu"
+        self._half: bool = False
+        self._models: List[YOLO] = []
+        self._ready: threading.Event = threading.Event()
+        self._load_error: str = ""
+
+        model_path = Path(yolo_model_path)
+        if config.COLOR_DETECTION_BACKGROUND_LOAD:
+            threading.Thread(target=self._load_models, args=(model_path,), name="ColorDetectionLoader",
+                             daemon=True).start()
+        else:
+            self._load_models(model_path)
+            if self._load_error:
+                raise RuntimeError(self._load_error)
+
     # ----------------------------------------------------------------------
     # Public methods
     # ----------------------------------------------------------------------
     def start(self) -> None:
         """
-        Starts the background thread that processes frames from the queue.
+        Starts processing the frames of the default channel, and the background worker threads if no
+        channel is running yet.
         
         It continously retrives FrameWithTelemetry objects for detection and color analysis. 
         When the target color is detected, it triggers the registered callback.
         """
-        if self._running:
-            self._logger.warning("Already running.")
-            return
-
-        self._running = True
-        self._thread = threading.Thread(target=self._process, daemon=True)
-        self._thread.start()
-        self._logger.info("Started.")
+        self._channel.start()
 
     def stop(self) -> None:
         """
-        Stops the background color detection thread.
+        Stops processing the frames of the default channel, and the background worker threads if no
+        other channel is running.
         """
-        if not self._running:
-            self._logger.warning("Already stopped.")
-            return
+        self._channel.stop()
+
+    def enqueue(self, fwt: FrameWithTelemetry) -> None:
+        """
+        Enqueues a FrameWithTelemetry object on the default channel, see AFrameConsumer.enqueue.
+
+        Args:
+            fwt (FrameWithTelemetry): Frame data with associated telemetry to enqueue.
+        """
+        super().enqueue(fwt)
+        self._wake.set()
 
-        self._running = False
-        if self._thread:
-            self._thread.join(timeout=1.0)
-            if self._thread.is_alive():
-                self._logger.warning("Did not stop in time.")
-            self._thread = None
-        self._logger.info("Stopped.")
+    def open_channel(self, name: str = "DetectionChannel") -> "DetectionChannel":
+        """
+        Creates a channel for another drone to share the models and the workers of this instance.
+
+        Args:
+            name (str): Logger name of the channel.
+
+        Returns:
+            DetectionChannel: Stopped channel, without callbacks.
+        """
+        return DetectionChannel(self, name)
 
     def set_callback(self, callback: Callable[[Position], None]) -> None:
         """
-        Registers a callback function to be called whenever the target color is detected
-        in a frame, passing the Position associated with the frame.
+        Registers a callback function to be called once per confirmed object of the target color,
+        passing the mean Position of the frames the object was detected in.
+
+        The workers call it one at a time.
 
         Args:
             callback (Callable[[Position], None]): Callback function with position as parameter.
         """
-        self._callback = callback
+        self._channel.set_callback(callback)
+
+    def set_coverage_callback(self, callback: Callable[[Position, float], None]) -> None:
+        """
+        Registers a callback function to be called with the ground footprint of every frame taken
+        from the queue, whether YOLO runs on it or not, except frames taken tilted and crop frames.
+
+        The footprint is the disk inscribed in the camera view on the ground, around the ground point
+        of the image centre. The workers call it concurrently.
+
+        Args:
+            callback (Callable[[Position, float], None]): Callback function with the ground centre and the
+            radius (in meters) of the footprint as parameters.
+        """
+        self._channel.set_coverage_callback(callback)
+
+    def set_trace_callback(self, callback: Callable[[DetectionTrace], None]) -> None:
+        """
+        Registers a callback function to be called after the detection callback of each confirmed object,
+        with the times the confirming frame went through the detection stages, for latency measurements.
+
+        The workers call it one at a time. A DetectionProcess does not forward it.
+
+        Args:
+            callback (Callable[[DetectionTrace], None]): Callback function with the trace as parameter.
+        """
+        self._channel.set_trace_callback(callback)
+
+    def get_frame_stats(self) -> Dict[str, int]:
+        """
+        Returns the number of frames analyzed by YOLO and of frames skipped before it, since creation.
+
+        Returns:
+            Dict[str, int]: "processed" and "skipped" frame counts.
+        """
+        with self._stats_lock:
+            return {"processed": self._processed_frames, "skipped": self._skipped_frames}
+
+    def label(self, image: np.ndarray) -> np.ndarray:
+        """
+        Finds the objects of the target color in an image, as the workers do, for labelling datasets.
+
+        It uses the model of the first worker, so it must not be called while the workers run.
+
+        Args:
+            image (np.ndarray): Image in BGR.
+
+        Returns:
+            np.ndarray: Boxes (x1, y1, x2, y2) in pixels of the image, shape (N, 4), possibly empty.
+
+        Raises:
+            RuntimeError: If the models could not be loaded.
+        """
+        if not self.wait_ready():
+            raise RuntimeError(self._load_error or "YOLO models not loaded")
+        result = self._predict(self._models[0], [image], self._device, self._half)[0]
+        if len(result.boxes) == 0:
+            return np.zeros((0, 4), int)
+        return self._target_boxes(image, 1.0, result.boxes)
+
+    @staticmethod
+    def select_model(name: str) -> Path:
+        """
+        Switches the detection settings to a model of COLOR_DETECTION_MODELS, for the instances created afterwards.
+
+        Args:
+            name (str): Model name.
+
+        Returns:
+            Path: Path to the YOLO model file, to create the instances with.
+        """
+        model = config.COLOR_DETECTION_MODELS[name]
+        config.YOLO_MODEL_PATH = model["path"]
+        config.COLOR_DETECTION_IMG_SIZE = model["img_size"]
+        config.COLOR_DETECTION_INT8 = model["int8"]
+        return model["path"]
+
+    def get_backend(self) -> str:
+        """
+        Returns the inference backend selected at startup.
+
+        Returns:
+            str: Backend name, one of COLOR_DETECTION_BACKENDS or "cpu", empty until the models are loaded.
+        """
+        return self._backend
+
+    def wait_ready(self, timeout: Optional[float] = None) -> bool:
+        """
+        Waits until the YOLO models are loaded and warmed up.
+
+        Args:
+            timeout (Optional[float]): Longest wait (in seconds), None to wait until loading ends.
+
+        Returns:
+            bool: True if the models are ready, False on timeout or if loading failed.
+        """
+        return self._ready.wait(timeout) and not self._load_error
 
     # ----------------------------------------------------------------------
     # Private methods
     # ----------------------------------------------------------------------
+    def _start_channel(self, channel: "DetectionChannel") -> None:
+        """
+        Starts taking the frames of a channel, forgetting its tracked objects and covered ground,
+        and starts the worker threads if it is the first running channel.
+
+        Args:
+            channel (DetectionChannel): Channel to start.
+        """
+        with self._channels_lock:
+            if channel in self._channels:
+                channel._logger.warning("Already running.")
+                return
+
+            with self._coverage_lock:
+                channel._last_covered = None
+            with self._callback_lock:
+                channel._tracks = []
+            self._channels += (channel,)
+            if self._running:
+                channel._logger.info("Started, sharing %d workers.", len(self._threads))
+                return
+
+            self._running = True
+            self._threads = [threading.Thread(target=self._process, args=(index,), daemon=True)
+                             for index in range(max(config.COLOR_DETECTION_WORKERS, 1))]
+            for thread in self._threads:
+                thread.start()
+        channel._logger.info("Started with %d workers.", len(self._threads))
+
+    def _stop_channel(self, channel: "DetectionChannel") -> None:
+        """
+        Stops taking the frames of a channel, and stops the worker threads if it was the last running channel.
+
+        Args:
+            channel (DetectionChannel): Channel to stop.
+        """
+        with self._channels_lock:
+            if channel not in self._channels:
+                channel._logger.warning("Already stopped.")
+                return
+
+            self._channels = tuple(other for other in self._channels if other is not channel)
+            if not self._channels:
+                # Joined under the lock, so that a channel started meanwhile does not run a second set of workers
+                self._running = False
+                self._wake.set()
+                for thread in self._threads:
+                    thread.join(timeout=1.0)
+                    if thread.is_alive():
+                        self._logger.warning("Did not stop in time.")
+                self._threads = []
+        channel._logger.info("Stopped.")
+
+    def _load_models(self, model_path: Path) -> None:
+        """
+        Loads and warms up one YOLO model per worker, on the cached or the selected inference backend.
+
+        Failures are kept in the load error instead of being raised, since this runs in the loader thread
+        with COLOR_DETECTION_BACKGROUND_LOAD.
+
+        Args:
+            model_path (Path): Path to the YOLO model file.
+        """
+        start = perf_counter()
+        try:
+            models = [self._cached_backend(model_path) or self._select_backend(model_path)]
+            for _ in range(1, max(config.COLOR_DETECTION_WORKERS, 1)):
+                model = self._load_backend(model_path, self._backend)
+                self._warm_up(model, self._backend)
+                models.append(model)
+            self._models = models
+            self._logger.info("%d models ready in %.1f s.", len(models), perf_counter() - start)
+        except Exception as e:
+            self._load_error = str(e)
+            self._logger.error("Could not load the YOLO model: %s", e)
+        finally:
+            self._ready.set()
+
+    def _cached_backend(self, model_path: Path) -> Optional[YOLO]:
+        """
+        Loads the YOLO model on the backend selected by an earlier run (see COLOR_DETECTION_BACKEND_CACHE).
+
+        Args:
+            model_path (Path): Path to the YOLO model file.
+
+        Returns:
+            Optional[YOLO]: Model loaded and warmed up on the cached backend, or None if there is no usable
+            cached backend.
+        """
+        cache = model_path.with_suffix(".backend")
+        if not config.COLOR_DETECTION_BACKEND_CACHE or not cache.exists():
+            return None
+
+        name = cache.read_text().strip()
+        if name not in self._BACKENDS or name not in config.COLOR_DETECTION_BACKENDS + ("cpu",):
+            return None
+        try:
+            model = self._load_backend(model_path, name)
+            self._warm_up(model, name)
+        except Exception as e:
+            self._logger.info("Cached inference backend '%s' unavailable: %s", name, e)
+            return None
+
+        self._backend = name
+        _, self._device, self._half = self._BACKENDS[name]
+        self._logger.info("Using cached inference backend '%s'", name)
+        return model
+
+    def _warm_up(self, model: YOLO, name: str) -> None:
+        """
+        Runs a model once on a blank frame and once on a full batch of them, so that the first
+        frames do not pay for building the inference graph.
+
+        Args:
+            model (YOLO): Model to warm up.
+            name (str): Backend the model is loaded for.
+        """
+        _, device, half = self._BACKENDS[name]
+        frame = np.zeros((config.COLOR_DETECTION_IMG_SIZE, config.COLOR_DETECTION_IMG_SIZE, 3), np.uint8)
+        self._predict(model, [frame], device, half)
+        if config.COLOR_DETECTION_BATCH_SIZE > 1:
+            self._predict(model, [frame] * config.COLOR_DETECTION_BATCH_SIZE, device, half)
+
+    def _select_backend(self, model_path: Path) -> YOLO:
+        """
+        Loads the YOLO model on the fastest available inference backend.
+
+        Each backend of COLOR_DETECTION_BACKENDS is loaded, exporting the model first if needed,
+        and checked with a warm-up. Backends that fail are skipped. With
+        COLOR_DETECTION_BACKEND_BENCHMARK, the available backends are timed and the fastest is kept;
+        otherwise the first available backend is kept. The choice is cached with COLOR_DETECTION_BACKEND_CACHE.
+
+        Args:
+            model_path (Path): Path to the YOLO model file.
+
+        Returns:
+            YOLO: Model loaded on the selected backend.
+        """
+        names = [name for name in config.COLOR_DETECTION_BACKENDS if name != "cpu"] + ["cpu"]
+        batch = [np.zeros((config.COLOR_DETECTION_IMG_SIZE, config.COLOR_DETECTION_IMG_SIZE, 3), np.uint8)] \
+            * config.COLOR_DETECTION_BATCH_SIZE
+
+        best: Optional[Tuple[float, str, YOLO]] = None
+        for name in names:
+            if name not in self._BACKENDS:
+                self._logger.warning("Unknown inference backend '%s', skipped.", name)
+                continue
+            _, device, half = self._BACKENDS[name]
+            try:
+                model = self._load_backend(model_path, name)
+                self._warm_up(model, name)
+                elapsed = 0.0
+                if config.COLOR_DETECTION_BACKEND_BENCHMARK:
+                    start = perf_counter()
+                    for _ in range(config.COLOR_DETECTION_BENCHMARK_RUNS):
+                        self._predict(model, batch, device, half)
+                    elapsed = (perf_counter() - start) / max(config.COLOR_DETECTION_BENCHMARK_RUNS, 1)
+            except Exception as e:
+                self._logger.info("Inference backend '%s' unavailable: %s", name, e)
+                continue
+
+            self._logger.info("Inference backend '%s' available, %.1f ms per batch", name, elapsed * 1000)
+            if best is None or elapsed < best[0]:
+                best = (elapsed, name, model)
+            if not config.COLOR_DETECTION_BACKEND_BENCHMARK:
+                break
+
+        if best is None:
+            raise RuntimeError(f"No inference backend available for '{model_path}'.")
+
+        _, self._backend, model = best
+        _, self._device, self._half = self._BACKENDS[self._backend]
+        self._logger.info("Using inference backend '%s'", self._backend)
+        if config.COLOR_DETECTION_BACKEND_CACHE:
+            try:
+                model_path.with_suffix(".backend").write_text(self._backend)
+            except OSError as e:
+                self._logger.warning("Could not cache the inference backend: %s", e)
+        return model
+
+    def _load_backend(self, model_path: Path, name: str) -> YOLO:
+        """
+        Loads the YOLO model for an inference backend.
+
+        Backends that need an exported model reuse the export cached next to the model file,
+        or export it on first use. With COLOR_DETECTION_INT8, the "tensorrt" and "openvino" exports
+        are quantized to INT8, calibrated on COLOR_DETECTION_CALIBRATION_DATA.
+
+        Args:
+            model_path (Path): Path to the YOLO model file.
+            name (str): Backend name.
+
+        Returns:
+            YOLO: Model loaded for the backend.
+        """
+        fmt, device, half = self._BACKENDS[name]
+        if device != "cpu":
+            import torch
+            if not torch.cuda.is_available():
+                raise RuntimeError("CUDA not available")
+        if fmt is None:
+            return YOLO(str(model_path))
+
+        # INT8 calibration only pays off on TensorRT and OpenVINO, ONNX Runtime keeps the float model
+        int8 = config.COLOR_DETECTION_INT8 and fmt in ("engine", "openvino")
+        suffix = "_int8" if int8 else ""
+        exported = {
+            "engine": model_path.with_name(model_path.stem + suffix + ".engine"),
+            "onnx": model_path.with_suffix(".onnx"),
+            "openvino": model_path.with_name(model_path.stem + suffix + "_openvino_model"),
+        }[fmt]
+        if not exported.exists():
+            if int8 and not config.COLOR_DETECTION_CALIBRATION_DATA.exists():
+                raise RuntimeError(f"INT8 calibration data {config.COLOR_DETECTION_CALIBRATION_DATA} not found, "
+                                   f"run model_export.py")
+            self._logger.info("Exporting YOLO model to %s%s", fmt, " (INT8)" if int8 else "")
+            options = {"int8": True, "data": str(config.COLOR_DETECTION_CALIBRATION_DATA)} if int8 else {"half": half}
+            target = exported
+            exported = Path(YOLO(str(model_path)).export(
+                format=fmt,
+                imgsz=config.COLOR_DETECTION_IMG_SIZE,
+                dynamic=True,
+                batch=config.COLOR_DETECTION_BATCH_SIZE,
+                device=device,
+                verbose=False,
+                **options
+            ))
+            # YOLO names the export after the model only, the INT8 one is kept apart from the float one
+            if exported != target:
+                exported = exported.rename(target)
+        return YOLO(str(exported), task="detect")
+
+    @staticmethod
+    def _predict(model: YOLO, data, device, half: bool) -> list:
+        """
+        Runs YOLO on an image or a batch of images with the detection settings.
+
+        Args:
+            model (YOLO): Model to run.
+            data: Image or list of images.
+            device: Inference device.
+            half (bool): True to infer in half precision.
+
+        Returns:
+            list: YOLO results, one per image.
+        """
+        return model.predict(
+            data,
+            device=device,
+            imgsz=config.COLOR_DETECTION_IMG_SIZE,
+            conf=config.COLOR_DETECTION_CONF_THRESH,
+            iou=config.COLOR_DETECTION_IOU_THRESH,
+            half=half,
+            verbose=False
+        )
+
+    def _should_process(self, channel: "DetectionChannel", fwt: FrameWithTelemetry) -> bool:
+        """
+        Tells whether a frame is worth running YOLO on.
+
+        Frames the camera flagged as tilted, or measured below the minimum color
+        ratio by its prefilter, are skipped, as are frames that add little ground coverage
+        (see _adds_coverage). Frames the camera did not measure go through the color
+        check on a downscaled copy, when COLOR_DETECTION_GATE is set.
+
+        Args:
+            channel (DetectionChannel): Channel the frame was taken from.
+            fwt (FrameWithTelemetry): Frame with telemetry to check.
+
+        Returns:
+            bool: True if the frame must be processed.
+        """
+        if config.COLOR_DETECTION_SKIP_TILTED and fwt.frame.tilted:
+            self._logger.debug("Frame skipped, drone tilted")
+            return False
+
+        if 0 <= fwt.frame.color_ratio < config.COLOR_DETECTION_PREFILTER_MIN_RATIO:
+            self._logger.debug("Frame skipped by color prefilter (ratio %.3f)", fwt.frame.color_ratio)
+            return False
+
+        if self._over_confirmed_track(channel, fwt.telemetry.pose.position):
+            self._logger.debug("Frame skipped, object already confirmed there")
+            return False
+
+        if not self._adds_coverage(channel, fwt):
+            self._logger.debug("Frame skipped, footprint already covered")
+            return False
+
+        if config.COLOR_DETECTION_GATE and fwt.frame.color_ratio < 0:
+            small, scale = self._reduced_image(fwt.frame, config.COLOR_DETECTION_GATE_SCALE)
+            if small is None:
+                self._logger.warning("Frame %d skipped, failed to decode", fwt.frame.frame_id)
+                return False
+            if scale > config.COLOR_DETECTION_GATE_SCALE:
+                factor = config.COLOR_DETECTION_GATE_SCALE / scale
+                small = cv2.resize(small, None, fx=factor, fy=factor, interpolation=cv2.INTER_NEAREST)
+            mask = self._color_mask(cv2.cvtColor(small, cv2.COLOR_BGR2HSV))
+            ratio = cv2.countNonZero(mask) / (mask.shape[0] * mask.shape[1] + 1e-6)
+            if ratio < config.COLOR_DETECTION_PREFILTER_MIN_RATIO:
+                self._logger.debug("Frame skipped by color gate (ratio %.3f)", ratio)
+                return False
+
+        return True
+
+    def _over_confirmed_track(self, channel: "DetectionChannel", position: Position) -> bool:
+        """
+        Tells whether a position is within COLOR_DETECTION_TRACK_RADIUS of a confirmed object of a channel.
+
+        Args:
+            channel (DetectionChannel): Channel the frame was taken from.
+            position (Position): Frame position.
+
+        Returns:
+            bool: True if a confirmed object is that close.
+        """
+        with self._callback_lock:
+            return any(track.confirmed and math.hypot(position.x - track.x, position.y - track.y)
+                       < config.COLOR_DETECTION_TRACK_RADIUS for track in channel._tracks)
+
+    def _on_detection(self, channel: "DetectionChannel", fwt: FrameWithTelemetry, position: Position,
+                      stages: Tuple[int, int, int] = (0, 0, 0)) -> None:
+        """
+        Associates a detection to the closest object tracked by a channel, or starts tracking a new object.
+
+        The tracked position is the mean of the associated detection positions. When the object reaches
+        COLOR_DETECTION_TRACK_CONFIRM_HITS detections, it is confirmed and the callback is triggered.
+        Unconfirmed objects without detections for COLOR_DETECTION_TRACK_TIMEOUT are dropped.
+
+        Args:
+            channel (DetectionChannel): Channel the frame was taken from, whose callbacks are triggered.
+            fwt (FrameWithTelemetry): Frame the target color was detected in.
+            position (Position): Position of the detected object.
+            stages (Tuple[int, int, int]): Times the batch of the frame was dequeued, decoded and inferred
+                (in microseconds, see utils.clock_offset), for the trace callback.
+        """
+        now_us = fwt.frame.host_capture_us or local_time_us()
+        with self._callback_lock:
+            timeout_us = config.COLOR_DETECTION_TRACK_TIMEOUT * 1e6
+            channel._tracks = [track for track in channel._tracks
+                               if track.confirmed or now_us - track.last_us < timeout_us]
+
+            closest = min(channel._tracks, default=None,
+                          key=lambda track: math.hypot(position.x - track.x, position.y - track.y))
+            if closest is None or math.hypot(position.x - closest.x, position.y - closest.y) \
+                    >= config.COLOR_DETECTION_TRACK_RADIUS:
+                closest = _Track(position.x, position.y, position.z, 0, now_us, first_us=now_us)
+                channel._tracks.append(closest)
+
+            closest.hits += 1
+            closest.x += (position.x - closest.x) / closest.hits
+            closest.y += (position.y - closest.y) / closest.hits
+            closest.z += (position.z - closest.z) / closest.hits
+            closest.last_us = max(closest.last_us, now_us)
+            channel._logger.debug("%s object detected at position %s (%d hits)",
+                                  self._color.capitalize(), position, closest.hits)
+
+            if closest.confirmed or closest.hits < config.COLOR_DETECTION_TRACK_CONFIRM_HITS:
+                return
+            closest.confirmed = True
+            fired_us = local_time_us()
+            if channel._callback:
+                channel._callback(Position(closest.x, closest.y, closest.z))
+                metrics.observe("latency_seconds", "detect_to_callback", (local_time_us() - closest.first_us) / 1e6)
+            if channel._trace_callback:
+                channel._trace_callback(DetectionTrace(fwt.frame, fwt.matched_us, *stages, fired_us, local_time_us()))
+
+    def _adds_coverage(self, channel: "DetectionChannel", fwt: FrameWithTelemetry) -> bool:
+        """
+        Tells whether a frame adds enough ground coverage to be processed, and records its footprint if so.
+        Each channel keeps its own last footprint, since the drones fly apart.
+
+        The footprint is a circle of COLOR_DETECTION_FOOTPRINT_RADIUS around the frame position.
+        The drone displacement since the last processed frame is the larger of the position change
+        and the telemetry speed times the elapsed time, so stale poses still account for the motion.
+        The frame is skipped while the footprints overlap by more than COLOR_DETECTION_MAX_OVERLAP,
+        for at most COLOR_DETECTION_MAX_SKIP_INTERVAL.
+
+        Args:
+            channel (DetectionChannel): Channel the frame was taken from.
+            fwt (FrameWithTelemetry): Frame with telemetry to check.
+
+        Returns:
+            bool: True if the frame must be processed.
+        """
+        position = fwt.telemetry.pose.position
+        now_us = fwt.frame.host_capture_us or local_time_us()
+        with self._coverage_lock:
+            if channel._last_covered is not None and config.COLOR_DETECTION_MAX_OVERLAP < 1.0:
+                elapsed = (now_us - channel._last_covered_us) / 1e6
+                if 0 <= elapsed < config.COLOR_DETECTION_MAX_SKIP_INTERVAL:
+                    velocity = fwt.telemetry.velocity
+                    displacement = max(
+                        math.hypot(position.x - channel._last_covered.x, position.y - channel._last_covered.y),
+                        math.hypot(velocity.vx, velocity.vy) * elapsed)
+                    if self._footprint_overlap(displacement) > config.COLOR_DETECTION_MAX_OVERLAP:
+                        return False
+
+            channel._last_covered = position
+            channel._last_covered_us = now_us
+        return True
+
+    @staticmethod
+    def _footprint_overlap(distance: float) -> float:
+        """
+        Computes the overlapping fraction of two frame footprints.
+
+        Args:
+            distance (float): Distance between the footprint centers (in meters).
+
+        Returns:
+            float: Fraction of a footprint covered by the other, from 0 to 1.
+        """
+        r = config.COLOR_DETECTION_FOOTPRINT_RADIUS
+        if distance >= 2 * r:
+            return 0.0
+        area = 2 * r * r * math.acos(distance / (2 * r)) - distance / 2 * math.sqrt(4 * r * r - distance * distance)
+        return area / (math.pi * r * r)
+
+    @staticmethod
+    def _reduced_image(frame: Frame, scale: float) -> Tuple[Optional[np.ndarray], float]:
+        """
+        Returns the image of a frame at the smallest JPEG reduced size not below a scale.
+
+        Args:
+            frame (Frame): Frame to decode.
+            scale (float): Smallest accepted scale, relative to the full size frame.
+
+        Returns:
+            Tuple[Optional[np.ndarray], float]: Image (None if it could not be decoded) and its actual scale.
+        """
+        size = frame.size()
+        if size is None:
+            return frame.image(), 1.0
+        data = frame.image(reduced_scale(size, max(size) * scale))
+        if data is None:
+            return None, 1.0
+        return data, data.shape[1] / size[0]
+
+    def _detection_image(self, frame: Frame) -> Tuple[Optional[np.ndarray], float]:
+        """
+        Returns the image of a frame YOLO runs on, decoded at a reduced size when it still
+        fills the YOLO input (see COLOR_DETECTION_REDUCED_DECODE).
+
+        Args:
+            frame (Frame): Frame to decode.
+
+        Returns:
+            Tuple[Optional[np.ndarray], float]: Image (None if it could not be decoded) and its scale,
+            relative to the full size frame.
+        """
+        if not config.COLOR_DETECTION_REDUCED_DECODE:
+            return frame.image(), 1.0
+        size = frame.size()
+        longer = max(size) if size else config.COLOR_DETECTION_IMG_SIZE
+        return self._reduced_image(frame, config.COLOR_DETECTION_IMG_SIZE / longer)
+
+    def _color_mask(self, hsv: np.ndarray) -> np.ndarray:
+        """
+        Computes the mask of the pixels within the HSV ranges of the target color.
+
+        Args:
+            hsv (np.ndarray): Image in HSV.
+
+        Returns:
+            np.ndarray: Mask, 255 for the pixels of the target color and 0 elsewhere.
+        """
+        mask = None
+        for lower, upper in self._colorRanges:
+            m = cv2.inRange(hsv, lower, upper)
+            mask = m if mask is None else cv2.bitwise_or(mask, m)
+        return mask
+
     def _process_frame(self, fwt: FrameWithTelemetry) -> None:
         """
-        Processes a single frame.
-        
-        It runs YOLO to detect objects and extracts the corresponding
-        image regions, filtering by minimum area. 
-        For each region, it converts the region to HSV, applies color masks,
-        and computes the proportion of matching pixels.
-        If the color is detected, it triggers the callback.
+        Processes a single frame of the default channel, as a batch of one frame.
 
         Args:
             fwt (FrameWithTelemetry): Frame with telemetry to analyze.
         """
-        data = fwt.frame.data
-        position = fwt.telemetry.pose.position
-        self._logger.debug("Processing frame of shape %s at position %s", data.shape, position)
+        self._process_channel_frame(self._channel, fwt)
+
+    def _process_channel_frame(self, channel: "DetectionChannel", fwt: FrameWithTelemetry) -> None:
+        """
+        Processes a single frame of a channel, as a batch of one frame.
+
+        Args:
+            channel (DetectionChannel): Channel of the frame.
+            fwt (FrameWithTelemetry): Frame with telemetry to analyze.
+        """
+        if not self.wait_ready():
+            return
+        self._report_coverage(channel, fwt)
+        if self._should_process(channel, fwt):
+            self._process_batch([(channel, fwt)], self._models[0])
+
+    def _process_batch(self, batch: List[Tuple["DetectionChannel", FrameWithTelemetry]], model: YOLO) -> None:
+        """
+        Runs YOLO once on a batch of frames, then checks the detections of each frame.
 
+        Frames that fail to decode are dropped from the batch.
+
+        Args:
+            batch (List[Tuple[DetectionChannel, FrameWithTelemetry]]): Frames with telemetry to analyze,
+                with the channel each was taken from.
+            model (YOLO): Model of the calling worker.
+        """
+        self._logger.debug("Processing batch of %d frames", len(batch))
+
+        dequeued_us = local_time_us()
+        images = []
+        for channel, fwt in batch:
+            data, scale = self._detection_image(fwt.frame)
+            if data is None:
+                channel._logger.warning("Frame %d skipped, failed to decode", fwt.frame.frame_id)
+                continue
+            images.append((channel, fwt, data, scale))
+        if not images:
+            return
+
+        decoded_us = local_time_us()
         try:
-            results = self._model.predict(
-                data,
-                device="cpu",
-                imgsz=config.COLOR_DETECTION_IMG_SIZE,
-                conf=config.COLOR_DETECTION_CONF_THRESH,
-                iou=config.COLOR_DETECTION_IOU_THRESH,
-                half=False,
-                verbose=False
-            )
+            results = self._predict(model, [data for _, _, data, _ in images], self._device, self._half)
         except Exception as e:
             self._logger.error("YOLO prediction error: %s", e)
             return
-        dets = results[0].boxes if len(results) else []
-        self._logger.debug("YOLO detected %d objects", len(dets))
-
-        for box in dets:
-            xyxy = box.xyxy.cpu().numpy().astype(int)[0] if hasattr(box.xyxy, "cpu") else np.array(box.xyxy).astype(int)[0]
-            x1, y1, x2, y2 = xyxy
-            w, h = x2 - x1, y2 - y1
-            if w * h < config.COLOR_DETECTION_MIN_BOX_AREA:
-                continue
 
-            roi = data[y1:y2, x1:x2]
-            if roi.size == 0:
+        with self._stats_lock:
+            self._processed_frames += len(images)
+            for channel, _, _, _ in images:
+                channel._processed_frames += 1
+        metrics.inc("frames_total", "detected", len(images))
+        detected_us = local_time_us()
+        for _, fwt, _, _ in images:
+            if fwt.matched_us:
+                metrics.observe("latency_seconds", "match_to_detect", (detected_us - fwt.matched_us) / 1e6)
+        for (channel, fwt, data, scale), result in zip(images, results):
+            self._check_detections(channel, fwt, data, scale, result.boxes, (dequeued_us, decoded_us, detected_us))
+
+    def _target_boxes(self, data: np.ndarray, scale: float, dets) -> np.ndarray:
+        """
+        Keeps the boxes YOLO detected in an image that are mostly of the target color.
+
+        The image is converted to HSV and masked with the target color once, and an integral
+        image of the mask is built, so the proportion of matching pixels in each detection
+        is a rectangle sum, computed for all the boxes at once. Detections below the minimum area
+        are ignored.
+
+        Args:
+            data (np.ndarray): Image YOLO ran on.
+            scale (float): Scale of the image, relative to the full size frame.
+            dets: YOLO boxes detected in the image.
+
+        Returns:
+            np.ndarray: Boxes (x1, y1, x2, y2) in pixels of the image, shape (N, 4), possibly empty.
+        """
+        height, width = data.shape[:2]
+        xyxy = dets.xyxy
+        boxes = (xyxy.cpu().numpy() if hasattr(xyxy, "cpu") else np.asarray(xyxy)).astype(int).reshape(-1, 4)
+        areas = (boxes[:, 2] - boxes[:, 0]) * (boxes[:, 3] - boxes[:, 1])
+        boxes[:, 0::2] = np.clip(boxes[:, 0::2], 0, width)
+        boxes[:, 1::2] = np.clip(boxes[:, 1::2], 0, height)
+        boxes = boxes[(areas >= config.COLOR_DETECTION_MIN_BOX_AREA * scale * scale)
+                      & (boxes[:, 2] > boxes[:, 0]) & (boxes[:, 3] > boxes[:, 1])]
+        if len(boxes) == 0:
+            return boxes
+
+        mask = self._color_mask(cv2.cvtColor(data, cv2.COLOR_BGR2HSV))
+        counts = cv2.integral(mask // 255, sdepth=cv2.CV_32S)
+        x1, y1, x2, y2 = boxes.T
+        matching = counts[y2, x2] - counts[y1, x2] - counts[y2, x1] + counts[y1, x1]
+        return boxes[matching / ((x2 - x1) * (y2 - y1) + 1e-6) >= config.COLOR_DETECTION_THRESH]
+
+    def _check_detections(self, channel: "DetectionChannel", fwt: FrameWithTelemetry, data: np.ndarray,
+                          scale: float, dets, stages: Tuple[int, int, int] = (0, 0, 0)) -> None:
+        """
+        Checks the color of the objects YOLO detected in a frame (see _target_boxes).
+
+        Each object of the target color is located on the ground (see _ground_positions),
+        and boxes of the frame located within COLOR_DETECTION_TRACK_RADIUS of an earlier one count
+        as the same object.
+
+        Args:
+            channel (DetectionChannel): Channel the frame was taken from.
+            fwt (FrameWithTelemetry): Analyzed frame with telemetry.
+            data (np.ndarray): Image YOLO ran on.
+            scale (float): Scale of the image, relative to the full size frame.
+            dets: YOLO boxes detected in the image.
+            stages (Tuple[int, int, int]): Times the batch was dequeued, decoded and inferred, see _on_detection.
+        """
+        position = fwt.telemetry.pose.position
+        self._logger.debug("YOLO detected %d objects in frame of shape %s at position %s",
+                           len(dets), data.shape, position)
+        if len(dets) == 0:
+            return
+
+        boxes = self._target_boxes(data, scale, dets)
+        if len(boxes) == 0:
+            return
+
+        if not config.COLOR_DETECTION_GROUND_PROJECTION:
+            self._on_detection(channel, fwt, position, stages)
+            return
+
+        located: List[Position] = []
+        for x, y in self._ground_positions(fwt, boxes, data.shape):
+            ground = Position(float(x), float(y), 0.0) if np.isfinite(x) else position
+            if all(math.hypot(ground.x - other.x, ground.y - other.y) >= config.COLOR_DETECTION_TRACK_RADIUS
+                   for other in located):
+                located.append(ground)
+                self._on_detection(channel, fwt, ground, stages)
+
+    @staticmethod
+    def _ground_positions(fwt: FrameWithTelemetry, boxes: np.ndarray, shape: Tuple[int, ...]) -> np.ndarray:
+        """
+        Projects the centres of boxes to the ground plane (z = 0).
+
+        The camera is a pinhole of COLOR_DETECTION_CAMERA_HFOV looking down the body z axis, with the top of
+        the image toward the body x axis (front). The ray through each box centre is rotated to the world frame
+        with the attitude of the telemetry, the pitch of the state estimate being the legacy inverted one
+        (positive nose up), then intersected with the ground from the drone position.
+
+        Args:
+            fwt (FrameWithTelemetry): Frame with the telemetry of its capture time.
+            boxes (np.ndarray): Boxes (x1, y1, x2, y2) in pixels of the image YOLO ran on, shape (N, 4).
+            shape (Tuple[int, ...]): Shape of the image YOLO ran on.
+
+        Returns:
+            np.ndarray: Ground x and y (in meters) of each box, shape (N, 2), NaN for rays that do not
+            point down to the ground or when the drone is not above it.
+        """
+        pose = fwt.telemetry.pose
+        height, width = shape[:2]
+        u = (boxes[:, 0] + boxes[:, 2]) / 2.0
+        v = (boxes[:, 1] + boxes[:, 3]) / 2.0
+        if fwt.frame.roi is None:
+            view_width, view_height = width, height
+        else:
+            # Crop frames: from crop pixels to pixels of the full view
+            roi_x, roi_y, roi_width, roi_height = fwt.frame.roi
+            view_width, view_height = config.COLOR_DETECTION_CAMERA_VIEW_SIZE
+            u = roi_x + u * roi_width / width
+            v = roi_y + v * roi_height / height
+        focal = view_width / 2.0 / math.tan(math.radians(config.COLOR_DETECTION_CAMERA_HFOV) / 2.0)
+
+        # Rays in the body frame: x front (image up), y left (image left), z up
+        rays = np.stack([view_height / 2.0 - v, view_width / 2.0 - u, np.full_like(u, -focal)], axis=1)
+
+        roll = math.radians(pose.orientation.roll)
+        pitch = -math.radians(pose.orientation.pitch)
+        yaw = math.radians(pose.orientation.yaw)
+        cr, sr = math.cos(roll), math.sin(roll)
+        cp, sp = math.cos(pitch), math.sin(pitch)
+        cy, sy = math.cos(yaw), math.sin(yaw)
+        body_to_world = np.array([
+            [cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr],
+            [sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr],
+            [-sp, cp * sr, cp * cr],
+        ])
+        rays = rays @ body_to_world.T
+
+        position = pose.position
+        with np.errstate(divide="ignore", invalid="ignore"):
+            distance = np.where((rays[:, 2] < 0) & (position.z > 0), -position.z / rays[:, 2], np.nan)
+        return np.stack([position.x + distance * rays[:, 0], position.y + distance * rays[:, 1]], axis=1)
+
+    def _report_coverage(self, channel: "DetectionChannel", fwt: FrameWithTelemetry) -> None:
+        """
+        Passes the ground footprint of a frame to the coverage callback of its channel, see set_coverage_callback.
+
+        Args:
+            channel (DetectionChannel): Channel the frame was taken from.
+            fwt (FrameWithTelemetry): Frame taken from the queue.
+        """
+        position = fwt.telemetry.pose.position
+        if channel._coverage_callback is None or fwt.frame.tilted or fwt.frame.roi is not None or position.z <= 0:
+            return
+
+        width, height = config.COLOR_DETECTION_CAMERA_VIEW_SIZE
+        centre = self._ground_positions(fwt, np.array([[width / 2, height / 2, width / 2, height / 2]]),
+                                        (height, width))[0]
+        if not np.isfinite(centre[0]):
+            return
+        radius = position.z * math.tan(math.radians(config.COLOR_DETECTION_CAMERA_HFOV) / 2) * min(width, height) / width
+        try:
+            channel._coverage_callback(Position(float(centre[0]), float(centre[1]), 0.0), radius)
+        except Exception as e:
+            channel._logger.error("Coverage callback failed: %s", e)
+
+    def _take(self, timeout: float) -> Optional[Tuple["DetectionChannel", FrameWithTelemetry]]:
+        """
+        Takes the next frame from the queues of the running channels.
+
+        The channels are visited in turn, from the one after the channel of the last frame taken,
+        so that a drone sending more frames does not starve the others. Waits for a frame when
+        all the queues are empty.
+
+        Args:
+            timeout (float): Longest wait (in seconds).
+
+        Returns:
+            Optional[Tuple[DetectionChannel, FrameWithTelemetry]]: Frame with its channel, None if none arrived.
+        """
+        deadline = monotonic() + timeout
+        while True:
+            channels = self._channels
+            for i in range(len(channels)):
+                channel = channels[(self._next_channel + i) % len(channels)]
+                try:
+                    fwt = channel._queue.get_nowait()
+                except Empty:
+                    continue
+                self._next_channel = (self._next_channel + i + 1) % len(channels)
+                return channel, fwt
+
+            self._wake.clear()
+            if any(not channel._queue.empty() for channel in self._channels):
                 continue
+            remaining = deadline - monotonic()
+            if remaining <= 0 or not self._running:
+                return None
+            self._wake.wait(remaining)
 
-            hsv = cv2.cvtColor(roi, cv2.COLOR_BGR2HSV)
-            mask1 = cv2.inRange(hsv, np.array(self._colorLimits["lower1"]), np.array(self._colorLimits["upper1"]))
-            mask2 = None
-            if "lower2" in self._colorLimits and "upper2" in self._colorLimits:
-                mask2 = cv2.inRange(hsv, np.array(self._colorLimits["lower2"]), np.array(self._colorLimits["upper2"]))
-            mask = mask1 if mask2 is None else cv2.bitwise_or(mask1, mask2)
-            ratio = cv2.countNonZero(mask) / (roi.shape[0] * roi.shape[1] + 1e-6)
-
-            if ratio >= config.COLOR_DETECTION_THRESH:
-                if self._callback:
-                    self._callback(position)
-                self._logger.debug("%s object detected at position %s", self._color.capitalize(), position)
-                return
+    def _collect_batch(self) -> List[Tuple["DetectionChannel", FrameWithTelemetry]]:
+        """
+        Collects the frames of the next batch from the queues of the running channels.
+
+        Waits for a first frame to process, then takes frames until the batch holds
+        COLOR_DETECTION_BATCH_SIZE frames or COLOR_DETECTION_BATCH_WINDOW has elapsed.
+        The frames of several drones share a batch.
+
+        Returns:
+            List[Tuple[DetectionChannel, FrameWithTelemetry]]: Frames to process with their channel,
+            empty if none arrived.
+        """
+        batch: List[Tuple[DetectionChannel, FrameWithTelemetry]] = []
+        deadline = None
+        while self._running and len(batch) < config.COLOR_DETECTION_BATCH_SIZE:
+            timeout = 0.1 if deadline is None else deadline - monotonic()
+            if timeout <= 0:
+                break
+            taken = self._take(timeout)
+            if taken is None:
+                break
+            channel, fwt = taken
+            self._report_coverage(channel, fwt)
+            if not self._should_process(channel, fwt):
+                with self._stats_lock:
+                    self._skipped_frames += 1
+                    channel._skipped_frames += 1
+                metrics.inc("frames_skipped_total", "ColorDetection")
+                continue
+            batch.append(taken)
+            if deadline is None:
+                deadline = monotonic() + config.COLOR_DETECTION_BATCH_WINDOW
+        return batch
 
-    def _process(self) -> None:
+    def _process(self, index: int) -> None:
         """
-        Background thread method that continuously retrieves frames from the queue and
-        applies color detection processing.
+        Background worker method that waits for the models to be loaded, then continuously retrieves
+        batches of frames from the channel queues and applies color detection processing.
+
+        Args:
+            index (int): Index of the worker, and of the model it owns.
         """
+        while self._running and not self._ready.wait(0.1):
+            pass
+        if not self._running or index >= len(self._models):
+            return
+
+        model = self._models[index]
         while self._running:
-            try:
-                fwt = self._queue.get(timeout=0.1)
-            except Empty:
-                sleep(config.COLOR_DETECTION_SLEEP_TIME)
+            batch = self._collect_batch()
+            if not batch:
                 continue
 
             try:
-                self._process_frame(fwt)
+                self._process_batch(batch, model)
             except Exception as e:
-                self._logger.error("Error processing frame: %s", e)
+                self._logger.error("Error processing frames: %s", e)
+
+
+class DetectionChannel(AFrameConsumer):
+    """
+    Frame consumer of one drone on a ColorDetection shared by several drones.
+
+    A channel has its own queue, tracked objects, last covered footprint and callbacks, so the objects
+    a drone sees are reported to that drone only, while the YOLO models and the worker threads of the
+    ColorDetection serve all the channels. Channels are created by ColorDetection.open_channel and
+    started and stopped on their own; the workers run while any channel does.
+    """
+
+    def __init__(self, detection: ColorDetection, name: str) -> None:
+        """
+        Creates a stopped DetectionChannel instance, without callbacks.
+
+        Args:
+            detection (ColorDetection): Color detection processing the frames.
+            name (str): Logger name.
+        """
+        self._detection: ColorDetection = detection
+
+        self._callback: Optional[Callable[[Position], None]] = None
+        self._coverage_callback: Optional[Callable[[Position, float], None]] = None
+        self._trace_callback: Optional[Callable[[DetectionTrace], None]] = None
+
+        self._queue = FrameMailbox(config.COLOR_DETECTION_MAILBOX_SIZE) if config.COLOR_DETECTION_MAILBOX_SIZE > 0 \
+            else Queue(maxsize=config.COLOR_DETECTION_MAX_QUEUE_SIZE)
+
+        self._last_covered: Optional[Position] = None
+        self._last_covered_us: int = 0
+        self._tracks: List[_Track] = []
+
+        # Guarded by the stats lock of the ColorDetection
+        self._processed_frames: int = 0
+        self._skipped_frames: int = 0
 
-            sleep(config.COLOR_DETECTION_SLEEP_TIME)
+        self._logger: logging.Logger = logging.getLogger(name)
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def start(self) -> None:
+        """
+        Starts processing the frames of the channel, with no tracked object and nothing covered.
+        """
+        self._detection._start_channel(self)
+
+    def stop(self) -> None:
+        """
+        Stops processing the frames of the channel.
+        """
+        self._detection._stop_channel(self)
+
+    def enqueue(self, fwt: FrameWithTelemetry) -> None:
+        """
+        Enqueues a FrameWithTelemetry object for processing, see AFrameConsumer.enqueue.
+
+        Args:
+            fwt (FrameWithTelemetry): Frame data with associated telemetry to enqueue.
+        """
+        super().enqueue(fwt)
+        self._detection._wake.set()
+
+    def set_callback(self, callback: Callable[[Position], None]) -> None:
+        """
+        Registers the callback of the confirmed objects of the channel, see ColorDetection.set_callback.
+
+        Args:
+            callback (Callable[[Position], None]): Callback function with position as parameter.
+        """
+        self._callback = callback
+
+    def set_coverage_callback(self, callback: Callable[[Position, float], None]) -> None:
+        """
+        Registers the callback of the frame footprints of the channel, see ColorDetection.set_coverage_callback.
+
+        Args:
+            callback (Callable[[Position, float], None]): Callback function with the ground centre and the
+            radius (in meters) of the footprint as parameters.
+        """
+        self._coverage_callback = callback
+
+    def set_trace_callback(self, callback: Callable[[DetectionTrace], None]) -> None:
+        """
+        Registers the callback of the detection traces of the channel, see ColorDetection.set_trace_callback.
+
+        Args:
+            callback (Callable[[DetectionTrace], None]): Callback function with the trace as parameter.
+        """
+        self._trace_callback = callback
+
+    def get_frame_stats(self) -> Dict[str, int]:
+        """
+        Returns the number of frames of the channel analyzed by YOLO and of frames skipped before it,
+        since creation. ColorDetection.get_frame_stats counts the frames of all the channels.
+
+        Returns:
+            Dict[str, int]: "processed" and "skipped" frame counts.
+        """
+        with self._detection._stats_lock:
+            return {"processed": self._processed_frames, "skipped": self._skipped_frames}
+
+    def wait_ready(self, timeout: Optional[float] = None) -> bool:
+        """
+        Waits until the models of the shared ColorDetection are ready, see ColorDetection.wait_ready.
+
+        Args:
+            timeout (Optional[float]): Longest wait (in seconds), None to wait until loading ends.
+
+        Returns:
+            bool: True if the models are ready, False on timeout or if loading failed.
+        """
+        return self._detection.wait_ready(timeout)
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _process_frame(self, fwt: FrameWithTelemetry) -> None:
+        """
+        Processes a single frame of the channel, see ColorDetection._process_frame.
+
+        Args:
+            fwt (FrameWithTelemetry): Frame with telemetry to analyze.
+        """
+        self._detection._process_channel_frame(self, fwt)
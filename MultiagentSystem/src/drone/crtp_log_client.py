@@ -0,0 +1,390 @@
+from configuration import drone_telemetry as config
+import json
+import os
+import queue
+import socket
+import struct
+import threading
+import logging
+from time import monotonic
+from typing import Callable, Dict, List, Optional, Tuple
+
+LogCallback = Callable[[int, Dict[str, float]], None]
+"""Callback of a log block, called with the drone timestamp (in ms) and the values by variable name."""
+
+class CrtpLogClient:
+    """
+    Lightweight client of the drone CRTP log subsystem over UDP.
+
+    The drone Wi-Fi link carries CRTP packets over UDP, each datagram being
+    the CRTP header, the payload and a trailing checksum byte. This client
+    downloads the log table of contents (TOC), creates log blocks of any
+    logged variables, such as ``stateEstimate.x`` or ``pm.vbat``, and calls
+    back with the decoded values of every block packet. Selecting other
+    variables or rates only needs a new subscription, not a firmware rebuild.
+
+    The drone stops streaming the log blocks when the link has been idle for
+    a second, so a keep-alive packet is sent while the client runs.
+
+    Downloading the TOC takes one request per variable. The drone reports a
+    CRC of its TOC, which only changes with the firmware, so each downloaded
+    TOC is kept on disk under its CRC and reused on the next connections.
+    """
+
+    _PORT_LOG = 0x05
+    _PORT_LINK = 0x0F
+    _CHANNEL_TOC = 0
+    _CHANNEL_CONTROL = 1
+    _CHANNEL_DATA = 2
+    _CHANNEL_LINK_SINK = 2
+
+    _CMD_GET_ITEM_V2 = 2
+    _CMD_GET_INFO_V2 = 3
+    _CONTROL_CREATE_BLOCK_V2 = 6
+    _CONTROL_START_BLOCK = 3
+    _CONTROL_RESET = 5
+
+    _LEGACY_DATA_SIZE = 30
+    _BLOCK_HEADER_SIZE = 4
+
+    # Log variable types, as in the firmware log.h
+    _TYPE_FORMATS: Dict[int, str] = {
+        1: "B", 2: "H", 3: "I", 4: "b", 5: "h", 6: "i", 7: "f", 8: "e",
+    }
+
+    def __init__(self, drone_ip: str, drone_port: int, local_port: int) -> None:
+        """
+        Creates a CrtpLogClient instance.
+
+        Args:
+            drone_ip (str): IP address of the drone.
+            drone_port (int): UDP port of the drone CRTP link.
+            local_port (int): Local UDP port to receive the CRTP packets on.
+        """
+        self._drone_ip: str = drone_ip
+        self._drone_port: int = drone_port
+        self._local_port: int = local_port
+
+        self._toc: Dict[str, Tuple[int, int]] = {}
+        self._blocks: Dict[int, Tuple[List[str], struct.Struct, LogCallback]] = {}
+        self._next_block_id: int = 0
+
+        self._replies: "queue.Queue[bytes]" = queue.Queue()
+        self._sock: Optional[socket.socket] = None
+        self._send_lock: threading.Lock = threading.Lock()
+        self._last_send: float = 0.0
+
+        self._running: bool = False
+        self._thread: Optional[threading.Thread] = None
+
+        self._logger: logging.Logger = logging.getLogger("CrtpLogClient")
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def start(self) -> None:
+        """
+        Opens the UDP socket and starts the receiving thread.
+
+        The log blocks left on the drone by a previous client are deleted.
+        """
+        if self._running:
+            self._logger.warning("Already running.")
+            return
+
+        self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self._sock.bind(("0.0.0.0", self._local_port))
+        self._sock.settimeout(config.LOG_KEEPALIVE_PERIOD)
+
+        self._running = True
+        self._thread = threading.Thread(target=self._listen, daemon=True)
+        self._thread.start()
+
+        self._request(self._CHANNEL_CONTROL, bytes([self._CONTROL_RESET]))
+        self._blocks.clear()
+        self._next_block_id = 0
+        self._logger.info("Started.")
+
+    def stop(self) -> None:
+        """
+        Stops the receiving thread and closes the socket.
+
+        The drone deletes the log blocks by itself once the link is idle.
+        """
+        if not self._running:
+            self._logger.warning("Already stopped.")
+            return
+
+        self._running = False
+        if self._thread:
+            self._thread.join(timeout=2 * config.LOG_KEEPALIVE_PERIOD)
+            if self._thread.is_alive():
+                self._logger.warning("Did not stop in time.")
+            self._thread = None
+        if self._sock:
+            try:
+                self._sock.close()
+            except OSError:
+                pass
+            self._sock = None
+
+        self._logger.info("Stopped.")
+
+    def fetch_toc(self) -> Dict[str, Tuple[int, int]]:
+        """
+        Downloads the log table of contents, or loads it from the cache when the drone reports a known TOC CRC.
+
+        Returns:
+            Dict[str, Tuple[int, int]]: Variable id and type by "group.name".
+
+        Raises:
+            TimeoutError: If the drone does not answer.
+        """
+        info = self._request(self._CHANNEL_TOC, bytes([self._CMD_GET_INFO_V2]))
+        count, crc = struct.unpack_from("<HI", info, 1)
+
+        toc = self._load_cached_toc(crc, count)
+        if toc is not None:
+            self._toc = toc
+            self._logger.info("Log TOC %08x loaded from the cache, %d variables.", crc, len(toc))
+            return toc
+
+        toc = {}
+        for var_id in range(count):
+            item = self._request(self._CHANNEL_TOC, struct.pack("<BH", self._CMD_GET_ITEM_V2, var_id))
+            group, name = item[4:].split(b"\0")[:2]
+            toc[f"{group.decode()}.{name.decode()}"] = (var_id, item[3] & 0x0F)
+
+        self._toc = toc
+        self._save_cached_toc(crc, toc)
+        self._logger.info("Log TOC %08x downloaded, %d variables.", crc, len(toc))
+        return toc
+
+    def add_block(self, names: List[str], period_ms: int, callback: LogCallback) -> int:
+        """
+        Creates and starts a log block sending the given variables.
+
+        Args:
+            names (List[str]): Variables, as "group.name".
+            period_ms (int): Block period, 10-2550 ms in steps of 10 ms.
+            callback (LogCallback): Called from the receiving thread with every block packet.
+
+        Returns:
+            int: Block id.
+
+        Raises:
+            KeyError: If a variable is not in the TOC.
+            ValueError: If the variables do not fit in one packet or the period is out of range.
+            RuntimeError: If the drone refuses the block.
+        """
+        if not self._toc:
+            self.fetch_toc()
+
+        settings = b""
+        formats = "<"
+        for name in names:
+            var_id, var_type = self._toc[name]
+            settings += struct.pack("<BH", var_type, var_id)
+            formats += self._TYPE_FORMATS[var_type]
+        values = struct.Struct(formats)
+        if values.size > self._LEGACY_DATA_SIZE - self._BLOCK_HEADER_SIZE:
+            raise ValueError(f"Block of {values.size} bytes does not fit in a log packet")
+        if not 10 <= period_ms <= 2550:
+            raise ValueError(f"Block period {period_ms} ms out of range")
+
+        block_id = self._next_block_id
+        self._next_block_id += 1
+        self._blocks[block_id] = (names, values, callback)
+
+        self._control(bytes([self._CONTROL_CREATE_BLOCK_V2, block_id]) + settings)
+        self._control(bytes([self._CONTROL_START_BLOCK, block_id, period_ms // 10]))
+        self._logger.info("Block %d started every %d ms: %s", block_id, period_ms, ", ".join(names))
+        return block_id
+
+    def send(self, port: int, channel: int, data: bytes) -> None:
+        """
+        Sends one CRTP packet to another port than the log, such as a commander, without waiting for an answer.
+
+        Args:
+            port (int): CRTP port.
+            channel (int): CRTP channel.
+            data (bytes): Packet payload.
+
+        Raises:
+            RuntimeError: If the client is not running.
+        """
+        if not self._running:
+            raise RuntimeError("CRTP client not running")
+        self._send(port, channel, data)
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _send(self, port: int, channel: int, data: bytes) -> None:
+        """
+        Sends one CRTP packet.
+
+        Args:
+            port (int): CRTP port.
+            channel (int): CRTP channel.
+            data (bytes): Packet payload.
+        """
+        packet = bytes([(port & 0x0F) << 4 | (channel & 0x0F)]) + data
+        with self._send_lock:
+            self._sock.sendto(packet + bytes([sum(packet) & 0xFF]), (self._drone_ip, self._drone_port))
+            self._last_send = monotonic()
+
+    @staticmethod
+    def _toc_cache_path(crc: int) -> str:
+        """
+        Returns the cache file of a log TOC.
+
+        Args:
+            crc (int): TOC CRC reported by the drone.
+
+        Returns:
+            str: File path.
+        """
+        return os.path.join(config.LOG_TOC_CACHE_FOLDER, f"log_toc_{crc:08x}.json")
+
+    def _load_cached_toc(self, crc: int, count: int) -> Optional[Dict[str, Tuple[int, int]]]:
+        """
+        Loads a log TOC from the cache.
+
+        Args:
+            crc (int): TOC CRC reported by the drone.
+            count (int): Number of variables reported by the drone.
+
+        Returns:
+            Optional[Dict[str, Tuple[int, int]]]: Variable id and type by "group.name", None if not cached.
+        """
+        if not config.LOG_TOC_CACHE_FOLDER:
+            return None
+        try:
+            with open(self._toc_cache_path(crc), "r", encoding="utf-8") as f:
+                toc = {name: (var_id, var_type) for name, (var_id, var_type) in json.load(f).items()}
+        except FileNotFoundError:
+            return None
+        except (OSError, ValueError, TypeError) as e:
+            self._logger.warning("Unreadable log TOC cache %08x: %s", crc, e)
+            return None
+        if len(toc) != count:
+            self._logger.warning("Log TOC cache %08x holds %d variables instead of %d.", crc, len(toc), count)
+            return None
+        return toc
+
+    def _save_cached_toc(self, crc: int, toc: Dict[str, Tuple[int, int]]) -> None:
+        """
+        Saves a downloaded log TOC to the cache.
+
+        Args:
+            crc (int): TOC CRC reported by the drone.
+            toc (Dict[str, Tuple[int, int]]): Variable id and type by "group.name".
+        """
+        if not config.LOG_TOC_CACHE_FOLDER:
+            return
+        path = self._toc_cache_path(crc)
+        try:
+            os.makedirs(config.LOG_TOC_CACHE_FOLDER, exist_ok=True)
+            with open(path + ".tmp", "w", encoding="utf-8") as f:
+                json.dump(toc, f)
+            os.replace(path + ".tmp", path)
+        except OSError as e:
+            self._logger.warning("Could not cache the log TOC %08x: %s", crc, e)
+
+    def _request(self, channel: int, data: bytes) -> bytes:
+        """
+        Sends a log TOC or control request and waits for its answer.
+
+        Answers are matched by their leading bytes, so stale answers of a
+        timed out request are skipped.
+
+        Args:
+            channel (int): Log channel of the request.
+            data (bytes): Request payload, command first.
+
+        Returns:
+            bytes: Answer payload.
+
+        Raises:
+            TimeoutError: If no answer arrived after the configured retries.
+        """
+        match = data[:3] if channel == self._CHANNEL_TOC else data[:2]
+        for _ in range(config.LOG_REQUEST_RETRIES):
+            self._send(self._PORT_LOG, channel, data)
+            deadline = monotonic() + config.LOG_REQUEST_TIMEOUT
+            while True:
+                remaining = deadline - monotonic()
+                if remaining <= 0:
+                    break
+                try:
+                    reply = self._replies.get(timeout=remaining)
+                except queue.Empty:
+                    break
+                if reply[:len(match)] == match:
+                    return reply
+        raise TimeoutError(f"No answer to log request {data[0]} on channel {channel}")
+
+    def _control(self, data: bytes) -> None:
+        """
+        Sends a log control request and checks its status.
+
+        Args:
+            data (bytes): Control payload, command and block id first.
+
+        Raises:
+            RuntimeError: If the drone answered with an error.
+        """
+        reply = self._request(self._CHANNEL_CONTROL, data)
+        if len(reply) >= 3 and reply[2] != 0:
+            raise RuntimeError(f"Log control {data[0]} of block {data[1]} failed with error {reply[2]}")
+
+    def _process_data(self, data: bytes) -> None:
+        """
+        Decodes a log block packet and calls the block callback.
+
+        Args:
+            data (bytes): Packet payload, block id, 24 bit timestamp (ms) and values.
+        """
+        block = self._blocks.get(data[0])
+        if block is None or len(data) < self._BLOCK_HEADER_SIZE + block[1].size:
+            return
+
+        names, values, callback = block
+        timestamp_ms = data[1] | data[2] << 8 | data[3] << 16
+        callback(timestamp_ms, dict(zip(names, values.unpack_from(data, self._BLOCK_HEADER_SIZE))))
+
+    def _listen(self) -> None:
+        """
+        Background thread receiving the CRTP packets.
+
+        Log data packets are dispatched to their block callback, TOC and
+        control answers are handed to the pending request. Other packets,
+        such as the console, are ignored.
+        """
+        while self._running:
+            if monotonic() - self._last_send >= config.LOG_KEEPALIVE_PERIOD:
+                self._send(self._PORT_LINK, self._CHANNEL_LINK_SINK, b"")
+            try:
+                packet, _ = self._sock.recvfrom(config.DRONE_UDP_BUFFER_SIZE)
+            except socket.timeout:
+                continue
+            except OSError as e:
+                if self._running:
+                    self._logger.error("Socket error: %s", e)
+                break
+
+            if len(packet) < 2 or (sum(packet[:-1]) & 0xFF) != packet[-1]:
+                continue
+            header, data = packet[0], packet[1:-1]
+            if header >> 4 != self._PORT_LOG or not data:
+                continue
+
+            channel = header & 0x0F
+            try:
+                if channel == self._CHANNEL_DATA:
+                    self._process_data(data)
+                else:
+                    self._replies.put(data)
+            except (struct.error, ValueError) as e:
+                self._logger.error("Unpack error: %s", e)
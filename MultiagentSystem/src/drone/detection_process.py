@@ -0,0 +1,336 @@
+from configuration import color_detection as config
+import threading
+import logging
+import multiprocessing
+from dataclasses import fields
+from multiprocessing.connection import Connection
+from queue import Empty
+from typing import Callable, Dict, Optional
+
+from interfaces.interfaces import AFrameConsumer
+from structures.structures import Frame, FrameWithTelemetry, Position
+from utils import metrics
+from utils.frame_mailbox import FrameMailbox
+from utils.shared_frame_ring import SharedFrameRing
+
+# Frame attributes sent through the pipe, the image itself going through the ring
+_FRAME_FIELDS = tuple(f.name for f in fields(Frame) if f.init and f.name not in ("data", "jpeg"))
+
+class DetectionProcess(AFrameConsumer):
+    """
+    Runs a ColorDetection in a separate process, as a drop-in replacement for it.
+
+    Decoding, the color checks and inference then no longer share the interpreter lock
+    with capture, matching, the viewer and the operation visualizer, and run on their own core.
+
+    Each frame goes through a SharedFrameRing: its JPEG (or raw image) is copied into the next slot,
+    and only a small message with the slot sequence number, the frame attributes and the telemetry
+    is sent over a pipe. The detection process copies the frame out of the ring as soon as the message
+    arrives and hands it to its ColorDetection; confirmed positions come back over the same pipe and
+    are passed to the callback from a listener thread.
+
+    The process starts, and loads the YOLO model, when the instance is created, and runs
+    until close. start and stop only start and stop its ColorDetection.
+    """
+
+    def __init__(self, color: str, yolo_model_path: str) -> None:
+        """
+        Creates a DetectionProcess instance and launches the detection process.
+
+        Args:
+            color (str): Name of the color to detect.
+            yolo_model_path (str): Path to the YOLO model file.
+        """
+        self._callback: Optional[Callable[[Position], None]] = None
+        self._coverage_callback: Optional[Callable[[Position, float], None]] = None
+        self._queue = FrameMailbox(config.COLOR_DETECTION_MAILBOX_SIZE)
+
+        self._ring: SharedFrameRing = SharedFrameRing(config.COLOR_DETECTION_RING_SLOTS,
+                                                      config.COLOR_DETECTION_RING_SLOT_SIZE)
+        context = multiprocessing.get_context("spawn")
+        self._conn, child_conn = context.Pipe()
+        self._process = context.Process(target=_run, name="ColorDetection", daemon=True,
+                                        args=(child_conn, self._ring.name, color, str(yolo_model_path)))
+
+        self._running: bool = False
+        self._closed: bool = False
+        self._send_lock: threading.Lock = threading.Lock()
+        self._forwarder: Optional[threading.Thread] = None
+        self._backend: str = ""
+        self._stats: Dict[str, int] = {"processed": 0, "skipped": 0}
+        self._stats_event: threading.Event = threading.Event()
+
+        self._logger: logging.Logger = logging.getLogger("DetectionProcess")
+
+        self._process.start()
+        child_conn.close()
+        self._listener: threading.Thread = threading.Thread(target=self._listen, daemon=True)
+        self._listener.start()
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def start(self) -> None:
+        """
+        Starts the color detection of the process and the thread forwarding frames to it.
+        """
+        if self._running:
+            self._logger.warning("Already running.")
+            return
+
+        self._running = True
+        self._send(("start",))
+        self._forwarder = threading.Thread(target=self._forward, daemon=True)
+        self._forwarder.start()
+        self._logger.info("Started.")
+
+    def stop(self) -> None:
+        """
+        Stops forwarding frames and the color detection of the process, which stays alive.
+        """
+        if not self._running:
+            self._logger.warning("Already stopped.")
+            return
+
+        self._running = False
+        if self._forwarder:
+            self._forwarder.join(timeout=1.0)
+            self._forwarder = None
+        self._stats_event.clear()
+        self._send(("stop",))
+        if not self._stats_event.wait(config.COLOR_DETECTION_PROCESS_TIMEOUT):
+            self._logger.warning("Detection process did not stop in time.")
+        self._logger.info("Stopped.")
+
+    def close(self) -> None:
+        """
+        Ends the detection process and frees the shared memory ring.
+        """
+        if self._closed:
+            return
+        if self._running:
+            self.stop()
+
+        self._closed = True
+        self._send(("close",))
+        self._process.join(config.COLOR_DETECTION_PROCESS_TIMEOUT)
+        if self._process.is_alive():
+            self._logger.warning("Detection process did not end in time, terminating it.")
+            self._process.terminate()
+            self._process.join()
+        self._conn.close()
+        self._listener.join(timeout=1.0)
+        self._ring.close()
+        self._logger.info("Closed.")
+
+    def set_callback(self, callback: Callable[[Position], None]) -> None:
+        """
+        Registers a callback function to be called once per confirmed object of the target color,
+        passing the mean Position of the frames the object was detected in.
+
+        It is called from the listener thread, one object at a time.
+
+        Args:
+            callback (Callable[[Position], None]): Callback function with position as parameter.
+        """
+        self._callback = callback
+
+    def set_coverage_callback(self, callback: Callable[[Position, float], None]) -> None:
+        """
+        Registers a callback function to be called with the ground footprint of the frames,
+        see ColorDetection.set_coverage_callback.
+
+        It is called from the listener thread, one footprint at a time.
+
+        Args:
+            callback (Callable[[Position, float], None]): Callback function with the ground centre and the
+            radius (in meters) of the footprint as parameters.
+        """
+        self._coverage_callback = callback
+
+    def get_frame_stats(self) -> Dict[str, int]:
+        """
+        Returns the number of frames analyzed by YOLO and of frames skipped before it,
+        as reported by the detection process when it last stopped.
+
+        Returns:
+            Dict[str, int]: "processed" and "skipped" frame counts.
+        """
+        return dict(self._stats)
+
+    def get_backend(self) -> str:
+        """
+        Returns the inference backend selected by the detection process.
+
+        Returns:
+            str: Backend name, empty until the process has loaded the model.
+        """
+        return self._backend
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _send(self, message: tuple) -> bool:
+        """
+        Sends a message to the detection process.
+
+        Args:
+            message (tuple): Message kind followed by its arguments.
+
+        Returns:
+            bool: False if the process is gone.
+        """
+        try:
+            with self._send_lock:
+                self._conn.send(message)
+            return True
+        except (OSError, ValueError):
+            self._logger.error("Detection process is gone.")
+            return False
+
+    def _forward(self) -> None:
+        """
+        Background thread sending the queued frames to the detection process.
+        """
+        while self._running:
+            try:
+                fwt = self._queue.get(timeout=0.1)
+            except Empty:
+                continue
+            self._process_frame(fwt)
+
+    def _process_frame(self, fwt: FrameWithTelemetry) -> None:
+        """
+        Copies a frame into the ring and sends its message to the detection process.
+
+        Args:
+            fwt (FrameWithTelemetry): Frame with telemetry to send.
+        """
+        frame = fwt.frame
+        if frame.jpeg is not None:
+            payload, shape, dtype = frame.jpeg, None, None
+        elif frame.data is not None:
+            payload, shape, dtype = frame.data.tobytes(), frame.data.shape, frame.data.dtype.str
+        else:
+            return
+
+        seq = self._ring.write(payload)
+        if seq is None:
+            metrics.inc("frames_dropped_total", "ring")
+            self._logger.warning("Frame %d of %d bytes does not fit in a ring slot, dropped.",
+                                 frame.frame_id, len(payload))
+            return
+        attributes = tuple(getattr(frame, name) for name in _FRAME_FIELDS)
+        self._send(("frame", seq, attributes, shape, dtype, fwt.telemetry, fwt.matched_us))
+
+    def _listen(self) -> None:
+        """
+        Background thread receiving the messages of the detection process.
+        """
+        while True:
+            try:
+                message = self._conn.recv()
+            except (EOFError, OSError):
+                break
+            kind = message[0]
+            if kind == "ready":
+                self._backend = message[1]
+                self._logger.info("Detection process ready, inference backend '%s'.", self._backend)
+            elif kind == "detected":
+                if self._callback:
+                    try:
+                        self._callback(message[1])
+                    except Exception as e:
+                        self._logger.error("Callback failed: %s", e)
+            elif kind == "covered":
+                if self._coverage_callback:
+                    try:
+                        self._coverage_callback(message[1], message[2])
+                    except Exception as e:
+                        self._logger.error("Coverage callback failed: %s", e)
+            elif kind == "stats":
+                self._stats = message[1]
+                self._stats_event.set()
+            elif kind == "failed":
+                self._logger.error("Detection process failed: %s", message[1])
+
+def _run(conn: Connection, ring_name: str, color: str, yolo_model_path: str) -> None:
+    """
+    Entry point of the detection process.
+
+    It creates the ColorDetection, then executes the messages of the ground station
+    process until asked to close or until the pipe is closed.
+
+    Args:
+        conn (Connection): Pipe end of the detection process.
+        ring_name (str): Name of the shared memory of the frame ring.
+        color (str): Name of the color to detect.
+        yolo_model_path (str): Path to the YOLO model file.
+    """
+    import numpy as np
+    from drone.color_detection import ColorDetection
+
+    logging.basicConfig(level=logging.INFO, format="[%(levelname)s] %(name)s: %(message)s")
+    logger = logging.getLogger("DetectionProcess")
+    send_lock = threading.Lock()
+
+    def send(message: tuple) -> None:
+        with send_lock:
+            conn.send(message)
+
+    try:
+        detector = ColorDetection(color, yolo_model_path)
+    except Exception as e:
+        send(("failed", str(e)))
+        conn.close()
+        return
+    detector.set_callback(lambda position: send(("detected", position)))
+    detector.set_coverage_callback(lambda position, radius: send(("covered", position, radius)))
+    ring = SharedFrameRing(config.COLOR_DETECTION_RING_SLOTS, config.COLOR_DETECTION_RING_SLOT_SIZE, name=ring_name)
+
+    def report_ready() -> None:
+        if detector.wait_ready():
+            send(("ready", detector.get_backend()))
+        else:
+            send(("failed", "YOLO model not loaded"))
+
+    # The models may still be loading, the messages are handled meanwhile
+    threading.Thread(target=report_ready, daemon=True).start()
+
+    lost = 0
+    running = False
+    try:
+        while True:
+            try:
+                message = conn.recv()
+            except (EOFError, OSError):
+                break
+            kind = message[0]
+            if kind == "frame":
+                _, seq, attributes, shape, dtype, telemetry, matched_us = message
+                payload = ring.read(seq)
+                if payload is None:
+                    lost += 1
+                    logger.debug("Frame %d overwritten in the ring, %d lost.", seq, lost)
+                    continue
+                frame_fields = dict(zip(_FRAME_FIELDS, attributes))
+                if shape is None:
+                    frame = Frame(jpeg=payload, **frame_fields)
+                else:
+                    frame = Frame(data=np.frombuffer(payload, dtype).reshape(shape), **frame_fields)
+                detector.enqueue(FrameWithTelemetry(frame, telemetry, matched_us))
+            elif kind == "start" and not running:
+                running = True
+                detector.start()
+            elif kind == "stop":
+                if running:
+                    running = False
+                    detector.stop()
+                send(("stats", detector.get_frame_stats()))
+            elif kind == "close":
+                break
+    finally:
+        if running:
+            detector.stop()
+        ring.close()
+        conn.close()
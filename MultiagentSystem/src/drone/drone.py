@@ -1,10 +1,17 @@
 import logging
-from typing import Dict, List, Optional
+import threading
+from time import monotonic
+from typing import Callable, Dict, List, Optional, Tuple, Union
+
+from configuration import drone as config
 
 from interfaces.interfaces import ICamera, ITelemetry, ARobot
 from drone.matcher import Matcher
-from drone.color_detection import ColorDetection
+from drone.color_detection import ColorDetection, DetectionChannel
+from drone.detection_process import DetectionProcess
 from drone.viewer import Viewer
+from drone.flight_recorder import FlightRecorder
+from drone.speed_governor import SpeedGovernor
 from structures.structures import Position, Point2D
 
 class Drone(ARobot):
@@ -20,12 +27,21 @@ class Drone(ARobot):
     routine, as well as to notify user-defined callbacks when relevant
     events occur, such as the detection of points of interest or the
     completion of the exploration routine.
+
+    The subcomponents are started and stopped concurrently, within
+    DRONE_ROUTINE_TIMEOUT. With DRONE_KEEP_WARM, the telemetry and the
+    camera are only paused between routines, so back-to-back routines
+    start immediately; shutdown stops them. With SPEED_GOVERNOR_ENABLED,
+    the ground speed is limited to what the color detection keeps up
+    with during the routines (see SpeedGovernor).
     """
 
     def __init__(self,
                  telemetry: ITelemetry,
                  camera: ICamera,
-                 color_detection: ColorDetection
+                 color_detection: Union[ColorDetection, DetectionChannel, DetectionProcess],
+                 show_viewer: bool = True,
+                 recorder: Optional[FlightRecorder] = None
                  ) -> None:
         """
         Creates a Drone instance.
@@ -37,22 +53,35 @@ class Drone(ARobot):
         Args:
             telemetry (ITelemetry): Telemetry provider used to obtain the drone state.
             camera (ICamera): Camera provider used to capture image frames.
-            color_detection (ColorDetection): Module responsible for visual color detection.
+            color_detection (Union[ColorDetection, DetectionChannel, DetectionProcess]): Module responsible for visual
+                color detection, in this process or in its own, or a channel of a ColorDetection shared with other drones.
+            show_viewer (bool): Whether to show the live video window, False for headless runs.
+            recorder (Optional[FlightRecorder]): Recorder of the frames and telemetry of each routine, if any.
         """
         self._telemetry = telemetry
         self._camera = camera
         self._matcher = Matcher(self._telemetry, self._camera)
         self._color_detection = color_detection
-        self._viewer = Viewer()
+        self._viewer: Optional[Viewer] = Viewer() if show_viewer else None
 
         self._detected_points: List[Point2D] = []
         self._active: bool = False
+        self._warm: bool = False
 
         self._logger = logging.getLogger("Drone")
 
         self._color_detection.set_callback(self._on_color_detected)
+        self._color_detection.set_coverage_callback(self._on_coverage)
         self._matcher.register_consumer(self._color_detection)
-        self._matcher.register_consumer(self._viewer)
+        if self._viewer:
+            self._matcher.register_consumer(self._viewer)
+        self._recorder: Optional[FlightRecorder] = recorder
+        if self._recorder:
+            self._matcher.register_consumer(self._recorder)
+        # The frame counts of a DetectionProcess are only reported when it stops
+        self._governor: Optional[SpeedGovernor] = \
+            SpeedGovernor(self._telemetry, self._color_detection.get_frame_stats, self._telemetry.set_speed_limit) \
+            if config.SPEED_GOVERNOR_ENABLED and not isinstance(color_detection, DetectionProcess) else None
 
     # ---------------------------------------------------
     # Public methods
@@ -61,9 +90,11 @@ class Drone(ARobot):
         """
         Starts the exploration routine.
 
-        This method initializes and starts all the system subcomponents in
-        a coordinated manner: telemetry acquisition, camera capture, frame/
-        telemetry synchronization, visual color detection, and visualization.
+        This method initializes and starts all the system subcomponents
+        concurrently: telemetry acquisition, camera capture, frame/
+        telemetry synchronization, visual color detection, visualization and,
+        if a recorder is set, recording. The telemetry and the camera are
+        resumed if they were kept warm by the last routine.
 
         Before starting, the list of detected points is cleared.
         """
@@ -73,11 +104,20 @@ class Drone(ARobot):
 
         self._active = True
         self._detected_points.clear()
-        self._telemetry.start()
-        self._camera.start()
-        self._matcher.start()
-        self._color_detection.start()
-        self._viewer.start()
+        steps = [
+            ("telemetry", self._telemetry.resume if self._warm else self._telemetry.start),
+            ("camera", self._camera.resume if self._warm else self._camera.start),
+            ("matcher", self._matcher.start),
+            ("color detection", self._color_detection.start),
+        ]
+        if self._viewer:
+            steps.append(("viewer", self._viewer.start))
+        if self._recorder:
+            steps.append(("recorder", self._recorder.start))
+        if self._governor:
+            steps.append(("speed governor", self._governor.start))
+        self._warm = False
+        self._run_concurrently(steps)
 
         self._logger.info("Started.")
 
@@ -85,9 +125,10 @@ class Drone(ARobot):
         """
         Stops the exploration routine and all associated subcomponents.
 
-        The subsystems are stopped in an orderly manner. Once the routine
-        finishes, the user-defined completion callback is invoked, if it
-        has been registered.
+        The subsystems are stopped concurrently, the telemetry and the camera
+        being only paused with DRONE_KEEP_WARM. Once the routine finishes,
+        the user-defined completion callback is invoked, if it has been
+        registered.
 
         Returns:
             List[Point2D]: Detected 2D points during the exploration routine.
@@ -97,11 +138,20 @@ class Drone(ARobot):
             return []
 
         self._active = False
-        self._viewer.stop()
-        self._color_detection.stop()
-        self._matcher.stop()
-        self._camera.stop()
-        self._telemetry.stop()
+        self._warm = config.DRONE_KEEP_WARM
+        steps = [
+            ("color detection", self._color_detection.stop),
+            ("matcher", self._matcher.stop),
+            ("camera", self._camera.pause if self._warm else self._camera.stop),
+            ("telemetry", self._telemetry.pause if self._warm else self._telemetry.stop),
+        ]
+        if self._viewer:
+            steps.append(("viewer", self._viewer.stop))
+        if self._recorder:
+            steps.append(("recorder", self._recorder.stop))
+        if self._governor:
+            steps.append(("speed governor", self._governor.stop))
+        self._run_concurrently(steps)
 
         if self._callback_onFinish:
             try:
@@ -112,6 +162,19 @@ class Drone(ARobot):
         self._logger.info("Stopped.")
         return self._detected_points.copy()
 
+    def shutdown(self) -> None:
+        """
+        Stops the telemetry and the camera kept warm between routines, stopping the routine first if it runs.
+        """
+        if self._active:
+            self.stop_routine()
+        if not self._warm:
+            return
+
+        self._warm = False
+        self._run_concurrently([("telemetry", self._telemetry.stop), ("camera", self._camera.stop)])
+        self._logger.info("Shut down.")
+
     def get_current_position(self) -> Optional[Point2D]:
         """
         Returns the current 2D position of the drone.
@@ -130,8 +193,20 @@ class Drone(ARobot):
     
     def get_telemetry(self) -> Optional[Dict[str, float]]:
         """
-        Retrieves the current telemetry data of the drone (no-op).
+        Retrieves the battery status of the drone, from the latest received telemetry.
+
+        Returns:
+            Optional[Dict[str, float]]: Battery "voltage" (in volts), "charge" (in percent) and
+            "remaining_time" (in seconds, negative if not measured), or None if unavailable.
         """
+        try:
+            telemetry = self._telemetry.get_telemetry()
+            if telemetry:
+                battery = telemetry.battery
+                return {"voltage": battery.voltage, "charge": battery.charge,
+                        "remaining_time": battery.remaining_time}
+        except Exception as e:
+            self._logger.error("Failed to get telemetry: %s", e)
         return None
 
     def get_detected_points(self) -> List[Point2D]:
@@ -146,6 +221,33 @@ class Drone(ARobot):
     # ---------------------------------------------------
     # Private methods
     # ---------------------------------------------------
+    def _run_concurrently(self, steps: List[Tuple[str, Callable[[], None]]]) -> None:
+        """
+        Runs start or stop steps of the subcomponents in parallel threads, waiting for all of them
+        until a shared deadline DRONE_ROUTINE_TIMEOUT away.
+
+        Steps still running at the deadline are left to finish in the background, with a warning,
+        so that one slow subcomponent does not hold the mission transition.
+
+        Args:
+            steps (List[Tuple[str, Callable[[], None]]]): Name and function of each step.
+        """
+        def run(name: str, step: Callable[[], None]) -> None:
+            try:
+                step()
+            except Exception as e:
+                self._logger.error("Failed to run %s step: %s", name, e)
+
+        threads = [(name, threading.Thread(target=run, args=(name, step), daemon=True)) for name, step in steps]
+        for _, thread in threads:
+            thread.start()
+
+        deadline = monotonic() + config.DRONE_ROUTINE_TIMEOUT
+        for name, thread in threads:
+            thread.join(timeout=max(deadline - monotonic(), 0.0))
+            if thread.is_alive():
+                self._logger.warning("%s step did not finish in %.1f s.", name.capitalize(), config.DRONE_ROUTINE_TIMEOUT)
+
     def _on_color_detected(self, position: Position) -> None:
         """
         Internal callback invoked when a target-colored object is detected.
@@ -178,3 +280,18 @@ class Drone(ARobot):
                 self._callback_onPoint(Point2D(position.x, position.y))
             except Exception as e:
                 self._logger.error("Callback onPoint failed: %s", e)
+
+    def _on_coverage(self, position: Position, radius: float) -> None:
+        """
+        Internal callback invoked with the ground footprint of every frame the ColorDetection
+        module analyzes, passed on to the coverage callback while the routine runs.
+
+        Args:
+            position (Position): Ground point at the centre of the footprint.
+            radius (float): Footprint radius (in meters).
+        """
+        if self._active and self._callback_onCoverage:
+            try:
+                self._callback_onCoverage(Point2D(position.x, position.y), radius)
+            except Exception as e:
+                self._logger.error("Callback onCoverage failed: %s", e)
@@ -0,0 +1,261 @@
+from configuration import drone_telemetry as config
+import threading
+import logging
+import struct
+from dataclasses import replace
+from typing import Dict, Optional
+
+from drone.crtp_log_client import CrtpLogClient
+from interfaces.interfaces import ITelemetry, IMovementSimulator
+from structures.structures import Battery, Position, Velocity, Acceleration, Orientation, Pose, TelemetryData
+
+class DroneLogTelemetry(ITelemetry):
+    """
+    Telemetry of a drone read from its CRTP log subsystem.
+
+    Unlike DroneTelemetry, no bespoke telemetry packets are involved: the
+    variables listed in LOG_BLOCKS, with the period of each block, are
+    subscribed through a CrtpLogClient and mapped to the telemetry fields
+    with LOG_TELEMETRY_FIELDS. Any logged variable can be picked at any rate
+    by editing the configuration, without rebuilding the firmware.
+
+    The log blocks carry a millisecond timestamp but no sequence number, so
+    lost packets are estimated from the gaps between block timestamps.
+    Optionally, a movement simulator can override x/y coordinates.
+
+    Speed limits are commanded to the high-level commander of the drone
+    over the same CRTP link.
+    """
+
+    _PORT_SETPOINT_HL = 0x08
+    _COMMAND_SET_SPEED_LIMIT = 13
+    _ALL_GROUPS = 0
+
+    def __init__(self,
+                 drone_ip: str,
+                 drone_port: int,
+                 local_port: int,
+                 simulator: Optional[IMovementSimulator] = None) -> None:
+        """
+        Creates a DroneLogTelemetry instance.
+
+        The instance starts with default telemetry (position 0,0,0 and voltage 0V).
+        Log blocks are subscribed by calling start().
+
+        Args:
+            drone_ip (str): IP address of the drone.
+            drone_port (int): UDP port of the drone CRTP link.
+            local_port (int): Local UDP port to receive the log packets on.
+            simulator (Optional[IMovementSimulator]): Optional simulator to provide x/y drone coordinates.
+        """
+        self._client: CrtpLogClient = CrtpLogClient(drone_ip, drone_port, local_port)
+        self._simulator: Optional[IMovementSimulator] = simulator
+
+        self._telemetry: TelemetryData = TelemetryData(
+            pose=Pose(
+                position=Position(0, 0, 0),
+                orientation=Orientation(0, 0, 0)
+            ),
+            battery=Battery(voltage=0)
+        )
+        self._values: Dict[str, float] = {}
+
+        self._block_periods: Dict[int, int] = {}
+        self._last_timestamps: Dict[int, int] = {}
+        self._lost_packets: int = 0
+
+        self._lock: threading.Lock = threading.Lock()
+        self._running: bool = False
+
+        self._logger: logging.Logger = logging.getLogger("DroneLogTelemetry")
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def start(self) -> None:
+        """
+        Starts the log client and subscribes the configured log blocks.
+
+        Blocks the drone refuses, or whose variables are not logged by the
+        running firmware, are skipped with an error.
+        """
+        if self._running:
+            self._logger.warning("Already running.")
+            return
+
+        self._running = True
+        if self._simulator:
+            self._simulator.start()
+        self._client.start()
+
+        try:
+            self._client.fetch_toc()
+        except TimeoutError as e:
+            self._logger.error("Failed to download the log TOC: %s", e)
+            return
+
+        for period_ms, names in config.LOG_BLOCKS:
+            try:
+                block_id = self._client.add_block(list(names), period_ms, self._make_callback(period_ms))
+            except (KeyError, ValueError, RuntimeError, TimeoutError) as e:
+                self._logger.error("Failed to subscribe %s: %s", ", ".join(names), e)
+                continue
+            self._block_periods[block_id] = period_ms
+        self._logger.info("Started.")
+
+    def stop(self) -> None:
+        """
+        Stops the log client. No telemetry internal state is updated.
+        """
+        if not self._running:
+            self._logger.warning("Already stopped.")
+            return
+
+        self._running = False
+        if self._simulator:
+            self._simulator.stop()
+        self._client.stop()
+        self._block_periods.clear()
+        self._last_timestamps.clear()
+        self._logger.info("Stopped.")
+
+    def pause(self) -> None:
+        """
+        Pauses the telemetry between routines, keeping the log client and its subscribed log blocks: only the movement simulator,
+        if any, is stopped.
+        """
+        if not self._running:
+            self._logger.warning("Not running.")
+            return
+
+        if self._simulator:
+            self._simulator.stop()
+        self._logger.info("Paused.")
+
+    def resume(self) -> None:
+        """
+        Resumes the telemetry after pause, or starts it if it is stopped.
+        """
+        if not self._running:
+            self.start()
+            return
+
+        if self._simulator:
+            self._simulator.start()
+        self._logger.info("Resumed.")
+
+    def get_telemetry(self) -> TelemetryData:
+        """
+        Returns the latest telemetry data.
+
+        If a simulator is active, the x/y coordinates are replaced with simulated
+        values while z and orientation remain from the last received packet.
+
+        Returns:
+            TelemetryData: Latest immutable telemetry snapshot, shared and not copied.
+        """
+        telemetry = self._telemetry
+
+        if self._simulator and getattr(self._simulator, "_active", False):
+            xy = self._simulator.get_xy()
+            if xy is not None:
+                telemetry = replace(
+                    telemetry,
+                    pose=Pose(
+                        position=Position(xy.x, xy.y, telemetry.pose.position.z),
+                        orientation=telemetry.pose.orientation
+                    )
+                )
+        return telemetry
+
+    def set_speed_limit(self, speed: float) -> None:
+        """
+        Limits the speed of the coverage trajectories flown by the high-level commander
+        of the drone, and of the movement simulator, if any.
+
+        Args:
+            speed (float): Largest ground speed (in m/s), 0 to lift the limit.
+        """
+        if self._simulator:
+            self._simulator.set_speed_limit(speed)
+        if self._running:
+            self._client.send(self._PORT_SETPOINT_HL, 0,
+                              struct.pack("<BBf", self._COMMAND_SET_SPEED_LIMIT, self._ALL_GROUPS, speed))
+
+    def get_lost_packets(self) -> int:
+        """
+        Returns the number of log packets estimated as lost.
+
+        Returns:
+            int: Total block periods missed since the listener was created.
+        """
+        return self._lost_packets
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _make_callback(self, period_ms: int):
+        """
+        Builds the callback of a log block.
+
+        Args:
+            period_ms (int): Block period, used to detect lost packets.
+
+        Returns:
+            Callable[[int, Dict[str, float]], None]: Block callback.
+        """
+        key = len(self._block_periods)
+
+        def callback(timestamp_ms: int, values: Dict[str, float]) -> None:
+            self._check_timestamp(key, period_ms, timestamp_ms)
+            self._update(timestamp_ms, values)
+
+        return callback
+
+    def _check_timestamp(self, key: int, period_ms: int, timestamp_ms: int) -> None:
+        """
+        Counts the block periods missed between two packets of a block.
+
+        Args:
+            key (int): Block key.
+            period_ms (int): Block period.
+            timestamp_ms (int): Drone timestamp of the packet, 24 bit milliseconds.
+        """
+        last = self._last_timestamps.get(key)
+        self._last_timestamps[key] = timestamp_ms
+        if last is None:
+            return
+
+        missed = round(((timestamp_ms - last) % (1 << 24)) / period_ms) - 1
+        if missed > 0:
+            self._lost_packets += missed
+            self._logger.debug("Lost %d packets of block %d", missed, key)
+
+    def _update(self, timestamp_ms: int, values: Dict[str, float]) -> None:
+        """
+        Updates internal telemetry with the values of a block packet.
+
+        Args:
+            timestamp_ms (int): Drone timestamp of the packet, in milliseconds.
+            values (Dict[str, float]): Values by variable name.
+        """
+        pose_update = False
+        with self._lock:
+            for name, value in values.items():
+                field = config.LOG_TELEMETRY_FIELDS.get(name)
+                if field:
+                    self._values[field] = value
+                    pose_update |= field != "voltage"
+
+            v = self._values
+            self._telemetry = TelemetryData(
+                pose=Pose(
+                    position=Position(v.get("x", 0), v.get("y", 0), v.get("z", 0)),
+                    orientation=Orientation(v.get("roll", 0), v.get("pitch", 0), v.get("yaw", 0))
+                ),
+                battery=Battery(voltage=v.get("voltage", 0)),
+                velocity=Velocity(v.get("vx", 0), v.get("vy", 0), v.get("vz", 0)),
+                acceleration=Acceleration(v.get("ax", 0), v.get("ay", 0), v.get("az", 0)),
+                timestamp_us=timestamp_ms * 1000 if pose_update else self._telemetry.timestamp_us
+            )
+        self._logger.debug("Updated telemetry: %s", values)
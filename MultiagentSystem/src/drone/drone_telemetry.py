@@ -1,14 +1,21 @@
 from configuration import drone_telemetry as config
+from configuration import clock_offset as clock_config
+import selectors
 import socket 
 import struct
 import threading
 import logging
-from copy import deepcopy
+import math
+from bisect import bisect_left
+from collections import deque
+from dataclasses import replace
 from time import sleep
-from typing import Optional
+from typing import Any, Callable, Deque, Dict, List, Optional, Tuple
 
 from interfaces.interfaces import ITelemetry, IMovementSimulator
-from structures.structures import Battery, Position, Orientation, Pose, TelemetryData
+from structures.structures import Battery, ClockEstimate, HotspotEvent, LoopTiming, Position, Velocity, Acceleration, Orientation, Pose, QueueFill, QueueLoad, StageTiming, SystemLoad, TaskLoad, TelemetryData, ThermalHotspot
+from utils.clock_offset import ClockOffset, local_time_us
+from utils import metrics
 
 class DroneTelemetry(ITelemetry):
     """
@@ -18,10 +25,36 @@ class DroneTelemetry(ITelemetry):
     the latest telemetry snapshot including position, orientation, and battery
     voltage. Optionally, a movement simulator can override x/y coordinates.
 
-    The listener runs in a background thread and updates internal telemetry safely. 
-    Two types of packets are processed:
+    The listener runs in a background thread and is the only writer of the telemetry.
+    Each update builds a new immutable snapshot and publishes it with a single reference
+    assignment, so readers get a consistent snapshot without locking or copying it. 
+    Every packet starts with a versioned header carrying the packet type, a
+    per-type sequence number and the drone timestamp. Sequence gaps are counted
+    as lost packets and late (reordered) packets are dropped.
+    Three types of packets are processed:
         - Battery packets: update voltage
-        - Pose packets: update position (x, y, z) and orientation (roll, pitch, yaw)
+        - Pose packets: update position (x, y, z), velocity, acceleration
+          and orientation (roll, pitch, yaw)
+        - Pose batch packets: several pose samples packed in one datagram,
+          applied in order
+        - Loop timing packets: stabilizer loop time histograms, a warning is
+          logged when the loop missed its deadline
+        - Task load packets: CPU load and stack headroom of the drone tasks,
+          the task list can span several packets
+        - Queue load packets: fill and overflows of the drone queues, the
+          queue list can span several packets, a warning is logged when a
+          queue overflowed
+        - Time sync packets: answers to the time sync requests the listener
+          sends every CLOCK_SYNC_PERIOD
+        - Hotspot packets: hot pixel groups the drone found in a frame of its
+          thermal array, with its pose, passed to the hotspot callback
+
+    The last pose samples are kept with their drone timestamps, and the packet
+    timestamps track the offset from the drone clock to the local clock, so that
+    the telemetry can be looked up at the capture time of a camera frame. The
+    offset and the drift between the clocks are refined by NTP-like time
+    exchanges: the drone stamps the receive time of each request and the send
+    time of its answer (see ClockOffset).
     """
 
     def __init__(self,
@@ -54,13 +87,40 @@ class DroneTelemetry(ITelemetry):
             battery=Battery(voltage=0)
         )
 
+        self._loop_timing: Optional[LoopTiming] = None
+        self._system_load: Optional[SystemLoad] = None
+        self._queue_load: Optional[QueueLoad] = None
+        self._hotspots: Optional[HotspotEvent] = None
+        self._hotspot_callback: Optional[Callable[[HotspotEvent], None]] = None
+        self._list_parts: Dict[int, Tuple[int, List[Any]]] = {}
+
+        self._pose_history: Deque[TelemetryData] = deque(maxlen=config.POSE_HISTORY_LENGTH)
+        self._clock: ClockOffset = ClockOffset()
+        self._next_sync_us: int = 0
+
+        self._last_seq: Dict[int, int] = {}
+        self._lost_packets: int = 0
+        self._rate_divisor: int = 1
+
         self._sock: Optional[socket.socket] = None
+        self._handlers: Dict[int, Callable[[memoryview, int], None]] = {
+            config.PACKET_ID_BATTERY: self._process_battery_packet,
+            config.PACKET_ID_POSE: self._process_pose_packet,
+            config.PACKET_ID_POSE_BATCH: self._process_pose_batch_packet,
+            config.PACKET_ID_LOOP_TIMING: self._process_loop_timing_packet,
+            config.PACKET_ID_TASK_LOAD: self._process_task_load_packet,
+            config.PACKET_ID_QUEUE_LOAD: self._process_queue_load_packet,
+            config.PACKET_ID_HOTSPOT: self._process_hotspot_packet,
+        }
     
         self._lock: threading.Lock = threading.Lock()
         self._running: bool = False
         self._thread: Optional[threading.Thread] = None
 
         self._logger: logging.Logger  = logging.getLogger("DroneTelemetry")
+
+        metrics.register_gauge("telemetry_lost_packets", "drone", self.get_lost_packets)
+        metrics.register_gauge("telemetry_rate_divisor", "drone", self.get_rate_divisor)
         
     # ----------------------------------------------------------------------
     # Public methods
@@ -112,31 +172,197 @@ class DroneTelemetry(ITelemetry):
 
         self._logger.info("Stopped.")
 
+    def pause(self) -> None:
+        """
+        Pauses the telemetry between routines, keeping the UDP link and its handshake: only the movement simulator,
+        if any, is stopped.
+        """
+        if not self._running:
+            self._logger.warning("Not running.")
+            return
+
+        if self._simulator:
+            self._simulator.stop()
+        self._logger.info("Paused.")
+
+    def resume(self) -> None:
+        """
+        Resumes the telemetry after pause, or starts it if it is stopped.
+        """
+        if not self._running:
+            self.start()
+            return
+
+        if self._simulator:
+            self._simulator.start()
+        self._logger.info("Resumed.")
+
     def get_telemetry(self) -> TelemetryData:
         """
-        Returns a copy of the latest telemetry data.
+        Returns the latest telemetry data.
 
         The returned telemetry includes position, orientation, and battery voltage.
         If a simulator is active, the x/y coordinates are replaced with simulated
         values while z and orientation remain from the last received packet.
 
         Returns:
-            TelemetryData: Thread-safe copy of the current telemetry.
+            TelemetryData: Latest immutable telemetry snapshot, shared and not copied.
+        """
+        return self._apply_simulator(self._telemetry)
+
+    def get_telemetry_at(self, host_time_us: int) -> TelemetryData:
+        """
+        Returns the telemetry at a past time, from the pose history.
+
+        The pose is interpolated between the two samples around that time, or the
+        nearest sample is used when they are too far apart or the time is out of the
+        history. The battery status is the latest one. The simulator override applies
+        as in get_telemetry().
+
+        Args:
+            host_time_us (int): Time on the ground station monotonic clock (in microseconds).
+
+        Returns:
+            TelemetryData: Telemetry at that time, or the current telemetry if no pose was received.
         """
+        drone_time_us = self._clock.to_remote(host_time_us)
+        battery = self._telemetry.battery
         with self._lock:
-            telemetry_copy = deepcopy(self._telemetry)
+            history = list(self._pose_history)
 
-        if self._simulator and getattr(self._simulator, "_active", False):
-            xy = self._simulator.get_xy()
-            if xy is not None:
-                telemetry_copy = TelemetryData(
-                    pose=Pose(
-                        position=Position(xy.x, xy.y, telemetry_copy.pose.position.z),
-                        orientation=deepcopy(telemetry_copy.pose.orientation)
-                    ),
-                    battery=deepcopy(telemetry_copy.battery)
-                )
-        return telemetry_copy
+        if drone_time_us is None or not history:
+            return self.get_telemetry()
+
+        telemetry = replace(self._interpolate_pose(history, drone_time_us), battery=battery)
+        return self._apply_simulator(telemetry)
+
+    def get_clock_estimate(self) -> Optional[ClockEstimate]:
+        """
+        Returns the mapping of the drone clock onto the ground station monotonic clock.
+
+        Returns:
+            Optional[ClockEstimate]: Offset, drift and error bound, None until the drone sends a packet.
+        """
+        return self._clock.get_estimate()
+
+    def set_speed_limit(self, speed: float) -> None:
+        """
+        Limits the speed of the movement simulator, if any. The telemetry link cannot command the drone.
+
+        Args:
+            speed (float): Largest ground speed (in m/s), 0 to lift the limit.
+        """
+        if self._simulator:
+            self._simulator.set_speed_limit(speed)
+
+    def get_lost_packets(self) -> int:
+        """
+        Returns the number of telemetry packets detected as lost.
+
+        Returns:
+            int: Total sequence gaps observed since the listener was created.
+        """
+        return self._lost_packets
+
+    def get_rate_divisor(self) -> int:
+        """
+        Returns the rate divisor the drone applies to the pose stream, raised when its link degrades.
+
+        Returns:
+            int: 1 at full rate, N when only 1 of every N poses is sent.
+        """
+        return self._rate_divisor
+
+    def get_loop_timing(self) -> Optional[LoopTiming]:
+        """
+        Returns the latest stabilizer loop timing of the drone.
+
+        Returns:
+            Optional[LoopTiming]: Last received loop timing, None until the drone sends one.
+        """
+        with self._lock:
+            return self._loop_timing
+
+    def get_system_load(self) -> Optional[SystemLoad]:
+        """
+        Returns the latest load of the drone tasks.
+
+        Returns:
+            Optional[SystemLoad]: Last complete task load, None until the drone sends one.
+        """
+        with self._lock:
+            return self._system_load
+
+    def get_queue_load(self) -> Optional[QueueLoad]:
+        """
+        Returns the latest fill of the drone queues.
+
+        Returns:
+            Optional[QueueLoad]: Last complete queue load, None until the drone sends one.
+        """
+        with self._lock:
+            return self._queue_load
+
+    def get_hotspots(self) -> Optional[HotspotEvent]:
+        """
+        Returns the latest thermal hotspots found by the drone.
+
+        Returns:
+            Optional[HotspotEvent]: Last received hotspot event, None until the drone sends one.
+        """
+        with self._lock:
+            return self._hotspots
+
+    def set_hotspot_callback(self, callback: Callable[[HotspotEvent], None]) -> None:
+        """
+        Registers a callback function to be called with every hotspot event.
+
+        It is called from the listener thread and should return quickly.
+
+        Args:
+            callback (Callable[[HotspotEvent], None]): Callback function with the event as parameter.
+        """
+        self._hotspot_callback = callback
+
+    def send_external_pose(self,
+                           position: Position,
+                           quaternion: Optional[Tuple[float, float, float, float]] = None,
+                           sample_us: Optional[int] = None) -> bool:
+        """
+        Sends an external position, or pose, measurement (e.g. motion capture or visual odometry) to the drone.
+
+        The drone enqueues it straight into its state estimator from the packet receiving task, rather than
+        routing it through its CRTP queues, and drops it if it is older than its locSrv.extMaxAge parameter.
+
+        Args:
+            position (Position): Measured position (in meters).
+            quaternion (Optional[Tuple[float, float, float, float]]): Measured orientation (x, y, z, w), None to send the position only.
+            sample_us (Optional[int]): Local time (in microseconds) the measurement was taken at, None if unknown.
+
+        Returns:
+            bool: True if the packet was sent.
+        """
+        if not self._sock:
+            return False
+
+        timestamp = 0
+        if sample_us is not None:
+            drone_us = self._clock.to_remote(sample_us)
+            if drone_us is not None:
+                timestamp = (drone_us & 0xFFFFFFFF) or 1
+        if quaternion is None:
+            packet = config.STRUCT_EXT_POSITION.pack(config.EXT_SAMPLE_HEADER, timestamp,
+                                                     position.x, position.y, position.z)
+        else:
+            packet = config.STRUCT_EXT_POSE.pack(config.EXT_SAMPLE_HEADER, timestamp,
+                                                 position.x, position.y, position.z,
+                                                 self._compress_quaternion(quaternion))
+        try:
+            self._sock.sendto(packet + bytes([sum(packet) & 0xFF]), (self._drone_ip, self._drone_port))
+            return True
+        except OSError as e:
+            self._logger.debug("Error sending external pose: %s", e)
+            return False
 
     # ----------------------------------------------------------------------
     # Private methods
@@ -153,10 +379,40 @@ class DroneTelemetry(ITelemetry):
         
         try:
             self._logger.info("Sending handshake to %s:%d", self._drone_ip, self._drone_port)
-            self._sock.sendto(config.HANDSHAKE_PACKET, (self._drone_ip, self._drone_port))
+            self._sock.sendto(self._build_handshake(), (self._drone_ip, self._drone_port))
         except Exception as e:
             self._logger.error("Error sending handshake: %s", e)
 
+    def _build_handshake(self) -> bytes:
+        """
+        Builds the handshake packet.
+
+        The handshake subscribes this listener to the drone telemetry. When a
+        rate divisor other than 1 is configured, it is appended to the
+        handshake so the drone only forwards 1 of every N pose packets.
+
+        Returns:
+            bytes: Handshake packet, including the trailing checksum byte.
+        """
+        if config.TELEMETRY_RATE_DIVISOR <= 1:
+            return config.HANDSHAKE_PACKET
+
+        payload = bytes([config.HANDSHAKE_HEADER, config.TELEMETRY_RATE_DIVISOR & 0xFF])
+        return payload + bytes([sum(payload) & 0xFF])
+
+    def _send_time_sync(self) -> None:
+        """
+        Sends a time sync request to the drone, stamped with the local send time.
+        """
+        if not self._sock:
+            return
+
+        request = config.STRUCT_TIME_SYNC_REQUEST.pack(config.TIME_SYNC_HEADER, local_time_us())
+        try:
+            self._sock.sendto(request + bytes([sum(request) & 0xFF]), (self._drone_ip, self._drone_port))
+        except OSError as e:
+            self._logger.debug("Error sending time sync request: %s", e)
+
     def _start_communication(self) -> None:
         """
         Initializes the UDP socket and perform handshake.
@@ -166,7 +422,11 @@ class DroneTelemetry(ITelemetry):
         """
         self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
         self._sock.bind(("0.0.0.0", self._local_port))
-        self._sock.settimeout(config.DRONE_UDP_TIMEOUT)
+        try:
+            self._sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, config.DRONE_UDP_RCVBUF_SIZE)
+        except OSError as e:
+            self._logger.warning("Could not set the receive buffer size: %s", e)
+        self._sock.setblocking(False)
         self._logger.info("Listening UDP on port %d...", self._local_port)
 
         for _ in range(config.DRONE_UDP_HANDSHAKE_RETRIES):
@@ -176,15 +436,46 @@ class DroneTelemetry(ITelemetry):
             except Exception:
                 pass
 
-    def _process_battery_packet(self, payload: bytes) -> None:
+    def _check_sequence(self, packet_type: int, seq: int) -> bool:
+        """
+        Checks a packet sequence number against the last one of its type.
+
+        Gaps are accumulated as lost packets. Duplicated or reordered packets
+        (older than the last accepted one) are rejected.
+
+        Args:
+            packet_type (int): Packet type identifier.
+            seq (int): Packet sequence number.
+
+        Returns:
+            bool: True if the packet is newer than the last accepted one.
+        """
+        last = self._last_seq.get(packet_type)
+        self._last_seq.setdefault(packet_type, seq)
+        if last is None:
+            return True
+
+        delta = (seq - last) % config.SEQUENCE_MODULO
+        if delta == 0 or delta >= config.SEQUENCE_MODULO // 2:
+            self._logger.debug("Dropped late packet type %d seq %d (last %d)", packet_type, seq, last)
+            return False
+
+        if delta > 1:
+            self._lost_packets += delta - 1
+            self._logger.debug("Lost %d packets of type %d", delta - 1, packet_type)
+        self._last_seq[packet_type] = seq
+        return True
+
+    def _process_battery_packet(self, payload: bytes, timestamp_us: int) -> None:
         """
         Processes a battery packet.
 
-        Extracts voltage from the payload and updates internal telemetry
-        in a thread-safe manner.
+        Extracts voltage, and the battery model when the drone sends it, from
+        the payload and updates internal telemetry in a thread-safe manner.
 
         Args:
             payload (bytes): Raw UDP payload of the battery packet.
+            timestamp_us (int): Drone timestamp of the packet (in microseconds).
         """
         if len(payload) < config.STRUCT_BATTERY.size:
             self._logger.warning(
@@ -195,22 +486,31 @@ class DroneTelemetry(ITelemetry):
             return
 
         (voltage,) = config.STRUCT_BATTERY.unpack_from(payload)
-        with self._lock:
-            self._telemetry = TelemetryData(
-                pose=deepcopy(self._telemetry.pose),
-                battery=Battery(voltage=voltage)
+        battery = Battery(voltage=voltage)
+        if len(payload) >= config.STRUCT_BATTERY.size + config.STRUCT_BATTERY_MODEL.size:
+            compensated_voltage, charge, remaining_time = config.STRUCT_BATTERY_MODEL.unpack_from(
+                payload, config.STRUCT_BATTERY.size
             )
+            battery = Battery(
+                voltage=voltage,
+                compensated_voltage=compensated_voltage,
+                charge=charge,
+                remaining_time=remaining_time
+            )
+        self._telemetry = replace(self._telemetry, battery=battery)
         self._logger.debug("Updated battery: %.2f V", voltage)
 
-    def _process_pose_packet(self, payload: bytes) -> None:
+    def _process_pose_packet(self, payload: bytes, timestamp_us: int) -> None:
         """
         Processes a pose packet.
 
-        Extracts position (x, y, z) and orientation (roll, pitch, yaw) from
-        the payload and updates internal telemetry in a thread-safe way.
+        Extracts position (x, y, z), velocity, acceleration and orientation
+        (roll, pitch, yaw) from the payload and updates internal telemetry
+        in a thread-safe way.
 
         Args:
             payload (bytes): Raw UDP payload of the pose packet.
+            timestamp_us (int): Drone timestamp of the pose sample (in microseconds).
         """
         if len(payload) < config.STRUCT_POSE.size:
             self._logger.warning(
@@ -220,48 +520,460 @@ class DroneTelemetry(ITelemetry):
             )
             return
         
-        x, y, z, roll, pitch, yaw = config.STRUCT_POSE.unpack_from(payload)
+        self._update_pose(config.STRUCT_POSE.unpack_from(payload), timestamp_us)
+
+    def _process_pose_batch_packet(self, payload: bytes, timestamp_us: int) -> None:
+        """
+        Processes a pose batch packet.
+
+        Unpacks every pose record of the batch and applies them in order, so
+        the internal telemetry ends up holding the most recent sample.
+
+        Args:
+            payload (bytes): Raw UDP payload of the pose batch packet.
+            timestamp_us (int): Drone timestamp of the first sample of the batch (in microseconds).
+        """
+        if len(payload) < config.STRUCT_BATCH_COUNT.size:
+            self._logger.warning("Pose batch payload too short (%d bytes)", len(payload))
+            return
+
+        (count,) = config.STRUCT_BATCH_COUNT.unpack_from(payload)
+        expected = config.STRUCT_BATCH_COUNT.size + count * config.STRUCT_POSE_RECORD.size
+        if len(payload) < expected:
+            self._logger.warning(
+                "Pose batch payload too short (%d bytes, expected %d)",
+                len(payload),
+                expected
+            )
+            return
+
+        for record in config.STRUCT_POSE_RECORD.iter_unpack(payload[config.STRUCT_BATCH_COUNT.size:expected]):
+            self._update_pose(record[1:], timestamp_us + record[0])
+
+    def _process_loop_timing_packet(self, payload: bytes, timestamp_us: int) -> None:
+        """
+        Processes a loop timing packet.
+
+        Unpacks the histogram of every stabilizer loop stage and logs a
+        warning when iterations overran the loop period since the last packet.
+
+        Args:
+            payload (bytes): Raw UDP payload of the loop timing packet.
+            timestamp_us (int): Drone timestamp of the packet (in microseconds).
+        """
+        expected = len(config.LOOP_TIMING_STAGES) * config.STRUCT_STAGE_TIMING.size
+        if len(payload) < expected:
+            self._logger.warning(
+                "Loop timing payload too short (%d bytes, expected %d)",
+                len(payload),
+                expected
+            )
+            return
+
+        stages = {}
+        for name, values in zip(config.LOOP_TIMING_STAGES,
+                                config.STRUCT_STAGE_TIMING.iter_unpack(payload[:expected])):
+            stages[name] = StageTiming(bins=values[:-1], max_us=values[-1])
+
+        with self._lock:
+            self._loop_timing = LoopTiming(stages=stages, timestamp_us=timestamp_us)
+
+        loop = stages["loop"]
+        if loop.bins[-1] > 0:
+            self._logger.warning("Stabilizer loop missed %d deadlines (longest %d us)", loop.bins[-1], loop.max_us)
+
+    def _process_task_load_packet(self, payload: bytes, timestamp_us: int) -> None:
+        """
+        Processes a task load packet.
+
+        The packets of one measurement share its timestamp and carry
+        consecutive parts of the task list. The load is published once every
+        part has been received, a measurement with a lost part is discarded.
+
+        Args:
+            payload (bytes): Raw UDP payload of the task load packet.
+            timestamp_us (int): Drone time the load was measured (in microseconds).
+        """
+        if len(payload) < config.STRUCT_TASK_LOAD.size:
+            self._logger.warning("Task load payload too short (%d bytes)", len(payload))
+            return
+
+        first, count, total, free_heap, min_free_heap = config.STRUCT_TASK_LOAD.unpack_from(payload)
+        expected = config.STRUCT_TASK_LOAD.size + count * config.STRUCT_TASK_LOAD_RECORD.size
+        if len(payload) < expected:
+            self._logger.warning(
+                "Task load payload too short (%d bytes, expected %d)",
+                len(payload),
+                expected
+            )
+            return
+
+        records = [
+            TaskLoad(
+                name=self._decode_name(name),
+                load_percent=load / 100.0,
+                stack_left=stack_left,
+                priority=priority
+            )
+            for name, load, stack_left, priority in config.STRUCT_TASK_LOAD_RECORD.iter_unpack(
+                payload[config.STRUCT_TASK_LOAD.size:expected])
+        ]
+        tasks = self._collect_list_part(config.PACKET_ID_TASK_LOAD, timestamp_us, first, total, records)
+        if tasks is None:
+            return
+
+        with self._lock:
+            self._system_load = SystemLoad(
+                tasks={task.name: task for task in tasks},
+                free_heap=free_heap,
+                min_free_heap=min_free_heap,
+                timestamp_us=timestamp_us
+            )
+
+    def _process_queue_load_packet(self, payload: bytes, timestamp_us: int) -> None:
+        """
+        Processes a queue load packet.
+
+        The packets of one measurement share its timestamp and carry
+        consecutive parts of the queue list, the load is published once every
+        part has been received. A warning is logged for every queue that
+        dropped items.
+
+        Args:
+            payload (bytes): Raw UDP payload of the queue load packet.
+            timestamp_us (int): Drone time at the end of the measured second (in microseconds).
+        """
+        if len(payload) < config.STRUCT_QUEUE_LOAD.size:
+            self._logger.warning("Queue load payload too short (%d bytes)", len(payload))
+            return
+
+        first, count, total = config.STRUCT_QUEUE_LOAD.unpack_from(payload)
+        expected = config.STRUCT_QUEUE_LOAD.size + count * config.STRUCT_QUEUE_LOAD_RECORD.size
+        if len(payload) < expected:
+            self._logger.warning(
+                "Queue load payload too short (%d bytes, expected %d)",
+                len(payload),
+                expected
+            )
+            return
+
+        records = [
+            QueueFill(name=self._decode_name(name), length=length, sent=sent, peak=peak, full=full)
+            for name, length, sent, peak, full in config.STRUCT_QUEUE_LOAD_RECORD.iter_unpack(
+                payload[config.STRUCT_QUEUE_LOAD.size:expected])
+        ]
+        for queue in records:
+            if queue.full > 0:
+                self._logger.warning("Drone queue %s dropped %d items (length %d)", queue.name, queue.full, queue.length)
+
+        queues = self._collect_list_part(config.PACKET_ID_QUEUE_LOAD, timestamp_us, first, total, records)
+        if queues is None:
+            return
+
         with self._lock:
-            self._telemetry = TelemetryData(
-                pose=Pose(
-                    position=Position(x, y, z),
-                    orientation=Orientation(roll, pitch, yaw)
-                ),
-                battery=deepcopy(self._telemetry.battery)
+            self._queue_load = QueueLoad(
+                queues={queue.name: queue for queue in queues},
+                timestamp_us=timestamp_us
             )
-        self._logger.debug("Updated pose: %s", self._telemetry.pose)
+
+    def _process_hotspot_packet(self, payload: bytes, timestamp_us: int) -> None:
+        """
+        Processes a thermal hotspot packet.
+
+        Args:
+            payload (bytes): Raw UDP payload of the hotspot packet.
+            timestamp_us (int): Drone time the thermal frame was read (in microseconds).
+        """
+        if len(payload) < config.STRUCT_HOTSPOT.size:
+            self._logger.warning("Hotspot payload too short (%d bytes)", len(payload))
+            return
+
+        x, y, z, roll, pitch, yaw, background, count = config.STRUCT_HOTSPOT.unpack_from(payload)
+        expected = config.STRUCT_HOTSPOT.size + count * config.STRUCT_HOTSPOT_RECORD.size
+        if len(payload) < expected:
+            self._logger.warning(
+                "Hotspot payload too short (%d bytes, expected %d)",
+                len(payload),
+                expected
+            )
+            return
+
+        event = HotspotEvent(
+            pose=Pose(position=Position(x, y, z), orientation=Orientation(roll, pitch, yaw)),
+            background_celsius=background / 4.0,
+            hotspots=tuple(
+                ThermalHotspot(column=column / 16.0, row=row / 16.0, pixels=pixels, peak_celsius=peak / 4.0)
+                for column, row, pixels, peak in config.STRUCT_HOTSPOT_RECORD.iter_unpack(
+                    payload[config.STRUCT_HOTSPOT.size:expected])
+            ),
+            timestamp_us=timestamp_us
+        )
+        with self._lock:
+            self._hotspots = event
+        self._logger.debug("Thermal hotspots: %s", event.hotspots)
+
+        if self._hotspot_callback:
+            try:
+                self._hotspot_callback(event)
+            except Exception as e:
+                self._logger.error("Hotspot callback failed: %s", e)
+
+    def _collect_list_part(self,
+                           packet_type: int,
+                           timestamp_us: int,
+                           first: int,
+                           total: int,
+                           records: List[Any]) -> Optional[List[Any]]:
+        """
+        Collects one part of a list split over several packets.
+
+        The parts of one list share the packet timestamp and arrive in order.
+        A list with a lost part is discarded.
+
+        Args:
+            packet_type (int): Packet type identifier.
+            timestamp_us (int): Drone timestamp of the list (in microseconds).
+            first (int): Index of the first record of the part in the list.
+            total (int): Number of records of the list.
+            records (List[Any]): Records of the part.
+
+        Returns:
+            Optional[List[Any]]: The whole list once its last part is collected, None otherwise.
+        """
+        list_timestamp_us, parts = self._list_parts.get(packet_type, (-1, []))
+        if first == 0 or timestamp_us != list_timestamp_us:
+            parts = []
+        if first != len(parts):
+            return None
+
+        parts = parts + records
+        if len(parts) >= total:
+            self._list_parts.pop(packet_type, None)
+            return parts
+        self._list_parts[packet_type] = (timestamp_us, parts)
+        return None
+
+    @staticmethod
+    def _compress_quaternion(quaternion: Tuple[float, float, float, float]) -> int:
+        """
+        Compresses a quaternion as the drone quatcompress does: the index of its largest element,
+        then the sign and 9 bit magnitude of the three others.
+
+        Args:
+            quaternion (Tuple[float, float, float, float]): Orientation (x, y, z, w).
+
+        Returns:
+            int: Compressed quaternion.
+        """
+        norm = math.sqrt(sum(q * q for q in quaternion)) or 1.0
+        q = [v / norm for v in quaternion]
+        largest = max(range(4), key=lambda i: abs(q[i]))
+        negate = q[largest] < 0
+        compressed = largest
+        for i in range(4):
+            if i != largest:
+                negative = (q[i] < 0) != negate
+                magnitude = min(511, int(511 * abs(q[i]) / math.sqrt(0.5) + 0.5))
+                compressed = (compressed << 10) | (negative << 9) | magnitude
+        return compressed
+
+    @staticmethod
+    def _decode_name(name: bytes) -> str:
+        """
+        Decodes a null terminated name of a packet record.
+
+        Args:
+            name (bytes): Fixed size name field.
+
+        Returns:
+            str: Name up to its terminator.
+        """
+        return name.split(b"\0", 1)[0].decode("ascii", "replace")
+
+    def _apply_simulator(self, telemetry: TelemetryData) -> TelemetryData:
+        """
+        Replaces the x/y coordinates with the simulated ones if a simulator is active.
+
+        Args:
+            telemetry (TelemetryData): Telemetry to update.
+
+        Returns:
+            TelemetryData: Telemetry with the simulated x/y coordinates, or unchanged.
+        """
+        if self._simulator and getattr(self._simulator, "_active", False):
+            xy = self._simulator.get_xy()
+            if xy is not None:
+                telemetry = replace(
+                    telemetry,
+                    pose=Pose(
+                        position=Position(xy.x, xy.y, telemetry.pose.position.z),
+                        orientation=telemetry.pose.orientation
+                    )
+                )
+        return telemetry
+
+    @staticmethod
+    def _interpolate_pose(history: List[TelemetryData], timestamp_us: int) -> TelemetryData:
+        """
+        Interpolates the pose history at a drone time.
+
+        Args:
+            history (List[TelemetryData]): Pose samples ordered by timestamp.
+            timestamp_us (int): Drone time (in microseconds).
+
+        Returns:
+            TelemetryData: Interpolated telemetry, or the nearest sample.
+        """
+        i = bisect_left([sample.timestamp_us for sample in history], timestamp_us)
+        if i == 0:
+            return history[0]
+        if i == len(history):
+            return history[-1]
+
+        before, after = history[i - 1], history[i]
+        gap = after.timestamp_us - before.timestamp_us
+        if gap <= 0 or gap > config.POSE_INTERPOLATION_MAX_GAP_US:
+            return before if timestamp_us - before.timestamp_us <= after.timestamp_us - timestamp_us else after
+
+        w = (timestamp_us - before.timestamp_us) / gap
+
+        def lerp(a: float, b: float) -> float:
+            return a + (b - a) * w
+
+        def lerp_angle(a: float, b: float) -> float:
+            angle = a + ((b - a + 180) % 360 - 180) * w
+            return (angle + 180) % 360 - 180
+
+        p0, p1 = before.pose.position, after.pose.position
+        o0, o1 = before.pose.orientation, after.pose.orientation
+        v0, v1 = before.velocity, after.velocity
+        a0, a1 = before.acceleration, after.acceleration
+        return TelemetryData(
+            pose=Pose(
+                position=Position(lerp(p0.x, p1.x), lerp(p0.y, p1.y), lerp(p0.z, p1.z)),
+                orientation=Orientation(lerp_angle(o0.roll, o1.roll), lerp_angle(o0.pitch, o1.pitch),
+                                        lerp_angle(o0.yaw, o1.yaw))
+            ),
+            battery=before.battery,
+            velocity=Velocity(lerp(v0.vx, v1.vx), lerp(v0.vy, v1.vy), lerp(v0.vz, v1.vz)),
+            acceleration=Acceleration(lerp(a0.ax, a1.ax), lerp(a0.ay, a1.ay), lerp(a0.az, a1.az)),
+            timestamp_us=timestamp_us
+        )
+
+    def _update_pose(self, values: tuple, timestamp_us: int) -> None:
+        """
+        Updates internal telemetry with an unpacked pose.
+
+        Args:
+            values (tuple): Position, velocity, acceleration and orientation values, in packet order.
+            timestamp_us (int): Drone timestamp of the pose sample (in microseconds).
+        """
+        x, y, z, vx, vy, vz, ax, ay, az, roll, pitch, yaw = values
+        telemetry = TelemetryData(
+            pose=Pose(
+                position=Position(x, y, z),
+                orientation=Orientation(roll, pitch, yaw)
+            ),
+            battery=self._telemetry.battery,
+            velocity=Velocity(vx, vy, vz),
+            acceleration=Acceleration(ax, ay, az),
+            timestamp_us=timestamp_us
+        )
+        with self._lock:
+            if self._pose_history and timestamp_us < self._pose_history[-1].timestamp_us:
+                # The drone restarted, its clock too
+                self._pose_history.clear()
+            self._pose_history.append(telemetry)
+        self._telemetry = telemetry
+        self._logger.debug("Updated pose: %s", telemetry.pose)
+
+    def _process_time_sync_packet(self, payload: memoryview, timestamp_us: int, receive_us: int) -> None:
+        """
+        Processes the answer to a time sync request.
+
+        Args:
+            payload (memoryview): Raw UDP payload of the time sync packet.
+            timestamp_us (int): Drone time the answer was sent (in microseconds).
+            receive_us (int): Local time the answer was received (in microseconds).
+        """
+        if len(payload) < config.STRUCT_TIME_SYNC.size:
+            self._logger.warning("Time sync payload too short (%d bytes)", len(payload))
+            return
+
+        send_us, drone_receive_us = config.STRUCT_TIME_SYNC.unpack_from(payload)
+        self._clock.update_exchange(send_us, drone_receive_us, timestamp_us, receive_us)
+
+    def _process_packet(self, packet: memoryview, receive_us: int) -> None:
+        """
+        Checks the header of a telemetry packet and dispatches its payload to its processing method.
+
+        Args:
+            packet (memoryview): Received datagram, only valid during the call.
+            receive_us (int): Local time the datagram was received (in microseconds).
+        """
+        if len(packet) < config.STRUCT_HEADER.size:
+            self._logger.warning("Packet too short for header (%d bytes)", len(packet))
+            return
+
+        version, packet_id, seq, timestamp_us, rate_divisor = config.STRUCT_HEADER.unpack_from(packet)
+        if version != config.TELEMETRY_PACKET_VERSION:
+            self._logger.warning("Unsupported packet version %d", version)
+            return
+        if not self._check_sequence(packet_id, seq):
+            return
+        if packet_id == config.PACKET_ID_TIME_SYNC:
+            self._process_time_sync_packet(packet[config.STRUCT_HEADER.size:], timestamp_us, receive_us)
+            return
+        self._clock.update(timestamp_us)
+        if packet_id in (config.PACKET_ID_POSE, config.PACKET_ID_POSE_BATCH) and rate_divisor != self._rate_divisor:
+            self._logger.info("Drone pose rate divided by %d.", rate_divisor)
+            self._rate_divisor = rate_divisor
+
+        handler = self._handlers.get(packet_id)
+        if handler:
+            handler(packet[config.STRUCT_HEADER.size:], timestamp_us)
 
     def _listen(self) -> None:
         """
         Background thread that receives and processes UDP telemetry packets.
         
-        This method runs in a loop, receiving packets and dispatching them
-        to the appropriate processing methods until stopped.
+        This method runs in a loop until stopped. It waits for the socket to be
+        readable, then receives every queued datagram (up to DRONE_UDP_RECV_BATCH)
+        into a preallocated buffer, so a burst costs one wake up and no allocation
+        per datagram, and dispatches them to the appropriate processing methods.
+        Time sync requests are sent from the same loop, every CLOCK_SYNC_PERIOD.
         """
+        buffer = bytearray(config.DRONE_UDP_BUFFER_SIZE)
+        view = memoryview(buffer)
         try:
             self._start_communication()
-            while self._running:
-                try:
-                    packet, addr = self._sock.recvfrom(config.DRONE_UDP_BUFFER_SIZE)
-                    if not packet:
-                        continue
-
-                    packet_id = packet[0]
-                    payload = packet[1:]
-
-                    if packet_id == config.PACKET_ID_BATTERY:
-                        self._process_battery_packet(payload)
-                    elif packet_id == config.PACKET_ID_POSE:
-                        self._process_pose_packet(payload)
-
-                except socket.timeout:
-                    continue
-                except struct.error as e:
-                    self._logger.error("Unpack error: %s", e)
-                except OSError as e:
-                    if self._running:
-                        self._logger.error("Socket error: %s", e)
-                    break
+            with selectors.DefaultSelector() as selector:
+                selector.register(self._sock, selectors.EVENT_READ)
+                while self._running:
+                    try:
+                        now_us = local_time_us()
+                        if now_us >= self._next_sync_us:
+                            self._next_sync_us = now_us + int(clock_config.CLOCK_SYNC_PERIOD * 1_000_000)
+                            self._send_time_sync()
+                        if not selector.select(min(config.DRONE_UDP_TIMEOUT, clock_config.CLOCK_SYNC_PERIOD)):
+                            continue
+                        # Drain the datagrams queued since the last wake up
+                        received = 0
+                        for _ in range(config.DRONE_UDP_RECV_BATCH):
+                            try:
+                                size, _ = self._sock.recvfrom_into(buffer)
+                            except BlockingIOError:
+                                break
+                            if size:
+                                received += 1
+                                self._process_packet(view[:size], local_time_us())
+                        metrics.inc("telemetry_packets_total", "received", received)
+                    except struct.error as e:
+                        self._logger.error("Unpack error: %s", e)
+                    except (OSError, ValueError) as e:
+                        if self._running:
+                            self._logger.error("Socket error: %s", e)
+                        break
 
         except Exception as e:
             self._logger.critical("Fatal socket error: %s", e)
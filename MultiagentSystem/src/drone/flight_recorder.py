@@ -0,0 +1,166 @@
+from configuration import flight_recorder as config
+import cv2
+import os
+import threading
+import logging
+from datetime import datetime
+from queue import Empty, Queue
+from typing import BinaryIO, Optional
+
+from interfaces.interfaces import AFrameConsumer
+from structures.structures import FrameWithTelemetry
+
+class FlightRecorder(AFrameConsumer):
+    """
+    Frame consumer that records the frames and their telemetry to disk, for replay.
+
+    Each start creates a recording folder holding numbered segments. A segment is a data file
+    (segment_NNNNN.bin) with the JPEG bytes of the frames one after the other, and an index file
+    (segment_NNNNN.idx) with one fixed-size RECORDER_STRUCT_INDEX record per frame: where its JPEG
+    lies in the data file, its timestamps, and its pose and battery voltage. A new segment starts
+    when the data file would exceed RECORDER_SEGMENT_SIZE. Both files are only appended to, so a
+    recording cut short stays readable up to its last complete record.
+
+    The frames are written by a background thread, see FlightReplay to play them back.
+    """
+
+    def __init__(self, output_folder: str = config.RECORDER_OUTPUT_FOLDER) -> None:
+        """
+        Creates a FlightRecorder instance.
+
+        Args:
+            output_folder (str): Folder where the recording folders are created.
+        """
+        self._output_folder: str = output_folder
+        self._queue = Queue(maxsize=config.RECORDER_MAX_QUEUE_SIZE)
+
+        self._path: Optional[str] = None
+        self._segment: int = -1
+        self._data: Optional[BinaryIO] = None
+        self._index: Optional[BinaryIO] = None
+        self._offset: int = 0
+        self._frames: int = 0
+
+        self._running: bool = False
+        self._thread: Optional[threading.Thread] = None
+
+        self._logger: logging.Logger = logging.getLogger("FlightRecorder")
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def start(self) -> None:
+        """
+        Creates a new recording folder and starts the writer thread.
+        """
+        if self._running:
+            self._logger.warning("Already running.")
+            return
+
+        self._path = os.path.join(self._output_folder, datetime.now().strftime("%Y_%m_%d_%H_%M_%S_%f"))
+        os.makedirs(self._path, exist_ok=True)
+        self._segment = -1
+        self._frames = 0
+        self._open_segment()
+
+        self._running = True
+        self._thread = threading.Thread(target=self._loop, daemon=True)
+        self._thread.start()
+        self._logger.info("Recording to %s", os.path.abspath(self._path))
+
+    def stop(self) -> None:
+        """
+        Stops the writer thread once the queued frames are written, and closes the recording.
+        """
+        if not self._running:
+            self._logger.warning("Already stopped.")
+            return
+
+        self._running = False
+        if self._thread:
+            self._thread.join(timeout=5.0)
+            if self._thread.is_alive():
+                self._logger.warning("Did not stop in time.")
+            self._thread = None
+        self._close_segment()
+        self._logger.info("Stopped after recording %d frames.", self._frames)
+
+    def get_path(self) -> Optional[str]:
+        """
+        Returns the folder of the current or last recording.
+
+        Returns:
+            Optional[str]: Recording folder, None if never started.
+        """
+        return self._path
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _open_segment(self) -> None:
+        """
+        Closes the current segment, if any, and opens the next one.
+        """
+        self._close_segment()
+        self._segment += 1
+        name = os.path.join(self._path, f"segment_{self._segment:05d}")
+        self._data = open(name + ".bin", "wb")
+        self._index = open(name + ".idx", "wb")
+        self._offset = 0
+
+    def _close_segment(self) -> None:
+        """
+        Closes the files of the current segment.
+        """
+        for f in (self._data, self._index):
+            if f:
+                f.close()
+        self._data = None
+        self._index = None
+
+    def _process_frame(self, fwt: FrameWithTelemetry) -> None:
+        """
+        Appends a frame with its index record to the current segment.
+
+        The JPEG the camera sent is written as is; frames captured as arrays are encoded first.
+
+        Args:
+            fwt (FrameWithTelemetry): Frame with telemetry to record.
+        """
+        jpeg = fwt.frame.jpeg
+        if jpeg is None:
+            ok, encoded = cv2.imencode(".jpg", fwt.frame.data, [cv2.IMWRITE_JPEG_QUALITY, config.RECORDER_JPEG_QUALITY])
+            if not ok:
+                self._logger.error("Could not encode frame %d", fwt.frame.frame_id)
+                return
+            jpeg = encoded.tobytes()
+
+        size = len(jpeg)
+        if self._offset and self._offset + size > config.RECORDER_SEGMENT_SIZE:
+            self._open_segment()
+
+        telemetry = fwt.telemetry
+        p, o = telemetry.pose.position, telemetry.pose.orientation
+        v, a = telemetry.velocity, telemetry.acceleration
+        self._data.write(jpeg)
+        self._index.write(config.RECORDER_STRUCT_INDEX.pack(
+            self._offset, size, fwt.frame.host_capture_us, telemetry.timestamp_us, fwt.frame.seq,
+            p.x, p.y, p.z, v.vx, v.vy, v.vz, a.ax, a.ay, a.az, o.roll, o.pitch, o.yaw,
+            telemetry.battery.voltage, fwt.frame.color_ratio
+        ))
+        self._offset += size
+        self._frames += 1
+
+    def _loop(self) -> None:
+        """
+        Background writer thread: records the queued frames, and the frames left in the queue once stopped.
+        """
+        while self._running or not self._queue.empty():
+            try:
+                fwt = self._queue.get(timeout=0.1)
+            except Empty:
+                continue
+            try:
+                self._process_frame(fwt)
+            except Exception as e:
+                self._logger.error("Error recording frame: %s", e)
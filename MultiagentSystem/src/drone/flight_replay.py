@@ -0,0 +1,303 @@
+from configuration import flight_recorder as config
+import glob
+import mmap
+import os
+import threading
+import logging
+from bisect import bisect_right
+from typing import List, Optional, Tuple
+
+from interfaces.interfaces import ICamera, ITelemetry
+from structures.structures import Acceleration, Battery, Frame, Orientation, Pose, Position, TelemetryData, Velocity
+from utils import sim_clock
+
+class FlightReplay:
+    """
+    Playback of a recording of the FlightRecorder, shared by a ReplayCamera and a ReplayTelemetry.
+
+    The segment data files are memory-mapped, so a frame is only read when it is played, and only
+    decoded when a consumer needs its pixels.
+    The playback either follows the recorded capture times at a given speed of the simulation clock,
+    or, at maximum speed, moves to the next frame each time the camera is asked for a new one.
+    """
+
+    def __init__(self, path: str, speed: Optional[float] = 1.0) -> None:
+        """
+        Creates a FlightReplay instance and maps the recording.
+
+        Args:
+            path (str): Recording folder.
+            speed (Optional[float]): Playback speed relative to the recording, None for maximum speed.
+        """
+        self._speed: Optional[float] = speed
+
+        self._maps: List[mmap.mmap] = []
+        self._records: List[Tuple[int, tuple]] = []
+        for name in sorted(glob.glob(os.path.join(path, "segment_*.bin"))):
+            self._load_segment(name)
+        if not self._records:
+            raise ValueError(f"No recorded frames in '{path}'.")
+
+        first_us = self._records[0][1][2]
+        self._times: List[float] = [(record[2] - first_us) / 1e6 for _, record in self._records]
+
+        self._start_time: Optional[float] = None
+        self._index: int = -1
+        self._cached: Optional[Frame] = None
+        self._lock: threading.Lock = threading.Lock()
+
+        self._logger: logging.Logger = logging.getLogger("FlightReplay")
+        self._logger.info("Loaded %d frames from %s", len(self._records), path)
+
+    # ---------------------------------------------------
+    # Public methods
+    # ---------------------------------------------------
+    def __len__(self) -> int:
+        """
+        Returns the number of recorded frames.
+
+        Returns:
+            int: Number of frames.
+        """
+        return len(self._records)
+
+    def start(self) -> None:
+        """
+        Starts the playback from the first frame, if not started yet.
+        """
+        with self._lock:
+            if self._start_time is not None:
+                return
+            self._start_time = sim_clock.now()
+            self._index = -1
+
+    def stop(self) -> None:
+        """
+        Stops the playback.
+        """
+        with self._lock:
+            self._start_time = None
+
+    def current_index(self) -> int:
+        """
+        Returns the index of the frame being played.
+
+        Returns:
+            int: Frame index, -1 before the first frame or when stopped.
+        """
+        with self._lock:
+            if self._start_time is None:
+                return -1
+            if self._speed is None:
+                return self._index
+            elapsed = (sim_clock.now() - self._start_time) * self._speed
+            return bisect_right(self._times, elapsed) - 1
+
+    def time_until(self, index: int) -> Optional[float]:
+        """
+        Returns the time left until a frame is played.
+
+        Args:
+            index (int): Frame index.
+
+        Returns:
+            Optional[float]: Time left (in seconds of the simulation clock), 0 at maximum speed,
+            None if stopped or past the end of the recording.
+        """
+        with self._lock:
+            if self._start_time is None or index >= len(self._records):
+                return None
+            if self._speed is None:
+                return 0.0
+            return self._start_time + self._times[index] / self._speed - sim_clock.now()
+
+    def advance(self) -> int:
+        """
+        Moves to the next frame at maximum speed.
+
+        Returns:
+            int: Index of the frame now played, the last one at the end of the recording.
+        """
+        with self._lock:
+            self._index = min(self._index + 1, len(self._records) - 1)
+            return self._index
+
+    def frame(self, index: int) -> Frame:
+        """
+        Returns a recorded frame, with its recorded pose embedded and its JPEG left for its consumers to decode.
+
+        Args:
+            index (int): Frame index.
+
+        Returns:
+            Frame: Frame with frame_id set to its index.
+        """
+        with self._lock:
+            if self._cached is not None and self._cached.frame_id == index:
+                return self._cached
+
+        segment, record = self._records[index]
+        offset, size, _, timestamp_us, seq = record[:5]
+        x, y, z, _, _, _, _, _, _, roll, pitch, yaw, _, color_ratio = record[5:]
+        frame = Frame(
+            jpeg=self._maps[segment][offset:offset + size],
+            seq=seq,
+            pose=Pose(Position(x, y, z), Orientation(roll, pitch, yaw)),
+            pose_timestamp_us=timestamp_us,
+            color_ratio=color_ratio,
+            frame_id=index,
+        )
+        with self._lock:
+            self._cached = frame
+        return frame
+
+    def telemetry(self, index: int) -> TelemetryData:
+        """
+        Returns the recorded telemetry of a frame.
+
+        Args:
+            index (int): Frame index.
+
+        Returns:
+            TelemetryData: Recorded pose, motion and battery voltage.
+        """
+        _, record = self._records[index]
+        x, y, z, vx, vy, vz, ax, ay, az, roll, pitch, yaw, voltage, _ = record[5:]
+        return TelemetryData(
+            pose=Pose(Position(x, y, z), Orientation(roll, pitch, yaw)),
+            battery=Battery(voltage=voltage),
+            velocity=Velocity(vx, vy, vz),
+            acceleration=Acceleration(ax, ay, az),
+            timestamp_us=record[3],
+        )
+
+    # ---------------------------------------------------
+    # Private methods
+    # ---------------------------------------------------
+    def _load_segment(self, name: str) -> None:
+        """
+        Maps the data file of a segment and reads its index, ignoring an incomplete last record.
+
+        Args:
+            name (str): Path to the segment data file.
+        """
+        with open(name[:-len(".bin")] + ".idx", "rb") as f:
+            index = f.read()
+        if os.path.getsize(name) == 0:
+            return
+
+        with open(name, "rb") as f:
+            data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        segment = len(self._maps)
+        self._maps.append(data)
+
+        complete = len(index) - len(index) % config.RECORDER_STRUCT_INDEX.size
+        for record in config.RECORDER_STRUCT_INDEX.iter_unpack(index[:complete]):
+            if record[0] + record[1] <= len(data):
+                self._records.append((segment, record))
+
+class ReplayCamera(ICamera):
+    """
+    Camera provider playing back the frames of a FlightReplay.
+
+    The frames carry their recorded pose, so the Matcher pairs them with it whatever the playback speed.
+    """
+
+    def __init__(self, replay: FlightReplay) -> None:
+        """
+        Creates a ReplayCamera instance.
+
+        Args:
+            replay (FlightReplay): Playback to follow.
+        """
+        self._replay: FlightReplay = replay
+
+    def start(self) -> None:
+        """Starts the playback."""
+        self._replay.start()
+
+    def stop(self) -> None:
+        """Stops the playback."""
+        self._replay.stop()
+
+    def get_frame(self, last_frame_id: int = -1) -> Optional[Frame]:
+        """
+        Returns the frame being played.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
+
+        Returns:
+            Optional[Frame]: The frame being played, or None if none or still the frame with last_frame_id.
+        """
+        index = self._replay.current_index()
+        if index < 0 or index == last_frame_id:
+            return None
+        return self._replay.frame(index)
+
+    def wait_frame(self, last_frame_id: int = -1, timeout: Optional[float] = None) -> Optional[Frame]:
+        """
+        Waits until the frame after the one with last_frame_id is played, at maximum speed moves to it.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
+            timeout (Optional[float]): Longest wait (in seconds), None to wait without limit.
+
+        Returns:
+            Optional[Frame]: The new frame, or None on timeout, when stopped or at the end of the recording.
+        """
+        remaining = self._replay.time_until(last_frame_id + 1)
+        if remaining is None:
+            sim_clock.sleep(0.1 if timeout is None else timeout)
+            return None
+        if remaining == 0.0 and self._replay.current_index() == last_frame_id:
+            index = self._replay.advance()
+            return self._replay.frame(index) if index != last_frame_id else None
+        if timeout is not None and remaining > timeout:
+            sim_clock.sleep(timeout)
+            return None
+        if remaining > 0:
+            sim_clock.sleep(remaining)
+        return self.get_frame(last_frame_id)
+
+    def turn_on_flash(self) -> None:
+        """No flash on a replay (no-op)."""
+        pass
+
+    def turn_off_flash(self) -> None:
+        """No flash on a replay (no-op)."""
+        pass
+
+class ReplayTelemetry(ITelemetry):
+    """
+    Telemetry provider playing back the telemetry of a FlightReplay, at the frame being played.
+    """
+
+    def __init__(self, replay: FlightReplay) -> None:
+        """
+        Creates a ReplayTelemetry instance.
+
+        Args:
+            replay (FlightReplay): Playback to follow.
+        """
+        self._replay: FlightReplay = replay
+
+    def start(self) -> None:
+        """Starts the playback."""
+        self._replay.start()
+
+    def stop(self) -> None:
+        """Stops the playback."""
+        self._replay.stop()
+
+    def get_telemetry(self) -> Optional[TelemetryData]:
+        """
+        Returns the recorded telemetry of the frame being played.
+
+        Returns:
+            Optional[TelemetryData]: Recorded telemetry, or None before the first frame.
+        """
+        index = self._replay.current_index()
+        if index < 0:
+            return None
+        return self._replay.telemetry(index)
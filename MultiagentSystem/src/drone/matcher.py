@@ -1,11 +1,13 @@
 from configuration import matcher as config
 import threading
 import logging
-from time import sleep
+from dataclasses import replace
 from typing import List, Optional
 
 from interfaces.interfaces import ICamera, AFrameConsumer, ITelemetry
 from structures.structures import FrameWithTelemetry
+from utils import metrics
+from utils.clock_offset import local_time_us
 
 class Matcher:
     """
@@ -15,6 +17,10 @@ class Matcher:
     from a telemetry provider. Each frame is associated with the exact telemetry data at the 
     moment of capture, forming a FrameWithTelemetry object. These objects are then distributed 
     to all registered consumers (instances of AFrameConsumer).
+
+    If the camera embedded the drone pose in the frame, that pose replaces the telemetry pose,
+    since it was paired with the frame at capture time by the camera itself. Otherwise the
+    telemetry is looked up at the frame capture time, from the telemetry pose history.
     """
     def __init__(self, telemetry: ITelemetry, camera: ICamera) -> None:
         """
@@ -28,6 +34,7 @@ class Matcher:
         self._camera: ICamera = camera
 
         self._consumers: List[AFrameConsumer] = []
+        self._last_frame_id: int = -1
 
         self._running: bool = False
         self._thread: Optional[threading.Thread] = None
@@ -83,6 +90,7 @@ class Matcher:
             )
             return
         self._consumers.append(consumer)
+        metrics.register_gauge("queue_depth", type(consumer).__name__, consumer._queue.qsize)
         self._logger.info("Registered consumer: %s", type(consumer).__name__)
 
     # ----------------------------------------------------------------------
@@ -94,21 +102,33 @@ class Matcher:
 
         Retrieves a frame from the camera and telemetry from the telemetry provider,
         creates a FrameWithTelemetry object, and enqueues it to all registered consumers. 
+        The thread sleeps until the camera publishes a new frame, so each frame is matched
+        once and as soon as it arrives.
         """
         while self._running:
-            frame = self._camera.get_frame()
+            frame = self._camera.wait_frame(self._last_frame_id, config.MATCHER_FRAME_TIMEOUT)
             if frame is None:
-                sleep(config.MATCHER_SLEEP_TIME)
                 continue
-            self._logger.debug("Retrieved frame of shape %s", frame.data.shape)
-
-            telemetry = self._telemetry.get_telemetry()
+            self._last_frame_id = frame.frame_id
+            self._logger.debug("Retrieved frame %d", frame.frame_id)
+
+            if frame.pose is not None:
+                telemetry = self._telemetry.get_telemetry()
+                telemetry = replace(telemetry, pose=frame.pose, timestamp_us=frame.pose_timestamp_us)
+            elif frame.host_capture_us:
+                telemetry = self._telemetry.get_telemetry_at(frame.host_capture_us)
+            else:
+                telemetry = self._telemetry.get_telemetry()
             self._logger.debug("Retrieved telemetry: %s", telemetry)
 
-            fwt = FrameWithTelemetry(frame, telemetry)
+            matched_us = local_time_us()
+            fwt = FrameWithTelemetry(frame, telemetry, matched_us)
+            metrics.inc("frames_total", "matched")
+            if frame.host_capture_us:
+                metrics.observe("latency_seconds", "capture_to_match", (matched_us - frame.host_capture_us) / 1e6)
             self._logger.debug(
-                "Matched frame of shape %s with telemetry %s",
-                frame.data.shape, telemetry
+                "Matched frame %d with telemetry %s",
+                frame.frame_id, telemetry
             )
 
             for consumer in self._consumers:
@@ -119,5 +139,3 @@ class Matcher:
                         "Error sending to consumer %s: %s",
                         type(consumer).__name__, e
                     )
-
-            sleep(config.MATCHER_SLEEP_TIME)
@@ -0,0 +1,181 @@
+from configuration import camera_capture as config
+import socket
+from typing import Dict, List, Optional, Tuple
+from urllib.parse import urlsplit
+
+class MjpegStream:
+    """
+    Minimal HTTP client of a multipart/x-mixed-replace (MJPEG) stream, on its own socket.
+
+    It sends a single GET request and splits the response body into parts, each with its
+    headers and its body delimited by Content-Length. Chunked transfer encoding, which the
+    camera web server uses, is decoded on the fly. Nothing is buffered beyond the bytes of
+    the part being received, unlike OpenCV VideoCapture.
+    """
+
+    def __init__(self, url: str, timeout: float = config.CAMERA_STREAM_TIMEOUT) -> None:
+        """
+        Creates a MjpegStream instance, not connected.
+
+        Args:
+            url (str): HTTP URL of the stream.
+            timeout (float): Longest wait for data (in seconds) before the stream is considered dead.
+        """
+        parts = urlsplit(url)
+        self._host: str = parts.hostname or ""
+        self._port: int = parts.port or 80
+        self._path: str = (parts.path or "/") + (f"?{parts.query}" if parts.query else "")
+        self._timeout: float = timeout
+
+        self._sock: Optional[socket.socket] = None
+        self._recv_buffer: bytearray = bytearray(config.CAMERA_STREAM_CHUNK_SIZE)
+        self._raw: bytearray = bytearray()
+        self._body: bytearray = bytearray()
+        self._chunked: bool = False
+        self._chunk_left: int = 0
+        self._ended: bool = False
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def open(self) -> None:
+        """
+        Connects, sends the request and reads the response headers.
+
+        Raises:
+            OSError: If the connection fails or the server does not answer 200.
+        """
+        self._raw.clear()
+        self._body.clear()
+        self._chunk_left = 0
+        self._ended = False
+
+        self._sock = socket.create_connection((self._host, self._port), timeout=config.CAMERA_STREAM_CONNECT_TIMEOUT)
+        self._sock.settimeout(self._timeout)
+        request = f"GET {self._path} HTTP/1.1\r\nHost: {self._host}\r\nAccept: multipart/x-mixed-replace\r\n\r\n"
+        self._sock.sendall(request.encode("ascii"))
+
+        while (end := self._raw.find(b"\r\n\r\n")) < 0:
+            if not self._recv():
+                raise OSError("Connection closed before the response headers")
+        status, _, header_block = bytes(self._raw[:end]).decode("ascii", errors="ignore").partition("\r\n")
+        del self._raw[:end + 4]
+        if status.split(" ")[1:2] != ["200"]:
+            raise OSError(f"Unexpected response: {status}")
+        headers = parse_headers(header_block)
+        self._chunked = "chunked" in headers.get("transfer-encoding", "").lower()
+        self._decode()
+
+    def close(self) -> None:
+        """Closes the connection, if open, which also unblocks a pending read_parts."""
+        sock, self._sock = self._sock, None
+        if sock:
+            try:
+                sock.close()
+            except OSError:
+                pass
+
+    def read_parts(self) -> Optional[List[Tuple[Dict[str, str], bytes]]]:
+        """
+        Receives what the socket holds and returns the parts it completes.
+
+        A single socket read is made, so each part comes out as soon as its last byte
+        arrives. Several parts are returned when the reader fell behind.
+
+        Returns:
+            Optional[List[Tuple[Dict[str, str], bytes]]]: Headers and body of each completed part,
+            oldest first (possibly none), or None once the stream has ended.
+
+        Raises:
+            OSError: On socket errors, including the read timeout.
+        """
+        if self._ended or not self._recv():
+            return None
+        self._decode()
+
+        parts = []
+        while (header_end := self._body.find(b"\r\n\r\n")) >= 0:
+            headers = parse_headers(bytes(self._body[:header_end]).decode("ascii", errors="ignore"))
+            body_start = header_end + 4
+            if "content-length" not in headers:
+                del self._body[:body_start]
+                continue
+            body_end = body_start + int(headers["content-length"])
+            if len(self._body) < body_end:
+                break
+            parts.append((headers, bytes(self._body[body_start:body_end])))
+            del self._body[:body_end]
+        return parts
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _recv(self) -> bool:
+        """
+        Receives the next bytes from the socket into the raw buffer.
+
+        Returns:
+            bool: False if the connection was closed.
+        """
+        sock = self._sock
+        if sock is None:
+            return False
+        n = sock.recv_into(self._recv_buffer)
+        if n == 0:
+            return False
+        self._raw += memoryview(self._recv_buffer)[:n]
+        return True
+
+    def _decode(self) -> None:
+        """
+        Moves the received bytes to the body buffer, removing the chunked transfer encoding if used.
+        """
+        if not self._chunked:
+            self._body += self._raw
+            self._raw.clear()
+            return
+
+        while True:
+            if self._chunk_left > 0:
+                n = min(self._chunk_left, len(self._raw))
+                if n == 0:
+                    return
+                self._body += memoryview(self._raw)[:n]
+                del self._raw[:n]
+                self._chunk_left -= n
+                if self._chunk_left:
+                    return
+                self._chunk_left = -1
+            if self._chunk_left < 0:
+                if len(self._raw) < 2:
+                    return
+                del self._raw[:2]
+                self._chunk_left = 0
+            line_end = self._raw.find(b"\r\n")
+            if line_end < 0:
+                return
+            size = int(bytes(self._raw[:line_end]).split(b";")[0], 16)
+            del self._raw[:line_end + 2]
+            if size == 0:
+                self._ended = True
+                return
+            self._chunk_left = size
+
+def parse_headers(block: str) -> Dict[str, str]:
+    """
+    Parses a block of HTTP headers.
+
+    Lines without a colon (such as a multipart boundary) are ignored.
+
+    Args:
+        block (str): Header lines separated by CRLF, without the terminating blank line.
+
+    Returns:
+        Dict[str, str]: Header values indexed by lowercase header name.
+    """
+    headers: Dict[str, str] = {}
+    for line in block.split("\r\n"):
+        name, sep, value = line.partition(":")
+        if sep:
+            headers[name.strip().lower()] = value.strip()
+    return headers
@@ -1,10 +1,10 @@
 import logging
 from math import cos, pi, sin, sqrt
-from time import time
 from typing import Optional
 
 from structures.structures import Point2D
 from interfaces.interfaces import IMovementSimulator
+from utils import sim_clock
 
 class SpiralMovementSimulator(IMovementSimulator):
     """
@@ -12,22 +12,26 @@ class SpiralMovementSimulator(IMovementSimulator):
 
     The simulated agent moves in an equidistant spiral starting from the origin (0,0).
     The spiral has a fixed radial growth per turn, and the agent moves along the spiral 
-    at a constant linear speed. 
+    at a constant linear speed, or below a speed limit if one is set. The spiral can be rotated
+    about the origin, so that several agents fly interleaved arms.
     
     This simulator is time-based as the current position is computed on demand from the
     last angle recorded and the elapsed time since it.
     """
 
-    def __init__(self, radial_growth: float, linear_speed: float) -> None:
+    def __init__(self, radial_growth: float, linear_speed: float, rotation: float = 0.0) -> None:
         """
         Creates a SpiralMovementSimulator instance.
 
         Args:
             radial_growth (float): Radial growth per unit angle (m/rad), that is, the distance between turns.
             linear_speed (float): Linear speed of the movement (m/s).
+            rotation (float): Rotation of the spiral about the origin (in radians).
         """
         self._radial_growth: float = radial_growth
         self._linear_speed: float = linear_speed
+        self._rotation: float = rotation
+        self._speed_limit: float = 0.0
 
         self._active: bool = False
         self._last_t: Optional[float] = None
@@ -49,7 +53,7 @@ class SpiralMovementSimulator(IMovementSimulator):
             return
         
         self._last_theta = 0.0
-        self._last_t = time()
+        self._last_t = sim_clock.now()
         self._last_theta = 0.0
         self._active = True
         self._logger.info("Started.")
@@ -69,6 +73,15 @@ class SpiralMovementSimulator(IMovementSimulator):
         self._last_theta = 0.0   
         self._logger.info("Stopped.")
 
+    def set_speed_limit(self, speed: float) -> None:
+        """
+        Limits the linear speed of the movement, as the drone high-level commander does.
+
+        Args:
+            speed (float): Largest linear speed (in m/s), 0 to lift the limit.
+        """
+        self._speed_limit = speed
+
     def get_xy(self) -> Optional[Point2D]:
         """
         Returns the current (x, y) position of the simulated movement.
@@ -82,11 +95,12 @@ class SpiralMovementSimulator(IMovementSimulator):
         if not self._active:
             return None
 
-        now = time()
+        now = sim_clock.now()
         dt = now - self._last_t
         self._last_t = now
 
-        ds = self._linear_speed * dt
+        speed = min(self._linear_speed, self._speed_limit) if self._speed_limit > 0 else self._linear_speed
+        ds = speed * dt
 
         dr_dtheta = self._radial_growth / (2 * pi)
 
@@ -95,7 +109,7 @@ class SpiralMovementSimulator(IMovementSimulator):
         self._last_theta += dtheta
 
         r = dr_dtheta * self._last_theta
-        x = r * cos(self._last_theta)
-        y = r * sin(self._last_theta)
+        x = r * cos(self._last_theta + self._rotation)
+        y = r * sin(self._last_theta + self._rotation)
 
         return Point2D(x, y)
@@ -1,10 +1,10 @@
 from configuration import movement_simulator as config
 import logging
-from time import time
 from typing import Optional
 
 from structures.structures import Point2D
 from interfaces.interfaces import IMovementSimulator
+from utils import sim_clock
 
 class ZigzagMovementSimulator(IMovementSimulator):
     """
@@ -50,7 +50,7 @@ class ZigzagMovementSimulator(IMovementSimulator):
             self._logger.warning("Already started.")
             return
         
-        self._start_t = time()
+        self._start_t = sim_clock.now()
         self._active = True
         self._logger.info("Started.")
 
@@ -81,7 +81,7 @@ class ZigzagMovementSimulator(IMovementSimulator):
         if not self._active:
             return None
 
-        now = time()
+        now = sim_clock.now()
         dt = now - self._start_t
         distance = self._speed * dt
         dy, dx = divmod(distance, self._max_horizontal_distance)
@@ -0,0 +1,162 @@
+import logging
+import math
+import threading
+from typing import Callable, Dict, Optional
+
+from configuration import drone as config
+from interfaces.interfaces import ITelemetry
+from structures.structures import Position
+from utils import metrics
+from utils import sim_clock
+
+class SpeedGovernor:
+    """
+    Feedback from the throughput of the color detection to the ground speed of the drone.
+
+    Every SPEED_GOVERNOR_PERIOD, the frames the color detection handled, analyzed by YOLO or
+    skipped as already seen, are counted against the ground distance flown, from the telemetry.
+    No spot is missed as long as the drone flies at most SPEED_GOVERNOR_FRAME_SPACING between
+    handled frames, so the fastest speed the pipeline sustains is its handled frame rate times
+    that spacing; beyond it, the detection queue drops frames and their ground goes unseen.
+    The smoothed rate gives the speed limit, commanded with SPEED_GOVERNOR_MARGIN whenever it
+    changes by more than SPEED_GOVERNOR_HYSTERESIS.
+
+    The limit follows the pipeline both ways: a slower drone overlaps more frames, which are
+    skipped cheaply, so the handled rate and the limit rise again.
+    """
+
+    def __init__(self, telemetry: ITelemetry, frame_stats: Callable[[], Dict[str, int]],
+                 command: Callable[[float], None]) -> None:
+        """
+        Creates a SpeedGovernor instance.
+
+        Args:
+            telemetry (ITelemetry): Telemetry of the drone, for the distance flown.
+            frame_stats (Callable[[], Dict[str, int]]): Frame counts of the color detection, see
+                ColorDetection.get_frame_stats.
+            command (Callable[[float], None]): Commands a speed limit (in m/s) to the drone.
+        """
+        self._telemetry: ITelemetry = telemetry
+        self._frame_stats: Callable[[], Dict[str, int]] = frame_stats
+        self._command: Callable[[float], None] = command
+
+        self._rate: Optional[float] = None
+        self._frames_per_metre: float = 0.0
+        self._limit: float = 0.0
+
+        self._running: bool = False
+        self._thread: Optional[threading.Thread] = None
+
+        self._logger: logging.Logger = logging.getLogger("SpeedGovernor")
+
+        metrics.register_gauge("speed_limit", "drone", lambda: self._limit)
+        metrics.register_gauge("frames_per_metre", "drone", lambda: self._frames_per_metre)
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def start(self) -> None:
+        """
+        Starts the background thread that measures the throughput and commands the speed limit.
+        """
+        if self._running:
+            self._logger.warning("Already running.")
+            return
+
+        self._running = True
+        self._rate = None
+        self._thread = threading.Thread(target=self._govern, daemon=True)
+        self._thread.start()
+        self._logger.info("Started.")
+
+    def stop(self) -> None:
+        """
+        Stops the background thread. The last speed limit stays commanded.
+        """
+        if not self._running:
+            self._logger.warning("Already stopped.")
+            return
+
+        self._running = False
+        if self._thread:
+            self._thread.join(timeout=1.0)
+            if self._thread.is_alive():
+                self._logger.warning("Did not stop in time.")
+            self._thread = None
+        self._logger.info("Stopped.")
+
+    def get_speed_limit(self) -> float:
+        """
+        Returns the last speed limit commanded.
+
+        Returns:
+            float: Speed limit (in m/s), 0 if none was commanded yet.
+        """
+        return self._limit
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _handled_frames(self) -> int:
+        """
+        Returns the frames the color detection handled so far.
+
+        Returns:
+            int: Frames analyzed by YOLO or skipped before it.
+        """
+        stats = self._frame_stats()
+        return stats.get("processed", 0) + stats.get("skipped", 0)
+
+    def _position(self) -> Optional[Position]:
+        """
+        Returns the current position of the drone.
+
+        Returns:
+            Optional[Position]: Position from the telemetry, None if unavailable.
+        """
+        telemetry = self._telemetry.get_telemetry()
+        return telemetry.pose.position if telemetry else None
+
+    def _govern(self) -> None:
+        """
+        Background worker method that measures the handled frames per metre every SPEED_GOVERNOR_PERIOD
+        and commands the speed limit they allow.
+        """
+        frames = self._handled_frames()
+        position = self._position()
+        last_time = sim_clock.now()
+        while self._running:
+            sim_clock.sleep(config.SPEED_GOVERNOR_PERIOD)
+            now = sim_clock.now()
+            elapsed = now - last_time
+            if elapsed <= 0:
+                continue
+
+            handled = self._handled_frames()
+            current = self._position()
+            distance = math.hypot(current.x - position.x, current.y - position.y) \
+                if current is not None and position is not None else 0.0
+            rate = (handled - frames) / elapsed
+            flowing = handled > frames
+            frames, position, last_time = handled, current, now
+            if self._rate is None and not flowing:
+                # Frames not flowing yet at the start of the routine, nothing to measure
+                continue
+
+            self._rate = rate if self._rate is None \
+                else self._rate + config.SPEED_GOVERNOR_SMOOTHING * (rate - self._rate)
+            if distance > 0:
+                self._frames_per_metre = (rate * elapsed) / distance
+
+            limit = max(self._rate * config.SPEED_GOVERNOR_FRAME_SPACING * config.SPEED_GOVERNOR_MARGIN,
+                        config.SPEED_GOVERNOR_MIN_SPEED)
+            if self._limit > 0 and abs(limit - self._limit) <= config.SPEED_GOVERNOR_HYSTERESIS * self._limit:
+                continue
+
+            self._logger.debug("%.1f frames/s, %.2f frames/m, speed limit %.2f m/s",
+                               self._rate, self._frames_per_metre, limit)
+            try:
+                self._command(limit)
+                self._limit = limit
+            except Exception as e:
+                self._logger.error("Failed to command the speed limit: %s", e)
@@ -0,0 +1,93 @@
+import logging
+import threading
+from typing import Optional
+
+from configuration import drone_telemetry as config
+from interfaces.interfaces import ITelemetry, IMovementSimulator
+from structures.structures import Battery, Orientation, Pose, Position, TelemetryData
+from utils import sim_clock
+
+class TelemetrySimulator(ITelemetry):
+    """
+    Simulated telemetry provider, for operations run without a drone.
+
+    The x/y position comes from a movement simulator, the altitude is constant and the
+    battery drains linearly with the flight time of the simulation clock, from a full
+    charge when the simulator is created.
+    """
+
+    def __init__(self, simulator: IMovementSimulator) -> None:
+        """
+        Creates a TelemetrySimulator instance with a full battery.
+
+        Args:
+            simulator (IMovementSimulator): Movement simulator giving the x/y position.
+        """
+        self._simulator: IMovementSimulator = simulator
+
+        self._flight_time: float = 0.0
+        self._start_time: Optional[float] = None
+        self._lock: threading.Lock = threading.Lock()
+
+        self._logger: logging.Logger = logging.getLogger("TelemetrySimulator")
+
+    # ---------------------------------------------------
+    # Public methods
+    # ---------------------------------------------------
+    def start(self) -> None:
+        """
+        Starts the movement simulator and the battery drain.
+        """
+        with self._lock:
+            if self._start_time is not None:
+                self._logger.warning("Already running.")
+                return
+            self._start_time = sim_clock.now()
+        self._simulator.start()
+        self._logger.info("Started.")
+
+    def stop(self) -> None:
+        """
+        Stops the movement simulator and the battery drain.
+        """
+        with self._lock:
+            if self._start_time is None:
+                self._logger.warning("Already stopped.")
+                return
+            self._flight_time += sim_clock.now() - self._start_time
+            self._start_time = None
+        self._simulator.stop()
+        self._logger.info("Stopped.")
+
+    def set_speed_limit(self, speed: float) -> None:
+        """
+        Limits the speed of the movement simulator.
+
+        Args:
+            speed (float): Largest ground speed (in m/s), 0 to lift the limit.
+        """
+        self._simulator.set_speed_limit(speed)
+
+    def get_telemetry(self) -> Optional[TelemetryData]:
+        """
+        Returns the simulated telemetry.
+
+        Returns:
+            Optional[TelemetryData]: Simulated position and battery, at the origin while stopped.
+        """
+        with self._lock:
+            flight_time = self._flight_time
+            if self._start_time is not None:
+                flight_time += sim_clock.now() - self._start_time
+
+        xy = self._simulator.get_xy()
+        x, y = (xy.x, xy.y) if xy is not None else (0.0, 0.0)
+
+        full_voltage, empty_voltage = config.TELEMETRY_SIMULATOR_VOLTAGE
+        remaining_time = max(config.TELEMETRY_SIMULATOR_FLIGHT_TIME - flight_time, 0.0)
+        level = remaining_time / config.TELEMETRY_SIMULATOR_FLIGHT_TIME
+        voltage = empty_voltage + (full_voltage - empty_voltage) * level
+        return TelemetryData(
+            pose=Pose(Position(x, y, config.TELEMETRY_SIMULATOR_ALTITUDE), Orientation(0.0, 0.0, 0.0)),
+            battery=Battery(voltage, voltage, 100.0 * level, remaining_time),
+        )
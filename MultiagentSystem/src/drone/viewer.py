@@ -1,14 +1,17 @@
-from typing import Optional
+from typing import Optional, Tuple
 from configuration import viewer as config
 import cv2
+import numpy as np
 import threading
 import logging
 from queue import Empty, Queue
 from numpy import ndarray
-from time import sleep
+from time import monotonic, sleep
 
 from interfaces.interfaces import AFrameConsumer
 from structures.structures import FrameWithTelemetry
+from utils.frame_mailbox import FrameMailbox
+from utils import metrics
 
 class Viewer(AFrameConsumer):
     """
@@ -27,7 +30,10 @@ class Viewer(AFrameConsumer):
         """
         Creates a Viewer instance.
         """
-        self._queue = Queue(maxsize=config.VIEWER_MAX_QUEUE_SIZE)
+        self._queue = FrameMailbox(config.VIEWER_MAILBOX_SIZE) if config.VIEWER_MAILBOX_SIZE > 0 \
+            else Queue(maxsize=config.VIEWER_MAX_QUEUE_SIZE)
+
+        self._text_cache: Optional[Tuple[tuple, ndarray, ndarray]] = None
 
         self._running: bool = False
         self._thread: Optional[threading.Thread] = None
@@ -75,56 +81,113 @@ class Viewer(AFrameConsumer):
     # ----------------------------------------------------------------------
     # Private methods
     # ----------------------------------------------------------------------
-    def _process_frame(self, fwt: FrameWithTelemetry) -> ndarray:
+    def _process_frame(self, fwt: FrameWithTelemetry) -> Optional[ndarray]:
         """
         Draws telemetry overlay on the frame.
 
+        Only the bar region is darkened, and the text is pasted from a layer rendered once
+        per change of the displayed values (see _text_layer).
+
         Args:
             fwt (FrameWithTelemetry): Frame with telemetry associated.
 
         Returns:
-            ndarray: Frame with its telemetry information rendered on top.
+            Optional[ndarray]: Frame with its telemetry information rendered on top, None if it could not be decoded.
         """
-        data = fwt.frame.data
+        data = fwt.frame.image()
+        if data is None:
+            self._logger.warning("Failed to decode frame %d.", fwt.frame.frame_id)
+            return None
         telemetry = fwt.telemetry
         self._logger.debug("Processing frame of shape %s.", data.shape)
 
-        overlay = data.copy()
+        frame = data.copy()
+        bar = frame[:config.VIEWER_BAR_HEIGHT]
+        cv2.convertScaleAbs(bar, dst=bar, alpha=1 - config.VIEWER_OVERLAY_ALPHA)
 
-        cv2.rectangle(overlay, (0, 0), (data.shape[1], config.VIEWER_BAR_HEIGHT), (0, 0, 0), -1)
-        frame = cv2.addWeighted(overlay, config.VIEWER_OVERLAY_ALPHA, data, 1 - config.VIEWER_OVERLAY_ALPHA, 0)
+        lines = (
+            f"x:{telemetry.pose.position.x:.1f} y:{telemetry.pose.position.y:.1f}, z:{telemetry.pose.position.z:.1f}",
+            f"pitch:{telemetry.pose.orientation.pitch:.2f}  roll:{telemetry.pose.orientation.roll:.2f}  yaw:{telemetry.pose.orientation.yaw:.2f}",
+            f"voltage: {telemetry.battery.voltage:.2f}",
+        )
+        text, mask = self._text_layer(lines, bar.shape)
+        np.copyto(bar, text, where=mask)
 
-        line1 = f"x:{telemetry.pose.position.x:.1f} y:{telemetry.pose.position.y:.1f}, z:{telemetry.pose.position.z:.1f}"
-        line2 = f"pitch:{telemetry.pose.orientation.pitch:.2f}  roll:{telemetry.pose.orientation.roll:.2f}  yaw:{telemetry.pose.orientation.yaw:.2f}"
-        line3 = f"voltage: {telemetry.battery.voltage:.2f}"
+        return frame
 
-        def draw_text(text, y):
-            font = cv2.FONT_HERSHEY_SIMPLEX
-            cv2.putText(frame, text, (11, y + 2), font, config.VIEWER_FONT_SIZE, (0, 0, 0), 1, cv2.LINE_AA)
-            cv2.putText(frame, text, (10, y), font, config.VIEWER_FONT_SIZE, (255, 255, 255), 1, cv2.LINE_AA)
+    def _text_layer(self, lines: Tuple[str, ...], shape: Tuple[int, ...]) -> Tuple[ndarray, ndarray]:
+        """
+        Returns the rendered overlay text, rendering it only when the lines or the bar size change.
 
-        draw_text(line1, 22)
-        draw_text(line2, 44)
-        draw_text(line3, 66)
+        Args:
+            lines (Tuple[str, ...]): Text lines of the bar.
+            shape (Tuple[int, ...]): Shape of the bar region.
 
-        return frame
+        Returns:
+            Tuple[ndarray, ndarray]: Text with its shadow over black, and the mask of its pixels.
+        """
+        key = (lines, shape)
+        if self._text_cache is not None and self._text_cache[0] == key:
+            return self._text_cache[1], self._text_cache[2]
+
+        text = np.zeros(shape, np.uint8)
+        coverage = np.zeros(shape[:2], np.uint8)
+        font = cv2.FONT_HERSHEY_SIMPLEX
+        for line, y in zip(lines, (22, 44, 66)):
+            for org, color in (((11, y + 2), (0, 0, 0)), ((10, y), (255, 255, 255))):
+                cv2.putText(text, line, org, font, config.VIEWER_FONT_SIZE, color, 1, cv2.LINE_AA)
+                cv2.putText(coverage, line, org, font, config.VIEWER_FONT_SIZE, 255, 1, cv2.LINE_AA)
+        mask = (coverage > 0)[..., None]
+
+        self._text_cache = (key, text, mask)
+        return text, mask
+
+    def _latest(self, fwt: FrameWithTelemetry) -> FrameWithTelemetry:
+        """
+        Takes the newest frame waiting in the queue, skipping the older ones.
+
+        Args:
+            fwt (FrameWithTelemetry): Frame already taken from the queue.
+
+        Returns:
+            FrameWithTelemetry: Newest frame, fwt if none is waiting.
+        """
+        while True:
+            try:
+                newer = self._queue.get_nowait()
+            except Empty:
+                return fwt
+            self._logger.debug("Skipped frame %d.", fwt.frame.frame_id)
+            metrics.inc("frames_skipped_total", "Viewer")
+            fwt = newer
 
     def _loop(self):
         """
         Background thread loop.
 
         Continuously retrieves frames from the queue, applies telemetry overlay, 
-        and renders them. Pressing ESC stops the viewer.
+        and renders them. The display is limited to VIEWER_MAX_FPS: between two displays
+        the frames are skipped, and the newest one is displayed. Pressing ESC stops the viewer.
         """
+        period = 1.0 / config.VIEWER_MAX_FPS if config.VIEWER_MAX_FPS > 0 else 0.0
+        next_display = 0.0
         while self._running:
             try:
                 fwt = self._queue.get(timeout=0.05)
             except Empty:
                 sleep(config.VIEWER_SLEEP_TIME)
                 continue
+            wait = next_display - monotonic()
+            if wait > 0:
+                sleep(wait)
+            fwt = self._latest(fwt)
+            next_display = max(next_display + period, monotonic())
             try:
                 frame_display = self._process_frame(fwt)
+                if frame_display is None:
+                    continue
                 cv2.imshow("Drone Camera Live", frame_display)
+                metrics.inc("frames_total", "displayed")
                 if cv2.waitKey(1) & 0xFF == 27:
                     self._logger.info("ESC pressed. Closing viewer...")
                     self.stop()
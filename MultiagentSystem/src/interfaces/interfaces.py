@@ -1,7 +1,9 @@
 from abc import ABC, abstractmethod
-from typing import Dict, List, Optional, Callable, Any
+from typing import Dict, List, Optional, Callable, Any, Union
 from queue import Queue, Full, Empty
 from structures.structures import Frame, FrameWithTelemetry, Point2D, TelemetryData
+from utils.frame_mailbox import FrameMailbox
+from utils import metrics
 
 class ITelemetry(ABC):
     """Interface for telemetry providers."""
@@ -16,6 +18,18 @@ class ITelemetry(ABC):
         """Stops telemetry data acquisition."""
         pass
 
+    def pause(self) -> None:
+        """
+        Pauses telemetry data acquisition between routines.
+
+        Providers with a costly connection keep it open; the others stop.
+        """
+        self.stop()
+
+    def resume(self) -> None:
+        """Resumes telemetry data acquisition after pause."""
+        self.start()
+
     @abstractmethod
     def get_telemetry(self) -> Optional[TelemetryData]:
         """
@@ -26,6 +40,31 @@ class ITelemetry(ABC):
         """
         pass
 
+    def get_telemetry_at(self, host_time_us: int) -> Optional[TelemetryData]:
+        """
+        Retrieves the telemetry data at a past time.
+
+        Providers without pose history return the current telemetry data.
+
+        Args:
+            host_time_us (int): Time on the ground station monotonic clock (in microseconds), see utils.clock_offset.
+
+        Returns:
+            Optional[TelemetryData]: The telemetry data closest to that time, or None if unavailable.
+        """
+        return self.get_telemetry()
+
+    def set_speed_limit(self, speed: float) -> None:
+        """
+        Limits the ground speed of the drone, or of the movement simulator providing its position.
+
+        Providers that cannot command the drone ignore it.
+
+        Args:
+            speed (float): Largest ground speed (in m/s), 0 to lift the limit.
+        """
+        pass
+
 class IMovementSimulator(ABC):
     """Interface for 2D movement simulators."""
 
@@ -49,6 +88,15 @@ class IMovementSimulator(ABC):
         """
         pass
 
+    def set_speed_limit(self, speed: float) -> None:
+        """
+        Limits the linear speed of the movement. Simulators without a set speed ignore it.
+
+        Args:
+            speed (float): Largest linear speed (in m/s), 0 to lift the limit.
+        """
+        pass
+
 class ICamera(ABC):
     """Interface for frames providers."""
 
@@ -62,13 +110,47 @@ class ICamera(ABC):
         """Stops the frame acquisition."""
         pass
 
+    def pause(self) -> None:
+        """
+        Pauses the frame acquisition between routines.
+
+        Providers with a costly connection keep it open; the others stop.
+        """
+        self.stop()
+
+    def resume(self) -> None:
+        """Resumes the frame acquisition after pause."""
+        self.start()
+
     @abstractmethod
-    def get_frame(self) -> Optional[Frame]:
+    def get_frame(self, last_frame_id: int = -1) -> Optional[Frame]:
         """
         Retrieves the current frame.
 
+        The frame is shared, not copied: its data array is read-only.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
+
         Returns:
-            Optional[Frame]: The current frame, or None if unavailable.
+            Optional[Frame]: The current frame, or None if unavailable or still the frame
+            with last_frame_id.
+        """
+        pass
+
+    @abstractmethod
+    def wait_frame(self, last_frame_id: int = -1, timeout: Optional[float] = None) -> Optional[Frame]:
+        """
+        Waits for a frame newer than the one with last_frame_id.
+
+        Returns as soon as the provider publishes a new frame, shared and not copied as with get_frame.
+
+        Args:
+            last_frame_id (int): Id of the last frame the caller got, -1 if none.
+            timeout (Optional[float]): Longest wait (in seconds), None to wait without limit.
+
+        Returns:
+            Optional[Frame]: The new frame, or None on timeout.
         """
         pass
 
@@ -85,7 +167,7 @@ class ICamera(ABC):
 class AFrameConsumer(ABC):
     """Abstract class for components that process frames with telemetry."""
     
-    _queue: Queue
+    _queue: Union[Queue, FrameMailbox]
 
     @abstractmethod
     def start(self) -> None:
@@ -101,13 +183,18 @@ class AFrameConsumer(ABC):
         """
         Enqueues a FrameWithTelemetry object for processing.
 
+        The oldest frame is dropped when the queue is full. A FrameMailbox drops it by
+        itself, without the retries a Queue needs.
+
         Args:
             fwt (FrameWithTelemetry): Frame data with associated telemetry to enqueue.
         """
+        if self._queue.full():
+            metrics.inc("frames_dropped_total", type(self).__name__)
         while True:
             try:
                 self._queue.put_nowait(fwt)
-                self._logger.debug("Enqueued frame of shape %s", fwt.frame.data.shape)
+                self._logger.debug("Enqueued frame %d", fwt.frame.frame_id)
                 break
             except Full:
                 try:
@@ -133,10 +220,12 @@ class ARobot(ABC):
     Attributes:
         _callback_onPoint (Optional[Callable[[Point2D], None]]): Callback for when a point is reached.
         _callback_onFinish (Optional[Callable[[], None]]): Callback for when routine finishes.
+        _callback_onCoverage (Optional[Callable[[Point2D, float], None]]): Callback for when the robot sees an area.
     """
 
     _callback_onPoint: Optional[Callable[[Point2D], None]] = None
     _callback_onFinish: Optional[Callable[[], None]] = None
+    _callback_onCoverage: Optional[Callable[[Point2D, float], None]] = None
 
     @abstractmethod
     def start_routine(self, positions: Optional[List[Point2D]]) -> None:
@@ -158,6 +247,12 @@ class ARobot(ABC):
         """
         pass
 
+    def shutdown(self) -> None:
+        """
+        Releases what the robot keeps between routines, once no routine follows.
+        """
+        pass
+
     def set_callback_onPoint(self, callback: Callable[[Point2D], None]) -> None:
         """
         Register a callback triggered when the robot reaches a target point.
@@ -176,6 +271,16 @@ class ARobot(ABC):
         """
         self._callback_onFinish = callback
 
+    def set_callback_onCoverage(self, callback: Callable[[Point2D, float], None]) -> None:
+        """
+        Register a callback triggered when the robot sees a ground area, for robots that survey the ground.
+
+        Args:
+            callback (Callable[[Point2D, float], None]): Function to call with the centre and radius (in meters)
+            of the disk seen.
+        """
+        self._callback_onCoverage = callback
+
     @abstractmethod
     def get_current_position(self) -> Optional[Point2D]:
         """
@@ -196,9 +301,51 @@ class ARobot(ABC):
         """
         pass
 
+class IDistanceProvider(ABC):
+    """Interface for travel distance providers of the ground robots."""
+
+    @abstractmethod
+    def distance(self, p1: Point2D, p2: Point2D) -> float:
+        """
+        Computes the travel distance between two points.
+
+        Args:
+            p1 (Point2D): First point.
+            p2 (Point2D): Second point.
+
+        Returns:
+            float: Length of the shortest feasible path (in meters).
+        """
+        pass
+
+    @abstractmethod
+    def path(self, p1: Point2D, p2: Point2D) -> List[Point2D]:
+        """
+        Computes the shortest feasible path between two points.
+
+        Args:
+            p1 (Point2D): Start point.
+            p2 (Point2D): End point.
+
+        Returns:
+            List[Point2D]: Waypoints to follow from the start point, ending with the end point.
+        """
+        pass
+
 class IPathPlanner(ABC):
     """Interface for path planning algorithms."""
 
+    _distance: IDistanceProvider
+
+    def get_distance_provider(self) -> IDistanceProvider:
+        """
+        Returns the distance provider the planner plans with.
+
+        Returns:
+            IDistanceProvider: Travel distance provider.
+        """
+        return self._distance
+
     @abstractmethod
     def plan_path(self, start: Point2D, points: List[Point2D]) -> List[Point2D]:
         """
@@ -0,0 +1,210 @@
+from drone.drone import Drone
+from drone.camera_control import CameraControl
+from drone.camera_stream_capture import CameraStreamCapture
+from drone.color_detection import ColorDetection
+from drone.telemetry_simulator import TelemetrySimulator
+from interfaces.interfaces import IMovementSimulator
+from structures.structures import DetectionTrace, Point2D
+from utils.clock_offset import local_time_us
+from utils.logs import ColoredFormatter
+from datetime import datetime
+from queue import Queue, Empty
+from time import monotonic, sleep
+from typing import Dict, List, Optional
+import argparse
+import json
+import logging
+import os
+
+import configuration
+from configuration import benchmark as config
+
+# Stage name: what it spans. The stages up to "check" add up to the total, from the stimulus
+# command to the call of Drone._on_color_detected.
+STAGES: Dict[str, str] = {
+    "capture": "stimulus command to the sensor capture of the detected frame",
+    "queue": "capture to the frame stream task taking the frame, on the camera",
+    "encode": "JPEG encoding on the camera, 0 if the sensor output JPEG",
+    "send": "rest of the way to the ground station: sending, network and receiving",
+    "match": "reception to the match with telemetry",
+    "wait": "match to a detection worker taking the frame",
+    "decode": "JPEG decoding of the batch",
+    "infer": "YOLO inference on the batch",
+    "check": "color check, ground projection and tracking, up to the detection callback",
+    "total": "stimulus command to the detection callback",
+    "callback": "Drone._on_color_detected itself, flash included",
+    "control": "round trip of the stimulus command, the uncertainty of its time",
+}
+
+class _Hover(IMovementSimulator):
+    """Movement simulator of a drone hovering over the origin, in front of the stimulus."""
+
+    def start(self) -> None:
+        """Does nothing, the drone does not move."""
+        pass
+
+    def stop(self) -> None:
+        """Does nothing, the drone does not move."""
+        pass
+
+    def get_xy(self) -> Optional[Point2D]:
+        """
+        Returns the origin.
+
+        Returns:
+            Optional[Point2D]: The origin.
+        """
+        return Point2D(0.0, 0.0)
+
+def stage_times(trace: DetectionTrace, stimulus_us: int, acked_us: int) -> Dict[str, float]:
+    """
+    Splits the latency of a detection into its stages.
+
+    Args:
+        trace (DetectionTrace): Stage times of the frame that confirmed the detection.
+        stimulus_us (int): Time the stimulus command was sent (in microseconds, see utils.clock_offset).
+        acked_us (int): Time the camera acknowledged the stimulus command (in microseconds).
+
+    Returns:
+        Dict[str, float]: Duration of each stage of STAGES (in milliseconds).
+    """
+    frame = trace.frame
+    times = {
+        "capture": frame.host_capture_us - stimulus_us,
+        "queue": frame.camera_queue_us,
+        "encode": frame.encode_us,
+        "send": frame.receive_us - frame.host_capture_us - frame.camera_queue_us - frame.encode_us,
+        "match": trace.matched_us - frame.receive_us,
+        "wait": trace.dequeued_us - trace.matched_us,
+        "decode": trace.decoded_us - trace.dequeued_us,
+        "infer": trace.inferred_us - trace.decoded_us,
+        "check": trace.fired_us - trace.inferred_us,
+        "total": trace.fired_us - stimulus_us,
+        "callback": trace.returned_us - trace.fired_us,
+        "control": acked_us - stimulus_us,
+    }
+    return {stage: us / 1000 for stage, us in times.items()}
+
+def percentile(values: List[float], fraction: float) -> float:
+    """
+    Returns a percentile of values, by the nearest rank.
+
+    Args:
+        values (List[float]): Values, not empty.
+        fraction (float): Percentile, from 0 to 1.
+
+    Returns:
+        float: Value at that rank.
+    """
+    ordered = sorted(values)
+    return ordered[min(int(fraction * len(ordered)), len(ordered) - 1)]
+
+parser = argparse.ArgumentParser(description="Measures the latency from a stimulus in front of the camera to the detection "
+                                             "callback of the drone, stage by stage.")
+parser.add_argument("--stimulus", choices=["led", "colorbar"], default="led",
+                    help="Flash LED lighting a target of the detected color, or the sensor color bar test pattern.")
+parser.add_argument("--intensity", type=int, default=255, help="Flash LED intensity of the led stimulus.")
+parser.add_argument("--trials", type=int, default=config.LATENCY_BENCHMARK_TRIALS, help="Number of stimuli.")
+parser.add_argument("--color", default=configuration.color_detection.COLOR_DETECTION_COLOR, help="Color to detect.")
+parser.add_argument("--model", default=configuration.color_detection.YOLO_MODEL_PATH, help="YOLO model of the color detection.")
+parser.add_argument("--hover-skip", action="store_true",
+                    help="Keep skipping the frames over ground just seen, as a hovering drone does, instead of running YOLO on every frame.")
+args = parser.parse_args()
+
+handler = logging.StreamHandler()
+handler.setFormatter(ColoredFormatter("[%(levelname)s] %(name)s: %(message)s"))
+logging.basicConfig(level=logging.WARNING, handlers=[handler])
+logger = logging.getLogger("LatencyBenchmark")
+logger.setLevel(logging.INFO)
+
+if not args.hover_skip:
+    # The drone hovers in front of the stimulus: without this, the frames over the ground it has just
+    # seen would be skipped for up to COLOR_DETECTION_MAX_SKIP_INTERVAL, which measures the skipping
+    configuration.color_detection.COLOR_DETECTION_MAX_OVERLAP = 1.0
+
+var, on_value = ("led_intensity", args.intensity) if args.stimulus == "led" else ("colorbar", 1)
+
+camera = CameraStreamCapture(configuration.camera_capture.CAMERA_FRAME_STREAM_HOST,
+                             configuration.camera_capture.CAMERA_FRAME_STREAM_PORT,
+                             configuration.camera_capture.CAMERA_FLASH_URL)
+control = CameraControl(configuration.camera_capture.CAMERA_FLASH_URL)
+color_detector = ColorDetection(args.color, args.model)
+if not color_detector.wait_ready():
+    raise SystemExit("Color detection could not load its YOLO model.")
+
+drone = Drone(telemetry=TelemetrySimulator(_Hover()), camera=camera, color_detection=color_detector, show_viewer=False)
+traces: Queue[DetectionTrace] = Queue()
+color_detector.set_trace_callback(traces.put)
+
+control.set(var, 0)
+drone.start_routine()
+estimate = None
+deadline = monotonic() + config.LATENCY_BENCHMARK_SYNC_TIMEOUT
+while monotonic() < deadline and not ((estimate := camera.get_clock_estimate()) and estimate.synced):
+    sleep(0.1)
+if not (estimate and estimate.synced):
+    drone.shutdown()
+    control.close()
+    raise SystemExit("The camera clock could not be synchronized, capture times would be off.")
+logger.info("Camera clock synchronized within %.2f ms, %s stimulus on %s", estimate.error_us / 1000, args.stimulus, var)
+
+trials: List[Dict[str, float]] = []
+missed = 0
+for trial in range(args.trials):
+    control.set(var, 0)
+    sleep(config.LATENCY_BENCHMARK_OFF_TIME)
+    # Forgets the object of the previous trial, which would be reported only once
+    color_detector.stop()
+    color_detector.start()
+    while not traces.empty():
+        traces.get_nowait()
+
+    stimulus_us = local_time_us()
+    if not control.set(var, on_value):
+        logger.warning("Trial %d: the camera refused the stimulus.", trial)
+        missed += 1
+        continue
+    acked_us = local_time_us()
+
+    trace = None
+    wait_deadline = monotonic() + config.LATENCY_BENCHMARK_TIMEOUT
+    while trace is None and monotonic() < wait_deadline:
+        try:
+            trace = traces.get(timeout=max(wait_deadline - monotonic(), 0.0))
+        except Empty:
+            break
+        if trace.frame.host_capture_us < stimulus_us:
+            logger.warning("Trial %d: detection in a frame captured before the stimulus, ignored.", trial)
+            trace = None
+    if trace is None:
+        logger.warning("Trial %d: no detection within %.1f s.", trial, config.LATENCY_BENCHMARK_TIMEOUT)
+        missed += 1
+        continue
+
+    times = stage_times(trace, stimulus_us, acked_us)
+    trials.append(times)
+    logger.info("Trial %d: %.1f ms (frame %d)", trial, times["total"], trace.frame.seq)
+
+control.set(var, 0)
+drone.shutdown()
+control.close()
+
+print(f"{len(trials)} of {args.trials} stimuli detected")
+summary = {}
+if trials:
+    print(f"{'stage':<10} {'mean ms':>9} {'p50 ms':>9} {'p95 ms':>9} {'max ms':>9}  span")
+    for stage, span in STAGES.items():
+        values = [times[stage] for times in trials]
+        summary[stage] = {"mean": sum(values) / len(values), "p50": percentile(values, 0.5),
+                          "p95": percentile(values, 0.95), "max": max(values)}
+        row = summary[stage]
+        print(f"{stage:<10} {row['mean']:>9.1f} {row['p50']:>9.1f} {row['p95']:>9.1f} {row['max']:>9.1f}  {span}")
+
+timestamp = datetime.now().strftime("%Y_%m_%d_%H_%M_%S")
+os.makedirs(config.BENCHMARK_OUTPUT_FOLDER, exist_ok=True)
+path = f"{config.BENCHMARK_OUTPUT_FOLDER}/latency_{timestamp}.json"
+with open(path, "w") as f:
+    json.dump({"stimulus": args.stimulus, "backend": color_detector.get_backend(), "trials": args.trials,
+               "missed": missed, "clock_error_ms": estimate.error_us / 1000, "summary": summary,
+               "detections": trials}, f, indent=4)
+logger.info(f"Latency benchmark results saved to {os.path.abspath(path)}")
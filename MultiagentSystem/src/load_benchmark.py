@@ -0,0 +1,134 @@
+from drone.drone import Drone
+from drone.camera_simulator import CameraSimulator
+from drone.color_detection import ColorDetection
+from drone.telemetry_simulator import TelemetrySimulator
+from drone.movementSimulator.spiral_movement_simulator import SpiralMovementSimulator
+from structures.structures import DetectionTrace
+from utils.logs import ColoredFormatter
+from utils import metrics, sim_clock
+from datetime import datetime
+from typing import Dict, List
+import argparse
+import json
+import logging
+import os
+
+import configuration
+from configuration import benchmark as config
+
+FRAME_COUNTERS = ("frames_total", "frames_dropped_total", "frames_skipped_total")
+"""Pipeline counters reported by stage, see utils.metrics."""
+
+def counter_changes(before: Dict, after: Dict) -> Dict[str, float]:
+    """
+    Returns the changes of the frame counters between two metrics snapshots.
+
+    Args:
+        before (Dict): Counter values of the first snapshot, by name and stage.
+        after (Dict): Counter values of the second snapshot, by name and stage.
+
+    Returns:
+        Dict[str, float]: Change of each counter that changed, by "name/stage".
+    """
+    return {f"{name}/{stage}": value - before.get((name, stage), 0)
+            for (name, stage), value in sorted(after.items())
+            if name in FRAME_COUNTERS and value != before.get((name, stage), 0)}
+
+def run_rate(fps: float, detector: ColorDetection, duration: float, bank_size: int) -> Dict:
+    """
+    Flies a simulated drone over the frame bank served at a frame rate and counts the frames at each stage.
+
+    Args:
+        fps (float): Frame rate (in frames per second).
+        detector (ColorDetection): Color detection, loaded.
+        duration (float): Duration (in simulated seconds).
+        bank_size (int): Number of frames in the frame bank.
+
+    Returns:
+        Dict: Frames served by the camera, frame counters by stage, frames YOLO processed and skipped,
+        95th percentile match to detection latency (in milliseconds) and confirmed objects,
+        with the ones confirmed by a frame without a target object.
+    """
+    camera = CameraSimulator(frame_period=1 / fps, bank_size=bank_size)
+    drone = Drone(
+        telemetry=TelemetrySimulator(SpiralMovementSimulator(
+            configuration.movement_simulator.SPIRAL_SIMULATOR_RADIAL_GROWTH,
+            configuration.movement_simulator.SPIRAL_SIMULATOR_LINEAR_SPEED
+        )),
+        camera=camera,
+        color_detection=detector,
+        show_viewer=False,
+    )
+    traces: List[DetectionTrace] = []
+    detector.set_trace_callback(traces.append)
+
+    registry = metrics.get_registry()
+    counters_before, histograms_before, _ = registry.snapshot()
+    stats_before = detector.get_frame_stats()
+    drone.start_routine()
+    first_id = camera.get_frame().frame_id
+    sim_clock.sleep(duration)
+    last_id = camera.get_frame().frame_id
+    drone.shutdown()
+    counters_after, histograms_after, _ = registry.snapshot()
+    stats_after = detector.get_frame_stats()
+
+    key = ("latency_seconds", "match_to_detect")
+    latency_after = histograms_after.get(key, [])
+    latency_before = histograms_before.get(key, [0] * len(latency_after))
+    p95 = registry.quantile([n - m for n, m in zip(latency_after, latency_before)], 0.95) if latency_after else None
+    return {
+        "fps": fps,
+        "served": last_id - first_id + 1,
+        "counters": counter_changes(counters_before, counters_after),
+        "processed": stats_after["processed"] - stats_before["processed"],
+        "skipped": stats_after["skipped"] - stats_before["skipped"],
+        "p95_match_to_detect_ms": p95 * 1000 if p95 is not None else None,
+        "objects": len(traces),
+        "false_objects": sum(not camera.get_ground_truth(trace.frame.frame_id).target for trace in traces),
+    }
+
+parser = argparse.ArgumentParser(description="Serves a pre-rendered frame bank at increasing frame rates to measure the "
+                                             "throughput and the frame drops of the matcher and the color detection.")
+parser.add_argument("--fps", nargs="+", type=float, default=config.LOAD_BENCHMARK_FPS, help="Frame rates to serve.")
+parser.add_argument("--duration", type=float, default=config.LOAD_BENCHMARK_DURATION,
+                    help="Duration (in simulated seconds) of each frame rate.")
+parser.add_argument("--bank-size", type=int, default=config.LOAD_BENCHMARK_BANK_SIZE, help="Number of pre-rendered frames.")
+parser.add_argument("--color", default=configuration.color_detection.COLOR_DETECTION_COLOR, help="Color to detect.")
+parser.add_argument("--model", default=configuration.color_detection.YOLO_MODEL_PATH, help="YOLO model of the color detection.")
+parser.add_argument("--overlap-skip", action="store_true",
+                    help="Keep skipping the frames over ground just seen, instead of running YOLO on every frame.")
+args = parser.parse_args()
+
+handler = logging.StreamHandler()
+handler.setFormatter(ColoredFormatter("[%(levelname)s] %(name)s: %(message)s"))
+logging.basicConfig(level=logging.WARNING, handlers=[handler])
+logger = logging.getLogger("LoadBenchmark")
+logger.setLevel(logging.INFO)
+
+if not args.overlap_skip:
+    # Every frame is offered to YOLO, so that the load is the frame rate
+    configuration.color_detection.COLOR_DETECTION_MAX_OVERLAP = 1.0
+
+color_detector = ColorDetection(args.color, args.model)
+if not color_detector.wait_ready():
+    raise SystemExit("Color detection could not load its YOLO model.")
+
+results = []
+print(f"{'fps':>6} {'served':>7} {'matched':>8} {'dropped':>8} {'processed':>10} {'proc/s':>7} {'p95 ms':>8} {'objects':>8} {'false':>6}")
+for fps in args.fps:
+    row = run_rate(fps, color_detector, args.duration, args.bank_size)
+    results.append(row)
+    matched = row["counters"].get("frames_total/matched", 0)
+    dropped = sum(value for name, value in row["counters"].items() if name.startswith("frames_dropped_total"))
+    p95 = f"{row['p95_match_to_detect_ms']:8.0f}" if row["p95_match_to_detect_ms"] is not None else f"{'-':>8}"
+    print(f"{fps:>6g} {row['served']:>7} {matched:>8g} {dropped:>8g} {row['processed']:>10} "
+          f"{row['processed'] / args.duration:>7.1f} {p95} {row['objects']:>8} {row['false_objects']:>6}")
+
+timestamp = datetime.now().strftime("%Y_%m_%d_%H_%M_%S")
+os.makedirs(config.BENCHMARK_OUTPUT_FOLDER, exist_ok=True)
+path = f"{config.BENCHMARK_OUTPUT_FOLDER}/load_{timestamp}.json"
+with open(path, "w") as f:
+    json.dump({"duration": args.duration, "bank_size": args.bank_size, "backend": color_detector.get_backend(),
+               "results": results}, f, indent=4)
+logger.info(f"Load benchmark results saved to {os.path.abspath(path)}")
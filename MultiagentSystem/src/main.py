@@ -3,66 +3,91 @@ from drone.drone_telemetry import DroneTelemetry
 from drone.camera_capture import CameraCapture
 from drone.camera_simulator import CameraSimulator
 from drone.color_detection import ColorDetection
+from drone.detection_process import DetectionProcess
+from drone.flight_recorder import FlightRecorder
 from drone.movementSimulator.spiral_movement_simulator import SpiralMovementSimulator
 from robotDog.robot_dog_simulator import RobotDogSimulator
 from operation.operation_controller import OperationController
 from operation.operation_visualizer import OperationVisualizer
 from drone.movementSimulator.zigzag_movement_simulator import ZigzagMovementSimulator
 from utils.logs import ColoredFormatter, LoggerNameFilter
-from planners.nearest_neighbor_planner import NearestNeighborPlanner
+from utils import sim_clock
+from utils.metrics import MetricsReporter
+from planners.local_search_planner import LocalSearchPlanner
+from planners.distance_providers import ObstacleDistanceProvider
 import logging
 
 import configuration
 
-handler = logging.StreamHandler()
-handler.setFormatter(ColoredFormatter("[%(levelname)s] %(name)s: %(message)s"))
-
-logging.basicConfig(
-    level=logging.INFO,  
-    handlers=[handler]
-)
-
-spiralMovement = SpiralMovementSimulator(
-    configuration.movement_simulator.SPIRAL_SIMULATOR_RADIAL_GROWTH,
-    configuration.movement_simulator.SPIRAL_SIMULATOR_LINEAR_SPEED
-)
-
-zigzagMovement = ZigzagMovementSimulator(
-    configuration.movement_simulator.ZIGZAG_SIMULATOR_MAX_HORIZONTAL_DISTANCE,
-    configuration.movement_simulator.ZIGZAG_SIMULATOR_LINEAR_SPEED
-)
-
-telemetry = DroneTelemetry(
-    configuration.drone_telemetry.DRONE_IP, 
-    configuration.drone_telemetry.DRONE_PORT, 
-    configuration.drone_telemetry.LOCAL_PORT, 
-    spiralMovement
-)
-
-camera = CameraCapture(
-    configuration.camera_capture.CAMERA_STREAM_URL, 
-    configuration.camera_capture.CAMERA_FLASH_URL
-)
-
-cameraSimulator = CameraSimulator()
-color_detector = ColorDetection(configuration.color_detection.COLOR_DETECTION_COLOR, configuration.color_detection.YOLO_MODEL_PATH)
-
-explorer = Drone(
-    telemetry=telemetry,
-    camera=cameraSimulator,
-    color_detection=color_detector,
-) 
-
-inspector = RobotDogSimulator(configuration.robot_dog.ROBOT_DOG_SPEED)
-
-planner = NearestNeighborPlanner()
-
-controller = OperationController(
-    explorer_robot=explorer, 
-    inspector_robot=inspector, 
-    planner=planner, 
-    base_positions_path=configuration.operation.BASE_POSITIONS_PATH
-)
-
-visualizer = OperationVisualizer(controller)
-visualizer.start()
+def main() -> None:
+    """Runs an operation with the explorer drone, the inspector robots and the operation visualizer."""
+    handler = logging.StreamHandler()
+    handler.setFormatter(ColoredFormatter("[%(levelname)s] %(name)s: %(message)s"))
+
+    logging.basicConfig(
+        level=logging.INFO,  
+        handlers=[handler]
+    )
+
+    if configuration.simulation.SIMULATION_DISCRETE_EVENT:
+        sim_clock.set_clock(sim_clock.DiscreteEventClock())
+    elif configuration.simulation.SIMULATION_SPEED != 1.0:
+        sim_clock.set_clock(sim_clock.SimulationClock(configuration.simulation.SIMULATION_SPEED))
+
+    if configuration.metrics.METRICS_ENABLED:
+        MetricsReporter().start()
+
+    spiralMovement = SpiralMovementSimulator(
+        configuration.movement_simulator.SPIRAL_SIMULATOR_RADIAL_GROWTH,
+        configuration.movement_simulator.SPIRAL_SIMULATOR_LINEAR_SPEED
+    )
+
+    zigzagMovement = ZigzagMovementSimulator(
+        configuration.movement_simulator.ZIGZAG_SIMULATOR_MAX_HORIZONTAL_DISTANCE,
+        configuration.movement_simulator.ZIGZAG_SIMULATOR_LINEAR_SPEED
+    )
+
+    telemetry = DroneTelemetry(
+        configuration.drone_telemetry.DRONE_IP, 
+        configuration.drone_telemetry.DRONE_PORT, 
+        configuration.drone_telemetry.LOCAL_PORT, 
+        spiralMovement
+    )
+
+    camera = CameraCapture(
+        configuration.camera_capture.CAMERA_STREAM_URL, 
+        configuration.camera_capture.CAMERA_FLASH_URL
+    )
+
+    cameraSimulator = CameraSimulator()
+    if configuration.color_detection.COLOR_DETECTION_PROCESS:
+        color_detector = DetectionProcess(configuration.color_detection.COLOR_DETECTION_COLOR, configuration.color_detection.YOLO_MODEL_PATH)
+    else:
+        color_detector = ColorDetection(configuration.color_detection.COLOR_DETECTION_COLOR, configuration.color_detection.YOLO_MODEL_PATH)
+
+    explorer = Drone(
+        telemetry=telemetry,
+        camera=cameraSimulator,
+        color_detection=color_detector,
+        recorder=FlightRecorder() if configuration.flight_recorder.RECORDER_ENABLED else None,
+    ) 
+
+    inspectors = [RobotDogSimulator(configuration.robot_dog.ROBOT_DOG_SPEED) for _ in range(configuration.robot_dog.ROBOT_DOG_COUNT)]
+
+    planner = LocalSearchPlanner(distance=ObstacleDistanceProvider.from_json(configuration.operation.BASE_POSITIONS_PATH))
+
+    controller = OperationController(
+        explorer_robot=explorer, 
+        inspector_robot=inspectors, 
+        planner=planner, 
+        base_positions_path=configuration.operation.BASE_POSITIONS_PATH
+    )
+
+    visualizer = OperationVisualizer(controller)
+    visualizer.start()
+
+    if isinstance(color_detector, DetectionProcess):
+        color_detector.close()
+
+if __name__ == "__main__":
+    main()
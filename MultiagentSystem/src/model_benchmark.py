@@ -0,0 +1,123 @@
+from drone.color_detection import ColorDetection
+from drone.flight_replay import FlightReplay
+from structures.structures import FrameWithTelemetry, Position
+from utils.logs import ColoredFormatter
+from datetime import datetime
+from time import perf_counter
+from typing import Dict, List
+import argparse
+import json
+import logging
+import math
+import os
+
+import configuration
+from configuration import benchmark as config
+
+def detect(name: str, replay: FlightReplay, color: str) -> Dict:
+    """
+    Runs the color detection with a model over every frame of a recording, one frame at a time.
+
+    Args:
+        name (str): Detection model name.
+        replay (FlightReplay): Recording.
+        color (str): Color to detect.
+
+    Returns:
+        Dict: Backend, mean and 95th percentile time per frame (in milliseconds) and positions of the
+        confirmed objects.
+    """
+    detector = ColorDetection(color, ColorDetection.select_model(name))
+    if not detector.wait_ready():
+        raise SystemExit(f"Color detection could not load the {name} model.")
+    objects: List[Position] = []
+    detector.set_callback(objects.append)
+
+    times = []
+    for index in range(len(replay)):
+        fwt = FrameWithTelemetry(replay.frame(index), replay.telemetry(index))
+        begin = perf_counter()
+        detector._process_frame(fwt)
+        times.append((perf_counter() - begin) * 1000)
+
+    times.sort()
+    return {
+        "backend": detector.get_backend(),
+        "mean_ms": sum(times) / len(times),
+        "p95_ms": times[min(int(0.95 * len(times)), len(times) - 1)],
+        "objects": objects,
+    }
+
+def match(objects: List[Position], reference: List[Position], radius: float) -> int:
+    """
+    Pairs objects with reference objects, closest pairs first.
+
+    Args:
+        objects (List[Position]): Objects found.
+        reference (List[Position]): Reference objects.
+        radius (float): Farthest distance (in meters) of a pair.
+
+    Returns:
+        int: Number of pairs.
+    """
+    pairs = sorted((math.hypot(a.x - b.x, a.y - b.y), i, j)
+                   for i, a in enumerate(objects) for j, b in enumerate(reference))
+    used_objects, used_reference = set(), set()
+    for distance, i, j in pairs:
+        if distance > radius:
+            break
+        if i not in used_objects and j not in used_reference:
+            used_objects.add(i)
+            used_reference.add(j)
+    return len(used_objects)
+
+parser = argparse.ArgumentParser(description="Compares the detection models on a flight recording: objects found, "
+                                             "against a reference model, and time per frame.")
+parser.add_argument("recording", help="Recording folder of the FlightRecorder.")
+parser.add_argument("--models", nargs="+", choices=sorted(configuration.color_detection.COLOR_DETECTION_MODELS),
+                    default=sorted(configuration.color_detection.COLOR_DETECTION_MODELS), help="Detection models to compare.")
+parser.add_argument("--reference", default=config.MODEL_BENCHMARK_REFERENCE,
+                    choices=sorted(configuration.color_detection.COLOR_DETECTION_MODELS), help="Model the others are compared to.")
+parser.add_argument("--color", default=configuration.color_detection.COLOR_DETECTION_COLOR, help="Color to detect.")
+args = parser.parse_args()
+
+handler = logging.StreamHandler()
+handler.setFormatter(ColoredFormatter("[%(levelname)s] %(name)s: %(message)s"))
+logging.basicConfig(level=logging.WARNING, handlers=[handler])
+logger = logging.getLogger("ModelBenchmark")
+logger.setLevel(logging.INFO)
+
+# Every frame goes through YOLO, so the models are compared on the same frames whatever their speed
+configuration.color_detection.COLOR_DETECTION_MAX_OVERLAP = 1.0
+
+replay = FlightReplay(args.recording, speed=None)
+runs = {name: detect(name, replay, args.color) for name in dict.fromkeys([args.reference] + args.models)}
+reference = runs[args.reference]["objects"]
+radius = configuration.color_detection.COLOR_DETECTION_TRACK_RADIUS
+
+results = []
+print(f"{'model':<14} {'backend':<10} {'objects':>7} {'recall':>7} {'precision':>9} {'mean ms':>8} {'p95 ms':>8}")
+for name, run in runs.items():
+    matched = match(run["objects"], reference, radius)
+    row = {
+        "model": name,
+        "backend": run["backend"],
+        "objects": len(run["objects"]),
+        "recall": matched / len(reference) if reference else None,
+        "precision": matched / len(run["objects"]) if run["objects"] else None,
+        "mean_ms": run["mean_ms"],
+        "p95_ms": run["p95_ms"],
+        "positions": [[p.x, p.y] for p in run["objects"]],
+    }
+    results.append(row)
+    recall = f"{row['recall']:7.2f}" if row["recall"] is not None else f"{'-':>7}"
+    precision = f"{row['precision']:9.2f}" if row["precision"] is not None else f"{'-':>9}"
+    print(f"{name:<14} {row['backend']:<10} {row['objects']:>7} {recall} {precision} {row['mean_ms']:>8.1f} {row['p95_ms']:>8.1f}")
+
+timestamp = datetime.now().strftime("%Y_%m_%d_%H_%M_%S")
+os.makedirs(config.BENCHMARK_OUTPUT_FOLDER, exist_ok=True)
+path = f"{config.BENCHMARK_OUTPUT_FOLDER}/models_{timestamp}.json"
+with open(path, "w") as f:
+    json.dump({"recording": args.recording, "reference": args.reference, "frames": len(replay),
+               "track_radius": radius, "results": results}, f, indent=4)
+logger.info(f"Model benchmark results saved to {os.path.abspath(path)}")
@@ -0,0 +1,117 @@
+from drone.color_detection import ColorDetection
+from drone.flight_replay import FlightReplay
+from utils.logs import ColoredFormatter
+from ultralytics import YOLO
+from pathlib import Path
+from typing import List, Tuple
+import argparse
+import logging
+import shutil
+
+import configuration
+from configuration import benchmark as config
+
+def sample_frames(replays: List[FlightReplay], count: int) -> List[Tuple[FlightReplay, int]]:
+    """
+    Picks frames spread evenly over recordings.
+
+    Args:
+        replays (List[FlightReplay]): Recordings.
+        count (int): Largest number of frames.
+
+    Returns:
+        List[Tuple[FlightReplay, int]]: Recording and index of each picked frame.
+    """
+    frames = [(replay, index) for replay in replays for index in range(len(replay))]
+    step = max(len(frames) / count, 1.0)
+    return [frames[int(i * step)] for i in range(min(count, len(frames)))]
+
+def write_dataset(folder: Path, frames: List[Tuple[FlightReplay, int]], teacher: ColorDetection,
+                  val_fraction: float) -> int:
+    """
+    Writes recorded frames as a single-class YOLO dataset, labelled by the teacher detection: an object
+    of the target color is a box YOLO found and the color check kept, as in flight.
+
+    Args:
+        folder (Path): Dataset folder, its data.yaml included.
+        frames (List[Tuple[FlightReplay, int]]): Recording and index of each frame.
+        teacher (ColorDetection): Detection labelling the frames.
+        val_fraction (float): Fraction of the frames kept for validation.
+
+    Returns:
+        int: Number of labelled objects.
+    """
+    every = max(round(1 / val_fraction), 2) if val_fraction > 0 else 0
+    objects = 0
+    for i, (replay, index) in enumerate(frames):
+        frame = replay.frame(index)
+        image = frame.image()
+        if image is None:
+            continue
+        split = "val" if every and i % every == 0 else "train"
+        (folder / "images" / split).mkdir(parents=True, exist_ok=True)
+        (folder / "labels" / split).mkdir(parents=True, exist_ok=True)
+
+        height, width = image.shape[:2]
+        lines = [f"0 {(x1 + x2) / 2 / width:.6f} {(y1 + y2) / 2 / height:.6f} {(x2 - x1) / width:.6f} {(y2 - y1) / height:.6f}"
+                 for x1, y1, x2, y2 in teacher.label(image)]
+        objects += len(lines)
+        (folder / "images" / split / f"frame_{i:05d}.jpg").write_bytes(bytes(frame.jpeg))
+        (folder / "labels" / split / f"frame_{i:05d}.txt").write_text("\n".join(lines))
+
+    (folder / "data.yaml").write_text(f"path: {folder}\ntrain: images/train\nval: images/val\nnames:\n  0: target\n")
+    return objects
+
+parser = argparse.ArgumentParser(description="Builds the calibration dataset of the target model from flight recordings, "
+                                             "fine-tunes it and exports its INT8 backends.")
+parser.add_argument("recordings", nargs="+", help="Recording folders of the FlightRecorder.")
+parser.add_argument("--model", default="target_int8", choices=sorted(configuration.color_detection.COLOR_DETECTION_MODELS),
+                    help="Detection model to build.")
+parser.add_argument("--teacher", default=config.MODEL_BENCHMARK_REFERENCE,
+                    choices=sorted(configuration.color_detection.COLOR_DETECTION_MODELS), help="Detection model labelling the frames.")
+parser.add_argument("--color", default=configuration.color_detection.COLOR_DETECTION_COLOR, help="Color to detect.")
+parser.add_argument("--max-frames", type=int, default=config.MODEL_EXPORT_MAX_FRAMES, help="Largest number of labelled frames.")
+parser.add_argument("--epochs", type=int, default=config.MODEL_EXPORT_EPOCHS,
+                    help="Fine-tuning epochs, 0 to export the model file as it is.")
+args = parser.parse_args()
+
+handler = logging.StreamHandler()
+handler.setFormatter(ColoredFormatter("[%(levelname)s] %(name)s: %(message)s"))
+logging.basicConfig(level=logging.WARNING, handlers=[handler])
+logger = logging.getLogger("ModelExport")
+logger.setLevel(logging.INFO)
+
+configuration.color_detection.COLOR_DETECTION_BACKGROUND_LOAD = False
+
+dataset = configuration.color_detection.COLOR_DETECTION_CALIBRATION_DATA.parent
+shutil.rmtree(dataset, ignore_errors=True)
+teacher = ColorDetection(args.color, ColorDetection.select_model(args.teacher))
+frames = sample_frames([FlightReplay(path) for path in args.recordings], args.max_frames)
+objects = write_dataset(dataset, frames, teacher, config.MODEL_EXPORT_VAL_FRACTION)
+logger.info("Labelled %d objects in %d frames with the %s model, dataset in %s", objects, len(frames), args.teacher, dataset)
+
+target = configuration.color_detection.COLOR_DETECTION_MODELS[args.model]
+if args.epochs > 0:
+    # Starts from the teacher weights, with a single class at the input size of the target model
+    results = YOLO(str(configuration.color_detection.COLOR_DETECTION_MODELS[args.teacher]["path"])).train(
+        data=str(configuration.color_detection.COLOR_DETECTION_CALIBRATION_DATA),
+        epochs=args.epochs,
+        imgsz=target["img_size"],
+        single_cls=True,
+        project=str(dataset / "runs"),
+        verbose=False
+    )
+    shutil.copy(Path(results.save_dir) / "weights" / "best.pt", target["path"])
+    logger.info("Fine-tuned model saved to %s", target["path"])
+elif not target["path"].exists():
+    raise SystemExit(f"No model file {target['path']}, fine-tune it with --epochs.")
+
+# Exported backends of an earlier model file are stale
+for stale in list(target["path"].parent.glob(target["path"].stem + "*")):
+    if stale != target["path"]:
+        shutil.rmtree(stale) if stale.is_dir() else stale.unlink()
+
+# Loading benchmarks every backend, which exports and caches each one the machine supports
+configuration.color_detection.COLOR_DETECTION_BACKEND_BENCHMARK = True
+detector = ColorDetection(args.color, ColorDetection.select_model(args.model))
+logger.info("Model %s exported, fastest backend here: %s", args.model, detector.get_backend())
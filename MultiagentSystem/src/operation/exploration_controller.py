@@ -1,27 +1,35 @@
 import threading
-from typing import Dict, List, Callable, Tuple
+from typing import List, Callable, Optional, Union
 from queue import Queue
 import logging
-from time import time
-import winsound
 
 from configuration import operation as config
 from operation.operation_status import OperationStatus
 from operation.operation_events import OperationEvents
+from operation.operation_notifier import OperationNotifier, PointEvent, PointEventType
+from operation.point_registry import PointRegistry
 from interfaces.interfaces import ARobot
 from structures.structures import Point2D
+from utils import sim_clock
+from utils.coverage_grid import CoverageGrid
+from utils.spatial_grid import SpatialGrid
 
 class ExplorationController(threading.Thread):
     """
     Controller for managing the exploration phases of missions in a the multi-agent operation.
 
     This class runs as a separate thread and orchestrates the execution of exploration
-    phases performed by a explorer agent. It handles starting and stopping the
-    exploration routine, recording detected points, and synchronizing with the operation-level
+    phases performed by one or several explorer agents. It handles starting and stopping the
+    exploration routines, recording detected points, and synchronizing with the operation-level
     events to ensure safe and ordered execution.
+
+    All the explorers fly the area of the current mission from its base station, each reporting
+    its points relative to it. The ground they have seen during a mission is tracked on one coverage
+    grid of the mission area, and the exploration stops by itself once EXPLORATION_TARGET_COVERAGE
+    of it is covered, so more explorers finish a mission sooner.
     """
 
-    def __init__(self, robot: ARobot, base_positions: List[Point2D], points_queue: Queue[Point2D], all_points: Dict[Point2D, Tuple[int, bool, float, float]], events: OperationEvents) -> None:
+    def __init__(self, robots: Union[ARobot, List[ARobot]], base_positions: List[Point2D], points_queue: Queue[Point2D], all_points: PointRegistry, events: OperationEvents, notifier: OperationNotifier) -> None:
         """
         Creates an ExplorationController instance.
 
@@ -29,34 +37,40 @@ class ExplorationController(threading.Thread):
         and sets up the necessary callbacks.
 
         Args:
-            robot (ARobot): Robot instance that performs the exploration.
+            robots (Union[ARobot, List[ARobot]]): Robot, or robots sharing the missions, that perform the exploration.
             base_positions (List[Point2D]): List of positions corresponding to the base stations from which exploration phases start.
             points_queue (Queue[Point2D]): Queue for sending detected points during exploration to the inspection controller.
-            all_points (Dict[Point2D, Tuple[int, bool, float, float]]): Dictionary storing all detected points across missions, including:
-                           (mission_id, processed_flag, detection_time, inspection_time)
+            all_points (PointRegistry): Registry of all detected points across missions.
             events (OperationEvents): Shared operation events for synchronizing exploration and inspection phases.
+            notifier (OperationNotifier): Notification bus for the detected points.
         """
         super().__init__(daemon=True)
-        self._robot: ARobot = robot
+        self._robots: List[ARobot] = list(robots) if isinstance(robots, (list, tuple)) else [robots]
         self._base_positions: List[Point2D] = base_positions
         self._n_missions: int = len(base_positions)
         self._points_queue: Queue[Point2D] = points_queue
-        self._all_points: Dict[Point2D, Tuple[int, bool, float, float]] = all_points
+        self._all_points: PointRegistry = all_points
         self._events: OperationEvents = events
+        self._notifier: OperationNotifier = notifier
 
         self.current_mission_id: int = 0
         self.status: OperationStatus = OperationStatus.NOT_STARTED
         self.start_finish_times: List[(float, float)] = []
 
         self._points_current_mission: List[Point2D] = []
+        self._points_index: SpatialGrid = SpatialGrid(config.DRONE_VISIBILITY, all_points.points())
+        self._coverage: Optional[CoverageGrid] = None
 
         self._callback_onFinishAll: Callable[[], None] = None
+        self._callback_onMissionFinished: Callable[[int, float, float], None] = None
 
         self._lock: threading.RLock = threading.RLock()
 
         self._logger: logging.Logger = logging.getLogger("ExplorationController")
 
-        self._robot.set_callback_onPoint(self._on_point)
+        for robot in self._robots:
+            robot.set_callback_onPoint(self._on_point)
+            robot.set_callback_onCoverage(self._on_coverage)
 
     # -----------------------------------------------------------------
     # Public methods
@@ -69,8 +83,9 @@ class ExplorationController(threading.Thread):
         For each phase, it:
             1. Sets the status to RUNNING.
             2. Records the start time.
-            3. Starts the robot's exploration routine.
-            4. Waits for the `stop_exploration` event to stop the routine.
+            3. Starts the exploration routine of every robot.
+            4. Waits for the `stop_exploration` event to stop the routines, triggered by the operator
+               or once the coverage target is reached.
             5. Records the finish time.
             6. Sets status to FINISHED.
             7. Pushes the detected points (in absolute coordinates) to the shared queue.
@@ -84,21 +99,36 @@ class ExplorationController(threading.Thread):
             self._logger.info("Starting mission %d", self.current_mission_id)
             with self._lock:
                 self.status = OperationStatus.RUNNING
-            start_time = time() 
-            self._robot.start_routine()
+                if config.EXPLORATION_TARGET_COVERAGE > 0:
+                    self._coverage = CoverageGrid(config.EXPLORATION_AREA_RADIUS, config.EXPLORATION_COVERAGE_CELL_SIZE)
+            start_time = sim_clock.now() 
+            for robot in self._robots:
+                robot.start_routine()
             self._events.wait_for_stop_exploration()
+            with self._lock:
+                # No coverage stop after this one, which would stop the next mission
+                coverage = self._coverage.fraction() if self._coverage else None
+                self._coverage = None
             self._events.clear_stop_exploration()
-            self._robot.stop_routine()
-            finish_time = time()
+            if coverage is not None:
+                self._logger.info("Mission %d stopped with %.0f%% of its area covered", self.current_mission_id, coverage * 100)
+            for robot in self._robots:
+                robot.stop_routine()
+            finish_time = sim_clock.now()
             with self._lock:
                 self.status = OperationStatus.FINISHED
                 self.start_finish_times.append((start_time, finish_time))
                 self._points_queue.put(list(self._points_current_mission))
                 self._logger.info("Finished mission %d with %d points", self.current_mission_id, len(self._points_current_mission))
                 self._points_current_mission.clear()
+                mission_id = self.current_mission_id
+            if self._callback_onMissionFinished:
+                self._callback_onMissionFinished(mission_id, start_time, finish_time)
 
         with self._lock:
             self.status = OperationStatus.FINISHED
+        for robot in self._robots:
+            robot.shutdown()
         self._logger.info("All missions finished.")
         
         if self._callback_onFinishAll:
@@ -116,21 +146,37 @@ class ExplorationController(threading.Thread):
                 self._logger.warning("Cannot start next exploration while current mission is still running.")
                 return
             self.current_mission_id += 1
+            # Running from now on, so a second request before the mission starts is rejected
+            self.status = OperationStatus.RUNNING
         self._events.trigger_start_next_exploration()
 
 
+    def stop_exploration(self, mission_id: Optional[int] = None) -> None:
+        """
+        Signals the controller to stop the exploration of the current mission, only if it is running.
+
+        Args:
+            mission_id (Optional[int]): Mission to stop, None for the current one.
+        """
+        with self._lock:
+            if self.status != OperationStatus.RUNNING or (mission_id is not None and mission_id != self.current_mission_id):
+                self._logger.warning("No exploration of mission %s running to stop.", "current" if mission_id is None else mission_id)
+                return
+            self._events.trigger_stop_exploration()
+
     # ----------------------------------------------------
     # Private methods
     # ----------------------------------------------------
     def _on_point(self, point: Point2D) -> None:
         """
-        Internal callback triggered when the robot detects a point.
+        Internal callback triggered when a robot detects a point.
 
         Converts the detected point to absolute coordinates, checks for proximity to
-        existing points, and stores it in both the current mission list and the global dictionary.
+        the points of all missions, and stores it in both the current mission list and the point registry.
+        New points are published on the notifier.
 
         Args:
-            point (Point2D): Relative point detected by the robot.
+            point (Point2D): Point detected by the robot, relative to the base station of the current mission.
         """
         x_abs = self._base_positions[self.current_mission_id].x + point.x
         y_abs = self._base_positions[self.current_mission_id].y + point.y
@@ -138,17 +184,43 @@ class ExplorationController(threading.Thread):
         with self._lock:
             if not self._is_too_close(x_abs, y_abs):
                 point = Point2D(x_abs, y_abs)
-                self._logger.info("Detected point at %s in mission %d. Beeping...", point, self.current_mission_id)
-                winsound.Beep(1000, 200)
+                self._logger.info("Detected point at %s in mission %d", point, self.current_mission_id)
+                detection_time = sim_clock.now()
                 self._points_current_mission.append(point)
-                self._all_points[point] = (self.current_mission_id, False, time(), 0.0)
+                self._points_index.add(point)
+                self._all_points.add(point, self.current_mission_id, detection_time)
+                self._notifier.publish(PointEvent(PointEventType.DETECTED, point, self.current_mission_id, detection_time))
             else:
                 self._logger.debug("Skipping point (too close) at %s in mission %d", point, self.current_mission_id)
 
 
+    def _on_coverage(self, centre: Point2D, radius: float) -> None:
+        """
+        Internal callback triggered when a robot sees a ground area.
+
+        Marks the area on the coverage grid of the current mission, and stops the exploration
+        once EXPLORATION_TARGET_COVERAGE of the mission area is covered.
+
+        Args:
+            centre (Point2D): Centre of the seen disk, relative to the base station.
+            radius (float): Radius (in meters) of the seen disk.
+        """
+        with self._lock:
+            if self._coverage is None:
+                return
+            self._coverage.add_disk(centre.x, centre.y, radius)
+            if self._coverage.fraction() < config.EXPLORATION_TARGET_COVERAGE:
+                return
+            self._logger.info("Mission %d area covered, stopping the exploration.", self.current_mission_id)
+            self._coverage = None
+            self._events.trigger_stop_exploration()
+
     def _is_too_close(self, x: float, y: float) -> bool:
         """
-        Determines if a point is too close to previously recorded points in the current mission.
+        Determines if a point is too close to previously recorded points of any mission.
+
+        A point seen again from a later mission is merged into the recorded one, which is
+        already queued for inspection. The caller must hold the lock.
 
         Args:
             x (float): X coordinate of the point to check.
@@ -157,9 +229,4 @@ class ExplorationController(threading.Thread):
         Returns:
             bool: True if the point is closer than DRONE_VISIBILITY to any existing point.
         """
-        with self._lock:
-            for pt in self._points_current_mission:
-                dist = ((pt.x - x) ** 2 + (pt.y - y) ** 2) ** 0.5
-                if dist < config.DRONE_VISIBILITY:
-                    return True
-        return False
\ No newline at end of file
+        return self._points_index.nearest_within(x, y, config.DRONE_VISIBILITY) is not None
\ No newline at end of file
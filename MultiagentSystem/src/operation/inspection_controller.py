@@ -1,24 +1,34 @@
 import threading
 import logging
-from typing import Dict, Callable, List, Tuple
-from queue import Queue
-import winsound
-from time import time
+from typing import Dict, Callable, List
+from queue import Queue, Empty
 
 from operation.operation_status import OperationStatus
 from operation.operation_events import OperationEvents
+from configuration import operation as config
+from operation.operation_notifier import OperationNotifier, PointEvent, PointEventType
+from operation.point_registry import PointRegistry
 from structures.structures import Point2D
+from utils import sim_clock
 from interfaces.interfaces import IPathPlanner, ARobot
+from planners.insertion_planner import InsertionPlanner
+from planners.partition_planner import PartitionPlanner
 
 class InspectionController(threading.Thread):
     """
     Controller for managing the inspection phases of missions in a multi-agent operation.
 
     This class runs as a separate thread and orchestrates the execution of inspection
-    phases performed by a inspector agent. It ensures that the execution of the inspection phases is sequential and it respects the order of the missions. 
+    phases performed by one or more inspector agents. It ensures that the execution of the inspection phases is sequential and it respects the order of the missions. 
+
+    The inspection of a mission starts with its first detected point, while its exploration is still running:
+    each detected point is inserted into the live route of the inspector whose route stays the shortest once the point
+    is inserted at its cheapest place (min-max), and each inspector walks its own route one point at a time in its own
+    thread, around the obstacles known to the planner's distance provider. Once the exploration of the mission finishes,
+    the remaining points are split again among the inspectors and their routes are replanned with the configured planner.
     """
 
-    def __init__(self, robot: ARobot, planner: IPathPlanner, n_missions: int, points_queue: Queue[Point2D], all_points: Dict[Point2D, Tuple[int, bool, float, float]], events: OperationEvents) -> None:
+    def __init__(self, robots: List[ARobot], planner: IPathPlanner, n_missions: int, points_queue: Queue[Point2D], all_points: PointRegistry, events: OperationEvents, notifier: OperationNotifier) -> None:
         """
         Creates an InspectionController instance.
 
@@ -26,22 +36,23 @@ class InspectionController(threading.Thread):
         and sets up the necessary callbacks.
 
         Args:
-            robot (ARobot): Robot instance that performs the inspection.
-            planner (IPathPlanner): Path planner used to generate inspection paths.
+            robots (List[ARobot]): Robot instances that perform the inspection.
+            planner (IPathPlanner): Path planner used to reorder the remaining routes once the exploration of a mission finishes.
             n_missions (int): Total number of missions to perform.
             points_queue (Queue[Point2D]): Queue of points to inspect, shared with the ExplorationController.
-            all_points (Dict[Point2D, Tuple[int, bool, float, float]]):Dictionary storing all detected points across missions, including:
-                           (mission_id, processed_flag, detection_time, inspection_time)
-            events (OperationEvents): Shared operation events for synchronizing exploration and inspection phases.
+            all_points (PointRegistry): Registry of all detected points across missions, marked as inspected here.
+            events (OperationEvents): Shared operation events for synchronizing exploration and inspection phases, with one
+                inspector done event per robot.
+            notifier (OperationNotifier): Notification bus for the detected and reached points.
         """
         super().__init__(daemon=True)
-        self._robot: ARobot = robot
-        self._planner: IPathPlanner = planner
+        self._robots: List[ARobot] = robots
+        self._planner: PartitionPlanner = planner if isinstance(planner, PartitionPlanner) else PartitionPlanner(planner)
         self._n_missions: int = n_missions
         self._points_queue: Queue[Dict[Point2D, bool]] = points_queue
-        self._all_points: Dict[Point2D, Tuple[int, bool, float, float]] = all_points
-        self.points_temperatures: Dict[Point2D, float] = {}
+        self._all_points: PointRegistry = all_points
         self._events: OperationEvents = events
+        self._notifier: OperationNotifier = notifier
 
         self.current_mission_id: int = 0
         self.status: OperationStatus = OperationStatus.NOT_STARTED
@@ -49,13 +60,22 @@ class InspectionController(threading.Thread):
         self.start_finish_times: List[(float, float)] = []
 
         self._callback_onFinishAll: Callable[[], None] = None
+        self._callback_onMissionFinished: Callable[[int, float, float], None] = None
+        self._callback_onPointInspected: Callable[[Point2D, int, float, float], None] = None
+
+        self._routes: List[InsertionPlanner] = [InsertionPlanner(planner.get_distance_provider()) for _ in robots]
+        self._detected: Dict[int, List[Point2D]] = {}
+        self._explored: bool = False
 
         self._lock: threading.Lock = threading.Lock()
+        self._cond: threading.Condition = threading.Condition()
 
         self._logger: logging.Logger = logging.getLogger("InspectionController")
 
-        self._robot.set_callback_onPoint(self._on_point)
-        self._robot.set_callback_onFinish(self._on_finish)
+        for index, robot in enumerate(self._robots):
+            robot.set_callback_onPoint(lambda point, index=index: self._on_point(index, point))
+            robot.set_callback_onFinish(lambda index=index: self._on_finish(index))
+        self._notifier.subscribe(self._on_event)
 
     # ------------------------------------------------
     # Public methods
@@ -65,29 +85,24 @@ class InspectionController(threading.Thread):
         Main thread execution loop.
 
         For each inspection:
-            1. Retrieves points from the shared queue, if there are no points, it waits.
+            1. Waits for the first detected point of the mission, or for the end of its exploration.
             2. Sets the status to RUNNING.
             3. Records the start time.
-            4. Uses the path planner to compute an inspection path.
-            5. Starts the robot's inspection routine along the planned path.
-            6. Waits for the inspection routine to complete via the operation event `inspector_done`.
+            4. Inserts the detected points into the live routes as they arrive.
+            5. Each robot thread sends its robot to the next point of its route and waits for it via its operation event `inspector_done`.
+            6. Once the mission's points list arrives from the shared queue, splits the remaining points among the robots
+               and replans their routes with the path planner.
+            7. Finishes the mission when its exploration finished and all the routes are empty.
 
         Once all missions have been completed, the controller marks itself as FINISHED
         and triggers the optional completion callback.
         """
         while self.current_mission_id < self._n_missions - 1:
-            points = self._points_queue.get()
-            self._logger.info("Starting mission %d with %d points", self.current_mission_id, len(points))
             with self._lock:
                 if self.status != OperationStatus.NOT_STARTED:
                     self.current_mission_id += 1
-                self.status = OperationStatus.RUNNING
-                self._start_time_current_mission = time()
-            path = self._planner.plan_path(self._robot.get_current_position(), list(points))
-            self._robot.start_routine(path)
-            self._events.wait_for_inspector_done()
-            self._events.clear_inspector_done()
-            self._robot.stop_routine()
+                mission_id = self.current_mission_id
+            self._run_mission(mission_id)
 
         with self._lock:
             self.status = OperationStatus.FINISHED
@@ -99,37 +114,162 @@ class InspectionController(threading.Thread):
     # ------------------------------------------
     # Private methods
     # ------------------------------------------
-    def _on_point(self, point: Point2D) -> None:
+    def _run_mission(self, mission_id: int) -> None:
+        """
+        Inspects the points of a mission as they are detected, with one thread per robot.
+
+        Args:
+            mission_id (int): Mission to inspect.
+        """
+        with self._cond:
+            for route, robot in zip(self._routes, self._robots):
+                route.reset(robot.get_current_position())
+            self._explored = False
+        workers = [threading.Thread(target=self._inspect, args=(index,), daemon=True) for index in range(len(self._robots))]
+        for worker in workers:
+            worker.start()
+
+        inserted = set()
+        explored = False
+        started = False
+
+        while not explored:
+            with self._cond:
+                new_points = self._detected.pop(mission_id, [])
+            try:
+                new_points += self._points_queue.get_nowait()
+                explored = True
+            except Empty:
+                pass
+
+            with self._cond:
+                for point in new_points:
+                    if point not in inserted:
+                        inserted.add(point)
+                        self._assign(point)
+                if explored:
+                    self._replan()
+                    self._explored = True
+                self._cond.notify_all()
+
+            if not started and (inserted or explored):
+                started = True
+                self._logger.info("Starting mission %d", mission_id)
+                with self._lock:
+                    self.status = OperationStatus.RUNNING
+                    self._start_time_current_mission = sim_clock.now()
+
+            if not explored:
+                with self._cond:
+                    if mission_id not in self._detected:
+                        self._cond.wait(config.INSPECTION_POLL_TIME)
+
+        for worker in workers:
+            worker.join()
+
+        with self._lock:
+            finish_time = sim_clock.now()
+            self.status = OperationStatus.FINISHED
+            start_time = self._start_time_current_mission
+            self.start_finish_times.append((start_time, finish_time))
+            self._logger.info("Finished mission %d with %d points", mission_id, len(inserted))
+            self._start_time_current_mission = None
+            self._points_queue.task_done()
+        if self._callback_onMissionFinished:
+            self._callback_onMissionFinished(mission_id, start_time, finish_time)
+        with self._cond:
+            self._detected.pop(mission_id, None)
+
+    def _assign(self, point: Point2D) -> None:
+        """
+        Inserts a point into the route that is the shortest once the point is inserted. The caller must hold the condition.
+
+        Args:
+            point (Point2D): Detected point.
         """
-        Internal callback triggered when the robot reaches a point.
+        costs = [route.length() + route.insertion_cost(point)[1] for route in self._routes]
+        self._routes[min(range(len(costs)), key=costs.__getitem__)].insert_point(point)
 
-        Updates the status of the point to inspected and records the temperature if available.
+    def _replan(self) -> None:
+        """
+        Splits the remaining points among the robots and replans their routes. The caller must hold the condition.
+        """
+        points = [point for route in self._routes for point in route.current_path()]
+        if not points:
+            return
+        starts = [route.start_point() for route in self._routes]
+        for route, start, path in zip(self._routes, starts, self._planner.plan_routes(starts, points)):
+            route.reset(start, path)
+
+    def _inspect(self, index: int) -> None:
+        """
+        Robot thread: walks the route of a robot until the exploration of the mission finished and the route is empty.
+
+        Args:
+            index (int): Index of the robot.
+        """
+        robot = self._robots[index]
+        while True:
+            with self._cond:
+                target = self._routes[index].pop_next()
+                while target is None and not self._explored:
+                    self._cond.wait(config.INSPECTION_POLL_TIME)
+                    target = self._routes[index].pop_next()
+            if target is None:
+                return
+            robot.start_routine(self._planner.get_distance_provider().path(robot.get_current_position(), target))
+            self._events.wait_for_inspector_done(index)
+            self._events.clear_inspector_done(index)
+            robot.stop_routine()
+
+    def _on_event(self, event: PointEvent) -> None:
+        """
+        Notifier subscriber that collects the detected points for the inspection.
+
+        Args:
+            event (PointEvent): Published point event.
+        """
+        if event.type != PointEventType.DETECTED:
+            return
+        with self._cond:
+            self._detected.setdefault(event.mission_id, []).append(event.point)
+            self._cond.notify_all()
+
+    def _on_point(self, index: int, point: Point2D) -> None:
+        """
+        Internal callback triggered when a robot reaches a point.
+
+        Updates the status of the point to inspected, records the temperature if available
+        and publishes the point on the notifier. Waypoints around obstacles are ignored.
 
         Args:
+            index (int): Index of the robot.
             point (Point2D): The point reached by the robot during inspection.
         """
-        self._logger.info("Reached point %s in mission %d. Beeping...", point, self.current_mission_id)
-        winsound.Beep(1000, 200)
+        if point not in self._all_points:
+            return
+        self._logger.info("Reached point %s in mission %d", point, self.current_mission_id)
+        self._notifier.publish(PointEvent(PointEventType.REACHED, point, self.current_mission_id, sim_clock.now()))
 
+        inspected = None
         with self._lock:
-            if point in self._all_points:
-                mission_idx, _, _, _ = self._all_points[point]
-                if mission_idx == self.current_mission_id:
-                    self._all_points[point] = (mission_idx, True, self._all_points[point][2], time())
-                    self.points_temperatures[point] = self._robot.get_telemetry().get("temperature", None)
+            mission_idx = self._all_points.mission_of(point)
+            if mission_idx == self.current_mission_id:
+                inspection_time = sim_clock.now()
+                temperature = self._robots[index].get_telemetry().get("temperature", None)
+                self._all_points.mark_inspected(point, inspection_time, temperature)
+                inspected = (mission_idx, inspection_time, temperature)
+        if inspected and self._callback_onPointInspected:
+            self._callback_onPointInspected(point, *inspected)
 
-    def _on_finish(self) -> None:
+    def _on_finish(self, index: int) -> None:
         """
-        Internal callback triggered when the robot finishes the current inspection routine.
+        Internal callback triggered when a robot finishes the current inspection routine,
+        that is when it reaches the current point of its route.
 
-        Updates the mission status, records finish time, signals the event to release waiting threads,
-        and marks the points queue task as done.
+        Signals the event to release the waiting robot thread.
+
+        Args:
+            index (int): Index of the robot.
         """
-        with self._lock:
-            finish_time = time()
-            self.status = OperationStatus.FINISHED
-            self.start_finish_times.append((self._start_time_current_mission, finish_time))  
-            self._logger.info("Finished mission %d", self.current_mission_id)
-            self._start_time_current_mission = None
-            self._events.trigger_inspector_done()
-            self._points_queue.task_done()
\ No newline at end of file
+        self._events.trigger_inspector_done(index)
\ No newline at end of file
@@ -0,0 +1,189 @@
+import json
+import logging
+import os
+import time
+from datetime import datetime
+from typing import Callable, Dict, List, Optional
+
+from configuration import benchmark as config
+from configuration import operation as operation_config
+from drone.color_detection import ColorDetection
+from operation.operation_controller import OperationController
+from operation.operation_status import OperationStatus
+from utils import sim_clock
+
+class OperationBenchmark:
+    """
+    Headless runner of a whole operation, for benchmarking.
+
+    It plays the part of the operator of the OperationVisualizer buttons: it starts the operation,
+    stops the exploration of each mission after a fixed exploration time and, without automatic
+    advance, starts the next one. Once the operation finishes, it reports the operation metrics
+    (see OperationController.get_metrics) with the detection to inspection latency, the CPU usage
+    of the process and the frame rate of the color detection.
+
+    All durations are measured on the simulation clock, except the real duration and the CPU time.
+    """
+
+    def __init__(self, controller: OperationController, color_detection: Optional[ColorDetection] = None, label: str = "") -> None:
+        """
+        Creates an OperationBenchmark instance.
+
+        Args:
+            controller (OperationController): Controller of the operation to run, not started.
+            color_detection (Optional[ColorDetection]): Color detection of the explorer, for the frame statistics.
+            label (str): Name of the configuration under test, stored with the results.
+        """
+        self._controller: OperationController = controller
+        self._color_detection: Optional[ColorDetection] = color_detection
+        self._label: str = label
+
+        self._logger: logging.Logger = logging.getLogger("OperationBenchmark")
+
+    # -------------------------------------------
+    # Public methods
+    # -------------------------------------------
+    def run(self, exploration_time: float = config.BENCHMARK_EXPLORATION_TIME, timeout: float = config.BENCHMARK_TIMEOUT) -> Dict:
+        """
+        Runs the operation to its end and collects the results.
+
+        Args:
+            exploration_time (float): Longest exploration time (in simulated seconds) of each mission, which may
+            stop earlier once its area is covered (see EXPLORATION_TARGET_COVERAGE).
+            timeout (float): Longest duration (in simulated seconds) of the operation.
+
+        Returns:
+            Dict: Benchmark results, ready to be serialized to JSON.
+        """
+        controller = self._controller
+        exploration = controller.exploration_controller
+        n_missions = len(controller.base_positions)
+
+        real_start = time.perf_counter()
+        cpu_start = time.process_time()
+        sim_start = sim_clock.now()
+        deadline = sim_start + timeout
+        frames_start = self._color_detection.get_frame_stats() if self._color_detection else None
+
+        controller.start_operation()
+        finished = True
+        for mission_id in range(n_missions):
+            if not self._wait_until(lambda: exploration.current_mission_id > mission_id or (exploration.current_mission_id == mission_id and exploration.status == OperationStatus.RUNNING), deadline):
+                finished = False
+                break
+            self._logger.info("Exploring mission %d for up to %.1f s", mission_id, exploration_time)
+            if not self._wait_until(lambda: exploration.current_mission_id != mission_id or exploration.status != OperationStatus.RUNNING,
+                                    min(sim_clock.now() + exploration_time, deadline)):
+                controller.stop_inspection(mission_id)
+            if not operation_config.OPERATION_AUTO_ADVANCE and mission_id < n_missions - 1:
+                if not self._wait_until(lambda: exploration.status == OperationStatus.FINISHED, deadline):
+                    finished = False
+                    break
+                controller.next_mission()
+
+        finished = finished and self._wait_until(lambda: controller.status == OperationStatus.FINISHED, deadline)
+
+        real_duration = time.perf_counter() - real_start
+        cpu_time = time.process_time() - cpu_start
+        sim_duration = sim_clock.now() - sim_start
+
+        results = {
+            "label": self._label,
+            "finished": finished,
+            "clock": type(sim_clock.get_clock()).__name__,
+            "clock_speed": sim_clock.get_clock().get_speed(),
+            "real_duration": real_duration,
+            "simulated_duration": sim_duration,
+            "cpu_time": cpu_time,
+            "cpu_usage": cpu_time / real_duration if real_duration > 0 else None,
+            "frames": self._frame_results(frames_start, sim_duration),
+            "latency": self._latency_results(),
+            "operation": controller.get_metrics() if finished else None,
+        }
+        if not finished:
+            self._logger.warning("Operation did not finish within %.1f s.", timeout)
+        return results
+
+    def save(self, results: Dict, name: str) -> str:
+        """
+        Saves benchmark results to a timestamped JSON file.
+
+        Args:
+            results (Dict): Results returned by run.
+            name (str): Prefix of the file name, such as the scenario name.
+
+        Returns:
+            str: Path of the saved file.
+        """
+        timestamp = datetime.now().strftime("%Y_%m_%d_%H_%M_%S")
+        os.makedirs(config.BENCHMARK_OUTPUT_FOLDER, exist_ok=True)
+        path = f"{config.BENCHMARK_OUTPUT_FOLDER}/{name}_{timestamp}.json"
+
+        with open(path, "w") as f:
+            json.dump(results, f, indent=4)
+
+        self._logger.info(f"Benchmark results saved to {os.path.abspath(path)}")
+        return path
+
+    # ----------------------------------------
+    # Private methods
+    # ----------------------------------------
+    def _wait_until(self, condition: Callable[[], bool], deadline: float) -> bool:
+        """
+        Polls a condition on the simulation clock until it holds or the deadline passes.
+
+        Args:
+            condition (Callable[[], bool]): Condition to wait for.
+            deadline (float): Simulated time limit.
+
+        Returns:
+            bool: True if the condition holds, False on timeout.
+        """
+        while not condition():
+            if sim_clock.now() >= deadline:
+                return False
+            sim_clock.sleep(min(config.BENCHMARK_POLL_TIME, deadline - sim_clock.now()))
+        return True
+
+    def _frame_results(self, frames_start: Optional[Dict[str, int]], sim_duration: float) -> Optional[Dict[str, float]]:
+        """
+        Computes the color detection frame statistics of the run.
+
+        Args:
+            frames_start (Optional[Dict[str, int]]): Frame counts at the start of the run.
+            sim_duration (float): Simulated duration of the run (in seconds).
+
+        Returns:
+            Optional[Dict[str, float]]: Processed and skipped frames and processed frame rate
+            (in frames per simulated second), or None without color detection.
+        """
+        if self._color_detection is None:
+            return None
+        frames = self._color_detection.get_frame_stats()
+        processed = frames["processed"] - frames_start["processed"]
+        skipped = frames["skipped"] - frames_start["skipped"]
+        return {
+            "processed": processed,
+            "skipped": skipped,
+            "rate": processed / sim_duration if sim_duration > 0 else None,
+        }
+
+    def _latency_results(self) -> Dict[str, Optional[float]]:
+        """
+        Computes the detection to inspection latency statistics of the inspected points.
+
+        Returns:
+            Dict[str, Optional[float]]: Number of inspected points and mean, 95th percentile and
+            maximum latency (in simulated seconds, None without inspected points).
+        """
+        points = self._controller.all_points.snapshot()
+        latencies: List[float] = sorted(
+            (points.inspected_time[points.inspected] - points.detected_time[points.inspected]).tolist())
+        if not latencies:
+            return {"inspected_points": 0, "mean": None, "p95": None, "max": None}
+        return {
+            "inspected_points": len(latencies),
+            "mean": sum(latencies) / len(latencies),
+            "p95": latencies[min(int(0.95 * len(latencies)), len(latencies) - 1)],
+            "max": latencies[-1],
+        }
@@ -1,58 +1,68 @@
 import json
 import os
-from time import time
 from queue import Queue
 import logging
-from typing import List, Dict, Tuple
+from typing import List, Dict, Optional, Union
 import threading
-from datetime import datetime
+import winsound
 
 from operation.exploration_controller import ExplorationController
 from operation.inspection_controller import InspectionController
 from operation.operation_events import OperationEvents
+from operation.operation_log import OperationLog
+from operation.operation_notifier import OperationNotifier, PointEvent, PointEventType
 from operation.operation_status import OperationStatus
+from operation.point_registry import PointRegistry
 from interfaces.interfaces import IPathPlanner, ARobot
 from structures.structures import Point2D
+from utils import sim_clock
 from configuration import operation as config
 
 class OperationController:
     """
     High-level controller responsible for orchestrating the execution of an operation. 
     This includes coordinating the exploration and inspection phases, tracking operation
-    status, and saving performance metrics.
+    status, and logging performance metrics as the operation progresses (see OperationLog).
     """
 
-    def __init__(self, explorer_robot: ARobot, inspector_robot: ARobot, planner: IPathPlanner, base_positions_path: str) -> None:
+    def __init__(self, explorer_robot: Union[ARobot, List[ARobot]], inspector_robot: Union[ARobot, List[ARobot]], planner: IPathPlanner, base_positions_path: str) -> None:
         """
         Creates an OperationController instance.
 
         It loads the base positions from the specified JSON file, creates the ExplorationController and 
         InspectionController instances, creates the queue and events for communication between the two controllers,
-        and creates the global dictionary to store all detected points and its status.
-        It also initializes the operation status and timing variables and sets the callbacks for mission completion.
+        the notifier of the point events, and creates the registry of all detected points and their status.
+        It also initializes the operation status and timing variables, the event log, and sets the callbacks for
+        mission completion and for the events to log.
 
         Args:
-            explorer_robot (ARobot): Robot responsible for the exploration phase.
-            inspector_robot (ARobot): Robot responsible for the inspection phase.
-            planner (IPathPlanner): Path planner used by the inspector robot.
+            explorer_robot (Union[ARobot, List[ARobot]]): Robot, or robots sharing the missions, responsible for the exploration phase.
+            inspector_robot (Union[ARobot, List[ARobot]]): Robot, or robots sharing the points, responsible for the inspection phase.
+            planner (IPathPlanner): Path planner used by the inspector robots.
             base_positions_path (str): Path to a JSON file containing the coordinates of the base stations for each mission.
         """        
         self.base_positions: List[Point2D] = self._load_base_positions(base_positions_path)
         self._n_missions: int = len(self.base_positions)
     
         self._queue: Queue[Dict[Point2D, bool]] = Queue(maxsize=len(self.base_positions))
-        self.all_points: Dict[Point2D, Tuple[int, bool, float, float]] = {}
-        self._events: OperationEvents = OperationEvents()
+        self.all_points: PointRegistry = PointRegistry()
+        self.explorer_robots: List[ARobot] = list(explorer_robot) if isinstance(explorer_robot, (list, tuple)) else [explorer_robot]
+        self.inspector_robots: List[ARobot] = list(inspector_robot) if isinstance(inspector_robot, (list, tuple)) else [inspector_robot]
+        self._events: OperationEvents = OperationEvents(len(self.inspector_robots))
+        self.notifier: OperationNotifier = OperationNotifier()
+        self.notifier.subscribe(self._beep)
+        self.notifier.subscribe(self._log_detection)
+        self._log: OperationLog = OperationLog()
     
-        self.explorer_robot: ARobot = explorer_robot
-        self.inspector_robot: ARobot = inspector_robot
+        self.explorer_robot: ARobot = self.explorer_robots[0]
+        self.inspector_robot: ARobot = self.inspector_robots[0]
 
         self.status: OperationStatus = OperationStatus.NOT_STARTED
         self.start_time: float = None
         self.finished_time: float = None
 
-        self.exploration_controller: ExplorationController = ExplorationController(explorer_robot, self.base_positions, self._queue, self.all_points, self._events)
-        self.inspection_controller: InspectionController = InspectionController(inspector_robot, planner, len(self.base_positions), self._queue, self.all_points, self._events)
+        self.exploration_controller: ExplorationController = ExplorationController(self.explorer_robots, self.base_positions, self._queue, self.all_points, self._events, self.notifier)
+        self.inspection_controller: InspectionController = InspectionController(self.inspector_robots, planner, len(self.base_positions), self._queue, self.all_points, self._events, self.notifier)
 
         self._lock: threading.Lock = threading.Lock()
 
@@ -60,6 +70,13 @@ class OperationController:
 
         self.exploration_controller._callback_onFinishAll = self._on_all_missions_finished
         self.inspection_controller._callback_onFinishAll = self._on_all_missions_finished
+        self.exploration_controller._callback_onMissionFinished = \
+            lambda mission_id, start, finish: self._log.write("exploration_finished", mission_id=mission_id, start=start, finish=finish)
+        self.inspection_controller._callback_onMissionFinished = \
+            lambda mission_id, start, finish: self._log.write("inspection_finished", mission_id=mission_id, start=start, finish=finish)
+        self.inspection_controller._callback_onPointInspected = self._log_inspection
+
+        self._scheduler: threading.Thread = threading.Thread(target=self._schedule, daemon=True)
 
     # -------------------------------------------
     # Public methods
@@ -67,12 +84,19 @@ class OperationController:
     def start_operation(self) -> None:
         """
         Starts the operation by launching both exploration and inspection threads
-        and triggering the first exploration mission. It also records the start time and updates the operation status.
+        and triggering the first exploration mission. It also records the start time, updates the operation status
+        and opens the event log.
         """
-        self.start_time = time()
+        self.start_time = sim_clock.now()
         self.status = OperationStatus.RUNNING
+        self._log.open(self.start_time)
+        self._log.write("operation_started", time=self.start_time,
+                        base_positions=[OperationLog.point_fields(base) for base in self.base_positions])
+        self.notifier.start()
         self.exploration_controller.start()
         self.inspection_controller.start()
+        if config.OPERATION_AUTO_ADVANCE:
+            self._scheduler.start()
         self._logger.info("Operation started. Triggering first mission...")
         self._events.trigger_start_next_exploration()
 
@@ -83,12 +107,25 @@ class OperationController:
         self._logger.info("Triggering next exploration mission...")
         self.exploration_controller.start_next_exploration()
 
-    def stop_inspection(self) -> None:
+    def stop_inspection(self, mission_id: Optional[int] = None) -> None:
         """
         Signals the ExplorationController to stop the exploration phase of its current mission.
+
+        Args:
+            mission_id (Optional[int]): Mission to stop, None for whichever is running. Nothing is stopped
+            if that mission is not the one running, for instance because it stopped itself on coverage.
         """
         self._logger.info("Stopping current inspection...")
-        self._events.trigger_stop_exploration()
+        self.exploration_controller.stop_exploration(mission_id)
+
+    def get_metrics(self) -> Dict:
+        """
+        Collects the metrics of the operation from its event log, see OperationLog.summarize.
+
+        Returns:
+            Dict: Operation metrics, ready to be serialized to JSON, empty before the operation starts.
+        """
+        return OperationLog.summarize(self._log.path) if self._log.path else {}
 
     # ----------------------------------------
     # Private methods
@@ -107,6 +144,85 @@ class OperationController:
         base_positions = [Point2D(pos["x"], pos["y"]) for pos in data["base_positions"]]
         return base_positions
     
+    def _can_advance(self) -> bool:
+        """
+        Determines whether the next exploration mission may start automatically.
+
+        The current exploration must be finished with missions left, the exploration must not run more
+        than OPERATION_MAX_MISSIONS_AHEAD missions ahead of the finished inspections, and every explorer
+        must report its battery with enough charge and flight time left.
+
+        Returns:
+            bool: True if the next exploration mission may start.
+        """
+        exploration = self.exploration_controller
+        inspection = self.inspection_controller
+        with exploration._lock:
+            if exploration.status != OperationStatus.FINISHED or exploration.current_mission_id >= self._n_missions - 1:
+                return False
+            next_mission = exploration.current_mission_id + 1
+
+        with inspection._lock:
+            inspected = inspection.current_mission_id + 1 if inspection.status == OperationStatus.FINISHED else inspection.current_mission_id
+        if next_mission - inspected > config.OPERATION_MAX_MISSIONS_AHEAD:
+            return False
+
+        for robot in self.explorer_robots:
+            battery = robot.get_telemetry()
+            if battery is None:
+                self._logger.debug("Explorer battery unknown, waiting for next_mission.")
+                return False
+            if battery.get("charge", 0.0) < config.OPERATION_MIN_BATTERY_CHARGE:
+                return False
+            remaining_time = battery.get("remaining_time", -1.0)
+            if 0 <= remaining_time < config.OPERATION_MIN_FLIGHT_TIME:
+                return False
+        return True
+
+    def _schedule(self) -> None:
+        """
+        Scheduler thread that starts the next exploration mission as soon as it is allowed,
+        overlapping it with the inspection of the previous missions.
+        """
+        while self.status != OperationStatus.FINISHED:
+            if self._can_advance():
+                self._logger.info("Advancing to the next exploration mission automatically.")
+                self.exploration_controller.start_next_exploration()
+            sim_clock.sleep(config.OPERATION_SCHEDULER_PERIOD)
+
+    def _beep(self, event: PointEvent) -> None:
+        """
+        Notifier subscriber that beeps on every point detected or reached.
+
+        Args:
+            event (PointEvent): Published point event.
+        """
+        winsound.Beep(config.OPERATION_BEEP_FREQUENCY, config.OPERATION_BEEP_DURATION)
+
+    def _log_detection(self, event: PointEvent) -> None:
+        """
+        Notifier subscriber that logs the detected points.
+
+        Args:
+            event (PointEvent): Published point event.
+        """
+        if event.type == PointEventType.DETECTED:
+            self._log.write("point_detected", **OperationLog.point_fields(event.point), mission_id=event.mission_id,
+                            time=event.time)
+
+    def _log_inspection(self, point: Point2D, mission_id: int, time: float, temperature: float) -> None:
+        """
+        Callback of the InspectionController that logs the inspected points.
+
+        Args:
+            point (Point2D): Inspected point.
+            mission_id (int): Mission the point belongs to.
+            time (float): Time of the inspection (in seconds since the epoch).
+            temperature (float): Temperature measured at the point, None if unknown.
+        """
+        self._log.write("point_inspected", **OperationLog.point_fields(point), mission_id=mission_id,
+                        time=time, temperature=temperature)
+
     def _on_all_missions_finished(self) -> None:
         """
         Callback executed when both the exploration and inspection controllers
@@ -114,93 +230,21 @@ class OperationController:
         """
         with self._lock:
             if self.exploration_controller.current_mission_id == self._n_missions-1 and self.exploration_controller.status == OperationStatus.FINISHED and self.inspection_controller.current_mission_id == self._n_missions-1 and self.inspection_controller.status == OperationStatus.FINISHED:
-                self.finished_time = time()
+                self.finished_time = sim_clock.now()
                 self.status = OperationStatus.FINISHED
                 self._logger.info("Operation finished.")
                 self._save_metrics()
 
     def _save_metrics(self) -> None:
         """
-        Saves all collected metrics for the operation to a timestamped JSON file.
-        Metrics include:
-            - Operation start and end timestamps
-            - Operation duration and status
-            - Number of missions and points
-            - For each mission:
-                - Mission ID
-                - Base station coordinates
-                - Exploration and inspection start and end timestamps
-                - Exploration and inspection durations
-                - Exploration and inspection relative start and end times with respect to operation start time
-            - For each detected point:
-                - Point coordinates
-                - Mission ID
-                - Detection and inspection timestamps
-                - Detection and inspection relative times with respect to operation start time  
-                - Telemetry data (e.g., temperature)
-        """
-        def ts_to_iso(ts: float) -> str:
-            return datetime.fromtimestamp(ts).isoformat() if ts else None
-
-        operation_data = {
-            "operation_start_timestamp": ts_to_iso(self.start_time),
-            "operation_finished_timestamp": ts_to_iso(self.finished_time),
-            "operation_duration": self.finished_time - self.start_time if self.finished_time else None,
-            "status": self.status.name,
-            "number_of_missions": len(self.base_positions),
-            "number_of_points": len(self.exploration_controller._all_points),
-            "missions": [],
-            "points": []
-        }
-
-        for mission_id, base_pos in enumerate(self.base_positions):
-            explorer_start, explorer_finish = self.exploration_controller.start_finish_times[mission_id]
-            inspector_start, inspector_finish = self.inspection_controller.start_finish_times[mission_id]
-
-            operation_data["missions"].append({
-                "mission_id": mission_id,
-                "mission_base_position": {
-                    "x": base_pos.x, 
-                    "y": base_pos.y
-                },
-                "explorer_info": {
-                    "start_timestamp": ts_to_iso(explorer_start),
-                    "finish_timestamp": ts_to_iso(explorer_finish),
-                    "duration": explorer_finish - explorer_start,
-                    "relative_start_time": explorer_start - self.start_time,
-                    "relative_finish_time": explorer_finish - self.start_time
-                },
-                "inspector_info": {
-                    "start_timestamp": ts_to_iso(inspector_start),
-                    "finish_timestamp": ts_to_iso(inspector_finish),
-                    "duration": inspector_finish - inspector_start,
-                    "relative_start_time": inspector_start - self.start_time,
-                    "relative_finish_time": inspector_finish - self.start_time
-                }
-            })
-
-
-        for point, (mission_id, _, detected_time, finished_time) in self.exploration_controller._all_points.items():
-            operation_data["points"].append({
-                "point": {
-                    "x": point.x,
-                    "y": point.y
-                },
-                "mission_id": mission_id,
-                "detected_timestamp": ts_to_iso(detected_time),
-                "detected_relative_time": detected_time - self.start_time,
-                "inspected_timestamp": ts_to_iso(finished_time),
-                "inspected_relative_time": finished_time - self.start_time,
-                "telemetry": {
-                    "temperature": self.inspection_controller.points_temperatures.get(point, None)
-                },
-            })
-
-        timestamp = datetime.fromtimestamp(self.start_time).strftime("%Y_%m_%d_%H_%M_%S")
-        os.makedirs(config.METRICS_OUTPUT_FOLDER, exist_ok=True)
-        path = f"{config.METRICS_OUTPUT_FOLDER}/{timestamp}.json"
+        Closes the event log and saves the metrics derived from it to a JSON file next to it, see get_metrics.
+        """
+        self._log.write("operation_finished", time=self.finished_time, status=self.status.name)
+        self._log.close()
+        operation_data = self.get_metrics()
+        path = os.path.splitext(self._log.path)[0] + ".json"
 
         with open(path, "w") as f:
             json.dump(operation_data, f, indent=4)
 
-        self._logger.info(f"Operation metrics saved to {os.path.abspath(path)}")
\ No newline at end of file
+        self._logger.info(f"Operation metrics saved to {os.path.abspath(path)}")
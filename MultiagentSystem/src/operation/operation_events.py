@@ -1,4 +1,5 @@
 import threading
+from typing import List
 
 class OperationEvents:
     """
@@ -12,9 +13,12 @@ class OperationEvents:
     between threads.
     """
 
-    def __init__(self) -> None:
+    def __init__(self, n_inspectors: int = 1) -> None:
         """
         Creates all operation-level synchronization events.
+
+        Args:
+            n_inspectors (int): Number of inspector agents, each one with its own inspector done event.
         """
         self._stop_exploration: threading.Event = threading.Event()
         """Event used to signal the explorer agent to stop the current exploration phase."""
@@ -22,8 +26,8 @@ class OperationEvents:
         self._start_next_exploration: threading.Event = threading.Event()
         """Event used to signal the explorer agent to start the next exploration phase."""
 
-        self._inspector_done: threading.Event = threading.Event()
-        """Event used to signal that the inspector agent has completed the current inspection phase."""
+        self._inspector_done: List[threading.Event] = [threading.Event() for _ in range(n_inspectors)]
+        """Events used to signal that each inspector agent has completed its current inspection phase."""
 
     def trigger_stop_exploration(self) -> None:
         """
@@ -37,11 +41,14 @@ class OperationEvents:
         """
         self._start_next_exploration.set()
 
-    def trigger_inspector_done(self) -> None:
+    def trigger_inspector_done(self, inspector: int = 0) -> None:
         """
-        Activates the inspector done event.
+        Activates the inspector done event of an inspector.
+
+        Args:
+            inspector (int): Index of the inspector agent.
         """
-        self._inspector_done.set()
+        self._inspector_done[inspector].set()
 
     def clear_stop_exploration(self) -> None:
         """
@@ -55,11 +62,14 @@ class OperationEvents:
         """
         self._start_next_exploration.clear()  
 
-    def clear_inspector_done(self) -> None:
+    def clear_inspector_done(self, inspector: int = 0) -> None:
         """
-        Clears the inspector done event.
+        Clears the inspector done event of an inspector.
+
+        Args:
+            inspector (int): Index of the inspector agent.
         """
-        self._inspector_done.clear() 
+        self._inspector_done[inspector].clear()
 
     def wait_for_stop_exploration(self) -> None:
         """
@@ -73,9 +83,12 @@ class OperationEvents:
         """
         self._start_next_exploration.wait()
 
-    def wait_for_inspector_done(self) -> None:
+    def wait_for_inspector_done(self, inspector: int = 0) -> None:
         """
-        Blocks the calling thread until the inspector done event is set.
+        Blocks the calling thread until the inspector done event of an inspector is set.
+
+        Args:
+            inspector (int): Index of the inspector agent.
         """
-        self._inspector_done.wait()
+        self._inspector_done[inspector].wait()
     
\ No newline at end of file
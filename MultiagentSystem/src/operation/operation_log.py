@@ -0,0 +1,210 @@
+import json
+import os
+import threading
+import logging
+from datetime import datetime
+from typing import Dict, Iterator, Optional, TextIO
+
+from configuration import operation as config
+from structures.structures import Point2D
+
+class OperationLog:
+    """
+    Append-only log of the events of an operation, written as they happen.
+
+    Each event is one JSON line (JSONL) with its "event" name and fields, flushed right away,
+    so writing costs the same for every event and a log cut short by a crash stays readable
+    up to its last complete line. The events are:
+        - "operation_started": start time and base station of each mission
+        - "point_detected": point, mission and detection time
+        - "exploration_finished" and "inspection_finished": mission with its start and finish times
+        - "point_inspected": point, mission, inspection time and temperature
+        - "operation_finished": finish time and status
+
+    Times are in seconds since the epoch. summarize rebuilds the operation metrics from a log.
+    """
+
+    def __init__(self) -> None:
+        """
+        Creates an OperationLog instance, without a log file until open.
+        """
+        self.path: Optional[str] = None
+        self._file: Optional[TextIO] = None
+        self._lock: threading.Lock = threading.Lock()
+
+        self._logger: logging.Logger = logging.getLogger("OperationLog")
+
+    # -----------------------------------------------------------------
+    # Public methods
+    # -----------------------------------------------------------------
+    def open(self, start_time: float) -> None:
+        """
+        Creates the log file of an operation, named after its start time in METRICS_OUTPUT_FOLDER.
+
+        Args:
+            start_time (float): Start time of the operation (in seconds since the epoch).
+        """
+        timestamp = datetime.fromtimestamp(start_time).strftime("%Y_%m_%d_%H_%M_%S")
+        os.makedirs(config.METRICS_OUTPUT_FOLDER, exist_ok=True)
+        with self._lock:
+            self.path = os.path.join(config.METRICS_OUTPUT_FOLDER, f"{timestamp}.jsonl")
+            self._file = open(self.path, "w")
+        self._logger.info(f"Logging operation events to {os.path.abspath(self.path)}")
+
+    def write(self, event: str, **fields) -> None:
+        """
+        Appends an event to the log file. Events written before open or after close are dropped.
+
+        Args:
+            event (str): Event name.
+            **fields: Fields of the event, serializable to JSON.
+        """
+        line = json.dumps({"event": event, **fields})
+        with self._lock:
+            if self._file is None:
+                return
+            self._file.write(line + "\n")
+            self._file.flush()
+
+    def close(self) -> None:
+        """
+        Closes the log file.
+        """
+        with self._lock:
+            if self._file is not None:
+                self._file.close()
+                self._file = None
+
+    @staticmethod
+    def read(path: str) -> Iterator[Dict]:
+        """
+        Reads the events of a log file, ignoring an incomplete last line.
+
+        Args:
+            path (str): Path to the log file.
+
+        Yields:
+            Dict: Event with its "event" name and fields.
+        """
+        with open(path, "r") as f:
+            for line in f:
+                try:
+                    yield json.loads(line)
+                except json.JSONDecodeError:
+                    return
+
+    @staticmethod
+    def summarize(path: str) -> Dict:
+        """
+        Rebuilds the metrics of an operation from its log file.
+        Metrics include:
+            - Operation start and end timestamps
+            - Operation duration and status
+            - Number of missions and points
+            - For each mission:
+                - Mission ID
+                - Base station coordinates
+                - Exploration and inspection start and end timestamps
+                - Exploration and inspection durations
+                - Exploration and inspection relative start and end times with respect to operation start time
+            - For each detected point:
+                - Point coordinates
+                - Mission ID
+                - Detection and inspection timestamps
+                - Detection and inspection relative times with respect to operation start time
+                - Telemetry data (e.g., temperature)
+
+        Phases and points the log does not cover, because the operation is still running or was cut short,
+        are left None.
+
+        Args:
+            path (str): Path to the log file.
+
+        Returns:
+            Dict: Operation metrics, ready to be serialized to JSON.
+        """
+        def ts_to_iso(ts: Optional[float]) -> Optional[str]:
+            return datetime.fromtimestamp(ts).isoformat() if ts else None
+
+        start_time: Optional[float] = None
+        finished_time: Optional[float] = None
+        status: Optional[str] = None
+        bases: list = []
+        phases: Dict[str, Dict[int, tuple]] = {"exploration": {}, "inspection": {}}
+        points: Dict[tuple, Dict] = {}
+
+        for event in OperationLog.read(path):
+            kind = event["event"]
+            if kind == "operation_started":
+                start_time = event["time"]
+                bases = event["base_positions"]
+                status = "RUNNING"
+            elif kind == "point_detected":
+                points.setdefault((event["x"], event["y"]), {"mission_id": event["mission_id"],
+                                                             "detected": event["time"]})
+            elif kind in ("exploration_finished", "inspection_finished"):
+                phases[kind.split("_")[0]][event["mission_id"]] = (event["start"], event["finish"])
+            elif kind == "point_inspected":
+                point = points.setdefault((event["x"], event["y"]), {"mission_id": event["mission_id"]})
+                point["inspected"] = event["time"]
+                point["temperature"] = event["temperature"]
+            elif kind == "operation_finished":
+                finished_time = event["time"]
+                status = event["status"]
+
+        def relative(ts: Optional[float]) -> Optional[float]:
+            return ts - start_time if ts is not None and start_time is not None else None
+
+        def phase_info(times: Optional[tuple]) -> Optional[Dict]:
+            if times is None:
+                return None
+            start, finish = times
+            return {
+                "start_timestamp": ts_to_iso(start),
+                "finish_timestamp": ts_to_iso(finish),
+                "duration": finish - start,
+                "relative_start_time": relative(start),
+                "relative_finish_time": relative(finish)
+            }
+
+        return {
+            "operation_start_timestamp": ts_to_iso(start_time),
+            "operation_finished_timestamp": ts_to_iso(finished_time),
+            "operation_duration": relative(finished_time),
+            "status": status,
+            "number_of_missions": len(bases),
+            "number_of_points": len(points),
+            "missions": [{
+                "mission_id": mission_id,
+                "mission_base_position": base,
+                "explorer_info": phase_info(phases["exploration"].get(mission_id)),
+                "inspector_info": phase_info(phases["inspection"].get(mission_id))
+            } for mission_id, base in enumerate(bases)],
+            "points": [{
+                "point": {
+                    "x": x,
+                    "y": y
+                },
+                "mission_id": point["mission_id"],
+                "detected_timestamp": ts_to_iso(point.get("detected")),
+                "detected_relative_time": relative(point.get("detected")),
+                "inspected_timestamp": ts_to_iso(point.get("inspected")),
+                "inspected_relative_time": relative(point.get("inspected")),
+                "telemetry": {
+                    "temperature": point.get("temperature")
+                },
+            } for (x, y), point in points.items()]
+        }
+
+    @staticmethod
+    def point_fields(point: Point2D) -> Dict[str, float]:
+        """
+        Returns the fields of a point in the events.
+
+        Args:
+            point (Point2D): Point in absolute coordinates.
+
+        Returns:
+            Dict[str, float]: "x" and "y" coordinates.
+        """
+        return {"x": float(point.x), "y": float(point.y)}
@@ -0,0 +1,95 @@
+import threading
+import logging
+from dataclasses import dataclass
+from enum import Enum, auto
+from queue import Queue, Full
+from typing import Callable, List
+
+from configuration import operation as config
+from structures.structures import Point2D
+
+class PointEventType(Enum):
+    """
+    Enumeration of the point events published during the operation.
+    """
+
+    DETECTED = auto()
+    """The explorer agent detected a new point."""
+
+    REACHED = auto()
+    """The inspector agent reached a point."""
+
+@dataclass(frozen=True)
+class PointEvent:
+    """Point event published during the operation.
+
+    Attributes:
+        type (PointEventType): Kind of event.
+        point (Point2D): Point in absolute coordinates.
+        mission_id (int): Mission the point belongs to.
+        time (float): Time of the event (in seconds since the epoch).
+    """
+    type: PointEventType
+    point: Point2D
+    mission_id: int
+    time: float
+
+class OperationNotifier(threading.Thread):
+    """
+    Asynchronous notification bus for the point events of the operation.
+
+    The controllers publish events from their callbacks without blocking, and this thread
+    delivers them to the subscribers (audio signals, user interface, metrics) in publication
+    order. Subscribers run off the detection and inspection threads and without any
+    controller lock held, so they may take time or call back into the controllers.
+    """
+
+    def __init__(self) -> None:
+        """
+        Creates an OperationNotifier instance without subscribers.
+        """
+        super().__init__(daemon=True)
+        self._queue: Queue[PointEvent] = Queue(maxsize=config.OPERATION_NOTIFIER_MAX_QUEUE_SIZE)
+        self._subscribers: List[Callable[[PointEvent], None]] = []
+        self._lock: threading.Lock = threading.Lock()
+
+        self._logger: logging.Logger = logging.getLogger("OperationNotifier")
+
+    # -----------------------------------------------------------------
+    # Public methods
+    # -----------------------------------------------------------------
+    def subscribe(self, callback: Callable[[PointEvent], None]) -> None:
+        """
+        Registers a callback to be called with every published event.
+
+        Args:
+            callback (Callable[[PointEvent], None]): Function to call on the notifier thread.
+        """
+        with self._lock:
+            self._subscribers.append(callback)
+
+    def publish(self, event: PointEvent) -> None:
+        """
+        Queues an event for delivery, without blocking.
+
+        Args:
+            event (PointEvent): Event to deliver. It is dropped if the queue is full.
+        """
+        try:
+            self._queue.put_nowait(event)
+        except Full:
+            self._logger.warning("Queue full, dropped %s event of point %s.", event.type.name, event.point)
+
+    def run(self) -> None:
+        """
+        Main thread execution loop, delivering the queued events to the subscribers.
+        """
+        while True:
+            event = self._queue.get()
+            with self._lock:
+                subscribers = list(self._subscribers)
+            for callback in subscribers:
+                try:
+                    callback(event)
+                except Exception as e:
+                    self._logger.error("Subscriber failed on %s event: %s", event.type.name, e)
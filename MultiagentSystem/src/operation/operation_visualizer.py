@@ -2,14 +2,54 @@ import matplotlib.pyplot as plt
 from matplotlib import patches
 import matplotlib.animation as animation
 from matplotlib.widgets import Button
-from numpy import array
-from time import time
-from typing import List, Dict
+import numpy as np
+from typing import List, Optional, Tuple
 
 from configuration import operation as config
 from operation.operation_status import OperationStatus
 from operation.operation_controller import OperationController
+from operation.point_registry import PointSnapshot
 from structures.structures import Point2D
+from utils import sim_clock
+
+class _PathTrace:
+    """
+    Growing path of an agent, stored in arrays that double in size when full, so each
+    update only appends the new position and the plotted data is a view of the arrays.
+    """
+
+    def __init__(self) -> None:
+        """
+        Creates an empty _PathTrace instance.
+        """
+        self._xy: np.ndarray = np.empty((256, 2))
+        self._length: int = 0
+        self.distance: float = 0.0
+
+    def append(self, point: Point2D) -> None:
+        """
+        Adds a position to the path, unless the agent has not moved, and accumulates the traveled distance.
+
+        Args:
+            point (Point2D): New position.
+        """
+        if self._length:
+            last_x, last_y = self._xy[self._length - 1]
+            if last_x == point.x and last_y == point.y:
+                return
+            self.distance += ((point.x - last_x) ** 2 + (point.y - last_y) ** 2) ** 0.5
+        if self._length == len(self._xy):
+            self._xy = np.concatenate((self._xy, np.empty_like(self._xy)))
+        self._xy[self._length] = (point.x, point.y)
+        self._length += 1
+
+    def xs(self) -> np.ndarray:
+        """Returns the X coordinates of the path (a view, valid until the next append)."""
+        return self._xy[:self._length, 0]
+
+    def ys(self) -> np.ndarray:
+        """Returns the Y coordinates of the path (a view, valid until the next append)."""
+        return self._xy[:self._length, 1]
 
 class OperationVisualizer:
     """
@@ -19,6 +59,11 @@ class OperationVisualizer:
 
     It provides an interactive interface with buttons to start the operation,
     trigger the next mission, and stop the inspector.
+
+    The animation is blitted and updated incrementally: the paths only grow by the new
+    positions, the detected points only change when points are added or inspected, and
+    the points list only shows the latest OPERATION_VISUALIZER_MAX_LISTED_POINTS of each
+    mission, so the cost of an update does not grow with the length of the operation.
     """
     def __init__(self, controller: OperationController) -> None:
         """
@@ -28,25 +73,76 @@ class OperationVisualizer:
             controller (OperationController): Reference to the operation controller to visualize.
         """
         self.controller: OperationController = controller
-        self._explorer_positions: List[Point2D] = []
-        self._inspector_positions: List[Point2D] = []
-        self._points_by_mission: Dict[int, List[Point2D]] = {}
+        self._explorer_path: _PathTrace = _PathTrace()
+        self._inspector_path: _PathTrace = _PathTrace()
 
-    def _distance_traveled(self, path: List[Point2D]) -> float:
+        self._offsets: np.ndarray = np.empty((0, 2))
+        self._colors: List[str] = []
+        self._points_version: Optional[int] = None
+        self._points_text: str = ""
+        self._buttons_visible: Optional[Tuple[bool, bool, bool]] = None
+
+    def _update_points(self) -> bool:
+        """
+        Brings the detected points, their colors and the points list up to date, if they changed.
+
+        The points are only reread when the registry version changes, as a columnar snapshot.
+
+        Returns:
+            bool: True if the points changed.
+        """
+        registry = self.controller.all_points
+        if registry.version == self._points_version:
+            return False
+        points = registry.snapshot()
+        self._points_version = points.version
+
+        self._offsets = np.column_stack((points.x, points.y))
+        self._colors = np.where(points.inspected, "green", "red").tolist()
+        self._points_text = self._format_points(points)
+        return True
+
+    def _format_points(self, points: PointSnapshot) -> str:
         """
-        Computes the total Euclidean distance traveled along a given path.
+        Formats the points list of the information panel, missions in two columns.
 
         Args:
-            path (List[Point2D]): List of points representing the path.
+            points (PointSnapshot): Snapshot of the detected points.
+
         Returns:
-            float: Total distance traveled along the path.
+            str: Points list, with the latest OPERATION_VISUALIZER_MAX_LISTED_POINTS points of each mission.
         """
-        if len(path) < 2:
-            return 0.0
-        d = 0.0
-        for i in range(1, len(path)):
-            d += ((path[i].x - path[i - 1].x)** 2 + (path[i].y - path[i - 1].y)** 2) ** 0.5
-        return d
+        left_blocks = []
+        right_blocks = []
+        for mid in range(len(self.controller.base_positions)):
+            ids = np.flatnonzero(points.mission == mid)
+            block = [f"Mission {mid}: {len(ids)} points"]
+            hidden = len(ids) - config.OPERATION_VISUALIZER_MAX_LISTED_POINTS
+            if hidden > 0:
+                block.append(f"• ... {hidden} earlier points")
+                ids = ids[hidden:]
+            for i in ids:
+                if not np.isnan(points.temperature[i]):
+                    block.append(f"• ({points.x[i]:.2f}, {points.y[i]:.2f}) -> {points.temperature[i]:.2f}°C")
+                else:
+                    block.append(f"• ({points.x[i]:.2f}, {points.y[i]:.2f})")
+            if mid % 2 == 0:
+                left_blocks.append(block)
+            else:
+                right_blocks.append(block)
+
+        missions_text = ""
+        max_blocks = max(len(left_blocks), len(right_blocks))
+        for i in range(max_blocks):
+            left_block = left_blocks[i] if i < len(left_blocks) else []
+            right_block = right_blocks[i] if i < len(right_blocks) else []
+            max_lines = max(len(left_block), len(right_block))
+            for j in range(max_lines):
+                left_line = left_block[j] if j < len(left_block) else ""
+                right_line = right_block[j] if j < len(right_block) else ""
+                missions_text += f"{left_line:<45} {right_line}\n"
+            missions_text += "\n"
+        return missions_text
 
     def start(self) -> None:
         """
@@ -98,7 +194,7 @@ class OperationVisualizer:
         # ----------------------------
         ax_info = fig.add_subplot(1, 2, 2)
         ax_info.axis("off")
-        text_info = ax_info.text(0.02, 0.98, "", va="top", fontsize=12)
+        text_info = ax_info.text(0.02, 0.98, "", va="top", fontsize=12, color='black')
 
         # ----------------------------
         # Buttons
@@ -121,6 +217,9 @@ class OperationVisualizer:
         # ----------------------------
         # Animation update
         # ----------------------------
+        artists = [*base_markers, explorer_visibility, explorer_path, inspector_path,
+                   detected_scatter, explorer_point, inspector_point, text_info]
+
         def update(frame):
             mission_id = self.controller.exploration_controller.current_mission_id
             base_position = base_positions[mission_id]
@@ -132,85 +231,45 @@ class OperationVisualizer:
             # Explorer position
             ins_rel = self.controller.explorer_robot.get_current_position()
             ins_abs = Point2D(base_position.x + ins_rel.x, base_position.y + ins_rel.y)
-            self._explorer_positions.append(ins_abs)
+            self._explorer_path.append(ins_abs)
             explorer_visibility.center = (ins_abs.x, ins_abs.y)
 
             # Inspector position
             exe_rel = self.controller.inspector_robot.get_current_position()
             exe_abs = Point2D(exe_rel.x, exe_rel.y)
-            self._inspector_positions.append(exe_abs)
+            self._inspector_path.append(exe_abs)
 
             # Update paths
-            if self._explorer_positions:
-                xs, ys = zip(*[(p.x, p.y) for p in self._explorer_positions])
-                explorer_point.set_data([xs[-1]], [ys[-1]])
-                explorer_path.set_data(xs, ys)
-
-            if self._inspector_positions:
-                ex, ey = zip(*[(p.x, p.y) for p in self._inspector_positions])
-                inspector_point.set_data([ex[-1]], [ey[-1]])
-                inspector_path.set_data(ex, ey)
+            explorer_point.set_data([ins_abs.x], [ins_abs.y])
+            explorer_path.set_data(self._explorer_path.xs(), self._explorer_path.ys())
+            inspector_point.set_data([exe_abs.x], [exe_abs.y])
+            inspector_path.set_data(self._inspector_path.xs(), self._inspector_path.ys())
 
             # Detected points
-            self._points_by_mission.clear()
-            all_points = []
-            colors = []
-
-            for point, (mid, reached, _, _) in self.controller.all_points.items():
-                self._points_by_mission.setdefault(mid, []).append(point)
-                all_points.append(point)
-                colors.append("green" if reached else "red")
-
-            if all_points:
-                coords = array([[p.x, p.y] for p in all_points])
-                detected_scatter.set_offsets(coords)
-                detected_scatter.set_color(colors)
-
-            # Buttons visibility
-            start_button.ax.set_visible(self.controller.status == OperationStatus.NOT_STARTED)
-            stop_button.ax.set_visible(self.controller.exploration_controller.status == OperationStatus.RUNNING)
-            next_button.ax.set_visible(self.controller.status == OperationStatus.RUNNING and 
-                                       self.controller.exploration_controller.status == OperationStatus.FINISHED and
-                                       mission_id + 1 < len(base_positions))
+            if self._update_points() and len(self._offsets):
+                detected_scatter.set_offsets(self._offsets)
+                detected_scatter.set_color(self._colors)
+
+            # Buttons visibility, redrawn with the whole figure as they are not blitted
+            visible = (self.controller.status == OperationStatus.NOT_STARTED,
+                       self.controller.exploration_controller.status == OperationStatus.RUNNING,
+                       self.controller.status == OperationStatus.RUNNING and
+                       self.controller.exploration_controller.status == OperationStatus.FINISHED and
+                       mission_id + 1 < len(base_positions))
+            if visible != self._buttons_visible:
+                self._buttons_visible = visible
+                for button, shown in zip((start_button, stop_button, next_button), visible):
+                    button.ax.set_visible(shown)
+                fig.canvas.draw_idle()
 
             # Info panel
             if self.controller.status == OperationStatus.NOT_STARTED:
                 elapsed = 0.0
             elif self.controller.status == OperationStatus.RUNNING:
-                elapsed = time() - self.controller.start_time
+                elapsed = sim_clock.now() - self.controller.start_time
             else: 
                 elapsed = self.controller.finished_time - self.controller.start_time 
 
-            ins_dist = self._distance_traveled(self._explorer_positions)
-            exe_dist = self._distance_traveled(self._inspector_positions)
-
-            left_blocks = []
-            right_blocks = []
-            for mid in range(len(base_positions)):
-                pts = self._points_by_mission.get(mid, [])
-                block = [f"Mission {mid}: {len(pts)} points"]
-                for p in pts:
-                    if p in self.controller.inspection_controller.points_temperatures:
-                        block.append(f"• ({p.x:.2f}, {p.y:.2f}) -> {self.controller.inspection_controller.points_temperatures[p]:.2f}°C")
-                    else:
-                        block.append(f"• ({p.x:.2f}, {p.y:.2f})")
-                if mid % 2 == 0:
-                    left_blocks.append(block)
-                else:
-                    right_blocks.append(block)
-
-            missions_text = ""
-            max_blocks = max(len(left_blocks), len(right_blocks))
-            for i in range(max_blocks):
-                left_block = left_blocks[i] if i < len(left_blocks) else []
-                right_block = right_blocks[i] if i < len(right_blocks) else []
-                max_lines = max(len(left_block), len(right_block))
-                for j in range(max_lines):
-                    left_line = left_block[j] if j < len(left_block) else ""
-                    right_line = right_block[j] if j < len(right_block) else ""
-                    missions_text += f"{left_line:<45} {right_line}\n"
-                missions_text += "\n"
-                
             info = f"""OPERATION:
 - Time: {elapsed:.1f}s
 - Operation Status: {self.controller.status.name}
@@ -219,21 +278,20 @@ DRONE:
 - Drone Mission: {mission_id}
 - Drone Mission Status: {self.controller.exploration_controller.status.name}
 - Drone Position: x={ins_abs.x:.2f}, y={ins_abs.y:.2f}
-- Drone Distance: {ins_dist:.2f}
+- Drone Distance: {self._explorer_path.distance:.2f}
 
 ROBOT DOG:
 - Robot Dog Mission: {self.controller.inspection_controller.current_mission_id}
 - Robot Dog Mission Status: {self.controller.inspection_controller.status.name}
 - Robot Dog Position: x={exe_abs.x:.2f}, y={exe_abs.y:.2f}
-- Robot Dog Distance: {exe_dist:.2f}
+- Robot Dog Distance: {self._inspector_path.distance:.2f}
 
 POINTS DETECTED:
-{missions_text}
+{self._points_text}
 """
             text_info.set_text(info)
-            text_info.set_color('black')
 
-            return explorer_point, inspector_point, detected_scatter
+            return artists
 
-        ani = animation.FuncAnimation(fig, update, interval=100, blit=False, cache_frame_data=False)
+        ani = animation.FuncAnimation(fig, update, interval=config.OPERATION_VISUALIZER_INTERVAL, blit=True, cache_frame_data=False)
         plt.show()
@@ -0,0 +1,200 @@
+import threading
+from dataclasses import dataclass
+from typing import Dict, List, Optional
+
+import numpy as np
+
+from structures.structures import Point2D
+
+@dataclass(frozen=True)
+class PointSnapshot:
+    """
+    Copy of the registry columns at a given version, indexed by point id.
+
+    Attributes:
+        version (int): Registry version the snapshot was taken at.
+        x (np.ndarray): X coordinates (in meters).
+        y (np.ndarray): Y coordinates (in meters).
+        mission (np.ndarray): Mission id of each point.
+        inspected (np.ndarray): True for the inspected points.
+        detected_time (np.ndarray): Detection times (in simulated seconds).
+        inspected_time (np.ndarray): Inspection times (in simulated seconds), NaN if not inspected.
+        temperature (np.ndarray): Measured temperatures (in degrees Celsius), NaN if not measured.
+    """
+    version: int
+    x: np.ndarray
+    y: np.ndarray
+    mission: np.ndarray
+    inspected: np.ndarray
+    detected_time: np.ndarray
+    inspected_time: np.ndarray
+    temperature: np.ndarray
+
+    def __len__(self) -> int:
+        return len(self.x)
+
+class PointRegistry:
+    """
+    Columnar store of the points detected during an operation, shared by the controllers,
+    the visualizer and the benchmarks.
+
+    Each point gets a stable integer id, its order of detection, and its fields are stored
+    in numpy columns that double in size when full. Every change bumps a version counter,
+    so readers can tell cheaply whether anything changed and take a vectorized snapshot
+    instead of walking per-point Python objects. Points are only ever added or marked
+    as inspected.
+
+    It is thread safe.
+    """
+
+    _INITIAL_CAPACITY: int = 64
+
+    def __init__(self) -> None:
+        """
+        Creates an empty PointRegistry instance.
+        """
+        self.version: int = 0
+        self._count: int = 0
+        self._points: List[Point2D] = []
+        self._ids: Dict[Point2D, int] = {}
+        self._x: np.ndarray = np.empty(self._INITIAL_CAPACITY)
+        self._y: np.ndarray = np.empty(self._INITIAL_CAPACITY)
+        self._mission: np.ndarray = np.empty(self._INITIAL_CAPACITY, dtype=np.int32)
+        self._inspected: np.ndarray = np.empty(self._INITIAL_CAPACITY, dtype=bool)
+        self._detected_time: np.ndarray = np.empty(self._INITIAL_CAPACITY)
+        self._inspected_time: np.ndarray = np.empty(self._INITIAL_CAPACITY)
+        self._temperature: np.ndarray = np.empty(self._INITIAL_CAPACITY)
+        self._lock: threading.Lock = threading.Lock()
+
+    def __len__(self) -> int:
+        return self._count
+
+    def __contains__(self, point: Point2D) -> bool:
+        return point in self._ids
+
+    # -----------------------------------------------------------------
+    # Public methods
+    # -----------------------------------------------------------------
+    def add(self, point: Point2D, mission_id: int, detection_time: float) -> int:
+        """
+        Adds a detected point, not inspected yet.
+
+        Args:
+            point (Point2D): Point in absolute coordinates.
+            mission_id (int): Mission the point was detected in.
+            detection_time (float): Detection time (in simulated seconds).
+
+        Returns:
+            int: Id of the point, its existing id if it was already added.
+        """
+        with self._lock:
+            if point in self._ids:
+                return self._ids[point]
+            if self._count == len(self._x):
+                self._grow()
+            i = self._count
+            self._x[i] = point.x
+            self._y[i] = point.y
+            self._mission[i] = mission_id
+            self._inspected[i] = False
+            self._detected_time[i] = detection_time
+            self._inspected_time[i] = np.nan
+            self._temperature[i] = np.nan
+            self._points.append(point)
+            self._ids[point] = i
+            self._count += 1
+            self.version += 1
+            return i
+
+    def mark_inspected(self, point: Point2D, inspection_time: float, temperature: Optional[float]) -> Optional[int]:
+        """
+        Marks a point as inspected, with its measured temperature.
+
+        Args:
+            point (Point2D): Point in absolute coordinates.
+            inspection_time (float): Inspection time (in simulated seconds).
+            temperature (Optional[float]): Measured temperature (in degrees Celsius), None if not measured.
+
+        Returns:
+            Optional[int]: Id of the point, None if the point is not in the registry.
+        """
+        with self._lock:
+            i = self._ids.get(point)
+            if i is None:
+                return None
+            self._inspected[i] = True
+            self._inspected_time[i] = inspection_time
+            self._temperature[i] = np.nan if temperature is None else temperature
+            self.version += 1
+            return i
+
+    def id_of(self, point: Point2D) -> Optional[int]:
+        """
+        Returns the id of a point.
+
+        Args:
+            point (Point2D): Point in absolute coordinates.
+
+        Returns:
+            Optional[int]: Id of the point, None if the point is not in the registry.
+        """
+        return self._ids.get(point)
+
+    def mission_of(self, point: Point2D) -> Optional[int]:
+        """
+        Returns the mission a point was detected in.
+
+        Args:
+            point (Point2D): Point in absolute coordinates.
+
+        Returns:
+            Optional[int]: Mission id, None if the point is not in the registry.
+        """
+        i = self._ids.get(point)
+        return int(self._mission[i]) if i is not None else None
+
+    def points(self, start: int = 0) -> List[Point2D]:
+        """
+        Returns the points from an id on, in id order.
+
+        Args:
+            start (int): First id.
+
+        Returns:
+            List[Point2D]: Points with an id of at least start.
+        """
+        with self._lock:
+            return self._points[start:self._count]
+
+    def snapshot(self) -> PointSnapshot:
+        """
+        Copies the columns of the points added so far, consistent with each other.
+
+        Returns:
+            PointSnapshot: Columns indexed by point id, with the current version.
+        """
+        with self._lock:
+            n = self._count
+            return PointSnapshot(
+                version=self.version,
+                x=self._x[:n].copy(),
+                y=self._y[:n].copy(),
+                mission=self._mission[:n].copy(),
+                inspected=self._inspected[:n].copy(),
+                detected_time=self._detected_time[:n].copy(),
+                inspected_time=self._inspected_time[:n].copy(),
+                temperature=self._temperature[:n].copy(),
+            )
+
+    # -----------------------------------------------------------------
+    # Private methods
+    # -----------------------------------------------------------------
+    def _grow(self) -> None:
+        """
+        Doubles the capacity of the columns, keeping their content.
+        """
+        for name in ("_x", "_y", "_mission", "_inspected", "_detected_time", "_inspected_time", "_temperature"):
+            column = getattr(self, name)
+            grown = np.empty(2 * len(column), dtype=column.dtype)
+            grown[:len(column)] = column
+            setattr(self, name, grown)
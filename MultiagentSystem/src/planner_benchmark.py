@@ -0,0 +1,215 @@
+from planners.nearest_neighbor_planner import NearestNeighborPlanner
+from planners.local_search_planner import LocalSearchPlanner
+from planners.insertion_planner import InsertionPlanner
+from interfaces.interfaces import IPathPlanner
+from structures.structures import Point2D
+from utils.logs import ColoredFormatter
+from datetime import datetime
+from time import perf_counter
+from typing import Callable, Dict, List, Optional
+import argparse
+import json
+import logging
+import math
+import os
+import random
+import tracemalloc
+
+from configuration import benchmark as config
+
+PLANNERS: Dict[str, Callable[[], IPathPlanner]] = {
+    "nearest_neighbor": NearestNeighborPlanner,
+    "insertion": InsertionPlanner,
+    "local_search": LocalSearchPlanner,
+}
+
+def uniform_points(rng: random.Random, n: int, side: float) -> List[Point2D]:
+    """
+    Draws points uniformly over a square centred on the origin.
+
+    Args:
+        rng (random.Random): Random generator.
+        n (int): Number of points.
+        side (float): Side of the square (in meters).
+
+    Returns:
+        List[Point2D]: Drawn points.
+    """
+    return [Point2D(rng.uniform(-side / 2, side / 2), rng.uniform(-side / 2, side / 2)) for _ in range(n)]
+
+def clustered_points(rng: random.Random, n: int, side: float) -> List[Point2D]:
+    """
+    Draws points around about sqrt(n) / 2 centres spread over a square centred on the origin,
+    with a normal spread of a twentieth of its side, clipped to the square.
+
+    Args:
+        rng (random.Random): Random generator.
+        n (int): Number of points.
+        side (float): Side of the square (in meters).
+
+    Returns:
+        List[Point2D]: Drawn points.
+    """
+    centres = uniform_points(rng, max(round(math.sqrt(n) / 2), 1), side)
+    clip = lambda value: min(max(value, -side / 2), side / 2)
+    points = []
+    for _ in range(n):
+        centre = rng.choice(centres)
+        points.append(Point2D(clip(rng.gauss(centre.x, side / 20)), clip(rng.gauss(centre.y, side / 20))))
+    return points
+
+def line_points(rng: random.Random, n: int, side: float) -> List[Point2D]:
+    """
+    Draws points along three segments joining random points of a square centred on the origin,
+    with 5 cm of normal noise, as objects lined up along paths or fences.
+
+    Args:
+        rng (random.Random): Random generator.
+        n (int): Number of points.
+        side (float): Side of the square (in meters).
+
+    Returns:
+        List[Point2D]: Drawn points.
+    """
+    segments = [tuple(uniform_points(rng, 2, side)) for _ in range(3)]
+    points = []
+    for _ in range(n):
+        a, b = rng.choice(segments)
+        t = rng.random()
+        points.append(Point2D(a.x + t * (b.x - a.x) + rng.gauss(0, 0.05), a.y + t * (b.y - a.y) + rng.gauss(0, 0.05)))
+    return points
+
+DISTRIBUTIONS: Dict[str, Callable[[random.Random, int, float], List[Point2D]]] = {
+    "uniform": uniform_points,
+    "clustered": clustered_points,
+    "lines": line_points,
+}
+
+def path_length(start: Point2D, path: List[Point2D]) -> float:
+    """
+    Computes the Euclidean length of a path from its start point.
+
+    Args:
+        start (Point2D): Start point.
+        path (List[Point2D]): Ordered points, without the start point.
+
+    Returns:
+        float: Path length (in meters).
+    """
+    return sum(math.hypot(b.x - a.x, b.y - a.y) for a, b in zip([start] + path, path))
+
+def run_planner(name: str, start: Point2D, points: List[Point2D], memory: bool) -> Dict:
+    """
+    Plans a path with a new planner instance, timed, then again under tracemalloc for its peak memory.
+
+    Args:
+        name (str): Planner name in PLANNERS.
+        start (Point2D): Start point.
+        points (List[Point2D]): Points to visit.
+        memory (bool): True to measure the peak memory.
+
+    Returns:
+        Dict: Wall time (in seconds), path length (in meters), whether the path visits every point
+        once, and peak memory (in bytes, None if not measured).
+    """
+    planner = PLANNERS[name]()
+    begin = perf_counter()
+    path = planner.plan_path(start, list(points))
+    elapsed = perf_counter() - begin
+
+    peak = None
+    if memory:
+        planner = PLANNERS[name]()
+        tracemalloc.start()
+        planner.plan_path(start, list(points))
+        _, peak = tracemalloc.get_traced_memory()
+        tracemalloc.stop()
+
+    return {
+        "time": elapsed,
+        "length": path_length(start, path),
+        "valid": sorted((p.x, p.y) for p in path) == sorted((p.x, p.y) for p in points),
+        "peak_memory": peak,
+    }
+
+def mean(values: List[Optional[float]]) -> Optional[float]:
+    """
+    Averages values, ignoring the missing ones.
+
+    Args:
+        values (List[Optional[float]]): Values, None if missing.
+
+    Returns:
+        Optional[float]: Mean, None if all values are missing.
+    """
+    present = [v for v in values if v is not None]
+    return sum(present) / len(present) if present else None
+
+parser = argparse.ArgumentParser(description="Compares the inspection path planners on generated point sets.")
+parser.add_argument("--planners", nargs="+", choices=sorted(PLANNERS) + ["ilp"], default=sorted(PLANNERS),
+                    help="Planners to compare.")
+parser.add_argument("--sizes", nargs="+", type=int, default=config.PLANNER_BENCHMARK_SIZES,
+                    help="Numbers of points of the instances.")
+parser.add_argument("--distributions", nargs="+", choices=sorted(DISTRIBUTIONS),
+                    default=config.PLANNER_BENCHMARK_DISTRIBUTIONS, help="Point distributions.")
+parser.add_argument("--instances", type=int, default=config.PLANNER_BENCHMARK_INSTANCES,
+                    help="Instances per distribution and number of points.")
+parser.add_argument("--seed", type=int, default=1, help="Seed of the point generation.")
+parser.add_argument("--no-memory", action="store_true", help="Skip the peak memory measurement, which plans every path twice.")
+args = parser.parse_args()
+
+if "ilp" in args.planners:
+    from planners.ilp_planner import ILPPlanner
+    PLANNERS["ilp"] = ILPPlanner
+
+handler = logging.StreamHandler()
+handler.setFormatter(ColoredFormatter("[%(levelname)s] %(name)s: %(message)s"))
+logging.basicConfig(level=logging.WARNING, handlers=[handler])
+logger = logging.getLogger("PlannerBenchmark")
+logger.setLevel(logging.INFO)
+
+rng = random.Random(args.seed)
+start = Point2D(0.0, 0.0)
+results = []
+print(f"{'distribution':<12} {'points':>6} {'planner':<18} {'time ms':>10} {'length m':>10} {'gap %':>7} {'peak KiB':>9}")
+
+for distribution in args.distributions:
+    for size in args.sizes:
+        planners = [name for name in args.planners
+                    if name != "ilp" or size <= config.PLANNER_BENCHMARK_ILP_MAX_POINTS]
+        runs: Dict[str, List[Dict]] = {name: [] for name in planners}
+        for _ in range(args.instances):
+            points = DISTRIBUTIONS[distribution](rng, size, config.PLANNER_BENCHMARK_AREA)
+            instance = {name: run_planner(name, start, points, not args.no_memory) for name in planners}
+            # Best known: the shortest valid path any planner found on the instance
+            best = min((run["length"] for run in instance.values() if run["valid"]), default=None)
+            for name, run in instance.items():
+                if not run["valid"]:
+                    logger.warning("%s did not visit every point once on a %s instance of %d points.", name, distribution, size)
+                run["gap"] = (run["length"] / best - 1) if best and run["valid"] else None
+                runs[name].append(run)
+
+        for name in planners:
+            row = {
+                "distribution": distribution,
+                "points": size,
+                "planner": name,
+                "instances": len(runs[name]),
+                "valid": all(run["valid"] for run in runs[name]),
+                "time": mean([run["time"] for run in runs[name]]),
+                "max_time": max(run["time"] for run in runs[name]),
+                "length": mean([run["length"] for run in runs[name]]),
+                "gap": mean([run["gap"] for run in runs[name]]),
+                "peak_memory": mean([run["peak_memory"] for run in runs[name]]),
+            }
+            results.append(row)
+            gap = f"{row['gap'] * 100:7.2f}" if row["gap"] is not None else f"{'-':>7}"
+            peak = f"{row['peak_memory'] / 1024:9.0f}" if row["peak_memory"] is not None else f"{'-':>9}"
+            print(f"{distribution:<12} {size:>6} {name:<18} {row['time'] * 1000:>10.2f} {row['length']:>10.1f} {gap} {peak}")
+
+timestamp = datetime.now().strftime("%Y_%m_%d_%H_%M_%S")
+os.makedirs(config.BENCHMARK_OUTPUT_FOLDER, exist_ok=True)
+path = f"{config.BENCHMARK_OUTPUT_FOLDER}/planners_{timestamp}.json"
+with open(path, "w") as f:
+    json.dump({"seed": args.seed, "area": config.PLANNER_BENCHMARK_AREA, "results": results}, f, indent=4)
+logger.info(f"Planner benchmark results saved to {os.path.abspath(path)}")
@@ -0,0 +1,281 @@
+import heapq
+import json
+import math
+import threading
+from collections import OrderedDict
+from typing import Dict, List, Optional, Tuple
+
+from configuration import planner as config
+from structures.structures import Point2D
+from interfaces.interfaces import IDistanceProvider
+
+class EuclideanDistanceProvider(IDistanceProvider):
+    """
+    Distance provider for an open field: the shortest path between two points is the straight segment.
+    """
+
+    def distance(self, p1: Point2D, p2: Point2D) -> float:
+        """
+        Computes the Euclidean distance between two 2D points.
+
+        Args:
+            p1 (Point2D): First point.
+            p2 (Point2D): Second point.
+
+        Returns:
+            float: Euclidean distance between the two points.
+        """
+        return math.hypot(p1.x - p2.x, p1.y - p2.y)
+
+    def path(self, p1: Point2D, p2: Point2D) -> List[Point2D]:
+        """
+        Returns the straight path between two points.
+
+        Args:
+            p1 (Point2D): Start point.
+            p2 (Point2D): End point.
+
+        Returns:
+            List[Point2D]: The end point only.
+        """
+        return [p2]
+
+class ObstacleDistanceProvider(IDistanceProvider):
+    """
+    Distance provider around rectangular obstacles, based on a visibility graph.
+
+    The obstacles are inflated by PLANNER_OBSTACLE_MARGIN. Shortest paths around them
+    go straight between points and inflated obstacle corners that see each other, so the
+    graph nodes are the corners, linked when the segment between them crosses no
+    obstacle. The shortest distances from a point to all the corners (Dijkstra) are computed
+    on first use and cached, as are the pairwise distances, so the cost of a distance
+    is paid once per pair, across planners and missions.
+
+    A point inside an inflated obstacle, such as a target next to a wall, ignores that obstacle.
+    """
+
+    def __init__(self, obstacles: List[Tuple[float, float, float, float]]) -> None:
+        """
+        Creates an ObstacleDistanceProvider instance.
+
+        Args:
+            obstacles (List[Tuple[float, float, float, float]]): Obstacles as (x_min, y_min, x_max, y_max) rectangles (in meters).
+        """
+        m = config.PLANNER_OBSTACLE_MARGIN
+        self._obstacles: List[Tuple[float, float, float, float]] = [
+            (x0 - m, y0 - m, x1 + m, y1 + m) for x0, y0, x1, y1 in obstacles]
+        self._corners: List[Point2D] = [Point2D(x, y) for x0, y0, x1, y1 in self._obstacles
+                                        for x, y in ((x0, y0), (x1, y0), (x1, y1), (x0, y1))]
+        self._corner_edges: List[List[Tuple[int, float]]] = [
+            [(j, self._euclidean(a, b)) for j, b in enumerate(self._corners) if j != i and self._visible(a, b)]
+            for i, a in enumerate(self._corners)]
+
+        self._fields: "OrderedDict[Point2D, Tuple[List[float], List[int], List[int]]]" = OrderedDict()
+        self._distances: "OrderedDict[Tuple[Point2D, Point2D], float]" = OrderedDict()
+        self._lock: threading.Lock = threading.Lock()
+
+    @classmethod
+    def from_json(cls, path: str) -> IDistanceProvider:
+        """
+        Creates the distance provider of an operation file.
+
+        The file may hold an "obstacles" list of {"x_min", "y_min", "x_max", "y_max"} rectangles.
+
+        Args:
+            path (str): Path to the operation JSON file.
+
+        Returns:
+            IDistanceProvider: An ObstacleDistanceProvider, or an EuclideanDistanceProvider if the file has no obstacles.
+        """
+        with open(path, "r") as f:
+            data = json.load(f)
+        obstacles = [(o["x_min"], o["y_min"], o["x_max"], o["y_max"]) for o in data.get("obstacles", [])]
+        return cls(obstacles) if obstacles else EuclideanDistanceProvider()
+
+    # ---------------------------------------------------
+    # Public methods
+    # ---------------------------------------------------
+    def distance(self, p1: Point2D, p2: Point2D) -> float:
+        """
+        Computes the length of the shortest path between two points around the obstacles.
+
+        Args:
+            p1 (Point2D): First point.
+            p2 (Point2D): Second point.
+
+        Returns:
+            float: Path length (in meters), infinite if p2 cannot be reached.
+        """
+        with self._lock:
+            cached = self._distances.get((p1, p2))
+            if cached is not None:
+                self._distances.move_to_end((p1, p2))
+                return cached
+            dist, _ = self._shortest(p1, p2)
+            self._distances[(p1, p2)] = dist
+            self._distances[(p2, p1)] = dist
+            while len(self._distances) > config.PLANNER_DISTANCE_CACHE_SIZE:
+                self._distances.popitem(last=False)
+            return dist
+
+    def path(self, p1: Point2D, p2: Point2D) -> List[Point2D]:
+        """
+        Computes the shortest path between two points around the obstacles.
+
+        Args:
+            p1 (Point2D): Start point.
+            p2 (Point2D): End point.
+
+        Returns:
+            List[Point2D]: Obstacle corners to go through followed by the end point, or
+            the end point only if it cannot be reached.
+        """
+        with self._lock:
+            _, corner = self._shortest(p1, p2)
+            if corner < 0:
+                return [p2]
+            _, pred, _ = self._field(p1)
+            waypoints = [p2]
+            while corner >= 0:
+                waypoints.append(self._corners[corner])
+                corner = pred[corner]
+            return waypoints[::-1]
+
+    # ---------------------------------------------------
+    # Private methods
+    # ---------------------------------------------------
+    def _euclidean(self, p1: Point2D, p2: Point2D) -> float:
+        """
+        Computes the Euclidean distance between two 2D points.
+
+        Args:
+            p1 (Point2D): First point.
+            p2 (Point2D): Second point.
+
+        Returns:
+            float: Euclidean distance between the two points.
+        """
+        return math.hypot(p1.x - p2.x, p1.y - p2.y)
+
+    def _inside(self, p: Point2D, rect: Tuple[float, float, float, float]) -> bool:
+        """
+        Tells whether a point is strictly inside a rectangle.
+
+        Args:
+            p (Point2D): Point.
+            rect (Tuple[float, float, float, float]): Rectangle as (x_min, y_min, x_max, y_max).
+
+        Returns:
+            bool: True if the point is inside.
+        """
+        x0, y0, x1, y1 = rect
+        return x0 < p.x < x1 and y0 < p.y < y1
+
+    def _crosses(self, a: Point2D, b: Point2D, rect: Tuple[float, float, float, float]) -> bool:
+        """
+        Tells whether a segment goes through the interior of a rectangle (Liang-Barsky clipping).
+
+        Segments along the rectangle sides or through its corners do not cross it.
+
+        Args:
+            a (Point2D): Segment start.
+            b (Point2D): Segment end.
+            rect (Tuple[float, float, float, float]): Rectangle as (x_min, y_min, x_max, y_max).
+
+        Returns:
+            bool: True if part of the segment is inside the rectangle.
+        """
+        eps = 1e-9
+        x0, y0, x1, y1 = rect[0] + eps, rect[1] + eps, rect[2] - eps, rect[3] - eps
+        dx, dy = b.x - a.x, b.y - a.y
+        t0, t1 = 0.0, 1.0
+        for p, q in ((-dx, a.x - x0), (dx, x1 - a.x), (-dy, a.y - y0), (dy, y1 - a.y)):
+            if p == 0:
+                if q <= 0:
+                    return False
+                continue
+            t = q / p
+            if p < 0:
+                t0 = max(t0, t)
+            else:
+                t1 = min(t1, t)
+            if t0 >= t1:
+                return False
+        return True
+
+    def _visible(self, a: Point2D, b: Point2D) -> bool:
+        """
+        Tells whether the segment between two points crosses no obstacle, ignoring the obstacles containing them.
+
+        Args:
+            a (Point2D): Segment start.
+            b (Point2D): Segment end.
+
+        Returns:
+            bool: True if the segment is free.
+        """
+        return not any(self._crosses(a, b, rect) for rect in self._obstacles
+                       if not self._inside(a, rect) and not self._inside(b, rect))
+
+    def _field(self, p: Point2D) -> Tuple[List[float], List[int], List[int]]:
+        """
+        Returns the shortest distances from a point to every corner, computing and caching them if needed.
+
+        Args:
+            p (Point2D): Source point.
+
+        Returns:
+            Tuple[List[float], List[int], List[int]]: Distance to each corner, previous corner of each
+            shortest path (-1 if reached straight from the point), and corners visible from the point.
+        """
+        field = self._fields.get(p)
+        if field is not None:
+            self._fields.move_to_end(p)
+            return field
+
+        n = len(self._corners)
+        dist = [math.inf] * n
+        pred = [-1] * n
+        visible = [i for i, c in enumerate(self._corners) if self._visible(p, c)]
+        heap = []
+        for i in visible:
+            dist[i] = self._euclidean(p, self._corners[i])
+            heap.append((dist[i], i))
+        heapq.heapify(heap)
+        while heap:
+            d, i = heapq.heappop(heap)
+            if d > dist[i]:
+                continue
+            for j, w in self._corner_edges[i]:
+                if d + w < dist[j]:
+                    dist[j] = d + w
+                    pred[j] = i
+                    heapq.heappush(heap, (dist[j], j))
+
+        field = (dist, pred, visible)
+        self._fields[p] = field
+        while len(self._fields) > config.PLANNER_FIELD_CACHE_SIZE:
+            self._fields.popitem(last=False)
+        return field
+
+    def _shortest(self, p1: Point2D, p2: Point2D) -> Tuple[float, int]:
+        """
+        Computes the shortest path length between two points and its last corner.
+
+        Args:
+            p1 (Point2D): Start point.
+            p2 (Point2D): End point.
+
+        Returns:
+            Tuple[float, int]: Path length, and last corner of the path (-1 if the path is straight or none exists).
+        """
+        if self._visible(p1, p2):
+            return self._euclidean(p1, p2), -1
+        dist, _, _ = self._field(p1)
+        _, _, visible = self._field(p2)
+        best, last = math.inf, -1
+        for i in visible:
+            d = dist[i] + self._euclidean(self._corners[i], p2)
+            if d < best:
+                best, last = d, i
+        return best, last
@@ -1,8 +1,12 @@
 import gurobipy as gp
-from typing import List, Tuple, Dict
+import logging
+from typing import List, Optional, Tuple, Dict
 
+from configuration import planner as config
 from structures.structures import Point2D
-from interfaces.interfaces import IPathPlanner
+from interfaces.interfaces import IDistanceProvider, IPathPlanner
+from planners.distance_providers import EuclideanDistanceProvider
+from planners.local_search_planner import LocalSearchPlanner
 
 class ILPPlanner(IPathPlanner):
     """
@@ -14,9 +18,23 @@ class ILPPlanner(IPathPlanner):
     total traveled Euclidean distance while visiting each point exactly once.
     
     The ILP model is solved using the commercial solver Gurobi through its Python
-    API (``gurobipy``).
+    API (``gurobipy``). Connectivity constraints are added lazily from a solver callback
+    whenever a candidate solution has points disconnected from the start point, and the
+    solver is warm-started from the LocalSearchPlanner path and limited to
+    PLANNER_ILP_TIME_LIMIT.
     """
 
+    def __init__(self, distance: Optional[IDistanceProvider] = None) -> None:
+        """
+        Creates an ILPPlanner instance.
+
+        Args:
+            distance (Optional[IDistanceProvider]): Travel distance provider, Euclidean if None.
+        """
+        self._distance: IDistanceProvider = distance or EuclideanDistanceProvider()
+        self._heuristic: LocalSearchPlanner = LocalSearchPlanner(distance=self._distance)
+        self._logger: logging.Logger = logging.getLogger("ILPPlanner")
+
     # ---------------------------------------------------
     # Private methods
     # ---------------------------------------------------
@@ -52,13 +70,49 @@ class ILPPlanner(IPathPlanner):
 
         return path
 
+    def _components(self, n: int, edges: List[Tuple[int, int]]) -> List[List[int]]:
+        """
+        Computes the connected components of the graph formed by the selected edges.
+
+        Args:
+            n (int): Number of points.
+            edges (List[Tuple[int, int]]): Selected edges.
+
+        Returns:
+            List[List[int]]: Point indices of each component, the component of the start point first.
+        """
+        adj = [[] for _ in range(n)]
+        for i, j in edges:
+            adj[i].append(j)
+            adj[j].append(i)
+
+        seen = [False] * n
+        components = []
+        for root in range(n):
+            if seen[root]:
+                continue
+            seen[root] = True
+            stack, component = [root], []
+            while stack:
+                v = stack.pop()
+                component.append(v)
+                for w in adj[v]:
+                    if not seen[w]:
+                        seen[w] = True
+                        stack.append(w)
+            components.append(component)
+        return components
+
     def _solve_gurobi(self, points: List[Point2D]) -> Dict:
         """
         Builds and solves the ILP model for the path planning problem.
 
         This method formulates the routing problem as an integer linear program
         where binary variables indicate whether an edge between two points is
-        selected.
+        selected. The start point has degree 1, the other points degree 1 or 2, and
+        n - 1 edges are selected. Each integer solution with a set S of points disconnected
+        from the start point is cut off by the lazy constraint requiring an edge leaving S,
+        so the accepted solutions are paths from the start point through all the points.
 
         Args:
             points (List[Point2D]): List of all points, including the starting point in index 0.
@@ -66,12 +120,12 @@ class ILPPlanner(IPathPlanner):
         Returns:
             Dict: Dictionary containing:
                 - status: Solver termination status.
-                - obj: Objective value (total distance), if optimal.
+                - obj: Objective value (total distance) of the best solution found, if any.
                 - ordered_points: List of points in visiting order.
         """    
         n = len(points)
         nodes = list(range(n))
-        dist = {(i, j): self._euclidean_distance(points[i], points[j]) for i in range(n) for j in range(i + 1, n)}
+        dist = {(i, j): self._distance.distance(points[i], points[j]) for i in range(n) for j in range(i + 1, n)}
 
         m = gp.Model()
 
@@ -83,35 +137,46 @@ class ILPPlanner(IPathPlanner):
             if i == 0:
                 m.addConstr(deg_expr == 1)
             else:
+                m.addConstr(deg_expr >= 1)
                 m.addConstr(deg_expr <= 2)
 
         m.addConstr(gp.quicksum(x.values()) == n - 1, name ="total_edges")
 
+        # Warm start from the heuristic path
+        order = {p: k for k, p in enumerate(self._heuristic.plan_path(points[0], points[1:]), start=1)}
+        tour = [0] + sorted(range(1, n), key=lambda k: order[points[k]])
+        for var in x.values():
+            var.Start = 0
+        for i, j in zip(tour, tour[1:]):
+            x[(min(i, j), max(i, j))].Start = 1
+
+        def connectivity_cuts(model: gp.Model, where: int) -> None:
+            if where != gp.GRB.Callback.MIPSOL:
+                return
+            values = model.cbGetSolution(x)
+            edges = [e for e, v in values.items() if v > 0.5]
+            for component in self._components(n, edges)[1:]:
+                inside = set(component)
+                model.cbLazy(gp.quicksum(var for (i, j), var in x.items() if (i in inside) != (j in inside)) >= 1)
+
+        m.Params.LazyConstraints = 1
+        m.Params.TimeLimit = config.PLANNER_ILP_TIME_LIMIT
         m.modelSense = gp.GRB.MINIMIZE
-        m.optimize()
+        m.optimize(connectivity_cuts)
+
+        if m.SolCount == 0:
+            self._logger.warning("No ILP solution found (status %d), using the heuristic path.", m.status)
+            return {"status": m.status, "obj": None, "ordered_points": [points[i] for i in tour]}
 
         sol_edges = [(i, j) for (i, j), var in x.items() if var.x > 0.5]
         path = self._extract_path(sol_edges)
 
         return {
             "status": m.status,
-            "obj": m.objVal if m.status == gp.GRB.OPTIMAL else None,
+            "obj": m.objVal,
             "ordered_points": [points[i] for i in path]
         }
 
-    def _euclidean_distance(self, p1: Point2D, p2: Point2D) -> float:
-        """
-        Computes the Euclidean distance between two 2D points.
-
-        Args:
-            p1 (Point2D): First point.
-            p2 (Point2D): Second point.
-
-        Returns:
-            float: Euclidean distance between the two points.
-        """
-        return ((p1.x - p2.x) ** 2 + (p1.y - p2.y) ** 2) ** 0.5
-    
     # ---------------------------------------------------
     # Public methods
     # ---------------------------------------------------
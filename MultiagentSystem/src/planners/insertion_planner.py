@@ -0,0 +1,166 @@
+from typing import List, Optional, Tuple
+
+from structures.structures import Point2D
+from interfaces.interfaces import IDistanceProvider, IPathPlanner
+from planners.distance_providers import EuclideanDistanceProvider
+
+class InsertionPlanner(IPathPlanner):
+    """
+    Incremental path planner.
+
+    This class keeps a live route from a start point and inserts each new point
+    where it lengthens the route the least (cheapest insertion), so points can be
+    added while the route is being followed. Each insertion takes linear time in
+    the route length.
+
+    It is not thread safe: callers must hold their own lock.
+    """
+
+    def __init__(self, distance: Optional[IDistanceProvider] = None) -> None:
+        """
+        Creates an InsertionPlanner instance with an empty route from the origin.
+
+        Args:
+            distance (Optional[IDistanceProvider]): Travel distance provider, Euclidean if None.
+        """
+        self._distance: IDistanceProvider = distance or EuclideanDistanceProvider()
+        self._start: Point2D = Point2D(0.0, 0.0)
+        self._route: List[Point2D] = []
+
+    # ----------------------------------------------------------------
+    # Public Methods
+    # ----------------------------------------------------------------
+    def reset(self, start_point: Point2D, points: Optional[List[Point2D]] = None) -> None:
+        """
+        Replaces the route.
+
+        Args:
+            start_point (Point2D): Start point of the route.
+            points (Optional[List[Point2D]]): Ordered points of the route, empty if None.
+        """
+        self._start = start_point
+        self._route = list(points or [])
+
+    def insertion_cost(self, point: Point2D) -> Tuple[int, float]:
+        """
+        Finds the cheapest place of a point in the route, without inserting it.
+
+        Args:
+            point (Point2D): Point to place.
+
+        Returns:
+            Tuple[int, float]: Index the point would take in the route, and the route lengthening (in meters).
+        """
+        d = self._distance.distance
+        best_index = len(self._route)
+        best_cost = d(self._route[-1], point) if self._route else d(self._start, point)
+        prev = self._start
+        for index, nxt in enumerate(self._route):
+            cost = d(prev, point) + d(point, nxt) - d(prev, nxt)
+            if cost < best_cost:
+                best_index, best_cost = index, cost
+            prev = nxt
+        return best_index, best_cost
+
+    def insert_point(self, point: Point2D) -> int:
+        """
+        Inserts a point into the route at the cheapest place.
+
+        Args:
+            point (Point2D): Point to insert.
+
+        Returns:
+            int: Index of the point in the route.
+        """
+        index, _ = self.insertion_cost(point)
+        self._route.insert(index, point)
+        return index
+
+    def removal_saving(self, index: int) -> float:
+        """
+        Computes how much the route shortens when one of its points is removed.
+
+        Args:
+            index (int): Index of the point in the route.
+
+        Returns:
+            float: Route shortening (in meters).
+        """
+        d = self._distance.distance
+        prev = self._route[index - 1] if index > 0 else self._start
+        point = self._route[index]
+        if index + 1 == len(self._route):
+            return d(prev, point)
+        nxt = self._route[index + 1]
+        return d(prev, point) + d(point, nxt) - d(prev, nxt)
+
+    def remove_at(self, index: int) -> Point2D:
+        """
+        Removes a point from the route.
+
+        Args:
+            index (int): Index of the point in the route.
+
+        Returns:
+            Point2D: The removed point.
+        """
+        return self._route.pop(index)
+
+    def pop_next(self) -> Optional[Point2D]:
+        """
+        Removes the first point of the route, which becomes the start point.
+
+        Returns:
+            Optional[Point2D]: The next point to visit, or None if the route is empty.
+        """
+        if not self._route:
+            return None
+        self._start = self._route.pop(0)
+        return self._start
+
+    def start_point(self) -> Point2D:
+        """
+        Returns the start point of the route, that is the last point popped.
+
+        Returns:
+            Point2D: Start point.
+        """
+        return self._start
+
+    def length(self) -> float:
+        """
+        Computes the length of the route from its start point.
+
+        Returns:
+            float: Route length (in meters).
+        """
+        d = self._distance.distance
+        return sum(d(a, b) for a, b in zip([self._start] + self._route, self._route))
+
+    def current_path(self) -> List[Point2D]:
+        """
+        Returns the remaining route.
+
+        Returns:
+            List[Point2D]: Ordered points still to visit, without the start point.
+        """
+        return list(self._route)
+
+    def plan_path(self, start_point: Point2D, points: List[Point2D]) -> List[Point2D]:
+        """
+        Computes an ordered path by inserting the points one by one at the cheapest place.
+
+        The live route is replaced by the planned path.
+
+        Args:
+            start_point (Point2D): Initial position from which the path is built.
+            points (List[Point2D]): Set of target points to be visited.
+
+        Returns:
+            List[Point2D]: Ordered list of points representing the visiting sequence,
+            without the start point. If the input list is empty, an empty list is returned.
+        """
+        self.reset(start_point)
+        for point in points:
+            self.insert_point(point)
+        return self.current_path()
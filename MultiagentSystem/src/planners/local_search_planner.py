@@ -0,0 +1,181 @@
+import heapq
+from time import perf_counter
+from typing import List, Optional
+
+from configuration import planner as config
+from structures.structures import Point2D
+from interfaces.interfaces import IDistanceProvider, IPathPlanner
+from planners.distance_providers import EuclideanDistanceProvider
+
+class LocalSearchPlanner(IPathPlanner):
+    """
+    Heuristic path planner with local search improvement.
+
+    This class builds a path with the nearest neighbor strategy and then improves it
+    with 2-opt (reversal of a subpath) and Or-opt (relocation of a run of up to
+    PLANNER_OR_OPT_MAX_SEGMENT points, possibly reversed) moves until no move shortens it,
+    or until PLANNER_TIME_BUDGET is spent. The moves only join points to their
+    PLANNER_NEIGHBORS nearest neighbors, so each pass over the path takes linear time.
+
+    The path is open: it starts at the start point and ends at any point.
+    """
+
+    def __init__(self, time_budget: float = config.PLANNER_TIME_BUDGET, distance: Optional[IDistanceProvider] = None) -> None:
+        """
+        Creates a LocalSearchPlanner instance.
+
+        Args:
+            time_budget (float): Longest time (in seconds) spent improving a path.
+            distance (Optional[IDistanceProvider]): Travel distance provider, Euclidean if None.
+        """
+        self._time_budget: float = time_budget
+        self._distance: IDistanceProvider = distance or EuclideanDistanceProvider()
+
+    # ----------------------------------------------------------------
+    # Private Methods
+    # ----------------------------------------------------------------
+    def _nearest_neighbor_tour(self, dist: List[List[float]]) -> List[int]:
+        """
+        Builds a path from node 0 with the nearest neighbor strategy.
+
+        Args:
+            dist (List[List[float]]): Distance matrix, node 0 being the start point.
+
+        Returns:
+            List[int]: Ordered node indices, starting with 0.
+        """
+        remaining = set(range(1, len(dist)))
+        tour = [0]
+        while remaining:
+            row = dist[tour[-1]]
+            nxt = min(remaining, key=row.__getitem__)
+            tour.append(nxt)
+            remaining.remove(nxt)
+        return tour
+
+    def _two_opt(self, tour: List[int], pos: List[int], dist: List[List[float]], neighbors: List[List[int]]) -> bool:
+        """
+        Applies the first improving 2-opt move found, if any.
+
+        The move reverses tour[lo + 1..hi], replacing the edges (tour[lo], tour[lo + 1]) and
+        (tour[hi], tour[hi + 1]) by (tour[lo], tour[hi]) and (tour[lo + 1], tour[hi + 1]).
+        When hi is the last node, the second edge does not exist.
+
+        Args:
+            tour (List[int]): Path, modified in place.
+            pos (List[int]): Position of each node in the path, updated in place.
+            dist (List[List[float]]): Distance matrix.
+            neighbors (List[List[int]]): Nearest neighbors of each node.
+
+        Returns:
+            bool: True if the path was improved.
+        """
+        last = len(tour) - 1
+        for i in range(last):
+            a = tour[i]
+            for c in neighbors[a]:
+                lo, hi = sorted((i, pos[c]))
+                if hi <= lo + 1:
+                    continue
+                p, q = tour[lo], tour[lo + 1]
+                r = tour[hi]
+                delta = dist[p][r] - dist[p][q]
+                if hi < last:
+                    s = tour[hi + 1]
+                    delta += dist[q][s] - dist[r][s]
+                if delta < -1e-9:
+                    tour[lo + 1:hi + 1] = tour[lo + 1:hi + 1][::-1]
+                    for k in range(lo + 1, hi + 1):
+                        pos[tour[k]] = k
+                    return True
+        return False
+
+    def _or_opt(self, tour: List[int], pos: List[int], dist: List[List[float]], neighbors: List[List[int]]) -> bool:
+        """
+        Applies the first improving Or-opt move found, if any.
+
+        The move takes a run of consecutive nodes out of the path and inserts it, in either
+        direction, next to a neighbor of one of its ends.
+
+        Args:
+            tour (List[int]): Path, modified in place.
+            pos (List[int]): Position of each node in the path, updated in place.
+            dist (List[List[float]]): Distance matrix.
+            neighbors (List[List[int]]): Nearest neighbors of each node.
+
+        Returns:
+            bool: True if the path was improved.
+        """
+        n = len(tour)
+        for length in range(1, config.PLANNER_OR_OPT_MAX_SEGMENT + 1):
+            for i in range(1, n - length + 1):
+                j = i + length - 1
+                first, end = tour[i], tour[j]
+                prev = tour[i - 1]
+                nxt = tour[j + 1] if j + 1 < n else None
+                gain = dist[prev][first]
+                if nxt is not None:
+                    gain += dist[end][nxt] - dist[prev][nxt]
+
+                for c in neighbors[first] + neighbors[end]:
+                    k = pos[c]
+                    if i <= k <= j:
+                        continue
+                    # Gaps next to c: (tour[k - 1], c) and (c, tour[k + 1])
+                    for u, v in ((k - 1, k), (k, k + 1)):
+                        if u < 0 or i <= u <= j or i <= v <= j or (u == i - 1 and v == j + 1):
+                            continue
+                        x = tour[u]
+                        y = tour[v] if v < n else None
+                        removed = dist[x][y] if y is not None else 0.0
+                        for head, tail in ((first, end), (end, first)):
+                            cost = dist[x][head] - removed
+                            if y is not None:
+                                cost += dist[tail][y]
+                            if cost - gain < -1e-9:
+                                segment = tour[i:j + 1] if head == first else tour[i:j + 1][::-1]
+                                rest = tour[:i] + tour[j + 1:]
+                                at = u + 1 if u < i else u + 1 - length
+                                tour[:] = rest[:at] + segment + rest[at:]
+                                for idx, node in enumerate(tour):
+                                    pos[node] = idx
+                                return True
+        return False
+
+    # ----------------------------------------------------------------
+    # Public Methods
+    # ----------------------------------------------------------------
+    def plan_path(self, start_point: Point2D, points: List[Point2D], time_budget: Optional[float] = None) -> List[Point2D]:
+        """
+        Computes an ordered path with the nearest neighbor heuristic improved by local search.
+
+        Args:
+            start_point (Point2D): Initial position from which the path is built.
+            points (List[Point2D]): Set of target points to be visited.
+            time_budget (Optional[float]): Longest improvement time (in seconds), the planner
+                default if None.
+
+        Returns:
+            List[Point2D]: Ordered list of points representing the visiting sequence,
+            without the start point. If the input list is empty, an empty list is returned.
+        """
+        if not points:
+            return []
+
+        deadline = perf_counter() + (self._time_budget if time_budget is None else time_budget)
+        nodes = [start_point] + points
+        dist = [[self._distance.distance(p, q) for q in nodes] for p in nodes]
+        neighbors = [heapq.nsmallest(config.PLANNER_NEIGHBORS, (j for j in range(len(nodes)) if j != i),
+                                     key=row.__getitem__)
+                     for i, row in enumerate(dist)]
+
+        tour = self._nearest_neighbor_tour(dist)
+        pos = [0] * len(tour)
+        for idx, node in enumerate(tour):
+            pos[node] = idx
+
+        while perf_counter() < deadline:
+            if not (self._two_opt(tour, pos, dist, neighbors) or self._or_opt(tour, pos, dist, neighbors)):
+                break
+
+        return [nodes[i] for i in tour[1:]]
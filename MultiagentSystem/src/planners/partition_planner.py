@@ -0,0 +1,134 @@
+from concurrent.futures import ThreadPoolExecutor
+from time import perf_counter
+from typing import List
+
+from configuration import planner as config
+from structures.structures import Point2D
+from interfaces.interfaces import IPathPlanner
+from planners.insertion_planner import InsertionPlanner
+
+class PartitionPlanner(IPathPlanner):
+    """
+    Multi-inspector path planner.
+
+    This class splits the points among several inspectors and plans the route of each
+    inspector with a single-inspector planner. The points are first clustered with k-means,
+    seeded at the inspector start points. The routes are then balanced by moving points from
+    the longest route to the route where they lengthen the longest route the least (min-max),
+    and finally each route is planned in its own thread.
+    """
+
+    def __init__(self, planner: IPathPlanner) -> None:
+        """
+        Creates a PartitionPlanner instance.
+
+        Args:
+            planner (IPathPlanner): Planner of each inspector route, whose distance provider is shared.
+        """
+        self._planner: IPathPlanner = planner
+        self._distance = planner.get_distance_provider()
+
+    # ----------------------------------------------------------------
+    # Private Methods
+    # ----------------------------------------------------------------
+    def _cluster(self, starts: List[Point2D], points: List[Point2D]) -> List[List[Point2D]]:
+        """
+        Assigns each point to the closest cluster center with k-means, the centers starting at the inspectors.
+
+        Args:
+            starts (List[Point2D]): Start point of each inspector.
+            points (List[Point2D]): Points to assign.
+
+        Returns:
+            List[List[Point2D]]: Points of each inspector.
+        """
+        d = self._distance.distance
+        centers = list(starts)
+        clusters: List[List[Point2D]] = [[] for _ in starts]
+        for _ in range(max(config.PLANNER_PARTITION_ITERATIONS, 1)):
+            clusters = [[] for _ in starts]
+            for point in points:
+                k = min(range(len(centers)), key=lambda i: d(centers[i], point))
+                clusters[k].append(point)
+            moved = [Point2D(sum(p.x for p in c) / len(c), sum(p.y for p in c) / len(c)) if c else centers[k]
+                     for k, c in enumerate(clusters)]
+            if moved == centers:
+                break
+            centers = moved
+        return clusters
+
+    def _balance(self, starts: List[Point2D], clusters: List[List[Point2D]]) -> List[List[Point2D]]:
+        """
+        Moves points out of the longest route while it shortens the longest route.
+
+        The routes are kept with cheapest insertion while balancing, for at most PLANNER_TIME_BUDGET.
+
+        Args:
+            starts (List[Point2D]): Start point of each inspector.
+            clusters (List[List[Point2D]]): Points of each inspector.
+
+        Returns:
+            List[List[Point2D]]: Balanced points of each inspector.
+        """
+        routes = [InsertionPlanner(self._distance) for _ in starts]
+        for route, start, cluster in zip(routes, starts, clusters):
+            route.plan_path(start, cluster)
+        lengths = [route.length() for route in routes]
+
+        deadline = perf_counter() + config.PLANNER_TIME_BUDGET
+        for _ in range(config.PLANNER_BALANCE_MOVES):
+            if perf_counter() >= deadline:
+                break
+            longest = max(range(len(routes)), key=lengths.__getitem__)
+            best = None
+            for index, point in enumerate(routes[longest].current_path()):
+                shortened = lengths[longest] - routes[longest].removal_saving(index)
+                for k, route in enumerate(routes):
+                    if k == longest or lengths[k] >= lengths[longest]:
+                        continue
+                    _, cost = route.insertion_cost(point)
+                    worst = max(shortened, lengths[k] + cost)
+                    if worst < lengths[longest] - 1e-9 and (best is None or worst < best[0]):
+                        best = (worst, index, k, shortened, cost)
+            if best is None:
+                break
+            _, index, k, shortened, cost = best
+            routes[k].insert_point(routes[longest].remove_at(index))
+            lengths[longest] = shortened
+            lengths[k] += cost
+
+        return [route.current_path() for route in routes]
+
+    # ----------------------------------------------------------------
+    # Public Methods
+    # ----------------------------------------------------------------
+    def plan_routes(self, starts: List[Point2D], points: List[Point2D]) -> List[List[Point2D]]:
+        """
+        Splits the points among the inspectors and plans the route of each one.
+
+        Args:
+            starts (List[Point2D]): Start point of each inspector.
+            points (List[Point2D]): Target points to be visited.
+
+        Returns:
+            List[List[Point2D]]: Ordered points to visit by each inspector, without its start point.
+        """
+        if len(starts) == 1:
+            return [self.plan_path(starts[0], points)]
+
+        clusters = self._balance(starts, self._cluster(starts, points))
+        with ThreadPoolExecutor(max_workers=len(starts)) as pool:
+            return list(pool.map(self._planner.plan_path, starts, clusters))
+
+    def plan_path(self, start_point: Point2D, points: List[Point2D]) -> List[Point2D]:
+        """
+        Computes the path of a single inspector with the route planner.
+
+        Args:
+            start_point (Point2D): Initial position from which the path is built.
+            points (List[Point2D]): Target points to be visited.
+
+        Returns:
+            List[Point2D]: Ordered list of points representing the planned path.
+        """
+        return self._planner.plan_path(start_point, points)
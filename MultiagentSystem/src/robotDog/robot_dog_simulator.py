@@ -1,6 +1,5 @@
 import logging
 import threading
-import time
 from math import hypot
 from typing import Dict, List, Optional
 from numpy.random import normal
@@ -8,6 +7,7 @@ from numpy.random import normal
 from configuration import robot_dog as config
 from interfaces.interfaces import ARobot
 from structures.structures import Point2D
+from utils import sim_clock
 
 class RobotDogSimulator(ARobot):
     """
@@ -162,7 +162,7 @@ class RobotDogSimulator(ARobot):
                 ny = cy + (ty - cy) * ratio
                 self._current_position = Point2D(nx, ny)
 
-                time.sleep(config.ROBOT_SLEEP_TIME)
+                sim_clock.sleep(config.ROBOT_SLEEP_TIME)
 
         if self._callback_onFinish:
             try:
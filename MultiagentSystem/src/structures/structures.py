@@ -1,17 +1,27 @@
 from __future__ import annotations
-from dataclasses import dataclass
+from dataclasses import dataclass, field
+from typing import Dict, Optional, Tuple
 import numpy as np
+import threading
 
-@dataclass(frozen=True)
+from utils.jpeg import decode_jpeg, jpeg_size
+
+@dataclass(frozen=True, slots=True)
 class Battery:
     """Battery status.
 
     Attributes:
         voltage (float): Battery voltage (in volts).
+        compensated_voltage (float): Battery voltage without the sag of the motor load (in volts).
+        charge (float): Battery charge (in percent).
+        remaining_time (float): Flight time left (in seconds), negative until the drone has measured it.
     """
     voltage: float
+    compensated_voltage: float = 0.0
+    charge: float = 0.0
+    remaining_time: float = -1.0
     
-@dataclass(frozen=True)
+@dataclass(frozen=True, slots=True)
 class Position:
     """3D position in space.
 
@@ -24,7 +34,33 @@ class Position:
     y: float
     z: float
 
-@dataclass(frozen=True)
+@dataclass(frozen=True, slots=True)
+class Velocity:
+    """3D linear velocity.
+
+    Attributes:
+        vx (float): Velocity along the X-axis (in meters per second).
+        vy (float): Velocity along the Y-axis (in meters per second).
+        vz (float): Velocity along the Z-axis (in meters per second).
+    """
+    vx: float
+    vy: float
+    vz: float
+
+@dataclass(frozen=True, slots=True)
+class Acceleration:
+    """3D linear acceleration.
+
+    Attributes:
+        ax (float): Acceleration along the X-axis (in Gs).
+        ay (float): Acceleration along the Y-axis (in Gs).
+        az (float): Acceleration along the Z-axis (in Gs).
+    """
+    ax: float
+    ay: float
+    az: float
+
+@dataclass(frozen=True, slots=True)
 class Orientation:
     """Orientation expressed as Euler angles.
 
@@ -37,7 +73,7 @@ class Orientation:
     pitch: float
     yaw: float
 
-@dataclass(frozen=True)
+@dataclass(frozen=True, slots=True)
 class Pose:
     """Full 6-DOF pose.
     Combines position and orientation.
@@ -49,26 +85,221 @@ class Pose:
     position: Position
     orientation: Orientation
 
-@dataclass(frozen=True)
+@dataclass(frozen=True, slots=True)
 class TelemetryData:
     """Aggregated telemetry snapshot.
 
     Attributes:
         pose (Pose): System pose.
         battery (Battery): Battery status.
+        velocity (Velocity): Linear velocity.
+        acceleration (Acceleration): Linear acceleration.
+        timestamp_us (int): Drone time the pose was sampled (in microseconds since boot).
     """
     pose: Pose
     battery: Battery
+    velocity: Velocity = field(default_factory=lambda: Velocity(0, 0, 0))
+    acceleration: Acceleration = field(default_factory=lambda: Acceleration(0, 0, 0))
+    timestamp_us: int = 0
+
+@dataclass(frozen=True)
+class StageTiming:
+    """Time histogram of one stage of the drone stabilizer loop.
+
+    Attributes:
+        bins (Tuple[int, ...]): Loop iterations per time bin over the last period, see LOOP_TIMING_BIN_EDGES_US.
+        max_us (int): Longest time of the last second (in microseconds).
+    """
+    bins: Tuple[int, ...]
+    max_us: int
+
+@dataclass(frozen=True)
+class LoopTiming:
+    """Timing of the drone stabilizer loop.
+
+    Attributes:
+        stages (Dict[str, StageTiming]): Histogram of each stage, the loop time and the wake up jitter, by name.
+        timestamp_us (int): Drone time the histograms were sent (in microseconds since boot).
+    """
+    stages: Dict[str, StageTiming]
+    timestamp_us: int
+
+@dataclass(frozen=True)
+class TaskLoad:
+    """CPU load and stack usage of one drone task.
+
+    Attributes:
+        name (str): Task name.
+        load_percent (float): CPU load over the last second (in percent of one core).
+        stack_left (int): Unused stack at peak usage (in bytes).
+        priority (int): Task base priority.
+    """
+    name: str
+    load_percent: float
+    stack_left: int
+    priority: int
+
+@dataclass(frozen=True)
+class SystemLoad:
+    """Load of the drone tasks.
+
+    Attributes:
+        tasks (Dict[str, TaskLoad]): Load of every task, by name.
+        free_heap (int): Free heap (in bytes).
+        min_free_heap (int): Lowest free heap since boot (in bytes).
+        timestamp_us (int): Drone time the load was measured (in microseconds since boot).
+    """
+    tasks: Dict[str, TaskLoad]
+    free_heap: int
+    min_free_heap: int
+    timestamp_us: int
+
+@dataclass(frozen=True)
+class QueueFill:
+    """Fill and overflows of one drone queue over the last second.
+
+    Attributes:
+        name (str): Queue name.
+        length (int): Queue length (in items).
+        sent (int): Items sent to the queue.
+        peak (int): Most items waiting in the queue, its length when it overflowed.
+        full (int): Items dropped because the queue was full.
+    """
+    name: str
+    length: int
+    sent: int
+    peak: int
+    full: int
+
+@dataclass(frozen=True)
+class QueueLoad:
+    """Load of the drone queues.
+
+    Attributes:
+        queues (Dict[str, QueueFill]): Fill of every monitored queue, by name.
+        timestamp_us (int): Drone time at the end of the measured second (in microseconds since boot).
+    """
+    queues: Dict[str, QueueFill]
+    timestamp_us: int
+
+@dataclass(frozen=True)
+class ThermalHotspot:
+    """Connected group of hot pixels of the drone thermal array.
+
+    Attributes:
+        column (float): Column of the centroid, 0 to 8 from the left edge of the array (in pixels).
+        row (float): Row of the centroid, 0 to 8 from the top edge of the array (in pixels).
+        pixels (int): Number of pixels.
+        peak_celsius (float): Hottest pixel (in degrees Celsius).
+    """
+    column: float
+    row: float
+    pixels: int
+    peak_celsius: float
+
+@dataclass(frozen=True)
+class HotspotEvent:
+    """Hotspots found by the drone in one thermal frame.
+
+    Attributes:
+        pose (Pose): Drone pose when the frame was read.
+        background_celsius (float): Median pixel of the frame (in degrees Celsius).
+        hotspots (Tuple[ThermalHotspot, ...]): Hotspots, hottest first.
+        timestamp_us (int): Drone time the frame was read (in microseconds since boot).
+    """
+    pose: Pose
+    background_celsius: float
+    hotspots: Tuple[ThermalHotspot, ...]
+    timestamp_us: int
+
+@dataclass(frozen=True)
+class ClockEstimate:
+    """Mapping of a remote device clock onto the ground station monotonic clock.
+
+    Attributes:
+        offset_us (float): Local time minus remote time, now (in microseconds).
+        drift_ppm (float): Rate at which the offset grows (in parts per million).
+        error_us (float): Bound of the offset error, half the shortest round trip (in microseconds),
+            -1 when only estimated from one-way messages.
+        synced (bool): True if estimated from time exchanges, False if from one-way message timestamps,
+            which include the transmission delay.
+    """
+    offset_us: float
+    drift_ppm: float
+    error_us: float
+    synced: bool
 
 @dataclass(frozen=True)
 class Frame:
     """Captured camera frame.
 
     Attributes:
-        data (np.ndarray): Image array with shape (H, W, C).
-              Typically uint8 RGB or BGR.
+        data (Optional[np.ndarray]): Image array with shape (H, W, C), typically uint8 BGR,
+              None if the frame only holds its JPEG (see image).
+        seq (int): Frame sequence number assigned by the camera (-1 if unknown).
+        capture_timestamp_us (int): Camera sensor capture time (in microseconds, camera clock).
+        pose (Optional[Pose]): Drone pose embedded by the camera at capture time, if any.
+        pose_timestamp_us (int): Drone time the embedded pose was sampled (in microseconds since boot).
+        color_ratio (float): Share of target-color pixels measured by the camera prefilter (-1 if not measured).
+        roi (Optional[Tuple[int, int, int, int]]): If the frame is a high resolution crop, the cropped
+              region (x, y, width, height) in pixels of the full view frame.
+        tilted (bool): Whether the camera flagged the drone as tilted past its attitude limit at capture time.
+        frame_id (int): Id given by the camera provider, increasing with each new frame (-1 if not assigned).
+        host_capture_us (int): Capture time on the ground station monotonic clock (in microseconds, 0 if unknown).
+              Estimated from capture_timestamp_us when the camera sends it, else the receive time.
+        jpeg (Optional[bytes]): JPEG the camera sent, kept undecoded (None for frames captured as arrays).
+        receive_us (int): Time the frame was fully received, on the ground station monotonic clock
+              (in microseconds, 0 if unknown).
+        camera_queue_us (int): Time the frame waited in the camera pipeline before being sent (in microseconds, 0 if unknown).
+        encode_us (int): Time the camera took to encode the frame as JPEG (in microseconds, 0 if the sensor output JPEG or unknown).
+
+    Frames from a camera provider are shared by all their readers: the data array is read-only
+    and must be copied before drawing on it. Frames captured as JPEG are decoded on demand by
+    image, once per scale whatever the number of readers.
     """
-    data: np.ndarray
+    data: Optional[np.ndarray] = None
+    seq: int = -1
+    capture_timestamp_us: int = 0
+    pose: Optional[Pose] = None
+    pose_timestamp_us: int = 0
+    color_ratio: float = -1.0
+    roi: Optional[Tuple[int, int, int, int]] = None
+    tilted: bool = False
+    frame_id: int = -1
+    host_capture_us: int = 0
+    jpeg: Optional[bytes] = None
+    receive_us: int = 0
+    camera_queue_us: int = 0
+    encode_us: int = 0
+    _images: Dict[int, Optional[np.ndarray]] = field(default_factory=dict, init=False, repr=False, compare=False)
+    _decode_lock: threading.Lock = field(default_factory=threading.Lock, init=False, repr=False, compare=False)
+
+    def image(self, scale: int = 1) -> Optional[np.ndarray]:
+        """Returns the frame image, decoding the JPEG on first use.
+
+        Args:
+            scale (int): Scale denominator (1, 2, 4 or 8) of a JPEG frame, decoded directly at that
+                size. Frames without JPEG always return their full size data.
+
+        Returns:
+            Optional[np.ndarray]: Read-only image, None if the JPEG is invalid.
+        """
+        if self.jpeg is None or (scale == 1 and self.data is not None):
+            return self.data
+        with self._decode_lock:
+            if scale not in self._images:
+                self._images[scale] = decode_jpeg(self.jpeg, scale)
+            return self._images[scale]
+
+    def size(self) -> Optional[Tuple[int, int]]:
+        """Returns the full image size, read from the JPEG headers if not decoded.
+
+        Returns:
+            Optional[Tuple[int, int]]: Width and height (in pixels), None if unknown.
+        """
+        if self.data is not None:
+            return self.data.shape[1], self.data.shape[0]
+        return jpeg_size(self.jpeg) if self.jpeg is not None else None
 
 @dataclass(frozen=True)
 class FrameWithTelemetry:
@@ -77,9 +308,49 @@ class FrameWithTelemetry:
     Attributes:
         frame (Frame): Captured camera frame.
         telemetry (TelemetryData): Telemetry snapshot at capture time.
+        matched_us (int): Time the frame was matched, on the ground station monotonic clock (in microseconds, 0 if unknown).
     """
     frame: Frame
     telemetry: TelemetryData
+    matched_us: int = 0
+
+@dataclass(frozen=True)
+class DetectionTrace:
+    """Times the frame that confirmed a detected object went through the detection stages.
+
+    Times are on the ground station monotonic clock (in microseconds, 0 if unknown).
+
+    Attributes:
+        frame (Frame): Frame that confirmed the object, with its capture and receive times.
+        matched_us (int): Time the frame was matched with telemetry.
+        dequeued_us (int): Time a detection worker took the batch of the frame.
+        decoded_us (int): Time the images of the batch were decoded.
+        inferred_us (int): Time YOLO ran on the batch.
+        fired_us (int): Time the detection callback was called.
+        returned_us (int): Time the detection callback returned.
+    """
+    frame: Frame
+    matched_us: int
+    dequeued_us: int
+    decoded_us: int
+    inferred_us: int
+    fired_us: int
+    returned_us: int
+
+@dataclass(frozen=True)
+class SimulatedObject:
+    """Object drawn in a frame by the camera simulator, the ground truth of the frame.
+
+    Attributes:
+        center (Tuple[int, int]): Center (x, y) in pixels.
+        radius (int): Radius in pixels.
+        color (Tuple[int, int, int]): BGR color.
+        target (bool): Whether it has the target color.
+    """
+    center: Tuple[int, int]
+    radius: int
+    color: Tuple[int, int, int]
+    target: bool
 
 @dataclass(frozen=True)
 class Point2D:
@@ -0,0 +1,188 @@
+from configuration import clock_offset as config
+import threading
+from collections import deque
+from time import monotonic_ns
+from typing import Deque, Optional, Tuple
+
+from structures.structures import ClockEstimate
+
+
+def local_time_us() -> int:
+    """
+    Returns the local monotonic time used to compare remote timestamps.
+
+    Returns:
+        int: Local monotonic time (in microseconds).
+    """
+    return monotonic_ns() // 1000
+
+
+class ClockOffset:
+    """
+    Estimates the offset from a remote clock to the local monotonic clock.
+
+    Each message stamped by the remote clock gives the local receive time minus the
+    remote timestamp, that is the clock offset plus the transmission delay. The
+    estimate is the smallest of these, so it carries the shortest delay only. It is
+    raised slowly between messages to follow the drift between the clocks, and reset
+    when the remote clock jumps back.
+
+    Time exchanges, as in NTP, give a better estimate: the local send time, the remote
+    receive and send times and the local receive time of a request and its answer bound
+    the offset within half the round trip. Once exchanges are fed, the estimate comes
+    from the recent exchanges with the shortest round trips only, the others having
+    waited in a queue, as a line fitted through their offsets, whose slope is the drift
+    between the clocks. One-way messages then only detect remote clock resets.
+    """
+
+    def __init__(self) -> None:
+        """
+        Creates a ClockOffset instance without estimate.
+        """
+        self._offset_us: Optional[float] = None
+        self._last_local_us: int = 0
+        self._last_remote_us: int = 0
+
+        # (local time, offset, round trip) of the recent exchanges, in microseconds
+        self._exchanges: Deque[Tuple[int, float, int]] = deque(maxlen=config.CLOCK_SYNC_WINDOW)
+        self._ref_local_us: int = 0
+        self._drift: float = 0.0
+        self._error_us: float = -1.0
+
+        self._lock: threading.Lock = threading.Lock()
+
+    def update(self, remote_us: int, local_us: Optional[int] = None) -> None:
+        """
+        Updates the estimate with a received message.
+
+        Args:
+            remote_us (int): Remote timestamp of the message (in microseconds).
+            local_us (Optional[int]): Local receive time (in microseconds), now if None.
+        """
+        if local_us is None:
+            local_us = local_time_us()
+        with self._lock:
+            sample = local_us - remote_us
+            if remote_us < self._last_remote_us - config.CLOCK_OFFSET_RESET_US:
+                self._reset()
+            if self._offset_us is None:
+                self._offset_us = sample
+            elif not self._exchanges:
+                drift = (local_us - self._last_local_us) * config.CLOCK_OFFSET_DRIFT_US_PER_S / 1_000_000
+                self._offset_us = min(self._offset_us + drift, sample)
+            self._last_local_us = local_us
+            self._last_remote_us = remote_us
+
+    def update_exchange(self, local_send_us: int, remote_receive_us: int,
+                        remote_send_us: int, local_receive_us: int) -> None:
+        """
+        Updates the estimate with a time exchange.
+
+        Args:
+            local_send_us (int): Local time the request was sent (in microseconds).
+            remote_receive_us (int): Remote time the request was received (in microseconds).
+            remote_send_us (int): Remote time the answer was sent (in microseconds).
+            local_receive_us (int): Local time the answer was received (in microseconds).
+        """
+        round_trip = (local_receive_us - local_send_us) - (remote_send_us - remote_receive_us)
+        if round_trip < 0:
+            return
+        offset = ((local_send_us - remote_receive_us) + (local_receive_us - remote_send_us)) / 2
+        with self._lock:
+            if remote_send_us < self._last_remote_us - config.CLOCK_OFFSET_RESET_US:
+                self._reset()
+            self._last_local_us = max(self._last_local_us, local_receive_us)
+            self._last_remote_us = max(self._last_remote_us, remote_send_us)
+            self._exchanges.append(((local_send_us + local_receive_us) // 2, offset, round_trip))
+            self._fit()
+
+    def to_local(self, remote_us: int) -> Optional[int]:
+        """
+        Converts a remote time to local time.
+
+        Args:
+            remote_us (int): Remote time (in microseconds).
+
+        Returns:
+            Optional[int]: Local time (in microseconds), or None before the first message.
+        """
+        with self._lock:
+            if self._offset_us is None:
+                return None
+            return int(remote_us + self._offset_at(remote_us + self._offset_us))
+
+    def to_remote(self, local_us: int) -> Optional[int]:
+        """
+        Converts a local time to remote time.
+
+        Args:
+            local_us (int): Local time (in microseconds).
+
+        Returns:
+            Optional[int]: Remote time (in microseconds), or None before the first message.
+        """
+        with self._lock:
+            if self._offset_us is None:
+                return None
+            return int(local_us - self._offset_at(local_us))
+
+    def get_estimate(self) -> Optional[ClockEstimate]:
+        """
+        Returns the current offset, drift and error bound of the estimate.
+
+        Returns:
+            Optional[ClockEstimate]: Estimate, or None before the first message.
+        """
+        with self._lock:
+            if self._offset_us is None:
+                return None
+            synced = bool(self._exchanges)
+            return ClockEstimate(offset_us=self._offset_at(local_time_us()), drift_ppm=self._drift * 1e6,
+                                 error_us=self._error_us if synced else -1.0, synced=synced)
+
+    # ----------------------------------------------------------------------
+    # Private methods
+    # ----------------------------------------------------------------------
+    def _reset(self) -> None:
+        """Drops the estimate after a remote clock reset. The lock must be held."""
+        self._offset_us = None
+        self._exchanges.clear()
+        self._drift = 0.0
+        self._error_us = -1.0
+        self._last_remote_us = 0
+
+    def _offset_at(self, local_us: int) -> float:
+        """
+        Returns the offset at a local time. The lock must be held.
+
+        Args:
+            local_us (int): Local time (in microseconds).
+
+        Returns:
+            float: Offset (in microseconds).
+        """
+        if not self._exchanges:
+            return self._offset_us
+        return self._offset_us + self._drift * (local_us - self._ref_local_us)
+
+    def _fit(self) -> None:
+        """
+        Fits the offset and drift through the exchanges with the shortest round trips. The lock must be held.
+        """
+        best = sorted(self._exchanges, key=lambda exchange: exchange[2])[:config.CLOCK_SYNC_BEST]
+        count = len(best)
+        mean_t = sum(t for t, _, _ in best) / count
+        mean_offset = sum(offset for _, offset, _ in best) / count
+
+        drift = 0.0
+        span = max(t for t, _, _ in best) - min(t for t, _, _ in best)
+        if count >= 2 and span >= config.CLOCK_SYNC_MIN_DRIFT_SPAN_US:
+            variance = sum((t - mean_t) ** 2 for t, _, _ in best)
+            drift = sum((t - mean_t) * (offset - mean_offset) for t, offset, _ in best) / variance
+            limit = config.CLOCK_SYNC_MAX_DRIFT_PPM / 1e6
+            drift = max(-limit, min(limit, drift))
+
+        self._ref_local_us = int(mean_t)
+        self._offset_us = mean_offset
+        self._drift = drift
+        self._error_us = best[0][2] / 2
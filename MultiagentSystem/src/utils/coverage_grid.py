@@ -0,0 +1,75 @@
+import math
+from typing import Tuple
+
+import numpy as np
+
+
+class CoverageGrid:
+    """
+    Occupancy grid of the ground seen within a disk around the origin.
+
+    The disk is split into square cells of a fixed size. Seen areas are added as disks, and
+    only the cells of their bounding box are tested, so adding one costs the same whatever
+    the grid size. The covered fraction is kept up to date as cells are first seen.
+
+    It is not thread safe: callers must hold their own lock.
+    """
+
+    def __init__(self, radius: float, cell_size: float) -> None:
+        """
+        Creates a CoverageGrid instance with nothing seen.
+
+        Args:
+            radius (float): Radius (in meters) of the area to cover, around the origin.
+            cell_size (float): Cell side (in meters).
+        """
+        self._cell_size: float = cell_size
+        self._half: int = max(int(math.ceil(radius / cell_size)), 1)
+        self._centres: np.ndarray = (np.arange(-self._half, self._half) + 0.5) * cell_size
+        self._area: np.ndarray = self._centres[:, None] ** 2 + self._centres[None, :] ** 2 <= radius * radius
+        self._seen: np.ndarray = np.zeros_like(self._area)
+        self._area_cells: int = max(int(self._area.sum()), 1)
+        self._seen_cells: int = 0
+
+    def add_disk(self, x: float, y: float, radius: float) -> None:
+        """
+        Marks the cells whose centre lies within a disk as seen.
+
+        Args:
+            x (float): X coordinate of the disk centre (in meters).
+            y (float): Y coordinate of the disk centre (in meters).
+            radius (float): Disk radius (in meters).
+        """
+        i0, i1 = self._range(x, radius)
+        j0, j1 = self._range(y, radius)
+        if i0 >= i1 or j0 >= j1:
+            return
+
+        inside = (self._centres[i0:i1, None] - x) ** 2 + (self._centres[None, j0:j1] - y) ** 2 <= radius * radius
+        new = inside & self._area[i0:i1, j0:j1] & ~self._seen[i0:i1, j0:j1]
+        self._seen[i0:i1, j0:j1] |= new
+        self._seen_cells += int(new.sum())
+
+    def fraction(self) -> float:
+        """
+        Returns the fraction of the area seen.
+
+        Returns:
+            float: Seen cells over the cells of the area, from 0 to 1.
+        """
+        return self._seen_cells / self._area_cells
+
+    def _range(self, centre: float, radius: float) -> Tuple[int, int]:
+        """
+        Computes the index range of the cells a disk spans along one axis.
+
+        Args:
+            centre (float): Disk centre coordinate along the axis (in meters).
+            radius (float): Disk radius (in meters).
+
+        Returns:
+            Tuple[int, int]: First and past the last cell index, clipped to the grid.
+        """
+        first = int(math.floor((centre - radius) / self._cell_size)) + self._half
+        last = int(math.floor((centre + radius) / self._cell_size)) + self._half + 1
+        return max(first, 0), min(last, 2 * self._half)
@@ -0,0 +1,113 @@
+import threading
+from collections import deque
+from queue import Empty
+from time import monotonic
+from typing import Deque, Generic, Optional, TypeVar
+
+T = TypeVar("T")
+
+class FrameMailbox(Generic[T]):
+    """
+    Latest-value mailbox: a ring of a few items where a new item pushes out the oldest.
+
+    It is a drop-in replacement for the Queue of a frame consumer (put_nowait, get, get_nowait,
+    empty, full, qsize), except that put_nowait never raises Full. The items live in a deque bounded
+    to the capacity, whose append and popleft are atomic, so neither side takes a lock to pass
+    an item; an event only wakes the readers waiting on an empty mailbox. Items are passed by
+    reference, so the frames shared by several consumers are never copied.
+    """
+
+    def __init__(self, capacity: int = 1) -> None:
+        """
+        Creates an empty FrameMailbox instance.
+
+        Args:
+            capacity (int): Number of items kept, 1 to keep only the latest.
+        """
+        self._items: Deque[T] = deque(maxlen=capacity)
+        self._ready: threading.Event = threading.Event()
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    def put_nowait(self, item: T) -> None:
+        """
+        Adds an item, dropping the oldest one if the mailbox is full.
+
+        Args:
+            item (T): Item to add.
+        """
+        self._items.append(item)
+        self._ready.set()
+
+    def get_nowait(self) -> T:
+        """
+        Takes the oldest item without waiting.
+
+        Returns:
+            T: Oldest item.
+
+        Raises:
+            Empty: If the mailbox is empty.
+        """
+        try:
+            return self._items.popleft()
+        except IndexError:
+            raise Empty from None
+
+    def get(self, block: bool = True, timeout: Optional[float] = None) -> T:
+        """
+        Takes the oldest item, waiting for one if the mailbox is empty.
+
+        Args:
+            block (bool): Whether to wait for an item.
+            timeout (Optional[float]): Longest wait (in seconds), None to wait without limit.
+
+        Returns:
+            T: Oldest item.
+
+        Raises:
+            Empty: If no item arrived in time.
+        """
+        deadline = None if timeout is None else monotonic() + timeout
+        while True:
+            try:
+                return self._items.popleft()
+            except IndexError:
+                pass
+            if not block:
+                raise Empty
+            self._ready.clear()
+            if self._items:
+                continue
+            remaining = None if deadline is None else deadline - monotonic()
+            if remaining is not None and remaining <= 0:
+                raise Empty
+            self._ready.wait(remaining)
+
+    def empty(self) -> bool:
+        """
+        Tells whether the mailbox is empty.
+
+        Returns:
+            bool: True if it holds no item.
+        """
+        return not self._items
+
+    def full(self) -> bool:
+        """
+        Tells whether the mailbox is full, so that the next item pushes out the oldest.
+
+        Returns:
+            bool: True if it holds as many items as its capacity.
+        """
+        return len(self._items) == self._items.maxlen
+
+    def qsize(self) -> int:
+        """
+        Returns the number of items held.
+
+        Returns:
+            int: Number of items, at most the capacity.
+        """
+        return len(self._items)
@@ -0,0 +1,68 @@
+import cv2
+import numpy as np
+from typing import Optional, Tuple
+
+_REDUCED_FLAGS = {1: cv2.IMREAD_COLOR, 2: cv2.IMREAD_REDUCED_COLOR_2, 4: cv2.IMREAD_REDUCED_COLOR_4, 8: cv2.IMREAD_REDUCED_COLOR_8}
+"""OpenCV read flags of the scale denominators libjpeg can decode to directly."""
+
+_SOF_MARKERS = frozenset(range(0xC0, 0xD0)) - {0xC4, 0xC8, 0xCC}
+"""JPEG start of frame markers (DHT, JPG and DAC share the range but are not frames)."""
+
+JPEG_SCALES: Tuple[int, ...] = tuple(sorted(_REDUCED_FLAGS))
+"""Scale denominators a JPEG can be decoded to, without decoding it at full size."""
+
+def decode_jpeg(jpeg: bytes, scale: int = 1) -> Optional[np.ndarray]:
+    """
+    Decodes a JPEG to a BGR image, optionally reduced.
+
+    Reduced images are decoded by libjpeg with a scaled inverse DCT, so a quarter
+    size image costs a fraction of the full size decode and no resize.
+
+    Args:
+        jpeg (bytes): JPEG encoded image.
+        scale (int): Scale denominator, one of JPEG_SCALES.
+
+    Returns:
+        Optional[np.ndarray]: Read-only decoded image, or None if the JPEG is invalid.
+    """
+    data = cv2.imdecode(np.frombuffer(jpeg, dtype=np.uint8), _REDUCED_FLAGS[scale])
+    if data is not None:
+        data.flags.writeable = False
+    return data
+
+def jpeg_size(jpeg: bytes) -> Optional[Tuple[int, int]]:
+    """
+    Reads the image size from the JPEG headers, without decoding.
+
+    Args:
+        jpeg (bytes): JPEG encoded image.
+
+    Returns:
+        Optional[Tuple[int, int]]: Width and height (in pixels), or None if no frame header is found.
+    """
+    i = 2
+    while i + 9 <= len(jpeg):
+        if jpeg[i] != 0xFF:
+            return None
+        marker = jpeg[i + 1]
+        if marker in _SOF_MARKERS:
+            return int.from_bytes(jpeg[i + 7:i + 9], "big"), int.from_bytes(jpeg[i + 5:i + 7], "big")
+        if marker == 0xFF:
+            i += 1
+            continue
+        i += 2 + int.from_bytes(jpeg[i + 2:i + 4], "big")
+    return None
+
+def reduced_scale(size: Tuple[int, int], min_side: float) -> int:
+    """
+    Returns the largest JPEG scale denominator keeping the longer side of an image above a length.
+
+    Args:
+        size (Tuple[int, int]): Full image width and height (in pixels).
+        min_side (float): Shortest accepted length of the longer side (in pixels).
+
+    Returns:
+        int: Scale denominator, one of JPEG_SCALES (1 if even the full size is shorter).
+    """
+    longer = max(size)
+    return max((scale for scale in JPEG_SCALES if longer / scale >= min_side), default=1)
@@ -0,0 +1,373 @@
+from configuration import metrics as config
+import threading
+import logging
+from bisect import bisect_left
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from time import monotonic
+from typing import Callable, Dict, List, Optional, Tuple
+
+class _Histogram:
+    """Bucket counts, sum and count of the observations of a latency histogram."""
+
+    __slots__ = ("buckets", "sum", "count")
+
+    def __init__(self, n_buckets: int) -> None:
+        """
+        Creates an empty _Histogram instance.
+
+        Args:
+            n_buckets (int): Number of buckets, overflow bucket included.
+        """
+        self.buckets: List[int] = [0] * n_buckets
+        self.sum: float = 0.0
+        self.count: int = 0
+
+class MetricsRegistry:
+    """
+    Counters, latency histograms and gauges of the ground station frame pipeline.
+
+    Every series is a metric name with a stage label, such as frames_total{stage="matched"}.
+    Counters and histograms are updated from the pipeline threads under a single lock, held
+    for a few dictionary operations. Gauges are read through a callback when exported.
+
+    The metrics of the pipeline are:
+        - frames_total: frames captured by the camera, matched with telemetry, run through
+          the detector and displayed by the viewer.
+        - frames_dropped_total: frames lost by the camera stream and dropped from full consumer queues.
+        - frames_skipped_total: frames the consumers chose not to process.
+        - telemetry_packets_total: telemetry datagrams received.
+        - latency_seconds: capture to match, match to detection, and first detection of an
+          object to the end of its callback.
+        - queue_depth and telemetry_lost_packets gauges.
+    """
+
+    def __init__(self, buckets: Tuple[float, ...] = config.METRICS_LATENCY_BUCKETS) -> None:
+        """
+        Creates an empty MetricsRegistry instance.
+
+        Args:
+            buckets (Tuple[float, ...]): Upper bounds (in seconds) of the latency histogram buckets.
+        """
+        self._bounds: Tuple[float, ...] = tuple(buckets)
+        self._counters: Dict[Tuple[str, str], float] = {}
+        self._histograms: Dict[Tuple[str, str], _Histogram] = {}
+        self._gauges: Dict[Tuple[str, str], Callable[[], float]] = {}
+        self._lock: threading.Lock = threading.Lock()
+
+    # ---------------------------------------------------
+    # Public methods
+    # ---------------------------------------------------
+    def inc(self, name: str, stage: str, value: float = 1) -> None:
+        """
+        Adds to a counter.
+
+        Args:
+            name (str): Metric name.
+            stage (str): Stage label.
+            value (float): Amount to add.
+        """
+        key = (name, stage)
+        with self._lock:
+            self._counters[key] = self._counters.get(key, 0) + value
+
+    def observe(self, name: str, stage: str, seconds: float) -> None:
+        """
+        Records a latency in a histogram.
+
+        Args:
+            name (str): Metric name.
+            stage (str): Stage label.
+            seconds (float): Observed latency (in seconds).
+        """
+        key = (name, stage)
+        index = bisect_left(self._bounds, seconds)
+        with self._lock:
+            histogram = self._histograms.get(key)
+            if histogram is None:
+                histogram = self._histograms[key] = _Histogram(len(self._bounds) + 1)
+            histogram.buckets[index] += 1
+            histogram.sum += seconds
+            histogram.count += 1
+
+    def register_gauge(self, name: str, stage: str, read: Callable[[], float]) -> None:
+        """
+        Registers a gauge, replacing the gauge of the same name and stage if any.
+
+        Args:
+            name (str): Metric name.
+            stage (str): Stage label.
+            read (Callable[[], float]): Returns the current value.
+        """
+        with self._lock:
+            self._gauges[(name, stage)] = read
+
+    def snapshot(self) -> Tuple[Dict[Tuple[str, str], float], Dict[Tuple[str, str], List[int]], Dict[Tuple[str, str], float]]:
+        """
+        Copies the current values.
+
+        Returns:
+            Tuple: Counter values, histogram bucket counts and gauge values, by name and stage.
+        """
+        with self._lock:
+            counters = dict(self._counters)
+            histograms = {key: list(h.buckets) for key, h in self._histograms.items()}
+            gauges = dict(self._gauges)
+        return counters, histograms, {key: self._read_gauge(read) for key, read in gauges.items()}
+
+    def render(self) -> str:
+        """
+        Formats all the series in the Prometheus text exposition format.
+
+        Returns:
+            str: Metrics text.
+        """
+        with self._lock:
+            counters = sorted(self._counters.items())
+            histograms = sorted((key, list(h.buckets), h.sum, h.count) for key, h in self._histograms.items())
+            gauges = sorted(self._gauges.items())
+
+        lines: List[str] = []
+        typed = set()
+        def header(name: str, kind: str) -> str:
+            full = f"{config.METRICS_PREFIX}_{name}"
+            if full not in typed:
+                typed.add(full)
+                lines.append(f"# TYPE {full} {kind}")
+            return full
+
+        for (name, stage), value in counters:
+            lines.append(f'{header(name, "counter")}{{stage="{stage}"}} {value:g}')
+        for (name, stage), buckets, total, count in histograms:
+            full = header(name, "histogram")
+            cumulative = 0
+            for bound, n in zip(self._bounds + (float("inf"),), buckets):
+                cumulative += n
+                le = "+Inf" if bound == float("inf") else f"{bound:g}"
+                lines.append(f'{full}_bucket{{stage="{stage}",le="{le}"}} {cumulative}')
+            lines.append(f'{full}_sum{{stage="{stage}"}} {total:g}')
+            lines.append(f'{full}_count{{stage="{stage}"}} {count}')
+        for (name, stage), read in gauges:
+            value = self._read_gauge(read)
+            if value is not None:
+                lines.append(f'{header(name, "gauge")}{{stage="{stage}"}} {value:g}')
+        return "\n".join(lines) + "\n"
+
+    def quantile(self, buckets: List[int], q: float) -> Optional[float]:
+        """
+        Estimates a quantile from histogram bucket counts, as the upper bound of its bucket.
+
+        Args:
+            buckets (List[int]): Bucket counts.
+            q (float): Quantile, from 0 to 1.
+
+        Returns:
+            Optional[float]: Quantile estimate (in seconds, infinite in the overflow bucket), None without observations.
+        """
+        total = sum(buckets)
+        if total == 0:
+            return None
+        rank = q * total
+        cumulative = 0
+        for bound, n in zip(self._bounds + (float("inf"),), buckets):
+            cumulative += n
+            if cumulative >= rank:
+                return bound
+        return float("inf")
+
+    # ---------------------------------------------------
+    # Private methods
+    # ---------------------------------------------------
+    @staticmethod
+    def _read_gauge(read: Callable[[], float]) -> Optional[float]:
+        """
+        Reads a gauge, ignoring failures.
+
+        Args:
+            read (Callable[[], float]): Gauge callback.
+
+        Returns:
+            Optional[float]: Gauge value, None if the callback failed.
+        """
+        try:
+            return float(read())
+        except Exception:
+            return None
+
+class MetricsReporter:
+    """
+    Periodic log line and Prometheus endpoint of a MetricsRegistry.
+
+    Every METRICS_LOG_PERIOD, the log line gives the rate of each counter over the period, the
+    gauges, and the median and 95th percentile of each latency over the period. The endpoint
+    serves the registry on http://<host>:METRICS_HTTP_PORT/metrics.
+    """
+
+    def __init__(self, registry: Optional[MetricsRegistry] = None, port: int = config.METRICS_HTTP_PORT) -> None:
+        """
+        Creates a MetricsReporter instance.
+
+        Args:
+            registry (Optional[MetricsRegistry]): Registry to report, the shared one if None.
+            port (int): HTTP port of the endpoint, 0 to disable it.
+        """
+        self._registry: MetricsRegistry = registry or get_registry()
+        self._port: int = port
+
+        self._server: Optional[ThreadingHTTPServer] = None
+        self._running: bool = False
+        self._stop_event: threading.Event = threading.Event()
+        self._thread: Optional[threading.Thread] = None
+
+        self._logger: logging.Logger = logging.getLogger("Metrics")
+
+    # ---------------------------------------------------
+    # Public methods
+    # ---------------------------------------------------
+    def start(self) -> None:
+        """
+        Starts the log thread and the HTTP endpoint.
+        """
+        if self._running:
+            self._logger.warning("Already running.")
+            return
+
+        self._running = True
+        self._stop_event.clear()
+        self._thread = threading.Thread(target=self._log_loop, daemon=True)
+        self._thread.start()
+
+        if self._port:
+            registry = self._registry
+            class Handler(BaseHTTPRequestHandler):
+                def do_GET(self) -> None:
+                    if self.path.split("?")[0] != "/metrics":
+                        self.send_error(404)
+                        return
+                    body = registry.render().encode("utf-8")
+                    self.send_response(200)
+                    self.send_header("Content-Type", "text/plain; version=0.0.4")
+                    self.send_header("Content-Length", str(len(body)))
+                    self.end_headers()
+                    self.wfile.write(body)
+
+                def log_message(self, format: str, *args) -> None:
+                    pass
+
+            try:
+                self._server = ThreadingHTTPServer(("", self._port), Handler)
+                self._server.daemon_threads = True
+                threading.Thread(target=self._server.serve_forever, daemon=True).start()
+                self._logger.info("Serving metrics on port %d.", self._port)
+            except OSError as e:
+                self._logger.warning("Could not serve metrics on port %d: %s", self._port, e)
+                self._server = None
+        self._logger.info("Started.")
+
+    def stop(self) -> None:
+        """
+        Stops the log thread and the HTTP endpoint.
+        """
+        if not self._running:
+            self._logger.warning("Already stopped.")
+            return
+
+        self._running = False
+        self._stop_event.set()
+        if self._server:
+            self._server.shutdown()
+            self._server.server_close()
+            self._server = None
+        if self._thread:
+            self._thread.join(timeout=1.0)
+            self._thread = None
+        self._logger.info("Stopped.")
+
+    # ---------------------------------------------------
+    # Private methods
+    # ---------------------------------------------------
+    def _log_loop(self) -> None:
+        """
+        Background thread logging the metrics summary every METRICS_LOG_PERIOD.
+        """
+        previous = self._registry.snapshot()
+        previous_time = monotonic()
+        while not self._stop_event.wait(config.METRICS_LOG_PERIOD):
+            current = self._registry.snapshot()
+            now = monotonic()
+            line = self._summary(previous, current, now - previous_time)
+            if line:
+                self._logger.info(line)
+            previous, previous_time = current, now
+
+    def _summary(self, previous: tuple, current: tuple, elapsed: float) -> str:
+        """
+        Formats the metrics of a period.
+
+        Args:
+            previous (tuple): Snapshot at the start of the period.
+            current (tuple): Snapshot at the end of the period.
+            elapsed (float): Duration of the period (in seconds).
+
+        Returns:
+            str: Rates, gauges and latencies of the period, empty if nothing was recorded.
+        """
+        counters, histograms, gauges = current
+        parts = []
+        for (name, stage), value in sorted(counters.items()):
+            rate = (value - previous[0].get((name, stage), 0)) / elapsed
+            parts.append(f"{name}[{stage}] {rate:.1f}/s")
+        for (name, stage), value in sorted(gauges.items()):
+            if value is not None:
+                parts.append(f"{name}[{stage}] {value:g}")
+        for (name, stage), buckets in sorted(histograms.items()):
+            old = previous[1].get((name, stage), [0] * len(buckets))
+            period = [n - o for n, o in zip(buckets, old)]
+            p50 = self._registry.quantile(period, 0.5)
+            p95 = self._registry.quantile(period, 0.95)
+            if p50 is not None:
+                parts.append(f"{name}[{stage}] p50<={p50 * 1000:g}ms p95<={p95 * 1000:g}ms")
+        return ", ".join(parts)
+
+_registry: MetricsRegistry = MetricsRegistry()
+
+def get_registry() -> MetricsRegistry:
+    """
+    Returns the registry shared by the pipeline.
+
+    Returns:
+        MetricsRegistry: Shared registry.
+    """
+    return _registry
+
+def inc(name: str, stage: str, value: float = 1) -> None:
+    """
+    Adds to a counter of the shared registry.
+
+    Args:
+        name (str): Metric name.
+        stage (str): Stage label.
+        value (float): Amount to add.
+    """
+    _registry.inc(name, stage, value)
+
+def observe(name: str, stage: str, seconds: float) -> None:
+    """
+    Records a latency in a histogram of the shared registry.
+
+    Args:
+        name (str): Metric name.
+        stage (str): Stage label.
+        seconds (float): Observed latency (in seconds).
+    """
+    _registry.observe(name, stage, seconds)
+
+def register_gauge(name: str, stage: str, read: Callable[[], float]) -> None:
+    """
+    Registers a gauge in the shared registry.
+
+    Args:
+        name (str): Metric name.
+        stage (str): Stage label.
+        read (Callable[[], float]): Returns the current value.
+    """
+    _registry.register_gauge(name, stage, read)
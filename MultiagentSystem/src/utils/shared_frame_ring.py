@@ -0,0 +1,103 @@
+import struct
+from multiprocessing import shared_memory
+from typing import Optional
+
+class SharedFrameRing:
+    """
+    Ring of frame slots in shared memory, written by one process and read by others.
+
+    Each frame written takes the next slot, numbered by an increasing sequence number, and
+    overwrites the frame written slots frames earlier. The frame bytes never go through a pipe:
+    the writer copies them once into the slot and the reader once out of it, and only the sequence
+    number is passed between the processes.
+
+    Each slot starts with a header holding its sequence number and payload length. The writer
+    marks the slot as busy while it copies, then publishes the new sequence number; the reader
+    checks the sequence number before and after its copy, so a frame overwritten during the
+    read is reported as lost rather than returned torn.
+    """
+
+    _HEADER = struct.Struct("<qI4x")
+    _BUSY = -1
+
+    def __init__(self, slots: int, slot_size: int, name: Optional[str] = None) -> None:
+        """
+        Creates a SharedFrameRing instance, allocating the shared memory or attaching to it.
+
+        Args:
+            slots (int): Number of slots.
+            slot_size (int): Largest frame (in bytes) a slot holds.
+            name (Optional[str]): Name of the shared memory of an existing ring to attach to, None to create one.
+        """
+        self._slots: int = slots
+        self._slot_size: int = slot_size
+        self._stride: int = self._HEADER.size + slot_size
+        self._owner: bool = name is None
+        self._shm: shared_memory.SharedMemory = shared_memory.SharedMemory(
+            name=name, create=self._owner, size=slots * self._stride if self._owner else 0)
+        self._buffer: memoryview = self._shm.buf
+        self._next_seq: int = 0
+        if self._owner:
+            for slot in range(slots):
+                self._HEADER.pack_into(self._buffer, slot * self._stride, self._BUSY, 0)
+
+    # ----------------------------------------------------------------------
+    # Public methods
+    # ----------------------------------------------------------------------
+    @property
+    def name(self) -> str:
+        """Name of the shared memory, to attach to the ring from another process."""
+        return self._shm.name
+
+    def write(self, payload: bytes) -> Optional[int]:
+        """
+        Copies a frame into the next slot.
+
+        Only the process that created the ring writes to it.
+
+        Args:
+            payload (bytes): Frame bytes.
+
+        Returns:
+            Optional[int]: Sequence number of the frame, None if it does not fit in a slot.
+        """
+        length = len(payload)
+        if length > self._slot_size:
+            return None
+        seq = self._next_seq
+        self._next_seq += 1
+        offset = (seq % self._slots) * self._stride
+        self._HEADER.pack_into(self._buffer, offset, self._BUSY, 0)
+        start = offset + self._HEADER.size
+        self._buffer[start:start + length] = payload
+        self._HEADER.pack_into(self._buffer, offset, seq, length)
+        return seq
+
+    def read(self, seq: int) -> Optional[bytes]:
+        """
+        Copies a frame out of its slot.
+
+        Args:
+            seq (int): Sequence number of the frame.
+
+        Returns:
+            Optional[bytes]: Frame bytes, None if the frame was overwritten.
+        """
+        offset = (seq % self._slots) * self._stride
+        slot_seq, length = self._HEADER.unpack_from(self._buffer, offset)
+        if slot_seq != seq:
+            return None
+        start = offset + self._HEADER.size
+        payload = bytes(self._buffer[start:start + length])
+        if self._HEADER.unpack_from(self._buffer, offset)[0] != seq:
+            return None
+        return payload
+
+    def close(self) -> None:
+        """
+        Detaches from the shared memory, and frees it if this process created the ring.
+        """
+        self._buffer.release()
+        self._shm.close()
+        if self._owner:
+            self._shm.unlink()
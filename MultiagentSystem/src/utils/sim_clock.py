@@ -0,0 +1,170 @@
+import heapq
+import threading
+import time
+from typing import List, Tuple
+
+from configuration import simulation as config
+
+
+class SimulationClock:
+    """
+    Wall clock of the simulation, running SIMULATION_SPEED times faster than the real time.
+
+    The simulators and the controllers read the time and sleep through the process clock
+    (see now() and sleep()), so a whole operation can be run faster than in real time.
+    A speed of 1 gives the real time.
+    """
+
+    def __init__(self, speed: float = 1.0) -> None:
+        """
+        Creates a SimulationClock instance starting at the current real time.
+
+        Args:
+            speed (float): Number of simulated seconds per real second.
+        """
+        self._speed: float = speed
+        self._origin_wall: float = time.time()
+        self._origin: float = time.monotonic()
+
+    def get_speed(self) -> float:
+        """
+        Returns the number of simulated seconds per real second.
+
+        Returns:
+            float: Clock speed.
+        """
+        return self._speed
+
+    def now(self) -> float:
+        """
+        Returns the simulated wall time.
+
+        Returns:
+            float: Simulated time (in seconds since the epoch).
+        """
+        return self._origin_wall + (time.monotonic() - self._origin) * self._speed
+
+    def sleep(self, seconds: float) -> None:
+        """
+        Blocks the calling thread for a simulated duration.
+
+        Args:
+            seconds (float): Simulated duration (in seconds).
+        """
+        if seconds > 0:
+            time.sleep(seconds / self._speed)
+
+
+class DiscreteEventClock(SimulationClock):
+    """
+    Virtual clock that jumps to the next wake-up time instead of waiting for it.
+
+    The sleeping threads register their wake-up times. Once no thread has slept or woken up for
+    SIMULATION_SETTLE_TIME of real time, that is when every simulated agent is waiting, the clock jumps
+    to the earliest wake-up time and wakes up the threads due, so the simulation runs as fast as
+    the computations allow. The computations themselves take no simulated time.
+    """
+
+    def __init__(self, settle_time: float = config.SIMULATION_SETTLE_TIME) -> None:
+        """
+        Creates a DiscreteEventClock instance starting at the current real time, and starts its driver thread.
+
+        Args:
+            settle_time (float): Real time (in seconds) without clock activity after which the clock jumps.
+        """
+        super().__init__(speed=float("inf"))
+        self._settle_time: float = settle_time
+        self._now: float = time.time()
+        self._wakeups: List[Tuple[float, int]] = []
+        self._seq: int = 0
+        self._activity: int = 0
+        self._cond: threading.Condition = threading.Condition()
+        self._driver: threading.Thread = threading.Thread(target=self._drive, daemon=True)
+        self._driver.start()
+
+    def now(self) -> float:
+        """
+        Returns the virtual wall time.
+
+        Returns:
+            float: Virtual time (in seconds since the epoch).
+        """
+        with self._cond:
+            return self._now
+
+    def sleep(self, seconds: float) -> None:
+        """
+        Blocks the calling thread until the virtual time reaches its wake-up time.
+
+        Args:
+            seconds (float): Virtual duration (in seconds).
+        """
+        with self._cond:
+            deadline = self._now + max(seconds, 0.0)
+            self._seq += 1
+            heapq.heappush(self._wakeups, (deadline, self._seq))
+            self._activity += 1
+            self._cond.notify_all()
+            while self._now < deadline:
+                self._cond.wait()
+            self._activity += 1
+
+    def _drive(self) -> None:
+        """
+        Driver thread: moves the virtual time to the earliest wake-up time once the clock is idle.
+        """
+        with self._cond:
+            while True:
+                activity = self._activity
+                self._cond.wait(self._settle_time)
+                if self._activity != activity or not self._wakeups:
+                    continue
+                self._now = max(self._now, self._wakeups[0][0])
+                while self._wakeups and self._wakeups[0][0] <= self._now:
+                    heapq.heappop(self._wakeups)
+                self._activity += 1
+                self._cond.notify_all()
+
+
+_clock: SimulationClock = SimulationClock()
+
+
+def set_clock(clock: SimulationClock) -> None:
+    """
+    Replaces the process clock. It must be called before the simulators and controllers start.
+
+    Args:
+        clock (SimulationClock): New process clock.
+    """
+    global _clock
+    _clock = clock
+
+
+def get_clock() -> SimulationClock:
+    """
+    Returns the process clock.
+
+    Returns:
+        SimulationClock: Process clock.
+    """
+    return _clock
+
+
+def now() -> float:
+    """
+    Returns the wall time of the process clock.
+
+    Returns:
+        float: Time (in seconds since the epoch).
+    """
+    return _clock.now()
+
+
+def sleep(seconds: float) -> None:
+    """
+    Blocks the calling thread for a duration of the process clock.
+
+    Args:
+        seconds (float): Duration (in seconds).
+    """
+    _clock.sleep(seconds)
@@ -0,0 +1,87 @@
+import math
+from typing import Dict, Iterable, List, Optional, Tuple
+
+from structures.structures import Point2D
+
+
+class SpatialGrid:
+    """
+    Uniform grid index of 2D points for near-neighbour queries.
+
+    The plane is split into square cells of a fixed size, and each point is stored in
+    the cell it falls into. A query within a radius up to the cell size only looks at
+    the 3x3 cells around the query point, so it takes constant time on average
+    whatever the number of points.
+
+    It is not thread safe: callers must hold their own lock.
+    """
+
+    def __init__(self, cell_size: float, points: Optional[Iterable[Point2D]] = None) -> None:
+        """
+        Creates a SpatialGrid instance.
+
+        Args:
+            cell_size (float): Cell side (in meters), the largest radius of the queries.
+            points (Optional[Iterable[Point2D]]): Points to add, if any.
+        """
+        self._cell_size: float = cell_size
+        self._cells: Dict[Tuple[int, int], List[Point2D]] = {}
+        self._count: int = 0
+        for point in points or ():
+            self.add(point)
+
+    def __len__(self) -> int:
+        return self._count
+
+    def add(self, point: Point2D) -> None:
+        """
+        Adds a point to the grid.
+
+        Args:
+            point (Point2D): Point to add.
+        """
+        self._cells.setdefault(self._cell(point.x, point.y), []).append(point)
+        self._count += 1
+
+    def clear(self) -> None:
+        """Removes all the points."""
+        self._cells.clear()
+        self._count = 0
+
+    def nearest_within(self, x: float, y: float, radius: float) -> Optional[Point2D]:
+        """
+        Finds the closest point strictly within a radius.
+
+        Args:
+            x (float): X coordinate of the query point.
+            y (float): Y coordinate of the query point.
+            radius (float): Search radius (in meters), at most the cell size.
+
+        Returns:
+            Optional[Point2D]: The closest point closer than radius, or None if there is none.
+        """
+        if radius > self._cell_size:
+            raise ValueError("Search radius larger than the grid cell size.")
+
+        cx, cy = self._cell(x, y)
+        best, best_dist = None, radius
+        for i in (cx - 1, cx, cx + 1):
+            for j in (cy - 1, cy, cy + 1):
+                for point in self._cells.get((i, j), ()):
+                    dist = math.hypot(point.x - x, point.y - y)
+                    if dist < best_dist:
+                        best, best_dist = point, dist
+        return best
+
+    def _cell(self, x: float, y: float) -> Tuple[int, int]:
+        """
+        Computes the cell of a position.
+
+        Args:
+            x (float): X coordinate.
+            y (float): Y coordinate.
+
+        Returns:
+            Tuple[int, int]: Cell indices.
+        """
+        return math.floor(x / self._cell_size), math.floor(y / self._cell_size)
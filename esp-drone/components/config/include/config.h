@@ -82,8 +82,10 @@
 // Task priorities. Higher number higher priority
 // system state tasks
 #define SYSTEM_TASK_PRI         1
+#define CONSOLE_TASK_PRI        1
 #define PM_TASK_PRI             1
 #define LEDSEQCMD_TASK_PRI      1
+#define DYN_NOTCH_TASK_PRI      1
 // communication TX tasks
 #define UDP_TX_TASK_PRI         2
 #define CRTP_TX_TASK_PRI        2
@@ -93,9 +95,10 @@
 #define UART2_TASK_PRI          2
 #define SYSLINK_TASK_PRI        2
 #define USBLINK_TASK_PRI        2
-#define WIFILINK_TASK_PRI       2
+#define WIFI_START_TASK_PRI     2
 #define CRTP_RX_TASK_PRI        2
 #define CMD_HIGH_LEVEL_TASK_PRI 3
+#define LOG_SCHED_TASK_PRI      3
 #define INFO_TASK_PRI           2
 #define LOG_TASK_PRI            2
 #define MEM_TASK_PRI            2
@@ -106,8 +109,13 @@
 #define ZRANGER2_TASK_PRI       5
 #define ZRANGER_TASK_PRI        5
 #define SENSORS_TASK_PRI        6
+#define I2C_TASK_PRI            6
 #define STABILIZER_TASK_PRI     7
 #define KALMAN_TASK_PRI         4
+// telemetry and camera tasks
+#define TELEMETRY_TASK_PRI      1
+#define CAMERA_TASK_PRI         5
+#define THERMAL_TASK_PRI        1
 
 // the kalman filter consumes a lot of CPU
 // for single core systems, we need to lower the priority
@@ -117,40 +125,53 @@
 #endif
 
 // Task names
+#define BATTERY_MONITOR_TASK_NAME  "BATTERY_MONITOR"
+#define CAMERA_TASK_NAME           "cameraTask"
 #define CMD_HIGH_LEVEL_TASK_NAME "CMDHL"
+#define CONSOLE_TASK_NAME       "CONSOLE"
 #define CRTP_RX_TASK_NAME       "CRTP-RX"
 #define CRTP_TX_TASK_NAME       "CRTP-TX"
+#define DYN_NOTCH_TASK_NAME     "DYNNOTCH"
 #define EXTRX_TASK_NAME         "EXTRX"
 #define FLOW_TASK_NAME          "FLOW"
+#define I2C_TASK_NAME           "I2C"
 #define KALMAN_TASK_NAME        "KALMAN"
 #define LEDSEQCMD_TASK_NAME     "LEDSEQCMD"
 #define LOG_TASK_NAME           "LOG"
+#define LOG_SCHED_TASK_NAME     "LOGSCHED"
 #define MEM_TASK_NAME           "MEM"
 #define PARAM_TASK_NAME         "PARAM"
 #define PM_TASK_NAME            "PWRMGNT"
+#define POSITION_MONITOR_TASK_NAME "POSITION_MONITOR"
 #define PROXIMITY_TASK_NAME     "PROXIMITY"
 #define SENSORS_TASK_NAME       "SENSORS"
 #define STABILIZER_TASK_NAME    "STABILIZER"
 #define SYSLINK_TASK_NAME       "SYSLINK"
 #define SYSTEM_TASK_NAME        "SYSTEM"
+#define THERMAL_TASK_NAME       "THERMAL"
 #define UART2_TASK_NAME         "UART2"
 #define UDP_RX_TASK_NAME        "UDP_RX"
 #define UDP_TX_TASK_NAME        "UDP_TX"
 #define USBLINK_TASK_NAME       "USBLINK"
-#define WIFILINK_TASK_NAME      "WIFILINK"
+#define WIFI_START_TASK_NAME    "WIFI_START"
 #define ZRANGER2_TASK_NAME      "ZRANGER2"
 #define ZRANGER_TASK_NAME       "ZRANGER"
 
 //Task stack sizes
 #define configBASE_STACK_SIZE CONFIG_BASE_STACK_SIZE
+#define CAMERA_TASK_STACKSIZE         4096
 #define CMD_HIGH_LEVEL_TASK_STACKSIZE (2 * configBASE_STACK_SIZE)
+#define CONSOLE_TASK_STACKSIZE        (2 * configBASE_STACK_SIZE)
 #define CRTP_RX_TASK_STACKSIZE        (3 * configBASE_STACK_SIZE)
 #define CRTP_TX_TASK_STACKSIZE        (3 * configBASE_STACK_SIZE)
+#define DYN_NOTCH_TASK_STACKSIZE      (2 * configBASE_STACK_SIZE)
 #define EXTRX_TASK_STACKSIZE          (1 * configBASE_STACK_SIZE)
 #define FLOW_TASK_STACKSIZE           (3 * configBASE_STACK_SIZE)
+#define I2C_TASK_STACKSIZE            (2 * configBASE_STACK_SIZE)
 #define KALMAN_TASK_STACKSIZE         (3 * configBASE_STACK_SIZE)
 #define LEDSEQCMD_TASK_STACKSIZE      (2 * configBASE_STACK_SIZE)
 #define LOG_TASK_STACKSIZE            (3 * configBASE_STACK_SIZE)
+#define LOG_SCHED_TASK_STACKSIZE      (3 * configBASE_STACK_SIZE)
 #define MEM_TASK_STACKSIZE            (2 * configBASE_STACK_SIZE)
 #define PARAM_TASK_STACKSIZE          (2 * configBASE_STACK_SIZE)
 #define PM_TASK_STACKSIZE             (4 * configBASE_STACK_SIZE)
@@ -158,14 +179,56 @@
 #define STABILIZER_TASK_STACKSIZE     (5 * configBASE_STACK_SIZE)
 #define SYSLINK_TASK_STACKSIZE        (1 * configBASE_STACK_SIZE)
 #define SYSTEM_TASK_STACKSIZE         (6 * configBASE_STACK_SIZE)
+#define TELEMETRY_TASK_STACKSIZE      4096
+#define THERMAL_TASK_STACKSIZE        (3 * configBASE_STACK_SIZE)
 #define UART2_TASK_STACKSIZE          (1 * configBASE_STACK_SIZE)
 #define UDP_RX_TASK_STACKSIZE         (4 * configBASE_STACK_SIZE)
 #define UDP_TX_TASK_STACKSIZE         (4 * configBASE_STACK_SIZE)
 #define USBLINK_TASK_STACKSIZE        (1 * configBASE_STACK_SIZE)
-#define WIFILINK_TASK_STACKSIZE       (4 * configBASE_STACK_SIZE)
+#define WIFI_START_TASK_STACKSIZE     (6 * configBASE_STACK_SIZE)
 #define ZRANGER2_TASK_STACKSIZE       (4 * configBASE_STACK_SIZE)
 #define ZRANGER_TASK_STACKSIZE        (2 * configBASE_STACK_SIZE)
 
+// Task cores. On dual core targets the flight tasks, from the sensors to the
+// motors, run on a core of their own; the link, CRTP services, telemetry and
+// camera tasks run on the other one, with the Wi-Fi driver and lwIP.
+// TASK_CORE_ANY leaves a task to the scheduler.
+#define TASK_CORE_ANY             tskNO_AFFINITY
+#if defined(CONFIG_TASK_PINNING) && !CONFIG_FREERTOS_UNICORE
+  #define FLIGHT_TASK_CORE        CONFIG_FLIGHT_TASK_CORE
+  #define NETWORK_TASK_CORE       (1 - CONFIG_FLIGHT_TASK_CORE)
+#else
+  #define FLIGHT_TASK_CORE        TASK_CORE_ANY
+  #define NETWORK_TASK_CORE       TASK_CORE_ANY
+#endif
+#define APP_TASK_CORE             TASK_CORE_ANY
+#define BATTERY_MONITOR_TASK_CORE NETWORK_TASK_CORE
+#define CAMERA_TASK_CORE          NETWORK_TASK_CORE
+#define CMD_HIGH_LEVEL_TASK_CORE  FLIGHT_TASK_CORE
+#define CONSOLE_TASK_CORE         NETWORK_TASK_CORE
+#define CRTP_RX_TASK_CORE         NETWORK_TASK_CORE
+#define CRTP_TX_TASK_CORE         NETWORK_TASK_CORE
+#define DYN_NOTCH_TASK_CORE       FLIGHT_TASK_CORE
+#define FLOW_TASK_CORE            FLIGHT_TASK_CORE
+#define I2C_TASK_CORE             FLIGHT_TASK_CORE
+#define KALMAN_TASK_CORE          FLIGHT_TASK_CORE
+#define LEDSEQCMD_TASK_CORE       TASK_CORE_ANY
+#define LOG_TASK_CORE             NETWORK_TASK_CORE
+#define LOG_SCHED_TASK_CORE       NETWORK_TASK_CORE
+#define MEM_TASK_CORE             NETWORK_TASK_CORE
+#define PARAM_TASK_CORE           NETWORK_TASK_CORE
+#define PM_TASK_CORE              TASK_CORE_ANY
+#define POSITION_MONITOR_TASK_CORE NETWORK_TASK_CORE
+#define SENSORS_TASK_CORE         FLIGHT_TASK_CORE
+#define STABILIZER_TASK_CORE      FLIGHT_TASK_CORE
+#define SYSTEM_TASK_CORE          TASK_CORE_ANY
+#define THERMAL_TASK_CORE         NETWORK_TASK_CORE
+#define UDP_RX_TASK_CORE          NETWORK_TASK_CORE
+#define UDP_TX_TASK_CORE          NETWORK_TASK_CORE
+#define WIFI_START_TASK_CORE      NETWORK_TASK_CORE
+#define ZRANGER2_TASK_CORE        FLIGHT_TASK_CORE
+#define ZRANGER_TASK_CORE         FLIGHT_TASK_CORE
+
 //The radio channel. From 0 to 125
 #define RADIO_RATE_2M 2
 #define RADIO_CHANNEL 80
@@ -5,6 +5,8 @@
 #include "driver/ledc.h"
 #include "driver/i2c.h"
 #include "driver/gpio.h"
+#include "config.h"
+#include "static_mem.h"
 
 static const char* TAG = "DRONE_CAMERA";
 
@@ -29,7 +31,6 @@ static const char* TAG = "DRONE_CAMERA";
 #define CAM_PIN_PCLK    20
 
 #define CAMERA_TASK_DELAY_MS 1000
-#define CAMERA_STACK 4096
 
 static camera_config_t camera_config = {
     .pin_pwdn  = CAM_PIN_PWDN,
@@ -118,9 +119,11 @@ static void cameraTask(void *arg)
     }
 }
 
+STATIC_MEM_TASK_ALLOC(cameraTask, CAMERA_TASK_STACKSIZE);
+
 void startCapturingCamera(void)
 {
     if (camera_init() == ESP_OK) {
-        xTaskCreate(cameraTask, "cameraTask", CAMERA_STACK, NULL, 5, NULL);
+        STATIC_MEM_TASK_CREATE_PINNED(cameraTask, cameraTask, CAMERA_TASK_NAME, NULL, CAMERA_TASK_PRI, CAMERA_TASK_CORE);
     }
 }
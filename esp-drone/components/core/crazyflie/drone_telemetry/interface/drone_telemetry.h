@@ -1,6 +1,8 @@
 #pragma once
 
 #include <stdint.h>
+#include "stabilizer_types.h"
+#include "thermal_hotspot.h"
 
 /**
  * @brief Starts the battery monitoring task.
@@ -16,3 +18,30 @@ void startPositionMonitor(void);
  * @brief Starts all monitoring tasks (battery + position).
  */
 void startTelemetry(void);
+
+
+/**
+ * @brief Publishes the latest estimated pose to the position monitor.
+ *
+ * Called from the stabilizer loop after every estimator update. Samples are
+ * decimated to CONFIG_TELEMETRY_POSE_RATE_HZ and overwrite the previous one,
+ * so the stabilizer never blocks. Does nothing until telemetry is started.
+ *
+ * @param state Current estimated state.
+ * @param tick  Stabilizer loop tick.
+ */
+void telemetryPublishPose(const state_t *state, uint32_t tick);
+
+/**
+ * @brief Sends the hotspots of a thermal frame with the current pose.
+ *
+ * Called by the thermal hotspot task for every frame that has hotspots.
+ * Never blocks, the event is dropped when the WiFi link is saturated.
+ *
+ * @param hotspots   Hotspots, hottest first.
+ * @param count      Number of hotspots, up to THERMAL_HOTSPOT_MAX.
+ * @param background Median pixel of the frame (0.25 degrees Celsius).
+ * @param timestamp  Frame read time (us since boot).
+ */
+void telemetrySendHotspots(const ThermalHotspot *hotspots, uint8_t count,
+                           int16_t background, uint64_t timestamp);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+// Most hotspots reported per thermal frame, the hottest ones are kept
+#define THERMAL_HOTSPOT_MAX         8
+
+// Hotspot: connected group of AMG8833 pixels above the detection threshold
+typedef struct __attribute__((packed)) {
+    uint8_t x;               // Column of the centroid (1/16 pixel)
+    uint8_t y;               // Row of the centroid (1/16 pixel)
+    uint8_t pixels;          // Number of pixels
+    int16_t peak;            // Hottest pixel (0.25 degrees Celsius)
+} ThermalHotspot;
+
+/**
+ * @brief Starts the thermal hotspot detection task.
+ *
+ * Reads the AMG8833 on the deck I2C bus at its 10 Hz frame rate, and sends
+ * the hotspots of every frame that has some with telemetrySendHotspots.
+ */
+void startThermalHotspots(void);
@@ -1,13 +1,27 @@
 // Include necessary headers
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include "motors.h"
 #include "pm_esplane.h"
 #include "stabilizer.h"
+#include "stabilizer_types.h"
+#include "sysload.h"
+#include "queuemonitor.h"
+#include "static_mem.h"
+#include "esp_system.h"
 #include "wifi_esp32.h"
+#include "usec_time.h"
+#include "config.h"
+#include "param.h"
+#include "log.h"
 #include "drone_telemetry.h"
+#ifdef CONFIG_TELEMETRY_ESPNOW_POSE
+#include "esp_now.h"
+#endif
 
 //======================================================================
 //                                CONSTANTS
@@ -16,84 +30,468 @@
 #define BATTERY_MONITOR_DELAY_MS    1000
 #define POSITION_MONITOR_DELAY_MS   500
 
+// Pose publishing rate from the stabilizer loop (in Hz)
+#ifdef CONFIG_TELEMETRY_POSE_RATE_HZ
+#define POSE_TELEMETRY_RATE_HZ      CONFIG_TELEMETRY_POSE_RATE_HZ
+#else
+#define POSE_TELEMETRY_RATE_HZ      50
+#endif
+
+// Pose samples per datagram and batch time window (in ms)
+#ifdef CONFIG_TELEMETRY_POSE_BATCH_SIZE
+#define POSE_BATCH_SIZE             CONFIG_TELEMETRY_POSE_BATCH_SIZE
+#define POSE_BATCH_WINDOW_MS        CONFIG_TELEMETRY_POSE_BATCH_WINDOW_MS
+#else
+#define POSE_BATCH_SIZE             1
+#define POSE_BATCH_WINDOW_MS        0
+#endif
+
+// Interval between position console prints (in ms)
+#define POSITION_PRINT_DELAY_MS     500
+
+// Console verbosity levels
+#define CONSOLE_VERBOSITY_OFF       0
+#define CONSOLE_VERBOSITY_BATTERY   1
+#define CONSOLE_VERBOSITY_POSITION  2
+
+#ifdef CONFIG_TELEMETRY_CONSOLE_PRINT
+#define CONSOLE_PRINT_ENABLED(level) (consoleVerbosity >= (level))
+#else
+#define CONFIG_TELEMETRY_CONSOLE_VERBOSITY CONSOLE_VERBOSITY_OFF
+#define CONSOLE_PRINT_ENABLED(level) (false)
+#endif
+
+// Rate control: the pose stream is sent at 1 / (1 << level) of its rate and
+// the loop timing, task and queue load every (1 << level) battery periods.
+// The level is raised on tx losses, a filling tx queue or a weak station,
+// and lowered after RATE_RECOVER_PERIODS clean periods with a good signal.
+#define RATE_LEVEL_MAX              3
+#define RATE_TX_FILL_HIGH_PCT       50
+#define RATE_RSSI_LOW               (-80)
+#define RATE_RSSI_GOOD              (-70)
+#define RATE_RECOVER_PERIODS        3
+
+// Telemetry packet format version
+#define TELEMETRY_PACKET_VERSION    3
+
 // Packet type identifier for packets
 #define PACKET_ID_BATTERY           0x01
 #define PACKET_ID_POSITION          0x02
+#define PACKET_ID_POSITION_BATCH    0x03
+#define PACKET_ID_LOOP_TIMING       0x04
+#define PACKET_ID_TASK_LOAD         0x05
+#define PACKET_ID_QUEUE_LOAD        0x06
+// Time sync answers, sent by the WiFi driver itself (wifi_esp32.c)
+#define PACKET_ID_TIME_SYNC         0x07
+#define PACKET_ID_HOTSPOT           0x08
+#define PACKET_ID_COUNT             9
 
-#define TASK_STACK_SIZE             4096
-#define TASK_PRIORITY               1
+// ESP-NOW pose packet identification, must match the camera firmware
+#define ESPNOW_POSE_MAGIC           "POS"
+#define ESPNOW_POSE_VERSION         1
 
 //======================================================================
 //                                PACKETS
 //======================================================================
+// Packet header: prepended to every telemetry packet
+typedef struct __attribute__((packed)) {
+    uint8_t version;         // Packet format version
+    uint8_t type;            // Packet type identifier
+    uint16_t seq;            // Per-type sequence counter
+    uint64_t timestamp;      // Sample time (us since boot)
+    uint8_t rateDivisor;     // Stream rate divisor set by the rate control
+} TelemetryHeader;
+
 // Battery Packet: contains drone battery
 typedef struct __attribute__((packed)) {
+    TelemetryHeader header;
     float vbatt; // Battery voltage (V)
+    float vbattCompensated; // Battery voltage without the motor load sag (V)
+    float charge;           // Battery charge (%)
+    float remainingTime;    // Flight time left (s), negative until measured
 } BatteryPacket;
 
-// Position Packet: contains drone position + orientation
+// Stage timing: one stabilizer loop timing histogram
+typedef struct __attribute__((packed)) {
+    uint16_t bins[STABILIZER_TIMING_BINS]; // Iterations per bin since the previous packet
+    uint16_t max;                          // Longest time of the last second (us)
+} StageTiming;
+
+// Loop Timing Packet: stabilizer stage times, loop time and wake up jitter
+typedef struct __attribute__((packed)) {
+    TelemetryHeader header;
+    StageTiming stages[stabilizerTimingCount];
+} LoopTimingPacket;
+
+// Task load record: CPU load and stack headroom of one task
+typedef struct __attribute__((packed)) {
+    char name[SYSLOAD_TASK_NAME_LEN]; // Task name, null terminated
+    uint16_t load;           // CPU load over the last second (0.01 % of one core)
+    uint16_t stackLeft;      // Unused stack at peak usage (bytes)
+    uint8_t priority;        // Base priority
+} TaskLoadRecord;
+
+// Task Load Packet: part of the task list, split to fit WIFI_TX_PACKET_SIZE
+typedef struct __attribute__((packed)) {
+    TelemetryHeader header;  // Timestamp is the end of the measured second
+    uint8_t first;           // Index of the first record in the task list
+    uint8_t count;           // Number of records in this packet
+    uint8_t total;           // Number of tasks in the list
+    uint32_t freeHeap;       // Free heap (bytes)
+    uint32_t minFreeHeap;    // Lowest free heap since boot (bytes)
+    TaskLoadRecord records[];
+} TaskLoadPacket;
+
+#define TASK_LOAD_RECORDS_PER_PACKET \
+    ((WIFI_TX_PACKET_SIZE - sizeof(TaskLoadPacket)) / sizeof(TaskLoadRecord))
+
+_Static_assert(TASK_LOAD_RECORDS_PER_PACKET >= 1,
+               "A task load record does not fit CONFIG_WIFI_TX_PACKET_SIZE");
+
+#ifdef DEBUG_QUEUE_MONITOR
+// Queue load record: fill and overflows of one queue
+typedef struct __attribute__((packed)) {
+    char name[QUEUE_MONITOR_NAME_LEN]; // Queue name, null terminated
+    uint16_t length;         // Queue length (items)
+    uint16_t sent;           // Items sent over the last second
+    uint16_t peak;           // Most items waiting over the last second
+    uint16_t full;           // Items dropped over the last second, queue full
+} QueueLoadRecord;
+
+// Queue Load Packet: part of the queue list, split to fit WIFI_TX_PACKET_SIZE
+typedef struct __attribute__((packed)) {
+    TelemetryHeader header;  // Timestamp is the end of the measured second
+    uint8_t first;           // Index of the first record in the queue list
+    uint8_t count;           // Number of records in this packet
+    uint8_t total;           // Number of queues in the list
+    QueueLoadRecord records[];
+} QueueLoadPacket;
+
+#define QUEUE_LOAD_RECORDS_PER_PACKET \
+    ((WIFI_TX_PACKET_SIZE - sizeof(QueueLoadPacket)) / sizeof(QueueLoadRecord))
+
+_Static_assert(QUEUE_LOAD_RECORDS_PER_PACKET >= 1,
+               "A queue load record does not fit CONFIG_WIFI_TX_PACKET_SIZE");
+#endif
+
+// Pose data: drone position + velocity + acceleration + orientation
 typedef struct __attribute__((packed)) {
     float x, y, z;           // Position (m)
+    float vx, vy, vz;        // Velocity (m/s)
+    float ax, ay, az;        // Acceleration (Gs)
     float roll, pitch, yaw;  // Orientation (deg)
+} PoseData;
+
+// Position Packet: contains a single pose
+typedef struct __attribute__((packed)) {
+    TelemetryHeader header;
+    PoseData pose;
 } PositionPacket;
 
+// Pose record: one pose of a batch, timed relative to the batch header
+typedef struct __attribute__((packed)) {
+    uint32_t dt;             // Offset from the header timestamp (us)
+    PoseData pose;
+} PoseRecord;
+
+// Position Batch Packet: contains up to POSE_BATCH_SIZE poses
+typedef struct __attribute__((packed)) {
+    TelemetryHeader header;
+    uint8_t count;           // Number of valid records
+    PoseRecord records[POSE_BATCH_SIZE];
+} PositionBatchPacket;
+
+// Hotspot Packet: hotspots of one thermal frame, with the pose it was read at
+typedef struct __attribute__((packed)) {
+    TelemetryHeader header;  // Timestamp is the frame read time
+    float x, y, z;           // Position (m)
+    float roll, pitch, yaw;  // Orientation (deg)
+    int16_t background;      // Median pixel of the frame (0.25 degrees Celsius)
+    uint8_t count;           // Number of hotspots
+    ThermalHotspot hotspots[THERMAL_HOTSPOT_MAX];
+} HotspotPacket;
+
+_Static_assert(sizeof(HotspotPacket) <= WIFI_TX_PACKET_SIZE,
+               "A hotspot packet does not fit CONFIG_WIFI_TX_PACKET_SIZE");
+
+// ESP-NOW Pose Packet: compact pose pushed to the camera
+typedef struct __attribute__((packed)) {
+    char magic[3];           // ESPNOW_POSE_MAGIC
+    uint8_t version;         // ESPNOW_POSE_VERSION
+    uint16_t seq;            // Sequence counter
+    uint64_t timestamp;      // Sample time (us since boot)
+    float x, y, z;           // Position (m)
+    float roll, pitch, yaw;  // Orientation (deg)
+} EspNowPosePacket;
+
+_Static_assert(sizeof(PositionBatchPacket) <= WIFI_TX_PACKET_SIZE,
+               "CONFIG_TELEMETRY_POSE_BATCH_SIZE does not fit CONFIG_WIFI_TX_PACKET_SIZE");
+
+// Pose sample: latest estimator output handed from the stabilizer loop
+typedef struct {
+    uint64_t timestamp;      // Estimator update time (us)
+    point_t position;        // Position (m)
+    velocity_t velocity;     // Velocity (m/s)
+    acc_t acc;               // Acceleration (Gs)
+    attitude_t attitude;     // Orientation (deg)
+} PoseSample;
+
+//======================================================================
+//                               POSE QUEUE
+//======================================================================
+// Length 1 queue overwritten by the stabilizer: always holds the latest pose.
+static QueueHandle_t poseQueue = NULL;
+#ifdef CONFIG_TELEMETRY_POSE_EVENT_DRIVEN
+STATIC_MEM_QUEUE_ALLOC(poseQueue, 1, sizeof(PoseSample));
+#endif
+
+// Next sequence number for each packet type
+static uint16_t packetSeq[PACKET_ID_COUNT];
+
+// Console verbosity, runtime adjustable through the telemetry.verbosity param
+static uint8_t consoleVerbosity = CONFIG_TELEMETRY_CONSOLE_VERBOSITY;
+
+// Rate control level, 0 sends every stream at full rate
+static uint8_t rateLevel = 0;
+// Rate control switch, runtime adjustable through the telemetry.rateCtrl param
+static uint8_t rateControlEnabled = 1;
+
+//======================================================================
+//                              RATE CONTROL
+//======================================================================
+// Rate divisor currently applied to a packet type: the battery and the
+// hotspot events are always sent, they are what the ground station needs
+// most on a weak link.
+static uint8_t rateDivisor(uint8_t packetID)
+{
+    return packetID == PACKET_ID_BATTERY || packetID == PACKET_ID_HOTSPOT ? 1 : 1 << rateLevel;
+}
+
+// Updates the rate level from the link health, once per battery period.
+static void updateRateControl(void)
+{
+    static WifiLinkStats previous;
+    static uint8_t cleanPeriods = 0;
+    WifiLinkStats link;
+    wifiGetLinkStats(&link);
+
+    uint32_t lost = (link.txError - previous.txError) + (link.txFull - previous.txFull) +
+                    (link.txDrop - previous.txDrop);
+    previous = link;
+
+    if (!rateControlEnabled) {
+        rateLevel = 0;
+        return;
+    }
+
+    bool congested = lost > 0 || link.txWaiting * 100 >= link.txPoolSize * RATE_TX_FILL_HIGH_PCT;
+    bool weak = link.stations > 0 && link.rssi < RATE_RSSI_LOW;
+    bool good = link.stations == 0 || link.rssi >= RATE_RSSI_GOOD;
+    if (congested || weak) {
+        cleanPeriods = 0;
+        if (rateLevel < RATE_LEVEL_MAX) {
+            rateLevel++;
+        }
+    } else if (good && ++cleanPeriods >= RATE_RECOVER_PERIODS) {
+        cleanPeriods = 0;
+        if (rateLevel > 0) {
+            rateLevel--;
+        }
+    }
+}
+
 //======================================================================
 //                               UDP SENDER
 //======================================================================
-// Builds the packet, prepends the packet ID, and sends using WiFi.
-static void sendUDP(uint8_t packetID, const void* data, size_t size)
+// Claims a WiFi tx packet, the telemetry packet is then built in place.
+// Never blocks: when the link is saturated the oldest queued packet is
+// dropped, fresh telemetry is worth more than stale one.
+static UDPTxPacket* claimUDP(void)
+{
+    return wifiClaimTxPacketDropOldest();
+}
+
+// Fills the header of a packet built in place, and sends using WiFi.
+static void sendUDP(uint8_t packetID, uint64_t timestamp, UDPTxPacket* packet, size_t size)
 {
-    if (!data || size == 0) return;
-    
-    // 1 byte header + packet struct
-    uint8_t buf[size + 1];
-    buf[0] = packetID;
-    memcpy(buf + 1, data, size);
+    if (!packet) return;
+    if (size < sizeof(TelemetryHeader) || packetID >= PACKET_ID_COUNT) {
+        wifiReleaseTxPacket(packet);
+        return;
+    }
+
+    TelemetryHeader *header = (TelemetryHeader *)packet->data;
+    header->version = TELEMETRY_PACKET_VERSION;
+    header->type = packetID;
+    header->seq = packetSeq[packetID]++;
+    header->timestamp = timestamp;
+    header->rateDivisor = rateDivisor(packetID);
 
-    wifiSendData(sizeof(buf), buf);
+    packet->size = size;
+    wifiSendTxPacket(packet);
 }
 
 //======================================================================
 //                                MONITORS
 //======================================================================
+// ---------------------- Loop Timing Monitor --------------------------
+// Sends the stabilizer loop timing histograms, as the iterations counted
+// since the previous packet so that they fit 16 bits.
+static void sendLoopTiming(void)
+{
+    static stabilizerTimingHistogram_t previous[stabilizerTimingCount];
+    stabilizerTimingHistogram_t current[stabilizerTimingCount];
+    stabilizerGetTimingHistograms(current);
+
+    UDPTxPacket *tx = claimUDP();
+    if (tx) {
+        LoopTimingPacket *packet = (LoopTimingPacket *)tx->data;
+        for (int i = 0; i < stabilizerTimingCount; i++) {
+            for (int bin = 0; bin < STABILIZER_TIMING_BINS; bin++) {
+                uint32_t count = current[i].bins[bin] - previous[i].bins[bin];
+                packet->stages[i].bins[bin] = count > UINT16_MAX ? UINT16_MAX : count;
+            }
+            packet->stages[i].max = current[i].max;
+        }
+        sendUDP(PACKET_ID_LOOP_TIMING, usecTimestamp(), tx, sizeof(*packet));
+        // Without a free tx packet, the next one also counts these iterations
+        memcpy(previous, current, sizeof(previous));
+    }
+}
+
+// ------------------------ Task Load Monitor --------------------------
+// Sends the CPU load and stack headroom of the tasks, once per second
+// measured by the load monitor, in as many packets as the task list needs.
+static void sendTaskLoad(void)
+{
+    static uint64_t lastTimestamp = 0;
+    sysLoadTask_t tasks[SYSLOAD_MAX_TASKS];
+    uint64_t timestamp;
+    int total = sysLoadGetTasks(tasks, SYSLOAD_MAX_TASKS, &timestamp);
+    if (timestamp == 0 || timestamp == lastTimestamp) return;
+    lastTimestamp = timestamp;
+
+    uint32_t freeHeap = esp_get_free_heap_size();
+    uint32_t minFreeHeap = esp_get_minimum_free_heap_size();
+    for (int first = 0; first < total; first += TASK_LOAD_RECORDS_PER_PACKET) {
+        UDPTxPacket *tx = claimUDP();
+        if (!tx) return;
+
+        TaskLoadPacket *packet = (TaskLoadPacket *)tx->data;
+        int count = total - first;
+        if (count > TASK_LOAD_RECORDS_PER_PACKET) count = TASK_LOAD_RECORDS_PER_PACKET;
+        packet->first = first;
+        packet->count = count;
+        packet->total = total;
+        packet->freeHeap = freeHeap;
+        packet->minFreeHeap = minFreeHeap;
+        for (int i = 0; i < count; i++) {
+            const sysLoadTask_t *task = &tasks[first + i];
+            memcpy(packet->records[i].name, task->name, SYSLOAD_TASK_NAME_LEN);
+            packet->records[i].load = task->load;
+            packet->records[i].stackLeft = task->stackLeft;
+            packet->records[i].priority = task->priority;
+        }
+        sendUDP(PACKET_ID_TASK_LOAD, timestamp, tx, sizeof(*packet) + count * sizeof(TaskLoadRecord));
+    }
+}
+
+#ifdef DEBUG_QUEUE_MONITOR
+// ------------------------ Queue Load Monitor -------------------------
+// Sends the fill and overflows of the monitored queues, once per second
+// measured by the queue monitor, in as many packets as the list needs.
+static void sendQueueLoad(void)
+{
+    static uint64_t lastTimestamp = 0;
+    queueMonitorQueue_t queues[QUEUE_MONITOR_MAX_QUEUES];
+    uint64_t timestamp;
+    int total = queueMonitorGetQueues(queues, QUEUE_MONITOR_MAX_QUEUES, &timestamp);
+    if (timestamp == 0 || timestamp == lastTimestamp) return;
+    lastTimestamp = timestamp;
+
+    for (int first = 0; first < total; first += QUEUE_LOAD_RECORDS_PER_PACKET) {
+        UDPTxPacket *tx = claimUDP();
+        if (!tx) return;
+
+        QueueLoadPacket *packet = (QueueLoadPacket *)tx->data;
+        int count = total - first;
+        if (count > QUEUE_LOAD_RECORDS_PER_PACKET) count = QUEUE_LOAD_RECORDS_PER_PACKET;
+        packet->first = first;
+        packet->count = count;
+        packet->total = total;
+        for (int i = 0; i < count; i++) {
+            const queueMonitorQueue_t *queue = &queues[first + i];
+            memcpy(packet->records[i].name, queue->name, QUEUE_MONITOR_NAME_LEN);
+            packet->records[i].length = queue->length;
+            packet->records[i].sent = queue->sendCount;
+            packet->records[i].peak = queue->maxWaiting;
+            packet->records[i].full = queue->fullCount;
+        }
+        sendUDP(PACKET_ID_QUEUE_LOAD, timestamp, tx, sizeof(*packet) + count * sizeof(QueueLoadRecord));
+    }
+}
+#endif
+
 // ----------------------- Battery Monitor -----------------------------
 // Periodically reads battery state, prints battery and motors states, and
-// sends UDP packets with battery.
+// sends UDP packets with battery, the loop timing, the task and queue load.
 static void batteryMonitorTask(void *param)
 {
+    uint32_t period = 0;
+
     while (1)
     {
         // Get current battery state
         float vbatt = pmGetBatteryVoltage();
-        float vbattMin = pmGetBatteryVoltageMin();
-        float vbattMax = pmGetBatteryVoltageMax();
-        
-        PMStates state = pmUpdateState();
-        const char *stateStr;
-        switch (state) {
-            case charged:   stateStr = "CHARGED"; break;
-            case charging:  stateStr = "CHARGING"; break;
-            case lowPower:  stateStr = "LOW_POWER"; break;
-            case battery:   stateStr = "BATTERY"; break;
-            default:        stateStr = "UNKNOWN"; break;
-        }
 
         // Print to console
-        printf("[BATTERY]  V=%.2f (Min=%.2f Max=%.2f) | State=%s | ",
-               vbatt, vbattMin, vbattMax, stateStr);
-        for (int i = 0; i < NBR_OF_MOTORS; i++)
-        {
-            // Calculate motor voltage based on battery voltage and motor ratio
-            float vmotor = vbatt * ((float)motorsGetRatio(i) / 65535.0f);
-            printf("M%d=%.2f\t", i+1, vmotor);
+        if (CONSOLE_PRINT_ENABLED(CONSOLE_VERBOSITY_BATTERY)) {
+            float vbattMin = pmGetBatteryVoltageMin();
+            float vbattMax = pmGetBatteryVoltageMax();
+
+            PMStates state = pmUpdateState();
+            const char *stateStr;
+            switch (state) {
+                case charged:   stateStr = "CHARGED"; break;
+                case charging:  stateStr = "CHARGING"; break;
+                case lowPower:  stateStr = "LOW_POWER"; break;
+                case battery:   stateStr = "BATTERY"; break;
+                default:        stateStr = "UNKNOWN"; break;
+            }
+
+            printf("[BATTERY]  V=%.2f (Min=%.2f Max=%.2f) | State=%s | ",
+                   vbatt, vbattMin, vbattMax, stateStr);
+            for (int i = 0; i < NBR_OF_MOTORS; i++)
+            {
+                // Calculate motor voltage based on battery voltage and motor ratio
+                float vmotor = vbatt * ((float)motorsGetRatio(i) / 65535.0f);
+                printf("M%d=%.2f\t", i+1, vmotor);
+            }
+            printf("\n");
         }
-        printf("\n");
 
         // Build battery packet
-        BatteryPacket packet = { vbatt };
+        UDPTxPacket *tx = claimUDP();
+        if (tx) {
+            BatteryPacket *packet = (BatteryPacket *)tx->data;
+            packet->vbatt = vbatt;
+            packet->vbattCompensated = pmGetBatteryVoltageCompensated();
+            packet->charge = pmGetBatteryCharge();
+            packet->remainingTime = pmGetRemainingFlightTime();
 
-        // Send UDP battery packet
-        sendUDP(PACKET_ID_BATTERY, &packet, sizeof(packet));
+            // Send UDP battery packet
+            sendUDP(PACKET_ID_BATTERY, usecTimestamp(), tx, sizeof(*packet));
+        }
+
+        // The slower streams, thinned out by the rate control
+        updateRateControl();
+        if (period++ % rateDivisor(PACKET_ID_LOOP_TIMING) == 0) {
+            sendLoopTiming();
+            sendTaskLoad();
+#ifdef DEBUG_QUEUE_MONITOR
+            sendQueueLoad();
+#endif
+        }
 
         // Wait before next update
         vTaskDelay(pdMS_TO_TICKS(BATTERY_MONITOR_DELAY_MS));
@@ -101,68 +499,231 @@ static void batteryMonitorTask(void *param)
 }
 
 // ----------------------------- Position Monitor -----------------------------
-// Periodically reads stabilizer state, prints position, and
-// sends UDP packets with position.
+// Reads a pose sample, prints position, and sends UDP packets with position.
+// In event-driven mode the task blocks until the stabilizer publishes a new
+// sample, otherwise it periodically polls the stabilizer state.
 //======================================================================
+static bool readPoseSample(PoseSample *sample)
+{
+#ifdef CONFIG_TELEMETRY_POSE_EVENT_DRIVEN
+    // Wait for the stabilizer loop to publish the next pose
+    return xQueueReceive(poseQueue, sample, portMAX_DELAY) == pdTRUE;
+#else
+    // Wait before next update
+    vTaskDelay(pdMS_TO_TICKS(POSITION_MONITOR_DELAY_MS));
+
+    // Copy the stabilizer state, all fields from the same tick
+    state_t s;
+    if (!stabilizerGetStateSnapshot(&s, NULL)) {
+        return false;
+    }
+
+    sample->timestamp = usecTimestamp();
+    sample->position = s.position;
+    sample->velocity = s.velocity;
+    sample->acc = s.acc;
+    sample->attitude = s.attitude;
+    return true;
+#endif
+}
+
+// Converts a pose sample to its packet representation.
+static void fillPoseData(PoseData *pose, const PoseSample *sample)
+{
+    pose->x = sample->position.x;
+    pose->y = sample->position.y;
+    pose->z = sample->position.z;
+    pose->vx = sample->velocity.x;
+    pose->vy = sample->velocity.y;
+    pose->vz = sample->velocity.z;
+    pose->ax = sample->acc.x;
+    pose->ay = sample->acc.y;
+    pose->az = sample->acc.z;
+    pose->roll = sample->attitude.roll;
+    pose->pitch = sample->attitude.pitch;
+    pose->yaw = sample->attitude.yaw;
+}
+
+#ifdef CONFIG_TELEMETRY_ESPNOW_POSE
+// Broadcasts a compact pose to the camera over ESP-NOW.
+static void sendEspNowPose(const PoseSample *sample)
+{
+    static const uint8_t broadcastAddr[ESP_NOW_ETH_ALEN] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    static uint16_t seq = 0;
+
+    EspNowPosePacket packet;
+    memcpy(packet.magic, ESPNOW_POSE_MAGIC, sizeof(packet.magic));
+    packet.version = ESPNOW_POSE_VERSION;
+    packet.seq = seq++;
+    packet.timestamp = sample->timestamp;
+    packet.x = sample->position.x;
+    packet.y = sample->position.y;
+    packet.z = sample->position.z;
+    packet.roll = sample->attitude.roll;
+    packet.pitch = sample->attitude.pitch;
+    packet.yaw = sample->attitude.yaw;
+
+    esp_now_send(broadcastAddr, (const uint8_t *)&packet, sizeof(packet));
+}
+#endif
+
+// Sends a single pose, or appends it to the current batch and sends the
+// batch once it is full or its oldest sample is older than the window.
+static void sendPose(const PoseSample *sample)
+{
+#ifdef CONFIG_TELEMETRY_ESPNOW_POSE
+    sendEspNowPose(sample);
+#endif
+
+    // Samples skipped by the rate control, the camera still gets them all
+    static uint8_t skipped = 0;
+    if (++skipped < rateDivisor(PACKET_ID_POSITION)) return;
+    skipped = 0;
+
+#if POSE_BATCH_SIZE > 1
+    // The batch is built in a tx packet held until the batch is sent
+    static UDPTxPacket *tx = NULL;
+    static uint64_t batchStart;
+
+    if (!tx) {
+        tx = claimUDP();
+        if (!tx) return;
+        ((PositionBatchPacket *)tx->data)->count = 0;
+        batchStart = sample->timestamp;
+    }
+    PositionBatchPacket *batch = (PositionBatchPacket *)tx->data;
+    PoseRecord *record = &batch->records[batch->count++];
+    record->dt = (uint32_t)(sample->timestamp - batchStart);
+    fillPoseData(&record->pose, sample);
+
+    if (batch->count >= POSE_BATCH_SIZE ||
+        sample->timestamp - batchStart >= (uint64_t)POSE_BATCH_WINDOW_MS * 1000) {
+        size_t size = offsetof(PositionBatchPacket, records) + batch->count * sizeof(PoseRecord);
+        tx->flags |= WIFI_TX_FLAG_RATE_LIMITED;
+        sendUDP(PACKET_ID_POSITION_BATCH, batchStart, tx, size);
+        tx = NULL;
+    }
+#else
+    UDPTxPacket *tx = claimUDP();
+    if (!tx) return;
+    PositionPacket *packet = (PositionPacket *)tx->data;
+    fillPoseData(&packet->pose, sample);
+    tx->flags |= WIFI_TX_FLAG_RATE_LIMITED;
+    sendUDP(PACKET_ID_POSITION, sample->timestamp, tx, sizeof(*packet));
+#endif
+}
+
 static void positionMonitorTask(void *param)
 {
+    TickType_t lastPrint = 0;
+    PoseSample sample;
+
     while (1)
     {
-        // Get current stabilizer state
-        const state_t* s = stabilizerGetState();
-
-        // Check if stabilizer state is valid
-        if (!s) {
-            printf("[ERROR] stabilizerGetState() returned NULL\n");
+        if (!readPoseSample(&sample)) {
             vTaskDelay(pdMS_TO_TICKS(100));
             continue;
         }
 
-        // Position
-        float x = s->position.x;
-        float y = s->position.y;
-        float z = s->position.z;
+        // Print to console (rate limited, the stream can run at up to 100 Hz)
+        TickType_t now = xTaskGetTickCount();
+        if (CONSOLE_PRINT_ENABLED(CONSOLE_VERBOSITY_POSITION) &&
+            now - lastPrint >= pdMS_TO_TICKS(POSITION_PRINT_DELAY_MS)) {
+            lastPrint = now;
+            printf("[POSITION] x=%.2f, y=%.2f, z=%.2f (m) | "
+                  "vx=%.2f, vy=%.2f, vz=%.2f (m/s) | "
+                  "ax=%.2f, ay=%.2f, az=%.2f (m/s²) | "
+                  "roll=%.2f, pitch=%.2f, yaw=%.2f (°)\n",
+                  sample.position.x, sample.position.y, sample.position.z,
+                  sample.velocity.x, sample.velocity.y, sample.velocity.z,
+                  sample.acc.x, sample.acc.y, sample.acc.z,
+                  sample.attitude.roll, sample.attitude.pitch, sample.attitude.yaw);
+        }
 
-        // Velocity
-        float vx = s->velocity.x;
-        float vy = s->velocity.y;
-        float vz = s->velocity.z;
+        // Send UDP position packet
+        sendPose(&sample);
+    }
+}
 
-        // Acceleration
-        float ax = s->acc.x;
-        float ay = s->acc.y;
-        float az = s->acc.z;
+//======================================================================
+//                    PUBLIC API — STABILIZER HOOK
+//======================================================================
+void telemetryPublishPose(const state_t *state, uint32_t tick)
+{
+#ifdef CONFIG_TELEMETRY_POSE_EVENT_DRIVEN
+    if (!poseQueue || !state) return;
 
-        // Orientation
-        float roll  = s->attitude.roll;
-        float pitch = s->attitude.pitch;
-        float yaw   = s->attitude.yaw;
+    if (RATE_DO_EXECUTE_PHASE(POSE_TELEMETRY_RATE_HZ, TELEMETRY_PHASE, tick)) {
+        PoseSample sample;
+        sample.timestamp = usecTimestamp();
+        sample.position = state->position;
+        sample.velocity = state->velocity;
+        sample.acc = state->acc;
+        sample.attitude = state->attitude;
+        xQueueOverwrite(poseQueue, &sample);
+    }
+#endif
+}
 
-        // Print to console
-        printf("[POSITION] x=%.2f, y=%.2f, z=%.2f (m) | "
-              "vx=%.2f, vy=%.2f, vz=%.2f (m/s) | "
-              "ax=%.2f, ay=%.2f, az=%.2f (m/s²) | "
-              "roll=%.2f, pitch=%.2f, yaw=%.2f (°)\n",
-              x, y, z, vx, vy, vz, ax, ay, az, roll, pitch, yaw);
+//======================================================================
+//                    PUBLIC API — THERMAL HOTSPOTS
+//======================================================================
+void telemetrySendHotspots(const ThermalHotspot *hotspots, uint8_t count,
+                           int16_t background, uint64_t timestamp)
+{
+    if (count > THERMAL_HOTSPOT_MAX) count = THERMAL_HOTSPOT_MAX;
 
-        // Build UDP position packet
-        PositionPacket packet;
-        packet.x = x;   packet.y = y;   packet.z = z;
-        packet.roll = roll; packet.pitch = pitch; packet.yaw = yaw;
+    UDPTxPacket *tx = claimUDP();
+    if (!tx) return;
 
-        // Send UDP position packet
-        sendUDP(PACKET_ID_POSITION, &packet, sizeof(packet));
+    state_t s = {0};
+    stabilizerGetStateSnapshot(&s, NULL);
+    HotspotPacket *packet = (HotspotPacket *)tx->data;
+    packet->x = s.position.x;
+    packet->y = s.position.y;
+    packet->z = s.position.z;
+    packet->roll = s.attitude.roll;
+    packet->pitch = s.attitude.pitch;
+    packet->yaw = s.attitude.yaw;
+    packet->background = background;
+    packet->count = count;
+    memcpy(packet->hotspots, hotspots, count * sizeof(ThermalHotspot));
 
-        // Wait before next update
-        vTaskDelay(pdMS_TO_TICKS(POSITION_MONITOR_DELAY_MS));
-    }
+    size_t size = offsetof(HotspotPacket, hotspots) + count * sizeof(ThermalHotspot);
+    sendUDP(PACKET_ID_HOTSPOT, timestamp, tx, size);
 }
 
 //======================================================================
 //                    PUBLIC API — START TELEMETRY TASK
 //======================================================================
+#ifdef CONFIG_TELEMETRY_UDP_PACKETS
+STATIC_MEM_TASK_ALLOC(batteryMonitorTask, TELEMETRY_TASK_STACKSIZE);
+STATIC_MEM_TASK_ALLOC(positionMonitorTask, TELEMETRY_TASK_STACKSIZE);
+#endif
+
 void startTelemetry(void)
 {
-    xTaskCreate(batteryMonitorTask, "BATTERY_MONITOR", TASK_STACK_SIZE, NULL, TASK_PRIORITY, NULL);
-    xTaskCreate(positionMonitorTask, "POSITION_MONITOR", TASK_STACK_SIZE, NULL, TASK_PRIORITY, NULL);
+// Without the UDP packets, the state is read through the CRTP log blocks instead
+#ifdef CONFIG_TELEMETRY_UDP_PACKETS
+#ifdef CONFIG_TELEMETRY_POSE_EVENT_DRIVEN
+    poseQueue = STATIC_MEM_QUEUE_CREATE(poseQueue);
+#endif
+
+    STATIC_MEM_TASK_CREATE_PINNED(batteryMonitorTask, batteryMonitorTask, BATTERY_MONITOR_TASK_NAME, NULL, TELEMETRY_TASK_PRI, BATTERY_MONITOR_TASK_CORE);
+    STATIC_MEM_TASK_CREATE_PINNED(positionMonitorTask, positionMonitorTask, POSITION_MONITOR_TASK_NAME, NULL, TELEMETRY_TASK_PRI, POSITION_MONITOR_TASK_CORE);
+#ifdef CONFIG_TELEMETRY_THERMAL_HOTSPOTS
+    startThermalHotspots();
+#endif
+#endif
 }
+
+PARAM_GROUP_START(telemetry)
+#ifdef CONFIG_TELEMETRY_CONSOLE_PRINT
+PARAM_ADD(PARAM_UINT8, verbosity, &consoleVerbosity)
+#endif
+PARAM_ADD(PARAM_UINT8, rateCtrl, &rateControlEnabled)
+PARAM_GROUP_STOP(telemetry)
+
+LOG_GROUP_START(telemetry)
+LOG_ADD(LOG_UINT8, rateLevel, &rateLevel)
+LOG_GROUP_STOP(telemetry)
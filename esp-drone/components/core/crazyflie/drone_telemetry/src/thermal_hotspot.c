@@ -0,0 +1,208 @@
+// Include necessary headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+#include "amg8833.h"
+#include "i2cdev.h"
+#include "system.h"
+#include "static_mem.h"
+#include "usec_time.h"
+#include "config.h"
+#include "param.h"
+#include "log.h"
+#include "drone_telemetry.h"
+#include "thermal_hotspot.h"
+
+// Built with the hotspot detection only, the task and its stack cost nothing otherwise
+#ifdef CONFIG_TELEMETRY_THERMAL_HOTSPOTS
+
+//======================================================================
+//                                CONSTANTS
+//======================================================================
+// Interval between frames (in ms), the AMG8833 runs at 10 fps at most
+#define THERMAL_FRAME_PERIOD_MS     100
+
+// Sensor frame size
+#define THERMAL_WIDTH               8
+#define THERMAL_HEIGHT              8
+#define THERMAL_PIXELS              (THERMAL_WIDTH * THERMAL_HEIGHT)
+
+// Pixel value units: 0.25 degrees Celsius
+#define THERMAL_UNITS_PER_DEGREE    4
+
+// Retry delay after the sensor failed to start (in ms)
+#define THERMAL_RETRY_DELAY_MS      5000
+
+//======================================================================
+//                               PARAMETERS
+//======================================================================
+// A pixel is hot above both the absolute threshold and the frame
+// background (its median pixel) plus the delta, in degrees Celsius.
+static uint8_t thresholdAbsolute = 45;
+static uint8_t thresholdDelta = 8;
+// Smallest hotspot reported (in pixels), filters single noisy pixels
+static uint8_t minPixels = 1;
+
+// Frame and read error counters, for the log
+static uint32_t frameCount = 0;
+static uint32_t readErrors = 0;
+static uint8_t hotspotCount = 0;
+
+//======================================================================
+//                                DETECTOR
+//======================================================================
+// Median pixel of the frame, the background the hotspots stand out from.
+static int16_t frameBackground(const int16_t *pixels)
+{
+    int16_t sorted[THERMAL_PIXELS];
+    memcpy(sorted, pixels, sizeof(sorted));
+    for (int i = 1; i < THERMAL_PIXELS; i++) {
+        int16_t value = sorted[i];
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > value; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+    return (sorted[THERMAL_PIXELS / 2 - 1] + sorted[THERMAL_PIXELS / 2]) / 2;
+}
+
+// Grows the 4-connected group of hot pixels holding the seed, marking its
+// pixels as visited, and fills the hotspot with it. The centroid is weighted
+// by how much each pixel is above the background, plus one so that the
+// weights never all vanish.
+static void growHotspot(const int16_t *pixels, bool *visited, int16_t threshold,
+                        int16_t background, uint8_t seed, ThermalHotspot *hotspot)
+{
+    uint8_t stack[THERMAL_PIXELS];
+    int top = 0;
+    int32_t sumWeight = 0, sumX = 0, sumY = 0;
+
+    hotspot->pixels = 0;
+    hotspot->peak = pixels[seed];
+    visited[seed] = true;
+    stack[top++] = seed;
+
+    while (top > 0) {
+        uint8_t i = stack[--top];
+        uint8_t x = i % THERMAL_WIDTH;
+        uint8_t y = i / THERMAL_WIDTH;
+        int32_t weight = pixels[i] - background + 1;
+
+        hotspot->pixels++;
+        if (pixels[i] > hotspot->peak) hotspot->peak = pixels[i];
+        sumWeight += weight;
+        sumX += weight * x;
+        sumY += weight * y;
+
+        // Each pixel is pushed at most once, so the stack never overflows
+        const uint8_t neighbours[4] = {
+            x > 0 ? i - 1 : i,
+            x < THERMAL_WIDTH - 1 ? i + 1 : i,
+            y > 0 ? i - THERMAL_WIDTH : i,
+            y < THERMAL_HEIGHT - 1 ? i + THERMAL_WIDTH : i,
+        };
+        for (int n = 0; n < 4; n++) {
+            uint8_t j = neighbours[n];
+            if (!visited[j] && pixels[j] >= threshold) {
+                visited[j] = true;
+                stack[top++] = j;
+            }
+        }
+    }
+
+    // Centroid of the pixel centres, in 1/16 pixel
+    hotspot->x = (uint8_t)((sumX * 16 + sumWeight * 8) / sumWeight);
+    hotspot->y = (uint8_t)((sumY * 16 + sumWeight * 8) / sumWeight);
+}
+
+// Finds the hotspots of a frame, keeping the THERMAL_HOTSPOT_MAX hottest.
+// Returns the number of hotspots found.
+static uint8_t findHotspots(const int16_t *pixels, int16_t background, ThermalHotspot *hotspots)
+{
+    int16_t threshold = thresholdAbsolute * THERMAL_UNITS_PER_DEGREE;
+    int16_t relative = background + thresholdDelta * THERMAL_UNITS_PER_DEGREE;
+    if (relative > threshold) threshold = relative;
+
+    bool visited[THERMAL_PIXELS] = {false};
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < THERMAL_PIXELS; i++) {
+        if (visited[i] || pixels[i] < threshold) continue;
+
+        ThermalHotspot hotspot;
+        growHotspot(pixels, visited, threshold, background, i, &hotspot);
+        if (hotspot.pixels < minPixels) continue;
+
+        // Insert sorted by peak, hottest first, dropping the coolest when full
+        int slot = count < THERMAL_HOTSPOT_MAX ? count++ : THERMAL_HOTSPOT_MAX;
+        for (; slot > 0 && hotspots[slot - 1].peak < hotspot.peak; slot--) {
+            if (slot < THERMAL_HOTSPOT_MAX) hotspots[slot] = hotspots[slot - 1];
+        }
+        if (slot < THERMAL_HOTSPOT_MAX) hotspots[slot] = hotspot;
+    }
+    return count;
+}
+
+//======================================================================
+//                                  TASK
+//======================================================================
+// Reads a frame every THERMAL_FRAME_PERIOD_MS and sends its hotspots.
+// Frames without hotspots send nothing, the uplink only carries events.
+static void thermalHotspotTask(void *param)
+{
+    AMG8833_Dev_t dev;
+    int16_t pixels[THERMAL_PIXELS];
+    ThermalHotspot hotspots[THERMAL_HOTSPOT_MAX];
+
+    systemWaitStart();
+
+    while (!begin(&dev, I2C1_DEV)) {
+        printf("[ERROR] AMG8833 not found on the deck I2C bus\n");
+        vTaskDelay(pdMS_TO_TICKS(THERMAL_RETRY_DELAY_MS));
+    }
+
+    TickType_t lastWake = xTaskGetTickCount();
+    while (1)
+    {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(THERMAL_FRAME_PERIOD_MS));
+
+        uint64_t timestamp = usecTimestamp();
+        if (!readPixelsRaw(&dev, pixels, THERMAL_PIXELS)) {
+            readErrors++;
+            continue;
+        }
+        frameCount++;
+
+        int16_t background = frameBackground(pixels);
+        hotspotCount = findHotspots(pixels, background, hotspots);
+        if (hotspotCount > 0) {
+            telemetrySendHotspots(hotspots, hotspotCount, background, timestamp);
+        }
+    }
+}
+
+//======================================================================
+//                    PUBLIC API — START THERMAL TASK
+//======================================================================
+STATIC_MEM_TASK_ALLOC(thermalHotspotTask, THERMAL_TASK_STACKSIZE);
+
+void startThermalHotspots(void)
+{
+    STATIC_MEM_TASK_CREATE_PINNED(thermalHotspotTask, thermalHotspotTask, THERMAL_TASK_NAME, NULL, THERMAL_TASK_PRI, THERMAL_TASK_CORE);
+}
+
+PARAM_GROUP_START(thermal)
+PARAM_ADD(PARAM_UINT8, threshold, &thresholdAbsolute)
+PARAM_ADD(PARAM_UINT8, delta, &thresholdDelta)
+PARAM_ADD(PARAM_UINT8, minPixels, &minPixels)
+PARAM_GROUP_STOP(thermal)
+
+LOG_GROUP_START(thermal)
+LOG_ADD(LOG_UINT32, frames, &frameCount)
+LOG_ADD(LOG_UINT32, readErrors, &readErrors)
+LOG_ADD(LOG_UINT8, hotspots, &hotspotCount)
+LOG_GROUP_STOP(thermal)
+
+#endif
@@ -90,6 +90,7 @@ bool begin(AMG8833_Dev_t *dev, I2C_Dev *I2Cx);
 
 // Data capture
 void readPixels(AMG8833_Dev_t *dev, float *buf, uint8_t size);
+bool readPixelsRaw(AMG8833_Dev_t *dev, int16_t *buf, uint8_t size);
 float readThermistor(AMG8833_Dev_t *dev);
 
 // Interrupts
@@ -106,17 +107,4 @@ void setInterruptLevels_H(AMG8833_Dev_t *dev, float high, float low, float hyste
 // Modes
 void setMovingAverageMode(AMG8833_Dev_t *dev, bool mode);
 
-// Read operations
-uint8_t read8(AMG8833_Dev_t *dev, uint8_t reg);
-void read(AMG8833_Dev_t *dev, uint8_t reg, uint8_t *buf, uint8_t num);
-
-// Write operations
-bool write8(AMG8833_Dev_t *dev, uint16_t reg, uint8_t value);
-void write(AMG8833_Dev_t *dev, uint8_t reg, uint8_t *buf, uint8_t num);
-
-// Supportive calculations
-float signedMag12ToFloat(uint16_t val);
-float int12ToFloat(uint16_t val);
-uint8_t min(uint8_t a, uint8_t b);
-
 #endif /* __AMG8833_H__ */
@@ -121,6 +121,24 @@ void pmSyslinkUpdate(SyslinkPacket *slp);
  */
 float pmGetBatteryVoltage(void);
 
+/**
+ * Returns the battery voltage without the sag of the motor load, in volts,
+ * as estimated by the battery model
+ */
+float pmGetBatteryVoltageCompensated(void);
+
+/**
+ * Returns the battery charge in %, from the compensated voltage
+ */
+float pmGetBatteryCharge(void);
+
+/**
+ * Returns the flight time left, in seconds, until the charge reaches a 10%
+ * reserve at the discharge rate measured in flight. Negative until the
+ * battery has flown long enough to measure it.
+ */
+float pmGetRemainingFlightTime(void);
+
 /**
  * Returns the min battery voltage i volts as a float
  */
@@ -31,6 +31,8 @@
 typedef enum { ACC_MODE_PROPTEST, ACC_MODE_FLIGHT } accModes;
 
 void sensorsInit(void);
+
+#ifndef CONFIG_SENSORS_DIRECT_CALLS
 bool sensorsTest(void);
 bool sensorsAreCalibrated(void);
 
@@ -53,9 +55,46 @@ bool sensorsReadAcc(Axis3f *acc);
 bool sensorsReadMag(Axis3f *mag);
 bool sensorsReadBaro(baro_t *baro);
 
+/**
+ * Same as the reads above, also giving the time the sample was taken, in us
+ * on the usecTimestamp() clock. Implementations that do not timestamp their
+ * samples give the time of the read.
+ */
+bool sensorsReadGyroTimestamped(Axis3f *gyro, uint64_t *timestamp);
+bool sensorsReadAccTimestamped(Axis3f *acc, uint64_t *timestamp);
+bool sensorsReadMagTimestamped(Axis3f *mag, uint64_t *timestamp);
+bool sensorsReadBaroTimestamped(baro_t *baro, uint64_t *timestamp);
+
 /**
  * Set acc mode, one of accModes enum
  */
 void sensorsSetAccMode(accModes accMode);
 
+#else
+/*
+ * The sensor implementation is fixed at build time and called without going
+ * through the implementation table of sensors.c, so the calls can be inlined,
+ * in the implementation itself and, with link time optimisation, in the
+ * stabilizer loop.
+ */
+#include "sensors_mpu6050_hm5883L_ms5611.h"
+
+#define SENSORS_DIRECT(name) sensorsMpu6050Hmc5883lMs5611##name
+
+static inline bool sensorsTest(void) { return SENSORS_DIRECT(Test)(); }
+static inline bool sensorsAreCalibrated(void) { return SENSORS_DIRECT(AreCalibrated)(); }
+static inline bool sensorsManufacturingTest(void) { return SENSORS_DIRECT(ManufacturingTest)(); }
+static inline void sensorsAcquire(sensorData_t *sensors, const uint32_t tick) { SENSORS_DIRECT(Acquire)(sensors, tick); }
+static inline void sensorsWaitDataReady(void) { SENSORS_DIRECT(WaitDataReady)(); }
+static inline bool sensorsReadGyro(Axis3f *gyro) { return SENSORS_DIRECT(ReadGyro)(gyro); }
+static inline bool sensorsReadAcc(Axis3f *acc) { return SENSORS_DIRECT(ReadAcc)(acc); }
+static inline bool sensorsReadMag(Axis3f *mag) { return SENSORS_DIRECT(ReadMag)(mag); }
+static inline bool sensorsReadBaro(baro_t *baro) { return SENSORS_DIRECT(ReadBaro)(baro); }
+static inline bool sensorsReadGyroTimestamped(Axis3f *gyro, uint64_t *timestamp) { return SENSORS_DIRECT(ReadGyroTimestamped)(gyro, timestamp); }
+static inline bool sensorsReadAccTimestamped(Axis3f *acc, uint64_t *timestamp) { return SENSORS_DIRECT(ReadAccTimestamped)(acc, timestamp); }
+static inline bool sensorsReadMagTimestamped(Axis3f *mag, uint64_t *timestamp) { return SENSORS_DIRECT(ReadMagTimestamped)(mag, timestamp); }
+static inline bool sensorsReadBaroTimestamped(baro_t *baro, uint64_t *timestamp) { return SENSORS_DIRECT(ReadBaroTimestamped)(baro, timestamp); }
+static inline void sensorsSetAccMode(accModes accMode) { SENSORS_DIRECT(SetAccMode)(accMode); }
+#endif
+
 #endif //__SENSORS_H__
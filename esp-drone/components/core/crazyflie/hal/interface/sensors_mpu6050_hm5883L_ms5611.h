@@ -39,6 +39,10 @@ bool sensorsMpu6050Hmc5883lMs5611ReadGyro(Axis3f *gyro);
 bool sensorsMpu6050Hmc5883lMs5611ReadAcc(Axis3f *acc);
 bool sensorsMpu6050Hmc5883lMs5611ReadMag(Axis3f *mag);
 bool sensorsMpu6050Hmc5883lMs5611ReadBaro(baro_t *baro);
+bool sensorsMpu6050Hmc5883lMs5611ReadGyroTimestamped(Axis3f *gyro, uint64_t *timestamp);
+bool sensorsMpu6050Hmc5883lMs5611ReadAccTimestamped(Axis3f *acc, uint64_t *timestamp);
+bool sensorsMpu6050Hmc5883lMs5611ReadMagTimestamped(Axis3f *mag, uint64_t *timestamp);
+bool sensorsMpu6050Hmc5883lMs5611ReadBaroTimestamped(baro_t *baro, uint64_t *timestamp);
 void sensorsMpu6050Hmc5883lMs5611SetAccMode(accModes accMode);
 
 #endif // __SENSORS_MPU9250_LPS25H_H__
\ No newline at end of file
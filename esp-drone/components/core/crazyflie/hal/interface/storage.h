@@ -51,7 +51,8 @@ bool storageTest();
  * it will be replaced.
  * 
  * This function can take a lot of time to complete: if there is no space for the new buffer,
- * the memory is going to be defragmented before the new buffer is written.
+ * the memory is going to be defragmented before the new buffer is written. The table is
+ * otherwise compacted in the background, by small steps while the system is not armed.
  * 
  * This function can fail either if there is no place left in memory or if the memory
  * is corrupted.
@@ -85,3 +86,15 @@ size_t storageFetch(char *key, void* buffer, size_t length);
  * @return true in case of success. false if the key was not found or if an error occured.
  */
 bool storageDelete(char* key);
+
+/**
+ * Start a batch of stores and deletes. Backends that write the whole table at
+ * once (NVS) defer the write until the matching storageBatchEnd().
+ * Batches can be nested.
+ */
+void storageBatchBegin(void);
+
+/**
+ * End a batch started with storageBatchBegin(), writing the pending changes.
+ */
+void storageBatchEnd(void);
@@ -27,15 +27,48 @@
 #define USEC_TIME_H_
 
 #include <stdint.h>
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
 
 /**
- * Initialize microsecond-resolution timer (TIM1).
+ * Initialize microsecond-resolution timer. Nothing to do, esp_timer is
+ * started by the system before app_main.
  */
 void initUsecTimer(void);
 
 /**
- * Get microsecond-resolution timestamp.
+ * Get microsecond-resolution timestamp, since boot.
+ *
+ * Inlined and safe to call from an ISR. The 64-bit esp_timer count does
+ * not wrap in the lifetime of the drone, and is the same on both cores.
+ */
+static inline uint64_t usecTimestamp(void)
+{
+  return (uint64_t)esp_timer_get_time();
+}
+
+/**
+ * Get the CPU cycle counter of the current core.
+ *
+ * Costs a single register read, for profiling short sections of code.
+ * The counter wraps every 2^32 cycles (18 s at 240 MHz), so only the
+ * unsigned difference of two reads is meaningful, and only when both
+ * were made on the same core: use usecTimestamp() for anything else.
+ */
+static inline uint32_t usecCycles(void)
+{
+  return esp_cpu_get_cycle_count();
+}
+
+/**
+ * Convert a CPU cycle count to microseconds.
+ *
+ * @param cycles Difference of two usecCycles() reads
  */
-uint64_t usecTimestamp(void);
+static inline uint32_t usecCyclesToUsec(uint32_t cycles)
+{
+  return cycles / esp_rom_get_cpu_ticks_per_us();
+}
 
 #endif /* USEC_TIME_H_ */
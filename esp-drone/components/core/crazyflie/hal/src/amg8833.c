@@ -31,6 +31,11 @@ const float AMG88xx_THRM_CONVERSION = 0.0625;
 
 static uint8_t mode = 1;
 
+static bool amgRead(AMG8833_Dev_t *dev, uint8_t reg, uint8_t *buf, uint8_t num);
+static bool amgWrite8(AMG8833_Dev_t *dev, uint8_t reg, uint8_t value);
+static float signedMag12ToFloat(uint16_t val);
+static uint8_t amgMin(uint8_t a, uint8_t b);
+
 /**************************************************************************
  Setups the I2C interface and thermal camera basic registers
 
@@ -45,13 +50,13 @@ bool begin(AMG8833_Dev_t *dev, I2C_Dev *I2Cx)
   dev->devAddr = AMG88xx_ADDRESS;
   bool i2c_complete = i2cdevInit(dev->I2Cx);
   // Enter normal mode
-  bool mode_selected = write8(dev, AMG88xx_PCTL, AMG88xx_NORMAL_MODE);
+  bool mode_selected = amgWrite8(dev, AMG88xx_PCTL, AMG88xx_NORMAL_MODE);
   // Software reset
-  bool software_resetted = write8(dev, AMG88xx_RST, AMG88xx_INITIAL_RESET);
+  bool software_resetted = amgWrite8(dev, AMG88xx_RST, AMG88xx_INITIAL_RESET);
   //disable interrupts by default
   bool interrupts_set = disableInterrupt(dev);
   //set to 10 FPS
-  bool fps_set = write8(dev, AMG88xx_FPSC, (AMG88xx_FPS_10 & 0x01));
+  bool fps_set = amgWrite8(dev, AMG88xx_FPSC, (AMG88xx_FPS_10 & 0x01));
   vTaskDelay(M2T(10));
   return i2c_complete && mode_selected && software_resetted &&
     interrupts_set && fps_set;
@@ -67,18 +72,37 @@ bool begin(AMG8833_Dev_t *dev, I2C_Dev *I2Cx)
 **************************************************************************/
 void readPixels(AMG8833_Dev_t *dev, float *buf, uint8_t size)
 {
-  uint16_t recast;
-  float converted;
-  uint8_t bytesToRead = min((uint8_t) (size << 1), (uint8_t) (AMG88xx_PIXEL_ARRAY_SIZE << 1));
-  uint8_t rawArray[bytesToRead];
-  read(dev, AMG88xx_PIXEL_OFFSET, rawArray, bytesToRead);
+  int16_t raw[AMG88xx_PIXEL_ARRAY_SIZE];
+  size = amgMin(size, AMG88xx_PIXEL_ARRAY_SIZE);
+  readPixelsRaw(dev, raw, size);
 
   for (int i = 0; i < size; i++) {
+    buf[i] = raw[i] * AMG88xx_TEMP_CONVERSION;
+  }
+}
+
+/**************************************************************************
+ Read Infrared sensor values without conversion, in one I2C transfer
+
+ @param  pdev Thermal camera struct
+ @param  buf the array to place the pixels in, in 0.25 degrees Celsius
+ @param  size number of pixels to read (up to 64)
+ @returns true if the transfer succeeded
+**************************************************************************/
+bool readPixelsRaw(AMG8833_Dev_t *dev, int16_t *buf, uint8_t size)
+{
+  uint8_t bytesToRead = amgMin((uint8_t) (size << 1), (uint8_t) (AMG88xx_PIXEL_ARRAY_SIZE << 1));
+  uint8_t rawArray[AMG88xx_PIXEL_ARRAY_SIZE << 1];
+  if (!amgRead(dev, AMG88xx_PIXEL_OFFSET, rawArray, bytesToRead)) {
+    return false;
+  }
+
+  for (int i = 0; i < (bytesToRead >> 1); i++) {
     uint8_t pos = i << 1;
-    recast = ((uint16_t) rawArray[pos + 1] << 8) | ((uint16_t) rawArray[pos]);
-    converted = int12ToFloat(recast) * AMG88xx_TEMP_CONVERSION;
-    buf[i] = converted;
+    // 12 bit two's complement, sign extended
+    buf[i] = (int16_t)((uint16_t)rawArray[pos + 1] << 12 | (uint16_t)rawArray[pos] << 4) >> 4;
   }
+  return true;
 }
 
 /**************************************************************************
@@ -90,7 +114,7 @@ void readPixels(AMG8833_Dev_t *dev, float *buf, uint8_t size)
 float readThermistor(AMG8833_Dev_t *dev)
 {
   uint8_t raw[2];
-  read(dev, AMG88xx_TTHL, raw, 2);
+  amgRead(dev, AMG88xx_TTHL, raw, 2);
   uint16_t recast = ((uint16_t) raw[1] << 8) | ((uint16_t) raw[0]);
   return signedMag12ToFloat(recast) * AMG88xx_THRM_CONVERSION;
 }
@@ -104,7 +128,7 @@ bool enableInterrupt(AMG8833_Dev_t *dev)
 {
   // 0 = Difference interrupt mode
   // 1 = absolute value interrupt mode
-  return write8(dev, AMG88xx_INTC, (mode << 1 | 1) & 0x03);
+  return amgWrite8(dev, AMG88xx_INTC, (mode << 1 | 1) & 0x03);
 }
 
 /**************************************************************************
@@ -116,7 +140,7 @@ bool disableInterrupt(AMG8833_Dev_t *dev)
 {
   // 0 = Difference interrupt mode
   // 1 = absolute value interrupt mode
-  return write8(dev, AMG88xx_INTC, (mode << 1 | 0) & 0x03);
+  return amgWrite8(dev, AMG88xx_INTC, (mode << 1 | 0) & 0x03);
 }
 
 /**************************************************************************
@@ -129,7 +153,7 @@ bool disableInterrupt(AMG8833_Dev_t *dev)
 void setInterruptMode(AMG8833_Dev_t *dev, uint8_t m)
 {
   mode = m;
-  write8(dev, AMG88xx_INTC, (mode << 1 | 1) & 0x03);
+  amgWrite8(dev, AMG88xx_INTC, (mode << 1 | 1) & 0x03);
 }
 
 /**************************************************************************
@@ -143,8 +167,8 @@ void setInterruptMode(AMG8833_Dev_t *dev, uint8_t m)
 **************************************************************************/
 void getInterrupt(AMG8833_Dev_t *dev, uint8_t *buf, uint8_t size)
 {
-  uint8_t bytesToRead = min(size, (uint8_t) 8);
-  read(dev, AMG88xx_INT_OFFSET, buf, bytesToRead);
+  uint8_t bytesToRead = amgMin(size, (uint8_t) 8);
+  amgRead(dev, AMG88xx_INT_OFFSET, buf, bytesToRead);
 }
 
 /**************************************************************************
@@ -154,7 +178,7 @@ void getInterrupt(AMG8833_Dev_t *dev, uint8_t *buf, uint8_t size)
 **************************************************************************/
 void clearInterrupt(AMG8833_Dev_t *dev)
 {
-  write8(dev, AMG88xx_RST, AMG88xx_FLAG_RESET);
+  amgWrite8(dev, AMG88xx_RST, AMG88xx_FLAG_RESET);
 }
 
 /**************************************************************************
@@ -182,18 +206,18 @@ void setInterruptLevels_H(AMG8833_Dev_t *dev, float high, float low,
 {
   int highConv = high / AMG88xx_TEMP_CONVERSION;
   highConv = constrain(highConv, -4095, 4095);
-  write8(dev, AMG88xx_INTHL, (highConv & 0xFF));
-  write8(dev, AMG88xx_INTHH, ((highConv & 0xF) >> 4));
+  amgWrite8(dev, AMG88xx_INTHL, (highConv & 0xFF));
+  amgWrite8(dev, AMG88xx_INTHH, ((highConv & 0xF) >> 4));
 
   int lowConv = low / AMG88xx_TEMP_CONVERSION;
   lowConv = constrain(lowConv, -4095, 4095);
-  write8(dev, AMG88xx_INTLL, (lowConv & 0xFF));
-  write8(dev, AMG88xx_INTLH, (((lowConv & 0xF) >> 4) & 0xF));
+  amgWrite8(dev, AMG88xx_INTLL, (lowConv & 0xFF));
+  amgWrite8(dev, AMG88xx_INTLH, (((lowConv & 0xF) >> 4) & 0xF));
 
   int hysConv = hysteresis / AMG88xx_TEMP_CONVERSION;
   hysConv = constrain(hysConv, -4095, 4095);
-  write8(dev, AMG88xx_IHYSL, (hysConv & 0xFF));
-  write8(dev, AMG88xx_IHYSH, (((hysConv & 0xF) >> 4) & 0xF));
+  amgWrite8(dev, AMG88xx_IHYSL, (hysConv & 0xFF));
+  amgWrite8(dev, AMG88xx_IHYSH, (((hysConv & 0xF) >> 4) & 0xF));
 }
 
 /**************************************************************************
@@ -204,21 +228,7 @@ void setInterruptLevels_H(AMG8833_Dev_t *dev, float high, float low,
 **************************************************************************/
 void setMovingAverageMode(AMG8833_Dev_t *dev, bool mode)
 {
-  write8(dev, AMG88xx_AVE, (mode << 5));
-}
-
-/**************************************************************************
- Read one byte of data from the specified register
-
- @param  dev Thermal camera struct
- @param  reg the register to read
- @returns one byte of register data
-**************************************************************************/
-uint8_t read8(AMG8833_Dev_t *dev, uint8_t reg)
-{
-  uint8_t ret;
-  read(dev, reg, &ret, 1);
-  return ret;
+  amgWrite8(dev, AMG88xx_AVE, (mode << 5));
 }
 
 /**************************************************************************
@@ -229,9 +239,9 @@ uint8_t read8(AMG8833_Dev_t *dev, uint8_t reg)
  @param  buf integer buffer to save read bytes
  @param  num number of bytes need to be read
 **************************************************************************/
-void read(AMG8833_Dev_t *dev, uint8_t reg, uint8_t *buf, uint8_t num)
+static bool amgRead(AMG8833_Dev_t *dev, uint8_t reg, uint8_t *buf, uint8_t num)
 {
-  i2cdevReadReg8(dev->I2Cx, dev->devAddr, reg, num, buf);
+  return i2cdevReadReg8(dev->I2Cx, dev->devAddr, reg, num, buf);
 }
 
 /**************************************************************************
@@ -242,24 +252,9 @@ void read(AMG8833_Dev_t *dev, uint8_t reg, uint8_t *buf, uint8_t num)
  @param  value the value to write
  @returns result of the write operation
 **************************************************************************/
-bool write8(AMG8833_Dev_t *dev, uint16_t reg, uint8_t value)
+static bool amgWrite8(AMG8833_Dev_t *dev, uint8_t reg, uint8_t value)
 {
-  return (i2cdevWrite16(dev->I2Cx, dev->devAddr, reg, 1, &value));
-}
-
-/**************************************************************************
- Read one byte of data from the specified register
-
- @param  dev Thermal camera struct
- @param  reg the register to write
- @param  buf integer buffer containing data to write
- @param  num number of bytes need to be written
-**************************************************************************/
-void write(AMG8833_Dev_t *dev, uint8_t reg, uint8_t *buf, uint8_t num)
-{
-  for (int i = 0; i < num; i++) {
-    write8(dev, reg, buf[i]);
-  }
+  return i2cdevWriteReg8(dev->I2Cx, dev->devAddr, reg, 1, &value);
 }
 
 /**************************************************************************
@@ -268,28 +263,13 @@ void write(AMG8833_Dev_t *dev, uint8_t reg, uint8_t *buf, uint8_t num)
  @param  val the 12-bit signed magnitude value to be converted
  @returns the converted floating point value
 **************************************************************************/
-float signedMag12ToFloat(uint16_t val)
+static float signedMag12ToFloat(uint16_t val)
 {
   // Take first 11 bits as absolute val
   uint16_t absVal = (val & 0x7FF);
   return (val & 0x800) ? 0 - (float) absVal : (float) absVal;
 }
 
-/**************************************************************************
- Convert a 12-bit integer two's complement value to a floating point number
-
- @param  val the 12-bit integer  two's complement value to be converted
- @returns the converted floating point value
-**************************************************************************/
-float int12ToFloat(uint16_t val)
-{
-  // Shift to left so that sign bit of 12 bit integer number is placed on
-  // sign bit of 16 bit signed integer number
-  int16_t sVal = (val << 4);
-  // Shift back the signed number, return converts to float
-  return sVal >> 4;
-}
-
 /**************************************************************************
  Finds the minimum value between two integers
 
@@ -297,7 +277,7 @@ float int12ToFloat(uint16_t val)
  @param  b second integer value
  @returns the minimum of a and b integers
 **************************************************************************/
-uint8_t min(uint8_t a, uint8_t b)
+static uint8_t amgMin(uint8_t a, uint8_t b)
 {
   return (a < b) ? a : b;
 }
@@ -31,8 +31,8 @@
 #include "ledseq.h"
 
 #include "FreeRTOS.h"
-#include "timers.h"
 #include "semphr.h"
+#include "esp_timer.h"
 #include "static_mem.h"
 
 #include "led.h"
@@ -177,21 +177,33 @@ struct ledseqCmd_s {
 };
 
 /* Led sequence handling machine implementation */
-static void runLedseq(xTimerHandle xTimer);
+static void runLedseq(led_t led, int64_t time);
 static void updateActive(led_t led);
+static void scheduleTimer(void);
+static void ledseqTimerCallback(void *arg);
+
+// Steps due within this time of the earliest one are run together (in us)
+#define LEDSEQ_TIMER_SLACK 2000
 
 NO_DMA_CCM_SAFE_ZERO_INIT static ledseqContext_t* activeSeq[LED_NUM];
 
-NO_DMA_CCM_SAFE_ZERO_INIT static xTimerHandle timer[LED_NUM];
-NO_DMA_CCM_SAFE_ZERO_INIT static StaticTimer_t timerBuffer[LED_NUM];
+// Time of the next step of each LED in us, 0 when the LED waits for nothing.
+// A single one shot esp_timer fires at the earliest of them.
+NO_DMA_CCM_SAFE_ZERO_INIT static int64_t nextStepTime[LED_NUM];
+static esp_timer_handle_t ledseqTimer;
+
+#define LEDSEQ_CMD_QUEUE_LENGTH 10
 
 static xSemaphoreHandle ledseqMutex;
+STATIC_MEM_SEMAPHORE_ALLOC(ledseqMutex);
 static xQueueHandle ledseqCmdQueue;
+STATIC_MEM_QUEUE_ALLOC(ledseqCmdQueue, LEDSEQ_CMD_QUEUE_LENGTH, sizeof(struct ledseqCmd_s));
 
 static bool isInit = false;
 static bool ledseqEnabled = false;
 
 static void lesdeqCmdTask(void* param);
+STATIC_MEM_TASK_ALLOC(lesdeqCmdTask, LEDSEQCMD_TASK_STACKSIZE);
 
 void ledseqInit() {
   if(isInit) {
@@ -216,15 +228,17 @@ void ledseqInit() {
     activeSeq[i] = 0;
   }
 
-  //Init the soft timers that runs the led sequences for each leds
-  for(int i=0; i<LED_NUM; i++) {
-    timer[i] = xTimerCreateStatic("ledseqTimer", M2T(1000), pdFALSE, (void*)i, runLedseq, &timerBuffer[i]);
-  }
+  ledseqMutex = STATIC_MEM_MUTEX_CREATE(ledseqMutex);
 
-  ledseqMutex = xSemaphoreCreateMutex();
+  //Init the timer that runs the led sequences of all the leds
+  const esp_timer_create_args_t timerArgs = {
+    .callback = ledseqTimerCallback,
+    .name = "ledseq",
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &ledseqTimer));
 
-  ledseqCmdQueue = xQueueCreate(10, sizeof(struct ledseqCmd_s));
-  xTaskCreate(lesdeqCmdTask, LEDSEQCMD_TASK_NAME, LEDSEQCMD_TASK_STACKSIZE, NULL, LEDSEQCMD_TASK_PRI, NULL);
+  ledseqCmdQueue = STATIC_MEM_QUEUE_CREATE(ledseqCmdQueue);
+  STATIC_MEM_TASK_CREATE_PINNED(lesdeqCmdTask, lesdeqCmdTask, LEDSEQCMD_TASK_NAME, NULL, LEDSEQCMD_TASK_PRI, LEDSEQCMD_TASK_CORE);
 
   isInit = true;
 }
@@ -279,12 +293,13 @@ void ledseqRunBlocking(ledseqContext_t *context) {
   xSemaphoreTake(ledseqMutex, portMAX_DELAY);
   context->state = 0;  //Reset the seq. to its first step
   updateActive(led);
-  xSemaphoreGive(ledseqMutex);
 
   // Run the first step if the new seq is the active sequence
   if(activeSeq[led] == context) {
-    runLedseq(timer[led]);
+    runLedseq(led, esp_timer_get_time());
+    scheduleTimer();
   }
+  xSemaphoreGive(ledseqMutex);
 }
 
 void ledseqSetChargeLevel(const float chargeLevel) {
@@ -309,39 +324,32 @@ void ledseqStopBlocking(ledseqContext_t *context) {
   const led_t led = context->led;
 
   xSemaphoreTake(ledseqMutex, portMAX_DELAY);
+  ledseqContext_t* previous = activeSeq[led];
   context->state = LEDSEQ_STOP;  //Stop the seq.
   updateActive(led);
-  xSemaphoreGive(ledseqMutex);
 
   //Run the next active sequence (if any...)
-  runLedseq(timer[led]);
+  if (activeSeq[led] != previous) {
+    runLedseq(led, esp_timer_get_time());
+    scheduleTimer();
+  }
+  xSemaphoreGive(ledseqMutex);
 }
 
-/* Center of the led sequence machine. This function is executed by the FreeRTOS
- * timers and runs the sequences
+/* Center of the led sequence machine. Runs the steps of the active sequence
+ * of a LED until the next wait, from time in us. Called with the mutex taken.
  */
-static void runLedseq( xTimerHandle xTimer ) {
+static void runLedseq(led_t led, int64_t time) {
+  nextStepTime[led] = 0;
+
   if (!ledseqEnabled) {
     return;
   }
 
-  led_t led = (led_t)pvTimerGetTimerID(xTimer);
   ledseqContext_t* context = activeSeq[led];
-  if (NO_CONTEXT == context) {
-    return;
-  }
-
-  bool leave = false;
-  while(!leave) {
-    if (context->state == LEDSEQ_STOP) {
-      return;
-    }
-
+  while (context != NO_CONTEXT && context->state != LEDSEQ_STOP) {
     const ledseqStep_t* step = &context->sequence[context->state];
-
-    xSemaphoreTake(ledseqMutex, portMAX_DELAY);
     context->state++;
-    led_t led = context->led;
 
     switch(step->action) {
       case LEDSEQ_LOOP:
@@ -350,21 +358,52 @@ static void runLedseq( xTimerHandle xTimer ) {
       case LEDSEQ_STOP:
         context->state = LEDSEQ_STOP;
         updateActive(led);
+        //Resume the next active sequence (if any...)
+        context = activeSeq[led];
         break;
       default:  //The step is a LED action and a time
         ledSet(led, step->value);
         if (step->action == 0) {
           break;
         }
-        xTimerChangePeriod(xTimer, M2T(step->action), 0);
-        xTimerStart(xTimer, 0);
-        leave = true;
-        break;
+        nextStepTime[led] = time + (int64_t)step->action * 1000;
+        return;
     }
-    xSemaphoreGive(ledseqMutex);
   }
 }
 
+// Arms the timer for the earliest step to come. Called with the mutex taken.
+static void scheduleTimer(void) {
+  int64_t next = 0;
+
+  for (int i = 0; i < LED_NUM; i++) {
+    if (nextStepTime[i] != 0 && (next == 0 || nextStepTime[i] < next)) {
+      next = nextStepTime[i];
+    }
+  }
+
+  esp_timer_stop(ledseqTimer);
+  if (next != 0) {
+    int64_t timeout = next - esp_timer_get_time();
+    esp_timer_start_once(ledseqTimer, (timeout > 0) ? timeout : 0);
+  }
+}
+
+static void ledseqTimerCallback(void *arg) {
+  xSemaphoreTake(ledseqMutex, portMAX_DELAY);
+
+  int64_t now = esp_timer_get_time();
+  for (int i = 0; i < LED_NUM; i++) {
+    if (nextStepTime[i] != 0 && nextStepTime[i] <= now + LEDSEQ_TIMER_SLACK) {
+      // The next step is counted from when this one was due, not from the late callback
+      runLedseq((led_t)i, nextStepTime[i]);
+    }
+  }
+  scheduleTimer();
+
+  xSemaphoreGive(ledseqMutex);
+}
+
 void ledseqRegisterSequence(ledseqContext_t* context) {
   context->state = LEDSEQ_STOP;
   context->nextContext = NO_CONTEXT;
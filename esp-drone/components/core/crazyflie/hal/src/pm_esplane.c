@@ -41,6 +41,7 @@
 #include "commander.h"
 #include "sound.h"
 #include "stm32_legacy.h"
+#include "motors.h"
 //#include "deck.h"
 #define DEBUG_MODULE "PM"
 #include "debug_cf.h"
@@ -93,6 +94,39 @@ static PmSyslinkInfo pmSyslinkInfo;
 
 static uint8_t batteryLevel;
 
+/*
+ * Battery model. The measured voltage is the open circuit voltage less a sag
+ * proportional to the motor load, the mean motor ratio from 0 to 1, which
+ * stands in for the current that is not measured. The sag per unit of load is
+ * learnt from the voltage steps that follow the load steps, over which the
+ * open circuit voltage does not change.
+ */
+#define PM_MODEL_PERIOD_S         0.1f
+// Load change between two samples from which the sag is measured
+#define PM_MODEL_STEP_LOAD        0.05f
+// Weight of a sag measurement in the estimate
+#define PM_MODEL_SAG_GAIN         0.1f
+// Sag at full load, in V
+#define PM_MODEL_R_INIT           0.3f
+#define PM_MODEL_R_MAX            2.0f
+// Mean motor ratio above which the battery is taken as being flown
+#define PM_MODEL_FLYING_LOAD      0.1f
+// Time constants of the open circuit voltage and discharge rate filters
+#define PM_MODEL_VOLTAGE_TC_S     5.0f
+#define PM_MODEL_RATE_TC_S        30.0f
+#define PM_MODEL_RATE_PERIOD_S    1.0f
+// Lowest discharge rate once measured, in %/s
+#define PM_MODEL_MIN_RATE         0.001f
+// Charge, in %, at which the remaining flight time ends
+#define PM_MODEL_RESERVE          10.0f
+
+static float batteryVoltageCompensated;
+static float batteryOpenCircuitVoltage;
+static float batteryResistance = PM_MODEL_R_INIT;
+static float batteryCharge;
+static float dischargeRate;
+static float remainingFlightTime = -1.0f;
+
 static void pmSetBatteryVoltage(float voltage);
 
 const static float bat671723HS25C[10] =
@@ -124,7 +158,7 @@ void pmInit(void)
     pmSyslinkInfo.vBat = 3.7f;
     pmSetBatteryVoltage(pmSyslinkInfo.vBat);
 
-    STATIC_MEM_TASK_CREATE(pmTask, pmTask, PM_TASK_NAME, NULL, PM_TASK_PRI);
+    STATIC_MEM_TASK_CREATE_PINNED(pmTask, pmTask, PM_TASK_NAME, NULL, PM_TASK_PRI, PM_TASK_CORE);
     isInit = true;
 
 }
@@ -186,11 +220,140 @@ static int32_t pmBatteryChargeFromVoltage(float voltage)
 }
 
 
+/**
+ * Charge in % of a rested battery, interpolated in the discharge curve
+ */
+static float pmBatteryChargePercent(float voltage)
+{
+  if (voltage <= bat671723HS25C[0])
+  {
+    return 0.0f;
+  }
+  if (voltage >= bat671723HS25C[9])
+  {
+    // Last step, to a full cell at 4.2 V
+    float charge = 90.0f + 10.0f * (voltage - bat671723HS25C[9]) / (4.20f - bat671723HS25C[9]);
+    return charge > 100.0f ? 100.0f : charge;
+  }
+
+  int i = 0;
+  while (voltage > bat671723HS25C[i + 1])
+  {
+    i++;
+  }
+
+  return 10.0f * (i + (voltage - bat671723HS25C[i]) / (bat671723HS25C[i + 1] - bat671723HS25C[i]));
+}
+
+static float pmMotorLoad(void)
+{
+  float load = 0.0f;
+
+  for (int i = 0; i < NBR_OF_MOTORS; i++)
+  {
+    load += (float)motorsGetRatio(i);
+  }
+
+  return load / (NBR_OF_MOTORS * 65535.0f);
+}
+
+/**
+ * Updates the sag model with a voltage sample and derives the compensated
+ * voltage, the charge and the remaining flight time.
+ */
+static void pmBatteryModelUpdate(float voltage)
+{
+  static bool isModelInit = false;
+  static float rateCharge;
+  static float rateTime;
+  static bool rateFlying;
+  static float lastVoltage;
+  static float lastLoad;
+
+  float load = pmMotorLoad();
+
+  if (!isModelInit)
+  {
+    batteryOpenCircuitVoltage = voltage + batteryResistance * load;
+    rateCharge = pmBatteryChargePercent(batteryOpenCircuitVoltage);
+    isModelInit = true;
+  }
+  else
+  {
+    float loadStep = load - lastLoad;
+    if (loadStep > PM_MODEL_STEP_LOAD || loadStep < -PM_MODEL_STEP_LOAD)
+    {
+      float sag = (lastVoltage - voltage) / loadStep;
+      // Steps measured across a voltage transient are not taken
+      if (sag > 0.0f && sag < PM_MODEL_R_MAX)
+      {
+        batteryResistance += PM_MODEL_SAG_GAIN * (sag - batteryResistance);
+      }
+    }
+  }
+  lastVoltage = voltage;
+  lastLoad = load;
+
+  batteryVoltageCompensated = voltage + batteryResistance * load;
+  batteryOpenCircuitVoltage += (PM_MODEL_PERIOD_S / PM_MODEL_VOLTAGE_TC_S) *
+                               (batteryVoltageCompensated - batteryOpenCircuitVoltage);
+  batteryCharge = pmBatteryChargePercent(batteryOpenCircuitVoltage);
+
+  // The discharge rate is learnt over the seconds flown all along, and kept
+  // on the ground to give the flight time the battery has left
+  bool flying = load > PM_MODEL_FLYING_LOAD;
+  rateFlying = rateFlying && flying;
+  rateTime += PM_MODEL_PERIOD_S;
+  if (rateTime >= PM_MODEL_RATE_PERIOD_S)
+  {
+    if (rateFlying)
+    {
+      float rate = (rateCharge - batteryCharge) / rateTime;
+      if (dischargeRate > 0.0f)
+      {
+        dischargeRate += (rateTime / PM_MODEL_RATE_TC_S) * (rate - dischargeRate);
+        if (dischargeRate < PM_MODEL_MIN_RATE)
+        {
+          dischargeRate = PM_MODEL_MIN_RATE;
+        }
+      }
+      else if (rate > 0.0f)
+      {
+        dischargeRate = rate;
+      }
+    }
+    rateCharge = batteryCharge;
+    rateTime = 0.0f;
+    rateFlying = flying;
+  }
+
+  if (dischargeRate > 0.0f)
+  {
+    float usable = batteryCharge - PM_MODEL_RESERVE;
+    remainingFlightTime = usable > 0.0f ? usable / dischargeRate : 0.0f;
+  }
+}
+
 float pmGetBatteryVoltage(void)
 {
   return batteryVoltage;
 }
 
+float pmGetBatteryVoltageCompensated(void)
+{
+  return batteryVoltageCompensated;
+}
+
+float pmGetBatteryCharge(void)
+{
+  return batteryCharge;
+}
+
+float pmGetRemainingFlightTime(void)
+{
+  return remainingFlightTime;
+}
+
 float pmGetBatteryVoltageMin(void)
 {
   return batteryVoltageMin;
@@ -334,6 +497,7 @@ void pmTask(void *param)
   extBatteryVoltageMV = (uint16_t)(extBatteryVoltage * 1000);
   extBatteryCurrent = pmMeasureExtBatteryCurrent();
   pmSetBatteryVoltage(extBatteryVoltage);
+  pmBatteryModelUpdate(extBatteryVoltage);
   batteryLevel = pmBatteryChargeFromVoltage(pmGetBatteryVoltage()) * 10;
 #ifdef DEBUG_EP2
   DEBUG_PRINTD("batteryLevel=%u extBatteryVoltageMV=%u \n", batteryLevel, extBatteryVoltageMV);
@@ -433,6 +597,11 @@ LOG_ADD(LOG_FLOAT, extCurr, &extBatteryCurrent)
 LOG_ADD(LOG_FLOAT, chargeCurrent, &pmSyslinkInfo.chargeCurrent)
 LOG_ADD(LOG_INT8, state, &pmState)
 LOG_ADD(LOG_UINT8, batteryLevel, &batteryLevel)
+LOG_ADD(LOG_FLOAT, vbatComp, &batteryVoltageCompensated)
+LOG_ADD(LOG_FLOAT, vbatOpen, &batteryOpenCircuitVoltage)
+LOG_ADD(LOG_FLOAT, sag, &batteryResistance)
+LOG_ADD(LOG_FLOAT, charge, &batteryCharge)
+LOG_ADD(LOG_FLOAT, flightTime, &remainingFlightTime)
 #ifdef PM_SYSTLINK_INLCUDE_TEMP
 LOG_ADD(LOG_FLOAT, temp, &temp)
 #endif
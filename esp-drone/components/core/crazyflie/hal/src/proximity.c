@@ -48,8 +48,15 @@ static uint32_t proximityDistanceAvg    = 0; /* Average distance in millimeters,
 static uint32_t proximityDistanceMedian = 0; /* Median distance in millimeters, initialized to zero. */
 static uint32_t proximityAccuracy       = 0; /* The accuracy as reported by the sensor driver for the latest sample. */
 
-/* The most recent samples in chronological order. Must be initialized before use. */
+/* The most recent samples in chronological order, from the oldest one at proximitySWinOldest. Must be initialized before use. */
 static uint32_t proximitySWin[PROXIMITY_SWIN_SIZE];
+static uint8_t proximitySWinOldest = 0;
+
+/* The same samples, kept sorted in increasing sample value order. Must be initialized before use. */
+static uint32_t proximitySWinSorted[PROXIMITY_SWIN_SIZE];
+
+/* Running sum of the samples. Must be initialized before use. */
+static uint64_t proximitySWinSum = 0;
 
 #if defined(PROXIMITY_ENABLED)
 
@@ -66,67 +73,71 @@ LOG_GROUP_STOP(proximity)
 STATIC_MEM_TASK_ALLOC(proximityTask, PROXIMITY_TASK_STACKSIZE);
 
 /**
- * This function returns the median value of an array.
+ * This function returns the median value of the sliding window.
  *
- * Internal sorting function by Bill Gentles Nov. 12 2010, seen
- * on http://forum.arduino.cc/index.php?topic=20920.0
+ * The sorted copy of the window is maintained by proximitySWinAdd(),
+ * so the median is read directly instead of sorting the window.
  *
- * @param proximitySWin Array of chronologically sequenced samples.
+ * @return Median value from the sliding window.
+ */
+static uint32_t proximitySWinMedian(void)
+{
+  return proximitySWinSorted[PROXIMITY_SWIN_SIZE / 2];
+}
+
+/**
+ * This function replaces a sample value of the sorted copy of the window with a new one.
+ * The values between the old and new positions are moved by one slot, so the copy stays
+ * sorted in a single pass instead of being sorted again.
  *
- * @return Median value from the array.
+ * @param oldest The sample value leaving the window.
+ * @param distance The sample value entering the window.
  */
-static uint32_t proximitySWinMedian(uint32_t *proximitySWin)
+static void proximitySWinSortedReplace(uint32_t oldest, uint32_t distance)
 {
-  /* The most recent samples, sorted in increasing sample value order. Must be initialized before use. */
-  uint32_t proximitySorted[PROXIMITY_SWIN_SIZE];
-
-  /* Create a copy of the chronologically sequenced buffer. */
-  memcpy(proximitySorted, proximitySWin, sizeof(uint32_t)*PROXIMITY_SWIN_SIZE);
-
-  /* Now sort this copy. */
-  uint8_t n;
-  for (n = 1; n < PROXIMITY_SWIN_SIZE; ++n) {
-    uint32_t valn = proximitySorted[n];
-    int8_t m; /* May reach value of -1 */
-    for (m = n - 1; (m >= 0) && (valn < proximitySorted[m]); m--)
-    {
-      proximitySorted[m + 1] = proximitySorted[m];
-    }
-    proximitySorted[m + 1] = valn;
+  /* Find the slot of the oldest sample. */
+  uint8_t n = 0;
+  while (proximitySWinSorted[n] != oldest) {
+    n++;
   }
 
-  /* Return the median value of the samples. */
-  return proximitySorted[PROXIMITY_SWIN_SIZE / 2];
+  /* Move the new sample towards its place. */
+  while ((n + 1 < PROXIMITY_SWIN_SIZE) && (proximitySWinSorted[n + 1] < distance)) {
+    proximitySWinSorted[n] = proximitySWinSorted[n + 1];
+    n++;
+  }
+  while ((n > 0) && (proximitySWinSorted[n - 1] > distance)) {
+    proximitySWinSorted[n] = proximitySWinSorted[n - 1];
+    n--;
+  }
+  proximitySWinSorted[n] = distance;
 }
 
 /**
  * This function adds a distance measurement to the sliding window, discarding the oldest sample.
  * After having added the new sample, a new average value of the samples is calculated and returned.
  *
+ * The window is a ring buffer with a running sum, so the average costs a single division
+ * whatever the window size.
+ *
  * @param distance The new sample to add to the sliding window.
  *
  * @return The new average value of the samples in the sliding window (after adding the new sample).
  */
 static uint32_t proximitySWinAdd(uint32_t distance)
 {
-  /* Discard oldest sample, move remaining samples one slot to the left. */
-  memmove(&proximitySWin[0], &proximitySWin[1], (PROXIMITY_SWIN_SIZE - 1) * sizeof(uint32_t));
-
-  /* Add the new sample in the last (right-most) slot. */
-  proximitySWin[PROXIMITY_SWIN_SIZE - 1] = distance;
-
-  /**
-   * Calculate the new average distance. Sum all the samples into a uint64_t,
-   * so that we only do a single division at the end.
-   */
-  uint64_t proximityNewAvg = 0;
-  uint8_t n;
-  for (n = 0; n < PROXIMITY_SWIN_SIZE; n++) {
-    proximityNewAvg += proximitySWin[n];
-  }
-  proximityNewAvg = proximityNewAvg / PROXIMITY_SWIN_SIZE;
+  /* Overwrite the oldest sample, the next one becomes the oldest. */
+  uint32_t oldest = proximitySWin[proximitySWinOldest];
+  proximitySWin[proximitySWinOldest] = distance;
+  proximitySWinOldest = (proximitySWinOldest + 1) % PROXIMITY_SWIN_SIZE;
+
+  proximitySWinSortedReplace(oldest, distance);
+
+  /* Update the sum of the samples, it fits a uint64_t whatever the window size. */
+  proximitySWinSum += distance;
+  proximitySWinSum -= oldest;
 
-  return (uint32_t)proximityNewAvg;
+  return (uint32_t)(proximitySWinSum / PROXIMITY_SWIN_SIZE);
 }
 
 /**
@@ -162,7 +173,7 @@ static void proximityTask(void* param)
     proximityDistanceAvg = proximitySWinAdd(proximityDistance);
 
     /* Get the latest median value calculated. */
-    proximityDistanceMedian = proximitySWinMedian(proximitySWin);
+    proximityDistanceMedian = proximitySWinMedian();
   }
 }
 #endif
@@ -177,6 +188,9 @@ void proximityInit(void)
 
   /* Initialise the sliding window to zero. */
   memset(&proximitySWin, 0, sizeof(uint32_t)*PROXIMITY_SWIN_SIZE);
+  memset(&proximitySWinSorted, 0, sizeof(uint32_t)*PROXIMITY_SWIN_SIZE);
+  proximitySWinOldest = 0;
+  proximitySWinSum = 0;
 
 #if defined(PROXIMITY_ENABLED)
   /* Only start the task if the proximity subsystem is enabled in conf.h */
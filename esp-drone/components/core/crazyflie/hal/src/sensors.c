@@ -31,11 +31,32 @@
 #include "sensors.h"
 #include "platform.h"
 #include "debug_cf.h"
+#include "usec_time.h"
 
 // https://gcc.gnu.org/onlinedocs/cpp/Stringizing.html
 #define xstr(s) str(s)
 #define str(s) #s
 
+#ifdef CONFIG_SENSORS_DIRECT_CALLS
+
+#ifndef SENSOR_INCLUDED_MPU6050_HMC5883L_MS5611
+#error "CONFIG_SENSORS_DIRECT_CALLS calls the MPU6050 implementation, which the platform does not include"
+#endif
+
+void sensorsInit(void) {
+  static bool isInit = false;
+
+  if (isInit) {
+    return;
+  }
+
+  SENSORS_DIRECT(Init)();
+
+  isInit = true;
+}
+
+#else
+
 #ifdef SENSOR_INCLUDED_BMI088_BMP388
   #include "sensors_bmi088_bmp388.h"
 #endif
@@ -68,6 +89,11 @@ typedef struct {
   bool (*readAcc)(Axis3f *acc);
   bool (*readMag)(Axis3f *mag);
   bool (*readBaro)(baro_t *baro);
+  // Optional, the time of the read is used when NULL
+  bool (*readGyroTimestamped)(Axis3f *gyro, uint64_t *timestamp);
+  bool (*readAccTimestamped)(Axis3f *acc, uint64_t *timestamp);
+  bool (*readMagTimestamped)(Axis3f *mag, uint64_t *timestamp);
+  bool (*readBaroTimestamped)(baro_t *baro, uint64_t *timestamp);
   void (*setAccMode)(accModes accMode);
   void (*dataAvailableCallback)(void);
 } sensorsImplementation_t;
@@ -125,6 +151,10 @@ static const sensorsImplementation_t sensorImplementations[SensorImplementation_
     .readAcc = sensorsMpu6050Hmc5883lMs5611ReadAcc,
     .readMag = sensorsMpu6050Hmc5883lMs5611ReadMag,
     .readBaro = sensorsMpu6050Hmc5883lMs5611ReadBaro,
+    .readGyroTimestamped = sensorsMpu6050Hmc5883lMs5611ReadGyroTimestamped,
+    .readAccTimestamped = sensorsMpu6050Hmc5883lMs5611ReadAccTimestamped,
+    .readMagTimestamped = sensorsMpu6050Hmc5883lMs5611ReadMagTimestamped,
+    .readBaroTimestamped = sensorsMpu6050Hmc5883lMs5611ReadBaroTimestamped,
     .setAccMode = sensorsMpu6050Hmc5883lMs5611SetAccMode,
     .dataAvailableCallback = nullFunction,
   }
@@ -197,7 +227,7 @@ bool sensorsAreCalibrated(void) {
 }
 
 bool sensorsManufacturingTest(void){
-  return activeImplementation->manufacturingTest;
+  return activeImplementation->manufacturingTest();
 }
 
 void sensorsAcquire(sensorData_t *sensors, const uint32_t tick) {
@@ -224,6 +254,38 @@ bool sensorsReadBaro(baro_t *baro) {
   return activeImplementation->readBaro(baro);
 }
 
+bool sensorsReadGyroTimestamped(Axis3f *gyro, uint64_t *timestamp) {
+  if (activeImplementation->readGyroTimestamped) {
+    return activeImplementation->readGyroTimestamped(gyro, timestamp);
+  }
+  *timestamp = usecTimestamp();
+  return activeImplementation->readGyro(gyro);
+}
+
+bool sensorsReadAccTimestamped(Axis3f *acc, uint64_t *timestamp) {
+  if (activeImplementation->readAccTimestamped) {
+    return activeImplementation->readAccTimestamped(acc, timestamp);
+  }
+  *timestamp = usecTimestamp();
+  return activeImplementation->readAcc(acc);
+}
+
+bool sensorsReadMagTimestamped(Axis3f *mag, uint64_t *timestamp) {
+  if (activeImplementation->readMagTimestamped) {
+    return activeImplementation->readMagTimestamped(mag, timestamp);
+  }
+  *timestamp = usecTimestamp();
+  return activeImplementation->readMag(mag);
+}
+
+bool sensorsReadBaroTimestamped(baro_t *baro, uint64_t *timestamp) {
+  if (activeImplementation->readBaroTimestamped) {
+    return activeImplementation->readBaroTimestamped(baro, timestamp);
+  }
+  *timestamp = usecTimestamp();
+  return activeImplementation->readBaro(baro);
+}
+
 void sensorsSetAccMode(accModes accMode) {
   activeImplementation->setAccMode(accMode);
 }
@@ -244,3 +306,5 @@ static const sensorsImplementation_t* findImplementation(SensorImplementation_t
 
   return result;
 }
+
+#endif // CONFIG_SENSORS_DIRECT_CALLS
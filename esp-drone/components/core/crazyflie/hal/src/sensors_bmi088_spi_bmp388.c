@@ -23,6 +23,12 @@
  *
  *
  * sensors_bmi088_bmp388.c: IMU sensor accusation for the *88 bosch sensors
+ *
+ * @note
+ * Kept as in the Crazyflie firmware, for the STM32 SPI and DMA peripherals. It is
+ * not built for the ESP32 targets, which have no BMI088 driver yet: a port should
+ * start the accel and gyro reads from the data ready ISR with spi_device_queue_trans()
+ * into two DMA capable buffers, and hand the completed one to sensorsTask.
  */
 
 #define DEBUG_MODULE "IMU"
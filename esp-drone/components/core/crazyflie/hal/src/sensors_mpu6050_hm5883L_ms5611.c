@@ -48,6 +48,9 @@
 #include "ledseq.h"
 #include "sound.h"
 #include "filter.h"
+#ifdef CONFIG_DYNAMIC_NOTCH
+#include "dynamic_notch.h"
+#endif
 #include "config.h"
 #include "stm32_legacy.h"
 
@@ -65,6 +68,11 @@
 #include "debug_cf.h"
 #include "static_mem.h"
 #include "crtp_commander.h"
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+#include "storage.h"
+#include "worker.h"
+#include "event_trace.h"
+#endif
 
 /**
  * Enable 250Hz digital LPF mode. However does not work with
@@ -115,8 +123,52 @@
 #define GYRO_VARIANCE_THRESHOLD_X (GYRO_VARIANCE_BASE)
 #define GYRO_VARIANCE_THRESHOLD_Y (GYRO_VARIANCE_BASE)
 #define GYRO_VARIANCE_THRESHOLD_Z (GYRO_VARIANCE_BASE)
+
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+#define SENSORS_BIAS_STORAGE_KEY "imu/bias"
+// Samples of the startup window checked against the stored bias
+#define SENSORS_BIAS_VERIFY_SAMPLES 128
+// Largest difference, in LSB, between the stored bias and the window mean. About 0.5 deg/s
+#define SENSORS_BIAS_VERIFY_TOLERANCE 8.0f
+// Weight of a new still buffer mean in the refined bias
+#define SENSORS_BIAS_REFINE_GAIN 0.25f
+// Acc scale change that is stored again
+#define SENSORS_ACC_SCALE_TOLERANCE 0.002f
+
+typedef struct {
+    Axis3f gyroBias;
+    float accScale;
+} storedBias_t;
+#endif
 #define ESP_INTR_FLAG_DEFAULT 0
 
+#ifdef CONFIG_MPU6050_FIFO
+// The MPU6050 has no FIFO watermark interrupt: the task polls the FIFO every
+// SENSORS_FIFO_BATCH samples, at the 1 kHz output rate of all the DLPF settings.
+#define SENSORS_FIFO_BATCH CONFIG_MPU6050_FIFO_BATCH
+#define SENSORS_FIFO_SAMPLE_PERIOD_US 1000
+#define SENSORS_FIFO_SIZE 1024
+// Up to two batches are read at once, to catch up after a late wakeup
+#define SENSORS_FIFO_MAX_SAMPLES (2 * SENSORS_FIFO_BATCH)
+#define SENSORS_IMU_QUEUE_LEN SENSORS_FIFO_MAX_SAMPLES
+#else
+#define SENSORS_IMU_QUEUE_LEN 1
+#endif
+// Output rate of the IMU
+#define SENSORS_IMU_PERIOD_US 1000
+
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+// Bus time kept free before the next IMU read
+#define SENSORS_BUS_SLOT_GUARD_US 50
+// First estimates of the transfers at 400 kHz, then following their measured duration
+#define SENSORS_MAG_SLOT_COST_US 300
+#define SENSORS_BARO_SLOT_COST_US 250
+// The estimates are capped below the idle time after an IMU read, so that a
+// preempted transfer does not keep its job out of it
+#define SENSORS_BUS_SLOT_MAX_COST_US 400
+#define SENSORS_MAG_SLOT_PERIOD_US 10000
+#endif
+
 #define PITCH_CALIB (CONFIG_PITCH_CALIB*1.0/100)
 #define ROLL_CALIB (CONFIG_ROLL_CALIB*1.0/100)
 
@@ -130,17 +182,34 @@ typedef struct {
     Axis3i16 buffer[SENSORS_NBR_OF_BIAS_SAMPLES];
 } BiasObj;
 
+// Samples on the output queues, with the time they were taken in us
+typedef struct {
+    Axis3f axis;
+    uint64_t timestamp;
+} timedAxis3f_t;
+
+typedef struct {
+    baro_t baro;
+    uint64_t timestamp;
+} timedBaro_t;
+
 static xQueueHandle accelerometerDataQueue;
-STATIC_MEM_QUEUE_ALLOC(accelerometerDataQueue, 1, sizeof(Axis3f));
+STATIC_MEM_QUEUE_ALLOC(accelerometerDataQueue, SENSORS_IMU_QUEUE_LEN, sizeof(timedAxis3f_t));
 static xQueueHandle gyroDataQueue;
-STATIC_MEM_QUEUE_ALLOC(gyroDataQueue, 1, sizeof(Axis3f));
+STATIC_MEM_QUEUE_ALLOC(gyroDataQueue, SENSORS_IMU_QUEUE_LEN, sizeof(timedAxis3f_t));
 static xQueueHandle magnetometerDataQueue;
-STATIC_MEM_QUEUE_ALLOC(magnetometerDataQueue, 1, sizeof(Axis3f));
+STATIC_MEM_QUEUE_ALLOC(magnetometerDataQueue, 1, sizeof(timedAxis3f_t));
 static xQueueHandle barometerDataQueue;
-STATIC_MEM_QUEUE_ALLOC(barometerDataQueue, 1, sizeof(baro_t));
+STATIC_MEM_QUEUE_ALLOC(barometerDataQueue, 1, sizeof(timedBaro_t));
+#ifdef CONFIG_MPU6050_FIFO
+static xQueueHandle timestampQueue;
+STATIC_MEM_QUEUE_ALLOC(timestampQueue, SENSORS_IMU_QUEUE_LEN, sizeof(uint64_t));
+#endif
 
 static xSemaphoreHandle sensorsDataReady;
+STATIC_MEM_SEMAPHORE_ALLOC(sensorsDataReady);
 static xSemaphoreHandle dataReady;
+STATIC_MEM_SEMAPHORE_ALLOC(dataReady);
 
 static bool isInit = false;
 static sensorData_t sensorData;
@@ -156,13 +225,20 @@ static Axis3f gyroBiasStdDev;
 static bool gyroBiasFound = false;
 static float accScaleSum = 0;
 static float accScale = 1;
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+static storedBias_t storedBias;
+static bool isStoredBiasValid = false;
+// Copy for the worker, which writes it to storage
+static storedBias_t biasToStore;
+static bool isBiasStoreScheduled = false;
+static uint8_t gyroBiasSource;
+#endif
 
 // Low Pass filtering
 #define GYRO_LPF_CUTOFF_FREQ 80
 #define ACCEL_LPF_CUTOFF_FREQ 30
-static lpf2pData accLpf[3];
-static lpf2pData gyroLpf[3];
-static void applyAxis3fLpf(lpf2pData *data, Axis3f *in);
+static lpf2pBank accLpf;
+static lpf2pBank gyroLpf;
 
 static bool isBarometerPresent = false;
 static bool isMagnetometerPresent = false;
@@ -191,11 +267,23 @@ float sinRoll;
 
 // This buffer needs to hold data from all sensors
 static uint8_t buffer[SENSORS_MPU6050_BUFF_LEN + SENSORS_MAG_BUFF_LEN + SENSORS_BARO_BUFF_LEN] = {0};
+#ifdef CONFIG_MPU6050_FIFO
+// FIFO samples hold the same acc, temperature, gyro registers as the direct read
+static uint8_t fifoBuffer[SENSORS_FIFO_MAX_SAMPLES * SENSORS_MPU6050_BUFF_LEN];
+static uint16_t fifoSamples;
+static uint16_t fifoResets;
+#endif
 
 static void processAccGyroMeasurements(const uint8_t *buffer);
 static void processMagnetometerMeasurements(const uint8_t *buffer);
 static void processBarometerMeasurements(const uint8_t *buffer);
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+static void sensorsRunBusSlots(uint64_t deadline);
+#endif
 static void sensorsSetupSlaveRead(void);
+#ifdef CONFIG_MPU6050_FIFO
+static void sensorsReadFifo(void);
+#endif
 
 #ifdef GYRO_GYRO_BIAS_LIGHT_WEIGHT
 static bool processGyroBiasNoBuffer(int16_t gx, int16_t gy, int16_t gz, Axis3f *gyroBiasOut);
@@ -204,42 +292,105 @@ static bool processGyroBias(int16_t gx, int16_t gy, int16_t gz, Axis3f *gyroBias
 #endif
 static bool processAccScale(int16_t ax, int16_t ay, int16_t az);
 static void sensorsBiasObjInit(BiasObj *bias);
-static void sensorsCalculateVarianceAndMean(BiasObj *bias, Axis3f *varOut, Axis3f *meanOut);
+static void sensorsCalculateVarianceAndMean(BiasObj *bias, uint32_t nbrOfSamples, Axis3f *varOut, Axis3f *meanOut);
 static void sensorsCalculateBiasMean(BiasObj *bias, Axis3i32 *meanOut);
 static void sensorsAddBiasValue(BiasObj *bias, int16_t x, int16_t y, int16_t z);
 static bool sensorsFindBiasValue(BiasObj *bias);
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+static void sensorsLoadStoredBias(void);
+static bool sensorsVerifyStoredBias(BiasObj *bias);
+static void sensorsRefineBiasValue(BiasObj *bias);
+static void sensorsScheduleBiasStore(void);
+#endif
 static void sensorsAccAlignToGravity(Axis3f *in, Axis3f *out);
 
 STATIC_MEM_TASK_ALLOC(sensorsTask, SENSORS_TASK_STACKSIZE);
+static bool sensorsReceiveAxis(xQueueHandle queue, Axis3f *axis, uint64_t *timestamp)
+{
+    timedAxis3f_t sample;
+
+    if (pdTRUE != xQueueReceive(queue, &sample, 0)) {
+        return false;
+    }
+
+    *axis = sample.axis;
+    *timestamp = sample.timestamp;
+    return true;
+}
+
+bool sensorsMpu6050Hmc5883lMs5611ReadGyroTimestamped(Axis3f *gyro, uint64_t *timestamp)
+{
+    return sensorsReceiveAxis(gyroDataQueue, gyro, timestamp);
+}
+
+bool sensorsMpu6050Hmc5883lMs5611ReadAccTimestamped(Axis3f *acc, uint64_t *timestamp)
+{
+    return sensorsReceiveAxis(accelerometerDataQueue, acc, timestamp);
+}
+
+bool sensorsMpu6050Hmc5883lMs5611ReadMagTimestamped(Axis3f *mag, uint64_t *timestamp)
+{
+    return sensorsReceiveAxis(magnetometerDataQueue, mag, timestamp);
+}
+
+bool sensorsMpu6050Hmc5883lMs5611ReadBaroTimestamped(baro_t *baro, uint64_t *timestamp)
+{
+    timedBaro_t sample;
+
+    if (pdTRUE != xQueueReceive(barometerDataQueue, &sample, 0)) {
+        return false;
+    }
+
+    *baro = sample.baro;
+    *timestamp = sample.timestamp;
+    return true;
+}
+
 bool sensorsMpu6050Hmc5883lMs5611ReadGyro(Axis3f *gyro)
 {
-    return (pdTRUE == xQueueReceive(gyroDataQueue, gyro, 0));
+    uint64_t timestamp;
+    return sensorsMpu6050Hmc5883lMs5611ReadGyroTimestamped(gyro, &timestamp);
 }
 
 bool sensorsMpu6050Hmc5883lMs5611ReadAcc(Axis3f *acc)
 {
-    return (pdTRUE == xQueueReceive(accelerometerDataQueue, acc, 0));
+    uint64_t timestamp;
+    return sensorsMpu6050Hmc5883lMs5611ReadAccTimestamped(acc, &timestamp);
 }
 
 bool sensorsMpu6050Hmc5883lMs5611ReadMag(Axis3f *mag)
 {
-    return (pdTRUE == xQueueReceive(magnetometerDataQueue, mag, 0));
+    uint64_t timestamp;
+    return sensorsMpu6050Hmc5883lMs5611ReadMagTimestamped(mag, &timestamp);
 }
 
 bool sensorsMpu6050Hmc5883lMs5611ReadBaro(baro_t *baro)
 {
-    return (pdTRUE == xQueueReceive(barometerDataQueue, baro, 0));
+    uint64_t timestamp;
+    return sensorsMpu6050Hmc5883lMs5611ReadBaroTimestamped(baro, &timestamp);
 }
 
 void sensorsMpu6050Hmc5883lMs5611Acquire(sensorData_t *sensors, const uint32_t tick)
 {
-    sensorsReadGyro(&sensors->gyro);
-    sensorsReadAcc(&sensors->acc);
-    sensorsReadMag(&sensors->mag);
-    sensorsReadBaro(&sensors->baro);
+    sensorsReadGyroTimestamped(&sensors->gyro, &sensors->gyroTimestamp);
+    sensorsReadAccTimestamped(&sensors->acc, &sensors->accTimestamp);
+    sensorsReadMagTimestamped(&sensors->mag, &sensors->magTimestamp);
+    sensorsReadBaroTimestamped(&sensors->baro, &sensors->baroTimestamp);
     sensors->interruptTimestamp = sensorData.interruptTimestamp;
 }
 
+static void sensorsOverwriteAxis(xQueueHandle queue, const Axis3f *axis, uint64_t timestamp)
+{
+    timedAxis3f_t sample = {.axis = *axis, .timestamp = timestamp};
+    xQueueOverwrite(queue, &sample);
+}
+
+static void sensorsOverwriteBaro(const baro_t *baro, uint64_t timestamp)
+{
+    timedBaro_t sample = {.baro = *baro, .timestamp = timestamp};
+    xQueueOverwrite(barometerDataQueue, &sample);
+}
+
 bool sensorsMpu6050Hmc5883lMs5611AreCalibrated()
 {
     return gyroBiasFound;
@@ -254,13 +405,35 @@ static void sensorsTask(void *param)
     sensorsSetupSlaveRead(); //
     DEBUG_PRINTD("xTaskCreate sensorsTask SetupSlave done");
 
+#ifdef CONFIG_MPU6050_FIFO
+    TickType_t lastWakeTime = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&lastWakeTime, M2T(SENSORS_FIFO_BATCH * SENSORS_FIFO_SAMPLE_PERIOD_US / 1000));
+        EVENT_TRACE_BEGIN(eventTraceSensorsRead, 0);
+        sensorsReadFifo();
+        EVENT_TRACE_STOP(eventTraceSensorsRead, 0);
+    }
+#else
     while (1) {
 
         /* mpu6050 interrupt trigger: data is ready to be read */
         if (pdTRUE == xSemaphoreTake(sensorsDataReady, portMAX_DELAY)) {
+            EVENT_TRACE_BEGIN(eventTraceSensorsRead, 0);
             sensorData.interruptTimestamp = imuIntTimestamp;
 
             /* sensors step 1-read data from I2C */
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+            // The mag and baro are read in the idle time after the IMU
+            i2cdevReadReg8(I2C0_DEV, MPU6050_ADDRESS_AD0_LOW, MPU6050_RA_ACCEL_XOUT_H, SENSORS_MPU6050_BUFF_LEN, buffer);
+
+            /* sensors step 2-process the respective data */
+            processAccGyroMeasurements(&(buffer[0]));
+
+            /* sensors step 3- queue sensors data  on the output queues */
+            sensorsOverwriteAxis(accelerometerDataQueue, &sensorData.acc, sensorData.interruptTimestamp);
+            sensorsOverwriteAxis(gyroDataQueue, &sensorData.gyro, sensorData.interruptTimestamp);
+#else
             uint8_t dataLen = (uint8_t)(SENSORS_MPU6050_BUFF_LEN +
                                         (isMagnetometerPresent ? SENSORS_MAG_BUFF_LEN : 0) +
                                         (isBarometerPresent ? SENSORS_BARO_BUFF_LEN : 0));
@@ -278,30 +451,228 @@ static void sensorsTask(void *param)
             }
 
             /* sensors step 3- queue sensors data  on the output queues */
-            xQueueOverwrite(accelerometerDataQueue, &sensorData.acc);
-            xQueueOverwrite(gyroDataQueue, &sensorData.gyro);
+            // The acc and gyro were latched at the interrupt, the slave data
+            // is at most one slave read period older
+            sensorsOverwriteAxis(accelerometerDataQueue, &sensorData.acc, sensorData.interruptTimestamp);
+            sensorsOverwriteAxis(gyroDataQueue, &sensorData.gyro, sensorData.interruptTimestamp);
 
             if (isMagnetometerPresent) {
-                xQueueOverwrite(magnetometerDataQueue, &sensorData.mag);
+                sensorsOverwriteAxis(magnetometerDataQueue, &sensorData.mag, sensorData.interruptTimestamp);
             }
 
             if (isBarometerPresent) {
-                xQueueOverwrite(barometerDataQueue, &sensorData.baro);
+                sensorsOverwriteBaro(&sensorData.baro, sensorData.interruptTimestamp);
             }
+#endif
 
             /* sensors step 4- Unlock stabilizer task */
+            EVENT_TRACE_STOP(eventTraceSensorsRead, 0);
             xSemaphoreGive(dataReady);
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+            sensorsRunBusSlots(sensorData.interruptTimestamp + SENSORS_IMU_PERIOD_US);
+#endif
 #ifdef DEBUG_EP2
             DEBUG_PRINT_LOCAL("ax = %f,  ay = %f,  az = %f,  gx = %f,  gy = %f,  gz = %f , hx = %f , hy = %f, hz =%f \n", sensorData.acc.x, sensorData.acc.y, sensorData.acc.z, sensorData.gyro.x, sensorData.gyro.y, sensorData.gyro.z, sensorData.mag.x, sensorData.mag.y, sensorData.mag.z);
 #endif
         }
     }
+#endif
 }
 
 void sensorsMpu6050Hmc5883lMs5611WaitDataReady(void)
 {
     xSemaphoreTake(dataReady, portMAX_DELAY);
+#ifdef CONFIG_MPU6050_FIFO
+    // Each release is for one FIFO sample, the stabilizer gets its timestamp
+    xQueueReceive(timestampQueue, &sensorData.interruptTimestamp, 0);
+#endif
+}
+
+#ifdef CONFIG_MPU6050_FIFO
+/**
+ * Queues a processed acc and gyro sample and releases the stabilizer for it.
+ * When the stabilizer is behind the oldest sample is dropped instead, its
+ * release already counted.
+ */
+static void sensorsQueueImuSample(uint64_t timestamp)
+{
+    timedAxis3f_t acc = {.axis = sensorData.acc, .timestamp = timestamp};
+    timedAxis3f_t gyro = {.axis = sensorData.gyro, .timestamp = timestamp};
+
+    if (uxQueueSpacesAvailable(gyroDataQueue) == 0) {
+        timedAxis3f_t dropped;
+        uint64_t droppedTimestamp;
+        xQueueReceive(accelerometerDataQueue, &dropped, 0);
+        xQueueReceive(gyroDataQueue, &dropped, 0);
+        xQueueReceive(timestampQueue, &droppedTimestamp, 0);
+        xQueueSend(accelerometerDataQueue, &acc, 0);
+        xQueueSend(gyroDataQueue, &gyro, 0);
+        xQueueSend(timestampQueue, &timestamp, 0);
+        return;
+    }
+
+    xQueueSend(accelerometerDataQueue, &acc, 0);
+    xQueueSend(gyroDataQueue, &gyro, 0);
+    xQueueSend(timestampQueue, &timestamp, 0);
+    xSemaphoreGive(dataReady);
+}
+
+/**
+ * Reads the samples stored in the MPU6050 FIFO since the last call in one
+ * burst and feeds them one by one to the filters and the stabilizer. Their
+ * timestamps are derived from the output rate, the newest sample being
+ * taken at most one period before the FIFO count is read.
+ */
+static void sensorsReadFifo(void)
+{
+    uint8_t countBuffer[2];
+    uint64_t readTimestamp = usecTimestamp();
+
+    if (!i2cdevReadReg8(I2C0_DEV, MPU6050_ADDRESS_AD0_LOW, MPU6050_RA_FIFO_COUNTH, 2, countBuffer)) {
+        return;
+    }
+
+    uint16_t count = (((uint16_t)countBuffer[0]) << 8) | countBuffer[1];
+
+    // Samples are only read whole, so the FIFO stays aligned on them until it
+    // overflows: the oldest bytes are then dropped, 1024 not being a multiple of 14
+    if (count > SENSORS_FIFO_SIZE - SENSORS_MPU6050_BUFF_LEN) {
+        mpu6050ResetFIFO();
+        fifoResets++;
+        return;
+    }
+
+    uint16_t available = count / SENSORS_MPU6050_BUFF_LEN;
+    uint16_t samples = available < SENSORS_FIFO_MAX_SAMPLES ? available : SENSORS_FIFO_MAX_SAMPLES;
+
+    if (samples == 0) {
+        return;
+    }
+
+    if (!i2cdevReadReg8(I2C0_DEV, MPU6050_ADDRESS_AD0_LOW, MPU6050_RA_FIFO_R_W,
+                        samples * SENSORS_MPU6050_BUFF_LEN, fifoBuffer)) {
+        // Part of the burst may have been read, the alignment is lost
+        mpu6050ResetFIFO();
+        fifoResets++;
+        return;
+    }
+
+    fifoSamples = samples;
+
+    for (uint16_t i = 0; i < samples; i++) {
+        processAccGyroMeasurements(&fifoBuffer[i * SENSORS_MPU6050_BUFF_LEN]);
+        sensorsQueueImuSample(readTimestamp - (uint64_t)(available - 1 - i) * SENSORS_FIFO_SAMPLE_PERIOD_US);
+    }
+
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+    sensorsRunBusSlots(readTimestamp + SENSORS_FIFO_BATCH * SENSORS_FIFO_SAMPLE_PERIOD_US);
+#else
+    // The slaves are not in the FIFO, their latest data is read once per batch
+    uint8_t slaveLen = (uint8_t)((isMagnetometerPresent ? SENSORS_MAG_BUFF_LEN : 0) +
+                                 (isBarometerPresent ? SENSORS_BARO_BUFF_LEN : 0));
+
+    if (slaveLen > 0 &&
+            i2cdevReadReg8(I2C0_DEV, MPU6050_ADDRESS_AD0_LOW, MPU6050_RA_EXT_SENS_DATA_00, slaveLen, buffer)) {
+        if (isMagnetometerPresent) {
+            processMagnetometerMeasurements(&(buffer[0]));
+            sensorsOverwriteAxis(magnetometerDataQueue, &sensorData.mag, readTimestamp);
+        }
+
+        if (isBarometerPresent) {
+            processBarometerMeasurements(&(buffer[isMagnetometerPresent ? SENSORS_MAG_BUFF_LEN : 0]));
+            sensorsOverwriteBaro(&sensorData.baro, readTimestamp);
+        }
+    }
+#endif
+}
+#endif
+
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+/*
+ * The mag and baro are read by the sensors task itself, in the bus idle time
+ * between the end of an IMU read and the next one. Each job follows the
+ * duration of its transfers, rising at once to a longer one and decaying
+ * slowly, and only starts when that duration fits before the next read.
+ * A job that does not fit waits for the idle time after the next IMU read.
+ */
+typedef struct {
+    void (*run)(uint64_t now);
+    const bool *present;
+    uint32_t periodUs;
+    uint32_t costUs;
+    uint64_t nextRun;
+} busSlotJob_t;
+
+#ifdef SENSORS_ENABLE_MAG_HM5883L
+static void sensorsMagSlot(uint64_t now)
+{
+    uint8_t magBuffer[SENSORS_MAG_BUFF_LEN];
+
+    // Same registers as the slave read: mode, x, z, y, status
+    if (i2cdevReadReg8(I2C0_DEV, HMC5883L_ADDRESS, HMC5883L_RA_MODE, SENSORS_MAG_BUFF_LEN, magBuffer)) {
+        processMagnetometerMeasurements(magBuffer);
+        sensorsOverwriteAxis(magnetometerDataQueue, &sensorData.mag, now);
+    }
 }
+#endif
+
+#ifdef SENSORS_ENABLE_PRESSURE_MS5611
+static void sensorsBaroSlot(uint64_t now)
+{
+    ms5611ConversionStep(&sensorData.baro.pressure, &sensorData.baro.temperature, &sensorData.baro.asl);
+    sensorsOverwriteBaro(&sensorData.baro, now);
+}
+#endif
+
+static busSlotJob_t busSlotJobs[] = {
+#ifdef SENSORS_ENABLE_MAG_HM5883L
+    {.run = sensorsMagSlot, .present = &isMagnetometerPresent, .periodUs = SENSORS_MAG_SLOT_PERIOD_US, .costUs = SENSORS_MAG_SLOT_COST_US},
+#endif
+#ifdef SENSORS_ENABLE_PRESSURE_MS5611
+    {.run = sensorsBaroSlot, .present = &isBarometerPresent, .periodUs = MS5611_CONVERSION_TIME_US, .costUs = SENSORS_BARO_SLOT_COST_US},
+#endif
+};
+#define BUS_SLOT_JOBS (sizeof(busSlotJobs) / sizeof(busSlotJobs[0]))
+
+static uint16_t busSlotDeferred;
+static uint16_t busSlotOverruns;
+
+/**
+ * Runs the due jobs that fit before the deadline, the time of the next IMU read.
+ */
+static void sensorsRunBusSlots(uint64_t deadline)
+{
+    for (int i = 0; i < (int)BUS_SLOT_JOBS; i++) {
+        busSlotJob_t *job = &busSlotJobs[i];
+        uint64_t start = usecTimestamp();
+
+        if (start < job->nextRun || !*job->present) {
+            continue;
+        }
+
+        if (start + job->costUs + SENSORS_BUS_SLOT_GUARD_US > deadline) {
+            busSlotDeferred++;
+            continue;
+        }
+
+        job->run(start);
+
+        uint64_t end = usecTimestamp();
+        uint32_t cost = (uint32_t)(end - start);
+        if (cost > job->costUs) {
+            job->costUs = cost < SENSORS_BUS_SLOT_MAX_COST_US ? cost : SENSORS_BUS_SLOT_MAX_COST_US;
+        } else {
+            job->costUs -= (job->costUs - cost) / 16;
+        }
+        if (end + SENSORS_BUS_SLOT_GUARD_US > deadline) {
+            busSlotOverruns++;
+        }
+
+        // Keep the period, unless the job is already more than a period late
+        job->nextRun = start - job->nextRun < job->periodUs ? job->nextRun + job->periodUs : start + job->periodUs;
+    }
+}
+#endif
 
 void processBarometerMeasurements(const uint8_t *buffer)
 {
@@ -383,7 +754,10 @@ void processAccGyroMeasurements(const uint8_t *buffer)
     sensorData.gyro.y = (gyroRaw.y - gyroBias.y) * SENSORS_DEG_PER_LSB_CFG;
     sensorData.gyro.z = (gyroRaw.z - gyroBias.z) * SENSORS_DEG_PER_LSB_CFG;
     /* sensors step 2.5 low pass filter */
-    applyAxis3fLpf((lpf2pData *)(&gyroLpf), &sensorData.gyro);
+#ifdef CONFIG_DYNAMIC_NOTCH
+    dynamicNotchApply(&sensorData.gyro);
+#endif
+    lpf2pBankApply(&gyroLpf, sensorData.gyro.axis);
 
 #ifdef CONFIG_TARGET_ESPLANE_V1
     accScaled.x = (accelRaw.x) * SENSORS_G_PER_LSB_CFG / accScale;
@@ -396,7 +770,7 @@ void processAccGyroMeasurements(const uint8_t *buffer)
 
     /* sensors step 2.6 Compensate for a miss-aligned accelerometer. */
     sensorsAccAlignToGravity(&accScaled, &sensorData.acc);
-    applyAxis3fLpf((lpf2pData *)(&accLpf), &sensorData.acc);
+    lpf2pBankApply(&accLpf, sensorData.acc.axis);
 }
 static void sensorsDeviceInit(void)
 {
@@ -458,18 +832,14 @@ static void sensorsDeviceInit(void)
     mpu6050SetRate(0);
     mpu6050SetDLPFMode(MPU6050_DLPF_BW_42);
     // Init second order filer for accelerometer
-    for (uint8_t i = 0; i < 3; i++) {
-        lpf2pInit(&gyroLpf[i], 1000, GYRO_LPF_CUTOFF_FREQ);
-        lpf2pInit(&accLpf[i], 1000, ACCEL_LPF_CUTOFF_FREQ);
-    }
+    lpf2pBankInit(&gyroLpf, 3, 1000, GYRO_LPF_CUTOFF_FREQ);
+    lpf2pBankInit(&accLpf, 3, 1000, ACCEL_LPF_CUTOFF_FREQ);
 #else
     mpu6050SetRate(0);
     mpu6050SetDLPFMode(MPU6050_DLPF_BW_98);
     // Init second order filer for accelerometer
-    for (uint8_t i = 0; i < 3; i++) {
-        lpf2pInit(&gyroLpf[i], 1000, GYRO_LPF_CUTOFF_FREQ);
-        lpf2pInit(&accLpf[i], 1000, ACCEL_LPF_CUTOFF_FREQ);
-    }
+    lpf2pBankInit(&gyroLpf, 3, 1000, GYRO_LPF_CUTOFF_FREQ);
+    lpf2pBankInit(&accLpf, 3, 1000, ACCEL_LPF_CUTOFF_FREQ);
 #endif
 
 #ifdef SENSORS_ENABLE_MAG_HM5883L
@@ -485,9 +855,15 @@ static void sensorsDeviceInit(void)
 
 #endif
 #ifdef SENSORS_ENABLE_PRESSURE_MS5611
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+    if (ms5611Init(I2C0_DEV)) {
+        // The first bus slot reads a temperature
+        ms5611StartConversion(MS5611_D2 + MS5611_OSR_DEFAULT);
+#else
     ms5611Init(I2C0_DEV);
 
     if (false) {
+#endif
         isBarometerPresent = true;
         DEBUG_PRINTI("MS5611 I2C connection [OK].\n");
     } else {
@@ -562,12 +938,18 @@ static void sensorsSetupSlaveRead(void)
     mpu6050SetSlave4MasterDelay(9); // read slaves at 100Hz = (500Hz / (1 + 4))
 #endif
 
+#ifndef CONFIG_SENSORS_BUS_SLOTS
     mpu6050SetI2CBypassEnabled(false);
     mpu6050SetWaitForExternalSensorEnabled(true);     // the slave data isn't so important for the state estimation
+#endif
     mpu6050SetInterruptMode(0);                       // active high
     mpu6050SetInterruptDrive(0);                      // push pull
     mpu6050SetInterruptLatch(0);                      // latched until clear
     mpu6050SetInterruptLatchClear(1);                 // cleared on any register read
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+    // The mag and baro stay on the main bus through the bypass, they are
+    // read by the sensors task between the IMU reads
+#else
     mpu6050SetSlaveReadWriteTransitionEnabled(false); // Send a stop at the end of a slave read
     mpu6050SetMasterClockSpeed(13);                   // Set i2c speed to 400kHz
 
@@ -609,8 +991,20 @@ static void sensorsSetupSlaveRead(void)
 
     // Enable sensors after configuration
     mpu6050SetI2CMasterModeEnabled(true);
-
+#endif // CONFIG_SENSORS_BUS_SLOTS
+
+#ifdef CONFIG_MPU6050_FIFO
+    // Samples are polled from the FIFO, in register order: acc, temperature, gyro
+    mpu6050SetAccelFIFOEnabled(true);
+    mpu6050SetTempFIFOEnabled(true);
+    mpu6050SetXGyroFIFOEnabled(true);
+    mpu6050SetYGyroFIFOEnabled(true);
+    mpu6050SetZGyroFIFOEnabled(true);
+    mpu6050ResetFIFO();
+    mpu6050SetFIFOEnabled(true);
+#else
     mpu6050SetIntDataReadyEnabled(true);
+#endif
 
     DEBUG_PRINTD("sensorsSetupSlaveRead done \n");
 }
@@ -621,8 +1015,14 @@ static void sensorsTaskInit(void)
   gyroDataQueue = STATIC_MEM_QUEUE_CREATE(gyroDataQueue);
   magnetometerDataQueue = STATIC_MEM_QUEUE_CREATE(magnetometerDataQueue);
   barometerDataQueue = STATIC_MEM_QUEUE_CREATE(barometerDataQueue);
+#ifdef CONFIG_MPU6050_FIFO
+  timestampQueue = STATIC_MEM_QUEUE_CREATE(timestampQueue);
+#endif
 
-  STATIC_MEM_TASK_CREATE(sensorsTask, sensorsTask, SENSORS_TASK_NAME, NULL, SENSORS_TASK_PRI);
+#ifdef CONFIG_DYNAMIC_NOTCH
+  dynamicNotchInit(1000);
+#endif
+  STATIC_MEM_TASK_CREATE_PINNED(sensorsTask, sensorsTask, SENSORS_TASK_NAME, NULL, SENSORS_TASK_PRI, SENSORS_TASK_CORE);
   DEBUG_PRINTD("xTaskCreate sensorsTask \n");
 }
 
@@ -657,8 +1057,13 @@ static void sensorsInterruptInit(void)
         //enable pull-up mode
         .pull_up_en = 1,
     };
-    sensorsDataReady = xSemaphoreCreateBinary();
-    dataReady = xSemaphoreCreateBinary();
+    sensorsDataReady = STATIC_MEM_BINARY_SEMAPHORE_CREATE(sensorsDataReady);
+#ifdef CONFIG_MPU6050_FIFO
+    // Given once per FIFO sample, the data ready interrupt stays disabled
+    dataReady = STATIC_MEM_COUNTING_SEMAPHORE_CREATE(dataReady, SENSORS_IMU_QUEUE_LEN, 0);
+#else
+    dataReady = STATIC_MEM_BINARY_SEMAPHORE_CREATE(dataReady);
+#endif
     gpio_config(&io_conf);
     //install gpio isr service
     //portDISABLE_INTERRUPTS();
@@ -680,6 +1085,9 @@ void sensorsMpu6050Hmc5883lMs5611Init(void)
     }
 
     sensorsBiasObjInit(&gyroBiasRunning);
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+    sensorsLoadStoredBias();
+#endif
     sensorsDeviceInit();
     sensorsInterruptInit();
     sensorsTaskInit();
@@ -749,6 +1157,9 @@ static bool processAccScale(int16_t ax, int16_t ay, int16_t az)
         if (accScaleSumCount == SENSORS_ACC_SCALE_SAMPLES) {
             accScale = accScaleSum / SENSORS_ACC_SCALE_SAMPLES;
             accBiasFound = true;
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+            sensorsScheduleBiasStore();
+#endif
         }
     }
 
@@ -807,7 +1218,15 @@ static bool processGyroBias(int16_t gx, int16_t gy, int16_t gz, Axis3f *gyroBias
     sensorsAddBiasValue(&gyroBiasRunning, gx, gy, gz);
 
     if (!gyroBiasRunning.isBiasValueFound) {
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+        if (sensorsVerifyStoredBias(&gyroBiasRunning)) {
+            gyroBiasSource = 1;
+        } else if (sensorsFindBiasValue(&gyroBiasRunning)) {
+            gyroBiasSource = 2;
+        }
+#else
         sensorsFindBiasValue(&gyroBiasRunning);
+#endif
 
         if (gyroBiasRunning.isBiasValueFound) {
             //TODO:
@@ -816,6 +1235,11 @@ static bool processGyroBias(int16_t gx, int16_t gy, int16_t gz, Axis3f *gyroBias
             DEBUG_PRINTI("isBiasValueFound!");
         }
     }
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+    else {
+        sensorsRefineBiasValue(&gyroBiasRunning);
+    }
+#endif
 
     gyroBiasOut->x = gyroBiasRunning.bias.x;
     gyroBiasOut->y = gyroBiasRunning.bias.y;
@@ -832,30 +1256,33 @@ static void sensorsBiasObjInit(BiasObj *bias)
 }
 
 /**
- * Calculates the variance and mean for the bias buffer.
+ * Calculates the variance and mean of the last nbrOfSamples values of the bias buffer.
+ * The variance is not divided by the number of samples, as the thresholds expect.
  */
-static void sensorsCalculateVarianceAndMean(BiasObj *bias, Axis3f *varOut, Axis3f *meanOut)
+static void sensorsCalculateVarianceAndMean(BiasObj *bias, uint32_t nbrOfSamples, Axis3f *varOut, Axis3f *meanOut)
 {
     uint32_t i;
     int64_t sum[GYRO_NBR_OF_AXES] = {0};
     int64_t sumSq[GYRO_NBR_OF_AXES] = {0};
-
-    for (i = 0; i < SENSORS_NBR_OF_BIAS_SAMPLES; i++) {
-        sum[0] += bias->buffer[i].x;
-        sum[1] += bias->buffer[i].y;
-        sum[2] += bias->buffer[i].z;
-        sumSq[0] += bias->buffer[i].x * bias->buffer[i].x;
-        sumSq[1] += bias->buffer[i].y * bias->buffer[i].y;
-        sumSq[2] += bias->buffer[i].z * bias->buffer[i].z;
+    uint32_t index = bias->bufHead - bias->buffer;
+
+    for (i = 0; i < nbrOfSamples; i++) {
+        index = (index == 0 ? SENSORS_NBR_OF_BIAS_SAMPLES : index) - 1;
+        sum[0] += bias->buffer[index].x;
+        sum[1] += bias->buffer[index].y;
+        sum[2] += bias->buffer[index].z;
+        sumSq[0] += bias->buffer[index].x * bias->buffer[index].x;
+        sumSq[1] += bias->buffer[index].y * bias->buffer[index].y;
+        sumSq[2] += bias->buffer[index].z * bias->buffer[index].z;
     }
 
-    varOut->x = (sumSq[0] - ((int64_t)sum[0] * sum[0]) / SENSORS_NBR_OF_BIAS_SAMPLES);
-    varOut->y = (sumSq[1] - ((int64_t)sum[1] * sum[1]) / SENSORS_NBR_OF_BIAS_SAMPLES);
-    varOut->z = (sumSq[2] - ((int64_t)sum[2] * sum[2]) / SENSORS_NBR_OF_BIAS_SAMPLES);
+    varOut->x = (sumSq[0] - ((int64_t)sum[0] * sum[0]) / nbrOfSamples);
+    varOut->y = (sumSq[1] - ((int64_t)sum[1] * sum[1]) / nbrOfSamples);
+    varOut->z = (sumSq[2] - ((int64_t)sum[2] * sum[2]) / nbrOfSamples);
 
-    meanOut->x = (float)sum[0] / SENSORS_NBR_OF_BIAS_SAMPLES;
-    meanOut->y = (float)sum[1] / SENSORS_NBR_OF_BIAS_SAMPLES;
-    meanOut->z = (float)sum[2] / SENSORS_NBR_OF_BIAS_SAMPLES;
+    meanOut->x = (float)sum[0] / nbrOfSamples;
+    meanOut->y = (float)sum[1] / nbrOfSamples;
+    meanOut->z = (float)sum[2] / nbrOfSamples;
 }
 
 /**
@@ -905,7 +1332,7 @@ static bool sensorsFindBiasValue(BiasObj *bias)
     bool foundBias = false;
 
     if (bias->isBufferFilled) {
-        sensorsCalculateVarianceAndMean(bias, &bias->variance, &bias->mean);
+        sensorsCalculateVarianceAndMean(bias, SENSORS_NBR_OF_BIAS_SAMPLES, &bias->variance, &bias->mean);
 
         if (bias->variance.x < GYRO_VARIANCE_THRESHOLD_X &&
                 bias->variance.y < GYRO_VARIANCE_THRESHOLD_Y &&
@@ -923,6 +1350,117 @@ static bool sensorsFindBiasValue(BiasObj *bias)
     return foundBias;
 }
 
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+static void sensorsLoadStoredBias(void)
+{
+    isStoredBiasValid = storageFetch(SENSORS_BIAS_STORAGE_KEY, &storedBias, sizeof(storedBias)) == sizeof(storedBias) &&
+                        isfinite(storedBias.gyroBias.x) && isfinite(storedBias.gyroBias.y) &&
+                        isfinite(storedBias.gyroBias.z) && isfinite(storedBias.accScale) &&
+                        storedBias.accScale > 0.5f && storedBias.accScale < 1.5f;
+
+    if (isStoredBiasValid) {
+        DEBUG_PRINTI("Stored gyro bias %.1f, %.1f, %.1f", (double)storedBias.gyroBias.x,
+                     (double)storedBias.gyroBias.y, (double)storedBias.gyroBias.z);
+    }
+}
+
+/**
+ * Takes the stored bias when the last SENSORS_BIAS_VERIFY_SAMPLES values are still and
+ * their mean is within SENSORS_BIAS_VERIFY_TOLERANCE of it. Checked once per window
+ * until the bias is found, by this or by the full buffer search.
+ */
+static bool sensorsVerifyStoredBias(BiasObj *bias)
+{
+    static uint32_t sampleCount;
+    Axis3f variance;
+    Axis3f mean;
+
+    if (!isStoredBiasValid || ++sampleCount % SENSORS_BIAS_VERIFY_SAMPLES != 0) {
+        return false;
+    }
+
+    sensorsCalculateVarianceAndMean(bias, SENSORS_BIAS_VERIFY_SAMPLES, &variance, &mean);
+
+    // The thresholds are for a full buffer
+    const float scale = (float)SENSORS_BIAS_VERIFY_SAMPLES / SENSORS_NBR_OF_BIAS_SAMPLES;
+    if (variance.x < GYRO_VARIANCE_THRESHOLD_X * scale &&
+            variance.y < GYRO_VARIANCE_THRESHOLD_Y * scale &&
+            variance.z < GYRO_VARIANCE_THRESHOLD_Z * scale &&
+            fabsf(mean.x - storedBias.gyroBias.x) < SENSORS_BIAS_VERIFY_TOLERANCE &&
+            fabsf(mean.y - storedBias.gyroBias.y) < SENSORS_BIAS_VERIFY_TOLERANCE &&
+            fabsf(mean.z - storedBias.gyroBias.z) < SENSORS_BIAS_VERIFY_TOLERANCE) {
+        // The window mean is of the current temperature, the stored bias only vouches for it
+        bias->bias.x = mean.x;
+        bias->bias.y = mean.y;
+        bias->bias.z = mean.z;
+        bias->isBiasValueFound = true;
+        accScale = storedBias.accScale;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Moves the bias towards the buffer mean each time the buffer has been refilled
+ * while the platform is still, which follows the drift with temperature.
+ */
+static void sensorsRefineBiasValue(BiasObj *bias)
+{
+    if (bias->bufHead != bias->buffer) {
+        return;
+    }
+
+    sensorsCalculateVarianceAndMean(bias, SENSORS_NBR_OF_BIAS_SAMPLES, &bias->variance, &bias->mean);
+
+    if (bias->variance.x < GYRO_VARIANCE_THRESHOLD_X &&
+            bias->variance.y < GYRO_VARIANCE_THRESHOLD_Y &&
+            bias->variance.z < GYRO_VARIANCE_THRESHOLD_Z) {
+        bias->bias.x += SENSORS_BIAS_REFINE_GAIN * (bias->mean.x - bias->bias.x);
+        bias->bias.y += SENSORS_BIAS_REFINE_GAIN * (bias->mean.y - bias->bias.y);
+        bias->bias.z += SENSORS_BIAS_REFINE_GAIN * (bias->mean.z - bias->bias.z);
+        sensorsScheduleBiasStore();
+    }
+}
+
+static void sensorsStoreBiasWorker(void *arg)
+{
+    if (storageStore(SENSORS_BIAS_STORAGE_KEY, &biasToStore, sizeof(biasToStore))) {
+        storedBias = biasToStore;
+        isStoredBiasValid = true;
+    }
+    isBiasStoreScheduled = false;
+}
+
+/**
+ * Stores the bias and acc scale from the worker, if they have moved from the stored ones.
+ * Storage writes take too long for the sensors task.
+ */
+static void sensorsScheduleBiasStore(void)
+{
+    const float halfTolerance = SENSORS_BIAS_VERIFY_TOLERANCE / 2;
+
+    if (isBiasStoreScheduled || !gyroBiasRunning.isBiasValueFound) {
+        return;
+    }
+
+    if (isStoredBiasValid &&
+            fabsf(gyroBiasRunning.bias.x - storedBias.gyroBias.x) < halfTolerance &&
+            fabsf(gyroBiasRunning.bias.y - storedBias.gyroBias.y) < halfTolerance &&
+            fabsf(gyroBiasRunning.bias.z - storedBias.gyroBias.z) < halfTolerance &&
+            fabsf(accScale - storedBias.accScale) < SENSORS_ACC_SCALE_TOLERANCE) {
+        return;
+    }
+
+    biasToStore.gyroBias = gyroBiasRunning.bias;
+    biasToStore.accScale = accScale;
+    isBiasStoreScheduled = true;
+    if (workerSchedulePriority(sensorsStoreBiasWorker, NULL, workerPriorityLow) != 0) {
+        isBiasStoreScheduled = false;
+    }
+}
+#endif
+
 bool sensorsMpu6050Hmc5883lMs5611ManufacturingTest(void)
 {
     bool testStatus = false;
@@ -1008,36 +1546,22 @@ void sensorsMpu6050Hmc5883lMs5611SetAccMode(accModes accMode)
     case ACC_MODE_PROPTEST:
         mpu6050SetRate(7);
         mpu6050SetDLPFMode(MPU6050_DLPF_BW_256);
-        for (uint8_t i = 0; i < 3; i++)
-        {
-            lpf2pInit(&accLpf[i], 1000, 250);
-        }
+        lpf2pBankInit(&accLpf, 3, 1000, 250);
         break;
     case ACC_MODE_FLIGHT:
     default:
         mpu6050SetRate(0);
 #ifdef CONFIG_TARGET_ESP32_S2_DRONE_V1_2
         mpu6050SetDLPFMode(MPU6050_DLPF_BW_42);
-        for (uint8_t i = 0; i < 3; i++) {
-        lpf2pInit(&accLpf[i], 1000, ACCEL_LPF_CUTOFF_FREQ);
-        }
+        lpf2pBankInit(&accLpf, 3, 1000, ACCEL_LPF_CUTOFF_FREQ);
 #else
         mpu6050SetDLPFMode(MPU6050_DLPF_BW_98);
-        for (uint8_t i = 0; i < 3; i++) {
-        lpf2pInit(&accLpf[i], 1000, ACCEL_LPF_CUTOFF_FREQ);
-        }
+        lpf2pBankInit(&accLpf, 3, 1000, ACCEL_LPF_CUTOFF_FREQ);
 #endif
         break;
     }
 }
 
-static void applyAxis3fLpf(lpf2pData *data, Axis3f *in)
-{
-    for (uint8_t i = 0; i < 3; i++) {
-        in->axis[i] = lpf2pApply(&data[i], in->axis[i]);
-    }
-}
-
 #ifdef GYRO_ADD_RAW_AND_VARIANCE_LOG_VALUES
 LOG_GROUP_START(gyro)
 LOG_ADD(LOG_INT16, xRaw, &gyroRaw.x)
@@ -1049,6 +1573,36 @@ LOG_ADD(LOG_FLOAT, zVariance, &gyroBiasRunning.variance.z)
 LOG_GROUP_STOP(gyro)
 #endif
 
+#ifdef CONFIG_MPU6050_FIFO
+LOG_GROUP_START(mpuFifo)
+LOG_ADD(LOG_UINT16, samples, &fifoSamples)
+LOG_ADD(LOG_UINT16, resets, &fifoResets)
+LOG_GROUP_STOP(mpuFifo)
+#endif
+
+#ifdef CONFIG_SENSORS_BUS_SLOTS
+/**
+ * Mag and baro transfers postponed to the next IMU idle time, and the ones
+ * that ended inside the guard time before the next IMU read
+ */
+LOG_GROUP_START(busSlot)
+LOG_ADD(LOG_UINT16, deferred, &busSlotDeferred)
+LOG_ADD(LOG_UINT16, overruns, &busSlotOverruns)
+LOG_GROUP_STOP(busSlot)
+#endif
+
+#ifdef CONFIG_SENSORS_STORE_GYRO_BIAS
+/**
+ * Gyro bias in LSB, and where it came from: 0 not found yet, 1 storage, 2 full search
+ */
+LOG_GROUP_START(gyroBias)
+LOG_ADD(LOG_UINT8, source, &gyroBiasSource)
+LOG_ADD(LOG_FLOAT, x, &gyroBiasRunning.bias.x)
+LOG_ADD(LOG_FLOAT, y, &gyroBiasRunning.bias.y)
+LOG_ADD(LOG_FLOAT, z, &gyroBiasRunning.bias.z)
+LOG_GROUP_STOP(gyroBias)
+#endif
+
 //TODO:
 PARAM_GROUP_START(imu_sensors)
 PARAM_ADD(PARAM_UINT8 | PARAM_RONLY, HMC5883L, &isMagnetometerPresent)
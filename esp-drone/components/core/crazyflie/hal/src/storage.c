@@ -30,18 +30,29 @@
 
 #include "kve/kve.h"
 
+#include <string.h>
+
 #include "FreeRTOS.h"
 #include "semphr.h"
-
+#include "timers.h"
+
+#include "config.h"
+#include "static_mem.h"
+#include "system.h"
+#include "worker.h"
+#ifdef CONFIG_STORAGE_NVS
+#include "nvs.h"
+#else
 #include "i2cdev.h"
 #include "eeprom.h"
+#endif
 
 #define TRACE_MEMORY_ACCESS 0
 
 #if !TRACE_MEMORY_ACCESS
 #define DEBUG_MODULE "STORAGE"
 #endif
-#include "debug.h"
+#include "debug_cf.h"
 
 // Memory organization
 
@@ -52,7 +63,105 @@
 #define KVE_PARTITION_LENGTH (7*1024)
 
 static SemaphoreHandle_t storageMutex;
+STATIC_MEM_SEMAPHORE_ALLOC(storageMutex);
+
+// Key addresses of the table, so that fetches do not scan the memory
+static kveIndex_t kveIndex;
+
+/*
+ * Background defragmentation. A store that does not fit defragments the
+ * whole table at once, so the table is compacted ahead of time by the
+ * worker, a few items per second while the system is not armed. It only
+ * starts when the free space at the end runs low, and only for holes large
+ * enough to be worth moving the items, to not rewrite the table for nothing.
+ */
+#define DEFRAG_PERIOD M2T(1000)
+#define DEFRAG_FREE_THRESHOLD (KVE_PARTITION_LENGTH / 4)
+#define DEFRAG_HOLE_THRESHOLD (64)
+#define DEFRAG_STEP_LENGTH (256)
+
+static StaticTimer_t defragTimerBuffer;
+
+#ifdef CONFIG_STORAGE_NVS
+/*
+ * The ESP32 boards have no EEPROM. The kve table lives in a RAM mirror
+ * saved as a single NVS blob on every kve flush. Inside a batch the save is
+ * deferred to storageBatchEnd, so a burst of stores costs one flash write.
+ */
+#define STORAGE_NVS_NAMESPACE "storage"
+#define STORAGE_NVS_KEY "kve"
+
+static uint8_t mirror[KVE_PARTITION_LENGTH];
+static int batchDepth = 0;
+static bool dirty = false;
+
+static size_t readMirror(size_t address, void* data, size_t length)
+{
+  if (address + length > sizeof(mirror)) {
+    return 0;
+  }
+  memcpy(data, &mirror[address], length);
+  return length;
+}
+
+static size_t writeMirror(size_t address, const void* data, size_t length)
+{
+  if (address + length > sizeof(mirror)) {
+    return 0;
+  }
+  memcpy(&mirror[address], data, length);
+  dirty = true;
+  return length;
+}
+
+static void commitMirror(void)
+{
+  nvs_handle_t handle;
+
+  if (nvs_open(STORAGE_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+    DEBUG_PRINT("Error: cannot open NVS!\n");
+    return;
+  }
+  if (nvs_set_blob(handle, STORAGE_NVS_KEY, mirror, sizeof(mirror)) == ESP_OK &&
+      nvs_commit(handle) == ESP_OK) {
+    dirty = false;
+  } else {
+    DEBUG_PRINT("Error: cannot save storage to NVS!\n");
+  }
+  nvs_close(handle);
+}
+
+static void flushMirror(void)
+{
+  if (batchDepth == 0 && dirty) {
+    commitMirror();
+  }
+}
+
+static void loadMirror(void)
+{
+  nvs_handle_t handle;
+  size_t length = sizeof(mirror);
+
+  // An erased mirror fails kveCheck and is formatted
+  memset(mirror, 0xff, sizeof(mirror));
+  if (nvs_open(STORAGE_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+    if (nvs_get_blob(handle, STORAGE_NVS_KEY, mirror, &length) != ESP_OK) {
+      memset(mirror, 0xff, sizeof(mirror));
+    }
+    nvs_close(handle);
+  }
+  dirty = false;
+}
 
+static kveMemory_t kve = {
+  .memorySize = KVE_PARTITION_LENGTH,
+  .read = readMirror,
+  .write = writeMirror,
+  .flush = flushMirror,
+  .index = &kveIndex,
+};
+#else
 static size_t readEeprom(size_t address, void* data, size_t length)
 {
   if (length == 0) {
@@ -113,7 +222,39 @@ static kveMemory_t kve = {
   .read = readEeprom,
   .write = writeEeprom,
   .flush = flushEeprom,
+  .index = &kveIndex,
 };
+#endif
+
+static void defragWorker(void *arg)
+{
+  size_t holeLength;
+  size_t freeLength;
+
+  xSemaphoreTake(storageMutex, portMAX_DELAY);
+#ifdef CONFIG_STORAGE_NVS
+  batchDepth++;
+#endif
+
+  kveGetSpace(&kve, &holeLength, &freeLength);
+  if (freeLength < DEFRAG_FREE_THRESHOLD && holeLength >= DEFRAG_HOLE_THRESHOLD) {
+    kveDefragStep(&kve, DEFRAG_STEP_LENGTH);
+  }
+
+#ifdef CONFIG_STORAGE_NVS
+  // One save of the mirror for the step
+  batchDepth--;
+  flushMirror();
+#endif
+  xSemaphoreGive(storageMutex);
+}
+
+static void defragTimer(xTimerHandle timer)
+{
+  if (!systemIsArmed()) {
+    workerSchedulePriority(defragWorker, NULL, workerPriorityLow);
+  }
+}
 
 // Public API
 
@@ -121,13 +262,34 @@ static bool isInit = false;
 
 void storageInit()
 {
-  storageMutex = xSemaphoreCreateMutex();
+  if (isInit) {
+    return;
+  }
+
+  storageMutex = STATIC_MEM_MUTEX_CREATE(storageMutex);
+#ifdef CONFIG_STORAGE_NVS
+  loadMirror();
+  // Checked here already since parameters are loaded before storageTest
+  if (!kveCheck(&kve)) {
+    DEBUG_PRINT("Formatting storage\n");
+    kveFormat(&kve);
+  }
+#endif
+
+  xTimerHandle timer = xTimerCreateStatic("storageDefragTimer", DEFRAG_PERIOD, pdTRUE, NULL, defragTimer, &defragTimerBuffer);
+  xTimerStart(timer, 100);
 
   isInit = true;
 }
 
 bool storageTest()
 {
+  if (!isInit) {
+    return false;
+  }
+
+  xSemaphoreTake(storageMutex, portMAX_DELAY);
+
   bool pass = kveCheck(&kve);
 
   DEBUG_PRINT("Storage check %s.\n", pass?"[OK]":"[FAIL]");
@@ -145,6 +307,8 @@ bool storageTest()
     }
   }
 
+  xSemaphoreGive(storageMutex);
+
   return pass;
 }
 
@@ -155,9 +319,17 @@ bool storageStore(char* key, const void* buffer, size_t length)
   }
 
   xSemaphoreTake(storageMutex, portMAX_DELAY);
+#ifdef CONFIG_STORAGE_NVS
+  // One save of the mirror, also when the store defragments the table
+  batchDepth++;
+#endif
 
   bool result = kveStore(&kve, key, buffer, length);
 
+#ifdef CONFIG_STORAGE_NVS
+  batchDepth--;
+  flushMirror();
+#endif
   xSemaphoreGive(storageMutex);
 
   return result;
@@ -192,3 +364,32 @@ bool storageDelete(char* key)
 
   return result;
 }
+
+void storageBatchBegin(void)
+{
+  if (!isInit) {
+    return;
+  }
+
+  xSemaphoreTake(storageMutex, portMAX_DELAY);
+#ifdef CONFIG_STORAGE_NVS
+  batchDepth++;
+#endif
+  xSemaphoreGive(storageMutex);
+}
+
+void storageBatchEnd(void)
+{
+  if (!isInit) {
+    return;
+  }
+
+  xSemaphoreTake(storageMutex, portMAX_DELAY);
+#ifdef CONFIG_STORAGE_NVS
+  if (batchDepth > 0) {
+    batchDepth--;
+  }
+  flushMirror();
+#endif
+  xSemaphoreGive(storageMutex);
+}
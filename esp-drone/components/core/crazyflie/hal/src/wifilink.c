@@ -37,8 +37,6 @@
 #include "pm_esplane.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
-#include "queuemonitor.h"
 #include "semphr.h"
 #include "stm32_legacy.h"
 
@@ -47,18 +45,21 @@
 #include "static_mem.h"
 
 #define WIFI_ACTIVITY_TIMEOUT_MS (1000)
+// Bulk packets waiting in the UDP TX queue at most: one being sent while the
+// next one is filled, the rest of the TX pool stays free for the telemetry
+#define WIFI_BULK_MAX_WAITING (2)
 
 static bool isInit = false;
-static xQueueHandle crtpPacketDelivery;
-STATIC_MEM_QUEUE_ALLOC(crtpPacketDelivery, 16, sizeof(CRTPPacket));
-static UDPPacket wifiIn;
 static uint32_t lastPacketTick;
 
 static int wifilinkSendPacket(CRTPPacket *p);
 static int wifilinkSetEnable(bool enable);
-static int wifilinkReceiveCRTPPacket(CRTPPacket *p);
+static uint8_t wifilinkGetMaxDataSize(void);
+static uint16_t wifilinkGetMaxBulkSize(void);
+static bool wifilinkSendBulkPacket(uint8_t header, const uint8_t *data, uint16_t size);
 
-STATIC_MEM_TASK_ALLOC(wifilinkTask, WIFILINK_TASK_STACKSIZE);
+_Static_assert(CRTP_MAX_DATA_SIZE + 1 <= WIFI_TX_PACKET_SIZE,
+               "CRTP packets must fit in a UDP TX packet");
 
 static bool wifilinkIsConnected(void)
 {
@@ -68,16 +69,19 @@ static bool wifilinkIsConnected(void)
 static struct crtpLinkOperations wifilinkOp = {
     .setEnable         = wifilinkSetEnable,
     .sendPacket        = wifilinkSendPacket,
-    .receivePacket     = wifilinkReceiveCRTPPacket,
+    .receivePacket     = NULL,  // Packets are dispatched from the UDP rx task
     .isConnected       = wifilinkIsConnected,
+    .getMaxDataSize    = wifilinkGetMaxDataSize,
+    .getMaxBulkSize    = wifilinkGetMaxBulkSize,
+    .sendBulkPacket    = wifilinkSendBulkPacket,
 };
 
 #ifdef CONFIG_ENABLE_LEGACY_APP
-static bool detectOldVersionApp(UDPPacket *in)
+static bool detectOldVersionApp(const uint8_t *data, uint16_t size)
 {
 
-    if ((in->data)[0] != 0x00 && in->size == 11) { //12-1
-        if ((in->data)[0] == 0x80 && (in->data)[9] == 0x00 && (in->data)[10] == 0x00 && (in->data)[11] == 0x00) {
+    if (data[0] != 0x00 && size == 11) { //12-1
+        if (data[0] == 0x80 && data[9] == 0x00 && data[10] == 0x00 && data[11] == 0x00) {
             return true;
         }
     }
@@ -86,81 +90,42 @@ static bool detectOldVersionApp(UDPPacket *in)
 }
 #endif
 
-static bool detectEspNow(UDPPacket *in)
+// Called by the UDP rx task for every CRTP packet: the one copy, from the
+// socket buffer to the CRTP port queue or straight to the port callback
+static void wifilinkReceive(const uint8_t *data, uint16_t size)
 {
-    if (in->size == 7 && (in->data)[0] == 'n' && (in->data)[1] == 'o' && (in->data)[2] == 'w') {
-        return true;
+    CRTPPacket p;
+    if (size == 0) {
+        return;
     }
-    return false;
-}
-
-static void wifilinkTask(void *param)
-{
-    CRTPPacket p = {0};
-    while (1) {
-        /* command step - receive  03 Fetch a wifi packet off the queue */
-        wifiGetDataBlocking(&wifiIn);
-        lastPacketTick = xTaskGetTickCount();
-        uint16_t sendWaitMs = 0;
+    lastPacketTick = xTaskGetTickCount();
 #ifdef CONFIG_ENABLE_LEGACY_APP
-        float rch, pch, ych;
-        uint16_t tch;
-        if (detectOldVersionApp(&wifiIn)) {
-            rch  = (1.0) * (float)(((((uint16_t)wifiIn.data[1] << 8) + (uint16_t)wifiIn.data[2]) - 296) * 15.0 / 150.0); //-15~+15
-            pch  = (-1.0) * (float)(((((uint16_t)wifiIn.data[3] << 8) + (uint16_t)wifiIn.data[4]) - 296) * 15.0 / 150.0); //-15~+15
-            tch  = (((uint16_t)wifiIn.data[5] << 8) + (uint16_t)wifiIn.data[6]) * 59000.0 / 600.0;
-            ych  = (float)(((((uint16_t)wifiIn.data[7] << 8) + (uint16_t)wifiIn.data[8]) - 296) * 15.0 / 150.0); //-15~+15
-            p.size = wifiIn.size - 1;
-            p.header = CRTP_HEADER(CRTP_PORT_SETPOINT, 0x00); //head redefine
-
-            memcpy(&p.data[0], &rch, 4);
-            memcpy(&p.data[4], &pch, 4);
-            memcpy(&p.data[8], &ych, 4);
-            memcpy(&p.data[12], &tch, 2);
-        } else
+    float rch, pch, ych;
+    uint16_t tch;
+    if (detectOldVersionApp(data, size)) {
+        rch  = (1.0) * (float)(((((uint16_t)data[1] << 8) + (uint16_t)data[2]) - 296) * 15.0 / 150.0); //-15~+15
+        pch  = (-1.0) * (float)(((((uint16_t)data[3] << 8) + (uint16_t)data[4]) - 296) * 15.0 / 150.0); //-15~+15
+        tch  = (((uint16_t)data[5] << 8) + (uint16_t)data[6]) * 59000.0 / 600.0;
+        ych  = (float)(((((uint16_t)data[7] << 8) + (uint16_t)data[8]) - 296) * 15.0 / 150.0); //-15~+15
+        p.size = size - 1;
+        p.header = CRTP_HEADER(CRTP_PORT_SETPOINT, 0x00); //head redefine
+
+        memcpy(&p.data[0], &rch, 4);
+        memcpy(&p.data[4], &pch, 4);
+        memcpy(&p.data[8], &ych, 4);
+        memcpy(&p.data[12], &tch, 2);
+    } else
 #endif
-        if (detectEspNow(&wifiIn)) {
-            float rch, pch, ych;
-            uint16_t tch;
-            rch  = (float)((int8_t)wifiIn.data[6] * 15.0 / 128);; //-15~+15
-            pch  = (float)((int8_t)wifiIn.data[5] * 15.0 / -128);; //-15~+15
-            if ((int8_t)wifiIn.data[4] < 0) {
-                tch  = 0;
-            } else {
-                tch  = (int8_t)wifiIn.data[4] * 59000.0 / 128;
-            }
-            ych  = (float)((int8_t)wifiIn.data[3] * 15.0 / 128); //-15~+15
-            p.size = wifiIn.size - 1;
-            p.header = CRTP_HEADER(CRTP_PORT_SETPOINT, 0x00); //head redefine
-
-            //printf("rch: %.2f, pch: %.2f, tch: %d, ych: %.2f\n", rch, pch, tch, ych);
-            memcpy(&p.data[0], &rch, 4);
-            memcpy(&p.data[4], &pch, 4);
-            memcpy(&p.data[8], &ych, 4);
-            memcpy(&p.data[12], &tch, 2);
-        } else
-        {
-            /* command step - receive  04 copy CRTP part from packet, the size not contain head */
-            p.size = wifiIn.size - 1;
-            ASSERT(p.size <= CRTP_MAX_DATA_SIZE);
-            memcpy(&p.raw, wifiIn.data, wifiIn.size);
-            sendWaitMs = 10;
-        }
-
-        /* command step - receive 05 send to crtpPacketDelivery queue */
-        xQueueSend(crtpPacketDelivery, &p, M2T(sendWaitMs));
+    {
+        /* command step - receive  03 copy CRTP part from packet, the size not contain head */
+        p.size = size - 1;
+        ASSERT(p.size <= CRTP_MAX_DATA_SIZE);
+        memcpy(&p.raw, data, size);
     }
 
-}
-
-static int wifilinkReceiveCRTPPacket(CRTPPacket *p)
-{
-    if (xQueueReceive(crtpPacketDelivery, p, M2T(100)) == pdTRUE) {
-        ledseqRun(&seq_linkUp);
-        return 0;
-    }
-
-    return -1;
+    ledseqRun(&seq_linkUp);
+    /* command step - receive  04 to the port queue or callback */
+    crtpDispatchPacket(&p);
 }
 
 static int wifilinkSendPacket(CRTPPacket *p)
@@ -175,6 +140,33 @@ static int wifilinkSetEnable(bool enable)
     return 0;
 }
 
+static uint8_t wifilinkGetMaxDataSize(void)
+{
+    return CRTP_MAX_DATA_SIZE;
+}
+
+// Bulk packets fill a whole UDP TX packet: header + data
+static uint16_t wifilinkGetMaxBulkSize(void)
+{
+    return WIFI_TX_PACKET_SIZE - 1;
+}
+
+static bool wifilinkSendBulkPacket(uint8_t header, const uint8_t *data, uint16_t size)
+{
+    if (wifiGetTxWaiting() >= WIFI_BULK_MAX_WAITING) {
+        return false;
+    }
+    UDPTxPacket *packet = wifiClaimTxPacket(0);
+    if (packet == NULL) {
+        return false;
+    }
+    packet->data[0] = header;
+    memcpy(&packet->data[1], data, size);
+    packet->size = size + 1;
+    ledseqRun(&seq_linkDown);
+    return wifiSendTxPacket(packet);
+}
+
 /*
  * Public functions
  */
@@ -185,10 +177,7 @@ void wifilinkInit()
         return;
     }
 
-    crtpPacketDelivery = STATIC_MEM_QUEUE_CREATE(crtpPacketDelivery);
-    DEBUG_QUEUE_MONITOR_REGISTER(crtpPacketDelivery);
-
-    STATIC_MEM_TASK_CREATE(wifilinkTask, wifilinkTask, WIFILINK_TASK_NAME,NULL, WIFILINK_TASK_PRI);
+    wifiSetRxHandler(wifilinkReceive);
 
     isInit = true;
 }
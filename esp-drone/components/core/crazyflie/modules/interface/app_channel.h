@@ -81,6 +81,38 @@ size_t appchannelReceivePacket(void* buffer, size_t max_length, int timeout_ms);
  */
 bool appchannelHasOverflowOccured();
 
+/**
+ * Write data to the app-channel stream
+ *
+ * The stream carries data larger than a packet to the ground, on its own platform
+ * channel and in the bulk TX queue, so it does not delay setpoints or platform replies.
+ * The data is cut in packets of up to crtpGetMaxDataSize() - 2 bytes, that is larger
+ * packets when the Wi-Fi link negotiated jumbo frames. Each packet starts with a
+ * little endian uint16 sequence number.
+ *
+ * The ground opens the stream with a window in packets and then grants credit as it
+ * receives them, as the sequence number the stream may send up to. The function blocks
+ * while there is no credit or while the TX queue is nearly full, so a fast app never
+ * overruns the ground nor starves the log.
+ *
+ * @param data Pointer to the data to be sent
+ * @param length Length of the data
+ * @param timeout_ms Time to wait for credit in millisecond, APPCHANNEL_WAIT_FOREVER
+ *                   to wait until everything is sent or the stream is closed.
+ * @return The number of bytes sent, less than length on timeout or if the stream is
+ *         not open.
+ *
+ * \app_api
+ */
+size_t appchannelStreamWrite(const void* data, size_t length, int timeout_ms);
+
+/**
+ * Returns if the ground has opened the app-channel stream
+ *
+ * \app_api
+ */
+bool appchannelStreamIsOpen();
+
 
 // Function declared bellow are private to the Crazyflie firmware and
 // should not be called from an app
@@ -94,3 +126,8 @@ void appchannelInit();
  * 
  */
 void appchannelIncomingPacket(CRTPPacket *p);
+
+/**
+ * Handles the stream credit packets from the ground
+ */
+void appchannelStreamIncomingPacket(CRTPPacket *p);
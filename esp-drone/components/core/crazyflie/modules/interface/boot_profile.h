@@ -0,0 +1,52 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * boot_profile.h - Time stamps of the boot phases
+ *
+ * Each phase is stamped the first time it completes, in ms since the start
+ * of the application. The stamps are printed once the system is up and
+ * available in the "boot" log group.
+ */
+
+#pragma once
+
+typedef enum {
+  bootPhaseSystemTask = 0, // System task running
+  bootPhaseWifiUp,         // Access point and UDP server up, runs in parallel
+  bootPhaseSystemInit,     // Base modules, storage, CRTP and debug output
+  bootPhaseComm,           // Link and CRTP services
+  bootPhaseFlight,         // Estimator, sensors and stabilizer
+  bootPhaseSelfTest,       // Module tests passed or failed
+  bootPhaseTelemetryReady, // Telemetry started
+  bootPhaseCount,
+} bootPhase_t;
+
+/**
+ * Stamp the completion of a phase. Only the first stamp of a phase is kept.
+ * Can be called from any task.
+ */
+void bootProfileMark(bootPhase_t phase);
+
+/**
+ * Print the stamps of the phases, and the duration of each one since the
+ * previous stamp.
+ */
+void bootProfilePrint(void);
@@ -82,6 +82,12 @@ typedef struct collision_avoidance_params_s
   // Using Dykstra's algorithm.
   int voronoiProjectionMaxIters;
 
+  // Max number of row projections, summed over the iterations, of one
+  // projection into our Voronoi cell. Bounds the computation time whatever
+  // the number of neighbors, at the cost of convergence in crowded cells.
+  // If not positive, only voronoiProjectionMaxIters applies.
+  int voronoiProjectionBudget;
+
 } collision_avoidance_params_t;
 
 
@@ -120,7 +126,9 @@ typedef struct collision_avoidance_state_s
 //   sensorData: Not currently used, but kept for API similarity with sitAw.
 //   state: Current state estimate.
 //
-void collisionAvoidanceUpdateSetpointCore(
+// Returns the number of neighbors close enough to bound our cell.
+//
+int collisionAvoidanceUpdateSetpointCore(
   collision_avoidance_params_t const *params,
   collision_avoidance_state_t *collisionState,
   int nOthers,
@@ -55,4 +55,11 @@ void commanderNotifySetpointsStop(int remainValidMillisecs);
 
 void commanderGetSetpoint(setpoint_t *setpoint, const state_t *state);
 
+/* Generation of the queued setpoint last read by commanderGetSetpoint(). It
+ * changes whenever a new setpoint is queued, so terms computed only from an
+ * unchanged queued setpoint can be kept. The setpoints of the high-level
+ * commander and of the watchdog timeouts are not tracked by it.
+ */
+uint32_t commanderGetSetpointGeneration(void);
+
 #endif /* COMMANDER_H_ */
@@ -31,7 +31,7 @@
 #include "eprintf.h"
 
 /**
- * Initialize the console
+ * Initialize the console and start the task draining its buffer to CRTP
  */
 void consoleInit(void);
 
@@ -42,6 +42,9 @@ bool consoleTest(void);
  *
  * @param ch character that shall be printed
  * @return The character casted to unsigned int or EOF in case of error
+ *
+ * @note Never blocks. When the buffer is full the character is dropped and
+ * counted, an "<overflowed N bytes>" line is sent in its place.
  */
 int consolePutchar(int ch);
 
@@ -51,9 +54,8 @@ int consolePutchar(int ch);
  * @param ch character that shall be printed
  * @return The character casted to unsigned int or EOF in case of error
  *
- * @note This version can be called by interrup. In such case the internal
- * buffer is going to be used. If a task currently is printing or if the
- * interrupts prints too much the data will be ignored.
+ * @note This version can be called by interrupt. It shares the buffer with
+ * the tasks, the characters are dropped when it is full.
  */
 int consolePutcharFromISR(int ch);
 
@@ -66,7 +68,8 @@ int consolePutcharFromISR(int ch);
 int consolePuts(char *str);
 
 /**
- * Flush the console buffer
+ * Flush the console buffer, the last line is sent even without new line.
+ * Returns without waiting for the data to be sent.
  */
 void consoleFlush(void);
 
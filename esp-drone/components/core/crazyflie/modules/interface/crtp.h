@@ -29,8 +29,16 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "sdkconfig.h"
 
-#define CRTP_MAX_DATA_SIZE 30
+// Payload size of the nRF radio, used until a link negotiates a larger one
+#define CRTP_LEGACY_DATA_SIZE 30
+
+#ifdef CONFIG_CRTP_MAX_DATA_SIZE
+#define CRTP_MAX_DATA_SIZE CONFIG_CRTP_MAX_DATA_SIZE
+#else
+#define CRTP_MAX_DATA_SIZE CRTP_LEGACY_DATA_SIZE
+#endif
 
 #define CRTP_HEADER(port, channel) (((port & 0x0F) << 4) | (channel & 0x0F))
 
@@ -102,6 +110,16 @@ void crtpInitTaskQueue(CRTPPort taskId);
  */
 void crtpRegisterPortCB(int port, CrtpCallback cb);
 
+/**
+ * Deliver a received packet to its port: the task queue of the port and the
+ * callback registered for it, as the CRTP RX task does with the packets of
+ * links that have a receivePacket operation. Links without one receive in a
+ * task of their own and call it directly, saving a queue hop.
+ *
+ * @param[in] p Received CRTPPacket, copied to the task queue of its port
+ */
+void crtpDispatchPacket(CRTPPacket *p);
+
 /**
  * Put a packet in the TX task
  *
@@ -140,12 +158,54 @@ int crtpReceivePacket(CRTPPort taskId, CRTPPacket *p);
 int crtpReceivePacketWait(CRTPPort taskId, CRTPPacket *p, int wait);
 
 /**
- * Get the number of free tx packets in the queue
+ * Get the number of free tx packets in the queue of the bulk (console/log)
+ * TX class
  *
  * @return Number of free packets
  */
 int crtpGetFreeTxQueuePackets(void);
 
+/**
+ * Get the largest payload a packet may currently carry. This is
+ * CRTP_LEGACY_DATA_SIZE until the client negotiates jumbo packets.
+ *
+ * @return Payload size in bytes, at most CRTP_MAX_DATA_SIZE
+ */
+uint8_t crtpGetMaxDataSize(void);
+
+/**
+ * Negotiate the payload size used for packets sent to the client.
+ * The size is capped to what the current link supports and goes back to
+ * CRTP_LEGACY_DATA_SIZE when the link changes.
+ *
+ * @param[in] size Payload size requested by the client
+ *
+ * @return Payload size granted
+ */
+uint8_t crtpSetMaxDataSize(uint8_t size);
+
+/**
+ * Get the largest payload of a bulk packet on the current link. Bulk packets
+ * are laid out as CRTP packets but sized to the link MTU, they are only sent
+ * to clients that asked for them (see the bulk reads of mem.c).
+ *
+ * @return Payload size in bytes, 0 if the link has no bulk packets
+ */
+uint16_t crtpGetMaxBulkSize(void);
+
+/**
+ * Send a bulk packet straight on the link, bypassing the TX queues.
+ * Does not block: the link refuses the packet while its previous bulk
+ * packets are still waiting to be sent.
+ *
+ * @param[in] header CRTP header of the packet
+ * @param[in] data   Payload
+ * @param[in] size   Payload size, at most crtpGetMaxBulkSize()
+ *
+ * @return true if the packet was queued by the link
+ */
+bool crtpSendBulkPacket(uint8_t header, const uint8_t *data, uint16_t size);
+
 /**
  * Wait for a packet to arrive for the specified taskID
  *
@@ -164,9 +224,12 @@ struct crtpLinkOperations
 {
   int (*setEnable)(bool enable);
   int (*sendPacket)(CRTPPacket *pk);
-  int (*receivePacket)(CRTPPacket *pk);
+  int (*receivePacket)(CRTPPacket *pk);  // NULL if the link calls crtpDispatchPacket()
   bool (*isConnected)(void);
   int (*reset)(void);
+  uint8_t (*getMaxDataSize)(void); //< Optional, CRTP_LEGACY_DATA_SIZE if not set
+  uint16_t (*getMaxBulkSize)(void); //< Optional, no bulk packets if not set
+  bool (*sendBulkPacket)(uint8_t header, const uint8_t *data, uint16_t size); //< Set with getMaxBulkSize
 };
 
 void crtpSetLink(struct crtpLinkOperations * lk);
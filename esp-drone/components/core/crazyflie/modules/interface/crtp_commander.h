@@ -40,6 +40,19 @@ typedef enum {
 void crtpCommanderInit(void);
 void crtpCommanderRpytDecodeSetpoint(setpoint_t *setpoint, CRTPPacket *pk);
 void crtpCommanderGenericDecodeSetpoint(setpoint_t *setpoint, CRTPPacket *pk);
+
+/**
+ * Sets a roll/pitch/yaw/thrust setpoint, as a legacy setpoint packet on the
+ * CRTP setpoint port would, without going through the CRTP queues. For links
+ * whose receive callback runs in task context, such as ESP-NOW, to get the
+ * stick input to the commander with no queue hop.
+ *
+ * @param roll Roll (in degrees).
+ * @param pitch Pitch (in degrees).
+ * @param yaw Yaw rate (in degrees per second).
+ * @param thrust Thrust, 0 to 65535.
+ */
+void crtpCommanderSetRpytSetpoint(float roll, float pitch, float yaw, uint16_t thrust);
 void setCommandermode(FlightMode mode);
 
 #endif /* CRTP_COMMANDER_H_ */
@@ -51,9 +51,18 @@ Header file for high-level commander that computes smooth setpoints based on hig
 typedef enum {
   CRTP_CHL_TRAJECTORY_TYPE_POLY4D = 0, // struct poly4d, see pptraj.h
   CRTP_CHL_TRAJECTORY_TYPE_POLY4D_COMPRESSED = 1, // see pptraj_compressed.h
+  CRTP_CHL_TRAJECTORY_TYPE_POLY4D_STREAM = 2, // ring of struct poly4d appended to while flown, see pptraj.h
   // Future types might include versions without yaw
 } crtpCommanderTrajectoryType_t;
 
+// Pieces of the coverage trajectories planned on board
+#define NUM_COVERAGE_PIECES 48
+
+typedef enum {
+  CRTP_CHL_COVERAGE_SPIRAL = 0, // archimedean spiral out from the current position
+  CRTP_CHL_COVERAGE_ZIGZAG = 1, // lanes along x, stepping along y
+} crtpCommanderCoveragePattern_t;
+
 /* Public functions */
 void crtpCommanderHighLevelInit(void);
 
@@ -179,6 +188,30 @@ bool crtpCommanderHighLevelIsTrajectoryDefined(uint8_t trajectoryId);
  */
 int crtpCommanderHighLevelStartTrajectory(const uint8_t trajectoryId, const float timeScale, const bool relative, const bool reversed);
 
+/**
+ * @brief Plans a coverage trajectory on board and starts it from the current
+ *        setpoint, at its height and yaw. It starts and ends at rest.
+ *
+ * @param pattern  the path to fly
+ * @param spacing  distance between the turns of the spiral, or the lanes of the zigzag (m)
+ * @param width    outer radius of the spiral, or length of the lanes of the zigzag (m)
+ * @param length   distance covered across the lanes of the zigzag, unused by the spiral (m)
+ * @param speed    speed along the path (m/s)
+ * @return zero if the command succeeded, an error code otherwise, also if
+ *         the trajectory needs more than NUM_COVERAGE_PIECES pieces
+ */
+int crtpCommanderHighLevelStartCoverage(const crtpCommanderCoveragePattern_t pattern, const float spacing, const float width, const float length, const float speed);
+
+/**
+ * @brief Limits the speed of the coverage trajectories. The running one is
+ *        slowed down or sped up from where it is, without a setpoint jump;
+ *        a coverage planned faster is flown at the limit.
+ *
+ * @param speed  largest speed along the path (m/s), 0 to lift the limit
+ * @return zero if the command succeeded, EINVAL for a negative speed
+ */
+int crtpCommanderHighLevelSetSpeedLimit(const float speed);
+
 /**
  * @brief Define a trajectory that has previously been uploaded to memory.
  *
@@ -190,6 +223,19 @@ int crtpCommanderHighLevelStartTrajectory(const uint8_t trajectoryId, const floa
  */
 int crtpCommanderHighLevelDefineTrajectory(const uint8_t trajectoryId, const crtpCommanderTrajectoryType_t type, const uint32_t offset, const uint8_t nPieces);
 
+/**
+ * @brief Append pieces to the ring of a streamed trajectory. The pieces must
+ *        have been written to the slots that follow the last piece appended,
+ *        wrapping around the ring. The slots of the pieces flown are free again.
+ *
+ * @param trajectoryId The id of the trajectory, defined as CRTP_CHL_TRAJECTORY_TYPE_POLY4D_STREAM
+ * @param nPieces      Nr of pieces to append
+ * @param last         true if no more pieces follow
+ * @return zero if the command succeeded, ENOMEM if the ring has not enough
+ *         free slots, an error code otherwise
+ */
+int crtpCommanderHighLevelAppendTrajectory(const uint8_t trajectoryId, const uint8_t nPieces, const bool last);
+
 /**
  * @brief Get the size of the allocated trajectory memory
  *
@@ -50,6 +50,27 @@ struct CrtpExtPose
   float qw;
 } __attribute__((packed));
 
+/**
+ * External position sample of the UDP fast path (see locSrvEnqueueExtSample)
+ */
+struct ExtPositionSample
+{
+  uint32_t timestamp; // sample time, low 32 bits of the drone clock (us), 0 if unknown
+  float x; // in m
+  float y; // in m
+  float z; // in m
+} __attribute__((packed));
+
+/**
+ * External pose sample of the UDP fast path, the position followed by the
+ * orientation compressed as in quatcompress.h
+ */
+struct ExtPoseSample
+{
+  struct ExtPositionSample position;
+  uint32_t quat;
+} __attribute__((packed));
+
 typedef enum
 {
   RANGE_STREAM_FLOAT      = 0,
@@ -68,6 +89,19 @@ typedef enum
 // Set up the callback for the CRTP_PORT_LOCALIZATION
 void locSrvInit(void);
 
+/**
+ * Enqueue an external position or pose sample into the state estimator
+ * straight from the link receiving it, without going through CRTP.
+ * Samples older than the locSrv.extMaxAge parameter are dropped.
+ *
+ * @param sample       ExtPositionSample or ExtPoseSample, told apart by size
+ * @param size         Sample size in bytes
+ * @param receiveTime  Time the sample was received (us since boot)
+ *
+ * @return false if size matches neither sample
+ */
+bool locSrvEnqueueExtSample(const void *sample, uint32_t size, uint64_t receiveTime);
+
 // Send range in float. After 5 ranges it will send the packet.
 void locSrvSendRangeFloat(uint8_t id, float range);
 //void locSrvSendLighthouseAngle(int basestation, pulseProcessorResult_t* angles);
@@ -0,0 +1,52 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * dsp_bench.h - Cycle counts of the dsp_lib kernels against plain C loops
+ *
+ * Test build option (CONFIG_DSP_BENCHMARK). The matrix, FFT and biquad
+ * kernels of dsp_lib are timed at the sizes of the firmware: the 9 state
+ * Kalman covariance, the 128 point dynamic notch spectrum and the 2-pole
+ * filters run per sample. Each kernel runs DSP_BENCH_RUNS times next to a
+ * plain C loop computing the same result, the minimum and mean cycle counts
+ * of both are printed on the console.
+ */
+
+#ifndef __DSP_BENCH_H__
+#define __DSP_BENCH_H__
+
+#define DSP_BENCH_RUNS 50
+
+#ifdef CONFIG_DSP_BENCHMARK
+/**
+ * Run the benchmark once from the worker, after the system started, then
+ * again each time the dspBench.run parameter is set.
+ */
+void dspBenchInit(void);
+
+/**
+ * Time all the kernels and print the results. Takes about a second.
+ */
+void dspBenchRun(void *arg);
+#else
+  #define dspBenchInit()
+#endif
+
+#endif /* __DSP_BENCH_H__ */
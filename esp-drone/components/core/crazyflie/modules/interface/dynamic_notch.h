@@ -0,0 +1,60 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * dynamic_notch.h - Gyro notch filters following the motor vibration peak
+ *
+ * The gyro samples entering the filter chain are collected in blocks of
+ * DYN_NOTCH_FFT_LEN per axis. A low priority task computes the spectrum of
+ * each block and tracks the strongest peak between the minHz and maxHz
+ * parameters, where the motor vibrations are. A notch per axis is moved to
+ * the tracked frequency by the sensors task, in front of the low pass filter.
+ */
+
+#ifndef __DYNAMIC_NOTCH_H__
+#define __DYNAMIC_NOTCH_H__
+
+#include <stdbool.h>
+
+#include "imu_types.h"
+
+#define DYN_NOTCH_FFT_LEN 128
+
+/**
+ * Create the spectrum task.
+ *
+ * @param sampleFreq Rate of the gyro samples given to dynamicNotchApply(), in Hz
+ */
+void dynamicNotchInit(float sampleFreq);
+
+/**
+ * @return true if the spectrum task is running
+ */
+bool dynamicNotchTest(void);
+
+/**
+ * Collect one gyro sample for the spectrum and filter it, in place, with the
+ * notches. Called by the sensors task at the sample rate.
+ *
+ * @param[in,out] gyro Gyro sample, deg/s
+ */
+void dynamicNotchApply(Axis3f *gyro);
+
+#endif /* __DYNAMIC_NOTCH_H__ */
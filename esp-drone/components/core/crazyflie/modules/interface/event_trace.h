@@ -0,0 +1,108 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * event_trace.h - Always-on tracing of the begin and end of task stages
+ *
+ * Each core records into its own ring of CONFIG_EVENT_TRACE_RECORDS
+ * records, the oldest ones are overwritten. The rings are downloaded
+ * through the MEM_TYPE_EVENT_TRACE memory:
+ *
+ *   0x00  'E' 'T' version number of cores
+ *   0x04  uint32 records per core
+ *   0x08  uint32 records written on core 0 since the last clear
+ *   0x0C  uint32 records written on core 1 since the last clear
+ *   0x10  ring of core 0, then ring of core 1. Record n of a core is at
+ *         index n % records per core, each record is
+ *           uint32 timestamp (us, low bits of usecTimestamp())
+ *           uint16 event id, EVENT_TRACE_END or EVENT_TRACE_MARK flagged
+ *           uint16 argument
+ *
+ * Any write to the memory clears the rings. Tracing, the trace.enable
+ * parameter, should be stopped before downloading, otherwise the oldest
+ * records are overwritten while being read. tools/event_trace converts a
+ * download to a trace viewer file.
+ */
+
+#ifndef __EVENT_TRACE_H__
+#define __EVENT_TRACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#define EVENT_TRACE_VERSION 1
+#define EVENT_TRACE_HEADER_SIZE 16
+#define EVENT_TRACE_MAX_CORES 2
+
+#define EVENT_TRACE_END  0x8000
+#define EVENT_TRACE_MARK 0x4000
+
+// Traced stages, the ids are part of the download format
+typedef enum {
+  eventTraceStabilizerLoop = 1,
+  eventTraceStabilizerEstimator,
+  eventTraceStabilizerSetpoint,
+  eventTraceStabilizerController,
+  eventTraceStabilizerPower,
+  eventTraceKalmanTask,
+  eventTraceKalmanPredict,
+  eventTraceKalmanMeasurements,
+  eventTraceKalmanFinalize,
+  eventTraceSensorsRead,
+  eventTraceWifiRx,
+  eventTraceWifiTx,
+} eventTraceId_t;
+
+typedef struct {
+  uint32_t timestamp;
+  uint16_t id;
+  uint16_t arg;
+} eventTraceRecord_t;
+
+#ifdef CONFIG_EVENT_TRACE
+/**
+ * Register the trace memory.
+ */
+void eventTraceInit(void);
+
+/**
+ * Append one record to the ring of the calling core. Lock free, callable
+ * from any task.
+ */
+void eventTraceRecord(uint16_t id, uint16_t arg);
+
+/**
+ * Drop all the records.
+ */
+void eventTraceClear(void);
+
+  #define EVENT_TRACE_BEGIN(id, arg) eventTraceRecord((id), (arg))
+  #define EVENT_TRACE_STOP(id, arg)  eventTraceRecord((id) | EVENT_TRACE_END, (arg))
+  #define EVENT_TRACE_POINT(id, arg) eventTraceRecord((id) | EVENT_TRACE_MARK, (arg))
+#else
+  #define eventTraceInit()
+  #define EVENT_TRACE_BEGIN(id, arg)
+  #define EVENT_TRACE_STOP(id, arg)
+  #define EVENT_TRACE_POINT(id, arg)
+#endif
+
+#endif /* __EVENT_TRACE_H__ */
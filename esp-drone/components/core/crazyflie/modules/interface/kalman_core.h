@@ -93,9 +93,39 @@ typedef struct {
   // Indicates that the internal state is corrupt and should be reset
   bool resetEstimation;
 
+  // Set between kalmanCoreBeginBatch() and kalmanCoreEndBatch(), only the upper triangle of P is up to date
+  bool inBatch;
+
+  // Set while the measurements of the history are applied again, the outlier filters have already seen them
+  bool replaying;
+
   float baroReferenceHeight;
 } kalmanCoreData_t;
 
+#ifdef CONFIG_KALMAN_COMPACT_COVARIANCE
+// Covariance in compact form, the standard deviations and the correlations of the upper triangle in Q15.
+// The correlations are bounded by 1 whatever the scale of the states, so the precision is kept relative
+// to each variance.
+#define KC_CORRELATIONS (KC_STATE_DIM * (KC_STATE_DIM - 1) / 2)
+typedef struct {
+  float stdDev[KC_STATE_DIM];
+  int16_t correlation[KC_CORRELATIONS];
+} kalmanCoreCompactCovariance_t;
+#endif
+
+// The part of the filter state that evolves with the predictions and updates, saved to apply delayed
+// measurements at their capture time
+typedef struct {
+  float S[KC_STATE_DIM];
+  float q[4];
+  float R[3][3];
+#ifdef CONFIG_KALMAN_COMPACT_COVARIANCE
+  kalmanCoreCompactCovariance_t P;
+#else
+  float P[KC_STATE_DIM][KC_STATE_DIM];
+#endif
+} kalmanCoreSnapshot_t;
+
 
 void kalmanCoreInit(kalmanCoreData_t* this);
 
@@ -131,6 +161,13 @@ void kalmanCoreUpdateWithYawError(kalmanCoreData_t *this, yawErrorMeasurement_t
 // Measurement of sweep angles from a Lighthouse base station
 //void kalmanCoreUpdateWithSweepAngles(kalmanCoreData_t *this, sweepAngleMeasurement_t *angles, const uint32_t tick);
 
+/*  - Batched measurement updates
+ * The measurement updates made between kalmanCoreBeginBatch() and kalmanCoreEndBatch() are applied as one
+ * sequential batch, one scalar measurement at a time on the upper triangle of P. The symmetry and the bounds
+ * of P are enforced once when the batch ends, instead of after every measurement. */
+void kalmanCoreBeginBatch(kalmanCoreData_t* this);
+void kalmanCoreEndBatch(kalmanCoreData_t* this);
+
 /**
  * Primary Kalman filter functions
  *
@@ -143,9 +180,14 @@ void kalmanCoreAddProcessNoise(kalmanCoreData_t* this, float dt);
 /*  - Finalization to incorporate attitude error into body attitude */
 void kalmanCoreFinalize(kalmanCoreData_t* this, uint32_t tick);
 
-/*  - Externalization to move the filter's internal state into the external state expected by other modules */
+/*  - Externalization to move the filter's internal state into the external state expected by other modules.
+ *    The state is updated in place: its Euler angles are only recomputed when the attitude changed */
 void kalmanCoreExternalizeState(const kalmanCoreData_t* this, state_t *state, const Axis3f *acc, uint32_t tick);
 
 void kalmanCoreDecoupleXY(kalmanCoreData_t* this);
 
+/*  - Snapshots of the filter state, to re-run the filter from a past state once a delayed measurement arrives */
+void kalmanCoreSaveSnapshot(const kalmanCoreData_t* this, kalmanCoreSnapshot_t* snapshot);
+void kalmanCoreRestoreSnapshot(kalmanCoreData_t* this, const kalmanCoreSnapshot_t* snapshot);
+
 #endif // __KALMAN_CORE_H__
@@ -0,0 +1,73 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * log_record.h - On-board ring buffer recording log block packets
+ *
+ * Log blocks switched to recording are written here at their full rate
+ * instead of being sent over the link. The buffer is downloaded afterwards
+ * through the MEM_TYPE_LOG_RECORD memory:
+ *
+ *   0x00  'L' 'R' version reserved
+ *   0x04  uint32 bytes of records stored
+ *   0x08  uint32 records overwritten since the last clear
+ *   0x0C  uint32 buffer capacity
+ *   0x10  records, oldest first, each one size byte followed by the log
+ *         packet data (block id, 3 byte timestamp, values)
+ *
+ * Any write to the memory clears the buffer. Recording should be stopped
+ * before downloading, otherwise the oldest records shift while being read.
+ */
+
+#ifndef __LOG_RECORD_H__
+#define __LOG_RECORD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LOG_RECORD_VERSION 1
+#define LOG_RECORD_HEADER_SIZE 16
+
+/**
+ * Allocate the record buffer of CONFIG_LOG_RECORD_BUFFER_SIZE bytes, in PSRAM
+ * when available, and register its memory.
+ */
+void logRecordInit(void);
+
+/**
+ * @return true if the record buffer is available
+ */
+bool logRecordTest(void);
+
+/**
+ * Append one log packet to the buffer, overwriting the oldest records
+ * when it is full.
+ *
+ * @param[in] data Log packet data
+ * @param[in] size Number of bytes in data
+ */
+void logRecordAppend(const uint8_t *data, uint8_t size);
+
+/**
+ * Drop all the records.
+ */
+void logRecordClear(void);
+
+#endif /* __LOG_RECORD_H__ */
@@ -41,6 +41,8 @@ typedef enum {
   MEM_TYPE_USD    = 0x16,
   MEM_TYPE_LEDMEM = 0x17,
   MEM_TYPE_APP    = 0x18,
+  MEM_TYPE_LOG_RECORD = 0x19,
+  MEM_TYPE_EVENT_TRACE = 0x1A,
 } MemoryType_t;
 
 #define MEMORY_SERIAL_LENGTH 8
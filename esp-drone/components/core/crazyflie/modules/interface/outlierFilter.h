@@ -27,15 +27,46 @@
 
 #include "stabilizer_types.h"
 
-bool outlierFilterValidateTdoaSimple(const tdoaMeasurement_t* tdoa);
-bool outlierFilterValidateTdoaSteps(const tdoaMeasurement_t* tdoa, const float error, const vector_t* jacobian, const point_t* estPos);
+// Robust statistics of the latest samples of a measurement stream: the
+// running median and median absolute deviation (MAD) of a fixed window. A
+// sample is judged against the statistics of the samples before it, then
+// enters the window, so that a filter that lost track opens up as its median
+// and MAD follow the new errors. The cost of a sample is bounded by the
+// window size.
+#define OUTLIER_FILTER_WINDOW 16
 
 typedef struct {
-    uint32_t openingTime;
-    int32_t openingWindow;
-} OutlierFilterLhState_t;
-bool outlierFilterValidateLighthouseSweep(OutlierFilterLhState_t* this, const float distanceToBs, const float angleError, const uint32_t now);
-void outlierFilterReset(OutlierFilterLhState_t* this, const uint32_t now);
+    float samples[OUTLIER_FILTER_WINDOW];       // Arrival order, oldest at next once full
+    float deviations[OUTLIER_FILTER_WINDOW];    // |sample - median| at the arrival of each sample
+    float sortedSamples[OUTLIER_FILTER_WINDOW];
+    float sortedDeviations[OUTLIER_FILTER_WINDOW];
+    uint8_t next;
+    uint8_t count;
+    float median;
+    float mad;
+    float acceptanceLevel;                      // Latest accepted distance to the median
+    uint32_t rejected;
+} OutlierFilterRobustState_t;
+
+void outlierFilterRobustReset(OutlierFilterRobustState_t* this);
+
+/**
+ * Judge a sample of a stream.
+ *
+ * @param this      Statistics of the stream
+ * @param value     Sample
+ * @param threshold Accepted distance to the median, in standard deviations estimated from the MAD
+ * @param minLevel  Accepted distance to the median whatever the spread of the window
+ * @param learn     Add the sample to the window. Samples judged a second time, when the
+ *                  history is replayed, must not be added again.
+ * @return true if the sample is not an outlier
+ */
+bool outlierFilterValidateRobust(OutlierFilterRobustState_t* this, const float value, const float threshold, const float minLevel, const bool learn);
+
+bool outlierFilterValidateTdoaSimple(const tdoaMeasurement_t* tdoa);
+bool outlierFilterValidateTdoaSteps(const tdoaMeasurement_t* tdoa, const float error, const vector_t* jacobian, const point_t* estPos, const bool learn);
+
+bool outlierFilterValidateLighthouseSweep(OutlierFilterRobustState_t* this, const float distanceToBs, const float angleError, const bool learn);
 
 
 #endif // __OUTLIER_FILTER_H__
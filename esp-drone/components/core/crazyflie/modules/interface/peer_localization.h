@@ -11,10 +11,22 @@
 // of other Crazyflies on the same radio "for free". In the future, other
 // methods of peer localization such as peer-to-peer sharing could be added.
 
-// The maximum number of other Crazyflie ID's to track. This constant may be
-// needed for static allocations in other modules, e.g. collision avoidance.
+// The maximum number of other Crazyflie ID's to track. When the table is full,
+// the peer not heard of for the longest time makes room for a new one.
+#define PEER_LOCALIZATION_MAX_PEERS 64
+
+// The maximum number of neighbors returned by a neighbor query. This constant
+// may be needed for static allocations in other modules, e.g. collision
+// avoidance.
 #define PEER_LOCALIZATION_MAX_NEIGHBORS 10
 
+// Side (m) of the cells of the horizontal grid indexing the peers by position,
+// and number of hash buckets the cells share. A neighbor query visits the
+// cells its radius overlaps, so cells of about the radius of the usual queries
+// keep it to a few buckets.
+#define PEER_LOCALIZATION_GRID_CELL_SIZE 1.0f
+#define PEER_LOCALIZATION_GRID_BUCKETS 32
+
 // Initialize and test the module.
 void peerLocalizationInit();
 bool peerLocalizationTest();
@@ -33,11 +45,18 @@ bool peerLocalizationTellPosition(int id, positionMeasurement_t const *pos);
 bool peerLocalizationIsIDActive(uint8_t id);
 
 // Returns the position value for the given radio ID, or NULL if none exists.
-// Performs a linear search.
 peerLocalizationOtherPosition_t *peerLocalizationGetPositionByID(uint8_t id);
 
 // Returns the position value based on index, uncorrelated with radio ID. More
 // efficient if iterating over all peers is needed.
 peerLocalizationOtherPosition_t *peerLocalizationGetPositionByIdx(uint8_t idx);
 
+// Copies the peers within radius (m) of center, nearest first, into neighbors.
+// Peers whose position is older than maxAgeMillis are left out, unless it is
+// negative. Only visits the grid cells overlapping the radius.
+//
+// Returns the number of neighbors copied, at most maxNeighbors.
+int peerLocalizationGetNeighbors(point_t const *center, float radius, int maxAgeMillis,
+                                 peerLocalizationOtherPosition_t neighbors[], int maxNeighbors);
+
 #endif // __PEER_LOCALIZATION_H__
@@ -224,4 +224,71 @@ void pidSetKd(PidObject* pid, const float kd);
  * @param[in] dt    Delta time
  */
 void pidSetDt(PidObject* pid, const float dt);
+
+#define PID_AXES 3
+#define PID_AXES_ALL ((1 << PID_AXES) - 1)
+
+/**
+ * Three PIDs of the same rate run together, one per axis of a vector, with
+ * each field stored as an array over the axes. One update runs the same
+ * arithmetic as pidUpdate() on each axis, the D terms being filtered in one
+ * pass through a filter bank.
+ */
+typedef struct
+{
+  float desired[PID_AXES];      //< set point
+  float error[PID_AXES];        //< error
+  float prevError[PID_AXES];    //< previous error
+  float integ[PID_AXES];        //< integral
+  float deriv[PID_AXES];        //< derivative
+  float kp[PID_AXES];           //< proportional gain
+  float ki[PID_AXES];           //< integral gain
+  float kd[PID_AXES];           //< derivative gain
+  float outP[PID_AXES];         //< proportional output (debugging)
+  float outI[PID_AXES];         //< integral output (debugging)
+  float outD[PID_AXES];         //< derivative output (debugging)
+  float iLimit[PID_AXES];       //< integral limit, absolute value. '0' means no limit.
+  float outputLimit[PID_AXES];  //< total PID output limit, absolute value. '0' means no limit.
+  float dt;                     //< delta-time dt
+  lpf2pBank dFilter;            //< filters for D terms
+  bool enableDFilter;           //< filter for D terms enable flag
+} PidObject3;
+
+/**
+ * Three axis PID object initialization. The errors are reset and the limits
+ * set to their defaults.
+ *
+ * @param[out] pid   A pointer to the pid object to initialize.
+ * @param[in] kp        The proportional gain of each axis
+ * @param[in] ki        The integral gain of each axis
+ * @param[in] kd        The derivative gain of each axis
+ * @param[in] dt        Delta time since the last call
+ * @param[in] samplingRate Frequency the update will be called
+ * @param[in] cutoffFreq   Frequency to set the low pass filters cutoff at
+ * @param[in] enableDFilter Enable setting for the D lowpass filters
+ */
+void pid3Init(PidObject3* pid, const float kp[PID_AXES], const float ki[PID_AXES],
+              const float kd[PID_AXES], const float dt, const float samplingRate,
+              const float cutoffFreq, bool enableDFilter);
+
+/**
+ * Reset the error values of every axis.
+ *
+ * @param[in] pid   A pointer to the pid object.
+ */
+void pid3Reset(PidObject3* pid);
+
+/**
+ * Update the PIDs of some axes on a new measurement, from the desired values
+ * set in the pid object. The other axes, and their D filters, are left as
+ * they are.
+ *
+ * @param[in] pid       A pointer to the pid object.
+ * @param[in] measured  The measured value of each axis
+ * @param[in] axes      Bit mask of the axes to update, bit 0 for axis 0
+ * @param[out] output   PID algorithm output of each updated axis
+ */
+void pid3Update(PidObject3* pid, const float measured[PID_AXES], const uint8_t axes,
+                float output[PID_AXES]);
+
 #endif /* PID_H_ */
@@ -52,7 +52,8 @@ enum trajectory_state
 enum trajectory_type
 {
 	TRAJECTORY_TYPE_PIECEWISE            = 0,
-	TRAJECTORY_TYPE_PIECEWISE_COMPRESSED = 1
+	TRAJECTORY_TYPE_PIECEWISE_COMPRESSED = 1,
+	TRAJECTORY_TYPE_PIECEWISE_STREAM     = 2
 };
 
 struct planner
@@ -64,6 +65,7 @@ struct planner
 	union {
 		const struct piecewise_traj* trajectory; // pointer to trajectory
 		struct piecewise_traj_compressed* compressed_trajectory; // pointer to compressed trajectory
+		struct piecewise_traj_stream* stream_trajectory; // pointer to streamed trajectory
 	};
 
 	struct piecewise_traj planned_trajectory; // trajectory for on-board planning
@@ -104,5 +106,8 @@ int plan_start_trajectory(struct planner *p, const struct piecewise_traj* trajec
 // start compressed trajectory
 int plan_start_compressed_trajectory(struct planner *p, struct piecewise_traj_compressed* trajectory);
 
+// start streamed trajectory
+int plan_start_stream_trajectory(struct planner *p, struct piecewise_traj_stream* trajectory);
+
 // Query if the trjectory is finished
 bool plan_is_finished(struct planner *p, float t);
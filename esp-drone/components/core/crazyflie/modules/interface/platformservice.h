@@ -31,6 +31,9 @@
 
 #include "crtp.h"
 
+// Platform port channel of the app-channel stream, sent in the bulk TX class
+#define PLATFORMSERVICE_APP_STREAM_CHANNEL 0x03
+
 /**
  * Initialize the platform CRTP port
  */
@@ -40,5 +43,12 @@ bool platformserviceTest(void);
 
 void platformserviceSendAppchannelPacket(CRTPPacket *p);
 
+/**
+ * Send an app-channel stream packet, without waiting
+ *
+ * @return true if the packet was queued, false if the TX queue is full
+ */
+bool platformserviceSendAppStreamPacket(CRTPPacket *p);
+
 #endif /* __PLATFORMSERVICE_H__ */
 
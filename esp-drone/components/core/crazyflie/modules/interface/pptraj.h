@@ -168,6 +168,20 @@ void piecewise_plan_7th_order_no_jerk(struct piecewise_traj *p, float duration,
 	struct vec p0, float y0, struct vec v0, float dy0, struct vec a0,
 	struct vec p1, float y1, struct vec v1, float dy1, struct vec a1);
 
+// plan an archimedean spiral out from center with the given distance between
+// turns, flown at constant speed from and to rest, at the height of center.
+// the pieces of pp must hold max_pieces, about 4 are used per turn.
+// returns false if the parameters are invalid or the pieces do not fit.
+bool piecewise_plan_spiral(struct piecewise_traj *pp, int max_pieces,
+	struct vec center, float yaw, float spacing, float radius, float speed);
+
+// plan a zigzag from start: lanes of the given width along x, spacing apart
+// up to length along y, joined by half circle turns outside of the lanes.
+// the pieces of pp must hold max_pieces, 3 are used per lane.
+// returns false if the parameters are invalid or the pieces do not fit.
+bool piecewise_plan_zigzag(struct piecewise_traj *pp, int max_pieces,
+	struct vec start, float yaw, float spacing, float width, float length, float speed);
+
 struct traj_eval piecewise_eval(
 	struct piecewise_traj const *traj, float t);
 
@@ -179,3 +193,45 @@ static inline bool piecewise_is_finished(struct piecewise_traj const *traj, floa
 {
 	return (t - traj->t_begin) >= piecewise_duration(traj);
 }
+
+
+// ------------------------------------------------//
+// piecewise polynomial trajectories, streamed     //
+// ------------------------------------------------//
+
+// the pieces are appended to a ring while the earlier ones are flown.
+// a slot is free again once its piece has been flown.
+struct piecewise_traj_stream
+{
+	float t_begin;        // start time of the piece being flown
+	struct vec shift;
+	struct poly4d *ring;
+	unsigned char n_slots;
+	unsigned char first;  // slot of the piece being flown
+	unsigned char count;  // pieces in the ring, from first
+	bool complete;        // no more pieces will be appended
+	bool starved;         // the last piece has been flown before the next one came
+	unsigned short underruns;
+};
+
+// start an empty stream on a ring of n_slots pieces.
+void piecewise_stream_init(struct piecewise_traj_stream *traj, struct poly4d *ring, unsigned char n_slots);
+
+// add n pieces, already written to the slots that follow the last one.
+// complete marks the last pieces of the trajectory.
+// returns false if the pieces do not fit or the stream is complete.
+bool piecewise_stream_append(struct piecewise_traj_stream *traj, unsigned char n, bool complete);
+
+// check if the slot holds a piece still to be flown.
+bool piecewise_stream_is_busy(struct piecewise_traj_stream const *traj, unsigned char slot);
+
+// evaluate the stream, freeing the slots of the pieces flown.
+// holds the end of the last piece, at rest, until the next one is appended.
+struct traj_eval piecewise_stream_eval(
+	struct piecewise_traj_stream *traj, float t);
+
+static inline bool piecewise_stream_is_finished(struct piecewise_traj_stream const *traj, float t)
+{
+	return traj->complete && traj->count == 1
+		&& (t - traj->t_begin) >= traj->ring[traj->first].duration;
+}
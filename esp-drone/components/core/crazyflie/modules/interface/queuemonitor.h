@@ -21,7 +21,7 @@
  * You should have received a copy of the GNU General Public License
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  *
- * log.h - Dynamic log system
+ * queuemonitor.h - Monitoring functionality for queues
  */
 
 #ifndef __QUEUE_MONITOR_H__
@@ -30,17 +30,58 @@
 
 #include "FreeRTOS.h"
 
+#ifdef CONFIG_QUEUE_MONITOR
+  #define DEBUG_QUEUE_MONITOR
+#endif
+
 #ifdef DEBUG_QUEUE_MONITOR
+  #include <stdbool.h>
+  #include <stdint.h>
   #include "queue.h"
 
+  #define QUEUE_MONITOR_MAX_QUEUES 24
+  #define QUEUE_MONITOR_NAME_LEN 20
+
+  /**
+   * Fill and overflows of one queue over the last period of the monitor (1 s).
+   * The peak is the length when an item was dropped in the period.
+   */
+  typedef struct {
+    char name[QUEUE_MONITOR_NAME_LEN];  // Null terminated, truncated
+    uint16_t length;
+    uint16_t sendCount;
+    uint16_t maxWaiting;
+    uint16_t fullCount;  // Items not sent or dropped because the queue was full
+  } queueMonitorQueue_t;
+
   void queueMonitorInit();
-  #define DEBUG_QUEUE_MONITOR_REGISTER(queue) qmRegisterQueue(queue, __FILE__, #queue)
+  #define DEBUG_QUEUE_MONITOR_REGISTER(queue) qmRegisterQueue(queue, __FILE__, #queue, -1)
+  // Registers one of several queues, named name followed by index
+  #define DEBUG_QUEUE_MONITOR_REGISTER_INDEXED(queue, name, index) qmRegisterQueue(queue, __FILE__, name, index)
+  // Registers a buffer that is not a FreeRTOS queue, number identifies it to DEBUG_QUEUE_MONITOR_RECORD
+  #define DEBUG_QUEUE_MONITOR_REGISTER_BUFFER(number, name, length) (number) = qmRegisterBuffer(__FILE__, name, length)
+  // Records the result of a send to a registered queue
+  #define DEBUG_QUEUE_MONITOR_SEND(queue, sent) qmQueueSend(queue, sent)
+  #define DEBUG_QUEUE_MONITOR_RECORD(number, waiting, sent) qmRecord(number, waiting, sent)
+
+  void qmRegisterQueue(xQueueHandle xQueue, const char* fileName, const char* queueName, int index);
+  unsigned char qmRegisterBuffer(const char* fileName, const char* bufferName, uint16_t length);
+  void qmQueueSend(xQueueHandle xQueue, bool sent);
+  void qmRecord(unsigned char number, uint32_t waiting, bool sent);
 
-  void qm_traceQUEUE_SEND(void* xQueue);
-  void qm_traceQUEUE_SEND_FAILED(void* xQueue);
-  void qmRegisterQueue(xQueueHandle* xQueue, char* fileName, char* queueName);
+  /**
+   * Copy the fill and overflows of the registered queues over the last period.
+   *
+   * @param timestamp Set to the end of the period, in us, 0 before the first period.
+   * @return The number of queues copied.
+   */
+  int queueMonitorGetQueues(queueMonitorQueue_t queues[], int maxQueues, uint64_t *timestamp);
 #else
   #define DEBUG_QUEUE_MONITOR_REGISTER(queue)
+  #define DEBUG_QUEUE_MONITOR_REGISTER_INDEXED(queue, name, index)
+  #define DEBUG_QUEUE_MONITOR_REGISTER_BUFFER(number, name, length)
+  #define DEBUG_QUEUE_MONITOR_SEND(queue, sent)
+  #define DEBUG_QUEUE_MONITOR_RECORD(number, waiting, sent)
 #endif // DEBUG_QUEUE_MONITOR
 
-#endif // __QUEUE_MONITOR_H__
\ No newline at end of file
+#endif // __QUEUE_MONITOR_H__
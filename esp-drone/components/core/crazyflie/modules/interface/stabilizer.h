@@ -33,13 +33,58 @@
 
 #define EMERGENCY_STOP_TIMEOUT_DISABLED (-1)
 
+// Bins of the loop timing histograms, the last one counts the times of a
+// whole loop period or more
+#define STABILIZER_TIMING_BINS 8
+
+/**
+ * Stages of the stabilizer loop timed in a histogram. The loop time runs
+ * from the wake up on the sensor data to the end of the iteration, the jitter
+ * is the deviation of the time between two wake ups from the loop period.
+ * The estimator stage includes the acquisition of the sensor data, done by
+ * the estimators.
+ */
+typedef enum {
+  stabilizerTimingEstimator = 0,
+  stabilizerTimingSetpoint,
+  stabilizerTimingController,
+  stabilizerTimingPower,
+  stabilizerTimingLoop,
+  stabilizerTimingJitter,
+  stabilizerTimingCount,
+} stabilizerTiming_t;
+
+typedef struct {
+  uint32_t bins[STABILIZER_TIMING_BINS];  // Iterations per bin since start
+  uint16_t max;                           // Longest time of the last second, us
+} stabilizerTimingHistogram_t;
+
+// Upper edges of the timing bins, in us
+extern const uint16_t stabilizerTimingBinEdges[STABILIZER_TIMING_BINS - 1];
+
 /**
  * @brief Returns a pointer to the current drone state.
  * 
  * Provides access to the state variables like position, velocity, and attitude.
+ * The stabilizer task updates it in place at the main loop rate: other tasks
+ * reading more than one field should use stabilizerGetStateSnapshot().
  */
 const state_t* stabilizerGetState(void);
 
+/**
+ * @brief Copies the drone state as of the end of the last estimator update.
+ *
+ * The copy is consistent, all the fields come from the same stabilizer tick.
+ * It never blocks the stabilizer task: the reader retries the copy, a few
+ * hundred bytes, in the rare case the stabilizer published a new state
+ * while it was copying.
+ *
+ * @param snapshot Destination of the copy.
+ * @param tick Destination of the stabilizer tick of the copy, NULL if not needed.
+ * @return false if no state was published yet, snapshot is left untouched then.
+ */
+bool stabilizerGetStateSnapshot(state_t *snapshot, uint32_t *tick);
+
 
 /**
  * Initialize the stabilizer subsystem and launch the stabilizer loop task.
@@ -72,5 +117,12 @@ void stabilizerResetEmergencyStop();
  */
 void stabilizerSetEmergencyStopTimeout(int timeout);
 
+/**
+ * Copy the timing histograms of the stabilizer loop.
+ *
+ * @param histograms One histogram per stabilizerTiming_t stage.
+ */
+void stabilizerGetTimingHistograms(stabilizerTimingHistogram_t histograms[stabilizerTimingCount]);
+
 
 #endif /* STABILIZER_H_ */
@@ -149,6 +149,11 @@ typedef struct sensorData_s {
   Axis3f gyroSec;           // deg/s
 #endif
   uint64_t interruptTimestamp;
+  // Time each sample was taken, us on the usecTimestamp() clock
+  uint64_t accTimestamp;
+  uint64_t gyroTimestamp;
+  uint64_t magTimestamp;
+  uint64_t baroTimestamp;
 } sensorData_t;
 
 typedef struct state_s {
@@ -271,6 +276,15 @@ typedef struct {
 #define ATTITUDE_RATE RATE_500_HZ
 #define POSITION_RATE RATE_100_HZ
 
-#define RATE_DO_EXECUTE(RATE_HZ, TICK) ((TICK % (RATE_MAIN_LOOP / RATE_HZ)) == 0)
+// Tick, within the period of a rate, at which a stage runs. The attitude
+// stages run on the even ticks, the position stages and the telemetry on
+// distinct odd ones, so that their work does not pile up on the same tick.
+#define ATTITUDE_PHASE 0
+#define POSITION_PHASE 1
+#define TELEMETRY_PHASE 5
+
+#define RATE_DO_EXECUTE_PHASE(RATE_HZ, PHASE, TICK) \
+  (((TICK) % (RATE_MAIN_LOOP / (RATE_HZ))) == ((PHASE) % (RATE_MAIN_LOOP / (RATE_HZ))))
+#define RATE_DO_EXECUTE(RATE_HZ, TICK) RATE_DO_EXECUTE_PHASE(RATE_HZ, 0, TICK)
 
 #endif
@@ -25,6 +25,9 @@
  * @brief Utility macros to create static memory for OS objects such as
  * queues, semaphores and so on.
  *
+ * The variables are all named osSys_<name>..., the static_mem_report build
+ * target sums them from the ELF (tools/static_mem_report).
+ *
  * @copyright Copyright (c) 2019
  *
  */
@@ -145,6 +148,29 @@
 #define STATIC_MEM_QUEUE_CREATE(NAME) xQueueCreateStatic(osSys_ ## NAME ## Length, osSys_ ## NAME ## ItemSize, osSys_ ## NAME ## Storage, &osSys_ ## NAME ## Mgm)
 
 
+/**
+ * @brief Creation of semaphores and mutexes using static memory.
+ *
+ * STATIC_MEM_SEMAPHORE_ALLOC() defines the control block of a semaphore or a
+ * mutex, one of the STATIC_MEM_*_CREATE() macros below creates the OS object in it.
+ *
+ * Example:
+ * static SemaphoreHandle_t myMutex;
+ * STATIC_MEM_SEMAPHORE_ALLOC(myMutex);
+ * // ...
+ * void init() {
+ *   myMutex = STATIC_MEM_MUTEX_CREATE(myMutex);
+ * }
+ *
+ * @param NAME - the name of the semaphore handle, used as base name of the variable
+ */
+#define STATIC_MEM_SEMAPHORE_ALLOC(NAME) \
+  NO_DMA_CCM_SAFE_ZERO_INIT static StaticSemaphore_t osSys_ ## NAME ## Mgm;
+
+#define STATIC_MEM_MUTEX_CREATE(NAME) xSemaphoreCreateMutexStatic(&osSys_ ## NAME ## Mgm)
+#define STATIC_MEM_BINARY_SEMAPHORE_CREATE(NAME) xSemaphoreCreateBinaryStatic(&osSys_ ## NAME ## Mgm)
+#define STATIC_MEM_COUNTING_SEMAPHORE_CREATE(NAME, MAX_COUNT, INITIAL_COUNT) xSemaphoreCreateCountingStatic((MAX_COUNT), (INITIAL_COUNT), &osSys_ ## NAME ## Mgm)
+
 /**
  * @brief Creation of tasks using static memory.
  *
@@ -212,3 +238,13 @@
  * @param PRIORITY The task priority
  */
 #define STATIC_MEM_TASK_CREATE(NAME, FUNCTION, TASK_NAME, PARAMETERS, PRIORITY) xTaskCreateStatic((FUNCTION), (TASK_NAME), osSys_ ## NAME ## StackDepth, (PARAMETERS), (PRIORITY), osSys_ ## NAME ## StackBuffer, &osSys_ ## NAME ## TaskBuffer)
+
+/**
+ * @brief Create a task using static memory, pinned to a core
+ *
+ * As STATIC_MEM_TASK_CREATE(), with the core the task runs on, one of the
+ * *_TASK_CORE of config.h.
+ *
+ * @param CORE The core of the task, or TASK_CORE_ANY
+ */
+#define STATIC_MEM_TASK_CREATE_PINNED(NAME, FUNCTION, TASK_NAME, PARAMETERS, PRIORITY, CORE) xTaskCreateStaticPinnedToCore((FUNCTION), (TASK_NAME), osSys_ ## NAME ## StackDepth, (PARAMETERS), (PRIORITY), osSys_ ## NAME ## StackBuffer, &osSys_ ## NAME ## TaskBuffer, (CORE))
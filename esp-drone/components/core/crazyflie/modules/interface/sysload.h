@@ -1,6 +1,50 @@
 #ifndef __SYSLOAD_H__
 #define __SYSLOAD_H__
 
+#include <stdint.h>
+
+#define SYSLOAD_MAX_TASKS 32
+#define SYSLOAD_TASK_NAME_LEN 16
+
+typedef struct {
+  char name[SYSLOAD_TASK_NAME_LEN];  // Null terminated, truncated
+  uint16_t load;                     // CPU load of the last period, in 0.01 %
+  uint16_t stackLeft;                // Unused stack at peak usage, in bytes
+  uint8_t priority;
+} sysLoadTask_t;
+
 void sysLoadInit();
 
-#endif
\ No newline at end of file
+/**
+ * Copy the CPU load and stack usage of the tasks, measured over the last
+ * period of the load monitor (1 s).
+ *
+ * @param tasks Filled with up to maxTasks tasks.
+ * @param timestamp Set to the time the load was measured, in us, 0 before the first period.
+ * @return The number of tasks copied.
+ */
+int sysLoadGetTasks(sysLoadTask_t tasks[], int maxTasks, uint64_t *timestamp);
+
+// Largest free internal block under which a warning is printed
+#define SYSLOAD_HEAP_LOW_BLOCK 4096
+
+/**
+ * Internal RAM heap at the last period of the monitor. It holds the Wi-Fi and
+ * lwIP buffers: a largest free block shrinking while the free space holds is
+ * fragmentation, which ends in failed allocations.
+ */
+typedef struct {
+  uint32_t freeSize;
+  uint32_t minFreeSize;       // Low watermark since boot
+  uint32_t largestBlock;
+  uint32_t minLargestBlock;   // Low watermark since boot
+  uint32_t allocFailures;     // Failed allocations since boot, of any heap
+  uint32_t lastFailedSize;    // Bytes, 0 if none failed
+} sysLoadHeap_t;
+
+/**
+ * Copy the heap stats of the last period.
+ */
+void sysLoadGetHeap(sysLoadHeap_t *heap);
+
+#endif
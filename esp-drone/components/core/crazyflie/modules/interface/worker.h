@@ -28,6 +28,17 @@
 
 #include <stdbool.h>
 
+/**
+ * Priorities of the scheduled work, the pending work of a priority runs
+ * before any of the lower ones.
+ */
+typedef enum {
+  workerPriorityHigh = 0,
+  workerPriorityNormal,
+  workerPriorityLow,
+  workerPriorityCount,
+} workerPriority_t;
+
 void workerInit();
 
 bool workerTest();
@@ -41,7 +52,7 @@ bool workerTest();
 void workerLoop();
 
 /**
- * Schedule a function for execution by the worker loop
+ * Schedule a function for execution by the worker loop, at normal priority
  * The function will be executed as soon as possible by the worker loop.
  * Scheduled functions are stacked in a FIFO queue.
  *
@@ -51,4 +62,18 @@ void workerLoop();
  */
 int workerSchedule(void (*function)(void*), void *arg);
 
+/**
+ * Schedule a function for execution by the worker loop at a priority
+ * Functions of the same priority are executed in FIFO order. A function
+ * already pending with the same argument, at the same or a higher priority,
+ * is not scheduled again and runs once.
+ *
+ * @param function Function to be executed
+ * @param arg      Argument that will be passed to the function when executed
+ * @param priority Priority of the work
+ * @return         0 in case of success or if coalesced, ENOMEM if all the
+ *                 CONFIG_WORKER_QUEUE_LENGTH slots are pending.
+ */
+int workerSchedulePriority(void (*function)(void*), void *arg, workerPriority_t priority);
+
 #endif //__WORKER_H
@@ -29,19 +29,47 @@
 #include <string.h>
 
 #include "FreeRTOS.h"
+#include "task.h"
 #include "semphr.h"
 #include "queue.h"
 
 #include "crtp.h"
 #include "platformservice.h"
 #include "stm32_legacy.h"
+#include "static_mem.h"
+
+#define APPCHANNEL_RX_QUEUE_LENGTH 10
 
 static SemaphoreHandle_t sendMutex;
+STATIC_MEM_SEMAPHORE_ALLOC(sendMutex);
 
 static xQueueHandle  rxQueue;
+STATIC_MEM_QUEUE_ALLOC(rxQueue, APPCHANNEL_RX_QUEUE_LENGTH, sizeof(CRTPPacket));
 
 static bool overflow;
 
+// Stream data packets start with the little endian sequence number of the packet
+#define APPCHANNEL_STREAM_HEADER_SIZE 2
+// Bulk TX queue packets left to the console and the log while streaming
+#define APPCHANNEL_STREAM_TX_RESERVE 4
+
+// Stream packets from the ground: command, then a little endian uint16
+typedef enum {
+  streamCredit = 0x00,  // Sequence number the stream may send up to, excluded
+  streamOpen   = 0x01,  // Window in packets, counted from the next sequence number
+  streamClose  = 0x02,
+} StreamCommand;
+
+static SemaphoreHandle_t streamMutex;
+STATIC_MEM_SEMAPHORE_ALLOC(streamMutex);
+// Given when credit arrives or the stream closes
+static SemaphoreHandle_t streamCreditGiven;
+STATIC_MEM_SEMAPHORE_ALLOC(streamCreditGiven);
+
+static bool streamIsOpen;
+static uint16_t streamNextSeq;
+static uint16_t streamLimit;
+
 void appchannelSendPacket(void* data, size_t length)
 {
   static CRTPPacket packet;
@@ -78,6 +106,65 @@ size_t appchannelReceivePacket(void* buffer, size_t max_length, int timeout_ms)
   }
 }
 
+static bool streamHasCredit(void)
+{
+  return (int16_t)(__atomic_load_n(&streamLimit, __ATOMIC_ACQUIRE) - streamNextSeq) > 0;
+}
+
+size_t appchannelStreamWrite(const void* data, size_t length, int timeout_ms)
+{
+  static CRTPPacket packet;
+  const uint8_t *bytes = data;
+  size_t written = 0;
+  TickType_t ticksToWait = (timeout_ms < 0) ? portMAX_DELAY : M2T(timeout_ms);
+  TimeOut_t timeOut;
+
+  vTaskSetTimeOutState(&timeOut);
+  xSemaphoreTake(streamMutex, portMAX_DELAY);
+
+  while (written < length && __atomic_load_n(&streamIsOpen, __ATOMIC_ACQUIRE)) {
+    if (!streamHasCredit()) {
+      if (xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdTRUE ||
+          xSemaphoreTake(streamCreditGiven, ticksToWait) != pdTRUE) {
+        break;
+      }
+      continue;
+    }
+
+    if (crtpGetFreeTxQueuePackets() <= APPCHANNEL_STREAM_TX_RESERVE) {
+      if (xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdTRUE) {
+        break;
+      }
+      vTaskDelay(1);
+      continue;
+    }
+
+    size_t payload = crtpGetMaxDataSize() - APPCHANNEL_STREAM_HEADER_SIZE;
+    if (payload > length - written) {
+      payload = length - written;
+    }
+
+    packet.data[0] = streamNextSeq & 0xFF;
+    packet.data[1] = streamNextSeq >> 8;
+    memcpy(&packet.data[APPCHANNEL_STREAM_HEADER_SIZE], &bytes[written], payload);
+    packet.size = APPCHANNEL_STREAM_HEADER_SIZE + payload;
+
+    if (platformserviceSendAppStreamPacket(&packet)) {
+      __atomic_store_n(&streamNextSeq, (uint16_t)(streamNextSeq + 1), __ATOMIC_RELEASE);
+      written += payload;
+    }
+  }
+
+  xSemaphoreGive(streamMutex);
+
+  return written;
+}
+
+bool appchannelStreamIsOpen()
+{
+  return __atomic_load_n(&streamIsOpen, __ATOMIC_ACQUIRE);
+}
+
 bool appchannelHasOverflowOccured()
 {
   bool hasOverflowed = overflow;
@@ -88,11 +175,17 @@ bool appchannelHasOverflowOccured()
 
 void appchannelInit()
 {
-  sendMutex = xSemaphoreCreateMutex();
+  sendMutex = STATIC_MEM_MUTEX_CREATE(sendMutex);
 
-  rxQueue = xQueueCreate(10, sizeof(CRTPPacket));
+  rxQueue = STATIC_MEM_QUEUE_CREATE(rxQueue);
 
   overflow = false;
+
+  streamMutex = STATIC_MEM_MUTEX_CREATE(streamMutex);
+  streamCreditGiven = STATIC_MEM_BINARY_SEMAPHORE_CREATE(streamCreditGiven);
+  streamIsOpen = false;
+  streamNextSeq = 0;
+  streamLimit = 0;
 }
 
 void appchannelIncomingPacket(CRTPPacket *p)
@@ -103,3 +196,33 @@ void appchannelIncomingPacket(CRTPPacket *p)
     overflow = true;
   }
 }
+
+void appchannelStreamIncomingPacket(CRTPPacket *p)
+{
+  if (p->size < 3) {
+    return;
+  }
+
+  uint16_t value = p->data[1] | (p->data[2] << 8);
+  uint16_t limit = __atomic_load_n(&streamLimit, __ATOMIC_RELAXED);
+
+  switch (p->data[0]) {
+    case streamCredit:
+      // Credits are cumulative, a late one is ignored and a lost one made up by the next
+      if ((int16_t)(value - limit) > 0) {
+        __atomic_store_n(&streamLimit, value, __ATOMIC_RELEASE);
+      }
+      break;
+    case streamOpen:
+      __atomic_store_n(&streamLimit, (uint16_t)(__atomic_load_n(&streamNextSeq, __ATOMIC_ACQUIRE) + value), __ATOMIC_RELEASE);
+      __atomic_store_n(&streamIsOpen, true, __ATOMIC_RELEASE);
+      break;
+    case streamClose:
+      __atomic_store_n(&streamIsOpen, false, __ATOMIC_RELEASE);
+      break;
+    default:
+      return;
+  }
+
+  xSemaphoreGive(streamCreditGiven);
+}
@@ -29,6 +29,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
+#include "config.h"
 #include "system.h"
 #include "static_mem.h"
 
@@ -54,7 +55,7 @@ void __attribute__((weak)) appInit()
     return;
   }
 
-  STATIC_MEM_TASK_CREATE(appTask, appTask, "app", NULL, APP_PRIORITY);
+  STATIC_MEM_TASK_CREATE_PINNED(appTask, appTask, "app", NULL, APP_PRIORITY, APP_TASK_CORE);
   isInit = true;
 }
 
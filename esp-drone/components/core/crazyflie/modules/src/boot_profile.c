@@ -0,0 +1,85 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * boot_profile.c - Time stamps of the boot phases
+ */
+
+#include <inttypes.h>
+
+#include "boot_profile.h"
+#include "log.h"
+#include "usec_time.h"
+
+#define DEBUG_MODULE "BOOT"
+#include "debug_cf.h"
+
+static const char * const phaseNames[bootPhaseCount] = {
+  [bootPhaseSystemTask] = "system task",
+  [bootPhaseWifiUp] = "wifi up",
+  [bootPhaseSystemInit] = "system init",
+  [bootPhaseComm] = "comm",
+  [bootPhaseFlight] = "flight",
+  [bootPhaseSelfTest] = "self test",
+  [bootPhaseTelemetryReady] = "telemetry",
+};
+
+// ms since the application start, 0 until stamped
+static uint32_t phaseTime[bootPhaseCount];
+
+void bootProfileMark(bootPhase_t phase)
+{
+  if (phase >= bootPhaseCount) {
+    return;
+  }
+
+  // At least 1 ms, 0 is not stamped
+  uint32_t now = usecTimestamp() / 1000 + 1;
+  uint32_t expected = 0;
+  __atomic_compare_exchange_n(&phaseTime[phase], &expected, now, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+void bootProfilePrint(void)
+{
+  uint32_t previous = 0;
+
+  for (int phase = 0; phase < bootPhaseCount; phase++) {
+    uint32_t time = __atomic_load_n(&phaseTime[phase], __ATOMIC_RELAXED);
+    if (time == 0) {
+      DEBUG_PRINT("%-12s -\n", phaseNames[phase]);
+    } else if (phase == bootPhaseWifiUp) {
+      // Overlaps the following phases, not in the sequence
+      DEBUG_PRINT("%-12s %5"PRIu32" ms\n", phaseNames[phase], time);
+    } else {
+      DEBUG_PRINT("%-12s %5"PRIu32" ms (+%"PRIu32")\n", phaseNames[phase], time, time - previous);
+      previous = time;
+    }
+  }
+}
+
+LOG_GROUP_START(boot)
+LOG_ADD(LOG_UINT32, sysTask, &phaseTime[bootPhaseSystemTask])
+LOG_ADD(LOG_UINT32, wifiUp, &phaseTime[bootPhaseWifiUp])
+LOG_ADD(LOG_UINT32, sysInit, &phaseTime[bootPhaseSystemInit])
+LOG_ADD(LOG_UINT32, comm, &phaseTime[bootPhaseComm])
+LOG_ADD(LOG_UINT32, flight, &phaseTime[bootPhaseFlight])
+LOG_ADD(LOG_UINT32, selfTest, &phaseTime[bootPhaseSelfTest])
+LOG_ADD(LOG_UINT32, telemetry, &phaseTime[bootPhaseTelemetryReady])
+LOG_GROUP_STOP(boot)
@@ -67,12 +67,14 @@ static struct vec3_s svec2vec(struct vec v)
 //   B: RHS vector for polytope inequality Ax <= B. Dimension [nRows].
 //   projectionWorkspace: Additional scratch area. Dimension [nRows * 3].
 //   nRows: Number of rows in our cell polytope inequality.
+//   maxIters: Max number of iterations of the projection into the cell.
 //
 static struct vec sidestepGoal(
   collision_avoidance_params_t const *params,
   struct vec goal,
   bool modifyIfInside,
-  float const A[], float const B[], float projectionWorkspace[], int nRows)
+  float const A[], float const B[], float projectionWorkspace[], int nRows,
+  int maxIters)
 {
   float const rayScale = rayintersectpolytope(vzero(), goal, A, B, nRows, NULL);
   if (rayScale >= 1.0f && !modifyIfInside) {
@@ -90,11 +92,25 @@ static struct vec sidestepGoal(
     goal,
     A, B, projectionWorkspace, nRows,
     params->voronoiProjectionTolerance,
-    params->voronoiProjectionMaxIters
+    maxIters
   );
 }
 
-void collisionAvoidanceUpdateSetpointCore(
+// Number of iterations of the projection into a cell of nRows rows that fit
+// the work budget of the params. Each iteration projects onto every row once.
+static int projectionMaxIters(collision_avoidance_params_t const *params, int nRows)
+{
+  int maxIters = params->voronoiProjectionMaxIters;
+  if (params->voronoiProjectionBudget > 0) {
+    int const budgetIters = params->voronoiProjectionBudget / nRows;
+    if (budgetIters < maxIters) {
+      maxIters = budgetIters > 1 ? budgetIters : 1;
+    }
+  }
+  return maxIters;
+}
+
+int collisionAvoidanceUpdateSetpointCore(
   collision_avoidance_params_t const *params,
   collision_avoidance_state_t *collisionState,
   int nOthers,
@@ -106,19 +122,23 @@ void collisionAvoidanceUpdateSetpointCore(
   // Part 1: Construct the polytope inequalities in A, b.
   //
 
-  int const nRows = nOthers + 6;
   float *A = workspace;
-  float *B = workspace + 3 * nRows;
-  float *projectionWorkspace = workspace + 4 * nRows;
+  float *B = workspace + 3 * (nOthers + 6);
+  float *projectionWorkspace = workspace + 4 * (nOthers + 6);
 
   // Compute the cell in a stretched coordinate system for downwash awareness.
   // See header for details.
   struct vec const radiiInv = veltrecip(params->ellipsoidRadii);
   struct vec const ourPos = vec2svec(state->position);
 
-  // We could do some optimizations here to reduce the number of rows, like
-  // leave out very far away neighbors. It would help the average case
-  // complexity, but not the worst case - so we skip it for now.
+  // The box faces enforce max speed in the infinity-norm, see below.
+  float const maxDist = params->horizonSecs * params->maxSpeed;
+
+  // Leave out the faces of the peers too far away to cut the max speed box:
+  // the largest a^T x over the box is maxDist * |a|_1. Without them the cell
+  // is the same, but the projection iterates over fewer rows. Rows are only
+  // written at or before the peer being read, so the in-place input is safe.
+  int nPeerRows = 0;
   for (int i = 0; i < nOthers; ++i) {
     struct vec peerPos = vloadf(otherPositions + 3 * i);
     struct vec const toPeerStretched = veltmul(vsub(peerPos, ourPos), radiiInv);
@@ -126,24 +146,29 @@ void collisionAvoidanceUpdateSetpointCore(
     struct vec const a = vdiv(veltmul(toPeerStretched, radiiInv), dist);
     float const b = dist / 2.0f - 1.0f;
     float scale = 1.0f / vmag(a);
-    vstoref(vscl(scale, a), A + 3 * i);
-    B[i] = scale * b;
+    struct vec const aNormalized = vscl(scale, a);
+    if (scale * b >= maxDist * vnorm1(aNormalized)) {
+      continue;
+    }
+    vstoref(aNormalized, A + 3 * nPeerRows);
+    B[nPeerRows] = scale * b;
+    ++nPeerRows;
   }
 
-  // Add the bounding box polytope faces. We also use the box faces to enforce
-  // max speed in the infinity-norm.
-  float const maxDist = params->horizonSecs * params->maxSpeed;
+  int const nRows = nPeerRows + 6;
+  int const maxIters = projectionMaxIters(params, nRows);
 
-  memset(A + 3 * nOthers, 0, 18 * sizeof(float));
+  // Add the bounding box polytope faces.
+  memset(A + 3 * nPeerRows, 0, 18 * sizeof(float));
 
   for (int dim = 0; dim < 3; ++dim) {
     float boxMax = vindex(params->bboxMax, dim) - vindex(ourPos, dim);
-    A[3 * (nOthers + dim) + dim] = 1.0f;
-    B[nOthers + dim] = fminf(maxDist, boxMax);
+    A[3 * (nPeerRows + dim) + dim] = 1.0f;
+    B[nPeerRows + dim] = fminf(maxDist, boxMax);
 
     float boxMin = vindex(params->bboxMin, dim) - vindex(ourPos, dim);
-    A[3 * (nOthers + dim + 3) + dim] = -1.0f;
-    B[nOthers + dim + 3] = -fmaxf(-maxDist, boxMin);
+    A[3 * (nPeerRows + dim + 3) + dim] = -1.0f;
+    B[nPeerRows + dim + 3] = -fmaxf(-maxDist, boxMin);
   }
 
   //
@@ -161,7 +186,7 @@ void collisionAvoidanceUpdateSetpointCore(
     if (vinpolytope(vzero(), A, B, nRows, inPolytopeTolerance)) {
       // Typical case - our current position is within our cell.
       struct vec pseudoGoal = vscl(params->horizonSecs, setVel);
-      pseudoGoal = sidestepGoal(params, pseudoGoal, true, A, B, projectionWorkspace, nRows);
+      pseudoGoal = sidestepGoal(params, pseudoGoal, true, A, B, projectionWorkspace, nRows, maxIters);
       if (vinpolytope(pseudoGoal, A, B, nRows, inPolytopeTolerance)) {
         setVel = vdiv(pseudoGoal, params->horizonSecs);
       }
@@ -177,7 +202,7 @@ void collisionAvoidanceUpdateSetpointCore(
         vzero(),
         A, B, projectionWorkspace, nRows,
         params->voronoiProjectionTolerance,
-        params->voronoiProjectionMaxIters
+        maxIters
       );
       if (vinpolytope(nearestInCell, A, B, nRows, inPolytopeTolerance)) {
         setVel = vclampnorm(nearestInCell, params->maxSpeed);
@@ -193,7 +218,7 @@ void collisionAvoidanceUpdateSetpointCore(
 
     struct vec const setPosRelative = vsub(setPos, ourPos);
     struct vec const setPosRelativeNew = sidestepGoal(
-      params, setPosRelative, false, A, B, projectionWorkspace, nRows);
+      params, setPosRelative, false, A, B, projectionWorkspace, nRows, maxIters);
 
     if (!vinpolytope(setPosRelativeNew, A, B, nRows, inPolytopeTolerance)) {
       // If the projection algorithm failed to converge, then either
@@ -250,6 +275,8 @@ void collisionAvoidanceUpdateSetpointCore(
 
   setpoint->position = svec2vec(setPos);
   setpoint->velocity = svec2vec(setVel);
+
+  return nPeerRows;
 }
 
 
@@ -265,6 +292,7 @@ void collisionAvoidanceUpdateSetpointCore(
 
 #include "param.h"
 #include "log.h"
+#include "usec_time.h"
 
 
 static uint8_t collisionAvoidanceEnable = 0;
@@ -279,6 +307,8 @@ static collision_avoidance_params_t params = {
   .maxPeerLocAgeMillis = 5000,  // Probably longer than desired in most applications.
   .voronoiProjectionTolerance = 1e-5,
   .voronoiProjectionMaxIters = 100,
+  // 25 iterations with every neighbor bounding the cell
+  .voronoiProjectionBudget = 400,
 };
 
 static collision_avoidance_state_t collisionState = {
@@ -301,8 +331,23 @@ bool collisionAvoidanceTest()
 #define MAX_CELL_ROWS (PEER_LOCALIZATION_MAX_NEIGHBORS + 6)
 static float workspace[7 * MAX_CELL_ROWS];
 
-// Latency counter for logging.
+static peerLocalizationOtherPosition_t neighbors[PEER_LOCALIZATION_MAX_NEIGHBORS];
+
+// Distance beyond which a peer cannot bound our cell. The face of a peer at
+// distance d is at least minRadius * (d / (2 * maxRadius) - 1) away from us,
+// in the stretched coordinates mapped back to meters, and only matters when
+// closer than the corners of the max speed box, sqrt(3) * maxDist.
+static float neighborRadius(collision_avoidance_params_t const *params)
+{
+  float const maxDist = params->horizonSecs * params->maxSpeed;
+  float const minRadius = vminelt(params->ellipsoidRadii);
+  float const maxRadius = vmaxelt(params->ellipsoidRadii);
+  return 2.0f * maxRadius * (sqrtf(3.0f) * maxDist / minRadius + 1.0f);
+}
+
+// Latency (us) and number of neighbors bounding our cell, for logging.
 static uint32_t latency = 0;
+static uint8_t nearPeers = 0;
 
 void collisionAvoidanceUpdateSetpoint(
   setpoint_t *setpoint, sensorData_t const *sensorData, state_t const *state, uint32_t tick)
@@ -311,37 +356,26 @@ void collisionAvoidanceUpdateSetpoint(
     return;
   }
 
-  TickType_t const time = xTaskGetTickCount();
-  bool doAgeFilter = params.maxPeerLocAgeMillis >= 0;
-
-  // Counts the actual number of neighbors after we filter stale measurements.
-  int nOthers = 0;
-
-  for (int i = 0; i < PEER_LOCALIZATION_MAX_NEIGHBORS; ++i) {
-
-    peerLocalizationOtherPosition_t const *otherPos = peerLocalizationGetPositionByIdx(i);
+  uint64_t const start = usecTimestamp();
 
-    if (otherPos == NULL || otherPos->id == 0) {
-      continue;
-    }
-
-    if (doAgeFilter && (time - otherPos->pos.timestamp > params.maxPeerLocAgeMillis)) {
-      continue;
-    }
+  // The nearest neighbors that can bound our cell, stale measurements left out.
+  int const nOthers = peerLocalizationGetNeighbors(&state->position, neighborRadius(&params),
+    params.maxPeerLocAgeMillis, neighbors, PEER_LOCALIZATION_MAX_NEIGHBORS);
 
-    workspace[3 * nOthers + 0] = otherPos->pos.x;
-    workspace[3 * nOthers + 1] = otherPos->pos.y;
-    workspace[3 * nOthers + 2] = otherPos->pos.z;
-    ++nOthers;
+  for (int i = 0; i < nOthers; ++i) {
+    workspace[3 * i + 0] = neighbors[i].pos.x;
+    workspace[3 * i + 1] = neighbors[i].pos.y;
+    workspace[3 * i + 2] = neighbors[i].pos.z;
   }
 
-  collisionAvoidanceUpdateSetpointCore(&params, &collisionState, nOthers, workspace, workspace, setpoint, sensorData, state);
+  nearPeers = collisionAvoidanceUpdateSetpointCore(&params, &collisionState, nOthers, workspace, workspace, setpoint, sensorData, state);
 
-  latency = xTaskGetTickCount() - time;
+  latency = usecTimestamp() - start;
 }
 
 LOG_GROUP_START(colAv)
   LOG_ADD(LOG_UINT32, latency, &latency)
+  LOG_ADD(LOG_UINT8, nearPeers, &nearPeers)
 LOG_GROUP_STOP(colAv)
 
 
@@ -366,6 +400,7 @@ PARAM_GROUP_START(colAv)
   PARAM_ADD(PARAM_INT32, maxPeerLocAge, &params.maxPeerLocAgeMillis)
   PARAM_ADD(PARAM_FLOAT, vorTol, &params.voronoiProjectionTolerance)
   PARAM_ADD(PARAM_INT32, vorIters, &params.voronoiProjectionMaxIters)
+  PARAM_ADD(PARAM_INT32, vorBudget, &params.voronoiProjectionBudget)
 PARAM_GROUP_STOP(colAv)
 
 #endif  // CRAZYFLIE_FW
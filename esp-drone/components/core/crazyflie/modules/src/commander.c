@@ -47,6 +47,12 @@ const static int priorityDisable = COMMANDER_PRIORITY_DISABLE;
 static uint32_t lastUpdate;
 static bool enableHighLevel = false;
 
+// Bumped after every write of the setpoint queue. The stabilizer loop keeps a
+// copy of the queued setpoint and only peeks the queue again after a write.
+static volatile uint32_t setpointGeneration = 1;
+static uint32_t cachedGeneration;
+static setpoint_t cachedSetpoint;
+
 static QueueHandle_t setpointQueue;
 STATIC_MEM_QUEUE_ALLOC(setpointQueue, 1, sizeof(setpoint_t));
 static QueueHandle_t priorityQueue;
@@ -82,6 +88,7 @@ void commanderSetSetpoint(setpoint_t *setpoint, int priority)
     // This is a potential race but without effect on functionality
     xQueueOverwrite(setpointQueue, setpoint);
     xQueueOverwrite(priorityQueue, &priority);
+    setpointGeneration++;
     // Send the high-level planner to idle so it will forget its current state
     // and start over if we switch from low-level to high-level in the future.
     crtpCommanderHighLevelStop();
@@ -98,12 +105,20 @@ void commanderNotifySetpointsStop(int remainValidMillisecs)
   xQueuePeek(setpointQueue, &tempSetpoint, 0);
   tempSetpoint.timestamp = currentTime - timeSetback;
   xQueueOverwrite(setpointQueue, &tempSetpoint);
+  setpointGeneration++;
   crtpCommanderHighLevelTellState(&lastState);
 }
 
 void commanderGetSetpoint(setpoint_t *setpoint, const state_t *state)
 {
-  xQueuePeek(setpointQueue, setpoint, 0);
+  // Read before the peek: a write in between is peeked again on the next call
+  const uint32_t generation = setpointGeneration;
+  if (generation != cachedGeneration) {
+    xQueuePeek(setpointQueue, &cachedSetpoint, 0);
+    cachedGeneration = generation;
+  }
+  // The caller modifies its setpoint, e.g. in the position controller
+  *setpoint = cachedSetpoint;
   lastUpdate = setpoint->timestamp;
   uint32_t currentTime = xTaskGetTickCount();
 
@@ -138,6 +153,11 @@ bool commanderTest(void)
   return isInit;
 }
 
+uint32_t commanderGetSetpointGeneration(void)
+{
+  return cachedGeneration;
+}
+
 uint32_t commanderGetInactivityTime(void)
 {
   return xTaskGetTickCount() - lastUpdate;
@@ -25,172 +25,288 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 /*FreeRtos includes*/
 #include "FreeRTOS.h"
-#include "semphr.h"
+#include "task.h"
 
+#include "config.h"
 #include "crtp.h"
-
-#ifdef STM32F40_41xxx
-#include "stm32f4xx.h"
-#else
+#include "console.h"
 #include "stm32_legacy.h"
-#ifndef SCB_ICSR_VECTACTIVE_Msk
-#define SCB_ICSR_VECTACTIVE_Msk 0x1FFUL
-#endif
-#endif
+#include "static_mem.h"
+
+// Characters are pushed lock free by any task or interrupt and drained into
+// CRTP packets by the console task. A producer never waits: when the ring is
+// full the character is dropped and counted, and a marker with the count is
+// sent once the text that made it in has been drained.
+
+// Must be a power of two, below 32768
+#define CONSOLE_RING_SIZE 512
+#define CONSOLE_RING_MASK (CONSOLE_RING_SIZE - 1)
+
+// Period of the console task while there is text waiting (in ms)
+#define CONSOLE_DRAIN_PERIOD 20
+// A line without new line is sent after this time (in ms)
+#define CONSOLE_PARTIAL_TIMEOUT 100
+// TX queue packets left to the log while the console drains
+#define CONSOLE_TX_QUEUE_RESERVE 2
+
+typedef struct {
+  uint16_t seq;  // Slot index when free, index + 1 once written
+  char ch;
+} consoleSlot_t;
+
+NO_DMA_CCM_SAFE_ZERO_INIT static consoleSlot_t consoleRing[CONSOLE_RING_SIZE];
+static uint16_t enqueuePos;
+static uint16_t dequeuePos;
+static uint32_t droppedBytes;
+// Enqueue position of the first dropped character since the last marker
+static uint16_t droppedPos;
+static bool flushRequested;
 
 static CRTPPacket messageToPrint;
 static bool messageSendingIsPending = false;
-static xSemaphoreHandle synch = NULL;
+static TickType_t partialStart;
+
+static TaskHandle_t consoleTaskHandle;
+STATIC_MEM_TASK_ALLOC(consoleTask, CONSOLE_TASK_STACKSIZE);
 
-static const char bufferFullMsg[] = "<F>\n";
 static bool isInit;
 
-static void addBufferFullMarker();
+static void consoleTask(void *param);
 
 
-/**
- * Send the data to the client
- * returns TRUE if successful otherwise FALSE
- */
-static bool consoleSendMessage(void)
+static bool consoleRingPush(char ch)
 {
-  if (crtpSendPacket(&messageToPrint) == pdTRUE)
-  {
-    messageToPrint.size = 0;
-    messageSendingIsPending = false;
+  uint16_t pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+  consoleSlot_t *slot;
+
+  while (true) {
+    slot = &consoleRing[pos & CONSOLE_RING_MASK];
+    int16_t diff = (int16_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&enqueuePos, &pos, (uint16_t)(pos + 1), true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Not drained yet, the ring is full
+      if (__atomic_fetch_add(&droppedBytes, 1, __ATOMIC_RELAXED) == 0) {
+        __atomic_store_n(&droppedPos, pos, __ATOMIC_RELEASE);
+      }
+      return false;
+    } else {
+      pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+    }
   }
-  else
-  {
+
+  slot->ch = ch;
+  __atomic_store_n(&slot->seq, (uint16_t)(pos + 1), __ATOMIC_RELEASE);
+  return true;
+}
+
+// Only called from the console task
+static bool consoleRingPop(char *ch)
+{
+  consoleSlot_t *slot = &consoleRing[dequeuePos & CONSOLE_RING_MASK];
+  if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != (uint16_t)(dequeuePos + 1)) {
+    // Empty, or the oldest slot is still being written
     return false;
   }
 
+  *ch = slot->ch;
+  __atomic_store_n(&slot->seq, (uint16_t)(dequeuePos + CONSOLE_RING_SIZE), __ATOMIC_RELEASE);
+  dequeuePos++;
   return true;
 }
 
-void consoleInit()
+static bool consoleRingIsEmpty(void)
 {
-  if (isInit)
-    return;
+  return __atomic_load_n(&consoleRing[dequeuePos & CONSOLE_RING_MASK].seq, __ATOMIC_ACQUIRE) != (uint16_t)(dequeuePos + 1);
+}
 
-  messageToPrint.size = 0;
-  messageToPrint.header = CRTP_HEADER(CRTP_PORT_CONSOLE, 0);
-  vSemaphoreCreateBinary(synch);
-  messageSendingIsPending = false;
+// True when everything pushed before the first drop has been drained
+static bool consoleMarkerIsDue(void)
+{
+  if (__atomic_load_n(&droppedBytes, __ATOMIC_ACQUIRE) == 0) {
+    return false;
+  }
 
-  isInit = true;
+  return (int16_t)(dequeuePos - __atomic_load_n(&droppedPos, __ATOMIC_ACQUIRE)) >= 0;
 }
 
-bool consoleTest(void)
+static void consoleWakeUp(bool isInInterrupt)
 {
-  return isInit;
+  if (isInInterrupt) {
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(consoleTaskHandle, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken) {
+      portYIELD_FROM_ISR();
+    }
+  } else {
+    xTaskNotifyGive(consoleTaskHandle);
+  }
 }
 
-int consolePutchar(int ch)
+static int consolePut(int ch, bool isInInterrupt)
 {
-  bool isInInterrupt = false; //bool isInInterrupt = (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0;
-
   if (!isInit) {
     return 0;
   }
 
-  if (isInInterrupt) {
-    return consolePutcharFromISR(ch);
+  if (!consoleRingPush((char)ch) || ch == '\n') {
+    consoleWakeUp(isInInterrupt);
   }
 
-  if (xSemaphoreTake(synch, portMAX_DELAY) == pdTRUE)
-  {
-    // Try to send if we already have a pending message
-    if (messageSendingIsPending) 
-    {
-      consoleSendMessage();
-    }
+  return (unsigned char)ch;
+}
 
-    if (! messageSendingIsPending) 
-    {
-      if (messageToPrint.size < CRTP_MAX_DATA_SIZE)
-      {
-        messageToPrint.data[messageToPrint.size] = (unsigned char)ch;
-        messageToPrint.size++;
-      }
+static void appendNumber(uint32_t value)
+{
+  char digits[10];
+  int count = 0;
 
-      if (ch == '\n' || messageToPrint.size >= CRTP_MAX_DATA_SIZE)
-      {
-        if (crtpGetFreeTxQueuePackets() == 1)
-        {
-          addBufferFullMarker();
-        }
-        messageSendingIsPending = true;
-        consoleSendMessage();
-      }
-    }
-    xSemaphoreGive(synch);
+  do {
+    digits[count++] = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  while (count > 0) {
+    messageToPrint.data[messageToPrint.size++] = digits[--count];
   }
+}
 
-  return (unsigned char)ch;
+static void appendText(const char *text)
+{
+  size_t length = strlen(text);
+  memcpy(&messageToPrint.data[messageToPrint.size], text, length);
+  messageToPrint.size += length;
 }
 
-int consolePutcharFromISR(int ch) {
-  BaseType_t higherPriorityTaskWoken;
+static void consoleBuildMarker(void)
+{
+  uint32_t dropped = __atomic_exchange_n(&droppedBytes, 0, __ATOMIC_ACQ_REL);
 
-  if (xSemaphoreTakeFromISR(synch, &higherPriorityTaskWoken) == pdTRUE) {
-    if (messageToPrint.size < CRTP_MAX_DATA_SIZE)
-    {
-      messageToPrint.data[messageToPrint.size] = (unsigned char)ch;
-      messageToPrint.size++;
+  appendText("<overflowed ");
+  appendNumber(dropped);
+  appendText(" bytes>\n");
+}
+
+// Fills the pending message from the ring, returns true when it is ready to send
+static bool consoleBuildMessage(void)
+{
+  const uint8_t maxSize = crtpGetMaxDataSize();
+  char ch;
+
+  if (messageToPrint.size == 0 && consoleMarkerIsDue()) {
+    consoleBuildMarker();
+    return true;
+  }
+
+  while (messageToPrint.size < maxSize && !consoleMarkerIsDue() && consoleRingPop(&ch)) {
+    if (messageToPrint.size == 0) {
+      partialStart = xTaskGetTickCount();
+    }
+    messageToPrint.data[messageToPrint.size++] = (uint8_t)ch;
+    if (ch == '\n') {
+      return true;
     }
-    xSemaphoreGiveFromISR(synch, &higherPriorityTaskWoken);
   }
 
-  return ch;
+  if (messageToPrint.size == 0) {
+    return false;
+  }
+
+  return messageToPrint.size >= maxSize || consoleMarkerIsDue() || flushRequested ||
+         (xTaskGetTickCount() - partialStart) >= M2T(CONSOLE_PARTIAL_TIMEOUT);
 }
 
-int consolePuts(char *str)
+static void consoleDrain(void)
 {
-  int ret = 0;
+  while (crtpGetFreeTxQueuePackets() > CONSOLE_TX_QUEUE_RESERVE) {
+    if (!messageSendingIsPending) {
+      messageSendingIsPending = consoleBuildMessage();
+      if (!messageSendingIsPending) {
+        break;
+      }
+    }
 
-  while(*str)
-    ret |= consolePutchar(*str++);
+    if (crtpSendPacket(&messageToPrint) != pdTRUE) {
+      break;
+    }
+    messageToPrint.size = 0;
+    messageSendingIsPending = false;
+  }
 
-  return ret;
+  if (consoleRingIsEmpty() && !messageSendingIsPending) {
+    flushRequested = false;
+  }
 }
 
-void consoleFlush(void)
+static void consoleTask(void *param)
 {
-  if (xSemaphoreTake(synch, portMAX_DELAY) == pdTRUE)
-  {
-    consoleSendMessage();
-    xSemaphoreGive(synch);
+  while (true) {
+    bool hasText = messageSendingIsPending || messageToPrint.size > 0 ||
+                   !consoleRingIsEmpty() || consoleMarkerIsDue();
+    ulTaskNotifyTake(pdTRUE, hasText ? M2T(CONSOLE_DRAIN_PERIOD) : portMAX_DELAY);
+    consoleDrain();
   }
 }
 
-
-static int findMarkerStart()
+void consoleInit()
 {
-  int start = messageToPrint.size;
-  
-  // If last char is new line, rewind one char since the marker contains a new line.
-  if (start > 0 && messageToPrint.data[start - 1] == '\n')
-  {
-    start -= 1;
+  if (isInit)
+    return;
+
+  for (uint16_t i = 0; i < CONSOLE_RING_SIZE; i++) {
+    consoleRing[i].seq = i;
   }
+  enqueuePos = 0;
+  dequeuePos = 0;
+  droppedBytes = 0;
+
+  messageToPrint.size = 0;
+  messageToPrint.header = CRTP_HEADER(CRTP_PORT_CONSOLE, 0);
+  messageSendingIsPending = false;
+
+  consoleTaskHandle = STATIC_MEM_TASK_CREATE_PINNED(consoleTask, consoleTask, CONSOLE_TASK_NAME, NULL, CONSOLE_TASK_PRI, CONSOLE_TASK_CORE);
 
-  return start;
+  isInit = true;
+}
+
+bool consoleTest(void)
+{
+  return isInit;
+}
+
+int consolePutchar(int ch)
+{
+  return consolePut(ch, xPortInIsrContext());
+}
+
+int consolePutcharFromISR(int ch)
+{
+  return consolePut(ch, true);
 }
 
-static void addBufferFullMarker()
+int consolePuts(char *str)
 {
-  // Try to add the marker after the message if it fits in the buffer, otherwise overwrite the end of the message 
-  int endMarker = findMarkerStart() + sizeof(bufferFullMsg);
-  if (endMarker >= (CRTP_MAX_DATA_SIZE)) 
-  {
-    endMarker = CRTP_MAX_DATA_SIZE;
+  int ret = 0;
+
+  while(*str)
+    ret |= consolePutchar(*str++);
+
+  return ret;
+}
+
+void consoleFlush(void)
+{
+  if (!isInit) {
+    return;
   }
 
-  int startMarker = endMarker - sizeof(bufferFullMsg);
-  memcpy(&messageToPrint.data[startMarker], bufferFullMsg, sizeof(bufferFullMsg));
-  messageToPrint.size = startMarker + sizeof(bufferFullMsg);
+  flushRequested = true;
+  xTaskNotifyGive(consoleTaskHandle);
 }
@@ -171,7 +171,7 @@ void controllerINDI(control_t *control, setpoint_t *setpoint,
 		}
 	}
 
-	if (RATE_DO_EXECUTE(POSITION_RATE, tick) && !outerLoopActive) {
+	if (RATE_DO_EXECUTE_PHASE(POSITION_RATE, POSITION_PHASE, tick) && !outerLoopActive) {
 		positionController(&actuatorThrust, &attitudeDesired, setpoint, state);
 	}
 
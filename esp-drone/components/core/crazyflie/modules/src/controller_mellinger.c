@@ -85,6 +85,11 @@ static float prev_omega_pitch;
 static float prev_setpoint_omega_roll;
 static float prev_setpoint_omega_pitch;
 
+// The desired yaw seldom changes, its sine and cosine are kept
+static float prev_desired_yaw = 0;
+static float cos_desired_yaw = 1;
+static float sin_desired_yaw = 0;
+
 static float i_error_m_x = 0;
 static float i_error_m_y = 0;
 static float i_error_m_z = 0;
@@ -199,12 +204,13 @@ void controllerMellinger(control_t *control, setpoint_t *setpoint,
 
   // yaw correction (only if position control is not used)
   if (setpoint->mode.x != modeAbs) {
-    struct vec x_yaw = mcolumn(R, 0);
-    x_yaw.z = 0;
-    x_yaw = vnormalize(x_yaw);
-    struct vec y_yaw = vcross(mkvec(0, 0, 1), x_yaw);
-    struct mat33 R_yaw_only = mcolumns(x_yaw, y_yaw, mkvec(0, 0, 1));
-    target_thrust = mvmul(R_yaw_only, target_thrust);
+    // Rotate by the yaw only, the heading of the x axis
+    float x_yaw_norm = sqrtf(fsqr(R.m[0][0]) + fsqr(R.m[1][0]));
+    float cos_yaw = R.m[0][0] / x_yaw_norm;
+    float sin_yaw = R.m[1][0] / x_yaw_norm;
+    float thrust_x = target_thrust.x;
+    target_thrust.x = cos_yaw * thrust_x - sin_yaw * target_thrust.y;
+    target_thrust.y = sin_yaw * thrust_x + cos_yaw * target_thrust.y;
   }
 
   // Current thrust [F]
@@ -215,8 +221,13 @@ void controllerMellinger(control_t *control, setpoint_t *setpoint,
 
   // [xC_des]
   // x_axis_desired = z_axis_desired x [sin(yaw), cos(yaw), 0]^T
-  x_c_des.x = cosf(radians(desiredYaw));
-  x_c_des.y = sinf(radians(desiredYaw));
+  if (desiredYaw != prev_desired_yaw) {
+    prev_desired_yaw = desiredYaw;
+    cos_desired_yaw = cosf(radians(desiredYaw));
+    sin_desired_yaw = sinf(radians(desiredYaw));
+  }
+  x_c_des.x = cos_desired_yaw;
+  x_c_des.y = sin_desired_yaw;
   x_c_des.z = 0;
   // [yB_des]
   y_axis_desired = vnormalize(vcross(z_axis_desired, x_c_des));
@@ -224,29 +235,13 @@ void controllerMellinger(control_t *control, setpoint_t *setpoint,
   x_axis_desired = vcross(y_axis_desired, z_axis_desired);
 
   // [eR]
-  // Slow version
-  // struct mat33 Rdes = mcolumns(
-  //   mkvec(x_axis_desired.x, x_axis_desired.y, x_axis_desired.z),
-  //   mkvec(y_axis_desired.x, y_axis_desired.y, y_axis_desired.z),
-  //   mkvec(z_axis_desired.x, z_axis_desired.y, z_axis_desired.z));
-
-  // struct mat33 R_transpose = mtranspose(R);
-  // struct mat33 Rdes_transpose = mtranspose(Rdes);
-
-  // struct mat33 eRM = msub(mmult(Rdes_transpose, R), mmult(R_transpose, Rdes));
-
-  // eR.x = eRM.m[2][1];
-  // eR.y = -eRM.m[0][2];
-  // eR.z = eRM.m[1][0];
-
-  // Fast version (generated using Mathematica)
-  float x = q.x;
-  float y = q.y;
-  float z = q.z;
-  float w = q.w;
-  eR.x = (-1 + 2*fsqr(x) + 2*fsqr(y))*y_axis_desired.z + z_axis_desired.y - 2*(x*y_axis_desired.x*z + y*y_axis_desired.y*z - x*y*z_axis_desired.x + fsqr(x)*z_axis_desired.y + fsqr(z)*z_axis_desired.y - y*z*z_axis_desired.z) +    2*w*(-(y*y_axis_desired.x) - z*z_axis_desired.x + x*(y_axis_desired.y + z_axis_desired.z));
-  eR.y = x_axis_desired.z - z_axis_desired.x - 2*(fsqr(x)*x_axis_desired.z + y*(x_axis_desired.z*y - x_axis_desired.y*z) - (fsqr(y) + fsqr(z))*z_axis_desired.x + x*(-(x_axis_desired.x*z) + y*z_axis_desired.y + z*z_axis_desired.z) + w*(x*x_axis_desired.y + z*z_axis_desired.y - y*(x_axis_desired.x + z_axis_desired.z)));
-  eR.z = y_axis_desired.x - 2*(y*(x*x_axis_desired.x + y*y_axis_desired.x - x*y_axis_desired.y) + w*(x*x_axis_desired.z + y*y_axis_desired.z)) + 2*(-(x_axis_desired.z*y) + w*(x_axis_desired.x + y_axis_desired.y) + x*y_axis_desired.z)*z - 2*y_axis_desired.x*fsqr(z) + x_axis_desired.y*(-1 + 2*fsqr(x) + 2*fsqr(z));
+  // eRM = Rdes^T R - R^T Rdes, eR = vee(eRM), each element being the dot
+  // products of a desired axis and a column of R
+  struct vec x_axis = mcolumn(R, 0);
+  struct vec y_axis = mcolumn(R, 1);
+  eR.x = vdot(z_axis_desired, y_axis) - vdot(y_axis_desired, z_axis);
+  eR.y = vdot(x_axis_desired, z_axis) - vdot(z_axis_desired, x_axis);
+  eR.z = vdot(y_axis_desired, x_axis) - vdot(x_axis_desired, y_axis);
 
   // Account for Crazyflie coordinate system
   eR.y = -eR.y;
@@ -294,9 +289,9 @@ void controllerMellinger(control_t *control, setpoint_t *setpoint,
   }
 
   cmd_thrust = control->thrust;
-  r_roll = radians(sensors->gyro.x);
-  r_pitch = -radians(sensors->gyro.y);
-  r_yaw = radians(sensors->gyro.z);
+  r_roll = stateAttitudeRateRoll;
+  r_pitch = stateAttitudeRatePitch;
+  r_yaw = stateAttitudeRateYaw;
   accelz = sensors->acc.z;
 
   if (control->thrust > 0) {
@@ -75,7 +75,7 @@ void controllerPid(control_t *control, setpoint_t *setpoint,
     attitudeDesired.yaw = capAngle(attitudeDesired.yaw);
   }
 
-  if (RATE_DO_EXECUTE(POSITION_RATE, tick)) {
+  if (RATE_DO_EXECUTE_PHASE(POSITION_RATE, POSITION_PHASE, tick)) {
     positionController(&actuatorThrust, &attitudeDesired, setpoint, state);
   }
 
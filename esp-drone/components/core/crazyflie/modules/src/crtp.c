@@ -37,6 +37,7 @@
 
 #include "crtp.h"
 #include "info.h"
+#include "platformservice.h"
 #include "cfassert.h"
 #include "queuemonitor.h"
 #include "static_mem.h"
@@ -58,6 +59,8 @@ static struct crtpLinkOperations nopLink = {
 };
 
 static struct crtpLinkOperations *link = &nopLink;
+// Negotiated payload size of the packets sent to the client
+static uint8_t maxDataSize = CRTP_LEGACY_DATA_SIZE;
 
 #define STATS_INTERVAL 500
 static struct {
@@ -71,16 +74,69 @@ static struct {
   uint32_t previousStatisticsTime;
 } stats;
 
-static xQueueHandle  txQueue;
-
 #define CRTP_NBR_OF_PORTS 16
-#define CRTP_TX_QUEUE_SIZE 120
 #define CRTP_RX_QUEUE_SIZE 16
+// Ports with a task queue: log, param, mem and info
+#define CRTP_RX_QUEUE_COUNT 4
+
+/*
+ * TX priority classes. Each class has its own queue and crtpTxTask always
+ * serves the most urgent non-empty one, so bulk logging never delays
+ * setpoint acks or localization replies. Every CRTP_TX_STARVATION_LIMIT
+ * packets the scan starts from the bulk class so it still drains.
+ */
+typedef enum {
+  CRTP_TX_CLASS_CRITICAL = 0,
+  CRTP_TX_CLASS_NORMAL,
+  CRTP_TX_CLASS_BULK,
+  CRTP_TX_CLASS_COUNT,
+} CrtpTxClass;
+
+#define CRTP_TX_QUEUE_SIZE_CRITICAL 20
+#define CRTP_TX_QUEUE_SIZE_NORMAL   40
+#define CRTP_TX_QUEUE_SIZE_BULK     60
+#define CRTP_TX_QUEUE_SIZE (CRTP_TX_QUEUE_SIZE_CRITICAL + CRTP_TX_QUEUE_SIZE_NORMAL + CRTP_TX_QUEUE_SIZE_BULK)
+#define CRTP_TX_STARVATION_LIMIT 8
+
+static xQueueHandle txQueues[CRTP_TX_CLASS_COUNT];
+STATIC_MEM_QUEUE_ALLOC(txQueueCritical, CRTP_TX_QUEUE_SIZE_CRITICAL, sizeof(CRTPPacket));
+STATIC_MEM_QUEUE_ALLOC(txQueueNormal, CRTP_TX_QUEUE_SIZE_NORMAL, sizeof(CRTPPacket));
+STATIC_MEM_QUEUE_ALLOC(txQueueBulk, CRTP_TX_QUEUE_SIZE_BULK, sizeof(CRTPPacket));
+// Counts packets waiting in all the TX queues, crtpTxTask blocks on it
+static xSemaphoreHandle txPending;
+STATIC_MEM_SEMAPHORE_ALLOC(txPending);
+
+// Packets dropped because their TX class queue was full, per port
+static uint16_t txDrops[CRTP_NBR_OF_PORTS];
+
+static CrtpTxClass txClass(const CRTPPacket *p)
+{
+  switch (p->port) {
+    case CRTP_PORT_SETPOINT:
+    case CRTP_PORT_SETPOINT_GENERIC:
+    case CRTP_PORT_SETPOINT_HL:
+    case CRTP_PORT_LOCALIZATION:
+    case CRTP_PORT_LINK:
+      return CRTP_TX_CLASS_CRITICAL;
+    case CRTP_PORT_PLATFORM:
+      // The app-channel stream can fill a queue, keep it away from the platform replies
+      return (p->channel == PLATFORMSERVICE_APP_STREAM_CHANNEL) ? CRTP_TX_CLASS_BULK : CRTP_TX_CLASS_CRITICAL;
+    case CRTP_PORT_CONSOLE:
+    case CRTP_PORT_LOG:
+      return CRTP_TX_CLASS_BULK;
+    default:
+      return CRTP_TX_CLASS_NORMAL;
+  }
+}
 
 static void crtpTxTask(void *param);
 static void crtpRxTask(void *param);
 
 static xQueueHandle queues[CRTP_NBR_OF_PORTS];
+// RX queues of the ports served by a task, handed out by crtpInitTaskQueue()
+static StaticQueue_t osSys_rxQueuesMgm[CRTP_RX_QUEUE_COUNT];
+NO_DMA_CCM_SAFE_ZERO_INIT static uint8_t osSys_rxQueuesStorage[CRTP_RX_QUEUE_COUNT][CRTP_RX_QUEUE_SIZE * sizeof(CRTPPacket)];
+static int rxQueuesUsed;
 static volatile CrtpCallback callbacks[CRTP_NBR_OF_PORTS];
 static void updateStats();
 
@@ -92,11 +148,16 @@ void crtpInit(void)
   if(isInit)
     return;
 
-  txQueue = xQueueCreate(CRTP_TX_QUEUE_SIZE, sizeof(CRTPPacket));
-  DEBUG_QUEUE_MONITOR_REGISTER(txQueue);
+  txQueues[CRTP_TX_CLASS_CRITICAL] = STATIC_MEM_QUEUE_CREATE(txQueueCritical);
+  txQueues[CRTP_TX_CLASS_NORMAL] = STATIC_MEM_QUEUE_CREATE(txQueueNormal);
+  txQueues[CRTP_TX_CLASS_BULK] = STATIC_MEM_QUEUE_CREATE(txQueueBulk);
+  for (int i = 0; i < CRTP_TX_CLASS_COUNT; i++) {
+    DEBUG_QUEUE_MONITOR_REGISTER_INDEXED(txQueues[i], "crtpTx", i);
+  }
+  txPending = STATIC_MEM_COUNTING_SEMAPHORE_CREATE(txPending, CRTP_TX_QUEUE_SIZE, 0);
 
-  STATIC_MEM_TASK_CREATE(crtpTxTask, crtpTxTask, CRTP_TX_TASK_NAME, NULL, CRTP_TX_TASK_PRI);
-  STATIC_MEM_TASK_CREATE(crtpRxTask, crtpRxTask, CRTP_RX_TASK_NAME, NULL, CRTP_RX_TASK_PRI);
+  STATIC_MEM_TASK_CREATE_PINNED(crtpTxTask, crtpTxTask, CRTP_TX_TASK_NAME, NULL, CRTP_TX_TASK_PRI, CRTP_TX_TASK_CORE);
+  STATIC_MEM_TASK_CREATE_PINNED(crtpRxTask, crtpRxTask, CRTP_RX_TASK_NAME, NULL, CRTP_RX_TASK_PRI, CRTP_RX_TASK_CORE);
 
   isInit = true;
 }
@@ -109,9 +170,11 @@ bool crtpTest(void)
 void crtpInitTaskQueue(CRTPPort portId)
 {
   ASSERT(queues[portId] == NULL);
+  ASSERT(rxQueuesUsed < CRTP_RX_QUEUE_COUNT);
 
-  queues[portId] = xQueueCreate(CRTP_RX_QUEUE_SIZE, sizeof(CRTPPacket));
-  DEBUG_QUEUE_MONITOR_REGISTER(queues[portId]);
+  int i = rxQueuesUsed++;
+  queues[portId] = xQueueCreateStatic(CRTP_RX_QUEUE_SIZE, sizeof(CRTPPacket), osSys_rxQueuesStorage[i], &osSys_rxQueuesMgm[i]);
+  DEBUG_QUEUE_MONITOR_REGISTER_INDEXED(queues[portId], "crtpRx", portId);
 }
 
 int crtpReceivePacket(CRTPPort portId, CRTPPacket *p)
@@ -141,18 +204,33 @@ int crtpReceivePacketWait(CRTPPort portId, CRTPPacket *p, int wait)
 
 int crtpGetFreeTxQueuePackets(void)
 {
-  return (CRTP_TX_QUEUE_SIZE - uxQueueMessagesWaiting(txQueue));
+  return (CRTP_TX_QUEUE_SIZE_BULK - uxQueueMessagesWaiting(txQueues[CRTP_TX_CLASS_BULK]));
+}
+
+static bool txReceive(CRTPPacket *p, bool bulkFirst)
+{
+  if (bulkFirst && xQueueReceive(txQueues[CRTP_TX_CLASS_BULK], p, 0) == pdTRUE) {
+    return true;
+  }
+  for (int i = 0; i < CRTP_TX_CLASS_COUNT; i++) {
+    if (xQueueReceive(txQueues[i], p, 0) == pdTRUE) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void crtpTxTask(void *param)
 {
   CRTPPacket p;
+  uint32_t sent = 0;
 
   while (true)
   {
     if (link != &nopLink)
     {
-      if (xQueueReceive(txQueue, &p, portMAX_DELAY) == pdTRUE)
+      if (xSemaphoreTake(txPending, portMAX_DELAY) == pdTRUE &&
+          txReceive(&p, ++sent % CRTP_TX_STARVATION_LIMIT == 0))
       {
         // Keep testing, if the link changes to USB it will go though
         while (link->sendPacket(&p) == false)
@@ -171,34 +249,42 @@ void crtpTxTask(void *param)
   }
 }
 
+void crtpDispatchPacket(CRTPPacket *p)
+{
+  if (queues[p->port])
+  {
+    BaseType_t result = xQueueSend(queues[p->port], p, 0);
+    DEBUG_QUEUE_MONITOR_SEND(queues[p->port], result == pdTRUE);
+    if (result == errQUEUE_FULL)
+    {
+      // We should never drop packet
+      printf("CRTP RX queue full\n");
+      printf("Port: %d\n", p->port);
+      ASSERT(0);
+    }
+  }
+
+  if (callbacks[p->port])
+  {
+    callbacks[p->port](p);
+  }
+
+  stats.rxCount++;
+  updateStats();
+}
+
 void crtpRxTask(void *param)
 {
   CRTPPacket p;
 
   while (true)
   {
-    if (link != &nopLink)
+    // Links without receivePacket dispatch their packets themselves
+    if (link != &nopLink && link->receivePacket)
     {
       if (!link->receivePacket(&p))
       {
-        if (queues[p.port])
-        {
-          if (xQueueSend(queues[p.port], &p, 0) == errQUEUE_FULL)
-          {
-            // We should never drop packet
-            printf("CRTP RX queue full\n");
-            printf("Port: %d\n", p.port);
-            ASSERT(0);
-          }
-        }
-
-        if (callbacks[p.port])
-        {
-          callbacks[p.port](&p);
-        }
-
-        stats.rxCount++;
-        updateStats();
+        crtpDispatchPacket(&p);
       }
     }
     else
@@ -216,25 +302,38 @@ void crtpRegisterPortCB(int port, CrtpCallback cb)
   callbacks[port] = cb;
 }
 
-int crtpSendPacket(CRTPPacket *p)
+static int txSend(CRTPPacket *p, TickType_t wait)
 {
   ASSERT(p);
   ASSERT(p->size <= CRTP_MAX_DATA_SIZE);
 
-  return xQueueSend(txQueue, p, 0);
+  xQueueHandle queue = txQueues[txClass(p)];
+  bool sent = (xQueueSend(queue, p, wait) == pdTRUE);
+  DEBUG_QUEUE_MONITOR_SEND(queue, sent);
+  if (!sent) {
+    txDrops[p->port]++;
+    return pdFALSE;
+  }
+  xSemaphoreGive(txPending);
+  return pdTRUE;
 }
 
-int crtpSendPacketBlock(CRTPPacket *p)
+int crtpSendPacket(CRTPPacket *p)
 {
-  ASSERT(p);
-  ASSERT(p->size <= CRTP_MAX_DATA_SIZE);
+  return txSend(p, 0);
+}
 
-  return xQueueSend(txQueue, p, portMAX_DELAY);
+int crtpSendPacketBlock(CRTPPacket *p)
+{
+  return txSend(p, portMAX_DELAY);
 }
 
 int crtpReset(void)
 {
-  xQueueReset(txQueue);
+  for (int i = 0; i < CRTP_TX_CLASS_COUNT; i++) {
+    xQueueReset(txQueues[i]);
+  }
+  xQueueReset(txPending);
   if (link->reset) {
     link->reset();
   }
@@ -249,6 +348,40 @@ bool crtpIsConnected(void)
   return true;
 }
 
+uint8_t crtpGetMaxDataSize(void)
+{
+  return maxDataSize;
+}
+
+uint8_t crtpSetMaxDataSize(uint8_t size)
+{
+  uint8_t linkMax = link->getMaxDataSize ? link->getMaxDataSize() : CRTP_LEGACY_DATA_SIZE;
+
+  if (size > linkMax) {
+    size = linkMax;
+  }
+  if (size < CRTP_LEGACY_DATA_SIZE) {
+    size = CRTP_LEGACY_DATA_SIZE;
+  }
+  maxDataSize = size;
+  DEBUG_PRINT("Packet data size set to %d\n", maxDataSize);
+
+  return maxDataSize;
+}
+
+uint16_t crtpGetMaxBulkSize(void)
+{
+  return link->getMaxBulkSize ? link->getMaxBulkSize() : 0;
+}
+
+bool crtpSendBulkPacket(uint8_t header, const uint8_t *data, uint16_t size)
+{
+  if (size > crtpGetMaxBulkSize()) {
+    return false;
+  }
+  return link->sendBulkPacket(header, data, size);
+}
+
 void crtpSetLink(struct crtpLinkOperations * lk)
 {
   if(link)
@@ -259,6 +392,8 @@ void crtpSetLink(struct crtpLinkOperations * lk)
   else
     link = &nopLink;
 
+  maxDataSize = CRTP_LEGACY_DATA_SIZE;
+
   link->setEnable(true);
 }
 
@@ -290,4 +425,14 @@ static void updateStats()
 LOG_GROUP_START(crtp)
 LOG_ADD(LOG_UINT16, rxRate, &stats.rxRate)
 LOG_ADD(LOG_UINT16, txRate, &stats.txRate)
+LOG_ADD(LOG_UINT16, dropConsole, &txDrops[CRTP_PORT_CONSOLE])
+LOG_ADD(LOG_UINT16, dropParam, &txDrops[CRTP_PORT_PARAM])
+LOG_ADD(LOG_UINT16, dropSetpoint, &txDrops[CRTP_PORT_SETPOINT])
+LOG_ADD(LOG_UINT16, dropMem, &txDrops[CRTP_PORT_MEM])
+LOG_ADD(LOG_UINT16, dropLog, &txDrops[CRTP_PORT_LOG])
+LOG_ADD(LOG_UINT16, dropLoc, &txDrops[CRTP_PORT_LOCALIZATION])
+LOG_ADD(LOG_UINT16, dropGeneric, &txDrops[CRTP_PORT_SETPOINT_GENERIC])
+LOG_ADD(LOG_UINT16, dropHl, &txDrops[CRTP_PORT_SETPOINT_HL])
+LOG_ADD(LOG_UINT16, dropPlatform, &txDrops[CRTP_PORT_PLATFORM])
+LOG_ADD(LOG_UINT16, dropLink, &txDrops[CRTP_PORT_LINK])
 LOG_GROUP_STOP(tdoa)
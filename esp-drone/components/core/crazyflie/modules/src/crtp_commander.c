@@ -25,6 +25,7 @@
  */
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "crtp_commander.h"
 
@@ -106,6 +107,23 @@ const static metaCommandDecoder_t metaCommandDecoders[] = {
   [metaNotifySetpointsStop] = notifySetpointsStopDecoder,
 };
 
+void crtpCommanderSetRpytSetpoint(float roll, float pitch, float yaw, uint16_t thrust)
+{
+  // Callers run on another task than the CRTP RX task, hence a setpoint of their own
+  static setpoint_t setpoint;
+  CRTPPacket pk;
+
+  pk.header = CRTP_HEADER(CRTP_PORT_SETPOINT, 0);
+  pk.size = 3 * sizeof(float) + sizeof(uint16_t);
+  memcpy(&pk.data[0], &roll, sizeof(float));
+  memcpy(&pk.data[4], &pitch, sizeof(float));
+  memcpy(&pk.data[8], &yaw, sizeof(float));
+  memcpy(&pk.data[12], &thrust, sizeof(uint16_t));
+
+  crtpCommanderRpytDecodeSetpoint(&setpoint, &pk);
+  commanderSetSetpoint(&setpoint, COMMANDER_PRIORITY_CRTP);
+}
+
 /* Decoder switch */
 static void commanderCrtpCB(CRTPPacket* pk)
 {
@@ -100,6 +100,12 @@ static struct vec vel; // last known setpoint (velocity [m/s])
 static float yaw; // last known setpoint yaw (yaw [rad])
 static struct piecewise_traj trajectory;
 static struct piecewise_traj_compressed  compressed_trajectory;
+static struct piecewise_traj_stream stream_trajectory;
+static uint8_t stream_trajectory_id = NUM_TRAJECTORY_DEFINITIONS; // none defined
+static struct poly4d coverage_pieces[NUM_COVERAGE_PIECES];
+static struct piecewise_traj coverage_trajectory = { .pieces = coverage_pieces };
+static float coverage_speed; // speed the coverage trajectory was planned for (m/s)
+static float speed_limit; // limit of the coverage speed (m/s), 0 if none
 
 // makes sure that we don't evaluate the trajectory while it is being changed
 static xSemaphoreHandle lockTraj;
@@ -137,6 +143,9 @@ enum TrajectoryCommand_e {
   COMMAND_LAND_2                  = 8,
   COMMAND_TAKEOFF_WITH_VELOCITY   = 9,
   COMMAND_LAND_WITH_VELOCITY      = 10,
+  COMMAND_START_COVERAGE          = 11,
+  COMMAND_APPEND_TRAJECTORY       = 12,
+  COMMAND_SET_SPEED_LIMIT         = 13,
 };
 
 struct data_set_group_mask {
@@ -224,6 +233,29 @@ struct data_start_trajectory {
   float timescale; // time factor; 1 = original speed; >1: slower; <1: faster
 } __attribute__((packed));
 
+// appends pieces, already written to trajectory memory, to a streamed trajectory
+struct data_append_trajectory {
+  uint8_t trajectoryId; // id of the trajectory (previously defined by COMMAND_DEFINE_TRAJECTORY)
+  uint8_t nPieces;      // pieces written after the last one appended
+  uint8_t last;         // set to true, if no more pieces follow
+} __attribute__((packed));
+
+// plans a coverage trajectory on board and starts it from the current setpoint
+struct data_start_coverage {
+  uint8_t groupMask; // mask for which CFs this should apply to
+  uint8_t pattern;   // one of crtpCommanderCoveragePattern_t
+  float spacing;     // m, between the turns of the spiral or the lanes of the zigzag
+  float width;       // m, outer radius of the spiral or length of the lanes of the zigzag
+  float length;      // m, covered across the lanes of the zigzag, unused by the spiral
+  float speed;       // m/s, along the path
+} __attribute__((packed));
+
+// limits the speed of the coverage trajectories, the current one included
+struct data_set_speed_limit {
+  uint8_t groupMask; // mask for which CFs this should apply to
+  float speed;       // m/s, along the path; 0 lifts the limit
+} __attribute__((packed));
+
 // starts executing a specified trajectory
 struct data_define_trajectory {
   uint8_t trajectoryId;
@@ -244,6 +276,9 @@ static int stop(const struct data_stop* data);
 static int go_to(const struct data_go_to* data);
 static int start_trajectory(const struct data_start_trajectory* data);
 static int define_trajectory(const struct data_define_trajectory* data);
+static int start_coverage(const struct data_start_coverage* data);
+static int append_trajectory(const struct data_append_trajectory* data);
+static int set_speed_limit(const struct data_set_speed_limit* data);
 
 // Helper functions
 static struct vec state2vec(struct vec3_s v)
@@ -265,7 +300,7 @@ void crtpCommanderHighLevelInit(void)
   plan_init(&planner);
 
   //Start the trajectory task
-  STATIC_MEM_TASK_CREATE(crtpCommanderHighLevelTask, crtpCommanderHighLevelTask, CMD_HIGH_LEVEL_TASK_NAME, NULL, CMD_HIGH_LEVEL_TASK_PRI);
+  STATIC_MEM_TASK_CREATE_PINNED(crtpCommanderHighLevelTask, crtpCommanderHighLevelTask, CMD_HIGH_LEVEL_TASK_NAME, NULL, CMD_HIGH_LEVEL_TASK_PRI, CMD_HIGH_LEVEL_TASK_CORE);
 
   lockTraj = xSemaphoreCreateMutexStatic(&lockTrajBuffer);
 
@@ -376,6 +411,15 @@ static int handleCommand(const enum TrajectoryCommand_e command, const uint8_t*
     case COMMAND_DEFINE_TRAJECTORY:
       ret = define_trajectory((const struct data_define_trajectory*)data);
       break;
+    case COMMAND_START_COVERAGE:
+      ret = start_coverage((const struct data_start_coverage*)data);
+      break;
+    case COMMAND_APPEND_TRAJECTORY:
+      ret = append_trajectory((const struct data_append_trajectory*)data);
+      break;
+    case COMMAND_SET_SPEED_LIMIT:
+      ret = set_speed_limit((const struct data_set_speed_limit*)data);
+      break;
     default:
       ret = ENOEXEC;
       break;
@@ -613,6 +657,28 @@ int start_trajectory(const struct data_start_trajectory* data)
           xSemaphoreGive(lockTraj);
         }
 
+      } else if (trajDesc->trajectoryLocation == TRAJECTORY_LOCATION_MEM
+          && trajDesc->trajectoryType == CRTP_CHL_TRAJECTORY_TYPE_POLY4D_STREAM
+          && data->trajectoryId == stream_trajectory_id) {
+
+        if (data->timescale != 1 || data->reversed) {
+          result = ENOEXEC;
+        } else {
+          xSemaphoreTake(lockTraj, portMAX_DELAY);
+          if (stream_trajectory.count == 0) {
+            result = ENOEXEC;
+          } else {
+            float t = usecTimestamp() / 1e6;
+            stream_trajectory.t_begin = t;
+            stream_trajectory.shift = vzero();
+            if (data->relative) {
+              struct traj_eval traj_init = piecewise_stream_eval(&stream_trajectory, t);
+              stream_trajectory.shift = vsub(pos, traj_init.pos);
+            }
+            result = plan_start_stream_trajectory(&planner, &stream_trajectory);
+          }
+          xSemaphoreGive(lockTraj);
+        }
       }
     }
   }
@@ -624,7 +690,106 @@ int define_trajectory(const struct data_define_trajectory* data)
   if (data->trajectoryId >= NUM_TRAJECTORY_DEFINITIONS) {
     return ENOEXEC;
   }
+
+  if (data->description.trajectoryType == CRTP_CHL_TRAJECTORY_TYPE_POLY4D_STREAM) {
+    uint32_t offset = data->description.trajectoryIdentifier.mem.offset;
+    uint8_t n_slots = data->description.trajectoryIdentifier.mem.n_pieces;
+    if (n_slots == 0 || offset + n_slots * sizeof(struct poly4d) > sizeof(trajectories_memory)) {
+      return ENOEXEC;
+    }
+
+    int result = 0;
+    xSemaphoreTake(lockTraj, portMAX_DELAY);
+    // There is a single stream, it can not be redefined while it is flown
+    if (!plan_is_stopped(&planner) && planner.type == TRAJECTORY_TYPE_PIECEWISE_STREAM) {
+      result = ENOEXEC;
+    } else {
+      trajectory_descriptions[data->trajectoryId] = data->description;
+      piecewise_stream_init(&stream_trajectory, (struct poly4d*)&trajectories_memory[offset], n_slots);
+      stream_trajectory_id = data->trajectoryId;
+    }
+    xSemaphoreGive(lockTraj);
+    return result;
+  }
+
   trajectory_descriptions[data->trajectoryId] = data->description;
+  if (data->trajectoryId == stream_trajectory_id) {
+    stream_trajectory_id = NUM_TRAJECTORY_DEFINITIONS;
+  }
+  return 0;
+}
+
+int append_trajectory(const struct data_append_trajectory* data)
+{
+  if (data->trajectoryId != stream_trajectory_id) {
+    return ENOEXEC;
+  }
+
+  int result = 0;
+  xSemaphoreTake(lockTraj, portMAX_DELAY);
+  if (!piecewise_stream_append(&stream_trajectory, data->nPieces, data->last)) {
+    result = stream_trajectory.complete ? ENOEXEC : ENOMEM;
+  }
+  xSemaphoreGive(lockTraj);
+  return result;
+}
+
+// time factor keeping the coverage trajectory under the speed limit
+static float coverage_timescale(void)
+{
+  if (speed_limit > 0 && coverage_speed > speed_limit) {
+    return coverage_speed / speed_limit;
+  }
+  return 1.0f;
+}
+
+int start_coverage(const struct data_start_coverage* data)
+{
+  int result = 0;
+  if (isInGroup(data->groupMask)) {
+    xSemaphoreTake(lockTraj, portMAX_DELAY);
+    bool planned = false;
+    if (data->pattern == CRTP_CHL_COVERAGE_SPIRAL) {
+      planned = piecewise_plan_spiral(&coverage_trajectory, NUM_COVERAGE_PIECES,
+        pos, yaw, data->spacing, data->width, data->speed);
+    } else if (data->pattern == CRTP_CHL_COVERAGE_ZIGZAG) {
+      planned = piecewise_plan_zigzag(&coverage_trajectory, NUM_COVERAGE_PIECES,
+        pos, yaw, data->spacing, data->width, data->length, data->speed);
+    }
+
+    if (planned) {
+      coverage_speed = data->speed;
+      coverage_trajectory.timescale = coverage_timescale();
+      coverage_trajectory.t_begin = usecTimestamp() / 1e6;
+      result = plan_start_trajectory(&planner, &coverage_trajectory, false);
+    } else {
+      result = ENOEXEC;
+    }
+    xSemaphoreGive(lockTraj);
+  }
+  return result;
+}
+
+int set_speed_limit(const struct data_set_speed_limit* data)
+{
+  if (!isInGroup(data->groupMask)) {
+    return 0;
+  }
+  if (!(data->speed >= 0)) {
+    return EINVAL;
+  }
+
+  xSemaphoreTake(lockTraj, portMAX_DELAY);
+  speed_limit = data->speed;
+  if (!plan_is_stopped(&planner) && planner.type == TRAJECTORY_TYPE_PIECEWISE
+      && planner.trajectory == &coverage_trajectory) {
+    // keeps the progress along the path, so the setpoint does not jump
+    float t = usecTimestamp() / 1e6;
+    float timescale = coverage_timescale();
+    coverage_trajectory.t_begin = t - (t - coverage_trajectory.t_begin) / coverage_trajectory.timescale * timescale;
+    coverage_trajectory.timescale = timescale;
+  }
+  xSemaphoreGive(lockTraj);
   return 0;
 }
 
@@ -773,6 +938,44 @@ int crtpCommanderHighLevelStartTrajectory(const uint8_t trajectoryId, const floa
   return handleCommand(COMMAND_START_TRAJECTORY, (const uint8_t*)&data);
 }
 
+int crtpCommanderHighLevelStartCoverage(const crtpCommanderCoveragePattern_t pattern, const float spacing, const float width, const float length, const float speed)
+{
+  struct data_start_coverage data =
+  {
+    .pattern = pattern,
+    .spacing = spacing,
+    .width = width,
+    .length = length,
+    .speed = speed,
+    .groupMask = ALL_GROUPS,
+  };
+
+  return handleCommand(COMMAND_START_COVERAGE, (const uint8_t*)&data);
+}
+
+int crtpCommanderHighLevelSetSpeedLimit(const float speed)
+{
+  struct data_set_speed_limit data =
+  {
+    .speed = speed,
+    .groupMask = ALL_GROUPS,
+  };
+
+  return handleCommand(COMMAND_SET_SPEED_LIMIT, (const uint8_t*)&data);
+}
+
+int crtpCommanderHighLevelAppendTrajectory(const uint8_t trajectoryId, const uint8_t nPieces, const bool last)
+{
+  struct data_append_trajectory data =
+  {
+    .trajectoryId = trajectoryId,
+    .nPieces = nPieces,
+    .last = last,
+  };
+
+  return handleCommand(COMMAND_APPEND_TRAJECTORY, (const uint8_t*)&data);
+}
+
 int crtpCommanderHighLevelDefineTrajectory(const uint8_t trajectoryId, const crtpCommanderTrajectoryType_t type, const uint32_t offset, const uint8_t nPieces)
 {
   struct data_define_trajectory data =
@@ -792,11 +995,36 @@ uint32_t crtpCommanderHighLevelTrajectoryMemSize()
   return sizeof(trajectories_memory);
 }
 
+// Whether a write overlaps a piece of the stream still to be flown
+static bool isStreamWriteBusy(const uint32_t offset, const uint32_t length)
+{
+  if (stream_trajectory_id >= NUM_TRAJECTORY_DEFINITIONS || length == 0) {
+    return false;
+  }
+
+  const uint32_t ringBegin = (uint8_t*)stream_trajectory.ring - trajectories_memory;
+  const uint32_t ringEnd = ringBegin + stream_trajectory.n_slots * sizeof(struct poly4d);
+  const uint32_t begin = offset > ringBegin ? offset : ringBegin;
+  const uint32_t end = offset + length < ringEnd ? offset + length : ringEnd;
+  if (begin >= end) {
+    return false;
+  }
+
+  const uint32_t firstSlot = (begin - ringBegin) / sizeof(struct poly4d);
+  const uint32_t lastSlot = (end - 1 - ringBegin) / sizeof(struct poly4d);
+  for (uint32_t slot = firstSlot; slot <= lastSlot; slot++) {
+    if (piecewise_stream_is_busy(&stream_trajectory, slot)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool crtpCommanderHighLevelWriteTrajectory(const uint32_t offset, const uint32_t length, const uint8_t* data)
 {
   bool result = false;
 
-  if ((offset + length) <= sizeof(trajectories_memory)) {
+  if ((offset + length) <= sizeof(trajectories_memory) && !isStreamWriteBusy(offset, length)) {
     memcpy(&(trajectories_memory[offset]), data, length);
     result = true;
   }
@@ -820,6 +1048,15 @@ bool crtpCommanderHighLevelIsTrajectoryFinished() {
   return plan_is_finished(&planner, t);
 }
 
+/**
+ * Streamed trajectory: pieces in the ring still to be flown, and the times
+ * the drone ran out of pieces before the last one came
+ */
+LOG_GROUP_START(hlCommander)
+LOG_ADD(LOG_UINT8, streamCount, &stream_trajectory.count)
+LOG_ADD(LOG_UINT16, underruns, &stream_trajectory.underruns)
+LOG_GROUP_STOP(hlCommander)
+
 PARAM_GROUP_START(hlCommander)
 PARAM_ADD(PARAM_FLOAT, vtoff, &defaultTakeoffVelocity)
 PARAM_ADD(PARAM_FLOAT, vland, &defaultLandingVelocity)
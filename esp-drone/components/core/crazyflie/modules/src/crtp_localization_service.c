@@ -48,6 +48,7 @@
 #include "peer_localization.h"
 
 #include "num.h"
+#include "usec_time.h"
 
 #define NBR_OF_RANGES_IN_PACKET   5
 #define NBR_OF_SWEEPS_IN_PACKET   2
@@ -117,6 +118,10 @@ static float extQuatStdDev = 4.5e-3;
 static bool isInit = false;
 static uint8_t my_id;
 static uint16_t tickOfLastPacket; // tick when last packet was received
+// UDP fast path: samples older than extMaxAge (ms) are dropped
+static uint16_t extMaxAge = 100;
+static uint32_t extSampleAge;     // age of the last timestamped sample (us)
+static uint32_t extSampleStale;   // samples dropped for being too old
 
 static void locSrvCrtpCB(CRTPPacket* pk);
 static void extPositionHandler(CRTPPacket* pk);
@@ -310,6 +315,51 @@ static void extPositionPackedHandler(CRTPPacket* pk)
   }
 }
 
+bool locSrvEnqueueExtSample(const void *sample, uint32_t size, uint64_t receiveTime)
+{
+  struct ExtPoseSample data;
+  if (size != sizeof(struct ExtPositionSample) && size != sizeof(struct ExtPoseSample)) {
+    return false;
+  }
+  memcpy(&data, sample, size);
+
+  if (data.position.timestamp != 0) {
+    // Both times are the drone clock, the sender mapping its own onto it.
+    // A sample from slightly ahead (sync error) counts as fresh
+    int32_t age = (int32_t)((uint32_t)receiveTime - data.position.timestamp);
+    extSampleAge = age > 0 ? age : 0;
+    if (extSampleAge > extMaxAge * 1000u) {
+      extSampleStale++;
+      return true;
+    }
+  }
+
+  // Enqueued from the link task, not the CRTP one: local measurements,
+  // ext_pos only mirrors the last one for logging
+  if (size == sizeof(struct ExtPoseSample)) {
+    poseMeasurement_t pose;
+    pose.x = data.position.x;
+    pose.y = data.position.y;
+    pose.z = data.position.z;
+    quatdecompress(data.quat, (float *)&pose.quat.q0);
+    pose.stdDevPos = extPosStdDev;
+    pose.stdDevQuat = extQuatStdDev;
+    estimatorEnqueuePose(&pose);
+  } else {
+    positionMeasurement_t pos;
+    pos.x = data.position.x;
+    pos.y = data.position.y;
+    pos.z = data.position.z;
+    pos.stdDev = extPosStdDev;
+    estimatorEnqueuePosition(&pos);
+  }
+  ext_pos.x = data.position.x;
+  ext_pos.y = data.position.y;
+  ext_pos.z = data.position.z;
+  tickOfLastPacket = xTaskGetTickCount();
+  return true;
+}
+
 void locSrvSendRangeFloat(uint8_t id, float range)
 {
   rangePacket *rp = (rangePacket *)pkRange.data;
@@ -369,6 +419,8 @@ LOG_GROUP_STOP(ext_pos)
 
 LOG_GROUP_START(locSrvZ)
   LOG_ADD(LOG_UINT16, tick, &tickOfLastPacket)  // time when data was received last (ms/ticks)
+  LOG_ADD(LOG_UINT32, extAge, &extSampleAge)     // age of the last UDP fast path sample (us)
+  LOG_ADD(LOG_UINT32, extStale, &extSampleStale) // UDP fast path samples dropped as too old
 LOG_GROUP_STOP(locSrvZ)
 
 PARAM_GROUP_START(locSrv)
@@ -376,4 +428,5 @@ PARAM_GROUP_START(locSrv)
   PARAM_ADD(PARAM_UINT8, enLhAngleStream, &enableLighthouseAngleStream)
   PARAM_ADD(PARAM_FLOAT, extPosStdDev, &extPosStdDev)
   PARAM_ADD(PARAM_FLOAT, extQuatStdDev, &extQuatStdDev)
+  PARAM_ADD(PARAM_UINT16, extMaxAge, &extMaxAge)
 PARAM_GROUP_STOP(locSrv)
@@ -0,0 +1,360 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * dsp_bench.c - Cycle counts of the dsp_lib kernels against plain C loops
+ */
+
+#include "dsp_bench.h"
+
+#ifdef CONFIG_DSP_BENCHMARK
+
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "timers.h"
+
+#include "dynamic_notch.h"
+#include "filter.h"
+#include "kalman_core.h"
+#include "param.h"
+#include "physicalConstants.h"
+#include "statsCnt.h"
+#include "worker.h"
+#include "xtensa_math.h"
+
+#define DEBUG_MODULE "DSPBENCH"
+#include "debug_cf.h"
+
+#define MAT_DIM KC_STATE_DIM
+#define INV_DIM_SMALL 3
+#define FFT_LEN DYN_NOTCH_FFT_LEN
+// Samples per call of the block filters, the firmware filters one per call
+#define BIQUAD_BLOCK 32
+
+typedef struct {
+  uint32_t min;
+  uint64_t total;
+} benchTime_t;
+
+typedef void (*benchFunc_t)(void);
+
+static bool isInit = false;
+static uint8_t runRequest = 1;
+static StaticTimer_t timerBuffer;
+
+static uint16_t invDim;
+static uint16_t biquadLength;
+
+static float matA[MAT_DIM * MAT_DIM];
+static float matB[MAT_DIM * MAT_DIM];
+static float matDsp[MAT_DIM * MAT_DIM];
+static float matNaive[MAT_DIM * MAT_DIM];
+static float invWork[MAT_DIM * MAT_DIM];
+static float invAugmented[MAT_DIM * 2 * MAT_DIM];
+static xtensa_matrix_instance_f32 matAInst, matBInst, matDspInst, invWorkInst;
+
+static float fftIn[FFT_LEN];
+static float fftWork[FFT_LEN];
+static float fftDsp[FFT_LEN];
+static float fftNaive[FFT_LEN];
+static float fftCos[FFT_LEN];
+static float fftSin[FFT_LEN];
+static xtensa_rfft_fast_instance_f32 fft;
+
+static float biquadIn[BIQUAD_BLOCK];
+static float biquadDsp[BIQUAD_BLOCK];
+static float biquadNaive[BIQUAD_BLOCK];
+static float biquadCoeffs[5];
+static float biquadState[4];
+static xtensa_biquad_casd_df1_inst_f32 biquad;
+static lpf2pData lpf;
+
+static void benchRequestTimer(xTimerHandle timer);
+
+void dspBenchInit(void)
+{
+  if (isInit) {
+    return;
+  }
+
+  xTimerHandle timer = xTimerCreateStatic("dspBenchTimer", M2T(1000), pdTRUE, NULL, benchRequestTimer, &timerBuffer);
+  xTimerStart(timer, 100);
+
+  isInit = true;
+}
+
+static void benchRequestTimer(xTimerHandle timer)
+{
+  if (runRequest && workerSchedulePriority(dspBenchRun, NULL, workerPriorityLow) == 0) {
+    runRequest = 0;
+  }
+}
+
+static uint32_t benchTime(benchFunc_t setup, benchFunc_t function, benchTime_t *time)
+{
+  time->min = UINT32_MAX;
+  time->total = 0;
+  for (int run = 0; run < DSP_BENCH_RUNS; run++) {
+    if (setup) {
+      setup();
+    }
+    uint32_t start = statsCntCycles();
+    function();
+    uint32_t cycles = statsCntCycles() - start;
+
+    if (cycles < time->min) {
+      time->min = cycles;
+    }
+    time->total += cycles;
+  }
+  return time->min;
+}
+
+static float maxDifference(const float *a, const float *b, int length)
+{
+  float max = 0.0f;
+  for (int i = 0; i < length; i++) {
+    float difference = fabsf(a[i] - b[i]);
+    if (difference > max) {
+      max = difference;
+    }
+  }
+  return max;
+}
+
+// Prints the times of a kernel and of its plain C version, and how far their results are apart
+static void benchCompare(const char *name, benchFunc_t setup, benchFunc_t dsp, benchFunc_t naive,
+                         const float *dspResult, const float *naiveResult, int length)
+{
+  benchTime_t dspTime;
+  benchTime_t naiveTime;
+  benchTime(setup, dsp, &dspTime);
+  benchTime(setup, naive, &naiveTime);
+
+  DEBUG_PRINTI("%-18s %8"PRIu32" %8"PRIu32" %8"PRIu32" %8"PRIu32" %6.2f %9.2e\n", name,
+               dspTime.min, (uint32_t)(dspTime.total / DSP_BENCH_RUNS),
+               naiveTime.min, (uint32_t)(naiveTime.total / DSP_BENCH_RUNS),
+               (double)naiveTime.min / dspTime.min,
+               (double)maxDifference(dspResult, naiveResult, length));
+}
+
+/* Matrix product of the covariance size */
+
+static void matMultDsp(void)
+{
+  xtensa_mat_mult_f32(&matAInst, &matBInst, &matDspInst);
+}
+
+static void matMultNaive(void)
+{
+  for (int i = 0; i < MAT_DIM; i++) {
+    for (int j = 0; j < MAT_DIM; j++) {
+      float sum = 0.0f;
+      for (int k = 0; k < MAT_DIM; k++) {
+        sum += matA[i * MAT_DIM + k] * matB[k * MAT_DIM + j];
+      }
+      matNaive[i * MAT_DIM + j] = sum;
+    }
+  }
+}
+
+/* Matrix inverse, the kernel inverts its source in place */
+
+static void matInverseSetup(void)
+{
+  memcpy(invWork, matA, invDim * invDim * sizeof(float));
+  xtensa_mat_init_f32(&invWorkInst, invDim, invDim, invWork);
+  xtensa_mat_init_f32(&matDspInst, invDim, invDim, matDsp);
+}
+
+static void matInverseDsp(void)
+{
+  xtensa_mat_inverse_f32(&invWorkInst, &matDspInst);
+}
+
+// Gauss-Jordan elimination with partial pivoting
+static void matInverseNaive(void)
+{
+  const int n = invDim;
+  const int width = 2 * n;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      invAugmented[i * width + j] = matA[i * n + j];
+      invAugmented[i * width + n + j] = (i == j) ? 1.0f : 0.0f;
+    }
+  }
+
+  for (int column = 0; column < n; column++) {
+    int pivot = column;
+    for (int row = column + 1; row < n; row++) {
+      if (fabsf(invAugmented[row * width + column]) > fabsf(invAugmented[pivot * width + column])) {
+        pivot = row;
+      }
+    }
+    if (pivot != column) {
+      for (int j = 0; j < width; j++) {
+        float swap = invAugmented[column * width + j];
+        invAugmented[column * width + j] = invAugmented[pivot * width + j];
+        invAugmented[pivot * width + j] = swap;
+      }
+    }
+
+    float scale = 1.0f / invAugmented[column * width + column];
+    for (int j = 0; j < width; j++) {
+      invAugmented[column * width + j] *= scale;
+    }
+    for (int row = 0; row < n; row++) {
+      float factor = invAugmented[row * width + column];
+      if (row == column || factor == 0.0f) {
+        continue;
+      }
+      for (int j = 0; j < width; j++) {
+        invAugmented[row * width + j] -= factor * invAugmented[column * width + j];
+      }
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      matNaive[i * n + j] = invAugmented[i * width + n + j];
+    }
+  }
+}
+
+/* Real FFT of the dynamic notch block, the kernel overwrites its input */
+
+static void fftSetup(void)
+{
+  memcpy(fftWork, fftIn, sizeof(fftWork));
+}
+
+static void fftDsp_(void)
+{
+  xtensa_rfft_fast_f32(&fft, fftWork, fftDsp, 0);
+}
+
+// DFT in the packed layout of the kernel: X[0] and X[N/2] real parts, then X[1..N/2-1]
+static void fftNaive_(void)
+{
+  for (int k = 0; k <= FFT_LEN / 2; k++) {
+    float re = 0.0f;
+    float im = 0.0f;
+    for (int n = 0; n < FFT_LEN; n++) {
+      int index = (k * n) % FFT_LEN;
+      re += fftIn[n] * fftCos[index];
+      im -= fftIn[n] * fftSin[index];
+    }
+    if (k == 0) {
+      fftNaive[0] = re;
+    } else if (k == FFT_LEN / 2) {
+      fftNaive[1] = re;
+    } else {
+      fftNaive[2 * k] = re;
+      fftNaive[2 * k + 1] = im;
+    }
+  }
+}
+
+/* 2-pole low pass filter, one sample as in the firmware and a block */
+
+static void biquadSetup(void)
+{
+  memset(biquadState, 0, sizeof(biquadState));
+  lpf.delay_element_1 = 0.0f;
+  lpf.delay_element_2 = 0.0f;
+}
+
+static void biquadDsp_(void)
+{
+  xtensa_biquad_cascade_df1_f32(&biquad, biquadIn, biquadDsp, biquadLength);
+}
+
+static void biquadNaive_(void)
+{
+  for (int i = 0; i < biquadLength; i++) {
+    biquadNaive[i] = lpf2pApply(&lpf, biquadIn[i]);
+  }
+}
+
+static void benchSetupData(void)
+{
+  // Symmetric and diagonally dominant, as a covariance, so that it inverts well
+  for (int i = 0; i < MAT_DIM; i++) {
+    for (int j = 0; j < MAT_DIM; j++) {
+      float value = 1.0f / (1.0f + i + j);
+      matA[i * MAT_DIM + j] = (i == j) ? MAT_DIM + value : value;
+      matB[i * MAT_DIM + j] = sinf(0.3f * i + 0.7f * j);
+    }
+  }
+  xtensa_mat_init_f32(&matAInst, MAT_DIM, MAT_DIM, matA);
+  xtensa_mat_init_f32(&matBInst, MAT_DIM, MAT_DIM, matB);
+  xtensa_mat_init_f32(&matDspInst, MAT_DIM, MAT_DIM, matDsp);
+
+  xtensa_rfft_fast_init_f32(&fft, FFT_LEN);
+  for (int i = 0; i < FFT_LEN; i++) {
+    fftIn[i] = sinf(2.0f * M_PI_F * 13.0f * i / FFT_LEN) + 0.3f * cosf(2.0f * M_PI_F * 41.0f * i / FFT_LEN);
+    fftCos[i] = cosf(2.0f * M_PI_F * i / FFT_LEN);
+    fftSin[i] = sinf(2.0f * M_PI_F * i / FFT_LEN);
+  }
+
+  // The gyro filter: 80 Hz at 1 kHz
+  lpf2pInit(&lpf, 1000.0f, 80.0f);
+  biquadCoeffs[0] = lpf.b0;
+  biquadCoeffs[1] = lpf.b1;
+  biquadCoeffs[2] = lpf.b2;
+  // The kernel adds the feedback terms lpf2pApply() subtracts
+  biquadCoeffs[3] = -lpf.a1;
+  biquadCoeffs[4] = -lpf.a2;
+  xtensa_biquad_cascade_df1_init_f32(&biquad, 1, biquadCoeffs, biquadState);
+  for (int i = 0; i < BIQUAD_BLOCK; i++) {
+    biquadIn[i] = sinf(0.1f * i) + 0.2f * sinf(2.9f * i);
+  }
+}
+
+void dspBenchRun(void *arg)
+{
+  benchSetupData();
+
+  DEBUG_PRINTI("Cycles over %d runs: dsp_lib min/mean, plain C min/mean, C/dsp_lib, max difference\n", DSP_BENCH_RUNS);
+
+  benchCompare("mat_mult 9x9", NULL, matMultDsp, matMultNaive, matDsp, matNaive, MAT_DIM * MAT_DIM);
+
+  invDim = INV_DIM_SMALL;
+  benchCompare("mat_inverse 3x3", matInverseSetup, matInverseDsp, matInverseNaive, matDsp, matNaive,
+               INV_DIM_SMALL * INV_DIM_SMALL);
+  invDim = MAT_DIM;
+  benchCompare("mat_inverse 9x9", matInverseSetup, matInverseDsp, matInverseNaive, matDsp, matNaive, MAT_DIM * MAT_DIM);
+
+  benchCompare("rfft_fast 128", fftSetup, fftDsp_, fftNaive_, fftDsp, fftNaive, FFT_LEN);
+
+  biquadLength = 1;
+  benchCompare("biquad 1 sample", biquadSetup, biquadDsp_, biquadNaive_, biquadDsp, biquadNaive, 1);
+  biquadLength = BIQUAD_BLOCK;
+  benchCompare("biquad 32 samples", biquadSetup, biquadDsp_, biquadNaive_, biquadDsp, biquadNaive, BIQUAD_BLOCK);
+}
+
+PARAM_GROUP_START(dspBench)
+PARAM_ADD(PARAM_UINT8, run, &runRequest)
+PARAM_GROUP_STOP(dspBench)
+
+#endif // CONFIG_DSP_BENCHMARK
@@ -0,0 +1,264 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * dynamic_notch.c - Gyro notch filters following the motor vibration peak
+ */
+
+#include <math.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "config.h"
+#include "dynamic_notch.h"
+#include "filter.h"
+#include "physicalConstants.h"
+#include "static_mem.h"
+#include "xtensa_math.h"
+#include "log.h"
+#include "param.h"
+#define DEBUG_MODULE "DYNNOTCH"
+#include "debug_cf.h"
+
+#define DYN_NOTCH_AXES 3
+// Power of the peak bin relative to the mean power of the other bins of the
+// band, below which a block is taken as having no vibration peak and the notch
+// stays put. White noise reaches 8 in about 1 of 100 blocks.
+#define DYN_NOTCH_MIN_PEAK_RATIO 8.0f
+// Weight of the peak of a new block in the tracked frequency
+#define DYN_NOTCH_SMOOTHING 0.3f
+
+static bool isInit = false;
+static float sampleFreq;
+
+// The sensors task fills one block while the spectrum task analyses the other
+static float blocks[2][DYN_NOTCH_AXES][DYN_NOTCH_FFT_LEN];
+static uint8_t writeBlock;
+static uint16_t writeIndex;
+static volatile bool analysing;
+static uint16_t droppedBlocks;
+static xSemaphoreHandle blockReady;
+static StaticSemaphore_t blockReadyBuffer;
+
+static xtensa_rfft_fast_instance_f32 fft;
+static float window[DYN_NOTCH_FFT_LEN];
+static float spectrum[DYN_NOTCH_FFT_LEN];
+
+// Tracked peak of each axis, 0 until one is found. Written by the spectrum task
+static float centerFreq[DYN_NOTCH_AXES];
+
+// Notches of the sensors task, and the frequency and Q they are set to
+static lpf2pData notch[DYN_NOTCH_AXES];
+static float notchFreq[DYN_NOTCH_AXES];
+static float notchQ[DYN_NOTCH_AXES];
+
+static uint8_t enable = 1;
+static float minHz = 80.0f;
+static float maxHz = 400.0f;
+static float q = 3.0f;
+
+STATIC_MEM_TASK_ALLOC(dynamicNotchTask, DYN_NOTCH_TASK_STACKSIZE);
+static void dynamicNotchTask(void *param);
+
+void dynamicNotchInit(float rate)
+{
+  if (isInit) {
+    return;
+  }
+
+  if (xtensa_rfft_fast_init_f32(&fft, DYN_NOTCH_FFT_LEN) != XTENSA_MATH_SUCCESS) {
+    DEBUG_PRINT("FFT length %d not supported\n", DYN_NOTCH_FFT_LEN);
+    return;
+  }
+
+  sampleFreq = rate;
+  // Hann window
+  for (int i = 0; i < DYN_NOTCH_FFT_LEN; i++) {
+    window[i] = 0.5f - 0.5f * cosf(2.0f * M_PI_F * i / (DYN_NOTCH_FFT_LEN - 1));
+  }
+
+  blockReady = xSemaphoreCreateBinaryStatic(&blockReadyBuffer);
+  STATIC_MEM_TASK_CREATE_PINNED(dynamicNotchTask, dynamicNotchTask, DYN_NOTCH_TASK_NAME, NULL, DYN_NOTCH_TASK_PRI, DYN_NOTCH_TASK_CORE);
+
+  isInit = true;
+}
+
+bool dynamicNotchTest(void)
+{
+  return isInit;
+}
+
+static float binPower(int bin)
+{
+  // The real FFT output holds the DC and Nyquist terms first, then re, im of each bin
+  float re = spectrum[2 * bin];
+  float im = spectrum[2 * bin + 1];
+  return re * re + im * im;
+}
+
+/**
+ * Finds the frequency of the strongest peak of a block between minHz and
+ * maxHz, interpolated between bins.
+ *
+ * @return Frequency in Hz, 0 if the block has no clear peak
+ */
+static float findPeak(float *samples)
+{
+  float mean = 0.0f;
+  for (int i = 0; i < DYN_NOTCH_FFT_LEN; i++) {
+    mean += samples[i];
+  }
+  mean /= DYN_NOTCH_FFT_LEN;
+
+  for (int i = 0; i < DYN_NOTCH_FFT_LEN; i++) {
+    samples[i] = (samples[i] - mean) * window[i];
+  }
+  // Also uses the samples as work area
+  xtensa_rfft_fast_f32(&fft, samples, spectrum, 0);
+
+  const float binHz = sampleFreq / DYN_NOTCH_FFT_LEN;
+  // Keep a neighbour on each side of the peak bin for the interpolation
+  int first = (int)ceilf(minHz / binHz);
+  int last = (int)(maxHz / binHz);
+  if (first < 2) {
+    first = 2;
+  }
+  if (last > DYN_NOTCH_FFT_LEN / 2 - 2) {
+    last = DYN_NOTCH_FFT_LEN / 2 - 2;
+  }
+  if (last < first) {
+    return 0.0f;
+  }
+
+  float sum = 0.0f;
+  float best = 0.0f;
+  int bestBin = first;
+  for (int bin = first; bin <= last; bin++) {
+    float power = binPower(bin);
+    sum += power;
+    if (power > best) {
+      best = power;
+      bestBin = bin;
+    }
+  }
+
+  if (last == first || best <= DYN_NOTCH_MIN_PEAK_RATIO * (sum - best) / (last - first)) {
+    return 0.0f;
+  }
+
+  // Parabola through the magnitudes of the peak bin and its neighbours
+  float y0 = sqrtf(binPower(bestBin - 1));
+  float y1 = sqrtf(best);
+  float y2 = sqrtf(binPower(bestBin + 1));
+  float denominator = y0 - 2.0f * y1 + y2;
+  float offset = denominator != 0.0f ? 0.5f * (y0 - y2) / denominator : 0.0f;
+
+  return (bestBin + offset) * binHz;
+}
+
+static void dynamicNotchTask(void *param)
+{
+  while (true) {
+    xSemaphoreTake(blockReady, portMAX_DELAY);
+
+    // The sensors task does not switch blocks while analysing is set
+    const uint8_t block = writeBlock ^ 1;
+    for (int axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+      float peak = findPeak(blocks[block][axis]);
+      if (peak > 0.0f) {
+        float freq = centerFreq[axis];
+        centerFreq[axis] = freq > 0.0f ? freq + DYN_NOTCH_SMOOTHING * (peak - freq) : peak;
+      }
+    }
+
+    analysing = false;
+  }
+}
+
+void dynamicNotchApply(Axis3f *gyro)
+{
+  if (!isInit) {
+    return;
+  }
+
+  for (int axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+    blocks[writeBlock][axis][writeIndex] = gyro->axis[axis];
+  }
+  if (++writeIndex >= DYN_NOTCH_FFT_LEN) {
+    writeIndex = 0;
+    if (!analysing) {
+      analysing = true;
+      writeBlock ^= 1;
+      xSemaphoreGive(blockReady);
+    } else {
+      // The spectrum task is late, this block is overwritten
+      droppedBlocks++;
+    }
+  }
+
+  if (!enable) {
+    for (int axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+      notchFreq[axis] = 0.0f;
+    }
+    return;
+  }
+
+  for (int axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+    float freq = centerFreq[axis];
+    if (freq <= 0.0f) {
+      continue;
+    }
+
+    if (freq != notchFreq[axis] || q != notchQ[axis]) {
+      bool wasOff = notchFreq[axis] <= 0.0f;
+      notch2pSetCenterFreq(&notch[axis], sampleFreq, freq, q);
+      notchFreq[axis] = freq;
+      notchQ[axis] = q;
+      if (wasOff) {
+        // Start from the steady state of the current sample
+        gyro->axis[axis] = lpf2pReset(&notch[axis], gyro->axis[axis]);
+        continue;
+      }
+    }
+    gyro->axis[axis] = lpf2pApply(&notch[axis], gyro->axis[axis]);
+  }
+}
+
+/**
+ * Tracked vibration peak of each gyro axis, 0 until one is found
+ */
+LOG_GROUP_START(dynNotch)
+LOG_ADD(LOG_FLOAT, freqX, &centerFreq[0])
+LOG_ADD(LOG_FLOAT, freqY, &centerFreq[1])
+LOG_ADD(LOG_FLOAT, freqZ, &centerFreq[2])
+LOG_ADD(LOG_UINT16, dropped, &droppedBlocks)
+LOG_GROUP_STOP(dynNotch)
+
+/**
+ * Notch filtering of the gyro, the peaks are tracked also when disabled
+ */
+PARAM_GROUP_START(dynNotch)
+PARAM_ADD(PARAM_UINT8, enable, &enable)
+PARAM_ADD(PARAM_FLOAT, minHz, &minHz)
+PARAM_ADD(PARAM_FLOAT, maxHz, &maxHz)
+PARAM_ADD(PARAM_FLOAT, q, &q)
+PARAM_GROUP_STOP(dynNotch)
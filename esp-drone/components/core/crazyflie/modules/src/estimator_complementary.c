@@ -93,7 +93,7 @@ void estimatorComplementary(state_t *state, sensorData_t *sensorData, control_t
     positionUpdateVelocity(state->acc.z, ATTITUDE_UPDATE_DT);
   }
 
-  if (RATE_DO_EXECUTE(POS_UPDATE_RATE, tick)) {
+  if (RATE_DO_EXECUTE_PHASE(POS_UPDATE_RATE, POSITION_PHASE, tick)) {
     tofMeasurement_t tofMeasurement;
 
     latestTofMeasurement(&tofMeasurement);
@@ -64,11 +64,12 @@
 #include "stm32_legacy.h"
 
 #include "FreeRTOS.h"
-#include "queue.h"
 #include "task.h"
 #include "semphr.h"
 #include "sensors.h"
 #include "static_mem.h"
+#include "queuemonitor.h"
+#include "event_trace.h"
 
 #include "system.h"
 #include "log.h"
@@ -97,78 +98,142 @@
  * As well as by the following internal functions and datatypes
  */
 
-// Distance-to-point measurements
-static xQueueHandle distDataQueue;
-STATIC_MEM_QUEUE_ALLOC(distDataQueue, 10, sizeof(distanceMeasurement_t));
-
-static inline bool stateEstimatorHasDistanceMeasurement(distanceMeasurement_t *dist) {
-  return (pdTRUE == xQueueReceive(distDataQueue, dist, 0));
-}
-
-// Direct measurements of Crazyflie position
-static xQueueHandle posDataQueue;
-STATIC_MEM_QUEUE_ALLOC(posDataQueue, 10, sizeof(positionMeasurement_t));
-
-static inline bool stateEstimatorHasPositionMeasurement(positionMeasurement_t *pos) {
-  return (pdTRUE == xQueueReceive(posDataQueue, pos, 0));
-}
-
-// Direct measurements of Crazyflie pose
-static xQueueHandle poseDataQueue;
-STATIC_MEM_QUEUE_ALLOC(poseDataQueue, 10, sizeof(poseMeasurement_t));
-
-static inline bool stateEstimatorHasPoseMeasurement(poseMeasurement_t *pose) {
-  return (pdTRUE == xQueueReceive(poseDataQueue, pose, 0));
-}
-
-// Measurements of a UWB Tx/Rx
-static xQueueHandle tdoaDataQueue;
-STATIC_MEM_QUEUE_ALLOC(tdoaDataQueue, 10, sizeof(tdoaMeasurement_t));
-
-static inline bool stateEstimatorHasTDOAPacket(tdoaMeasurement_t *uwb) {
-  return (pdTRUE == xQueueReceive(tdoaDataQueue, uwb, 0));
-}
-
-// Measurements of flow (dnx, dny)
-static xQueueHandle flowDataQueue;
-STATIC_MEM_QUEUE_ALLOC(flowDataQueue, 10, sizeof(flowMeasurement_t));
+// All the measurements are queued, in arrival order, in one ring of tagged
+// entries. Producers (deck drivers, the CRTP localization service, ...) reserve
+// a slot with a compare-and-swap on enqueuePos and publish it by advancing its
+// sequence number, the kalman task is the only consumer. No lock is taken, so
+// enqueueing is also safe from an interrupt.
+typedef enum {
+  MeasurementTypeTDOA,
+  MeasurementTypePosition,
+  MeasurementTypePose,
+  MeasurementTypeDistance,
+  MeasurementTypeFlow,
+  MeasurementTypeTOF,
+  MeasurementTypeAbsoluteHeight,
+  MeasurementTypeYawError,
+  MeasurementTypeCount,
+} measurementType_t;
+
+typedef struct {
+  measurementType_t type;
+  union {
+    tdoaMeasurement_t tdoa;
+    positionMeasurement_t position;
+    poseMeasurement_t pose;
+    distanceMeasurement_t distance;
+    flowMeasurement_t flow;
+    tofMeasurement_t tof;
+    heightMeasurement_t height;
+    yawErrorMeasurement_t yawError;
+  } data;
+} measurement_t;
+
+// Must be a power of two
+#define MEASUREMENT_RING_SIZE 32
+#define MEASUREMENT_RING_MASK (MEASUREMENT_RING_SIZE - 1)
+
+typedef struct {
+  uint32_t seq;  // Slot index when free, index + 1 once written
+  measurement_t measurement;
+} measurementSlot_t;
+
+NO_DMA_CCM_SAFE_ZERO_INIT static measurementSlot_t measurementRing[MEASUREMENT_RING_SIZE];
+static uint32_t enqueuePos;
+static uint32_t dequeuePos;
+static uint32_t measurementsDropped;
+#ifdef DEBUG_QUEUE_MONITOR
+static unsigned char measurementRingMonitor;
+#endif
 
-static inline bool stateEstimatorHasFlowPacket(flowMeasurement_t *flow) {
-  return (pdTRUE == xQueueReceive(flowDataQueue, flow, 0));
+static void measurementRingInit(void) {
+  for (uint32_t i = 0; i < MEASUREMENT_RING_SIZE; i++) {
+    measurementRing[i].seq = i;
+  }
+  enqueuePos = 0;
+  dequeuePos = 0;
+  DEBUG_QUEUE_MONITOR_REGISTER_BUFFER(measurementRingMonitor, "kalmanMeasurements", MEASUREMENT_RING_SIZE);
 }
 
-// Measurements of TOF from laser sensor
-static xQueueHandle tofDataQueue;
-STATIC_MEM_QUEUE_ALLOC(tofDataQueue, 10, sizeof(tofMeasurement_t));
+static bool measurementRingPush(const measurement_t *measurement) {
+  uint32_t pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+  measurementSlot_t *slot;
 
-static inline bool stateEstimatorHasTOFPacket(tofMeasurement_t *tof) {
-  return (pdTRUE == xQueueReceive(tofDataQueue, tof, 0));
-}
-
-// Absolute height measurement along the room Z
-static xQueueHandle heightDataQueue;
-STATIC_MEM_QUEUE_ALLOC(heightDataQueue, 10, sizeof(heightMeasurement_t));
+  while (true) {
+    slot = &measurementRing[pos & MEASUREMENT_RING_MASK];
+    int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Not consumed yet, the ring is full
+      DEBUG_QUEUE_MONITOR_RECORD(measurementRingMonitor, 0, false);
+      return false;
+    } else {
+      pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+    }
+  }
 
-static inline bool stateEstimatorHasHeightPacket(heightMeasurement_t *height) {
-  return (pdTRUE == xQueueReceive(heightDataQueue, height, 0));
+  slot->measurement = *measurement;
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+  DEBUG_QUEUE_MONITOR_RECORD(measurementRingMonitor, pos + 1 - __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED), true);
+  return true;
 }
 
+// Only called from the kalman task
+static bool measurementRingPop(measurement_t *measurement) {
+  measurementSlot_t *slot = &measurementRing[dequeuePos & MEASUREMENT_RING_MASK];
+  if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != dequeuePos + 1) {
+    // Empty, or the oldest slot is still being written
+    return false;
+  }
 
-static xQueueHandle yawErrorDataQueue;
-STATIC_MEM_QUEUE_ALLOC(yawErrorDataQueue, 10, sizeof(yawErrorMeasurement_t));
-
-static inline bool stateEstimatorHasYawErrorPacket(yawErrorMeasurement_t *error)
-{
-  return (pdTRUE == xQueueReceive(yawErrorDataQueue, error, 0));
+  *measurement = slot->measurement;
+  __atomic_store_n(&slot->seq, dequeuePos + MEASUREMENT_RING_SIZE, __ATOMIC_RELEASE);
+  dequeuePos++;
+  return true;
 }
 
-// static xQueueHandle sweepAnglesDataQueue;
-// STATIC_MEM_QUEUE_ALLOC(sweepAnglesDataQueue, 10, sizeof(sweepAngleMeasurement_t));
+// History of the past prediction steps, to fuse delayed measurements at their capture time.
+// Each step keeps the filter state before its prediction, the inputs of the prediction and of the
+// process noise, and the measurements fused during the step. A flow or ToF measurement captured
+// before the current step is filed in the step it was captured in, and the filter is then re-run
+// from that step up to now, once per loop whatever the number of delayed measurements.
+#ifdef CONFIG_KALMAN_HISTORY_LENGTH
+#define HISTORY_LENGTH CONFIG_KALMAN_HISTORY_LENGTH
+#else
+#define HISTORY_LENGTH 8
+#endif
+#define HISTORY_STEP_MEASUREMENTS 8  // At most 8, see judgedMask
+
+#if HISTORY_LENGTH > 0
+typedef struct {
+  uint32_t tick;                  // Tick of the prediction starting the step
+  kalmanCoreSnapshot_t snapshot;  // Filter state before the prediction
+
+  float thrust;
+  Axis3f acc;
+  Axis3f gyro;
+  float dt;
+  bool quadIsFlying;
+
+  float noiseDt;                  // Process noise added during the step
+  uint16_t noiseCount;
+
+  Axis3f updateGyro;              // Latest gyro sample, used by the flow updates
+  uint8_t measurementCount;
+  uint8_t judgedMask;             // Measurements the outlier filters have already seen, one bit each
+  measurement_t measurements[HISTORY_STEP_MEASUREMENTS];
+} historyStep_t;
+
+NO_DMA_CCM_SAFE_ZERO_INIT static historyStep_t history[HISTORY_LENGTH];
+static uint32_t historyHead;   // Current step
+static uint32_t historyCount;  // Steps stored, the current one included
+#endif
 
-// static inline bool stateEstimatorHasSweepAnglesPacket(sweepAngleMeasurement_t *angles)
-// {
-//   return (pdTRUE == xQueueReceive(sweepAnglesDataQueue, angles, 0));
-// }
+static uint32_t delayedMeasurements;
+static uint32_t historyOverflows;
 
 // Semaphore to signal that we got data from the stabilzer loop to process
 static SemaphoreHandle_t runTaskSemaphore;
@@ -190,9 +255,17 @@ static StaticSemaphore_t dataMutexBuffer;
 /**
  * Tuning parameters
  */
+#ifdef CONFIG_KALMAN_PREDICT_RATE_HZ
+#define PREDICT_RATE CONFIG_KALMAN_PREDICT_RATE_HZ
+#else
 #define PREDICT_RATE RATE_100_HZ // this is slower than the IMU update rate of 500Hz
+#endif
 #define BARO_RATE RATE_25_HZ
 
+// Above this the IMU sample times are not trusted for the prediction dt, after
+// a gap in the samples the ticks of the task are used
+#define MAX_IMU_DT_US 100000
+
 // the point at which the dynamics change from stationary to flying
 #define IN_FLIGHT_THRUST_THRESHOLD (GRAVITY_MAGNITUDE*0.1f)
 #define IN_FLIGHT_TIME_THRESHOLD (500)
@@ -230,6 +303,9 @@ static uint32_t accAccumulatorCount;
 static uint32_t thrustAccumulatorCount;
 static uint32_t gyroAccumulatorCount;
 static uint32_t baroAccumulatorCount;
+// Time of the newest gyro sample accumulated, and of the one of the last prediction, in us
+static uint64_t gyroAccumulatorTimestamp;
+static uint64_t lastPredictionImuTimestamp;
 static bool quadIsFlying = false;
 static uint32_t lastFlightCmd;
 static uint32_t takeoffTime;
@@ -248,6 +324,13 @@ static STATS_CNT_RATE_DEFINE(finalizeCounter, ONE_SECOND);
 static STATS_CNT_RATE_DEFINE(measurementAppendedCounter, ONE_SECOND);
 static STATS_CNT_RATE_DEFINE(measurementNotAppendedCounter, ONE_SECOND);
 
+// Cost, in CPU cycles, of the filter steps
+static STATS_CNT_COST_DEFINE(predictCost, ONE_SECOND);
+static STATS_CNT_COST_DEFINE(finalizeCost, ONE_SECOND);
+static STATS_CNT_COST_DEFINE(externalizeCost, ONE_SECOND);
+static STATS_CNT_COST_DEFINE(replayCost, ONE_SECOND);
+static statsCntCostCounter_t updateCost[MeasurementTypeCount];
+
 static rateSupervisor_t rateSupervisorContext;
 
 #define WARNING_HOLD_BACK_TIME M2T(2000)
@@ -261,6 +344,8 @@ static const bool useBaroUpdate = false;
 
 static void kalmanTask(void* parameters);
 static bool predictStateForward(uint32_t osTick, float dt);
+static void historyBeginStep(uint32_t tick, float thrust, const Axis3f *acc, const Axis3f *gyro, float dt);
+static void historyAddProcessNoise(float dt);
 static bool updateQueuedMeasurments(const Axis3f *gyro, const uint32_t tick);
 
 STATIC_MEM_TASK_ALLOC_STACK_NO_DMA_CCM_SAFE(kalmanTask, KALMAN_TASK_STACKSIZE);
@@ -269,21 +354,16 @@ STATIC_MEM_TASK_ALLOC_STACK_NO_DMA_CCM_SAFE(kalmanTask, KALMAN_TASK_STACKSIZE);
 
 // Called one time during system startup
 void estimatorKalmanTaskInit() {
-  distDataQueue = STATIC_MEM_QUEUE_CREATE(distDataQueue);
-  posDataQueue = STATIC_MEM_QUEUE_CREATE(posDataQueue);
-  poseDataQueue = STATIC_MEM_QUEUE_CREATE(poseDataQueue);
-  tdoaDataQueue = STATIC_MEM_QUEUE_CREATE(tdoaDataQueue);
-  flowDataQueue = STATIC_MEM_QUEUE_CREATE(flowDataQueue);
-  tofDataQueue = STATIC_MEM_QUEUE_CREATE(tofDataQueue);
-  heightDataQueue = STATIC_MEM_QUEUE_CREATE(heightDataQueue);
-  yawErrorDataQueue = STATIC_MEM_QUEUE_CREATE(yawErrorDataQueue);
-  //sweepAnglesDataQueue = STATIC_MEM_QUEUE_CREATE(sweepAnglesDataQueue);
+  measurementRingInit();
+  for (int i = 0; i < MeasurementTypeCount; i++) {
+    statsCntCostCounterInit(&updateCost[i], ONE_SECOND);
+  }
 
   vSemaphoreCreateBinary(runTaskSemaphore);
 
   dataMutex = xSemaphoreCreateMutexStatic(&dataMutexBuffer);
 
-  STATIC_MEM_TASK_CREATE(kalmanTask, kalmanTask, KALMAN_TASK_NAME, NULL, KALMAN_TASK_PRI);
+  STATIC_MEM_TASK_CREATE_PINNED(kalmanTask, kalmanTask, KALMAN_TASK_NAME, NULL, KALMAN_TASK_PRI, KALMAN_TASK_CORE);
 
   isInit = true;
 }
@@ -300,7 +380,7 @@ static void kalmanTask(void* parameters) {
   uint32_t lastPNUpdate = xTaskGetTickCount();
   uint32_t nextBaroUpdate = xTaskGetTickCount();
 
-  rateSupervisorInit(&rateSupervisorContext, xTaskGetTickCount(), M2T(1000), 99, 101, 1);
+  rateSupervisorInit(&rateSupervisorContext, xTaskGetTickCount(), M2T(1000), PREDICT_RATE - 1, PREDICT_RATE + 1, 1);
 
   while (true) {
     xSemaphoreTake(runTaskSemaphore, portMAX_DELAY);
@@ -315,6 +395,7 @@ static void kalmanTask(void* parameters) {
     bool doneUpdate = false;
 
     uint32_t osTick = xTaskGetTickCount(); // would be nice if this had a precision higher than 1ms...
+    EVENT_TRACE_BEGIN(eventTraceKalmanTask, osTick);
 
   #ifdef KALMAN_DECOUPLE_XY
     kalmanCoreDecoupleXY(&coreData);
@@ -323,11 +404,13 @@ static void kalmanTask(void* parameters) {
     // Run the system dynamics to predict the state forward.
     if (osTick >= nextPrediction) { // update at the PREDICT_RATE
       float dt = T2S(osTick - lastPrediction);
+      EVENT_TRACE_BEGIN(eventTraceKalmanPredict, osTick);
       if (predictStateForward(osTick, dt)) {
         lastPrediction = osTick;
         doneUpdate = true;
         STATS_CNT_RATE_EVENT(&predictionCounter);
       }
+      EVENT_TRACE_STOP(eventTraceKalmanPredict, osTick);
 
       nextPrediction = osTick + S2T(1.0f / PREDICT_RATE);
 
@@ -343,6 +426,7 @@ static void kalmanTask(void* parameters) {
       float dt = T2S(osTick - lastPNUpdate);
       if (dt > 0.0f) {
         kalmanCoreAddProcessNoise(&coreData, dt);
+        historyAddProcessNoise(dt);
         lastPNUpdate = osTick;
       }
     }
@@ -376,9 +460,11 @@ static void kalmanTask(void* parameters) {
       memcpy(&gyro, &gyroSnapshot, sizeof(gyro));
       xSemaphoreGive(dataMutex);
 
+      EVENT_TRACE_BEGIN(eventTraceKalmanMeasurements, osTick);
       if(updateQueuedMeasurments(&gyro, osTick)) {
         doneUpdate = true;
       }
+      EVENT_TRACE_STOP(eventTraceKalmanMeasurements, osTick);
     }
 
     /**
@@ -390,7 +476,11 @@ static void kalmanTask(void* parameters) {
 
     if (doneUpdate)
     {
+      EVENT_TRACE_BEGIN(eventTraceKalmanFinalize, osTick);
+      STATS_CNT_COST_START(&finalizeCost);
       kalmanCoreFinalize(&coreData, osTick);
+      STATS_CNT_COST_STOP(&finalizeCost);
+      EVENT_TRACE_STOP(eventTraceKalmanFinalize, osTick);
       STATS_CNT_RATE_EVENT(&finalizeCounter);
       if (! kalmanSupervisorIsStateWithinBounds(&coreData)) {
         coreData.resetEstimation = true;
@@ -407,10 +497,13 @@ static void kalmanTask(void* parameters) {
      * This is done every round, since the external state includes some sensor data
      */
     xSemaphoreTake(dataMutex, portMAX_DELAY);
+    STATS_CNT_COST_START(&externalizeCost);
     kalmanCoreExternalizeState(&coreData, &taskEstimatorState, &accSnapshot, osTick);
+    STATS_CNT_COST_STOP(&externalizeCost);
     xSemaphoreGive(dataMutex);
 
     STATS_CNT_RATE_EVENT(&updateCounter);
+    EVENT_TRACE_STOP(eventTraceKalmanTask, osTick);
   }
 }
 
@@ -423,18 +516,19 @@ void estimatorKalman(state_t *state, sensorData_t *sensors, control_t *control,
   // Average the last IMU measurements. We do this because the prediction loop is
   // slower than the IMU loop, but the IMU information is required externally at
   // a higher rate (for body rate control).
-  if (sensorsReadAcc(&sensors->acc)) {
+  if (sensorsReadAccTimestamped(&sensors->acc, &sensors->accTimestamp)) {
     accAccumulator.x += sensors->acc.x;
     accAccumulator.y += sensors->acc.y;
     accAccumulator.z += sensors->acc.z;
     accAccumulatorCount++;
   }
 
-  if (sensorsReadGyro(&sensors->gyro)) {
+  if (sensorsReadGyroTimestamped(&sensors->gyro, &sensors->gyroTimestamp)) {
     gyroAccumulator.x += sensors->gyro.x;
     gyroAccumulator.y += sensors->gyro.y;
     gyroAccumulator.z += sensors->gyro.z;
     gyroAccumulatorCount++;
+    gyroAccumulatorTimestamp = sensors->gyroTimestamp;
   }
 
   // Average the thrust command from the last time steps, generated externally by the controller
@@ -443,7 +537,7 @@ void estimatorKalman(state_t *state, sensorData_t *sensors, control_t *control,
 
   // Average barometer data
   if (useBaroUpdate) {
-    if (sensorsReadBaro(&sensors->baro)) {
+    if (sensorsReadBaroTimestamped(&sensors->baro, &sensors->baroTimestamp)) {
       baroAslAccumulator += sensors->baro.asl;
       baroAccumulatorCount++;
     }
@@ -485,6 +579,16 @@ static bool predictStateForward(uint32_t osTick, float dt) {
   // thrust is in grams, we need ms^-2
   float thrustAverage = thrustAccumulator * CONTROL_TO_ACC / thrustAccumulatorCount;
 
+  // The samples were taken between the newest ones of the two predictions,
+  // which is a better dt than the ticks of the task when it is sane
+  if (lastPredictionImuTimestamp != 0 && gyroAccumulatorTimestamp > lastPredictionImuTimestamp) {
+    uint64_t imuDt = gyroAccumulatorTimestamp - lastPredictionImuTimestamp;
+    if (imuDt < MAX_IMU_DT_US) {
+      dt = imuDt / 1e6f;
+    }
+  }
+  lastPredictionImuTimestamp = gyroAccumulatorTimestamp;
+
   accAccumulator = (Axis3f){.axis={0}};
   accAccumulatorCount = 0;
   gyroAccumulator = (Axis3f){.axis={0}};
@@ -504,93 +608,229 @@ static bool predictStateForward(uint32_t osTick, float dt) {
   }
   quadIsFlying = (osTick-lastFlightCmd) < IN_FLIGHT_TIME_THRESHOLD;
 
+  historyBeginStep(osTick, thrustAverage, &accAverage, &gyroAverage, dt);
+  STATS_CNT_COST_START(&predictCost);
   kalmanCorePredict(&coreData, thrustAverage, &accAverage, &gyroAverage, dt, quadIsFlying);
+  STATS_CNT_COST_STOP(&predictCost);
 
   return true;
 }
 
 
-static bool updateQueuedMeasurments(const Axis3f *gyro, const uint32_t tick) {
-  bool doneUpdate = false;
-  /**
-   * Sensor measurements can come in sporadically and faster than the stabilizer loop frequency,
-   * we therefore consume all measurements since the last loop, rather than accumulating
-   */
-
-  tofMeasurement_t tof;
-  while (stateEstimatorHasTOFPacket(&tof))
-  {
-    kalmanCoreUpdateWithTof(&coreData, &tof);
-    doneUpdate = true;
+static void applyMeasurement(measurement_t *m, const Axis3f *gyro)
+{
+  uint32_t start = statsCntCycles();
+  switch (m->type) {
+    case MeasurementTypeTDOA:
+      kalmanCoreUpdateWithTDOA(&coreData, &m->data.tdoa);
+      break;
+    case MeasurementTypePosition:
+      kalmanCoreUpdateWithPosition(&coreData, &m->data.position);
+      break;
+    case MeasurementTypePose:
+      kalmanCoreUpdateWithPose(&coreData, &m->data.pose);
+      break;
+    case MeasurementTypeDistance:
+      kalmanCoreUpdateWithDistance(&coreData, &m->data.distance);
+      break;
+    case MeasurementTypeFlow:
+      kalmanCoreUpdateWithFlow(&coreData, &m->data.flow, gyro);
+      break;
+    case MeasurementTypeTOF:
+      kalmanCoreUpdateWithTof(&coreData, &m->data.tof);
+      break;
+    case MeasurementTypeAbsoluteHeight:
+      kalmanCoreUpdateWithAbsoluteHeight(&coreData, &m->data.height);
+      break;
+    case MeasurementTypeYawError:
+      kalmanCoreUpdateWithYawError(&coreData, &m->data.yawError);
+      break;
+    default:
+      return;
   }
+  statsCntCostCounterAdd(&updateCost[m->type], statsCntCycles() - start);
+}
 
-  yawErrorMeasurement_t yawError;
-  while (stateEstimatorHasYawErrorPacket(&yawError))
-  {
-    kalmanCoreUpdateWithYawError(&coreData, &yawError);
-    doneUpdate = true;
+#if HISTORY_LENGTH > 0
+static void historyBeginStep(uint32_t tick, float thrust, const Axis3f *acc, const Axis3f *gyro, float dt)
+{
+  if (historyCount > 0) {
+    historyHead = (historyHead + 1) % HISTORY_LENGTH;
+  }
+  if (historyCount < HISTORY_LENGTH) {
+    historyCount++;
   }
 
-  heightMeasurement_t height;
-  while (stateEstimatorHasHeightPacket(&height))
-  {
-    kalmanCoreUpdateWithAbsoluteHeight(&coreData, &height);
-    doneUpdate = true;
+  historyStep_t *step = &history[historyHead];
+  step->tick = tick;
+  kalmanCoreSaveSnapshot(&coreData, &step->snapshot);
+  step->thrust = thrust;
+  step->acc = *acc;
+  step->gyro = *gyro;
+  step->dt = dt;
+  step->quadIsFlying = quadIsFlying;
+  step->noiseDt = 0;
+  step->noiseCount = 0;
+  // The prediction gyro is in rad/s, the flow updates use deg/s
+  step->updateGyro.x = gyro->x / DEG_TO_RAD;
+  step->updateGyro.y = gyro->y / DEG_TO_RAD;
+  step->updateGyro.z = gyro->z / DEG_TO_RAD;
+  step->measurementCount = 0;
+  step->judgedMask = 0;
+}
+
+static void historyAddProcessNoise(float dt)
+{
+  if (historyCount > 0) {
+    history[historyHead].noiseDt += dt;
+    history[historyHead].noiseCount++;
   }
+}
 
-  distanceMeasurement_t dist;
-  while (stateEstimatorHasDistanceMeasurement(&dist))
-  {
-    kalmanCoreUpdateWithDistance(&coreData, &dist);
-    doneUpdate = true;
+// Number of steps back from the current one that the measurement was captured in, 0 for the
+// measurements without a capture time
+static uint32_t historyStepsBack(const measurement_t *m)
+{
+  uint32_t timestamp;
+  switch (m->type) {
+    case MeasurementTypeFlow:
+      timestamp = m->data.flow.timestamp;
+      break;
+    case MeasurementTypeTOF:
+      timestamp = m->data.tof.timestamp;
+      break;
+    default:
+      return 0;
   }
 
-  positionMeasurement_t pos;
-  while (stateEstimatorHasPositionMeasurement(&pos))
-  {
-    kalmanCoreUpdateWithPosition(&coreData, &pos);
-    doneUpdate = true;
+  uint32_t back = 0;
+  uint32_t idx = historyHead;
+  // Measurements older than the history are fused in its oldest step
+  while (back + 1 < historyCount && (int32_t)(timestamp - history[idx].tick) < 0) {
+    back++;
+    idx = (idx + HISTORY_LENGTH - 1) % HISTORY_LENGTH;
   }
+  return back;
+}
 
-  poseMeasurement_t pose;
-  while (stateEstimatorHasPoseMeasurement(&pose))
-  {
-    kalmanCoreUpdateWithPose(&coreData, &pose);
-    doneUpdate = true;
+// Files the measurement in its step, false if the step is full
+static bool historyRecord(const measurement_t *m, uint32_t back, const Axis3f *gyro)
+{
+  historyStep_t *step = &history[(historyHead + HISTORY_LENGTH - back) % HISTORY_LENGTH];
+  if (back == 0) {
+    step->updateGyro = *gyro;
   }
+  if (step->measurementCount >= HISTORY_STEP_MEASUREMENTS) {
+    historyOverflows++;
+    return false;
+  }
+  // Measurements of the current step are applied right away, delayed ones at the replay
+  if (back == 0) {
+    step->judgedMask |= 1 << step->measurementCount;
+  }
+  step->measurements[step->measurementCount++] = *m;
+  return true;
+}
 
-  tdoaMeasurement_t tdoa;
-  while (stateEstimatorHasTDOAPacket(&tdoa))
-  {
-    kalmanCoreUpdateWithTDOA(&coreData, &tdoa);
-    doneUpdate = true;
+// Re-runs the filter from the state before the given step, up to the current time. The current step
+// is left to be finalized by the task loop.
+static void historyReplay(uint32_t back)
+{
+  uint32_t idx = (historyHead + HISTORY_LENGTH - back) % HISTORY_LENGTH;
+  kalmanCoreRestoreSnapshot(&coreData, &history[idx].snapshot);
+
+  while (true) {
+    historyStep_t *step = &history[idx];
+    if (idx != (historyHead + HISTORY_LENGTH - back) % HISTORY_LENGTH) {
+      kalmanCoreSaveSnapshot(&coreData, &step->snapshot);
+    }
+
+    Axis3f acc = step->acc;
+    Axis3f gyro = step->gyro;
+    kalmanCorePredict(&coreData, step->thrust, &acc, &gyro, step->dt, step->quadIsFlying);
+    for (int i = 0; i < step->noiseCount; i++) {
+      kalmanCoreAddProcessNoise(&coreData, step->noiseDt / step->noiseCount);
+    }
+
+    kalmanCoreBeginBatch(&coreData);
+    for (int i = 0; i < step->measurementCount; i++) {
+      coreData.replaying = (step->judgedMask & (1 << i)) != 0;
+      applyMeasurement(&step->measurements[i], &step->updateGyro);
+      step->judgedMask |= 1 << i;
+    }
+    coreData.replaying = false;
+    kalmanCoreEndBatch(&coreData);
+
+    if (idx == historyHead) {
+      break;
+    }
+    kalmanCoreFinalize(&coreData, step->tick);
+    idx = (idx + 1) % HISTORY_LENGTH;
   }
+}
+#else
+static void historyBeginStep(uint32_t tick, float thrust, const Axis3f *acc, const Axis3f *gyro, float dt) {}
+static void historyAddProcessNoise(float dt) {}
+#endif
+
+static bool updateQueuedMeasurments(const Axis3f *gyro, const uint32_t tick) {
+  bool doneUpdate = false;
+  /**
+   * Sensor measurements can come in sporadically and faster than the stabilizer loop frequency,
+   * we therefore consume all measurements since the last loop, rather than accumulating
+   */
 
-  flowMeasurement_t flow;
-  while (stateEstimatorHasFlowPacket(&flow))
+  // All the measurements of this loop are applied as one batch
+  kalmanCoreBeginBatch(&coreData);
+
+#if HISTORY_LENGTH > 0
+  // Oldest step a delayed measurement was filed in, the filter is re-run from there
+  uint32_t replayBack = 0;
+#endif
+
+  measurement_t m;
+  while (measurementRingPop(&m))
   {
-    kalmanCoreUpdateWithFlow(&coreData, &flow, gyro);
+#if HISTORY_LENGTH > 0
+    if (historyCount > 0) {
+      uint32_t back = historyStepsBack(&m);
+      if (back > 0 && historyRecord(&m, back, gyro)) {
+        delayedMeasurements++;
+        if (back > replayBack) {
+          replayBack = back;
+        }
+        doneUpdate = true;
+        continue;
+      }
+      historyRecord(&m, 0, gyro);
+    }
+#endif
+    applyMeasurement(&m, gyro);
     doneUpdate = true;
   }
 
-  // sweepAngleMeasurement_t angles;
-  // while (stateEstimatorHasSweepAnglesPacket(&angles))
-  // {
-  //   kalmanCoreUpdateWithSweepAngles(&coreData, &angles, tick);
-  //   doneUpdate = true;
-  // }
+  kalmanCoreEndBatch(&coreData);
+
+#if HISTORY_LENGTH > 0
+  if (replayBack > 0) {
+    STATS_CNT_COST_START(&replayCost);
+    historyReplay(replayBack);
+    STATS_CNT_COST_STOP(&replayCost);
+  }
+#endif
 
   return doneUpdate;
 }
 
 // Called when this estimator is activated
 void estimatorKalmanInit(void) {
-  xQueueReset(distDataQueue);
-  xQueueReset(posDataQueue);
-  xQueueReset(poseDataQueue);
-  xQueueReset(tdoaDataQueue);
-  xQueueReset(flowDataQueue);
-  xQueueReset(tofDataQueue);
+  // Drop the pending measurements. Producers may still be enqueueing, so the
+  // ring is drained rather than reinitialized.
+  measurement_t m;
+  while (measurementRingPop(&m));
+#if HISTORY_LENGTH > 0
+  historyCount = 0;
+#endif
 
   xSemaphoreTake(dataMutex, portMAX_DELAY);
   accAccumulator = (Axis3f){.axis={0}};
@@ -602,91 +842,82 @@ void estimatorKalmanInit(void) {
   gyroAccumulatorCount = 0;
   thrustAccumulatorCount = 0;
   baroAccumulatorCount = 0;
+  lastPredictionImuTimestamp = 0;
   xSemaphoreGive(dataMutex);
 
   kalmanCoreInit(&coreData);
 }
 
-static bool appendMeasurement(xQueueHandle queue, void *measurement)
+static bool appendMeasurement(measurementType_t type, const void *data, size_t size)
 {
-  portBASE_TYPE result;
-  bool isInInterrupt = 0; //TODO:= (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0;
+  measurement_t measurement;
+  measurement.type = type;
+  memcpy(&measurement.data, data, size);
 
-  if (isInInterrupt) {
-    portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
-    result = xQueueSendFromISR(queue, measurement, &xHigherPriorityTaskWoken);
-    if(xHigherPriorityTaskWoken == pdTRUE)
-    {
-      portYIELD();
-    }
-  } else {
-    result = xQueueSend(queue, measurement, 0);
-  }
-
-  if (result == pdTRUE) {
+  if (measurementRingPush(&measurement)) {
     STATS_CNT_RATE_EVENT(&measurementAppendedCounter);
-    return true;
   } else {
+    __atomic_fetch_add(&measurementsDropped, 1, __ATOMIC_RELAXED);
     STATS_CNT_RATE_EVENT(&measurementNotAppendedCounter);
-    return true;
   }
+  return true;
 }
 
 bool estimatorKalmanEnqueueTDOA(const tdoaMeasurement_t *uwb)
 {
   ASSERT(isInit);
-  return appendMeasurement(tdoaDataQueue, (void *)uwb);
+  return appendMeasurement(MeasurementTypeTDOA, uwb, sizeof(*uwb));
 }
 
 bool estimatorKalmanEnqueuePosition(const positionMeasurement_t *pos)
 {
   ASSERT(isInit);
-  return appendMeasurement(posDataQueue, (void *)pos);
+  return appendMeasurement(MeasurementTypePosition, pos, sizeof(*pos));
 }
 
 bool estimatorKalmanEnqueuePose(const poseMeasurement_t *pose)
 {
   ASSERT(isInit);
-  return appendMeasurement(poseDataQueue, (void *)pose);
+  return appendMeasurement(MeasurementTypePose, pose, sizeof(*pose));
 }
 
 bool estimatorKalmanEnqueueDistance(const distanceMeasurement_t *dist)
 {
   ASSERT(isInit);
-  return appendMeasurement(distDataQueue, (void *)dist);
+  return appendMeasurement(MeasurementTypeDistance, dist, sizeof(*dist));
 }
 
 bool estimatorKalmanEnqueueFlow(const flowMeasurement_t *flow)
 {
   // A flow measurement (dnx,  dny) [accumulated pixels]
   ASSERT(isInit);
-  return appendMeasurement(flowDataQueue, (void *)flow);
+  return appendMeasurement(MeasurementTypeFlow, flow, sizeof(*flow));
 }
 
 bool estimatorKalmanEnqueueTOF(const tofMeasurement_t *tof)
 {
   // A distance (distance) [m] to the ground along the z_B axis.
   ASSERT(isInit);
-  return appendMeasurement(tofDataQueue, (void *)tof);
+  return appendMeasurement(MeasurementTypeTOF, tof, sizeof(*tof));
 }
 
 bool estimatorKalmanEnqueueAbsoluteHeight(const heightMeasurement_t *height)
 {
   // A distance (height) [m] to the ground along the z axis.
   ASSERT(isInit);
-  return appendMeasurement(heightDataQueue, (void *)height);
+  return appendMeasurement(MeasurementTypeAbsoluteHeight, height, sizeof(*height));
 }
 
 bool estimatorKalmanEnqueueYawError(const yawErrorMeasurement_t* error)
 {
   ASSERT(isInit);
-  return appendMeasurement(yawErrorDataQueue, (void *)error);
+  return appendMeasurement(MeasurementTypeYawError, error, sizeof(*error));
 }
 
 // bool estimatorKalmanEnqueueSweepAngles(const sweepAngleMeasurement_t *angles)
 // {
 //   ASSERT(isInit);
-//   return appendMeasurement(sweepAnglesDataQueue, (void *)angles);
+//   return appendMeasurement(MeasurementTypeSweepAngles, angles, sizeof(*angles));
 // }
 
 bool estimatorKalmanTest(void)
@@ -745,8 +976,27 @@ LOG_GROUP_START(kalman)
   STATS_CNT_RATE_LOG_ADD(rtFinal, &finalizeCounter)
   STATS_CNT_RATE_LOG_ADD(rtApnd, &measurementAppendedCounter)
   STATS_CNT_RATE_LOG_ADD(rtRej, &measurementNotAppendedCounter)
+  LOG_ADD(LOG_UINT32, dropped, &measurementsDropped)
+  LOG_ADD(LOG_UINT32, delayed, &delayedMeasurements)
+  LOG_ADD(LOG_UINT32, histFull, &historyOverflows)
 LOG_GROUP_STOP(kalman)
 
+// Cost of the filter steps, min/avg/max CPU cycles over the last second
+LOG_GROUP_START(kalman_cost)
+  STATS_CNT_COST_LOG_ADD(pred, &predictCost)
+  STATS_CNT_COST_LOG_ADD(updTdoa, &updateCost[MeasurementTypeTDOA])
+  STATS_CNT_COST_LOG_ADD(updPos, &updateCost[MeasurementTypePosition])
+  STATS_CNT_COST_LOG_ADD(updPose, &updateCost[MeasurementTypePose])
+  STATS_CNT_COST_LOG_ADD(updDist, &updateCost[MeasurementTypeDistance])
+  STATS_CNT_COST_LOG_ADD(updFlow, &updateCost[MeasurementTypeFlow])
+  STATS_CNT_COST_LOG_ADD(updTof, &updateCost[MeasurementTypeTOF])
+  STATS_CNT_COST_LOG_ADD(updHgt, &updateCost[MeasurementTypeAbsoluteHeight])
+  STATS_CNT_COST_LOG_ADD(updYaw, &updateCost[MeasurementTypeYawError])
+  STATS_CNT_COST_LOG_ADD(final, &finalizeCost)
+  STATS_CNT_COST_LOG_ADD(ext, &externalizeCost)
+  STATS_CNT_COST_LOG_ADD(replay, &replayCost)
+LOG_GROUP_STOP(kalman_cost)
+
 PARAM_GROUP_START(kalman)
   PARAM_ADD(PARAM_UINT8, resetEstimation, &coreData.resetEstimation)
   PARAM_ADD(PARAM_UINT8, quadIsFlying, &quadIsFlying)
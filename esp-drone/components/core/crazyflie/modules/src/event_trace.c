@@ -0,0 +1,137 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * event_trace.c - Always-on tracing of the begin and end of task stages
+ */
+
+#include "event_trace.h"
+
+#ifdef CONFIG_EVENT_TRACE
+
+#include <string.h>
+
+#include "task.h"
+
+#include "mem.h"
+#include "param.h"
+#include "static_mem.h"
+#include "usec_time.h"
+
+#define EVENT_TRACE_RECORDS CONFIG_EVENT_TRACE_RECORDS
+#define EVENT_TRACE_MASK (EVENT_TRACE_RECORDS - 1)
+#define EVENT_TRACE_CORES portNUM_PROCESSORS
+
+#if EVENT_TRACE_RECORDS & EVENT_TRACE_MASK
+#error "CONFIG_EVENT_TRACE_RECORDS must be a power of two"
+#endif
+#if EVENT_TRACE_CORES > EVENT_TRACE_MAX_CORES
+#error "The trace memory header holds EVENT_TRACE_MAX_CORES cores"
+#endif
+
+// One ring per core, a core only contends with the tasks it preempts, the
+// slots are claimed with an atomic increment
+NO_DMA_CCM_SAFE_ZERO_INIT static eventTraceRecord_t rings[EVENT_TRACE_CORES][EVENT_TRACE_RECORDS];
+static uint32_t written[EVENT_TRACE_CORES];
+static volatile uint8_t enable = 1;
+
+static uint32_t handleMemGetSize(void) { return EVENT_TRACE_HEADER_SIZE + sizeof(rings); }
+static bool handleMemRead(const uint32_t memAddr, const uint8_t readLen, uint8_t* dest);
+static bool handleMemWrite(const uint32_t memAddr, const uint8_t writeLen, const uint8_t* src);
+static const MemoryHandlerDef_t memDef = {
+  .type = MEM_TYPE_EVENT_TRACE,
+  .getSize = handleMemGetSize,
+  .read = handleMemRead,
+  .write = handleMemWrite,
+};
+
+void eventTraceInit(void)
+{
+  memoryRegisterHandler(&memDef);
+}
+
+void eventTraceRecord(uint16_t id, uint16_t arg)
+{
+  if (!enable) {
+    return;
+  }
+
+  uint32_t timestamp = (uint32_t)usecTimestamp();
+  int core = xPortGetCoreID();
+  uint32_t index = __atomic_fetch_add(&written[core], 1, __ATOMIC_RELAXED);
+
+  eventTraceRecord_t *record = &rings[core][index & EVENT_TRACE_MASK];
+  record->timestamp = timestamp;
+  record->id = id;
+  record->arg = arg;
+}
+
+void eventTraceClear(void)
+{
+  for (int core = 0; core < EVENT_TRACE_CORES; core++) {
+    __atomic_store_n(&written[core], 0, __ATOMIC_RELAXED);
+  }
+}
+
+static bool handleMemRead(const uint32_t memAddr, const uint8_t readLen, uint8_t* dest)
+{
+  uint8_t header[EVENT_TRACE_HEADER_SIZE] = {'E', 'T', EVENT_TRACE_VERSION, EVENT_TRACE_CORES};
+  uint32_t records = EVENT_TRACE_RECORDS;
+  uint32_t addr = memAddr;
+  uint8_t len = readLen;
+
+  if (memAddr + readLen > handleMemGetSize()) {
+    return false;
+  }
+
+  if (addr < EVENT_TRACE_HEADER_SIZE) {
+    memcpy(&header[4], &records, 4);
+    for (int core = 0; core < EVENT_TRACE_CORES; core++) {
+      uint32_t count = __atomic_load_n(&written[core], __ATOMIC_RELAXED);
+      memcpy(&header[8 + 4 * core], &count, 4);
+    }
+
+    uint8_t n = EVENT_TRACE_HEADER_SIZE - addr;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(dest, &header[addr], n);
+    dest += n;
+    addr += n;
+    len -= n;
+  }
+  if (len > 0) {
+    memcpy(dest, (const uint8_t *)rings + (addr - EVENT_TRACE_HEADER_SIZE), len);
+  }
+
+  return true;
+}
+
+static bool handleMemWrite(const uint32_t memAddr, const uint8_t writeLen, const uint8_t* src)
+{
+  eventTraceClear();
+  return true;
+}
+
+PARAM_GROUP_START(trace)
+PARAM_ADD(PARAM_UINT8, enable, &enable)
+PARAM_GROUP_STOP(trace)
+
+#endif // CONFIG_EVENT_TRACE
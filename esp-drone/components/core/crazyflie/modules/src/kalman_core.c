@@ -157,7 +157,12 @@ static float initialQuaternion[4] = {0.0, 0.0, 0.0, 0.0};
 
 static uint32_t tdoaCount;
 
-static OutlierFilterLhState_t sweepOutlierFilterState;
+static OutlierFilterRobustState_t sweepOutlierFilterState;
+
+// Flow innovations, x and y, in pixels
+static OutlierFilterRobustState_t flowOutlierFilterState[2];
+static const float flowOutlierThreshold = 4.0f;
+static const float flowOutlierMinLevel = 3.0f; // [standard deviations of the measurement]
 
 
 void kalmanCoreInit(kalmanCoreData_t* this) {
@@ -213,79 +218,102 @@ void kalmanCoreInit(kalmanCoreData_t* this) {
 
   this->baroReferenceHeight = 0.0;
 
-  outlierFilterReset(&sweepOutlierFilterState, 0);
+  outlierFilterRobustReset(&sweepOutlierFilterState);
+  outlierFilterRobustReset(&flowOutlierFilterState[0]);
+  outlierFilterRobustReset(&flowOutlierFilterState[1]);
 }
 
+// Mirrors the upper triangle of P to the lower one and ensures boundedness
+static void boundCovariance(kalmanCoreData_t* this)
+{
+  // TODO: Why would it hit these bounds? Needs to be investigated.
+  for (int i=0; i<KC_STATE_DIM; i++) {
+    for (int j=i; j<KC_STATE_DIM; j++) {
+      float p = this->P[i][j];
+      if (isnan(p) || p > MAX_COVARIANCE) {
+        this->P[i][j] = this->P[j][i] = MAX_COVARIANCE;
+      } else if ( i==j && p < MIN_COVARIANCE ) {
+        this->P[i][j] = this->P[j][i] = MIN_COVARIANCE;
+      } else {
+        this->P[i][j] = this->P[j][i] = p;
+      }
+    }
+  }
+}
+
+/**
+ * Scalar measurement update in Joseph form. With a single row H, PH' is a vector and the Joseph form expands to
+ *
+ * (I - KH) P (I - KH)' + KRK' = P - K(PH')' - (PH')K' + (HPH' + R) KK'
+ *
+ * which is computed element-wise on the upper triangle of the symmetric P, without NxN temporaries. Within a
+ * batch the lower triangle is left stale until kalmanCoreEndBatch().
+ */
 static void scalarUpdate(kalmanCoreData_t* this, xtensa_matrix_instance_f32 *Hm, float error, float stdMeasNoise)
 {
   // The Kalman gain as a column vector
-  NO_DMA_CCM_SAFE_ZERO_INIT static float K[KC_STATE_DIM];
-  static xtensa_matrix_instance_f32 Km = {KC_STATE_DIM, 1, (float *)K};
-
-  // Temporary matrices for the covariance updates
-  NO_DMA_CCM_SAFE_ZERO_INIT __attribute__((aligned(4))) static float tmpNN1d[KC_STATE_DIM * KC_STATE_DIM];
-  static xtensa_matrix_instance_f32 tmpNN1m = {KC_STATE_DIM, KC_STATE_DIM, tmpNN1d};
-
-  NO_DMA_CCM_SAFE_ZERO_INIT __attribute__((aligned(4))) static float tmpNN2d[KC_STATE_DIM * KC_STATE_DIM];
-  static xtensa_matrix_instance_f32 tmpNN2m = {KC_STATE_DIM, KC_STATE_DIM, tmpNN2d};
-
-  NO_DMA_CCM_SAFE_ZERO_INIT __attribute__((aligned(4))) static float tmpNN3d[KC_STATE_DIM * KC_STATE_DIM];
-  static xtensa_matrix_instance_f32 tmpNN3m = {KC_STATE_DIM, KC_STATE_DIM, tmpNN3d};
-
-  NO_DMA_CCM_SAFE_ZERO_INIT __attribute__((aligned(4))) static float HTd[KC_STATE_DIM * 1];
-  static xtensa_matrix_instance_f32 HTm = {KC_STATE_DIM, 1, HTd};
-
-  NO_DMA_CCM_SAFE_ZERO_INIT __attribute__((aligned(4))) static float PHTd[KC_STATE_DIM * 1];
-  static xtensa_matrix_instance_f32 PHTm = {KC_STATE_DIM, 1, PHTd};
+  float K[KC_STATE_DIM];
+  // PH', as a column vector
+  float PHT[KC_STATE_DIM];
+  const float *h = Hm->pData;
 
   ASSERT(Hm->numRows == 1);
   ASSERT(Hm->numCols == KC_STATE_DIM);
 
   // ====== INNOVATION COVARIANCE ======
-
-  mat_trans(Hm, &HTm);
-  mat_mult(&this->Pm, &HTm, &PHTm); // PH'
+  // H usually has one to three non-zero elements
+  for (int i=0; i<KC_STATE_DIM; i++) {
+    PHT[i] = 0;
+  }
+  for (int k=0; k<KC_STATE_DIM; k++) {
+    if (h[k] != 0) {
+      for (int i=0; i<KC_STATE_DIM; i++) {
+        PHT[i] += (i <= k ? this->P[i][k] : this->P[k][i]) * h[k];
+      }
+    }
+  }
   float R = stdMeasNoise*stdMeasNoise;
   float HPHR = R; // HPH' + R
   for (int i=0; i<KC_STATE_DIM; i++) { // Add the element of HPH' to the above
-    HPHR += Hm->pData[i]*PHTd[i]; // this obviously only works if the update is scalar (as in this function)
+    HPHR += h[i]*PHT[i]; // this obviously only works if the update is scalar (as in this function)
   }
   ASSERT(!isnan(HPHR));
 
   // ====== MEASUREMENT UPDATE ======
   // Calculate the Kalman gain and perform the state update
   for (int i=0; i<KC_STATE_DIM; i++) {
-    K[i] = PHTd[i]/HPHR; // kalman gain = (PH' (HPH' + R )^-1)
+    K[i] = PHT[i]/HPHR; // kalman gain = (PH' (HPH' + R )^-1)
     this->S[i] = this->S[i] + K[i] * error; // state update
   }
   assertStateNotNaN(this);
 
   // ====== COVARIANCE UPDATE ======
-  mat_mult(&Km, Hm, &tmpNN1m); // KH
-  for (int i=0; i<KC_STATE_DIM; i++) { tmpNN1d[KC_STATE_DIM*i+i] -= 1; } // KH - I
-  mat_trans(&tmpNN1m, &tmpNN2m); // (KH - I)'
-  mat_mult(&tmpNN1m, &this->Pm, &tmpNN3m); // (KH - I)*P
-  mat_mult(&tmpNN3m, &tmpNN2m, &this->Pm); // (KH - I)*P*(KH - I)'
-  assertStateNotNaN(this);
-  // add the measurement variance and ensure boundedness and symmetry
-  // TODO: Why would it hit these bounds? Needs to be investigated.
+  // Joseph form, measurement noise included
   for (int i=0; i<KC_STATE_DIM; i++) {
     for (int j=i; j<KC_STATE_DIM; j++) {
-      float v = K[i] * R * K[j];
-      float p = 0.5f*this->P[i][j] + 0.5f*this->P[j][i] + v; // add measurement noise
-      if (isnan(p) || p > MAX_COVARIANCE) {
-        this->P[i][j] = this->P[j][i] = MAX_COVARIANCE;
-      } else if ( i==j && p < MIN_COVARIANCE ) {
-        this->P[i][j] = this->P[j][i] = MIN_COVARIANCE;
-      } else {
-        this->P[i][j] = this->P[j][i] = p;
-      }
+      this->P[i][j] = this->P[i][j] - K[i]*PHT[j] - PHT[i]*K[j] + HPHR*K[i]*K[j];
     }
   }
 
+  // ensure boundedness and symmetry, once per batch
+  if (!this->inBatch) {
+    boundCovariance(this);
+  }
+
   assertStateNotNaN(this);
 }
 
+void kalmanCoreBeginBatch(kalmanCoreData_t* this)
+{
+  this->inBatch = true;
+}
+
+void kalmanCoreEndBatch(kalmanCoreData_t* this)
+{
+  this->inBatch = false;
+  boundCovariance(this);
+}
+
 
 void kalmanCoreUpdateWithBaro(kalmanCoreData_t* this, float baroAsl, bool quadIsFlying)
 {
@@ -442,7 +470,7 @@ void kalmanCoreUpdateWithTDOA(kalmanCoreData_t* this, tdoaMeasurement_t *tdoa)
         .z = this->S[KC_STATE_Z],
       };
 
-      bool sampleIsGood = outlierFilterValidateTdoaSteps(tdoa, error, &jacobian, &estimatedPosition);
+      bool sampleIsGood = outlierFilterValidateTdoaSteps(tdoa, error, &jacobian, &estimatedPosition, !this->replaying);
       if (sampleIsGood) {
         scalarUpdate(this, &H, error, tdoa->stdDev);
       }
@@ -511,7 +539,10 @@ void kalmanCoreUpdateWithFlow(kalmanCoreData_t* this, const flowMeasurement_t *f
   hx[KC_STATE_PX] = (Npix * flow->dt / thetapix) * (this->R[2][2] / z_g);
 
   //First update
-  scalarUpdate(this, &Hx, measuredNX-predictedNX, flow->stdDevX);
+  if (outlierFilterValidateRobust(&flowOutlierFilterState[0], measuredNX-predictedNX, flowOutlierThreshold,
+                                  flowOutlierMinLevel * flow->stdDevX, !this->replaying)) {
+    scalarUpdate(this, &Hx, measuredNX-predictedNX, flow->stdDevX);
+  }
 
   // ~~~ Y velocity prediction and update ~~~
   float hy[KC_STATE_DIM] = {0};
@@ -524,7 +555,10 @@ void kalmanCoreUpdateWithFlow(kalmanCoreData_t* this, const flowMeasurement_t *f
   hy[KC_STATE_PY] = (Npix * flow->dt / thetapix) * (this->R[2][2] / z_g);
 
   // Second update
-  scalarUpdate(this, &Hy, measuredNY-predictedNY, flow->stdDevY);
+  if (outlierFilterValidateRobust(&flowOutlierFilterState[1], measuredNY-predictedNY, flowOutlierThreshold,
+                                  flowOutlierMinLevel * flow->stdDevY, !this->replaying)) {
+    scalarUpdate(this, &Hy, measuredNY-predictedNY, flow->stdDevY);
+  }
 }
 
 
@@ -602,7 +636,7 @@ void kalmanCoreUpdateWithYawError(kalmanCoreData_t *this, yawErrorMeasurement_t
   // const float measuredSweepAngle = sweepInfo->measuredSweepAngle;
   // const float error = measuredSweepAngle - predictedSweepAngle;
 
-  // if (outlierFilterValidateLighthouseSweep(&sweepOutlierFilterState, r, error, tick)) {
+  // if (outlierFilterValidateLighthouseSweep(&sweepOutlierFilterState, r, error, !this->replaying)) {
   //   // Calculate H vector (in the rotor reference frame)
   //   const float z_tan_t = z * tan_t;
   //   const float qNum = r2 - z_tan_t * z_tan_t;
@@ -630,6 +664,48 @@ void kalmanCoreUpdateWithYawError(kalmanCoreData_t *this, yawErrorMeasurement_t
   // }
 //}
 
+/**
+ * Covariance propagation P = A P A' exploiting the structure of the linearized dynamics. In 3x3 blocks of
+ * position, body-frame velocity and attitude error, A is block upper triangular with an identity position block:
+ *
+ *     | I  Axp Axd |
+ * A = | 0  App Apd |
+ *     | 0  0   Add |
+ *
+ * so only the non-zero blocks are multiplied, and only the upper triangle of the symmetric result is computed.
+ * This takes about 540 multiplications instead of the 1458 of the two dense products.
+ */
+static void predictCovariance(float P[KC_STATE_DIM][KC_STATE_DIM], float A[KC_STATE_DIM][KC_STATE_DIM])
+{
+  NO_DMA_CCM_SAFE_ZERO_INIT static float AP[KC_STATE_DIM][KC_STATE_DIM];
+
+  // AP = A P, only the blocks on and right of the diagonal are used below
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    bool position = (i < KC_STATE_PX);
+    int first = (i < KC_STATE_D0) ? KC_STATE_PX : KC_STATE_D0; // first non-zero column, besides the identity
+    for (int j = position ? KC_STATE_X : first; j < KC_STATE_DIM; j++) {
+      float sum = position ? P[i][j] : 0;
+      for (int k = first; k < KC_STATE_DIM; k++) {
+        sum += A[i][k] * P[k][j];
+      }
+      AP[i][j] = sum;
+    }
+  }
+
+  // P = AP A', upper triangle mirrored to the lower one
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    for (int j = i; j < KC_STATE_DIM; j++) {
+      int first = (j < KC_STATE_D0) ? KC_STATE_PX : KC_STATE_D0;
+      float sum = (j < KC_STATE_PX) ? AP[i][j] : 0;
+      for (int k = first; k < KC_STATE_DIM; k++) {
+        sum += AP[i][k] * A[j][k];
+      }
+      P[i][j] = sum;
+      P[j][i] = sum;
+    }
+  }
+}
+
 void kalmanCorePredict(kalmanCoreData_t* this, float cmdThrust, Axis3f *acc, Axis3f *gyro, float dt, bool quadIsFlying)
 {
   /* Here we discretize (euler forward) and linearise the quadrocopter dynamics in order
@@ -653,16 +729,8 @@ void kalmanCorePredict(kalmanCoreData_t* this, float cmdThrust, Axis3f *acc, Axi
    * since error information is incorporated into R after each Kalman update.
    */
 
-  // The linearized update matrix
+  // The linearized update matrix, the blocks left of the diagonal stay zero
   NO_DMA_CCM_SAFE_ZERO_INIT static float A[KC_STATE_DIM][KC_STATE_DIM];
-  static __attribute__((aligned(4))) xtensa_matrix_instance_f32 Am = { KC_STATE_DIM, KC_STATE_DIM, (float *)A}; // linearized dynamics for covariance update;
-
-  // Temporary matrices for the covariance updates
-  NO_DMA_CCM_SAFE_ZERO_INIT static float tmpNN1d[KC_STATE_DIM * KC_STATE_DIM];
-  static __attribute__((aligned(4))) xtensa_matrix_instance_f32 tmpNN1m = { KC_STATE_DIM, KC_STATE_DIM, tmpNN1d};
-
-  NO_DMA_CCM_SAFE_ZERO_INIT static float tmpNN2d[KC_STATE_DIM * KC_STATE_DIM];
-  static __attribute__((aligned(4))) xtensa_matrix_instance_f32 tmpNN2m = { KC_STATE_DIM, KC_STATE_DIM, tmpNN2d};
 
   float dt2 = dt*dt;
 
@@ -766,9 +834,7 @@ void kalmanCorePredict(kalmanCoreData_t* this, float cmdThrust, Axis3f *acc, Axi
 
 
   // ====== COVARIANCE UPDATE ======
-  mat_mult(&Am, &this->Pm, &tmpNN1m); // A P
-  mat_trans(&Am, &tmpNN2m); // A'
-  mat_mult(&tmpNN1m, &tmpNN2m, &this->Pm); // A P A'
+  predictCovariance(this->P, A); // A P A'
   // Process noise is added after the return from the prediction step
 
   // ====== PREDICTION STEP ======
@@ -837,10 +903,17 @@ void kalmanCorePredict(kalmanCoreData_t* this, float cmdThrust, Axis3f *acc, Axi
   float dtwz = dt*gyro->z;
 
   // compute the quaternion values in [w,x,y,z] order
+  // no rotation at all, as from a replayed still gyro, would divide 0 by 0
   float angle = xtensa_sqrt(dtwx*dtwx + dtwy*dtwy + dtwz*dtwz);
-  float ca = xtensa_cos_f32(angle/2.0f);
-  float sa = xtensa_sin_f32(angle/2.0f);
-  float dq[4] = {ca , sa*dtwx/angle , sa*dtwy/angle , sa*dtwz/angle};
+  float dq[4] = {1, 0, 0, 0};
+  if (angle > 0) {
+    float ca = xtensa_cos_f32(angle/2.0f);
+    float sa = xtensa_sin_f32(angle/2.0f);
+    dq[0] = ca;
+    dq[1] = sa*dtwx/angle;
+    dq[2] = sa*dtwy/angle;
+    dq[3] = sa*dtwz/angle;
+  }
 
   float tmpq0;
   float tmpq1;
@@ -867,11 +940,13 @@ void kalmanCorePredict(kalmanCoreData_t* this, float cmdThrust, Axis3f *acc, Axi
   this->q[0] = tmpq0/norm; this->q[1] = tmpq1/norm; this->q[2] = tmpq2/norm; this->q[3] = tmpq3/norm;
   assertStateNotNaN(this);
 
+#ifdef CONFIG_KALMAN_POSITION_DEADZONE
   // Deadzone to ignore small noise
   if (fabsf(this->S[KC_STATE_PX]) < 0.05f) this->S[KC_STATE_PX] = 0;
   if (fabsf(this->S[KC_STATE_PY]) < 0.05f) this->S[KC_STATE_PY] = 0;
   if (fabsf(this->S[KC_STATE_X])  < 0.05f) this->S[KC_STATE_X]  = 0;
   if (fabsf(this->S[KC_STATE_Y])  < 0.05f) this->S[KC_STATE_Y]  = 0;
+#endif
 
 }
 
@@ -911,19 +986,45 @@ void kalmanCoreAddProcessNoise(kalmanCoreData_t* this, float dt)
 
 
 
-void kalmanCoreFinalize(kalmanCoreData_t* this, uint32_t tick)
+/**
+ * Covariance rotation P = A P A' of the finalization, with A = diag(I, Ad) rotating the attitude error.
+ * Only the attitude rows and columns change, so they are rotated in place without N x N temporaries:
+ *
+ *     | Pxx      Pxd Ad'    |
+ * P = | Ad Pdx   Ad Pdd Ad' |
+ */
+static void rotateAttitudeCovariance(float P[KC_STATE_DIM][KC_STATE_DIM], float Ad[3][3])
 {
-  // Matrix to rotate the attitude covariances once updated
-  NO_DMA_CCM_SAFE_ZERO_INIT static float A[KC_STATE_DIM][KC_STATE_DIM];
-  static xtensa_matrix_instance_f32 Am = {KC_STATE_DIM, KC_STATE_DIM, (float *)A};
-
-  // Temporary matrices for the covariance updates
-  NO_DMA_CCM_SAFE_ZERO_INIT static float tmpNN1d[KC_STATE_DIM * KC_STATE_DIM];
-  static xtensa_matrix_instance_f32 tmpNN1m = {KC_STATE_DIM, KC_STATE_DIM, tmpNN1d};
+  // Pxd Ad', mirrored to Ad Pdx
+  for (int i = 0; i < KC_STATE_D0; i++) {
+    float pd[3] = {P[i][KC_STATE_D0], P[i][KC_STATE_D1], P[i][KC_STATE_D2]};
+    for (int a = 0; a < 3; a++) {
+      float sum = Ad[a][0] * pd[0] + Ad[a][1] * pd[1] + Ad[a][2] * pd[2];
+      P[i][KC_STATE_D0 + a] = sum;
+      P[KC_STATE_D0 + a][i] = sum;
+    }
+  }
 
-  NO_DMA_CCM_SAFE_ZERO_INIT static float tmpNN2d[KC_STATE_DIM * KC_STATE_DIM];
-  static xtensa_matrix_instance_f32 tmpNN2m = {KC_STATE_DIM, KC_STATE_DIM, tmpNN2d};
+  // Ad Pdd Ad'
+  float AdPdd[3][3];
+  for (int a = 0; a < 3; a++) {
+    for (int b = 0; b < 3; b++) {
+      AdPdd[a][b] = Ad[a][0] * P[KC_STATE_D0][KC_STATE_D0 + b]
+                  + Ad[a][1] * P[KC_STATE_D1][KC_STATE_D0 + b]
+                  + Ad[a][2] * P[KC_STATE_D2][KC_STATE_D0 + b];
+    }
+  }
+  for (int a = 0; a < 3; a++) {
+    for (int b = a; b < 3; b++) {
+      float sum = AdPdd[a][0] * Ad[b][0] + AdPdd[a][1] * Ad[b][1] + AdPdd[a][2] * Ad[b][2];
+      P[KC_STATE_D0 + a][KC_STATE_D0 + b] = sum;
+      P[KC_STATE_D0 + b][KC_STATE_D0 + a] = sum;
+    }
+  }
+}
 
+void kalmanCoreFinalize(kalmanCoreData_t* this, uint32_t tick)
+{
   // Incorporate the attitude error (Kalman filter state) with the attitude
   float v0 = this->S[KC_STATE_D0];
   float v1 = this->S[KC_STATE_D1];
@@ -965,29 +1066,21 @@ void kalmanCoreFinalize(kalmanCoreData_t* this, uint32_t tick)
     float d1 = v1/2; // so we use a first order approximation to d0 = tan(|v0|/2)*v0/|v0|
     float d2 = v2/2;
 
-    A[KC_STATE_X][KC_STATE_X] = 1;
-    A[KC_STATE_Y][KC_STATE_Y] = 1;
-    A[KC_STATE_Z][KC_STATE_Z] = 1;
-
-    A[KC_STATE_PX][KC_STATE_PX] = 1;
-    A[KC_STATE_PY][KC_STATE_PY] = 1;
-    A[KC_STATE_PZ][KC_STATE_PZ] = 1;
-
-    A[KC_STATE_D0][KC_STATE_D0] =  1 - d1*d1/2 - d2*d2/2;
-    A[KC_STATE_D0][KC_STATE_D1] =  d2 + d0*d1/2;
-    A[KC_STATE_D0][KC_STATE_D2] = -d1 + d0*d2/2;
+    // The rotation only involves the attitude error, A = diag(I, Ad)
+    float Ad[3][3];
+    Ad[0][0] =  1 - d1*d1/2 - d2*d2/2;
+    Ad[0][1] =  d2 + d0*d1/2;
+    Ad[0][2] = -d1 + d0*d2/2;
 
-    A[KC_STATE_D1][KC_STATE_D0] = -d2 + d0*d1/2;
-    A[KC_STATE_D1][KC_STATE_D1] =  1 - d0*d0/2 - d2*d2/2;
-    A[KC_STATE_D1][KC_STATE_D2] =  d0 + d1*d2/2;
+    Ad[1][0] = -d2 + d0*d1/2;
+    Ad[1][1] =  1 - d0*d0/2 - d2*d2/2;
+    Ad[1][2] =  d0 + d1*d2/2;
 
-    A[KC_STATE_D2][KC_STATE_D0] =  d1 + d0*d2/2;
-    A[KC_STATE_D2][KC_STATE_D1] = -d0 + d1*d2/2;
-    A[KC_STATE_D2][KC_STATE_D2] = 1 - d0*d0/2 - d1*d1/2;
+    Ad[2][0] =  d1 + d0*d2/2;
+    Ad[2][1] = -d0 + d1*d2/2;
+    Ad[2][2] = 1 - d0*d0/2 - d1*d1/2;
 
-    mat_trans(&Am, &tmpNN1m); // A'
-    mat_mult(&Am, &this->Pm, &tmpNN2m); // AP
-    mat_mult(&tmpNN2m, &tmpNN1m, &this->Pm); //APA'
+    rotateAttitudeCovariance(this->P, Ad);
   }
 
   // convert the new attitude to a rotation matrix, such that we can rotate body-frame velocity and acc
@@ -1053,18 +1146,24 @@ void kalmanCoreExternalizeState(const kalmanCoreData_t* this, state_t *state, co
       .z = this->R[2][0]*acc->x + this->R[2][1]*acc->y + this->R[2][2]*acc->z - 1
   };
 
-  // convert the new attitude into Euler YPR
-  float yaw = atan2f(2*(this->q[1]*this->q[2]+this->q[0]*this->q[3]) , this->q[0]*this->q[0] + this->q[1]*this->q[1] - this->q[2]*this->q[2] - this->q[3]*this->q[3]);
-  float pitch = asinf(-2*(this->q[1]*this->q[3] - this->q[0]*this->q[2]));
-  float roll = atan2f(2*(this->q[2]*this->q[3]+this->q[0]*this->q[1]) , this->q[0]*this->q[0] - this->q[1]*this->q[1] - this->q[2]*this->q[2] + this->q[3]*this->q[3]);
-
-  // Save attitude, adjusted for the legacy CF2 body coordinate system
-  state->attitude = (attitude_t){
-      .timestamp = tick,
-      .roll = roll*RAD_TO_DEG,
-      .pitch = -pitch*RAD_TO_DEG,
-      .yaw = yaw*RAD_TO_DEG
-  };
+  // The attitude only changes on predictions and updates, a fraction of the rounds. The Euler
+  // angles of the previous externalization are kept as long as the quaternion is the same.
+  const bool attitudeChanged = state->attitudeQuaternion.w != this->q[0] || state->attitudeQuaternion.x != this->q[1]
+                               || state->attitudeQuaternion.y != this->q[2] || state->attitudeQuaternion.z != this->q[3];
+  if (attitudeChanged) {
+    // convert the new attitude into Euler YPR
+    float yaw = atan2f(2*(this->q[1]*this->q[2]+this->q[0]*this->q[3]) , this->q[0]*this->q[0] + this->q[1]*this->q[1] - this->q[2]*this->q[2] - this->q[3]*this->q[3]);
+    float pitch = asinf(-2*(this->q[1]*this->q[3] - this->q[0]*this->q[2]));
+    float roll = atan2f(2*(this->q[2]*this->q[3]+this->q[0]*this->q[1]) , this->q[0]*this->q[0] - this->q[1]*this->q[1] - this->q[2]*this->q[2] + this->q[3]*this->q[3]);
+
+    // Save attitude, adjusted for the legacy CF2 body coordinate system
+    state->attitude = (attitude_t){
+        .roll = roll*RAD_TO_DEG,
+        .pitch = -pitch*RAD_TO_DEG,
+        .yaw = yaw*RAD_TO_DEG
+    };
+  }
+  state->attitude.timestamp = tick;
 
   // Save quaternion, hopefully one day this could be used in a better controller.
   // Note that this is not adjusted for the legacy coordinate system
@@ -1102,6 +1201,65 @@ void kalmanCoreDecoupleXY(kalmanCoreData_t* this)
   decoupleState(this, KC_STATE_PY);
 }
 
+#ifdef CONFIG_KALMAN_COMPACT_COVARIANCE
+#define CORRELATION_SCALE 32767.0f
+
+// The standard deviations renormalise the covariance on every save, so the correlations stay within Q15
+static void compactCovariance(kalmanCoreCompactCovariance_t* compact, const float P[KC_STATE_DIM][KC_STATE_DIM])
+{
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    compact->stdDev[i] = sqrtf(fmaxf(P[i][i], 0.0f));
+  }
+
+  int n = 0;
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    for (int j = i + 1; j < KC_STATE_DIM; j++) {
+      float norm = compact->stdDev[i] * compact->stdDev[j];
+      float rho = (norm > 0.0f) ? P[i][j] / norm : 0.0f;
+      rho = fminf(fmaxf(rho, -1.0f), 1.0f);
+      compact->correlation[n++] = (int16_t)lrintf(rho * CORRELATION_SCALE);
+    }
+  }
+}
+
+static void expandCovariance(float P[KC_STATE_DIM][KC_STATE_DIM], const kalmanCoreCompactCovariance_t* compact)
+{
+  int n = 0;
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    P[i][i] = compact->stdDev[i] * compact->stdDev[i];
+    for (int j = i + 1; j < KC_STATE_DIM; j++) {
+      float p = compact->correlation[n++] * (compact->stdDev[i] * compact->stdDev[j] / CORRELATION_SCALE);
+      P[i][j] = p;
+      P[j][i] = p;
+    }
+  }
+}
+#endif
+
+void kalmanCoreSaveSnapshot(const kalmanCoreData_t* this, kalmanCoreSnapshot_t* snapshot)
+{
+  memcpy(snapshot->S, this->S, sizeof(snapshot->S));
+  memcpy(snapshot->q, this->q, sizeof(snapshot->q));
+  memcpy(snapshot->R, this->R, sizeof(snapshot->R));
+#ifdef CONFIG_KALMAN_COMPACT_COVARIANCE
+  compactCovariance(&snapshot->P, this->P);
+#else
+  memcpy(snapshot->P, this->P, sizeof(snapshot->P));
+#endif
+}
+
+void kalmanCoreRestoreSnapshot(kalmanCoreData_t* this, const kalmanCoreSnapshot_t* snapshot)
+{
+  memcpy(this->S, snapshot->S, sizeof(this->S));
+  memcpy(this->q, snapshot->q, sizeof(this->q));
+  memcpy(this->R, snapshot->R, sizeof(this->R));
+#ifdef CONFIG_KALMAN_COMPACT_COVARIANCE
+  expandCovariance(this->P, &snapshot->P);
+#else
+  memcpy(this->P, snapshot->P, sizeof(this->P));
+#endif
+}
+
 // Stock log groups
 LOG_GROUP_START(kalman_pred)
   LOG_ADD(LOG_FLOAT, predNX, &predictedNX)
@@ -1111,7 +1269,9 @@ LOG_GROUP_START(kalman_pred)
 LOG_GROUP_STOP(kalman_pred)
 
 LOG_GROUP_START(outlierf)
-  LOG_ADD(LOG_INT32, lhWin, &sweepOutlierFilterState.openingWindow)
+  LOG_ADD(LOG_FLOAT, lhAccLev, &sweepOutlierFilterState.acceptanceLevel)
+  LOG_ADD(LOG_UINT32, flowRejX, &flowOutlierFilterState[0].rejected)
+  LOG_ADD(LOG_UINT32, flowRejY, &flowOutlierFilterState[1].rejected)
 LOG_GROUP_STOP(outlierf)
 
 PARAM_GROUP_START(kalman)
@@ -28,6 +28,7 @@
  * FIXME: See if we can factorise the TOC code */
 
 #include <string.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -35,15 +36,15 @@
 /* FreeRtos includes */
 #include "FreeRTOS.h"
 #include "task.h"
-#include "timers.h"
 #include "semphr.h"
 
 #include "config.h"
 #include "crtp.h"
 #include "log.h"
+#include "log_record.h"
 #include "crc.h"
-#include "worker.h"
 #include "num.h"
+#include "usec_time.h"
 
 #include "console.h"
 #include "cfassert.h"
@@ -79,8 +80,9 @@ typedef enum {
   acqType_function = 1,
 } acquisitionType_t;
 
-// Maximum log payload length (4 bytes are used for block id and timestamp)
-#define LOG_MAX_LEN 26
+// Maximum log payload length (4 bytes are used for block id and timestamp),
+// larger blocks can be created once jumbo packets are negotiated
+#define LOG_MAX_LEN (crtpGetMaxDataSize() - 4)
 
 /* Log packet parameters storage */
 #define LOG_MAX_OPS 128
@@ -89,17 +91,53 @@ struct log_ops {
   struct log_ops * next;
   uint8_t storageType : 4;
   uint8_t logType     : 4;
+  bool scaled;          // Sent as int16 of value * 10^scaleExp instead of logType
+  int8_t scaleExp;
+  uint32_t last;        // Last value sent, in delta mode
   void * variable;
   acquisitionType_t acquisitionType;
 };
 
+/*
+ * Block modes. In delta mode the packet carries a bitmap after the timestamp,
+ * one bit per variable in block order, and only the variables whose value
+ * changed since the last packet. Every LOG_DELTA_KEYFRAME_PERIOD packets all
+ * variables are sent so the client recovers from lost packets.
+ */
+#define LOG_BLOCK_MODE_FULL  0
+#define LOG_BLOCK_MODE_DELTA 1
+#define LOG_DELTA_KEYFRAME_PERIOD 10
+
+// Range of the decimal exponent of quantized variables
+#define LOG_SCALE_EXP_MIN (-4)
+#define LOG_SCALE_EXP_MAX 4
+#define LOG_SCALE_NONE 0x7F
+
+static const float scaleFactors[] = {
+  1e-4f, 1e-3f, 1e-2f, 1e-1f, 1.0f, 1e1f, 1e2f, 1e3f, 1e4f,
+};
+
 struct log_block {
   int id;
-  xTimerHandle timer;
-  StaticTimer_t timerBuffer;
+  TickType_t period;    // 0 for a single run
+  TickType_t nextDue;
+  int8_t heapPos;       // Position in the schedule heap, BLOCK_NOT_SCHEDULED if none
   struct log_ops * ops;
+  uint8_t mode;
+  uint8_t deltaCount;   // Packets sent since the last keyframe, owned by logRunBlock
+  uint32_t changes;     // Bumped by blockChanged() on each configuration change
+  uint32_t runChanges;  // Value of changes seen by the last run
+  bool record;          // Packets go to the record buffer instead of the link
 };
 
+/*
+ * logRunBlock reads the blocks without taking logLock, RCU style. Writers,
+ * under logLock, only publish fully initialized ops at the tail of a list
+ * and wait for the running block to finish with logSynchronize() before
+ * freeing ops that were unlinked. readEpoch is odd while a block is read.
+ */
+static uint32_t readEpoch = 0;
+
 NO_DMA_CCM_SAFE_ZERO_INIT static struct log_ops logOps[LOG_MAX_OPS];
 NO_DMA_CCM_SAFE_ZERO_INIT static struct log_block logBlocks[LOG_MAX_BLOCKS];
 static xSemaphoreHandle logLock;
@@ -133,16 +171,24 @@ struct ops_setting_v2 {
 #define CONTROL_RESET           5
 #define CONTROL_CREATE_BLOCK_V2 6
 #define CONTROL_APPEND_BLOCK_V2 7
+#define CONTROL_SET_BLOCK_MODE  8
+#define CONTROL_SET_VAR_SCALE   9
+#define CONTROL_RECORD_BLOCK    10
 
 #define BLOCK_ID_FREE -1
+#define BLOCK_NOT_SCHEDULED -1
 
 //Private functions
 static void logTask(void * prm);
+static void logSchedulerTask(void * prm);
 static void logTOCProcess(int command);
 static void logControlProcess(void);
 
 void logRunBlock(void * arg);
-void logBlockTimed(xTimerHandle timer);
+static void blockSchedule(struct log_block * block, TickType_t period);
+static void blockUnschedule(struct log_block * block);
+static void blockChanged(struct log_block * block);
+static void logSynchronize(void);
 
 //These are set by the Linker
 extern struct log_s _log_start;
@@ -154,8 +200,26 @@ static int logsLen;
 static uint32_t logsCrc;
 static uint16_t logsCount = 0;
 
+// TOC lookup tables, built at init
+#define TOC_NO_ENTRY 0xffffu
+static uint16_t * logsIdIndex;     // TOC id -> logs index
+static uint16_t * logsGroupIndex;  // logs index -> index of its group start, TOC_NO_ENTRY if none
+static uint16_t * logsHash;        // hash of group and name -> TOC id, open addressing
+static uint16_t logsHashMask;
+
 static CRTPPacket p;
 
+/*
+ * Started blocks ordered by next due tick in a binary min-heap, run by the
+ * log scheduler task. Protected by schedMux so the scheduler never waits
+ * for the control processing.
+ */
+static struct log_block * schedHeap[LOG_MAX_BLOCKS];
+static int schedHeapSize = 0;
+static portMUX_TYPE schedMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t schedTaskHandle;
+static uint32_t schedMissed = 0;    // Periods skipped because a block ran late
+
 static bool isInit = false;
 
 /* Log management functions */
@@ -166,10 +230,16 @@ static int logCreateBlockV2(unsigned char id, struct ops_setting_v2 * settings,
 static int logDeleteBlock(int id);
 static int logStartBlock(int id, unsigned int period);
 static int logStopBlock(int id);
+static int logSetBlockMode(int id, uint8_t mode);
+static int logSetVariableScale(int id, uint8_t index, int8_t scaleExp);
+static int logRecordBlock(int id, uint16_t period);
 static void logReset();
+static void logResetStreaming(void);
+static void logBuildIndex(void);
 static acquisitionType_t acquisitionTypeFromLogType(uint8_t logType);
 
 STATIC_MEM_TASK_ALLOC_STACK_NO_DMA_CCM_SAFE(logTask, LOG_TASK_STACKSIZE);
+STATIC_MEM_TASK_ALLOC_STACK_NO_DMA_CCM_SAFE(logSchedulerTask, LOG_SCHED_TASK_STACKSIZE);
 
 void logInit(void)
 {
@@ -219,6 +289,8 @@ void logInit(void)
       logsCount++;
   }
 
+  logBuildIndex();
+
   //Manually free all log blocks
   for(i=0; i<LOG_MAX_BLOCKS; i++)
     logBlocks[i].id = BLOCK_ID_FREE;
@@ -226,8 +298,11 @@ void logInit(void)
   //Init data structures and set the log subsystem in a known state
   logReset();
 
-  //Start the log task
-  STATIC_MEM_TASK_CREATE(logTask, logTask, LOG_TASK_NAME, NULL, LOG_TASK_PRI);
+  logRecordInit();
+
+  //Start the log task and the block scheduler
+  STATIC_MEM_TASK_CREATE_PINNED(logTask, logTask, LOG_TASK_NAME, NULL, LOG_TASK_PRI, LOG_TASK_CORE);
+  schedTaskHandle = STATIC_MEM_TASK_CREATE_PINNED(logSchedulerTask, logSchedulerTask, LOG_SCHED_TASK_NAME, NULL, LOG_SCHED_TASK_PRI, LOG_SCHED_TASK_CORE);
 
   isInit = true;
 }
@@ -414,6 +489,15 @@ void logControlProcess()
                             (struct ops_setting_v2*)&p.data[2],
                             (p.size-2)/sizeof(struct ops_setting_v2) );
       break;
+    case CONTROL_SET_BLOCK_MODE:
+      ret = logSetBlockMode( p.data[1], p.data[2] );
+      break;
+    case CONTROL_SET_VAR_SCALE:
+      ret = logSetVariableScale( p.data[1], p.data[2], (int8_t)p.data[3] );
+      break;
+    case CONTROL_RECORD_BLOCK:
+      ret = logRecordBlock( p.data[1], p.data[2] | (p.data[3] << 8) );
+      break;
   }
 
   //Commands answer
@@ -436,15 +520,12 @@ static int logCreateBlock(unsigned char id, struct ops_setting * settings, int l
     return ENOMEM;
 
   logBlocks[i].id = id;
-  logBlocks[i].timer = xTimerCreateStatic("logTimer", M2T(1000), pdTRUE,
-    &logBlocks[i], logBlockTimed, &logBlocks[i].timerBuffer);
+  logBlocks[i].period = 0;
+  logBlocks[i].heapPos = BLOCK_NOT_SCHEDULED;
   logBlocks[i].ops = NULL;
-
-  if (logBlocks[i].timer == NULL)
-  {
-	logBlocks[i].id = BLOCK_ID_FREE;
-	return ENOMEM;
-  }
+  logBlocks[i].mode = LOG_BLOCK_MODE_FULL;
+  logBlocks[i].record = false;
+  blockChanged(&logBlocks[i]);
 
   LOG_DEBUG("Added block ID %d\n", id);
 
@@ -465,15 +546,12 @@ static int logCreateBlockV2(unsigned char id, struct ops_setting_v2 * settings,
     return ENOMEM;
 
   logBlocks[i].id = id;
-  logBlocks[i].timer = xTimerCreateStatic("logTimer", M2T(1000), pdTRUE,
-    &logBlocks[i], logBlockTimed, &logBlocks[i].timerBuffer);
+  logBlocks[i].period = 0;
+  logBlocks[i].heapPos = BLOCK_NOT_SCHEDULED;
   logBlocks[i].ops = NULL;
-
-  if (logBlocks[i].timer == NULL)
-  {
-  logBlocks[i].id = BLOCK_ID_FREE;
-  return ENOMEM;
-  }
+  logBlocks[i].mode = LOG_BLOCK_MODE_FULL;
+  logBlocks[i].record = false;
+  blockChanged(&logBlocks[i]);
 
   LOG_DEBUG("Added block ID %d\n", id);
 
@@ -481,6 +559,8 @@ static int logCreateBlockV2(unsigned char id, struct ops_setting_v2 * settings,
 }
 
 static int blockCalcLength(struct log_block * block);
+static int blockCountOps(struct log_block * block);
+static bool blockFits(struct log_block * block, int extraLength, int extraOps);
 static struct log_ops * opsMalloc();
 static void opsFree(struct log_ops * ops);
 static void blockAppendOps(struct log_block * block, struct log_ops * ops);
@@ -505,11 +585,10 @@ static int logAppendBlock(int id, struct ops_setting * settings, int len)
 
   for (i=0; i<len; i++)
   {
-    int currentLength = blockCalcLength(block);
     struct log_ops * ops;
     int varId;
 
-    if ((currentLength + typeLength[settings[i].logType & TYPE_MASK])>LOG_MAX_LEN) {
+    if (!blockFits(block, typeLength[settings[i].logType & TYPE_MASK], 1)) {
       LOG_ERROR("Trying to append a full block. Block id %d.\n", id);
       return E2BIG;
     }
@@ -573,11 +652,10 @@ static int logAppendBlockV2(int id, struct ops_setting_v2 * settings, int len)
 
   for (i=0; i<len; i++)
   {
-    int currentLength = blockCalcLength(block);
     struct log_ops * ops;
     int varId;
 
-    if ((currentLength + typeLength[settings[i].logType & TYPE_MASK])>LOG_MAX_LEN) {
+    if (!blockFits(block, typeLength[settings[i].logType & TYPE_MASK], 1)) {
       LOG_ERROR("Trying to append a full block. Block id %d.\n", id);
       return E2BIG;
     }
@@ -636,7 +714,14 @@ static int logDeleteBlock(int id)
     return ENOENT;
   }
 
+  blockUnschedule(&logBlocks[i]);
+
+  // Unlink the ops before freeing them, logRunBlock may be reading them
   ops = logBlocks[i].ops;
+  __atomic_store_n(&logBlocks[i].ops, NULL, __ATOMIC_RELEASE);
+  __atomic_store_n(&logBlocks[i].id, BLOCK_ID_FREE, __ATOMIC_RELEASE);
+  logSynchronize();
+
   while (ops)
   {
     opsNext = ops->next;
@@ -644,13 +729,6 @@ static int logDeleteBlock(int id)
     ops = opsNext;
   }
 
-  if (logBlocks[i].timer != 0) {
-    xTimerStop(logBlocks[i].timer, portMAX_DELAY);
-    xTimerDelete(logBlocks[i].timer, portMAX_DELAY);
-    logBlocks[i].timer = 0;
-  }
-
-  logBlocks[i].id = BLOCK_ID_FREE;
   return 0;
 }
 
@@ -667,15 +745,10 @@ static int logStartBlock(int id, unsigned int period)
   }
 
   LOG_DEBUG("Starting block %d with period %dms\n", id, period);
+  logBlocks[i].record = false;
 
-  if (period>0)
-  {
-    xTimerChangePeriod(logBlocks[i].timer, M2T(period), 100);
-    xTimerStart(logBlocks[i].timer, 100);
-  } else {
-    // single-shoot run
-    workerSchedule(logRunBlock, &logBlocks[i]);
-  }
+  // A period of 0 is a single-shoot run
+  blockSchedule(&logBlocks[i], M2T(period));
 
   return 0;
 }
@@ -692,20 +765,233 @@ static int logStopBlock(int id)
     return ENOENT;
   }
 
-  xTimerStop(logBlocks[i].timer, portMAX_DELAY);
+  blockUnschedule(&logBlocks[i]);
+
+  return 0;
+}
+
+static int logRecordBlock(int id, uint16_t period)
+{
+  int i;
+
+  for (i=0; i<LOG_MAX_BLOCKS; i++)
+    if (logBlocks[i].id == id) break;
+
+  if (i >= LOG_MAX_BLOCKS) {
+    LOG_ERROR("Trying to record block id %d that doesn't exist.\n", id);
+    return ENOENT;
+  }
+
+  if (!logRecordTest())
+    return ENOMEM;
+
+  blockUnschedule(&logBlocks[i]);
+  logBlocks[i].record = (period > 0);
+
+  if (period > 0)
+  {
+    // Recording is not limited by the link, so the period is in ms
+    LOG_DEBUG("Recording block %d with period %dms\n", id, period);
+    blockSchedule(&logBlocks[i], M2T(period) ? M2T(period) : 1);
+  }
 
   return 0;
 }
 
-/* This function is called by the timer subsystem */
-void logBlockTimed(xTimerHandle timer)
+static int logSetBlockMode(int id, uint8_t mode)
+{
+  int i;
+
+  for (i=0; i<LOG_MAX_BLOCKS; i++)
+    if (logBlocks[i].id == id) break;
+
+  if (i >= LOG_MAX_BLOCKS) {
+    LOG_ERROR("Trying to set the mode of block id %d that doesn't exist.\n", id);
+    return ENOENT;
+  }
+
+  if (mode != LOG_BLOCK_MODE_FULL && mode != LOG_BLOCK_MODE_DELTA)
+    return EINVAL;
+
+  uint8_t previousMode = logBlocks[i].mode;
+  logBlocks[i].mode = mode;
+  if (!blockFits(&logBlocks[i], 0, 0)) {
+    // No room left for the bitmap
+    logBlocks[i].mode = previousMode;
+    return E2BIG;
+  }
+  blockChanged(&logBlocks[i]);
+
+  return 0;
+}
+
+static int logSetVariableScale(int id, uint8_t index, int8_t scaleExp)
+{
+  int i;
+  struct log_ops * ops;
+
+  for (i=0; i<LOG_MAX_BLOCKS; i++)
+    if (logBlocks[i].id == id) break;
+
+  if (i >= LOG_MAX_BLOCKS) {
+    LOG_ERROR("Trying to scale a variable of block id %d that doesn't exist.\n", id);
+    return ENOENT;
+  }
+
+  if (scaleExp != LOG_SCALE_NONE && (scaleExp < LOG_SCALE_EXP_MIN || scaleExp > LOG_SCALE_EXP_MAX))
+    return EINVAL;
+
+  for (ops = logBlocks[i].ops; ops && index; ops = ops->next)
+    index--;
+
+  if (!ops)
+    return ENOENT;
+
+  bool scaled = (scaleExp != LOG_SCALE_NONE);
+  // Going back to the full size may not fit in the block
+  if (!scaled && ops->scaled && !blockFits(&logBlocks[i], typeLength[ops->logType] - 2, 0)) {
+    return E2BIG;
+  }
+  ops->scaled = scaled;
+  ops->scaleExp = scaled ? scaleExp : 0;
+  blockChanged(&logBlocks[i]);
+
+  return 0;
+}
+
+/* True if block a is due before block b, tick wrap safe */
+static bool blockDueBefore(struct log_block * a, struct log_block * b)
+{
+  return (int32_t)(a->nextDue - b->nextDue) < 0;
+}
+
+static void heapSet(int pos, struct log_block * block)
+{
+  schedHeap[pos] = block;
+  block->heapPos = pos;
+}
+
+static void heapSiftUp(int pos)
+{
+  struct log_block * block = schedHeap[pos];
+
+  while (pos > 0 && blockDueBefore(block, schedHeap[(pos - 1) / 2]))
+  {
+    heapSet(pos, schedHeap[(pos - 1) / 2]);
+    pos = (pos - 1) / 2;
+  }
+  heapSet(pos, block);
+}
+
+static void heapSiftDown(int pos)
+{
+  struct log_block * block = schedHeap[pos];
+
+  while (2 * pos + 1 < schedHeapSize)
+  {
+    int child = 2 * pos + 1;
+    if (child + 1 < schedHeapSize && blockDueBefore(schedHeap[child + 1], schedHeap[child]))
+      child++;
+    if (!blockDueBefore(schedHeap[child], block))
+      break;
+    heapSet(pos, schedHeap[child]);
+    pos = child;
+  }
+  heapSet(pos, block);
+}
+
+static void heapPush(struct log_block * block)
+{
+  heapSet(schedHeapSize++, block);
+  heapSiftUp(block->heapPos);
+}
+
+static void heapRemove(struct log_block * block)
+{
+  int pos = block->heapPos;
+
+  block->heapPos = BLOCK_NOT_SCHEDULED;
+  if (--schedHeapSize == pos)
+    return;
+
+  struct log_block * moved = schedHeap[schedHeapSize];
+  heapSet(pos, moved);
+  heapSiftUp(pos);
+  heapSiftDown(moved->heapPos);
+}
+
+/* Runs the block now, then every period ticks */
+static void blockSchedule(struct log_block * block, TickType_t period)
+{
+  portENTER_CRITICAL(&schedMux);
+  if (block->heapPos != BLOCK_NOT_SCHEDULED)
+    heapRemove(block);
+
+  block->period = period;
+  block->nextDue = xTaskGetTickCount();
+  heapPush(block);
+  portEXIT_CRITICAL(&schedMux);
+
+  xTaskNotifyGive(schedTaskHandle);
+}
+
+static void blockUnschedule(struct log_block * block)
 {
-  workerSchedule(logRunBlock, pvTimerGetTimerID(timer));
+  portENTER_CRITICAL(&schedMux);
+  if (block->heapPos != BLOCK_NOT_SCHEDULED)
+    heapRemove(block);
+  portEXIT_CRITICAL(&schedMux);
+}
+
+/*
+ * Runs the blocks when they are due. A block running late is not run again
+ * to catch up, the skipped periods are counted in schedMissed instead.
+ */
+static void logSchedulerTask(void * prm)
+{
+  while(1)
+  {
+    struct log_block * block = NULL;
+    TickType_t wait = portMAX_DELAY;
+
+    portENTER_CRITICAL(&schedMux);
+    TickType_t now = xTaskGetTickCount();
+    if (schedHeapSize > 0)
+    {
+      int32_t untilDue = (int32_t)(schedHeap[0]->nextDue - now);
+      if (untilDue <= 0)
+      {
+        block = schedHeap[0];
+        heapRemove(block);
+        if (block->period > 0)
+        {
+          block->nextDue += block->period;
+          if ((int32_t)(block->nextDue - now) <= 0)
+          {
+            uint32_t skipped = (now - block->nextDue) / block->period + 1;
+            schedMissed += skipped;
+            block->nextDue += skipped * block->period;
+          }
+          heapPush(block);
+        }
+      }
+      else
+      {
+        wait = untilDue;
+      }
+    }
+    portEXIT_CRITICAL(&schedMux);
+
+    if (block)
+      logRunBlock(block);
+    else
+      ulTaskNotifyTake(pdTRUE, wait);
+  }
 }
 
 /* Appends data to a packet if space is available; returns false on failure. */
 static bool appendToPacket(CRTPPacket * pk, const void * data, size_t n) {
-  if (pk->size <= CRTP_MAX_DATA_SIZE - n)
+  if (pk->size <= crtpGetMaxDataSize() - n)
   {
     memcpy(&pk->data[pk->size], data, n);
     pk->size += n;
@@ -714,26 +1000,60 @@ static bool appendToPacket(CRTPPacket * pk, const void * data, size_t n) {
   else return false;
 }
 
-/* This function is usually called by the worker subsystem */
+/* This function is called by the log scheduler task */
 void logRunBlock(void * arg)
 {
   struct log_block *blk = arg;
-  struct log_ops *ops = blk->ops;
+  struct log_ops *ops;
   static CRTPPacket pk;
   unsigned int timestamp;
+  uint8_t *bitmap = NULL;
+  bool keyframe = false;
+  int index = 0;
+  int count = -1;
+  int id;
 
-  xSemaphoreTake(logLock, portMAX_DELAY);
+  // Enter the read side, the ops are not freed until it is left
+  __atomic_add_fetch(&readEpoch, 1, __ATOMIC_ACQ_REL);
+
+  // The block may have been deleted since the scheduler picked it
+  id = __atomic_load_n(&blk->id, __ATOMIC_ACQUIRE);
+  ops = __atomic_load_n(&blk->ops, __ATOMIC_ACQUIRE);
+  if (id == BLOCK_ID_FREE)
+  {
+    __atomic_add_fetch(&readEpoch, 1, __ATOMIC_RELEASE);
+    return;
+  }
 
-  timestamp = ((long long)xTaskGetTickCount())/portTICK_RATE_MS;
+  uint32_t changes = __atomic_load_n(&blk->changes, __ATOMIC_ACQUIRE);
+  if (changes != blk->runChanges)
+  {
+    blk->runChanges = changes;
+    blk->deltaCount = 0;
+  }
+
+  timestamp = usecTimestamp() / 1000;
 
   pk.header = CRTP_HEADER(CRTP_PORT_LOG, LOG_CH);
   pk.size = 4;
-  pk.data[0] = blk->id;
+  pk.data[0] = id;
   pk.data[1] = timestamp&0x0ff;
   pk.data[2] = (timestamp>>8)&0x0ff;
   pk.data[3] = (timestamp>>16)&0x0ff;
 
-  while (ops)
+  if (blk->mode == LOG_BLOCK_MODE_DELTA)
+  {
+    // Variables appended after this count are left for the next run
+    count = blockCountOps(blk);
+    int bitmapLength = (count + 7) / 8;
+    bitmap = &pk.data[pk.size];
+    memset(bitmap, 0, bitmapLength);
+    pk.size += bitmapLength;
+    keyframe = (blk->deltaCount == 0);
+    blk->deltaCount = (blk->deltaCount + 1) % LOG_DELTA_KEYFRAME_PERIOD;
+  }
+
+  while (ops && index != count)
   {
     int valuei = 0;
     float valuef = 0;
@@ -829,40 +1149,69 @@ void logRunBlock(void * arg)
       }
     }
 
-    if (ops->logType == LOG_FLOAT || ops->logType == LOG_FP16)
+    uint8_t value[4];
+    int length;
+
+    if (ops->storageType != LOG_FLOAT)
     {
-      if (ops->storageType != LOG_FLOAT)
-      {
-        valuef = valuei;
-      }
+      valuef = valuei;
+    }
 
-      // Try to append the next item to the packet.  If we run out of space,
-      // drop this and subsequent items.
-      if (ops->logType == LOG_FLOAT)
-      {
-        if (!appendToPacket(&pk, &valuef, 4)) break;
-      }
-      else
-      {
-        valuei = single2half(valuef);
-        if (!appendToPacket(&pk, &valuei, 2)) break;
-      }
+    if (ops->scaled)
+    {
+      // Quantized to int16 with the variable's decimal scale
+      int16_t v = constrain(valuef * scaleFactors[ops->scaleExp - LOG_SCALE_EXP_MIN], INT16_MIN, INT16_MAX);
+      memcpy(value, &v, 2);
+      length = 2;
+    }
+    else if (ops->logType == LOG_FLOAT)
+    {
+      memcpy(value, &valuef, 4);
+      length = 4;
+    }
+    else if (ops->logType == LOG_FP16)
+    {
+      valuei = single2half(valuef);
+      memcpy(value, &valuei, 2);
+      length = 2;
     }
     else  //logType is an integer
     {
-      if (!appendToPacket(&pk, &valuei, typeLength[ops->logType])) break;
+      length = typeLength[ops->logType];
+      memcpy(value, &valuei, length);
     }
 
-    ops = ops->next;
+    bool send = true;
+    if (bitmap)
+    {
+      send = keyframe || memcmp(&ops->last, value, length) != 0;
+      if (send)
+      {
+        memcpy(&ops->last, value, length);
+        bitmap[index / 8] |= 1 << (index % 8);
+      }
+    }
+
+    // Try to append the next item to the packet.  If we run out of space,
+    // drop this and subsequent items.
+    if (send && !appendToPacket(&pk, value, length)) break;
+
+    ops = __atomic_load_n(&ops->next, __ATOMIC_ACQUIRE);
+    index++;
   }
 
-  xSemaphoreGive(logLock);
+  __atomic_add_fetch(&readEpoch, 1, __ATOMIC_RELEASE);
 
+  if (blk->record)
+  {
+    // Recording goes on without the link
+    logRecordAppend(pk.data, pk.size);
+  }
   // Check if the connection is still up, oherwise disable
-  // all the logging and flush all the CRTP queues.
-  if (!crtpIsConnected())
+  // all the streamed logging and flush all the CRTP queues.
+  else if (!crtpIsConnected())
   {
-    logReset();
+    logResetStreaming();
     crtpReset();
   }
   else
@@ -871,25 +1220,63 @@ void logRunBlock(void * arg)
   }
 }
 
-static int variableGetIndex(int id)
+static uint32_t tocHash(const char * group, const char * name)
+{
+  // FNV-1a of "group.name"
+  uint32_t hash = 2166136261u;
+
+  for (; *group; group++)
+    hash = (hash ^ (uint8_t)*group) * 16777619u;
+  hash = (hash ^ '.') * 16777619u;
+  for (; *name; name++)
+    hash = (hash ^ (uint8_t)*name) * 16777619u;
+
+  return hash;
+}
+
+static void logBuildIndex(void)
 {
   int i;
-  int n=0;
+  uint16_t id = 0;
+  uint16_t group = TOC_NO_ENTRY;
+  int hashSize = 1;
+
+  // At most half full, so probe sequences stay short
+  while (hashSize < 2 * logsCount)
+    hashSize <<= 1;
+
+  logsIdIndex = malloc(logsCount * sizeof(uint16_t));
+  logsGroupIndex = malloc(logsLen * sizeof(uint16_t));
+  logsHash = malloc(hashSize * sizeof(uint16_t));
+  ASSERT(logsIdIndex && logsGroupIndex && logsHash);
+  logsHashMask = hashSize - 1;
+  memset(logsHash, 0xff, hashSize * sizeof(uint16_t));
 
   for (i=0; i<logsLen; i++)
   {
-    if(!(logs[i].type & LOG_GROUP))
+    if (logs[i].type & LOG_GROUP)
     {
-      if(n==id)
-        break;
-      n++;
+      if (logs[i].type & LOG_START)
+        group = i;
+    }
+    else
+    {
+      uint32_t slot = tocHash(group != TOC_NO_ENTRY ? logs[group].name : "", logs[i].name) & logsHashMask;
+      while (logsHash[slot] != TOC_NO_ENTRY)
+        slot = (slot + 1) & logsHashMask;
+      logsHash[slot] = id;
+      logsIdIndex[id++] = i;
     }
+    logsGroupIndex[i] = group;
   }
+}
 
-  if (i>=logsLen)
+static int variableGetIndex(int id)
+{
+  if (id < 0 || id >= logsCount)
     return -1;
 
-  return i;
+  return logsIdIndex[id];
 }
 
 static struct log_ops * opsMalloc()
@@ -902,6 +1289,8 @@ static struct log_ops * opsMalloc()
   if (i >= LOG_MAX_OPS)
       return NULL;
 
+  logOps[i].scaled = false;
+  logOps[i].last = 0;
   return &logOps[i];
 }
 
@@ -916,25 +1305,71 @@ static int blockCalcLength(struct log_block * block)
   int len = 0;
 
   for (ops = block->ops; ops; ops = ops->next)
-    len += typeLength[ops->logType];
+    len += ops->scaled ? 2 : typeLength[ops->logType];
 
   return len;
 }
 
+static int blockCountOps(struct log_block * block)
+{
+  struct log_ops * ops;
+  int count = 0;
+
+  for (ops = __atomic_load_n(&block->ops, __ATOMIC_ACQUIRE); ops;
+       ops = __atomic_load_n(&ops->next, __ATOMIC_ACQUIRE))
+    count++;
+
+  return count;
+}
+
+/* Checks that the block still fits in a packet, bitmap included, after
+ * adding extraLength bytes of values and extraOps variables. */
+static bool blockFits(struct log_block * block, int extraLength, int extraOps)
+{
+  int len = blockCalcLength(block) + extraLength;
+
+  if (block->mode == LOG_BLOCK_MODE_DELTA)
+    len += (blockCountOps(block) + extraOps + 7) / 8;
+
+  return len <= LOG_MAX_LEN;
+}
+
 void blockAppendOps(struct log_block * block, struct log_ops * ops)
 {
   struct log_ops * o;
 
   ops->next = NULL;
 
+  // Published only once initialized, logRunBlock may be reading the list
   if (block->ops == NULL)
-    block->ops = ops;
+    __atomic_store_n(&block->ops, ops, __ATOMIC_RELEASE);
   else
   {
     for (o = block->ops; o->next; o = o->next);
 
-    o->next = ops;
+    __atomic_store_n(&o->next, ops, __ATOMIC_RELEASE);
   }
+
+  // The bitmap layout changed, resend everything
+  blockChanged(block);
+}
+
+/* Makes the next run of the block send a keyframe. Called with logLock taken. */
+static void blockChanged(struct log_block * block)
+{
+  __atomic_add_fetch(&block->changes, 1, __ATOMIC_RELEASE);
+}
+
+/* Waits until the block being read, if any, is done. Called with logLock taken. */
+static void logSynchronize(void)
+{
+  uint32_t epoch = __atomic_load_n(&readEpoch, __ATOMIC_ACQUIRE);
+
+  if (!(epoch & 1))
+    return;
+
+  while (__atomic_load_n(&readEpoch, __ATOMIC_ACQUIRE) == epoch)
+    vTaskDelay(1);
 }
 
 static void logReset(void)
@@ -961,24 +1396,40 @@ static void logReset(void)
     logOps[i].variable = NULL;
 }
 
+/* Stop and delete the blocks sent over the link, keeping the recording ones */
+static void logResetStreaming(void)
+{
+  int i;
+
+  xSemaphoreTake(logLock, portMAX_DELAY);
+  for(i=0; i<LOG_MAX_BLOCKS; i++)
+    if (logBlocks[i].id != BLOCK_ID_FREE && !logBlocks[i].record)
+    {
+      logStopBlock(logBlocks[i].id);
+      logDeleteBlock(logBlocks[i].id);
+    }
+  xSemaphoreGive(logLock);
+}
+
 /* Public API to access log TOC from within the copter */
 static logVarId_t invalidVarId = 0xffffu;
 
 logVarId_t logGetVarId(char* group, char* name)
 {
-  int i;
-  logVarId_t varId = invalidVarId;
-  char * currgroup = "";
+  uint32_t slot;
 
-  for(i=0; i<logsLen; i++)
+  if (!logsHash)
+    return invalidVarId;
+
+  slot = tocHash(group, name) & logsHashMask;
+
+  for (; logsHash[slot] != TOC_NO_ENTRY; slot = (slot + 1) & logsHashMask)
   {
-    if (logs[i].type & LOG_GROUP) {
-      if (logs[i].type & LOG_START)
-        currgroup = logs[i].name;
-    } if ((!strcmp(group, currgroup)) && (!strcmp(name, logs[i].name))) {
-      varId = (logVarId_t)i;
-      return varId;
-    }
+    int i = logsIdIndex[logsHash[slot]];
+    uint16_t g = logsGroupIndex[i];
+
+    if (!strcmp(name, logs[i].name) && !strcmp(group, g != TOC_NO_ENTRY ? logs[g].name : ""))
+      return (logVarId_t)i;
   }
 
   return invalidVarId;
@@ -991,22 +1442,13 @@ int logGetType(logVarId_t varid)
 
 void logGetGroupAndName(logVarId_t varid, char** group, char** name)
 {
-  char * currgroup = "";
   *group = 0;
   *name = 0;
 
-  for(int i=0; i<logsLen; i++) {
-    if (logs[i].type & LOG_GROUP) {
-      if (logs[i].type & LOG_START) {
-        currgroup = logs[i].name;
-      }
-    }
-
-    if (i == varid) {
-      *group = currgroup;
-      *name = logs[i].name;
-      break;
-    }
+  if (varid < logsLen) {
+    uint16_t g = logsGroupIndex[varid];
+    *group = (g != TOC_NO_ENTRY) ? logs[g].name : "";
+    *name = logs[varid].name;
   }
 }
 
@@ -1076,3 +1518,7 @@ static acquisitionType_t acquisitionTypeFromLogType(uint8_t logType) {
 
   return acqType_memory;
 }
+
+LOG_GROUP_START(logsched)
+LOG_ADD(LOG_UINT32, missed, &schedMissed)
+LOG_GROUP_STOP(logsched)
@@ -0,0 +1,191 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * ESP-Drone Firmware
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * log_record.c - On-board ring buffer recording log block packets
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "esp_heap_caps.h"
+
+#include "config.h"
+#include "log_record.h"
+#include "mem.h"
+#include "log.h"
+#define DEBUG_MODULE "LOGREC"
+#include "debug_cf.h"
+
+#define LOG_RECORD_BUFFER_SIZE CONFIG_LOG_RECORD_BUFFER_SIZE
+
+static bool isInit = false;
+
+static uint8_t *buffer;
+static uint32_t head;       // Next byte written
+static uint32_t tail;       // First byte of the oldest record
+static uint32_t used;       // Bytes of records stored
+static uint32_t dropped;    // Records overwritten since the last clear
+static xSemaphoreHandle recordLock;
+static StaticSemaphore_t recordLockBuffer;
+
+static uint32_t handleMemGetSize(void) { return LOG_RECORD_HEADER_SIZE + LOG_RECORD_BUFFER_SIZE; }
+static bool handleMemRead(const uint32_t memAddr, const uint8_t readLen, uint8_t* dest);
+static bool handleMemWrite(const uint32_t memAddr, const uint8_t writeLen, const uint8_t* src);
+static const MemoryHandlerDef_t memDef = {
+  .type = MEM_TYPE_LOG_RECORD,
+  .getSize = handleMemGetSize,
+  .read = handleMemRead,
+  .write = handleMemWrite,
+};
+
+void logRecordInit(void)
+{
+  if (isInit) {
+    return;
+  }
+
+#ifdef CONFIG_SPIRAM
+  buffer = heap_caps_malloc(LOG_RECORD_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+#endif
+  if (buffer == NULL) {
+    buffer = heap_caps_malloc(LOG_RECORD_BUFFER_SIZE, MALLOC_CAP_8BIT);
+  }
+  if (buffer == NULL) {
+    DEBUG_PRINT("Failed to allocate %d bytes, recording disabled\n", LOG_RECORD_BUFFER_SIZE);
+    return;
+  }
+
+  recordLock = xSemaphoreCreateMutexStatic(&recordLockBuffer);
+  memoryRegisterHandler(&memDef);
+
+  isInit = true;
+}
+
+bool logRecordTest(void)
+{
+  return isInit;
+}
+
+static void ringWrite(const uint8_t *data, uint32_t size)
+{
+  uint32_t first = LOG_RECORD_BUFFER_SIZE - head;
+  if (first > size) {
+    first = size;
+  }
+  memcpy(&buffer[head], data, first);
+  memcpy(buffer, &data[first], size - first);
+  head = (head + size) % LOG_RECORD_BUFFER_SIZE;
+}
+
+static void ringRead(uint32_t offset, uint8_t *dest, uint32_t size)
+{
+  uint32_t start = (tail + offset) % LOG_RECORD_BUFFER_SIZE;
+  uint32_t first = LOG_RECORD_BUFFER_SIZE - start;
+  if (first > size) {
+    first = size;
+  }
+  memcpy(dest, &buffer[start], first);
+  memcpy(&dest[first], buffer, size - first);
+}
+
+void logRecordAppend(const uint8_t *data, uint8_t size)
+{
+  if (!isInit || size + 1 > LOG_RECORD_BUFFER_SIZE) {
+    return;
+  }
+
+  xSemaphoreTake(recordLock, portMAX_DELAY);
+  // Make room by dropping the oldest records
+  while (LOG_RECORD_BUFFER_SIZE - used < size + 1) {
+    uint32_t oldest = buffer[tail] + 1;
+    tail = (tail + oldest) % LOG_RECORD_BUFFER_SIZE;
+    used -= oldest;
+    dropped++;
+  }
+  ringWrite(&size, 1);
+  ringWrite(data, size);
+  used += size + 1;
+  xSemaphoreGive(recordLock);
+}
+
+void logRecordClear(void)
+{
+  if (!isInit) {
+    return;
+  }
+
+  xSemaphoreTake(recordLock, portMAX_DELAY);
+  head = tail = used = dropped = 0;
+  xSemaphoreGive(recordLock);
+}
+
+static bool handleMemRead(const uint32_t memAddr, const uint8_t readLen, uint8_t* dest)
+{
+  uint8_t header[LOG_RECORD_HEADER_SIZE] = {'L', 'R', LOG_RECORD_VERSION, 0};
+  uint32_t capacity = LOG_RECORD_BUFFER_SIZE;
+  uint32_t addr = memAddr;
+  uint8_t len = readLen;
+
+  if (memAddr + readLen > handleMemGetSize()) {
+    return false;
+  }
+
+  xSemaphoreTake(recordLock, portMAX_DELAY);
+  if (addr < LOG_RECORD_HEADER_SIZE) {
+    memcpy(&header[4], &used, 4);
+    memcpy(&header[8], &dropped, 4);
+    memcpy(&header[12], &capacity, 4);
+
+    uint8_t n = LOG_RECORD_HEADER_SIZE - addr;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(dest, &header[addr], n);
+    dest += n;
+    addr += n;
+    len -= n;
+  }
+  if (len > 0) {
+    // Reads past the stored records return zeros
+    uint32_t offset = addr - LOG_RECORD_HEADER_SIZE;
+    uint32_t valid = (offset < used) ? used - offset : 0;
+    if (valid > len) {
+      valid = len;
+    }
+    ringRead(offset, dest, valid);
+    memset(&dest[valid], 0, len - valid);
+  }
+  xSemaphoreGive(recordLock);
+
+  return true;
+}
+
+static bool handleMemWrite(const uint32_t memAddr, const uint8_t writeLen, const uint8_t* src)
+{
+  logRecordClear();
+  return true;
+}
+
+LOG_GROUP_START(logrec)
+LOG_ADD(LOG_UINT32, used, &used)
+LOG_ADD(LOG_UINT32, dropped, &dropped)
+LOG_GROUP_STOP(logrec)
@@ -62,12 +62,56 @@
 #define MEM_SETTINGS_CH     0
 #define MEM_READ_CH         1
 #define MEM_WRITE_CH        2
+#define MEM_BULK_CH         3
 
 #define MEM_CMD_GET_NBR     1
 #define MEM_CMD_GET_INFO    2
 
 #define STATUS_OK 0
 
+/*
+ * Bulk reads, on MEM_BULK_CH. The client requests a range and the chunks of
+ * the range are streamed with sequence numbers, at most a window of them not
+ * acknowledged. The client acknowledges the chunks received in order and
+ * NACKs the gaps, only the NACKed chunks are sent again.
+ *
+ * START  client: [cmd, memId, address(4), length(4), window, (flags)]
+ *        reply:  [cmd, memId, status, chunk length, chunk count(2), chunk length(2), flags]
+ * DATA   reply:  [cmd, seq(2), data], chunk seq starts at address + seq * chunk length
+ * ACK    client: [cmd, seq(2)], all the chunks before seq were received
+ * NACK   client: [cmd, seq(2)], chunk seq is missing
+ * STOP   client: [cmd], aborts the transfer
+ *        reply:  [cmd, status], the transfer was aborted on an error
+ *
+ * The transfer ends when all the chunks are acknowledged. Without an ACK or
+ * NACK for MEM_BULK_TIMEOUT_MS the oldest chunk not acknowledged is sent
+ * again, and the transfer is aborted after MEM_BULK_RETRIES of those.
+ *
+ * With MEM_BULK_FLAG_LINK_MTU, on a link with bulk packets (see
+ * crtpGetMaxBulkSize), the DATA chunks are sent as bulk packets sized to the
+ * link MTU instead of CRTP packets, e.g. over 1 KB UDP datagrams on Wi-Fi.
+ * The reply flags tell whether the client got them, the chunk length byte
+ * then only holds the low byte of the 16-bit chunk length.
+ */
+#define MEM_BULK_CMD_START  0
+#define MEM_BULK_CMD_DATA   1
+#define MEM_BULK_CMD_ACK    2
+#define MEM_BULK_CMD_NACK   3
+#define MEM_BULK_CMD_STOP   4
+
+#define MEM_BULK_FLAG_LINK_MTU  0x01
+
+#define MEM_BULK_HEADER_LEN 3
+// Largest chunk of a bulk packet
+#define MEM_BULK_MAX_CHUNK_LEN 1024
+// Largest memory handler read
+#define MEM_READ_MAX_LEN    UINT8_MAX
+#define MEM_BULK_MAX_WINDOW 32
+#define MEM_BULK_TIMEOUT_MS 500
+#define MEM_BULK_RETRIES    4
+// Receive wait when no chunk can be sent, to check the timeout
+#define MEM_BULK_POLL_MS    10
+
 #define MEM_TESTER_SIZE            0x1000
 
 //Private functions
@@ -75,6 +119,10 @@ static void memTask(void * prm);
 static void memSettingsProcess(CRTPPacket* p);
 static void memWriteProcess(CRTPPacket* p);
 static void memReadProcess(CRTPPacket* p);
+static void memBulkProcess(CRTPPacket* p);
+static bool memBulkCanSend(void);
+static void memBulkRun(void);
+static bool memRead(uint8_t memId, uint32_t memAddr, uint8_t readLen, uint8_t* buffer);
 static void createNbrResponse(CRTPPacket* p);
 static void createInfoResponse(CRTPPacket* p, uint8_t memId);
 static void createInfoResponseBody(CRTPPacket* p, uint8_t type, uint32_t memSize, const uint8_t data[8]);
@@ -103,6 +151,29 @@ static const MemoryHandlerDef_t* handlers[MAX_NR_HANDLERS];
 static uint8_t nrOfHandlers = 0;
 static const MemoryOwHandlerDef_t* owMemHandler = 0;
 
+typedef struct {
+  bool active;
+  uint8_t memId;
+  uint32_t address;
+  uint32_t length;
+  uint16_t chunkLength;
+  bool linkMtu;
+  uint8_t window;
+  uint16_t chunkCount;
+  // Chunks before acked are received, chunks from next on were never sent
+  uint16_t acked;
+  uint16_t next;
+  // NACKed chunks to send again, bit n is chunk acked + n
+  uint32_t resend;
+  uint8_t retries;
+  bool sendFailed;
+  TickType_t lastProgress;
+} memBulk_t;
+
+static memBulk_t bulk;
+static CRTPPacket bulkPacket;
+static uint8_t bulkData[MEM_BULK_HEADER_LEN + MEM_BULK_MAX_CHUNK_LEN];
+
 STATIC_MEM_TASK_ALLOC(memTask, MEM_TASK_STACKSIZE);
 
 void memInit(void)
@@ -114,7 +185,7 @@ void memInit(void)
   memoryRegisterHandler(&memTesterDef);
 
   //Start the mem task
-  STATIC_MEM_TASK_CREATE(memTask, memTask, MEM_TASK_NAME, NULL, MEM_TASK_PRI);
+  STATIC_MEM_TASK_CREATE_PINNED(memTask, memTask, MEM_TASK_NAME, NULL, MEM_TASK_PRI, MEM_TASK_CORE);
 
   isInit = true;
 }
@@ -160,7 +231,17 @@ static void memTask(void* param) {
   registrationEnabled = false;
 
 	while(1) {
-		crtpReceivePacketBlock(CRTP_PORT_MEM, &packet);
+    if (bulk.active) {
+      // Stream the chunks while serving the requests
+      int wait = memBulkCanSend() ? 0 : MEM_BULK_POLL_MS;
+      bool received = (crtpReceivePacketWait(CRTP_PORT_MEM, &packet, wait) == pdTRUE);
+      if (!received) {
+        memBulkRun();
+        continue;
+      }
+    } else {
+      crtpReceivePacketBlock(CRTP_PORT_MEM, &packet);
+    }
 
 		switch (packet.channel) {
       case MEM_SETTINGS_CH:
@@ -172,6 +253,9 @@ static void memTask(void* param) {
       case MEM_WRITE_CH:
         memWriteProcess(&packet);
         break;
+      case MEM_BULK_CH:
+        memBulkProcess(&packet);
+        break;
       default:
         // Do nothing
         break;
@@ -250,13 +334,11 @@ static void memReadProcess(CRTPPacket* p) {
   uint8_t readLen = p->data[5];
   uint8_t* startOfData = &p->data[6];
 
-  if (memId < nrOfHandlers) {
-    if (handlers[memId]->read) {
-      result = handlers[memId]->read(memAddr, readLen, startOfData);
-    }
+  // Jumbo packets let the client read up to the negotiated size at once
+  if (readLen > crtpGetMaxDataSize() - 6) {
+    MEM_ERROR("Read of %d bytes does not fit in a packet\n", readLen);
   } else {
-    uint8_t selectedMem = memId - nrOfHandlers;
-    result = owMemHandler->read(selectedMem, memAddr, readLen, startOfData);
+    result = memRead(memId, memAddr, readLen, startOfData);
   }
 
   p->data[5] = result ? STATUS_OK : EIO;
@@ -269,6 +351,230 @@ static void memReadProcess(CRTPPacket* p) {
   crtpSendPacket(p);
 }
 
+static bool memRead(uint8_t memId, uint32_t memAddr, uint8_t readLen, uint8_t* buffer) {
+  if (memId < nrOfHandlers) {
+    if (handlers[memId]->read) {
+      return handlers[memId]->read(memAddr, readLen, buffer);
+    }
+    return false;
+  } else if (owMemHandler) {
+    uint8_t selectedMem = memId - nrOfHandlers;
+    return owMemHandler->read(selectedMem, memAddr, readLen, buffer);
+  }
+
+  return false;
+}
+
+static void memBulkStart(CRTPPacket* p) {
+  uint32_t memAddr;
+  uint32_t length;
+  uint8_t status = STATUS_OK;
+
+  uint8_t memId = p->data[1];
+  memcpy(&memAddr, &p->data[2], 4);
+  memcpy(&length, &p->data[6], 4);
+  uint8_t window = p->data[10];
+  uint8_t flags = p->size >= 12 ? p->data[11] : 0;
+
+  // A new request replaces the transfer in progress
+  bulk.active = false;
+
+  // Bulk packets only pay off when they carry more than a CRTP packet
+  uint16_t chunkLength = crtpGetMaxDataSize() - MEM_BULK_HEADER_LEN;
+  uint16_t bulkSize = crtpGetMaxBulkSize();
+  bool linkMtu = (flags & MEM_BULK_FLAG_LINK_MTU) && bulkSize > crtpGetMaxDataSize();
+  if (linkMtu) {
+    chunkLength = bulkSize - MEM_BULK_HEADER_LEN;
+    if (chunkLength > MEM_BULK_MAX_CHUNK_LEN) {
+      chunkLength = MEM_BULK_MAX_CHUNK_LEN;
+    }
+  }
+  uint32_t chunkCount = (length + chunkLength - 1) / chunkLength;
+
+  if (p->size < 11 || length == 0 || window == 0 || chunkCount > UINT16_MAX) {
+    status = EINVAL;
+  } else if (memId >= nrOfHandlers + (owMemHandler ? nbrOwMems : 0) ||
+             (memId < nrOfHandlers && !handlers[memId]->read)) {
+    status = ENODEV;
+  } else {
+    bulk.memId = memId;
+    bulk.address = memAddr;
+    bulk.length = length;
+    bulk.chunkLength = chunkLength;
+    bulk.linkMtu = linkMtu;
+    bulk.window = window < MEM_BULK_MAX_WINDOW ? window : MEM_BULK_MAX_WINDOW;
+    bulk.chunkCount = chunkCount;
+    bulk.acked = 0;
+    bulk.next = 0;
+    bulk.resend = 0;
+    bulk.retries = 0;
+    bulk.sendFailed = false;
+    bulk.lastProgress = xTaskGetTickCount();
+    bulk.active = true;
+  }
+
+  p->header = CRTP_HEADER(CRTP_PORT_MEM, MEM_BULK_CH);
+  p->data[0] = MEM_BULK_CMD_START;
+  p->data[1] = memId;
+  p->data[2] = status;
+  p->data[3] = chunkLength & 0xff;
+  p->data[4] = bulk.active ? chunkCount & 0xff : 0;
+  p->data[5] = bulk.active ? chunkCount >> 8 : 0;
+  p->data[6] = chunkLength & 0xff;
+  p->data[7] = chunkLength >> 8;
+  p->data[8] = linkMtu ? MEM_BULK_FLAG_LINK_MTU : 0;
+  p->size = 9;
+  crtpSendPacket(p);
+}
+
+static void memBulkAck(uint16_t seq) {
+  if (seq <= bulk.acked || seq > bulk.next) {
+    return;
+  }
+
+  uint16_t count = seq - bulk.acked;
+  bulk.resend = count < 32 ? bulk.resend >> count : 0;
+  bulk.acked = seq;
+  bulk.retries = 0;
+  bulk.lastProgress = xTaskGetTickCount();
+
+  if (bulk.acked == bulk.chunkCount) {
+    bulk.active = false;
+  }
+}
+
+static void memBulkNack(uint16_t seq) {
+  if (seq < bulk.acked || seq >= bulk.next) {
+    return;
+  }
+
+  bulk.resend |= 1u << (seq - bulk.acked);
+  bulk.retries = 0;
+  bulk.lastProgress = xTaskGetTickCount();
+}
+
+static void memBulkProcess(CRTPPacket* p) {
+  uint16_t seq = p->data[1] | (p->data[2] << 8);
+
+  switch (p->data[0]) {
+    case MEM_BULK_CMD_START:
+      memBulkStart(p);
+      break;
+    case MEM_BULK_CMD_ACK:
+      if (bulk.active && p->size >= 3) {
+        memBulkAck(seq);
+      }
+      break;
+    case MEM_BULK_CMD_NACK:
+      if (bulk.active && p->size >= 3) {
+        memBulkNack(seq);
+      }
+      break;
+    case MEM_BULK_CMD_STOP:
+      bulk.active = false;
+      break;
+    default:
+      // Do nothing
+      break;
+  }
+}
+
+static bool memBulkCanSend(void) {
+  if (bulk.sendFailed) {
+    return false;
+  }
+  return bulk.resend != 0 ||
+         (bulk.next < bulk.chunkCount && bulk.next - bulk.acked < bulk.window);
+}
+
+static void memBulkAbort(uint8_t status) {
+  bulk.active = false;
+
+  bulkPacket.header = CRTP_HEADER(CRTP_PORT_MEM, MEM_BULK_CH);
+  bulkPacket.data[0] = MEM_BULK_CMD_STOP;
+  bulkPacket.data[1] = status;
+  bulkPacket.size = 2;
+  crtpSendPacket(&bulkPacket);
+}
+
+// Reads a chunk in as many memory handler reads as it takes.
+static bool memBulkRead(uint32_t memAddr, uint16_t length, uint8_t* buffer) {
+  while (length > 0) {
+    uint8_t readLen = length < MEM_READ_MAX_LEN ? length : MEM_READ_MAX_LEN;
+    if (!memRead(bulk.memId, memAddr, readLen, buffer)) {
+      return false;
+    }
+    memAddr += readLen;
+    buffer += readLen;
+    length -= readLen;
+  }
+  return true;
+}
+
+static bool memBulkSend(uint16_t seq, uint32_t offset, uint16_t length) {
+  uint8_t* chunk = bulk.linkMtu ? bulkData : bulkPacket.data;
+  chunk[0] = MEM_BULK_CMD_DATA;
+  chunk[1] = seq & 0xff;
+  chunk[2] = seq >> 8;
+  if (!memBulkRead(bulk.address + offset, length, &chunk[MEM_BULK_HEADER_LEN])) {
+    memBulkAbort(EIO);
+    return false;
+  }
+
+  if (bulk.linkMtu) {
+    return crtpSendBulkPacket(CRTP_HEADER(CRTP_PORT_MEM, MEM_BULK_CH), bulkData, MEM_BULK_HEADER_LEN + length);
+  }
+  bulkPacket.header = CRTP_HEADER(CRTP_PORT_MEM, MEM_BULK_CH);
+  bulkPacket.size = MEM_BULK_HEADER_LEN + length;
+  return crtpSendPacket(&bulkPacket) == pdTRUE;
+}
+
+static void memBulkRun(void) {
+  uint16_t seq;
+
+  // The negotiated packet size can go back to the legacy one on a link change
+  uint16_t maxSize = bulk.linkMtu ? crtpGetMaxBulkSize() : crtpGetMaxDataSize();
+  if (maxSize < bulk.chunkLength + MEM_BULK_HEADER_LEN) {
+    memBulkAbort(EMSGSIZE);
+    return;
+  }
+
+  bulk.sendFailed = false;
+  if (bulk.resend != 0) {
+    seq = bulk.acked + __builtin_ctz(bulk.resend);
+  } else if (bulk.next < bulk.chunkCount && bulk.next - bulk.acked < bulk.window) {
+    seq = bulk.next;
+  } else {
+    // Nothing received for a while, the last chunks or their ACK may be lost
+    if (xTaskGetTickCount() - bulk.lastProgress > M2T(MEM_BULK_TIMEOUT_MS)) {
+      if (++bulk.retries > MEM_BULK_RETRIES) {
+        memBulkAbort(ETIMEDOUT);
+        return;
+      }
+      bulk.resend = 1;
+      bulk.lastProgress = xTaskGetTickCount();
+    }
+    return;
+  }
+
+  uint32_t offset = (uint32_t)seq * bulk.chunkLength;
+  uint16_t readLen = bulk.length - offset < bulk.chunkLength ? bulk.length - offset : bulk.chunkLength;
+
+  // With the TX queue full, wait for the next poll instead of spinning
+  if (!memBulkSend(seq, offset, readLen)) {
+    if (bulk.active) {
+      bulk.sendFailed = true;
+    }
+    return;
+  }
+
+  if (seq == bulk.next) {
+    bulk.next++;
+  } else {
+    bulk.resend &= ~(1u << (seq - bulk.acked));
+  }
+}
+
 static void memWriteProcess(CRTPPacket* p) {
   uint32_t memAddr;
   bool result = false;
@@ -21,81 +21,65 @@
  * You should have received a copy of the GNU General Public License
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  *
- * outlierFilter.c: Outlier rejection filter for the LPS system
+ * outlierFilter.c: Outlier rejection filters of the kalman filter measurements
  */
 
 #include <math.h>
+#include <string.h>
 #include "outlierFilter.h"
 #include "stabilizer_types.h"
 #include "log.h"
 #include "debug_cf.h"
 
-#define BUCKET_ACCEPTANCE_LEVEL 3
-#define MAX_BUCKET_FILL 10
-#define FILTER_CLOSE_DELAY_COUNT 30
+// Samples accepted without judgement while the window fills
+#define ROBUST_MIN_SAMPLES (OUTLIER_FILTER_WINDOW / 2)
+// Standard deviation of a normal distribution over its MAD
+#define MAD_TO_STD_DEV 1.4826f
 
-static float acceptanceLevel = 0.0;
-static float errorDistance;
-static int filterCloseDelayCounter = 0;
-static int previousFilterIndex = 0;
+#define TDOA_THRESHOLD 3.0f
+#define TDOA_MIN_LEVEL 0.4f
 
-typedef struct {
-  float acceptanceLevel;
-  int bucket;
-} filterLevel_t;
+static const float lhThreshold = 3.0f;
+static const float lhMaxError = 0.05f;
 
-#define FILTER_LEVELS 5
-#define FILTER_NONE FILTER_LEVELS
-filterLevel_t filterLevels[FILTER_LEVELS] = {
-  {.acceptanceLevel = 0.4},
-  {.acceptanceLevel = 0.8},
-  {.acceptanceLevel = 1.2},
-  {.acceptanceLevel = 1.6},
-  {.acceptanceLevel = 2.0},
-};
+static OutlierFilterRobustState_t tdoaFilterState;
+static float errorDistance;
 
 
 static bool isDistanceDiffSmallerThanDistanceBetweenAnchors(const tdoaMeasurement_t* tdoa);
 static float distanceSq(const point_t* a, const point_t* b);
 static float sq(float a) {return a * a;}
-static void addToBucket(filterLevel_t* filter);
-static void removeFromBucket(filterLevel_t* filter);
-static int updateBuckets(float errorDistance);
+static void robustAdd(OutlierFilterRobustState_t* this, const float value);
 
 
 
-bool outlierFilterValidateTdoaSimple(const tdoaMeasurement_t* tdoa) {
-  return isDistanceDiffSmallerThanDistanceBetweenAnchors(tdoa);
+void outlierFilterRobustReset(OutlierFilterRobustState_t* this) {
+  memset(this, 0, sizeof(*this));
 }
 
-bool outlierFilterValidateTdoaSteps(const tdoaMeasurement_t* tdoa, const float error, const vector_t* jacobian, const point_t* estPos) {
-  bool sampleIsGood = false;
-
-  if (isDistanceDiffSmallerThanDistanceBetweenAnchors(tdoa)) {
-    float errorBaseDistance = sqrtf(powf(jacobian->x, 2) + powf(jacobian->y, 2) + powf(jacobian->z, 2));
-    errorDistance = fabsf(error / errorBaseDistance);
-
-    int filterIndex = updateBuckets(errorDistance);
+bool outlierFilterValidateRobust(OutlierFilterRobustState_t* this, const float value, const float threshold, const float minLevel, const bool learn) {
+  // A non finite sample would break the ordering of the window
+  if (!isfinite(value)) {
+    if (learn) {
+      this->rejected++;
+    }
+    return false;
+  }
 
-    if (filterIndex > previousFilterIndex) {
-      filterCloseDelayCounter = FILTER_CLOSE_DELAY_COUNT;
-    } else if (filterIndex < previousFilterIndex) {
-      if (filterCloseDelayCounter > 0) {
-        filterCloseDelayCounter--;
-        filterIndex = previousFilterIndex;
-      }
+  bool sampleIsGood = true;
+  if (this->count >= ROBUST_MIN_SAMPLES) {
+    float level = threshold * MAD_TO_STD_DEV * this->mad;
+    if (level < minLevel) {
+      level = minLevel;
     }
-    previousFilterIndex = filterIndex;
-
-    if (filterIndex == FILTER_NONE) {
-      // Lost tracking, open up to let the kalman filter converge
-      acceptanceLevel = 100.0;
-      sampleIsGood = true;
-    } else {
-      acceptanceLevel = filterLevels[filterIndex].acceptanceLevel;
-      if (errorDistance < acceptanceLevel) {
-        sampleIsGood = true;
-      }
+    this->acceptanceLevel = level;
+    sampleIsGood = (fabsf(value - this->median) < level);
+  }
+
+  if (learn) {
+    robustAdd(this, value);
+    if (!sampleIsGood) {
+      this->rejected++;
     }
   }
 
@@ -103,46 +87,29 @@ bool outlierFilterValidateTdoaSteps(const tdoaMeasurement_t* tdoa, const float e
 }
 
 
-#define LH_TICKS_PER_FRAME (1000 / 120)
-static const int32_t lhMinWindowTime = -2 * LH_TICKS_PER_FRAME;
-static const int32_t lhMaxWindowTime = 5 * LH_TICKS_PER_FRAME;
-static const int32_t lhBadSampleWindowChange = -LH_TICKS_PER_FRAME;
-static const int32_t lhGoodSampleWindowChange = LH_TICKS_PER_FRAME / 2;
-static const float lhMaxError = 0.05f;
+bool outlierFilterValidateTdoaSimple(const tdoaMeasurement_t* tdoa) {
+  return isDistanceDiffSmallerThanDistanceBetweenAnchors(tdoa);
+}
+
+bool outlierFilterValidateTdoaSteps(const tdoaMeasurement_t* tdoa, const float error, const vector_t* jacobian, const point_t* estPos, const bool learn) {
+  if (!isDistanceDiffSmallerThanDistanceBetweenAnchors(tdoa)) {
+    return false;
+  }
 
-void outlierFilterReset(OutlierFilterLhState_t* this, const uint32_t now) {
-  this->openingTime = now;
-  this->openingWindow = lhMinWindowTime;
+  // Error along the gradient of the distance difference, in meters
+  float errorBaseDistance = sqrtf(powf(jacobian->x, 2) + powf(jacobian->y, 2) + powf(jacobian->z, 2));
+  errorDistance = error / errorBaseDistance;
+
+  return outlierFilterValidateRobust(&tdoaFilterState, errorDistance, TDOA_THRESHOLD, TDOA_MIN_LEVEL, learn);
 }
 
 
-bool outlierFilterValidateLighthouseSweep(OutlierFilterLhState_t* this, const float distanceToBs, const float angleError, const uint32_t now) {
+bool outlierFilterValidateLighthouseSweep(OutlierFilterRobustState_t* this, const float distanceToBs, const float angleError, const bool learn) {
   // float error = distanceToBs * tan(angleError);
   // We use an approximattion
   float error = distanceToBs * angleError;
 
-  bool isGoodSample = (fabsf(error) < lhMaxError);
-  if (isGoodSample) {
-    this->openingWindow += lhGoodSampleWindowChange;
-    if (this->openingWindow > lhMaxWindowTime) {
-      this->openingWindow = lhMaxWindowTime;
-    }
-  } else {
-    this->openingWindow += lhBadSampleWindowChange;
-    if (this->openingWindow < lhMinWindowTime) {
-      this->openingWindow = lhMinWindowTime;
-    }
-  }
-
-  bool result = true;
-  bool isFilterClosed = (now < this->openingTime);
-  if (isFilterClosed) {
-    result = isGoodSample;
-  }
-
-  this->openingTime = now + this->openingWindow;
-
-  return result;
+  return outlierFilterValidateRobust(this, error, lhThreshold, lhMaxError, learn);
 }
 
 
@@ -157,44 +124,64 @@ static float distanceSq(const point_t* a, const point_t* b) {
 }
 
 
-static void addToBucket(filterLevel_t* filter) {
-  if (filter->bucket < MAX_BUCKET_FILL) {
-    filter->bucket++;
+// Replace the value old of a sorted window by value, moving the values between them by one
+static void sortedReplace(float* sorted, const int count, const float old, const float value) {
+  int i = 0;
+  while (i < count - 1 && sorted[i] != old) {
+    i++;
   }
+  while (i > 0 && sorted[i - 1] > value) {
+    sorted[i] = sorted[i - 1];
+    i--;
+  }
+  while (i < count - 1 && sorted[i + 1] < value) {
+    sorted[i] = sorted[i + 1];
+    i++;
+  }
+  sorted[i] = value;
 }
 
-static void removeFromBucket(filterLevel_t* filter) {
-  if (filter->bucket > 0) {
-    filter->bucket--;
+static void sortedInsert(float* sorted, const int count, const float value) {
+  int i = count;
+  while (i > 0 && sorted[i - 1] > value) {
+    sorted[i] = sorted[i - 1];
+    i--;
   }
+  sorted[i] = value;
 }
 
-static int updateBuckets(float errorDistance) {
-  int filterIndex = FILTER_NONE;
-
-  for (int i = FILTER_LEVELS - 1; i >= 0; i--) {
-    filterLevel_t* filter = &filterLevels[i];
+static float sortedMedian(const float* sorted, const int count) {
+  if (count % 2) {
+    return sorted[count / 2];
+  }
+  return 0.5f * (sorted[count / 2 - 1] + sorted[count / 2]);
+}
 
-    if (errorDistance < filter->acceptanceLevel) {
-      removeFromBucket(filter);
-    } else {
-      addToBucket(filter);
-    }
+// The deviation of each sample is taken from the median at its arrival, so the
+// MAD is kept up to date without going through the window again
+static void robustAdd(OutlierFilterRobustState_t* this, const float value) {
+  float deviation = (this->count > 0) ? fabsf(value - this->median) : 0.0f;
 
-    if (filter->bucket < BUCKET_ACCEPTANCE_LEVEL) {
-      filterIndex = i;
-    }
+  if (this->count < OUTLIER_FILTER_WINDOW) {
+    sortedInsert(this->sortedSamples, this->count, value);
+    sortedInsert(this->sortedDeviations, this->count, deviation);
+    this->count++;
+  } else {
+    sortedReplace(this->sortedSamples, this->count, this->samples[this->next], value);
+    sortedReplace(this->sortedDeviations, this->count, this->deviations[this->next], deviation);
   }
+  this->samples[this->next] = value;
+  this->deviations[this->next] = deviation;
+  this->next = (this->next + 1) % OUTLIER_FILTER_WINDOW;
 
-  return filterIndex;
+  this->median = sortedMedian(this->sortedSamples, this->count);
+  this->mad = sortedMedian(this->sortedDeviations, this->count);
 }
 
 LOG_GROUP_START(outlierf)
-  LOG_ADD(LOG_INT32, bucket0, &filterLevels[0].bucket)
-  LOG_ADD(LOG_INT32, bucket1, &filterLevels[1].bucket)
-  LOG_ADD(LOG_INT32, bucket2, &filterLevels[2].bucket)
-  LOG_ADD(LOG_INT32, bucket3, &filterLevels[3].bucket)
-  LOG_ADD(LOG_INT32, bucket4, &filterLevels[4].bucket)
-  LOG_ADD(LOG_FLOAT, accLev, &acceptanceLevel)
+  LOG_ADD(LOG_FLOAT, accLev, &tdoaFilterState.acceptanceLevel)
   LOG_ADD(LOG_FLOAT, errD, &errorDistance)
+  LOG_ADD(LOG_FLOAT, errMed, &tdoaFilterState.median)
+  LOG_ADD(LOG_FLOAT, errMad, &tdoaFilterState.mad)
+  LOG_ADD(LOG_UINT32, tdoaRej, &tdoaFilterState.rejected)
 LOG_GROUP_STOP(outlierf)
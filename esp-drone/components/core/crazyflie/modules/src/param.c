@@ -24,6 +24,8 @@
  * param.h - Crazy parameter system source file.
  */
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 
 /* FreeRtos includes */
@@ -35,6 +37,7 @@
 #include "param.h"
 #include "crc.h"
 #include "console.h"
+#include "storage.h"
 #define DEBUG_MODULE "PARAM"
 #include "debug_cf.h"
 #include "stm32_legacy.h"
@@ -71,9 +74,24 @@ static const uint8_t typeLength[] = {
 #define CMD_GET_INFO    1 // original version: up to 255 entries
 #define CMD_GET_ITEM_V2 2 // version 2: up to 16k entries
 #define CMD_GET_INFO_V2 3 // version 2: up to 16k entries
+#define CMD_GET_ITEMS_V2 4 // version 2: as many consecutive entries as fit in a packet
 
 #define MISC_SETBYNAME 0
 #define MISC_VALUE_UPDATED 1
+#define MISC_BATCH_WRITE 2
+#define MISC_BATCH_READ 3
+#define MISC_PERSISTENT_SAVE_CHANGED 4
+#define MISC_PERSISTENT_CLEAR 5
+
+// Persistent params are stored under "prm/group.name"
+#define PERSISTENT_PREFIX "prm/"
+#define PERSISTENT_KEY_MAX 64
+
+// Batch write flags. The entries of a transaction are staged until the
+// packet flagged COMMIT, then applied at once, or not at all on error.
+#define BATCH_BEGIN  0x01
+#define BATCH_COMMIT 0x02
+#define PARAM_BATCH_MAX 48
 
 //Private functions
 static void paramTask(void * prm);
@@ -88,19 +106,44 @@ extern struct param_s _param_end;
 static void paramWriteProcess();
 static void paramReadProcess();
 static int variableGetIndex(int id);
+static void paramBuildIndex(void);
 static char paramWriteByNameProcess(char* group, char* name, int type, void *valptr);
+static void paramBatchWriteProcess();
+static void paramBatchReadProcess();
+static void paramPersistentLoad(void);
+static int paramPersistentSaveChanged(void);
+static int paramPersistentClear(void);
 
 //Pointer to the parameters list and length of it
 static struct param_s * params;
 static int paramsLen;
 static uint32_t paramsCrc;
 static uint16_t paramsCount = 0;
+
+// TOC lookup tables, built at init
+#define TOC_NO_ENTRY 0xffffu
+static uint16_t * paramsIdIndex;     // TOC id -> params index
+static uint16_t * paramsGroupIndex;  // params index -> index of its group start, TOC_NO_ENTRY if none
+static uint16_t * paramsHash;        // hash of group and name -> TOC id, open addressing
+static uint16_t paramsHashMask;
+static uint64_t * paramsDefault;     // TOC id -> compiled default value
 // indicates if read/write operation use V2 (i.e., 16-bit index)
 // This is set to true, if a client uses TOC_CH in V2
 static bool useV2 = false;
 
 static CRTPPacket p;
 
+// Staged batch write transaction
+static struct {
+  uint16_t index;
+  uint8_t value[8];
+} batch[PARAM_BATCH_MAX];
+static uint8_t batchCount = 0;
+static uint8_t batchTxId = 0;
+// Batches are applied and read without preemption, so the stabilizer
+// never runs between two values of the same batch on its core
+static portMUX_TYPE batchMux = portMUX_INITIALIZER_UNLOCKED;
+
 static bool isInit = false;
 
 STATIC_MEM_TASK_ALLOC_STACK_NO_DMA_CCM_SAFE(paramTask, PARAM_TASK_STACKSIZE);
@@ -151,9 +194,12 @@ void paramInit(void)
       paramsCount++;
   }
 
+  paramBuildIndex();
+  paramPersistentLoad();
+
 
   //Start the param task
-  STATIC_MEM_TASK_CREATE(paramTask, paramTask, PARAM_TASK_NAME, NULL, PARAM_TASK_PRI);
+  STATIC_MEM_TASK_CREATE_PINNED(paramTask, paramTask, PARAM_TASK_NAME, NULL, PARAM_TASK_PRI, PARAM_TASK_CORE);
 
   //TODO: Handle stored parameters!
 
@@ -205,6 +251,21 @@ void paramTask(void * prm)
         p.data[1+strlen(group)+1+strlen(name)+1] = error;
         p.size = 1+strlen(group)+1+strlen(name)+1+1;
         crtpSendPacket(&p);
+      } else if (p.data[0] == MISC_BATCH_WRITE) {
+        paramBatchWriteProcess();
+      } else if (p.data[0] == MISC_BATCH_READ) {
+        paramBatchReadProcess();
+      } else if (p.data[0] == MISC_PERSISTENT_SAVE_CHANGED) {
+        // Answer: cmd, error, number of params saved
+        int saved = paramPersistentSaveChanged();
+        p.data[1] = saved < 0 ? EIO : 0;
+        p.data[2] = saved < 0 ? 0 : saved;
+        p.size = 3;
+        crtpSendPacket(&p);
+      } else if (p.data[0] == MISC_PERSISTENT_CLEAR) {
+        p.data[1] = paramPersistentClear() < 0 ? EIO : 0;
+        p.size = 2;
+        crtpSendPacket(&p);
       }
     }
 	}
@@ -318,6 +379,46 @@ void paramTOCProcess(int command)
       crtpSendPacket(&p);
     }
     break;
+  case CMD_GET_ITEMS_V2:  //Get consecutive param variables, mostly useful with jumbo packets
+  {
+    uint8_t count = 0;
+    int maxSize = crtpGetMaxDataSize();
+
+    memcpy(&paramId, &p.data[1], 2);
+    p.header=CRTP_HEADER(CRTP_PORT_PARAM, TOC_CH);
+    p.data[0]=CMD_GET_ITEMS_V2;
+    p.size=4;
+    for (ptr=0; ptr<paramsLen; ptr++) //Ptr points a group
+    {
+      if (params[ptr].type & PARAM_GROUP)
+      {
+        if (params[ptr].type & PARAM_START)
+          group = params[ptr].name;
+        else
+          group = "";
+      }
+      else                          //Ptr points a variable
+      {
+        if (n>=paramId)
+        {
+          int itemSize = 1+2+strlen(group)+strlen(params[ptr].name);
+          if (p.size+itemSize > maxSize)
+            break;
+          p.data[p.size]=params[ptr].type;
+          memcpy(p.data+p.size+1, group, strlen(group)+1);
+          memcpy(p.data+p.size+1+strlen(group)+1, params[ptr].name, strlen(params[ptr].name)+1);
+          p.size+=itemSize;
+          count++;
+        }
+        n++;
+      }
+    }
+    // An empty list tells the client it is past the end of the TOC
+    memcpy(&p.data[1], &paramId, 2);
+    p.data[3]=count;
+    crtpSendPacket(&p);
+    break;
+  }
   }
 }
 
@@ -400,6 +501,212 @@ static void paramWriteProcess()
   }
 }
 
+static uint8_t paramValueSize(int index)
+{
+  return 1 << (params[index].type & PARAM_BYTES_MASK);
+}
+
+/* Packet: cmd, transaction id, flags, then (id: 2 bytes, value) entries with
+ * the value size of each param type.
+ * Answer: cmd, transaction id, error, number of entries staged or applied. */
+static void paramBatchWriteProcess()
+{
+  uint8_t txId = p.data[1];
+  uint8_t flags = p.data[2];
+  int error = 0;
+  int pos = 3;
+
+  if (flags & BATCH_BEGIN) {
+    batchCount = 0;
+    batchTxId = txId;
+  } else if (txId != batchTxId) {
+    // Continuation of a transaction that is not the staged one
+    error = EPROTO;
+  }
+
+  while (!error && pos < p.size) {
+    uint16_t ident;
+    int index;
+
+    if (pos + 2 > p.size) {
+      error = EINVAL;
+      break;
+    }
+    memcpy(&ident, &p.data[pos], 2);
+    index = variableGetIndex(ident);
+    if (index < 0) {
+      error = ENOENT;
+    } else if (params[index].type & PARAM_RONLY) {
+      error = EACCES;
+    } else if (pos + 2 + paramValueSize(index) > p.size) {
+      error = EINVAL;
+    } else if (batchCount >= PARAM_BATCH_MAX) {
+      error = ENOMEM;
+    } else {
+      batch[batchCount].index = index;
+      memcpy(batch[batchCount].value, &p.data[pos + 2], paramValueSize(index));
+      batchCount++;
+      pos += 2 + paramValueSize(index);
+    }
+  }
+
+  if (error) {
+    // All or nothing, drop the whole transaction
+    PARAM_ERROR("Batch %d aborted (%d)\n", txId, error);
+    batchCount = 0;
+  } else if (flags & BATCH_COMMIT) {
+    portENTER_CRITICAL(&batchMux);
+    for (int i = 0; i < batchCount; i++) {
+      memcpy(params[batch[i].index].address, batch[i].value, paramValueSize(batch[i].index));
+    }
+    portEXIT_CRITICAL(&batchMux);
+  }
+
+  p.data[2] = error;
+  p.data[3] = batchCount;
+  p.size = 4;
+  crtpSendPacket(&p);
+
+  if (flags & BATCH_COMMIT) {
+    batchCount = 0;
+  }
+}
+
+/* Packet: cmd, then ids (2 bytes each).
+ * Answer: cmd, error, then the values in the order of the ids, all read
+ * at the same instant. */
+static void paramBatchReadProcess()
+{
+  static uint8_t values[CRTP_MAX_DATA_SIZE];
+  int count = (p.size - 1) / 2;
+  int size = 0;
+  int error = 0;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    uint16_t ident;
+    memcpy(&ident, &p.data[1 + 2 * i], 2);
+    int index = variableGetIndex(ident);
+    if (index < 0) {
+      error = ENOENT;
+      break;
+    }
+    if (2 + size + paramValueSize(index) > crtpGetMaxDataSize()) {
+      error = E2BIG;
+      break;
+    }
+    size += paramValueSize(index);
+  }
+
+  if (!error) {
+    int pos = 0;
+    portENTER_CRITICAL(&batchMux);
+    for (i = 0; i < count; i++) {
+      uint16_t ident;
+      memcpy(&ident, &p.data[1 + 2 * i], 2);
+      int index = variableGetIndex(ident);
+      memcpy(&values[pos], params[index].address, paramValueSize(index));
+      pos += paramValueSize(index);
+    }
+    portEXIT_CRITICAL(&batchMux);
+  }
+
+  p.data[1] = error;
+  if (error) {
+    p.size = 2;
+  } else {
+    memcpy(&p.data[2], values, size);
+    p.size = 2 + size;
+  }
+  crtpSendPacket(&p);
+}
+
+static void paramPersistentKey(int index, char * key)
+{
+  uint16_t g = paramsGroupIndex[index];
+
+  snprintf(key, PERSISTENT_KEY_MAX, PERSISTENT_PREFIX "%s.%s",
+           g != TOC_NO_ENTRY ? params[g].name : "", params[index].name);
+}
+
+/* Keeps the compiled defaults, then applies the values saved with
+ * MISC_PERSISTENT_SAVE_CHANGED. */
+static void paramPersistentLoad(void)
+{
+  char key[PERSISTENT_KEY_MAX];
+  int loaded = 0;
+
+  paramsDefault = calloc(paramsCount, sizeof(uint64_t));
+  ASSERT(paramsDefault);
+
+  for (int id = 0; id < paramsCount; id++) {
+    int index = paramsIdIndex[id];
+    uint8_t size = paramValueSize(index);
+    uint64_t value;
+
+    memcpy(&paramsDefault[id], params[index].address, size);
+    if (params[index].type & PARAM_RONLY)
+      continue;
+
+    paramPersistentKey(index, key);
+    if (storageFetch(key, &value, size) == size) {
+      memcpy(params[index].address, &value, size);
+      loaded++;
+    }
+  }
+
+  if (loaded > 0)
+    DEBUG_PRINT("Loaded %d persistent params\n", loaded);
+}
+
+/* Stores the params that differ from their compiled default and forgets
+ * the others. Returns the number of params stored, -1 on error. */
+static int paramPersistentSaveChanged(void)
+{
+  char key[PERSISTENT_KEY_MAX];
+  int saved = 0;
+  bool ok = true;
+
+  storageBatchBegin();
+  for (int id = 0; id < paramsCount && ok; id++) {
+    int index = paramsIdIndex[id];
+    uint8_t size = paramValueSize(index);
+
+    if (params[index].type & PARAM_RONLY)
+      continue;
+
+    paramPersistentKey(index, key);
+    if (memcmp(params[index].address, &paramsDefault[id], size) != 0) {
+      ok = storageStore(key, params[index].address, size);
+      saved++;
+    } else {
+      storageDelete(key);
+    }
+  }
+  storageBatchEnd();
+
+  return ok ? saved : -1;
+}
+
+static int paramPersistentClear(void)
+{
+  char key[PERSISTENT_KEY_MAX];
+
+  storageBatchBegin();
+  for (int id = 0; id < paramsCount; id++) {
+    int index = paramsIdIndex[id];
+
+    if (params[index].type & PARAM_RONLY)
+      continue;
+
+    paramPersistentKey(index, key);
+    storageDelete(key);
+  }
+  storageBatchEnd();
+
+  return 0;
+}
+
 static char paramWriteByNameProcess(char* group, char* name, int type, void *valptr) {
   int ptr;
   char *pgroup = "";
@@ -526,25 +833,63 @@ static void paramReadProcess()
   crtpSendPacket(&p);
 }
 
-static int variableGetIndex(int id)
+static uint32_t tocHash(const char * group, const char * name)
+{
+  // FNV-1a of "group.name"
+  uint32_t hash = 2166136261u;
+
+  for (; *group; group++)
+    hash = (hash ^ (uint8_t)*group) * 16777619u;
+  hash = (hash ^ '.') * 16777619u;
+  for (; *name; name++)
+    hash = (hash ^ (uint8_t)*name) * 16777619u;
+
+  return hash;
+}
+
+static void paramBuildIndex(void)
 {
   int i;
-  int n=0;
+  uint16_t id = 0;
+  uint16_t group = TOC_NO_ENTRY;
+  int hashSize = 1;
+
+  // At most half full, so probe sequences stay short
+  while (hashSize < 2 * paramsCount)
+    hashSize <<= 1;
+
+  paramsIdIndex = malloc(paramsCount * sizeof(uint16_t));
+  paramsGroupIndex = malloc(paramsLen * sizeof(uint16_t));
+  paramsHash = malloc(hashSize * sizeof(uint16_t));
+  ASSERT(paramsIdIndex && paramsGroupIndex && paramsHash);
+  paramsHashMask = hashSize - 1;
+  memset(paramsHash, 0xff, hashSize * sizeof(uint16_t));
 
   for (i=0; i<paramsLen; i++)
   {
-    if(!(params[i].type & PARAM_GROUP))
+    if (params[i].type & PARAM_GROUP)
     {
-      if(n==id)
-        break;
-      n++;
+      if (params[i].type & PARAM_START)
+        group = i;
+    }
+    else
+    {
+      uint32_t slot = tocHash(group != TOC_NO_ENTRY ? params[group].name : "", params[i].name) & paramsHashMask;
+      while (paramsHash[slot] != TOC_NO_ENTRY)
+        slot = (slot + 1) & paramsHashMask;
+      paramsHash[slot] = id;
+      paramsIdIndex[id++] = i;
     }
+    paramsGroupIndex[i] = group;
   }
+}
 
-  if (i>=paramsLen)
+static int variableGetIndex(int id)
+{
+  if (id < 0 || id >= paramsCount)
     return -1;
 
-  return i;
+  return paramsIdIndex[id];
 }
 
 /* Public API to access param TOC from within the copter */
@@ -552,24 +897,22 @@ static paramVarId_t invalidVarId = {0xffffu, 0xffffu};
 
 paramVarId_t paramGetVarId(char* group, char* name)
 {
-  int ptr;
-  int id = 0;
   paramVarId_t varId = invalidVarId;
-  char * currgroup = "";
+  uint32_t slot;
+
+  if (!paramsHash)
+    return invalidVarId;
 
-  for(ptr=0; ptr<paramsLen; ptr++)
+  slot = tocHash(group, name) & paramsHashMask;
+
+  for (; paramsHash[slot] != TOC_NO_ENTRY; slot = (slot + 1) & paramsHashMask)
   {
-    if (params[ptr].type & PARAM_GROUP) {
-      if (params[ptr].type & PARAM_START) {
-        currgroup = params[ptr].name;
-      }
-    } else {
-      id += 1;
-    }
-    
-    if ((!strcmp(group, currgroup)) && (!strcmp(name, params[ptr].name))) {
+    int ptr = paramsIdIndex[paramsHash[slot]];
+    uint16_t g = paramsGroupIndex[ptr];
+
+    if (!strcmp(name, params[ptr].name) && !strcmp(group, g != TOC_NO_ENTRY ? params[g].name : "")) {
       varId.ptr = ptr;
-      varId.id = id - 1;
+      varId.id = paramsHash[slot];
       return varId;
     }
   }
@@ -584,22 +927,13 @@ int paramGetType(paramVarId_t varid)
 
 void paramGetGroupAndName(paramVarId_t varid, char** group, char** name)
 {
-  char * currgroup = "";
   *group = 0;
   *name = 0;
 
-  for(int i=0; i<paramsLen; i++) {
-    if (params[i].type & PARAM_GROUP) {
-      if (params[i].type & PARAM_START) {
-        currgroup = params[i].name;
-      }
-    }
-
-    if (i == varid.ptr) {
-      *group = currgroup;
-      *name = params[i].name;
-      break;
-    }
+  if (varid.ptr < paramsLen) {
+    uint16_t g = paramsGroupIndex[varid.ptr];
+    *group = (g != TOC_NO_ENTRY) ? params[g].name : "";
+    *name = params[varid.ptr].name;
   }
 }
 
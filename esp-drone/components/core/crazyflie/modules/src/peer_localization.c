@@ -1,14 +1,51 @@
+#include <math.h>
+
 #include "config.h"
-#include "debug.h"
+#include "debug_cf.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "peer_localization.h"
 
+// Marks an empty id index entry, grid bucket or bucket list end
+#define NO_SLOT 0xFF
+#define MAX_ID 0xFF
+
+#if PEER_LOCALIZATION_MAX_PEERS >= NO_SLOT
+#error "PEER_LOCALIZATION_MAX_PEERS must fit the uint8_t slot indexes"
+#endif
+#if PEER_LOCALIZATION_GRID_BUCKETS > 32
+#error "PEER_LOCALIZATION_GRID_BUCKETS must fit the uint32_t visited mask"
+#endif
+
+// array of other's position
+static peerLocalizationOtherPosition_t other_positions[PEER_LOCALIZATION_MAX_PEERS];
+
+// Slot of each radio ID
+static uint8_t id_slot[MAX_ID + 1];
+
+// Grid buckets: first slot of each bucket, then the slots of a bucket are
+// linked through slot_next. slot_bucket is the bucket a slot is linked in.
+static uint8_t bucket_first[PEER_LOCALIZATION_GRID_BUCKETS];
+static uint8_t slot_next[PEER_LOCALIZATION_MAX_PEERS];
+static uint8_t slot_bucket[PEER_LOCALIZATION_MAX_PEERS];
+
+// The table is written by the radio tasks and queried by the stabilizer loop
+static portMUX_TYPE peerMux = portMUX_INITIALIZER_UNLOCKED;
 
 void peerLocalizationInit()
 {
   // All other_positions[in].id will be set to zero due to static initialization.
   // If we ever switch to dynamic allocation, we need to set them to zero explicitly.
+  for (int i = 0; i <= MAX_ID; ++i) {
+    id_slot[i] = NO_SLOT;
+  }
+  for (int i = 0; i < PEER_LOCALIZATION_GRID_BUCKETS; ++i) {
+    bucket_first[i] = NO_SLOT;
+  }
+  for (int i = 0; i < PEER_LOCALIZATION_MAX_PEERS; ++i) {
+    slot_next[i] = NO_SLOT;
+    slot_bucket[i] = NO_SLOT;
+  }
 }
 
 bool peerLocalizationTest()
@@ -16,40 +53,96 @@ bool peerLocalizationTest()
   return true;
 }
 
-// array of other's position
-static peerLocalizationOtherPosition_t other_positions[PEER_LOCALIZATION_MAX_NEIGHBORS];
+static int grid_cell(float coordinate)
+{
+  return (int)floorf(coordinate / PEER_LOCALIZATION_GRID_CELL_SIZE);
+}
 
-bool peerLocalizationTellPosition(int cfid, positionMeasurement_t const *pos)
+static uint8_t grid_bucket(int cell_x, int cell_y)
 {
-  for (uint8_t i = 0; i < PEER_LOCALIZATION_MAX_NEIGHBORS; ++i) {
-    if (other_positions[i].id == 0 || other_positions[i].id == cfid) {
-      other_positions[i].id = cfid;
-      other_positions[i].pos.x = pos->x;
-      other_positions[i].pos.y = pos->y;
-      other_positions[i].pos.z = pos->z;
-      other_positions[i].pos.timestamp = xTaskGetTickCount();
-      return true;
-    }
+  uint32_t hash = ((uint32_t)cell_x * 73856093u) ^ ((uint32_t)cell_y * 19349663u);
+  return hash % PEER_LOCALIZATION_GRID_BUCKETS;
+}
+
+static void bucket_unlink(uint8_t slot)
+{
+  uint8_t bucket = slot_bucket[slot];
+  if (bucket == NO_SLOT) {
+    return;
   }
-  return false;
+  uint8_t *link = &bucket_first[bucket];
+  while (*link != slot) {
+    link = &slot_next[*link];
+  }
+  *link = slot_next[slot];
+  slot_next[slot] = NO_SLOT;
+  slot_bucket[slot] = NO_SLOT;
 }
 
-bool peerLocalizationIsIDActive(uint8_t cfid)
+static void bucket_link(uint8_t slot, uint8_t bucket)
 {
-  for (uint8_t i = 0; i < PEER_LOCALIZATION_MAX_NEIGHBORS; ++i) {
-    if (other_positions[i].id == cfid) {
-      return true;
+  slot_next[slot] = bucket_first[bucket];
+  bucket_first[bucket] = slot;
+  slot_bucket[slot] = bucket;
+}
+
+// Slot for a new ID: a free one, else the one not updated for the longest time
+static uint8_t claim_slot(void)
+{
+  uint8_t oldest = 0;
+  for (uint8_t i = 0; i < PEER_LOCALIZATION_MAX_PEERS; ++i) {
+    if (other_positions[i].id == 0) {
+      return i;
+    }
+    if ((int32_t)(other_positions[i].pos.timestamp - other_positions[oldest].pos.timestamp) < 0) {
+      oldest = i;
     }
   }
-  return false;
+
+  id_slot[other_positions[oldest].id] = NO_SLOT;
+  bucket_unlink(oldest);
+  other_positions[oldest].id = 0;
+  return oldest;
+}
+
+bool peerLocalizationTellPosition(int cfid, positionMeasurement_t const *pos)
+{
+  if (cfid <= 0 || cfid > MAX_ID) {
+    return false;
+  }
+
+  portENTER_CRITICAL(&peerMux);
+  uint8_t slot = id_slot[cfid];
+  if (slot == NO_SLOT) {
+    slot = claim_slot();
+    id_slot[cfid] = slot;
+    other_positions[slot].id = cfid;
+  }
+
+  other_positions[slot].pos.x = pos->x;
+  other_positions[slot].pos.y = pos->y;
+  other_positions[slot].pos.z = pos->z;
+  other_positions[slot].pos.timestamp = xTaskGetTickCount();
+
+  uint8_t bucket = grid_bucket(grid_cell(pos->x), grid_cell(pos->y));
+  if (bucket != slot_bucket[slot]) {
+    bucket_unlink(slot);
+    bucket_link(slot, bucket);
+  }
+  portEXIT_CRITICAL(&peerMux);
+  return true;
+}
+
+bool peerLocalizationIsIDActive(uint8_t cfid)
+{
+  return cfid != 0 && id_slot[cfid] != NO_SLOT;
 }
 
 peerLocalizationOtherPosition_t *peerLocalizationGetPositionByID(uint8_t cfid)
 {
-  for (uint8_t i = 0; i < PEER_LOCALIZATION_MAX_NEIGHBORS; ++i) {
-    if (other_positions[i].id == cfid) {
-      return &other_positions[i];
-    }
+  uint8_t slot = cfid != 0 ? id_slot[cfid] : NO_SLOT;
+  if (slot != NO_SLOT) {
+    return &other_positions[slot];
   }
   return NULL;
 }
@@ -57,8 +150,77 @@ peerLocalizationOtherPosition_t *peerLocalizationGetPositionByID(uint8_t cfid)
 peerLocalizationOtherPosition_t *peerLocalizationGetPositionByIdx(uint8_t idx)
 {
   // TODO: should we return NULL if the id == 0?
-  if (idx < PEER_LOCALIZATION_MAX_NEIGHBORS) {
+  if (idx < PEER_LOCALIZATION_MAX_PEERS) {
     return &other_positions[idx];
   }
   return NULL;
 }
+
+int peerLocalizationGetNeighbors(point_t const *center, float radius, int maxAgeMillis,
+                                 peerLocalizationOtherPosition_t neighbors[], int maxNeighbors)
+{
+  // Squared distance of each neighbor, to keep them sorted
+  float dist2[PEER_LOCALIZATION_MAX_NEIGHBORS];
+  if (maxNeighbors > PEER_LOCALIZATION_MAX_NEIGHBORS) {
+    maxNeighbors = PEER_LOCALIZATION_MAX_NEIGHBORS;
+  }
+
+  uint32_t const now = xTaskGetTickCount();
+  float const radius2 = radius * radius;
+  int const x_first = grid_cell(center->x - radius);
+  int const x_last = grid_cell(center->x + radius);
+  int const y_first = grid_cell(center->y - radius);
+  int const y_last = grid_cell(center->y + radius);
+
+  // Cells sharing a bucket are visited once, the distance test sorts them out
+  uint32_t visited = 0;
+  int count = 0;
+
+  portENTER_CRITICAL(&peerMux);
+  for (int x = x_first; x <= x_last; ++x) {
+    for (int y = y_first; y <= y_last; ++y) {
+      uint8_t bucket = grid_bucket(x, y);
+      if (visited & (1u << bucket)) {
+        continue;
+      }
+      visited |= 1u << bucket;
+
+      for (uint8_t slot = bucket_first[bucket]; slot != NO_SLOT; slot = slot_next[slot]) {
+        peerLocalizationOtherPosition_t const *other = &other_positions[slot];
+        if (maxAgeMillis >= 0 && now - other->pos.timestamp > (uint32_t)maxAgeMillis) {
+          continue;
+        }
+        float const dx = other->pos.x - center->x;
+        float const dy = other->pos.y - center->y;
+        float const dz = other->pos.z - center->z;
+        float const d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 > radius2) {
+          continue;
+        }
+
+        // Insert in distance order, dropping the farthest when full
+        int i = count < maxNeighbors ? count++ : maxNeighbors;
+        while (i > 0 && dist2[i - 1] > d2) {
+          if (i < maxNeighbors) {
+            neighbors[i] = neighbors[i - 1];
+            dist2[i] = dist2[i - 1];
+          }
+          --i;
+        }
+        if (i < maxNeighbors) {
+          neighbors[i] = *other;
+          dist2[i] = d2;
+        }
+      }
+
+      if (visited == (1ull << PEER_LOCALIZATION_GRID_BUCKETS) - 1) {
+        // Every bucket seen, the remaining cells are all aliases
+        x = x_last;
+        break;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&peerMux);
+
+  return count;
+}
@@ -158,3 +158,97 @@ void pidSetKd(PidObject* pid, const float kd)
 void pidSetDt(PidObject* pid, const float dt) {
     pid->dt = dt;
 }
+
+void pid3Init(PidObject3* pid, const float kp[PID_AXES], const float ki[PID_AXES],
+              const float kd[PID_AXES], const float dt, const float samplingRate,
+              const float cutoffFreq, bool enableDFilter)
+{
+  for (int i = 0; i < PID_AXES; i++) {
+    pid->desired[i]     = 0;
+    pid->kp[i]          = kp[i];
+    pid->ki[i]          = ki[i];
+    pid->kd[i]          = kd[i];
+    pid->iLimit[i]      = DEFAULT_PID_INTEGRATION_LIMIT;
+    pid->outputLimit[i] = DEFAULT_PID_OUTPUT_LIMIT;
+  }
+  pid3Reset(pid);
+  pid->dt            = dt;
+  pid->enableDFilter = enableDFilter;
+  if (pid->enableDFilter)
+  {
+    lpf2pBankInit(&pid->dFilter, PID_AXES, samplingRate, cutoffFreq);
+  }
+}
+
+void pid3Reset(PidObject3* pid)
+{
+  for (int i = 0; i < PID_AXES; i++) {
+    pid->error[i]     = 0;
+    pid->prevError[i] = 0;
+    pid->integ[i]     = 0;
+    pid->deriv[i]     = 0;
+  }
+}
+
+void pid3Update(PidObject3* pid, const float measured[PID_AXES], const uint8_t axes,
+                float output[PID_AXES])
+{
+  float deriv[PID_AXES];
+  for (int i = 0; i < PID_AXES; i++) {
+    if (axes & (1 << i)) {
+      pid->error[i] = pid->desired[i] - measured[i];
+    }
+    deriv[i] = (pid->error[i] - pid->prevError[i]) / pid->dt;
+  }
+
+  if (pid->enableDFilter && axes == PID_AXES_ALL)
+  {
+    lpf2pBankApply(&pid->dFilter, deriv);
+  }
+  else if (pid->enableDFilter)
+  {
+    // The bank steps every channel, the axes not updated keep their state
+    float delay1[PID_AXES];
+    float delay2[PID_AXES];
+    for (int i = 0; i < PID_AXES; i++) {
+      delay1[i] = pid->dFilter.delay_element_1[i];
+      delay2[i] = pid->dFilter.delay_element_2[i];
+    }
+    lpf2pBankApply(&pid->dFilter, deriv);
+    for (int i = 0; i < PID_AXES; i++) {
+      if (!(axes & (1 << i))) {
+        pid->dFilter.delay_element_1[i] = delay1[i];
+        pid->dFilter.delay_element_2[i] = delay2[i];
+      }
+    }
+  }
+
+  for (int i = 0; i < PID_AXES; i++) {
+    if (!(axes & (1 << i))) {
+      continue;
+    }
+
+    pid->outP[i] = pid->kp[i] * pid->error[i];
+
+    pid->deriv[i] = isnan(deriv[i]) ? 0 : deriv[i];
+    pid->outD[i] = pid->kd[i] * pid->deriv[i];
+
+    pid->integ[i] += pid->error[i] * pid->dt;
+    // Constrain the integral (unless the iLimit is zero)
+    if (pid->iLimit[i] != 0)
+    {
+      pid->integ[i] = constrain(pid->integ[i], -pid->iLimit[i], pid->iLimit[i]);
+    }
+    pid->outI[i] = pid->ki[i] * pid->integ[i];
+
+    float out = pid->outP[i] + pid->outD[i] + pid->outI[i];
+    // Constrain the total PID output (unless the outputLimit is zero)
+    if (pid->outputLimit[i] != 0)
+    {
+      out = constrain(out, -pid->outputLimit[i], pid->outputLimit[i]);
+    }
+    output[i] = out;
+
+    pid->prevError[i] = pid->error[i];
+  }
+}
@@ -80,6 +80,9 @@ bool plan_is_finished(struct planner *p, float t)
 		case TRAJECTORY_TYPE_PIECEWISE_COMPRESSED:
 		  return piecewise_compressed_is_finished(p->compressed_trajectory, t);
 
+		case TRAJECTORY_TYPE_PIECEWISE_STREAM:
+		  return piecewise_stream_is_finished(p->stream_trajectory, t);
+
 		default:
 		  return 1;
 	}
@@ -128,6 +131,16 @@ struct traj_eval plan_eval(struct planner *p, float t)
 			}
 			break;
 
+		case TRAJECTORY_TYPE_PIECEWISE_STREAM:
+			if (p->reversed) {
+				/* not supported */
+				return traj_eval_invalid();
+			}
+			else {
+				return piecewise_stream_eval(p->stream_trajectory, t);
+			}
+			break;
+
 		default:
 			return traj_eval_invalid();
 	}
@@ -207,3 +220,13 @@ int plan_start_compressed_trajectory( struct planner *p, struct piecewise_traj_c
 
 	return 0;
 }
+
+int plan_start_stream_trajectory( struct planner *p, struct piecewise_traj_stream* trajectory)
+{
+	p->reversed = 0;
+	p->state = TRAJECTORY_STATE_FLYING;
+	p->type = TRAJECTORY_TYPE_PIECEWISE_STREAM;
+	p->stream_trajectory = trajectory;
+
+	return 0;
+}
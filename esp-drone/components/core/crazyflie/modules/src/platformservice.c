@@ -46,10 +46,12 @@ typedef enum {
   platformCommand   = 0x00,
   versionCommand    = 0x01,
   appChannel        = 0x02,
+  appStream         = PLATFORMSERVICE_APP_STREAM_CHANNEL,
 } Channel;
 
 typedef enum {
   setContinousWave   = 0x00,
+  setMaxDataSize     = 0x01,
 } PlatformCommand;
 
 typedef enum {
@@ -94,6 +96,9 @@ void platformserviceHandler(CRTPPacket *p)
     case appChannel:
       appchannelIncomingPacket(p);
       break;
+    case appStream:
+      appchannelStreamIncomingPacket(p);
+      break;
     default:
       break;
   }
@@ -110,6 +115,10 @@ static void platformCommandProcess(uint8_t command, uint8_t *data)
       // slp.data[0] = data[0];
       // syslinkSendPacket(&slp);
       break;
+    case setMaxDataSize:
+      // Jumbo packet negotiation, the granted size is echoed back
+      data[0] = crtpSetMaxDataSize(data[0]);
+      break;
     default:
       break;
   }
@@ -122,6 +131,13 @@ void platformserviceSendAppchannelPacket(CRTPPacket *p)
   crtpSendPacket(p);
 }
 
+bool platformserviceSendAppStreamPacket(CRTPPacket *p)
+{
+  p->port = CRTP_PORT_PLATFORM;
+  p->channel = appStream;
+  return crtpSendPacket(p) == pdTRUE;
+}
+
 static void versionCommandProcess(CRTPPacket *p)
 {
   switch (p->data[0]) {
@@ -131,15 +147,15 @@ static void versionCommandProcess(CRTPPacket *p)
       crtpSendPacket(p);
       break;
     case getFirmwareVersion:
-      strncpy((char*)&p->data[1], V_STAG, CRTP_MAX_DATA_SIZE-1);
-      p->size = (strlen(V_STAG)>CRTP_MAX_DATA_SIZE-1)?CRTP_MAX_DATA_SIZE:strlen(V_STAG)+1;
+      strncpy((char*)&p->data[1], V_STAG, CRTP_LEGACY_DATA_SIZE-1);
+      p->size = (strlen(V_STAG)>CRTP_LEGACY_DATA_SIZE-1)?CRTP_LEGACY_DATA_SIZE:strlen(V_STAG)+1;
       crtpSendPacket(p);
       break;
     case getDeviceTypeName:
       {
       const char* name = platformConfigGetDeviceTypeName();
-      strncpy((char*)&p->data[1], name, CRTP_MAX_DATA_SIZE-1);
-      p->size = (strlen(name)>CRTP_MAX_DATA_SIZE-1)?CRTP_MAX_DATA_SIZE:strlen(name)+1;
+      strncpy((char*)&p->data[1], name, CRTP_LEGACY_DATA_SIZE-1);
+      p->size = (strlen(name)>CRTP_LEGACY_DATA_SIZE-1)?CRTP_LEGACY_DATA_SIZE:strlen(name)+1;
       crtpSendPacket(p);
       }
       break;
@@ -42,29 +42,21 @@
 #endif
 
 struct pidInit_s {
-  float kp;
-  float ki;
-  float kd;
+  float kp[PID_AXES];
+  float ki[PID_AXES];
+  float kd[PID_AXES];
 };
 
-struct pidAxis_s {
-  PidObject pid;
+// Position and velocity PIDs, axis 0, 1, 2 are x, y, z
+struct pidAxes_s {
+  PidObject3 pid;
 
   struct pidInit_s init;
-    stab_mode_t previousMode;
-  float setpoint;
-
-  float output;
 };
 
 struct this_s {
-  struct pidAxis_s pidVX;
-  struct pidAxis_s pidVY;
-  struct pidAxis_s pidVZ;
-
-  struct pidAxis_s pidX;
-  struct pidAxis_s pidY;
-  struct pidAxis_s pidZ;
+  struct pidAxes_s pidV;
+  struct pidAxes_s pidPos;
 
   uint16_t thrustBase; // approximate throttle needed when in perfect hover. More weight/older battery can use a higher value
   uint16_t thrustMin;  // Minimum thrust value to output
@@ -85,56 +77,20 @@ static const float thrustScale = 1000.0f;
 
 #ifndef UNIT_TEST
 static struct this_s this = {
-  .pidVX = {
-    .init = {
-      .kp = 25.0f,
-      .ki = 1.0f,
-      .kd = 0.0f,
-    },
-    .pid.dt = DT,
-  },
-
-  .pidVY = {
+  .pidV = {
     .init = {
-      .kp = 25.0f,
-      .ki = 1.0f,
-      .kd = 0.0f,
+      .kp = {25.0f, 25.0f, 22},
+      .ki = {1.0f, 1.0f, 15},
+      .kd = {0.0f, 0.0f, 0},
     },
     .pid.dt = DT,
   },
 
-  .pidVZ = {
+  .pidPos = {
     .init = {
-      .kp = 22,
-      .ki = 15,
-      .kd = 0,
-    },
-    .pid.dt = DT,
-  },
-
-  .pidX = {
-    .init = {
-      .kp = 1.9f,
-      .ki = 0.1f,
-      .kd = 0,
-    },
-    .pid.dt = DT,
-  },
-
-  .pidY = {
-    .init = {
-      .kp = 1.9f,
-      .ki = 0.1f,
-      .kd = 0,
-    },
-    .pid.dt = DT,
-  },
-
-  .pidZ = {
-    .init = {
-      .kp = 1.6f,
-      .ki = 0.5,
-      .kd = 0,
+      .kp = {1.9f, 1.9f, 1.6f},
+      .ki = {0.1f, 0.1f, 0.5},
+      .kd = {0, 0, 0},
     },
     .pid.dt = DT,
   },
@@ -158,56 +114,55 @@ static struct this_s this = {
 
 void positionControllerInit()
 {
-  pidInit(&this.pidX.pid, this.pidX.setpoint, this.pidX.init.kp, this.pidX.init.ki, this.pidX.init.kd,
-      this.pidX.pid.dt, POSITION_RATE, POSITION_LPF_CUTOFF_FREQ, POSITION_LPF_ENABLE);
-  pidInit(&this.pidY.pid, this.pidY.setpoint, this.pidY.init.kp, this.pidY.init.ki, this.pidY.init.kd,
-      this.pidY.pid.dt, POSITION_RATE, POSITION_LPF_CUTOFF_FREQ, POSITION_LPF_ENABLE);
-  pidInit(&this.pidZ.pid, this.pidZ.setpoint, this.pidZ.init.kp, this.pidZ.init.ki, this.pidZ.init.kd,
-      this.pidZ.pid.dt, POSITION_RATE, POSITION_LPF_CUTOFF_FREQ, POSITION_LPF_ENABLE);
-
-  pidInit(&this.pidVX.pid, this.pidVX.setpoint, this.pidVX.init.kp, this.pidVX.init.ki, this.pidVX.init.kd,
-      this.pidVX.pid.dt, POSITION_RATE, POSITION_LPF_CUTOFF_FREQ, POSITION_LPF_ENABLE);
-  pidInit(&this.pidVY.pid, this.pidVY.setpoint, this.pidVY.init.kp, this.pidVY.init.ki, this.pidVY.init.kd,
-      this.pidVY.pid.dt, POSITION_RATE, POSITION_LPF_CUTOFF_FREQ, POSITION_LPF_ENABLE);
-  pidInit(&this.pidVZ.pid, this.pidVZ.setpoint, this.pidVZ.init.kp, this.pidVZ.init.ki, this.pidVZ.init.kd,
-      this.pidVZ.pid.dt, POSITION_RATE, POSITION_LPF_CUTOFF_FREQ, POSITION_LPF_ENABLE);
+  pid3Init(&this.pidPos.pid, this.pidPos.init.kp, this.pidPos.init.ki, this.pidPos.init.kd,
+      this.pidPos.pid.dt, POSITION_RATE, POSITION_LPF_CUTOFF_FREQ, POSITION_LPF_ENABLE);
+  pid3Init(&this.pidV.pid, this.pidV.init.kp, this.pidV.init.ki, this.pidV.init.kd,
+      this.pidV.pid.dt, POSITION_RATE, POSITION_LPF_CUTOFF_FREQ, POSITION_LPF_ENABLE);
   DEBUG_PRINTI("thrustBase = %d,thrustMin  = %d",this.thrustBase,this.thrustMin);
 }
 
-static float runPid(float input, struct pidAxis_s *axis, float setpoint, float dt) {
-  axis->setpoint = setpoint;
-
-  pidSetDesired(&axis->pid, axis->setpoint);
-  return pidUpdate(&axis->pid, input, true);
-}
-
 void positionController(float* thrust, attitude_t *attitude, setpoint_t *setpoint,
                                                              const state_t *state)
 {
-  this.pidX.pid.outputLimit = xyVelMax * velMaxOverhead;
-  this.pidY.pid.outputLimit = xyVelMax * velMaxOverhead;
+  PidObject3 *pid = &this.pidPos.pid;
+  pid->outputLimit[0] = xyVelMax * velMaxOverhead;
+  pid->outputLimit[1] = xyVelMax * velMaxOverhead;
   // The ROS landing detector will prematurely trip if
   // this value is below 0.5
-  this.pidZ.pid.outputLimit = fmaxf(zVelMax, 0.5f)  * velMaxOverhead;
+  pid->outputLimit[2] = fmaxf(zVelMax, 0.5f)  * velMaxOverhead;
 
   float cosyaw = cosf(state->attitude.yaw * (float)M_PI / 180.0f);
   float sinyaw = sinf(state->attitude.yaw * (float)M_PI / 180.0f);
   float bodyvx = setpoint->velocity.x;
   float bodyvy = setpoint->velocity.y;
 
-  // X, Y
-  if (setpoint->mode.x == modeAbs) {
-    setpoint->velocity.x = runPid(state->position.x, &this.pidX, setpoint->position.x, DT);
+  // X, Y, Z in one update of the axes in absolute mode
+  const stab_mode_t modes[PID_AXES] = {setpoint->mode.x, setpoint->mode.y, setpoint->mode.z};
+  const float position[PID_AXES] = {state->position.x, state->position.y, state->position.z};
+  const float desired[PID_AXES] = {setpoint->position.x, setpoint->position.y, setpoint->position.z};
+  uint8_t axes = 0;
+  for (int i = 0; i < PID_AXES; i++) {
+    if (modes[i] == modeAbs) {
+      pid->desired[i] = desired[i];
+      axes |= 1 << i;
+    }
+  }
+
+  float velocity[PID_AXES];
+  pid3Update(pid, position, axes, velocity);
+
+  if (axes & (1 << 0)) {
+    setpoint->velocity.x = velocity[0];
   } else if (setpoint->velocity_body) {
     setpoint->velocity.x = bodyvx * cosyaw - bodyvy * sinyaw;
   }
-  if (setpoint->mode.y == modeAbs) {
-    setpoint->velocity.y = runPid(state->position.y, &this.pidY, setpoint->position.y, DT);
+  if (axes & (1 << 1)) {
+    setpoint->velocity.y = velocity[1];
   } else if (setpoint->velocity_body) {
     setpoint->velocity.y = bodyvy * cosyaw + bodyvx * sinyaw;
   }
-  if (setpoint->mode.z == modeAbs) {
-    setpoint->velocity.z = runPid(state->position.z, &this.pidZ, setpoint->position.z, DT);
+  if (axes & (1 << 2)) {
+    setpoint->velocity.z = velocity[2];
   }
 
   velocityController(thrust, attitude, setpoint, state);
@@ -216,15 +171,23 @@ void positionController(float* thrust, attitude_t *attitude, setpoint_t *setpoin
 void velocityController(float* thrust, attitude_t *attitude, setpoint_t *setpoint,
                                                              const state_t *state)
 {
-  this.pidVX.pid.outputLimit = rpLimit * rpLimitOverhead;
-  this.pidVY.pid.outputLimit = rpLimit * rpLimitOverhead;
+  PidObject3 *pid = &this.pidV.pid;
+  pid->outputLimit[0] = rpLimit * rpLimitOverhead;
+  pid->outputLimit[1] = rpLimit * rpLimitOverhead;
   // Set the output limit to the maximum thrust range
-  this.pidVZ.pid.outputLimit = (UINT16_MAX / 2 / thrustScale);
-  //this.pidVZ.pid.outputLimit = (this.thrustBase - this.thrustMin) / thrustScale;
+  pid->outputLimit[2] = (UINT16_MAX / 2 / thrustScale);
+  //pid->outputLimit[2] = (this.thrustBase - this.thrustMin) / thrustScale;
+
+  pid->desired[0] = setpoint->velocity.x;
+  pid->desired[1] = setpoint->velocity.y;
+  pid->desired[2] = setpoint->velocity.z;
+  const float velocity[PID_AXES] = {state->velocity.x, state->velocity.y, state->velocity.z};
+  float raw[PID_AXES];
+  pid3Update(pid, velocity, PID_AXES_ALL, raw);
 
   // Roll and Pitch
-  float rollRaw  = runPid(state->velocity.x, &this.pidVX, setpoint->velocity.x, DT);
-  float pitchRaw = runPid(state->velocity.y, &this.pidVY, setpoint->velocity.y, DT);
+  float rollRaw  = raw[0];
+  float pitchRaw = raw[1];
 
   float yawRad = state->attitude.yaw * (float)M_PI / 180;
   attitude->pitch = -(rollRaw  * cosf(yawRad)) - (pitchRaw * sinf(yawRad));
@@ -234,7 +197,7 @@ void velocityController(float* thrust, attitude_t *attitude, setpoint_t *setpoin
   attitude->pitch = constrain(attitude->pitch, -rpLimit, rpLimit);
 
   // Thrust
-  float thrustRaw = runPid(state->velocity.z, &this.pidVZ, setpoint->velocity.z, DT);
+  float thrustRaw = raw[2];
   // Scale the thrust and add feed forward term
   *thrust = thrustRaw*thrustScale + this.thrustBase;
   // Check for minimum thrust
@@ -245,75 +208,71 @@ void velocityController(float* thrust, attitude_t *attitude, setpoint_t *setpoin
 
 void positionControllerResetAllPID()
 {
-  pidReset(&this.pidX.pid);
-  pidReset(&this.pidY.pid);
-  pidReset(&this.pidZ.pid);
-  pidReset(&this.pidVX.pid);
-  pidReset(&this.pidVY.pid);
-  pidReset(&this.pidVZ.pid);
+  pid3Reset(&this.pidPos.pid);
+  pid3Reset(&this.pidV.pid);
 }
 
 LOG_GROUP_START(posCtl)
 
-LOG_ADD(LOG_FLOAT, targetVX, &this.pidVX.pid.desired)
-LOG_ADD(LOG_FLOAT, targetVY, &this.pidVY.pid.desired)
-LOG_ADD(LOG_FLOAT, targetVZ, &this.pidVZ.pid.desired)
+LOG_ADD(LOG_FLOAT, targetVX, &this.pidV.pid.desired[0])
+LOG_ADD(LOG_FLOAT, targetVY, &this.pidV.pid.desired[1])
+LOG_ADD(LOG_FLOAT, targetVZ, &this.pidV.pid.desired[2])
 
-LOG_ADD(LOG_FLOAT, targetX, &this.pidX.pid.desired)
-LOG_ADD(LOG_FLOAT, targetY, &this.pidY.pid.desired)
-LOG_ADD(LOG_FLOAT, targetZ, &this.pidZ.pid.desired)
+LOG_ADD(LOG_FLOAT, targetX, &this.pidPos.pid.desired[0])
+LOG_ADD(LOG_FLOAT, targetY, &this.pidPos.pid.desired[1])
+LOG_ADD(LOG_FLOAT, targetZ, &this.pidPos.pid.desired[2])
 
-LOG_ADD(LOG_FLOAT, Xp, &this.pidX.pid.outP)
-LOG_ADD(LOG_FLOAT, Xi, &this.pidX.pid.outI)
-LOG_ADD(LOG_FLOAT, Xd, &this.pidX.pid.outD)
+LOG_ADD(LOG_FLOAT, Xp, &this.pidPos.pid.outP[0])
+LOG_ADD(LOG_FLOAT, Xi, &this.pidPos.pid.outI[0])
+LOG_ADD(LOG_FLOAT, Xd, &this.pidPos.pid.outD[0])
 
-LOG_ADD(LOG_FLOAT, Yp, &this.pidY.pid.outP)
-LOG_ADD(LOG_FLOAT, Yi, &this.pidY.pid.outI)
-LOG_ADD(LOG_FLOAT, Yd, &this.pidY.pid.outD)
+LOG_ADD(LOG_FLOAT, Yp, &this.pidPos.pid.outP[1])
+LOG_ADD(LOG_FLOAT, Yi, &this.pidPos.pid.outI[1])
+LOG_ADD(LOG_FLOAT, Yd, &this.pidPos.pid.outD[1])
 
-LOG_ADD(LOG_FLOAT, Zp, &this.pidZ.pid.outP)
-LOG_ADD(LOG_FLOAT, Zi, &this.pidZ.pid.outI)
-LOG_ADD(LOG_FLOAT, Zd, &this.pidZ.pid.outD)
+LOG_ADD(LOG_FLOAT, Zp, &this.pidPos.pid.outP[2])
+LOG_ADD(LOG_FLOAT, Zi, &this.pidPos.pid.outI[2])
+LOG_ADD(LOG_FLOAT, Zd, &this.pidPos.pid.outD[2])
 
-LOG_ADD(LOG_FLOAT, VXp, &this.pidVX.pid.outP)
-LOG_ADD(LOG_FLOAT, VXi, &this.pidVX.pid.outI)
-LOG_ADD(LOG_FLOAT, VXd, &this.pidVX.pid.outD)
+LOG_ADD(LOG_FLOAT, VXp, &this.pidV.pid.outP[0])
+LOG_ADD(LOG_FLOAT, VXi, &this.pidV.pid.outI[0])
+LOG_ADD(LOG_FLOAT, VXd, &this.pidV.pid.outD[0])
 
-LOG_ADD(LOG_FLOAT, VZp, &this.pidVZ.pid.outP)
-LOG_ADD(LOG_FLOAT, VZi, &this.pidVZ.pid.outI)
-LOG_ADD(LOG_FLOAT, VZd, &this.pidVZ.pid.outD)
+LOG_ADD(LOG_FLOAT, VZp, &this.pidV.pid.outP[2])
+LOG_ADD(LOG_FLOAT, VZi, &this.pidV.pid.outI[2])
+LOG_ADD(LOG_FLOAT, VZd, &this.pidV.pid.outD[2])
 
 LOG_GROUP_STOP(posCtl)
 
 PARAM_GROUP_START(velCtlPid)
 
-PARAM_ADD(PARAM_FLOAT, vxKp, &this.pidVX.pid.kp)
-PARAM_ADD(PARAM_FLOAT, vxKi, &this.pidVX.pid.ki)
-PARAM_ADD(PARAM_FLOAT, vxKd, &this.pidVX.pid.kd)
+PARAM_ADD(PARAM_FLOAT, vxKp, &this.pidV.pid.kp[0])
+PARAM_ADD(PARAM_FLOAT, vxKi, &this.pidV.pid.ki[0])
+PARAM_ADD(PARAM_FLOAT, vxKd, &this.pidV.pid.kd[0])
 
-PARAM_ADD(PARAM_FLOAT, vyKp, &this.pidVY.pid.kp)
-PARAM_ADD(PARAM_FLOAT, vyKi, &this.pidVY.pid.ki)
-PARAM_ADD(PARAM_FLOAT, vyKd, &this.pidVY.pid.kd)
+PARAM_ADD(PARAM_FLOAT, vyKp, &this.pidV.pid.kp[1])
+PARAM_ADD(PARAM_FLOAT, vyKi, &this.pidV.pid.ki[1])
+PARAM_ADD(PARAM_FLOAT, vyKd, &this.pidV.pid.kd[1])
 
-PARAM_ADD(PARAM_FLOAT, vzKp, &this.pidVZ.pid.kp)
-PARAM_ADD(PARAM_FLOAT, vzKi, &this.pidVZ.pid.ki)
-PARAM_ADD(PARAM_FLOAT, vzKd, &this.pidVZ.pid.kd)
+PARAM_ADD(PARAM_FLOAT, vzKp, &this.pidV.pid.kp[2])
+PARAM_ADD(PARAM_FLOAT, vzKi, &this.pidV.pid.ki[2])
+PARAM_ADD(PARAM_FLOAT, vzKd, &this.pidV.pid.kd[2])
 
 PARAM_GROUP_STOP(velCtlPid)
 
 PARAM_GROUP_START(posCtlPid)
 
-PARAM_ADD(PARAM_FLOAT, xKp, &this.pidX.pid.kp)
-PARAM_ADD(PARAM_FLOAT, xKi, &this.pidX.pid.ki)
-PARAM_ADD(PARAM_FLOAT, xKd, &this.pidX.pid.kd)
+PARAM_ADD(PARAM_FLOAT, xKp, &this.pidPos.pid.kp[0])
+PARAM_ADD(PARAM_FLOAT, xKi, &this.pidPos.pid.ki[0])
+PARAM_ADD(PARAM_FLOAT, xKd, &this.pidPos.pid.kd[0])
 
-PARAM_ADD(PARAM_FLOAT, yKp, &this.pidY.pid.kp)
-PARAM_ADD(PARAM_FLOAT, yKi, &this.pidY.pid.ki)
-PARAM_ADD(PARAM_FLOAT, yKd, &this.pidY.pid.kd)
+PARAM_ADD(PARAM_FLOAT, yKp, &this.pidPos.pid.kp[1])
+PARAM_ADD(PARAM_FLOAT, yKi, &this.pidPos.pid.ki[1])
+PARAM_ADD(PARAM_FLOAT, yKd, &this.pidPos.pid.kd[1])
 
-PARAM_ADD(PARAM_FLOAT, zKp, &this.pidZ.pid.kp)
-PARAM_ADD(PARAM_FLOAT, zKi, &this.pidZ.pid.ki)
-PARAM_ADD(PARAM_FLOAT, zKd, &this.pidZ.pid.kd)
+PARAM_ADD(PARAM_FLOAT, zKp, &this.pidPos.pid.kp[2])
+PARAM_ADD(PARAM_FLOAT, zKi, &this.pidPos.pid.ki[2])
+PARAM_ADD(PARAM_FLOAT, zKd, &this.pidPos.pid.kd[2])
 
 PARAM_ADD(PARAM_UINT16, thrustBase, &this.thrustBase)
 PARAM_ADD(PARAM_UINT16, thrustMin, &this.thrustMin)
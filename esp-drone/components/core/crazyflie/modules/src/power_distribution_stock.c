@@ -77,10 +77,8 @@ bool powerDistributionTest(void)
 
 void powerStop()
 {
-  motorsSetRatio(MOTOR_M1, 0);
-  motorsSetRatio(MOTOR_M2, 0);
-  motorsSetRatio(MOTOR_M3, 0);
-  motorsSetRatio(MOTOR_M4, 0);
+  const uint16_t stop[NBR_OF_MOTORS] = {0};
+  motorsSetRatios(stop);
 }
 
 void powerDistribution(const control_t *control)
@@ -105,10 +103,8 @@ void powerDistribution(const control_t *control)
 
   if (motorSetEnable)
   {
-    motorsSetRatio(MOTOR_M1, motorPowerSet.m1);
-    motorsSetRatio(MOTOR_M2, motorPowerSet.m2);
-    motorsSetRatio(MOTOR_M3, motorPowerSet.m3);
-    motorsSetRatio(MOTOR_M4, motorPowerSet.m4);
+    const uint16_t ratios[NBR_OF_MOTORS] = {motorPowerSet.m1, motorPowerSet.m2, motorPowerSet.m3, motorPowerSet.m4};
+    motorsSetRatios(ratios);
   }
   else
   {
@@ -125,10 +121,8 @@ void powerDistribution(const control_t *control)
       motorPower.m4 = idleThrust;
     }
 
-    motorsSetRatio(MOTOR_M1, motorPower.m1);
-    motorsSetRatio(MOTOR_M2, motorPower.m2);
-    motorsSetRatio(MOTOR_M3, motorPower.m3);
-    motorsSetRatio(MOTOR_M4, motorPower.m4);
+    const uint16_t ratios[NBR_OF_MOTORS] = {motorPower.m1, motorPower.m2, motorPower.m3, motorPower.m4};
+    motorsSetRatios(ratios);
   }
 }
 
@@ -37,6 +37,8 @@ implementation of piecewise polynomial trajectories
 See Daniel Mellinger, Vijay Kumar: "Minimum snap trajectory generation and control for quadrotors". ICRA 2011: 2520-2525
 */
 
+#include <string.h>
+
 #include "pptraj.h"
 
 #define GRAV (9.81f)
@@ -117,6 +119,37 @@ float polyval(float const p[PP_SIZE], float t)
 	return x;
 }
 
+// evaluate a polynomial and its first three derivatives in a single horner pass.
+// d[k] is the k-th derivative divided by k!, the taylor coefficient at t.
+static void polyval_taylor3(float const p[PP_SIZE], float t, float d[4])
+{
+	float d0 = p[PP_DEGREE];
+	float d1 = 0, d2 = 0, d3 = 0;
+	for (int i = PP_DEGREE - 1; i >= 0; --i) {
+		d3 = d3 * t + d2;
+		d2 = d2 * t + d1;
+		d1 = d1 * t + d0;
+		d0 = d0 * t + p[i];
+	}
+	d[0] = d0;
+	d[1] = d1;
+	d[2] = d2;
+	d[3] = d3;
+}
+
+// evaluate a polynomial and its first derivative in a single horner pass.
+static float polyval_taylor1(float const p[PP_SIZE], float t, float *d1)
+{
+	float d0 = p[PP_DEGREE];
+	float dd = 0;
+	for (int i = PP_DEGREE - 1; i >= 0; --i) {
+		dd = dd * t + d0;
+		d0 = d0 * t + p[i];
+	}
+	*d1 = dd;
+	return d0;
+}
+
 // compute derivative of a polynomial in place
 void polyder(float p[PP_SIZE])
 {
@@ -291,25 +324,19 @@ bool is_traj_eval_valid(struct traj_eval const *ev)
 
 struct traj_eval poly4d_eval(struct poly4d const *p, float t)
 {
-	// flat variables
+	// flat variables and their derivatives
 	struct traj_eval out;
-	out.pos = polyval_xyz(p, t);
-	out.yaw = polyval_yaw(p, t);
-
-	// 1st derivative
-	struct poly4d* deriv = &poly4d_tmp;
-	*deriv = *p;
-	polyder4d(deriv);
-	out.vel = polyval_xyz(deriv, t);
-	float dyaw = polyval_yaw(deriv, t);
-
-	// 2nd derivative
-	polyder4d(deriv);
-	out.acc = polyval_xyz(deriv, t);
-
-	// 3rd derivative
-	polyder4d(deriv);
-	struct vec jerk = polyval_xyz(deriv, t);
+	float x[4], y[4], z[4];
+	polyval_taylor3(p->p[0], t, x);
+	polyval_taylor3(p->p[1], t, y);
+	polyval_taylor3(p->p[2], t, z);
+	float dyaw;
+	out.yaw = polyval_taylor1(p->p[3], t, &dyaw);
+
+	out.pos = mkvec(x[0], y[0], z[0]);
+	out.vel = mkvec(x[1], y[1], z[1]);
+	out.acc = mkvec(2 * x[2], 2 * y[2], 2 * z[2]);
+	struct vec jerk = mkvec(6 * x[3], 6 * y[3], 6 * z[3]);
 
 	struct vec thrust = vadd(out.acc, mkvec(0, 0, GRAV));
 	// float thrust_mag = mass * vmag(thrust);
@@ -333,6 +360,40 @@ struct traj_eval poly4d_eval(struct poly4d const *p, float t)
 // piecewise 4d polynomials
 //
 
+// the piece being flown, shifted and stretched in time. it is prepared again
+// only when the piece, or how it is flown, changes.
+static struct {
+	struct poly4d piece;
+	struct vec shift;
+	float timescale;
+	bool reversed;
+	bool valid;
+	struct poly4d poly;
+} active;
+
+static struct poly4d const *active_piece(struct poly4d const *piece,
+	struct vec shift, float timescale, bool reversed)
+{
+	if (!active.valid || active.timescale != timescale || active.reversed != reversed
+		|| !veq(active.shift, shift) || memcmp(&active.piece, piece, sizeof(active.piece)) != 0) {
+		active.piece = *piece;
+		active.shift = shift;
+		active.timescale = timescale;
+		active.reversed = reversed;
+		active.valid = true;
+
+		active.poly = *piece;
+		poly4d_shift(&active.poly, shift.x, shift.y, shift.z, 0);
+		poly4d_stretchtime(&active.poly, timescale);
+		if (reversed) {
+			for (int i = 0; i < 4; ++i) {
+				polyreflect(active.poly.p[i]);
+			}
+		}
+	}
+	return &active.poly;
+}
+
 // piecewise eval
 struct traj_eval piecewise_eval(
   struct piecewise_traj const *traj, float t)
@@ -342,10 +403,7 @@ struct traj_eval piecewise_eval(
 	while (cursor < traj->n_pieces) {
 		struct poly4d const *piece = &(traj->pieces[cursor]);
 		if (t <= piece->duration * traj->timescale) {
-			poly4d_tmp = *piece;
-			poly4d_shift(&poly4d_tmp, traj->shift.x, traj->shift.y, traj->shift.z, 0);
-			poly4d_stretchtime(&poly4d_tmp, traj->timescale);
-			return poly4d_eval(&poly4d_tmp, t);
+			return poly4d_eval(active_piece(piece, traj->shift, traj->timescale, false), t);
 		}
 		t -= piece->duration * traj->timescale;
 		++cursor;
@@ -368,14 +426,8 @@ struct traj_eval piecewise_eval_reversed(
 	while (cursor >= 0) {
 		struct poly4d const *piece = &(traj->pieces[cursor]);
 		if (t <= piece->duration * traj->timescale) {
-			poly4d_tmp = *piece;
-			poly4d_shift(&poly4d_tmp, traj->shift.x, traj->shift.y, traj->shift.z, 0);
-			poly4d_stretchtime(&poly4d_tmp, traj->timescale);
-			for (int i = 0; i < 4; ++i) {
-				polyreflect(poly4d_tmp.p[i]);
-			}
 			t = t - piece->duration * traj->timescale;
-			return poly4d_eval(&poly4d_tmp, t);
+			return poly4d_eval(active_piece(piece, traj->shift, traj->timescale, true), t);
 		}
 		t -= piece->duration * traj->timescale;
 		--cursor;
@@ -423,3 +475,213 @@ void piecewise_plan_7th_order_no_jerk(struct piecewise_traj *pp, float duration,
 	poly7_nojerk(p->p[3], duration, y0, dy0, 0, y1, dy1, 0);
 }
 
+
+//
+// coverage paths, flown at constant speed from and to rest.
+// each piece joins two knots of the path with a 5th order polynomial
+// matching their position, velocity and centripetal acceleration.
+//
+
+struct path_knot
+{
+	struct vec pos;
+	struct vec dir;       // unit tangent
+	struct vec curvature; // curvature vector, towards the center of the turn
+	float s;              // arc length from the start
+};
+
+static void path_piece(struct poly4d *p, struct path_knot const *k0, struct path_knot const *k1,
+	bool first, bool last, float speed, float yaw)
+{
+	struct vec v0 = first ? vzero() : vscl(speed, k0->dir);
+	struct vec a0 = first ? vzero() : vscl(speed * speed, k0->curvature);
+	struct vec v1 = last ? vzero() : vscl(speed, k1->dir);
+	struct vec a1 = last ? vzero() : vscl(speed * speed, k1->curvature);
+
+	float duration = (k1->s - k0->s) / speed;
+	// about half the speed on average while accelerating or braking
+	if (first || last) {
+		duration *= 2;
+	}
+
+	p->duration = duration;
+	poly5(p->p[0], duration, k0->pos.x, v0.x, a0.x, k1->pos.x, v1.x, a1.x);
+	poly5(p->p[1], duration, k0->pos.y, v0.y, a0.y, k1->pos.y, v1.y, a1.y);
+	poly5(p->p[2], duration, k0->pos.z, 0, 0, k1->pos.z, 0, 0);
+	poly5(p->p[3], duration, yaw, 0, 0, yaw, 0, 0);
+}
+
+// knot of the archimedean spiral r = b * theta around center
+static struct path_knot spiral_knot(struct vec center, float b, float theta)
+{
+	float c = cosf(theta);
+	float s = sinf(theta);
+	float root = sqrtf(1 + theta * theta);
+	float kappa = (2 + theta * theta) / (b * root * root * root);
+
+	struct path_knot k;
+	k.pos = vadd(center, mkvec(b * theta * c, b * theta * s, 0));
+	k.dir = vdiv(mkvec(c - theta * s, s + theta * c, 0), root);
+	k.curvature = vscl(kappa, mkvec(-k.dir.y, k.dir.x, 0));
+	k.s = b / 2 * (theta * root + asinhf(theta));
+	return k;
+}
+
+bool piecewise_plan_spiral(struct piecewise_traj *pp, int max_pieces,
+	struct vec center, float yaw, float spacing, float radius, float speed)
+{
+	if (!(spacing > 0 && radius > 0 && speed > 0)) {
+		return false;
+	}
+
+	// a quarter turn per piece
+	float b = spacing / (2 * M_PI_F);
+	float theta_end = radius / b;
+	int n_pieces = (int)ceilf(theta_end / M_PI_2_F);
+	if (n_pieces > max_pieces || n_pieces > 255) {
+		return false;
+	}
+
+	struct path_knot k0 = spiral_knot(center, b, 0);
+	for (int i = 0; i < n_pieces; ++i) {
+		float theta = i == n_pieces - 1 ? theta_end : (i + 1) * M_PI_2_F;
+		struct path_knot k1 = spiral_knot(center, b, theta);
+		path_piece(&pp->pieces[i], &k0, &k1, i == 0, i == n_pieces - 1, speed, yaw);
+		k0 = k1;
+	}
+
+	pp->timescale = 1.0;
+	pp->shift = vzero();
+	pp->n_pieces = n_pieces;
+	return true;
+}
+
+// knot i of the zigzag: the start and end of each lane, then the middle of
+// the half circle turn to the next lane
+static struct path_knot zigzag_knot(struct vec start, float spacing, float width, int i)
+{
+	int lane = i / 3;
+	float sx = (lane % 2 == 0) ? 1 : -1;
+	float x_start = (lane % 2 == 0) ? 0 : width;
+	float y = lane * spacing;
+	float r = spacing / 2;
+	float half_turn = M_PI_F * r;
+
+	struct path_knot k;
+	k.s = lane * (width + half_turn);
+	switch (i % 3) {
+	case 0:
+		k.pos = mkvec(x_start, y, 0);
+		k.dir = mkvec(sx, 0, 0);
+		k.curvature = vzero();
+		break;
+	case 1:
+		k.pos = mkvec(x_start + sx * width, y, 0);
+		k.dir = mkvec(sx, 0, 0);
+		k.curvature = vzero();
+		k.s += width;
+		break;
+	default:
+		k.pos = mkvec(x_start + sx * (width + r), y + r, 0);
+		k.dir = mkvec(0, 1, 0);
+		k.curvature = mkvec(-sx / r, 0, 0);
+		k.s += width + half_turn / 2;
+		break;
+	}
+	k.pos = vadd(start, k.pos);
+	return k;
+}
+
+bool piecewise_plan_zigzag(struct piecewise_traj *pp, int max_pieces,
+	struct vec start, float yaw, float spacing, float width, float length, float speed)
+{
+	if (!(spacing > 0 && width > 0 && length >= 0 && speed > 0)) {
+		return false;
+	}
+
+	// lane, first half turn, second half turn
+	int n_lanes = (int)floorf(length / spacing) + 1;
+	int n_pieces = 3 * n_lanes - 2;
+	if (n_pieces > max_pieces || n_pieces > 255) {
+		return false;
+	}
+
+	struct path_knot k0 = zigzag_knot(start, spacing, width, 0);
+	for (int i = 0; i < n_pieces; ++i) {
+		struct path_knot k1 = zigzag_knot(start, spacing, width, i + 1);
+		path_piece(&pp->pieces[i], &k0, &k1, i == 0, i == n_pieces - 1, speed, yaw);
+		k0 = k1;
+	}
+
+	pp->timescale = 1.0;
+	pp->shift = vzero();
+	pp->n_pieces = n_pieces;
+	return true;
+}
+
+//
+// streamed piecewise trajectories
+//
+
+void piecewise_stream_init(struct piecewise_traj_stream *traj, struct poly4d *ring, unsigned char n_slots)
+{
+	traj->t_begin = 0;
+	traj->shift = vzero();
+	traj->ring = ring;
+	traj->n_slots = n_slots;
+	traj->first = 0;
+	traj->count = 0;
+	traj->complete = false;
+	traj->starved = false;
+	traj->underruns = 0;
+}
+
+bool piecewise_stream_append(struct piecewise_traj_stream *traj, unsigned char n, bool complete)
+{
+	if (traj->complete || traj->count + n > traj->n_slots) {
+		return false;
+	}
+	traj->count += n;
+	traj->complete = complete;
+	return true;
+}
+
+bool piecewise_stream_is_busy(struct piecewise_traj_stream const *traj, unsigned char slot)
+{
+	int offset = ((int)slot - traj->first + traj->n_slots) % traj->n_slots;
+	return offset < traj->count;
+}
+
+struct traj_eval piecewise_stream_eval(
+	struct piecewise_traj_stream *traj, float t)
+{
+	if (traj->count == 0) {
+		return traj_eval_invalid();
+	}
+
+	struct poly4d const *piece = &traj->ring[traj->first];
+	while (t - traj->t_begin > piece->duration && traj->count > 1) {
+		// a piece appended after starving starts now
+		traj->t_begin = traj->starved ? t : traj->t_begin + piece->duration;
+		traj->starved = false;
+		traj->first = (traj->first + 1) % traj->n_slots;
+		--traj->count;
+		piece = &traj->ring[traj->first];
+	}
+
+	if (t - traj->t_begin <= piece->duration) {
+		return poly4d_eval(active_piece(piece, traj->shift, 1, false), t - traj->t_begin);
+	}
+
+	// the end of the trajectory, or the ground is late
+	if (!traj->complete && !traj->starved) {
+		traj->starved = true;
+		++traj->underruns;
+	}
+	struct traj_eval ev = poly4d_eval(piece, piece->duration);
+	ev.pos = vadd(ev.pos, traj->shift);
+	ev.vel = vzero();
+	ev.acc = vzero();
+	ev.omega = vzero();
+	return ev;
+}
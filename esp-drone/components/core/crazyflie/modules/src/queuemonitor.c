@@ -31,41 +31,48 @@
 #ifdef DEBUG_QUEUE_MONITOR
 
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include "timers.h"
 #include "debug_cf.h"
 #include "cfassert.h"
+#include "usec_time.h"
 
-#define MAX_NR_OF_QUEUES 20
-#define TIMER_PERIOD M2T(10000)
+#define MAX_NR_OF_QUEUES (QUEUE_MONITOR_MAX_QUEUES + 1)
+#define TIMER_PERIOD M2T(1000)
 
-#define RESET_COUNTERS_AFTER_DISPLAY true
 #define DISPLAY_ONLY_OVERFLOW_QUEUES true
 
+// Counters of the current period, updated from any task, core or ISR
 typedef struct
 {
-  char* fileName;
-  char* queueName;
-  int sendCount;
-  int maxWaiting;
-  int fullCount;
+  const char* fileName;
+  char name[QUEUE_MONITOR_NAME_LEN];
+  uint16_t length;
+  uint32_t sendCount;
+  uint32_t maxWaiting;
+  uint32_t fullCount;
 } Data;
 
 static Data data[MAX_NR_OF_QUEUES];
 
+// Queues of the last period, read by the telemetry
+static queueMonitorQueue_t latest[QUEUE_MONITOR_MAX_QUEUES];
+static int latestCount = 0;
+static uint64_t latestTimestamp = 0;
+static portMUX_TYPE latestMux = portMUX_INITIALIZER_UNLOCKED;
+
 static xTimerHandle timer;
 static StaticTimer_t timerBuffer;
-static unsigned char nrOfQueues = 1; // Unregistered queues will end up at 0
+static uint32_t nrOfQueues = 1; // Unregistered queues have number 0
 static bool initialized = false;
 
 static void timerHandler(xTimerHandle timer);
-static void debugPrint();
-static bool filter(Data* queueData);
-static void debugPrintQueue(Data* queueData);
-static Data* getQueueData(xQueueHandle* xQueue);
-static int getMaxWaiting(xQueueHandle* xQueue, int prevPeak);
-static void resetCounters();
-
-unsigned char ucQueueGetQueueNumber( xQueueHandle xQueue );
+static bool filter(const queueMonitorQueue_t* queue);
+static void debugPrintQueue(const Data* queueData, const queueMonitorQueue_t* queue);
+static unsigned char registerData(const char* fileName, const char* queueName, int index, uint16_t length);
+static void raisePeak(uint32_t* peak, uint32_t waiting);
+static uint16_t clampU16(uint32_t value);
 
 
 void queueMonitorInit() {
@@ -74,101 +81,118 @@ void queueMonitorInit() {
     pdTRUE, NULL, timerHandler, &timerBuffer);
   xTimerStart(timer, 100);
 
-  data[0].fileName = "Na";
-  data[0].queueName = "Na";
-
   initialized = true;
 }
 
-void qm_traceQUEUE_SEND(void* xQueue) {
-  if(initialized) {
-    Data* queueData = getQueueData(xQueue);
+void qmRegisterQueue(xQueueHandle xQueue, const char* fileName, const char* queueName, int index) {
+  uint16_t length = uxQueueMessagesWaiting(xQueue) + uxQueueSpacesAvailable(xQueue);
+  vQueueSetQueueNumber(xQueue, registerData(fileName, queueName, index, length));
+}
 
-    queueData->sendCount++;
-    queueData->maxWaiting = getMaxWaiting(xQueue, queueData->maxWaiting);
-  }
+unsigned char qmRegisterBuffer(const char* fileName, const char* bufferName, uint16_t length) {
+  return registerData(fileName, bufferName, -1, length);
 }
 
-void qm_traceQUEUE_SEND_FAILED(void* xQueue) {
-  if(initialized) {
-    Data* queueData = getQueueData(xQueue);
+void qmQueueSend(xQueueHandle xQueue, bool sent) {
+  qmRecord(uxQueueGetQueueNumber(xQueue), sent ? uxQueueMessagesWaitingFromISR(xQueue) : 0, sent);
+}
 
-    queueData->fullCount++;
+void qmRecord(unsigned char number, uint32_t waiting, bool sent) {
+  if (number == 0 || number >= MAX_NR_OF_QUEUES) {
+    return;
   }
-}
+  Data* queueData = &data[number];
 
-void qmRegisterQueue(xQueueHandle* xQueue, char* fileName, char* queueName) {
-  ASSERT(initialized);
-  ASSERT(nrOfQueues < MAX_NR_OF_QUEUES);
-  Data* queueData = &data[nrOfQueues];
+  if (sent) {
+    __atomic_fetch_add(&queueData->sendCount, 1, __ATOMIC_RELAXED);
+    raisePeak(&queueData->maxWaiting, waiting);
+  } else {
+    __atomic_fetch_add(&queueData->fullCount, 1, __ATOMIC_RELAXED);
+    raisePeak(&queueData->maxWaiting, queueData->length);
+  }
+}
 
-  queueData->fileName = fileName;
-  queueData->queueName = queueName;
-  vQueueSetQueueNumber(xQueue, nrOfQueues);
+int queueMonitorGetQueues(queueMonitorQueue_t queues[], int maxQueues, uint64_t *timestamp) {
+  portENTER_CRITICAL(&latestMux);
+  int count = latestCount < maxQueues ? latestCount : maxQueues;
+  memcpy(queues, latest, count * sizeof(queueMonitorQueue_t));
+  *timestamp = latestTimestamp;
+  portEXIT_CRITICAL(&latestMux);
 
-  nrOfQueues++;
+  return count;
 }
 
-static Data* getQueueData(xQueueHandle* xQueue) {
-  unsigned char number = uxQueueGetQueueNumber(xQueue);
+static unsigned char registerData(const char* fileName, const char* queueName, int index, uint16_t length) {
+  unsigned char number = __atomic_fetch_add(&nrOfQueues, 1, __ATOMIC_RELAXED);
   ASSERT(number < MAX_NR_OF_QUEUES);
-  return &data[number];
-}
-
-static int getMaxWaiting(xQueueHandle* xQueue, int prevPeak) {
-  // We get here before the current item is added to the queue.
-  // Must add 1 to get the peak value.
-  unsigned portBASE_TYPE waiting = uxQueueMessagesWaitingFromISR(xQueue) + 1;
+  Data* queueData = &data[number];
 
-  if (waiting > prevPeak) {
-    return waiting;
+  queueData->fileName = fileName;
+  if (index >= 0) {
+    snprintf(queueData->name, QUEUE_MONITOR_NAME_LEN, "%s%d", queueName, index);
+  } else {
+    snprintf(queueData->name, QUEUE_MONITOR_NAME_LEN, "%s", queueName);
   }
-  return prevPeak;
+  queueData->length = length;
+
+  return number;
 }
 
-static void debugPrint() {
-  int i = 0;
-  for (i = 0; i < nrOfQueues; i++) {
-    Data* queueData = &data[i];
-    if (filter(queueData)) {
-      debugPrintQueue(queueData);
-    }
+static void raisePeak(uint32_t* peak, uint32_t waiting) {
+  uint32_t current = __atomic_load_n(peak, __ATOMIC_RELAXED);
+  while (waiting > current &&
+         !__atomic_compare_exchange_n(peak, &current, waiting, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
   }
+}
 
-  if (RESET_COUNTERS_AFTER_DISPLAY) {
-    resetCounters();
-  }
+static uint16_t clampU16(uint32_t value) {
+  return value > UINT16_MAX ? UINT16_MAX : value;
 }
 
-static bool filter(Data* queueData) {
+static bool filter(const queueMonitorQueue_t* queue) {
   bool doDisplay = false;
   if (DISPLAY_ONLY_OVERFLOW_QUEUES) {
-    doDisplay = (queueData->fullCount != 0);
+    doDisplay = (queue->fullCount != 0);
   } else {
     doDisplay = true;
   }
   return doDisplay;
 }
 
-static void debugPrintQueue(Data* queueData) {
-  DEBUG_PRINT("%s:%s, sent: %i, peak: %i, full: %i\n",
-    queueData->fileName, queueData->queueName, queueData->sendCount,
-    queueData->maxWaiting, queueData->fullCount);
+static void debugPrintQueue(const Data* queueData, const queueMonitorQueue_t* queue) {
+  DEBUG_PRINT("%s:%s, sent: %i, peak: %i/%i, full: %i\n",
+    queueData->fileName, queue->name, queue->sendCount,
+    queue->maxWaiting, queue->length, queue->fullCount);
 }
 
-static void resetCounters() {
-  int i = 0;
-  for (i = 0; i < nrOfQueues; i++) {
-    Data* queueData = &data[i];
+// Closes the period: the counters are moved to the latest table and reset
+static void timerHandler(xTimerHandle timer) {
+  static queueMonitorQueue_t queues[QUEUE_MONITOR_MAX_QUEUES];
+  int count = __atomic_load_n(&nrOfQueues, __ATOMIC_RELAXED) - 1;
+  if (count > QUEUE_MONITOR_MAX_QUEUES) {
+    count = QUEUE_MONITOR_MAX_QUEUES;
+  }
+
+  for (int i = 0; i < count; i++) {
+    Data* queueData = &data[i + 1];
+    queueMonitorQueue_t* queue = &queues[i];
+
+    memcpy(queue->name, queueData->name, QUEUE_MONITOR_NAME_LEN);
+    queue->length = queueData->length;
+    queue->sendCount = clampU16(__atomic_exchange_n(&queueData->sendCount, 0, __ATOMIC_RELAXED));
+    queue->maxWaiting = clampU16(__atomic_exchange_n(&queueData->maxWaiting, 0, __ATOMIC_RELAXED));
+    queue->fullCount = clampU16(__atomic_exchange_n(&queueData->fullCount, 0, __ATOMIC_RELAXED));
 
-    queueData->sendCount = 0;
-    queueData->maxWaiting = 0;
-    queueData->fullCount = 0;
+    if (filter(queue)) {
+      debugPrintQueue(queueData, queue);
+    }
   }
-}
 
-static void timerHandler(xTimerHandle timer) {
-  debugPrint();
+  portENTER_CRITICAL(&latestMux);
+  memcpy(latest, queues, count * sizeof(queueMonitorQueue_t));
+  latestCount = count;
+  latestTimestamp = usecTimestamp();
+  portEXIT_CRITICAL(&latestMux);
 }
 
 #endif // DEBUG_QUEUE_MONITOR
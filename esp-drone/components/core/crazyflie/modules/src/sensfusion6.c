@@ -25,6 +25,7 @@
  */
 #include <math.h>
 
+#include "sdkconfig.h"
 #include "sensfusion6.h"
 #include "log.h"
 #include "param.h"
@@ -171,6 +172,96 @@ static void sensfusion6UpdateQImpl(float gx, float gy, float gz, float ax, float
   qy *= recipNorm;
   qz *= recipNorm;
 }
+#elif defined(CONFIG_SENSFUSION6_FAST_UPDATE)
+// Single pass version of the Mahony update below. The deg/s to rad/s
+// conversion and the dt/2 integration factor are folded into gains, computed
+// again only when a gain or dt changes. The quaternion leaves unit length by
+// at most the integration error of one step, so it is renormalized with the
+// first order expansion of 1/sqrt(n) around 1 instead of a second invSqrt().
+static float gainsTwoKp = -1.0f;
+static float gainsTwoKi = -1.0f;
+static float gainsDt = -1.0f;
+static float gyroGain;    // deg/s to half the rotation over dt
+static float kpGain;      // proportional feedback to half the rotation over dt
+static float kiGain;      // integral feedback step
+static float halfDt;
+
+static void sensfusion6UpdateQImpl(float gx, float gy, float gz, float ax, float ay, float az, float dt)
+{
+  float recipNorm;
+  float halfvx, halfvy, halfvz;
+  float halfex, halfey, halfez;
+  float qa, qb, qc;
+
+  if (twoKp != gainsTwoKp || twoKi != gainsTwoKi || dt != gainsDt)
+  {
+    halfDt = 0.5f * dt;
+    gyroGain = halfDt * M_PI_F / 180;
+    kpGain = twoKp * halfDt;
+    kiGain = twoKi * dt;
+    gainsTwoKp = twoKp;
+    gainsTwoKi = twoKi;
+    gainsDt = dt;
+  }
+
+  gx *= gyroGain;
+  gy *= gyroGain;
+  gz *= gyroGain;
+
+  // Compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
+  if(!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f)))
+  {
+    recipNorm = invSqrt(ax * ax + ay * ay + az * az);
+
+    // Estimated direction of gravity
+    halfvx = qx * qz - qw * qy;
+    halfvy = qw * qx + qy * qz;
+    halfvz = qw * qw - 0.5f + qz * qz;
+
+    // Cross product between estimated and measured direction of gravity,
+    // normalised once instead of normalising the accelerometer
+    halfex = (ay * halfvz - az * halfvy) * recipNorm;
+    halfey = (az * halfvx - ax * halfvz) * recipNorm;
+    halfez = (ax * halfvy - ay * halfvx) * recipNorm;
+
+    if(twoKi > 0.0f)
+    {
+      integralFBx += kiGain * halfex;  // integral error scaled by Ki
+      integralFBy += kiGain * halfey;
+      integralFBz += kiGain * halfez;
+      gx += integralFBx * halfDt;  // apply integral feedback
+      gy += integralFBy * halfDt;
+      gz += integralFBz * halfDt;
+    }
+    else
+    {
+      integralFBx = 0.0f; // prevent integral windup
+      integralFBy = 0.0f;
+      integralFBz = 0.0f;
+    }
+
+    // Apply proportional feedback
+    gx += kpGain * halfex;
+    gy += kpGain * halfey;
+    gz += kpGain * halfez;
+  }
+
+  // Integrate rate of change of quaternion
+  qa = qw;
+  qb = qx;
+  qc = qy;
+  qw += (-qb * gx - qc * gy - qz * gz);
+  qx += (qa * gx + qc * gz - qz * gy);
+  qy += (qa * gy - qb * gz + qz * gx);
+  qz += (qa * gz + qb * gy - qc * gx);
+
+  // Normalise quaternion, 1/sqrt(n) ~ (3 - n) / 2 for n close to 1
+  recipNorm = 1.5f - 0.5f * (qw * qw + qx * qx + qy * qy + qz * qz);
+  qw *= recipNorm;
+  qx *= recipNorm;
+  qy *= recipNorm;
+  qz *= recipNorm;
+}
 #else // MAHONY_QUATERNION_IMU
 // Madgwick's implementation of Mayhony's AHRS algorithm.
 // See: http://www.x-io.co.uk/open-source-ahrs-with-x-imu
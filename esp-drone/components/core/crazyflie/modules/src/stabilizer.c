@@ -26,6 +26,8 @@
 
 #include <math.h>
 #include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -44,7 +46,7 @@
 #include "sitaw.h"
 #include "controller.h"
 #include "power_distribution.h"
-//#include "collision_avoidance.h"
+#include "collision_avoidance.h"
 
 #include "estimator.h"
 //#include "usddeck.h" //usddeckLoggingMode_e
@@ -54,6 +56,8 @@
 #include "debug_cf.h"
 #include "static_mem.h"
 #include "rateSupervisor.h"
+#include "drone_telemetry.h"
+#include "event_trace.h"
 
 static bool isInit;
 static bool emergencyStop = false;
@@ -72,6 +76,15 @@ static sensorData_t sensorData;
 static state_t state;
 static control_t control;
 
+// Copies of the state for the other tasks, published as a seqlock over two
+// buffers: the stabilizer writes the buffer the readers are not pointed to,
+// then bumps the sequence, whose parity selects the buffer to read
+static struct {
+  state_t state;
+  uint32_t tick;
+} stateSnapshots[2];
+static uint32_t stateSnapshotSeq;
+
 static StateEstimatorType estimatorType;
 static ControllerType controllerType;
 
@@ -83,9 +96,22 @@ typedef enum { configureAcc, measureNoiseFloor, measureProp, testBattery, restar
 #endif
 
 static STATS_CNT_RATE_DEFINE(stabilizerRate, 500);
+// Sensor interrupt to motor output latency, in us
+static STATS_CNT_LATENCY_DEFINE(inToOutStats, 1000, 50);
 static rateSupervisor_t rateSupervisorContext;
 static bool rateWarningDisplayed = false;
 
+// Period of the main loop, and window of the timing maximums (in loop ticks)
+#define STABILIZER_LOOP_PERIOD_US (1000000 / RATE_MAIN_LOOP)
+#define STABILIZER_TIMING_WINDOW RATE_MAIN_LOOP
+
+const uint16_t stabilizerTimingBinEdges[STABILIZER_TIMING_BINS - 1] = {
+  25, 50, 100, 200, 300, 500, STABILIZER_LOOP_PERIOD_US
+};
+static stabilizerTimingHistogram_t timing[stabilizerTimingCount];
+static uint16_t timingWindowMax[stabilizerTimingCount];
+static uint64_t lastWakeTimestamp;
+
 static struct {
   // position - mm
   int16_t x;
@@ -143,10 +169,83 @@ const state_t* stabilizerGetState(void)
     return &state; 
 }
 
+bool stabilizerGetStateSnapshot(state_t *snapshot, uint32_t *tick)
+{
+  uint32_t seq;
+  uint32_t snapshotTick;
+  do {
+    seq = __atomic_load_n(&stateSnapshotSeq, __ATOMIC_ACQUIRE);
+    if (seq == 0) {
+      return false;
+    }
+    memcpy(snapshot, &stateSnapshots[seq & 1].state, sizeof(state_t));
+    snapshotTick = stateSnapshots[seq & 1].tick;
+    // Once the sequence moves on, the next tick overwrites the buffer just read
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while (__atomic_load_n(&stateSnapshotSeq, __ATOMIC_RELAXED) != seq);
+
+  if (tick) {
+    *tick = snapshotTick;
+  }
+  return true;
+}
+
+static void publishStateSnapshot(uint32_t tick)
+{
+  uint32_t seq = stateSnapshotSeq + 1;
+  stateSnapshots[seq & 1].state = state;
+  stateSnapshots[seq & 1].tick = tick;
+  __atomic_store_n(&stateSnapshotSeq, seq, __ATOMIC_RELEASE);
+}
+
 static void calcSensorToOutputLatency(const sensorData_t *sensorData)
 {
   uint64_t outTimestamp = usecTimestamp();
   inToOutLatency = outTimestamp - sensorData->interruptTimestamp;
+  STATS_CNT_LATENCY_SAMPLE(&inToOutStats, inToOutLatency);
+}
+
+static void timingRecord(stabilizerTiming_t stage, uint64_t us)
+{
+  uint16_t clipped = us > UINT16_MAX ? UINT16_MAX : (uint16_t)us;
+  int bin = 0;
+  while (bin < STABILIZER_TIMING_BINS - 1 && clipped >= stabilizerTimingBinEdges[bin]) {
+    bin++;
+  }
+  timing[stage].bins[bin]++;
+  if (clipped > timingWindowMax[stage]) {
+    timingWindowMax[stage] = clipped;
+  }
+}
+
+// Records the end of a stage started at *start, and starts the next one
+static void timingStage(stabilizerTiming_t stage, uint64_t *start)
+{
+  uint64_t now = usecTimestamp();
+  timingRecord(stage, now - *start);
+  *start = now;
+}
+
+static void timingLoopEnd(uint64_t wake, uint32_t tick)
+{
+  timingRecord(stabilizerTimingLoop, usecTimestamp() - wake);
+  if (lastWakeTimestamp != 0) {
+    int64_t period = (int64_t)(wake - lastWakeTimestamp);
+    timingRecord(stabilizerTimingJitter, llabs(period - STABILIZER_LOOP_PERIOD_US));
+  }
+  lastWakeTimestamp = wake;
+
+  if (tick % STABILIZER_TIMING_WINDOW == 0) {
+    for (int i = 0; i < stabilizerTimingCount; i++) {
+      timing[i].max = timingWindowMax[i];
+      timingWindowMax[i] = 0;
+    }
+  }
+}
+
+void stabilizerGetTimingHistograms(stabilizerTimingHistogram_t histograms[stabilizerTimingCount])
+{
+  memcpy(histograms, timing, sizeof(timing));
 }
 
 static void compressState()
@@ -204,11 +303,11 @@ void stabilizerInit(StateEstimatorType estimator)
   controllerInit(ControllerTypeAny);
   powerDistributionInit();
   sitAwInit();
-  //collisionAvoidanceInit();
+  collisionAvoidanceInit();
   estimatorType = getStateEstimator();
   controllerType = getControllerType();
 
-  STATIC_MEM_TASK_CREATE(stabilizerTask, stabilizerTask, STABILIZER_TASK_NAME, NULL, STABILIZER_TASK_PRI);
+  STATIC_MEM_TASK_CREATE_PINNED(stabilizerTask, stabilizerTask, STABILIZER_TASK_NAME, NULL, STABILIZER_TASK_PRI, STABILIZER_TASK_CORE);
 
   isInit = true;
 }
@@ -221,7 +320,7 @@ bool stabilizerTest(void)
   pass &= stateEstimatorTest();
   pass &= controllerTest();
   pass &= powerDistributionTest();
-  //pass &= collisionAvoidanceTest();
+  pass &= collisionAvoidanceTest();
 
   return pass;
 }
@@ -273,6 +372,9 @@ static void stabilizerTask(void* param)
   while(1) {
     // The sensor should unlock at 1kHz
     sensorsWaitDataReady();
+    const uint64_t wake = usecTimestamp();
+    uint64_t stageStart = wake;
+    EVENT_TRACE_BEGIN(eventTraceStabilizerLoop, tick);
 
     if (startPropTest != false) {
       // TODO: What happens with estimator when we run tests after startup?
@@ -295,25 +397,39 @@ static void stabilizerTask(void* param)
         controllerType = getControllerType();
       }
 
+      EVENT_TRACE_BEGIN(eventTraceStabilizerEstimator, tick);
       stateEstimator(&state, &sensorData, &control, tick);
+      EVENT_TRACE_STOP(eventTraceStabilizerEstimator, tick);
+      timingStage(stabilizerTimingEstimator, &stageStart);
       compressState();
+      publishStateSnapshot(tick);
+      telemetryPublishPose(&state, tick);
 
+      EVENT_TRACE_BEGIN(eventTraceStabilizerSetpoint, tick);
       commanderGetSetpoint(&setpoint, &state);
       compressSetpoint();
 
       sitAwUpdateSetpoint(&setpoint, &sensorData, &state);
-      //collisionAvoidanceUpdateSetpoint(&setpoint, &sensorData, &state, tick);
+      collisionAvoidanceUpdateSetpoint(&setpoint, &sensorData, &state, tick);
+      EVENT_TRACE_STOP(eventTraceStabilizerSetpoint, tick);
+      timingStage(stabilizerTimingSetpoint, &stageStart);
 
+      EVENT_TRACE_BEGIN(eventTraceStabilizerController, tick);
       controller(&control, &setpoint, &sensorData, &state, tick);
+      EVENT_TRACE_STOP(eventTraceStabilizerController, tick);
+      timingStage(stabilizerTimingController, &stageStart);
 
       checkEmergencyStopTimeout();
 
+      EVENT_TRACE_BEGIN(eventTraceStabilizerPower, tick);
       checkStops = systemIsArmed();
       if (emergencyStop || (systemIsArmed() == false)) {
         powerStop();
       } else {
         powerDistribution(&control);
       }
+      EVENT_TRACE_STOP(eventTraceStabilizerPower, tick);
+      timingStage(stabilizerTimingPower, &stageStart);
 
       //TODO: Log data to uSD card if configured
       /*if (usddeckLoggingEnabled()
@@ -323,6 +439,8 @@ static void stabilizerTask(void* param)
       }*/
     }
     calcSensorToOutputLatency(&sensorData);
+    timingLoopEnd(wake, tick);
+    EVENT_TRACE_STOP(eventTraceStabilizerLoop, tick);
     tick++;
     STATS_CNT_RATE_EVENT(&stabilizerRate);
 
@@ -622,8 +740,105 @@ LOG_ADD(LOG_FLOAT, thrust, &control.thrust)
 
 STATS_CNT_RATE_LOG_ADD(rtStab, &stabilizerRate)
 LOG_ADD(LOG_UINT32, intToOut, &inToOutLatency)
+STATS_CNT_LATENCY_LOG_ADD(intToOut, &inToOutStats)
 LOG_GROUP_STOP(stabilizer)
 
+/**
+ * Time of the estimator, with the sensor data acquisition.
+ * Loop iterations per bin since start, in us, and longest time of the last second
+ */
+LOG_GROUP_START(stabEst)
+LOG_ADD(LOG_UINT32, lt25, &timing[stabilizerTimingEstimator].bins[0])
+LOG_ADD(LOG_UINT32, lt50, &timing[stabilizerTimingEstimator].bins[1])
+LOG_ADD(LOG_UINT32, lt100, &timing[stabilizerTimingEstimator].bins[2])
+LOG_ADD(LOG_UINT32, lt200, &timing[stabilizerTimingEstimator].bins[3])
+LOG_ADD(LOG_UINT32, lt300, &timing[stabilizerTimingEstimator].bins[4])
+LOG_ADD(LOG_UINT32, lt500, &timing[stabilizerTimingEstimator].bins[5])
+LOG_ADD(LOG_UINT32, lt1000, &timing[stabilizerTimingEstimator].bins[6])
+LOG_ADD(LOG_UINT32, ge1000, &timing[stabilizerTimingEstimator].bins[7])
+LOG_ADD(LOG_UINT16, max, &timing[stabilizerTimingEstimator].max)
+LOG_GROUP_STOP(stabEst)
+
+/**
+ * Time of the setpoint update and situation awareness.
+ * Loop iterations per bin since start, in us, and longest time of the last second
+ */
+LOG_GROUP_START(stabSetpt)
+LOG_ADD(LOG_UINT32, lt25, &timing[stabilizerTimingSetpoint].bins[0])
+LOG_ADD(LOG_UINT32, lt50, &timing[stabilizerTimingSetpoint].bins[1])
+LOG_ADD(LOG_UINT32, lt100, &timing[stabilizerTimingSetpoint].bins[2])
+LOG_ADD(LOG_UINT32, lt200, &timing[stabilizerTimingSetpoint].bins[3])
+LOG_ADD(LOG_UINT32, lt300, &timing[stabilizerTimingSetpoint].bins[4])
+LOG_ADD(LOG_UINT32, lt500, &timing[stabilizerTimingSetpoint].bins[5])
+LOG_ADD(LOG_UINT32, lt1000, &timing[stabilizerTimingSetpoint].bins[6])
+LOG_ADD(LOG_UINT32, ge1000, &timing[stabilizerTimingSetpoint].bins[7])
+LOG_ADD(LOG_UINT16, max, &timing[stabilizerTimingSetpoint].max)
+LOG_GROUP_STOP(stabSetpt)
+
+/**
+ * Time of the controller.
+ * Loop iterations per bin since start, in us, and longest time of the last second
+ */
+LOG_GROUP_START(stabCtrl)
+LOG_ADD(LOG_UINT32, lt25, &timing[stabilizerTimingController].bins[0])
+LOG_ADD(LOG_UINT32, lt50, &timing[stabilizerTimingController].bins[1])
+LOG_ADD(LOG_UINT32, lt100, &timing[stabilizerTimingController].bins[2])
+LOG_ADD(LOG_UINT32, lt200, &timing[stabilizerTimingController].bins[3])
+LOG_ADD(LOG_UINT32, lt300, &timing[stabilizerTimingController].bins[4])
+LOG_ADD(LOG_UINT32, lt500, &timing[stabilizerTimingController].bins[5])
+LOG_ADD(LOG_UINT32, lt1000, &timing[stabilizerTimingController].bins[6])
+LOG_ADD(LOG_UINT32, ge1000, &timing[stabilizerTimingController].bins[7])
+LOG_ADD(LOG_UINT16, max, &timing[stabilizerTimingController].max)
+LOG_GROUP_STOP(stabCtrl)
+
+/**
+ * Time of the power distribution.
+ * Loop iterations per bin since start, in us, and longest time of the last second
+ */
+LOG_GROUP_START(stabPower)
+LOG_ADD(LOG_UINT32, lt25, &timing[stabilizerTimingPower].bins[0])
+LOG_ADD(LOG_UINT32, lt50, &timing[stabilizerTimingPower].bins[1])
+LOG_ADD(LOG_UINT32, lt100, &timing[stabilizerTimingPower].bins[2])
+LOG_ADD(LOG_UINT32, lt200, &timing[stabilizerTimingPower].bins[3])
+LOG_ADD(LOG_UINT32, lt300, &timing[stabilizerTimingPower].bins[4])
+LOG_ADD(LOG_UINT32, lt500, &timing[stabilizerTimingPower].bins[5])
+LOG_ADD(LOG_UINT32, lt1000, &timing[stabilizerTimingPower].bins[6])
+LOG_ADD(LOG_UINT32, ge1000, &timing[stabilizerTimingPower].bins[7])
+LOG_ADD(LOG_UINT16, max, &timing[stabilizerTimingPower].max)
+LOG_GROUP_STOP(stabPower)
+
+/**
+ * Time of a whole loop iteration, ge1000 counts the deadline misses.
+ * Loop iterations per bin since start, in us, and longest time of the last second
+ */
+LOG_GROUP_START(stabLoop)
+LOG_ADD(LOG_UINT32, lt25, &timing[stabilizerTimingLoop].bins[0])
+LOG_ADD(LOG_UINT32, lt50, &timing[stabilizerTimingLoop].bins[1])
+LOG_ADD(LOG_UINT32, lt100, &timing[stabilizerTimingLoop].bins[2])
+LOG_ADD(LOG_UINT32, lt200, &timing[stabilizerTimingLoop].bins[3])
+LOG_ADD(LOG_UINT32, lt300, &timing[stabilizerTimingLoop].bins[4])
+LOG_ADD(LOG_UINT32, lt500, &timing[stabilizerTimingLoop].bins[5])
+LOG_ADD(LOG_UINT32, lt1000, &timing[stabilizerTimingLoop].bins[6])
+LOG_ADD(LOG_UINT32, ge1000, &timing[stabilizerTimingLoop].bins[7])
+LOG_ADD(LOG_UINT16, max, &timing[stabilizerTimingLoop].max)
+LOG_GROUP_STOP(stabLoop)
+
+/**
+ * Deviation of the loop wake up period from 1 ms.
+ * Loop iterations per bin since start, in us, and longest time of the last second
+ */
+LOG_GROUP_START(stabJitter)
+LOG_ADD(LOG_UINT32, lt25, &timing[stabilizerTimingJitter].bins[0])
+LOG_ADD(LOG_UINT32, lt50, &timing[stabilizerTimingJitter].bins[1])
+LOG_ADD(LOG_UINT32, lt100, &timing[stabilizerTimingJitter].bins[2])
+LOG_ADD(LOG_UINT32, lt200, &timing[stabilizerTimingJitter].bins[3])
+LOG_ADD(LOG_UINT32, lt300, &timing[stabilizerTimingJitter].bins[4])
+LOG_ADD(LOG_UINT32, lt500, &timing[stabilizerTimingJitter].bins[5])
+LOG_ADD(LOG_UINT32, lt1000, &timing[stabilizerTimingJitter].bins[6])
+LOG_ADD(LOG_UINT32, ge1000, &timing[stabilizerTimingJitter].bins[7])
+LOG_ADD(LOG_UINT16, max, &timing[stabilizerTimingJitter].max)
+LOG_GROUP_STOP(stabJitter)
+
 LOG_GROUP_START(acc)
 LOG_ADD(LOG_FLOAT, x, &sensorData.acc.x)
 LOG_ADD(LOG_FLOAT, y, &sensorData.acc.y)
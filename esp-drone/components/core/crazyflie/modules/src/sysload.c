@@ -29,18 +29,22 @@
 
 #include <stdbool.h>
 #include <inttypes.h>
+#include <string.h>
 #include "FreeRTOS.h"
 #include "timers.h"
+#include "esp_heap_caps.h"
 #include "cfassert.h"
+#include "log.h"
 #include "param.h"
 #include "static_mem.h"
+#include "usec_time.h"
 
 #include "sysload.h"
 #include "stm32_legacy.h"
 #define DEBUG_MODULE "SYSLOAD"
 #include "debug_cf.h"
 
-#define TIMER_PERIOD M2T(5000)
+#define TIMER_PERIOD M2T(1000)
 
 static void timerHandler(xTimerHandle timer);
 
@@ -52,16 +56,35 @@ typedef struct {
   uint32_t xTaskNumber;
 } taskData_t;
 
-#define TASK_MAX_COUNT 32
+#define TASK_MAX_COUNT SYSLOAD_MAX_TASKS
 NO_DMA_CCM_SAFE_ZERO_INIT static taskData_t previousSnapshot[TASK_MAX_COUNT];
 static int taskTopIndex = 0;
 static uint32_t previousTotalRunTime = 0;
 
+// Tasks of the last period, read by the telemetry
+NO_DMA_CCM_SAFE_ZERO_INIT static sysLoadTask_t latestTasks[TASK_MAX_COUNT];
+static int latestTaskCount = 0;
+static uint64_t latestTimestamp = 0;
+static portMUX_TYPE latestMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Heap of the last period, and the failed allocations counted by allocFailedHook
+static sysLoadHeap_t latestHeap;
+static uint32_t allocFailures;
+static uint32_t lastFailedSize;
+static bool lowBlockWarned = false;
+
 static StaticTimer_t timerBuffer;
 
+static void allocFailedHook(size_t size, uint32_t caps, const char *functionName) {
+  __atomic_add_fetch(&allocFailures, 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&lastFailedSize, (uint32_t)size, __ATOMIC_RELAXED);
+}
+
 void sysLoadInit() {
   ASSERT(!initialized);
 
+  heap_caps_register_failed_alloc_callback(allocFailedHook);
+
   xTimerHandle timer = xTimerCreateStatic( "sysLoadMonitorTimer", TIMER_PERIOD, pdTRUE, NULL, timerHandler, &timerBuffer);
   xTimerStart(timer, 100);
 
@@ -87,41 +110,118 @@ static taskData_t* getPreviousTaskData(uint32_t xTaskNumber) {
   return result;
 }
 
+static uint16_t clampU16(uint32_t value) {
+  return value > UINT16_MAX ? UINT16_MAX : value;
+}
+
+static void updateHeap(void) {
+  const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+  sysLoadHeap_t heap = latestHeap;
+
+  heap.freeSize = heap_caps_get_free_size(caps);
+  heap.minFreeSize = heap_caps_get_minimum_free_size(caps);
+  heap.largestBlock = heap_caps_get_largest_free_block(caps);
+  if (heap.minLargestBlock == 0 || heap.largestBlock < heap.minLargestBlock) {
+    heap.minLargestBlock = heap.largestBlock;
+  }
+  uint32_t failures = __atomic_load_n(&allocFailures, __ATOMIC_RELAXED);
+  heap.lastFailedSize = __atomic_load_n(&lastFailedSize, __ATOMIC_RELAXED);
+
+  if (failures != heap.allocFailures) {
+    DEBUG_PRINTW("%"PRIu32" allocations failed, the last of %"PRIu32" bytes, largest block %"PRIu32" of %"PRIu32" bytes free",
+                 failures - heap.allocFailures, heap.lastFailedSize, heap.largestBlock, heap.freeSize);
+  }
+  heap.allocFailures = failures;
+
+  // Warned once per crossing of the threshold
+  bool lowBlock = heap.largestBlock < SYSLOAD_HEAP_LOW_BLOCK;
+  if (lowBlock && !lowBlockWarned) {
+    DEBUG_PRINTW("Heap fragmented, largest block %"PRIu32" of %"PRIu32" bytes free", heap.largestBlock, heap.freeSize);
+  }
+  lowBlockWarned = lowBlock;
+
+  portENTER_CRITICAL(&latestMux);
+  latestHeap = heap;
+  portEXIT_CRITICAL(&latestMux);
+}
+
 static void timerHandler(xTimerHandle timer) {
-  if (triggerDump != 0) {
-    uint32_t totalRunTime;
+  uint32_t totalRunTime;
 
-    TaskStatus_t taskStats[TASK_MAX_COUNT];
-    uint32_t taskCount = uxTaskGetSystemState(taskStats, TASK_MAX_COUNT, &totalRunTime);
-    ASSERT(taskCount < TASK_MAX_COUNT);
+  updateHeap();
 
-    uint32_t totalDelta = totalRunTime - previousTotalRunTime;
-    float f = 100.0 / totalDelta;
+  TaskStatus_t taskStats[TASK_MAX_COUNT];
+  uint32_t taskCount = uxTaskGetSystemState(taskStats, TASK_MAX_COUNT, &totalRunTime);
+  ASSERT(taskCount < TASK_MAX_COUNT);
 
-    // Dumps the the CPU load and stack usage for all tasks
-    // CPU usage is since last dump in % compared to total time spent in tasks. Note that time spent in interrupts will be included in measured time.
-    // Stack usage is displayed as nr of unused bytes at peak stack usage.
+  uint32_t totalDelta = totalRunTime - previousTotalRunTime;
+  float f = 100.0f / totalDelta;
+
+  // CPU usage is over the last period in % compared to total time spent in tasks. Note that time spent in interrupts will be included in measured time.
+  // Stack usage is the nr of unused bytes at peak stack usage.
+  // Static, the timer task stack already holds taskStats and the dump prints
+  static sysLoadTask_t tasks[TASK_MAX_COUNT];
+  for (uint32_t i = 0; i < taskCount; i++) {
+    TaskStatus_t* stats = &taskStats[i];
+    taskData_t* previousTaskData = getPreviousTaskData(stats->xTaskNumber);
+
+    uint32_t taskRunTime = stats->ulRunTimeCounter;
+    float load = f * (taskRunTime - previousTaskData->ulRunTimeCounter);
+
+    strncpy(tasks[i].name, stats->pcTaskName, SYSLOAD_TASK_NAME_LEN - 1);
+    tasks[i].name[SYSLOAD_TASK_NAME_LEN - 1] = '\0';
+    tasks[i].load = clampU16((uint32_t)(load * 100.0f + 0.5f));
+    tasks[i].stackLeft = clampU16(stats->usStackHighWaterMark);
+    tasks[i].priority = stats->uxBasePriority;
 
+    previousTaskData->ulRunTimeCounter = taskRunTime;
+  }
+  previousTotalRunTime = totalRunTime;
+
+  portENTER_CRITICAL(&latestMux);
+  memcpy(latestTasks, tasks, taskCount * sizeof(sysLoadTask_t));
+  latestTaskCount = taskCount;
+  latestTimestamp = usecTimestamp();
+  portEXIT_CRITICAL(&latestMux);
+
+  if (triggerDump != 0) {
+    // Dumps the the CPU load and stack usage for all tasks
     DEBUG_PRINTI("Task dump");
     DEBUG_PRINTI("Load\tStack left\tName\tPRI");
     for (uint32_t i = 0; i < taskCount; i++) {
-      TaskStatus_t* stats = &taskStats[i];
-      taskData_t* previousTaskData = getPreviousTaskData(stats->xTaskNumber);
-
-      uint32_t taskRunTime = stats->ulRunTimeCounter;
-      float load = f * (taskRunTime - previousTaskData->ulRunTimeCounter);
-      DEBUG_PRINTI("%.2f \t%"PRIu32" \t%s \t%d", (double)load, stats->usStackHighWaterMark, stats->pcTaskName,stats->uxBasePriority);
-
-      previousTaskData->ulRunTimeCounter = taskRunTime;
+      DEBUG_PRINTI("%.2f \t%"PRIu32" \t%s \t%d", (double)(tasks[i].load / 100.0f),
+                   taskStats[i].usStackHighWaterMark, taskStats[i].pcTaskName, taskStats[i].uxBasePriority);
     }
 
-    DEBUG_PRINTI("Free heap: %"PRIu32" bytes", xPortGetFreeHeapSize());
-    previousTotalRunTime = totalRunTime;
+    DEBUG_PRINTI("Free heap: %"PRIu32" bytes, largest block %"PRIu32" bytes", latestHeap.freeSize, latestHeap.largestBlock);
 
     triggerDump = 0;
   }
 }
 
+int sysLoadGetTasks(sysLoadTask_t tasks[], int maxTasks, uint64_t *timestamp) {
+  portENTER_CRITICAL(&latestMux);
+  int count = latestTaskCount < maxTasks ? latestTaskCount : maxTasks;
+  memcpy(tasks, latestTasks, count * sizeof(sysLoadTask_t));
+  *timestamp = latestTimestamp;
+  portEXIT_CRITICAL(&latestMux);
+
+  return count;
+}
+
+void sysLoadGetHeap(sysLoadHeap_t *heap) {
+  portENTER_CRITICAL(&latestMux);
+  *heap = latestHeap;
+  portEXIT_CRITICAL(&latestMux);
+}
+
+LOG_GROUP_START(heap)
+LOG_ADD(LOG_UINT32, free, &latestHeap.freeSize)
+LOG_ADD(LOG_UINT32, minFree, &latestHeap.minFreeSize)
+LOG_ADD(LOG_UINT32, largest, &latestHeap.largestBlock)
+LOG_ADD(LOG_UINT32, minLargest, &latestHeap.minLargestBlock)
+LOG_ADD(LOG_UINT32, allocFail, &latestHeap.allocFailures)
+LOG_GROUP_STOP(heap)
 
 PARAM_GROUP_START(system)
 PARAM_ADD(PARAM_UINT8, taskDump, &triggerDump)
@@ -42,7 +42,7 @@
 #include "config.h"
 #include "system.h"
 #include "platform.h"
-//#include "storage.h"
+#include "storage.h"
 #include "configblock.h"
 #include "worker.h"
 #include "freeRTOSdebug.h"
@@ -59,9 +59,12 @@
 //#include "proximity.h"
 //#include "watchdog.h"
 #include "queuemonitor.h"
+#include "event_trace.h"
 #include "buzzer.h"
 #include "sound.h"
 #include "sysload.h"
+#include "dsp_bench.h"
+#include "boot_profile.h"
 #include "estimator_kalman.h"
 //#include "deck.h"
 //#include "extrx.h"
@@ -70,7 +73,7 @@
 #define DEBUG_MODULE "SYS"
 #include "debug_cf.h"
 #include "static_mem.h"
-//#include "peer_localization.h"
+#include "peer_localization.h"
 #include "cfassert.h"
 
 #include "drone_telemetry.h"
@@ -101,7 +104,7 @@ static void systemTask(void *arg);
 /* Public functions */
 void systemLaunch(void)
 {
-  STATIC_MEM_TASK_CREATE(systemTask, systemTask, SYSTEM_TASK_NAME, NULL, SYSTEM_TASK_PRI);
+  STATIC_MEM_TASK_CREATE_PINNED(systemTask, systemTask, SYSTEM_TASK_NAME, NULL, SYSTEM_TASK_PRI, SYSTEM_TASK_CORE);
 }
 
 // This must be the first module to be initialized!
@@ -118,6 +121,8 @@ void systemInit(void)
 
   wifilinkInit();
   sysLoadInit();
+  eventTraceInit();
+  dspBenchInit();
 
   /* Initialized here so that DEBUG_PRINT (buffered) can be used early */
   debugInit();
@@ -138,13 +143,13 @@ void systemInit(void)
               *((int*)(MCU_ID_ADDRESS+0)), *((short*)(MCU_FLASH_SIZE_ADDRESS)));*/
 
   configblockInit();
-  //storageInit();
+  storageInit();
   workerInit();
   adcInit();
   ledseqInit();
   pmInit();
   buzzerInit();
-//  peerLocalizationInit();
+  peerLocalizationInit();
 
 #ifdef APP_ENABLED
   appInit();
@@ -172,10 +177,12 @@ void systemTask(void *arg)
 {
   bool pass = true;
 
+  bootProfileMark(bootPhaseSystemTask);
   ledInit();
   ledSet(CHG_LED, 1);
+  // Brings up the access point in parallel to the init below, wifiTest()
+  // waits for it
   wifiInit();
-  vTaskDelay(M2T(500));
 
 #ifdef DEBUG_QUEUE_MONITOR
   queueMonitorInit();
@@ -190,8 +197,10 @@ void systemTask(void *arg)
 
   //Init the high-levels modules
   systemInit();
+  bootProfileMark(bootPhaseSystemInit);
   commInit();
   commanderInit();
+  bootProfileMark(bootPhaseComm);
 
   StateEstimatorType estimator = anyEstimator;
   estimatorKalmanTaskInit();
@@ -202,6 +211,7 @@ void systemTask(void *arg)
   //{
   //  platformSetLowInterferenceRadioMode();
   //}
+  bootProfileMark(bootPhaseFlight);
   soundInit();
   memInit();
 
@@ -216,7 +226,7 @@ void systemTask(void *arg)
   DEBUG_PRINTI("systemTest = %d ", pass);
   pass &= configblockTest();
   DEBUG_PRINTI("configblockTest = %d ", pass);
-  //pass &= storageTest();
+  pass &= storageTest();
   pass &= commTest();
   DEBUG_PRINTI("commTest = %d ", pass);
   pass &= commanderTest();
@@ -233,6 +243,7 @@ void systemTask(void *arg)
   //pass &= watchdogNormalStartTest();
   pass &= cfAssertNormalStartTest();
 //  pass &= peerLocalizationTest();
+  bootProfileMark(bootPhaseSelfTest);
 
   //Start the firmware
   if(pass)
@@ -246,6 +257,7 @@ void systemTask(void *arg)
 
     // Start telemetry
     startTelemetry();
+    bootProfileMark(bootPhaseTelemetryReady);
 
     // Capturing camera frames
     // startCapturingCamera();
@@ -275,6 +287,7 @@ void systemTask(void *arg)
       ledSet(SYS_LED, true);
     }
   }
+  bootProfilePrint();
   DEBUG_PRINT("Free heap: %"PRIu32" bytes\n", xPortGetFreeHeapSize());
 
   workerLoop();
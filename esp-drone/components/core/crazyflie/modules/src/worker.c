@@ -29,63 +29,177 @@
 
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
+#include "semphr.h"
 #include "queuemonitor.h"
-#include "static_mem.h"
+#include "log.h"
 
 #include "console.h"
 
-#define WORKER_QUEUE_LENGTH 5
+#define WORKER_QUEUE_LENGTH CONFIG_WORKER_QUEUE_LENGTH
+
+// Marks the end of a slot list
+#define NO_SLOT 0xFF
+
+#if WORKER_QUEUE_LENGTH >= NO_SLOT
+#error "CONFIG_WORKER_QUEUE_LENGTH must fit the uint8_t slot indexes"
+#endif
 
 struct worker_work {
   void (*function)(void*);
   void* arg;
+  uint8_t next;
 };
 
-static xQueueHandle workerQueue;
-STATIC_MEM_QUEUE_ALLOC(workerQueue, WORKER_QUEUE_LENGTH, sizeof(struct worker_work));
+// The slots are shared by the priorities: a free list, and one FIFO list of
+// pending work per priority
+static struct worker_work works[WORKER_QUEUE_LENGTH];
+static uint8_t freeFirst;
+static uint8_t pendingFirst[workerPriorityCount];
+static uint8_t pendingLast[workerPriorityCount];
+static uint16_t pendingCount;
+
+static uint16_t maxPending;
+static uint32_t coalescedCount;
+static uint32_t droppedCount[workerPriorityCount];
+
+static portMUX_TYPE workerMux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t workAvailable;
+static StaticSemaphore_t workAvailableBuffer;
+static bool isInit;
+#ifdef DEBUG_QUEUE_MONITOR
+static unsigned char workerQueueMonitor;
+#endif
 
 void workerInit()
 {
-  if (workerQueue)
+  if (isInit)
     return;
 
-  workerQueue = STATIC_MEM_QUEUE_CREATE(workerQueue);
-  DEBUG_QUEUE_MONITOR_REGISTER(workerQueue);
+  for (int i = 0; i < WORKER_QUEUE_LENGTH; i++) {
+    works[i].next = (i + 1 < WORKER_QUEUE_LENGTH) ? i + 1 : NO_SLOT;
+  }
+  freeFirst = 0;
+  for (int i = 0; i < workerPriorityCount; i++) {
+    pendingFirst[i] = NO_SLOT;
+    pendingLast[i] = NO_SLOT;
+  }
+
+  workAvailable = xSemaphoreCreateBinaryStatic(&workAvailableBuffer);
+  DEBUG_QUEUE_MONITOR_REGISTER_BUFFER(workerQueueMonitor, "workerQueue", WORKER_QUEUE_LENGTH);
+
+  isInit = true;
 }
 
 bool workerTest()
 {
-  return (workerQueue != NULL);
+  return isInit;
+}
+
+// Takes the oldest work of the highest priority out of its list
+static bool workerPop(struct worker_work *work)
+{
+  bool found = false;
+
+  portENTER_CRITICAL(&workerMux);
+  for (int priority = 0; priority < workerPriorityCount; priority++) {
+    uint8_t slot = pendingFirst[priority];
+    if (slot != NO_SLOT) {
+      *work = works[slot];
+      pendingFirst[priority] = works[slot].next;
+      if (pendingFirst[priority] == NO_SLOT)
+        pendingLast[priority] = NO_SLOT;
+      works[slot].next = freeFirst;
+      freeFirst = slot;
+      pendingCount--;
+      found = true;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&workerMux);
+
+  return found;
 }
 
 void workerLoop()
 {
   struct worker_work work;
 
-  if (!workerQueue)
+  if (!isInit)
     return;
 
   while (1)
   {
-    xQueueReceive(workerQueue, &work, portMAX_DELAY);
+    xSemaphoreTake(workAvailable, portMAX_DELAY);
 
-    if (work.function)
+    // Work scheduled while running is in the lists again, with the semaphore given
+    while (workerPop(&work))
       work.function(work.arg);
   }
 }
 
-int workerSchedule(void (*function)(void*), void *arg)
+int workerSchedulePriority(void (*function)(void*), void *arg, workerPriority_t priority)
 {
-  struct worker_work work;
-
   if (!function)
     return ENOEXEC;
+  if (priority >= workerPriorityCount)
+    return EINVAL;
+
+  int result = 0;
+  bool coalesced = false;
+
+  portENTER_CRITICAL(&workerMux);
+  // The same work pending at the same or a higher priority runs once
+  for (int p = 0; p <= priority && !coalesced; p++) {
+    for (uint8_t slot = pendingFirst[p]; slot != NO_SLOT; slot = works[slot].next) {
+      if (works[slot].function == function && works[slot].arg == arg) {
+        coalesced = true;
+        break;
+      }
+    }
+  }
+
+  if (coalesced) {
+    coalescedCount++;
+  } else if (freeFirst == NO_SLOT) {
+    droppedCount[priority]++;
+    result = ENOMEM;
+  } else {
+    uint8_t slot = freeFirst;
+    freeFirst = works[slot].next;
+    works[slot].function = function;
+    works[slot].arg = arg;
+    works[slot].next = NO_SLOT;
+    if (pendingLast[priority] == NO_SLOT)
+      pendingFirst[priority] = slot;
+    else
+      works[pendingLast[priority]].next = slot;
+    pendingLast[priority] = slot;
+
+    pendingCount++;
+    if (pendingCount > maxPending)
+      maxPending = pendingCount;
+  }
+  uint16_t waiting = pendingCount;
+  portEXIT_CRITICAL(&workerMux);
 
-  work.function = function;
-  work.arg = arg;
-  if (xQueueSend(workerQueue, &work, 0) == pdFALSE)
-    return ENOMEM;
+  DEBUG_QUEUE_MONITOR_RECORD(workerQueueMonitor, waiting, result == 0);
+  if (result != 0)
+    return result;
 
+  xSemaphoreGive(workAvailable);
   return 0;
 }
+
+int workerSchedule(void (*function)(void*), void *arg)
+{
+  return workerSchedulePriority(function, arg, workerPriorityNormal);
+}
+
+LOG_GROUP_START(worker)
+LOG_ADD(LOG_UINT16, pending, &pendingCount)
+LOG_ADD(LOG_UINT16, maxPending, &maxPending)
+LOG_ADD(LOG_UINT32, coalesced, &coalescedCount)
+LOG_ADD(LOG_UINT32, dropHigh, &droppedCount[workerPriorityHigh])
+LOG_ADD(LOG_UINT32, dropNormal, &droppedCount[workerPriorityNormal])
+LOG_ADD(LOG_UINT32, dropLow, &droppedCount[workerPriorityLow])
+LOG_GROUP_STOP(worker)
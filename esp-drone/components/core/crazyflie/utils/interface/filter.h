@@ -47,6 +47,35 @@ void lpf2pSetCutoffFreq(lpf2pData* lpfData, float sample_freq, float cutoff_freq
 float lpf2pApply(lpf2pData* lpfData, float sample);
 float lpf2pReset(lpf2pData* lpfData, float sample);
 
+/**
+ * Sets a 2-pole notch at center_freq, of quality factor q, in a biquad run
+ * with lpf2pApply(). The delay elements are kept, so the notch can be moved
+ * while filtering without a transient.
+ */
+void notch2pSetCenterFreq(lpf2pData* data, float sample_freq, float center_freq, float q);
+
+#define LPF2P_BANK_MAX_CHANNELS 6
+
+/**
+ * 2-pole low pass filters of the same cutoff frequency run on several
+ * channels, for instance the three axes of a sensor. The coefficients are
+ * shared and the delay elements stored per channel, so one call filters all
+ * channels with the same arithmetic as lpf2pApply() on each.
+ */
+typedef struct {
+  float a1;
+  float a2;
+  float b0;
+  float b1;
+  float b2;
+  uint8_t channels;
+  float delay_element_1[LPF2P_BANK_MAX_CHANNELS];
+  float delay_element_2[LPF2P_BANK_MAX_CHANNELS];
+} lpf2pBank;
+
+void lpf2pBankInit(lpf2pBank* bank, uint8_t channels, float sample_freq, float cutoff_freq);
+void lpf2pBankApply(lpf2pBank* bank, float* samples);
+
 /** Second order low pass filter structure.
  *
  * using biquad filter with bilinear z transform
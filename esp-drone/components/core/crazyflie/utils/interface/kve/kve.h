@@ -35,6 +35,20 @@
 
 void kveDefrag(kveMemory_t *kve);
 
+/**
+ * Compact the table by a bounded amount of work: the items following the
+ * first hole are moved over it, at least one item and then as many as fit
+ * in maxLength bytes.
+ *
+ * Return true if an item was moved, false if there was no hole left to fill.
+ */
+bool kveDefragStep(kveMemory_t *kve, size_t maxLength);
+
+/**
+ * Get the bytes taken by holes in the table and the bytes free after its end.
+ */
+void kveGetSpace(kveMemory_t *kve, size_t *holeLength, size_t *freeLength);
+
 bool kveStore(kveMemory_t *kve, char* key, const void* buffer, size_t length);
 
 size_t kveFetch(kveMemory_t *kve, const char* key, void* buffer, size_t bufferLength);
@@ -28,11 +28,32 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+// Slots of the index, a power of two. Filled to 3/4 at most.
+#define KVE_INDEX_SLOTS 128
+
+/**
+ * In-RAM index of the item addresses by key hash. Built by the first access
+ * to the table, then kept up to date by the kve functions, so that a key is
+ * found without scanning the table. When more keys than the index holds are
+ * stored, the keys left out are found by scanning, until the next rebuild.
+ */
+typedef struct {
+    bool built;
+    bool overflow;
+    uint16_t count;
+    uint16_t hash[KVE_INDEX_SLOTS];
+    uint16_t address[KVE_INDEX_SLOTS];
+} kveIndex_t;
 
 typedef struct {
     size_t memorySize;
     size_t (*read)(size_t address, void* data, size_t length);
     size_t (*write)(size_t address, const void* data, size_t length);
     void (*flush)(void);
+    // Optional, NULL to scan the table on each access. Only used for memories of less than 64 kB.
+    kveIndex_t *index;
 } kveMemory_t;
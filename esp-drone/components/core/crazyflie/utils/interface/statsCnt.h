@@ -22,12 +22,14 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  *
  *
- * statsCnt.h - utitlity for logging rates
+ * statsCnt.h - utitlity for logging rates, costs and latencies
  */
 
 #pragma once
 
 #include <stdint.h>
+#include "FreeRTOS.h"
+#include "usec_time.h"
 #include "log.h"
 
 /**
@@ -122,3 +124,184 @@ void statsCntRateLoggerInit(statsCntRateLogger_t* logger, uint32_t averagingInte
  * @return float The latest calculated rate
  */
 float statsCntRateLogHandler(uint32_t timestamp, void* data);
+
+
+// Cost counters ----------------------------------------------------------------
+
+/**
+ * @brief A struct used to track the cost, in CPU cycles, of a section of code.
+ * The min, average and max of the samples are published every interval.
+ *
+ * The cycle counter is per core: a task migrating to the other core while
+ * being measured gives an outlier. The ESP32-S2 has a single core.
+ */
+typedef struct {
+    uint32_t start;
+    uint32_t count;
+    uint64_t sum;
+    uint32_t min;
+    uint32_t max;
+    uint32_t latestAveragingMs;
+    uint32_t intervalMs;
+
+    uint32_t latestMin;
+    uint32_t latestAvg;
+    uint32_t latestMax;
+} statsCntCostCounter_t;
+
+/**
+ * @brief Initialize a statsCntCostCounter_t struct.
+ *
+ * @param counter The cost counter to initialize
+ * @param averagingIntervalMs The interval (in ms) between publications of min/avg/max
+ */
+void statsCntCostCounterInit(statsCntCostCounter_t* counter, uint32_t averagingIntervalMs);
+
+/**
+ * @brief Add a sample to a cost counter, and publish min/avg/max if the time since
+ * the previous publication is longer than the configured interval time.
+ *
+ * @param counter The cost counter to update
+ * @param cycles Cost of the sample, in CPU cycles
+ */
+void statsCntCostCounterAdd(statsCntCostCounter_t* counter, uint32_t cycles);
+
+/**
+ * @return The CPU cycle counter of the current core
+ */
+static inline uint32_t statsCntCycles(void) {
+    return usecCycles();
+}
+
+#define STATS_CNT_COST_DEFINE(NAME, INTERVAL_MS) statsCntCostCounter_t NAME = {.intervalMs = (INTERVAL_MS), .min = UINT32_MAX}
+
+/**
+ * @brief Macros to measure a section of code. STATS_CNT_COST_STOP() adds the cycles
+ * elapsed since STATS_CNT_COST_START() as a sample.
+ *
+ * @param COUNTER A pointer to a statsCntCostCounter_t
+ */
+#define STATS_CNT_COST_START(COUNTER) ((COUNTER)->start = statsCntCycles())
+#define STATS_CNT_COST_STOP(COUNTER) statsCntCostCounterAdd(COUNTER, statsCntCycles() - (COUNTER)->start)
+
+/**
+ * @brief Macro to add the min/avg/max of a statsCntCostCounter_t as NAMEMin, NAMEAvg
+ * and NAMEMax logs, in CPU cycles. Used in a similar way as LOG_ADD() in a
+ * LOG_GROUP_START() - LOG_GROUP_STOP() block
+ *
+ * @param COUNTER A pointer to a statsCntCostCounter_t
+ */
+#define STATS_CNT_COST_LOG_ADD(NAME, COUNTER) \
+  LOG_ADD(LOG_UINT32, NAME##Min, &(COUNTER)->latestMin) \
+  LOG_ADD(LOG_UINT32, NAME##Avg, &(COUNTER)->latestAvg) \
+  LOG_ADD(LOG_UINT32, NAME##Max, &(COUNTER)->latestMax)
+
+
+// Latency counters -------------------------------------------------------------
+
+#define STATS_CNT_LATENCY_BINS 32
+
+/**
+ * @brief A struct used to track the distribution of a latency, or any other
+ * unsigned sample, in the unit of the caller (us, CPU cycles...). The min, average,
+ * max, median and 99th percentile of the samples are published every interval.
+ *
+ * The percentiles come from a histogram of STATS_CNT_LATENCY_BINS bins of binWidth,
+ * they are the upper edge of the bin they fall in. Samples beyond the last bin are
+ * counted apart, a percentile falling there is reported as the max. Samples can be
+ * added from any task or ISR, the counter is protected by a spinlock.
+ */
+typedef struct {
+    portMUX_TYPE lock;
+    uint32_t binWidth;
+    uint32_t intervalMs;
+
+    uint32_t count;
+    uint64_t sum;
+    uint32_t min;
+    uint32_t max;
+    // The last bin counts the samples beyond the histogram
+    uint32_t bins[STATS_CNT_LATENCY_BINS + 1];
+    uint32_t latestAveragingMs;
+
+    uint32_t latestMin;
+    uint32_t latestAvg;
+    uint32_t latestMax;
+    uint32_t latestP50;
+    uint32_t latestP99;
+} statsCntLatencyCounter_t;
+
+/**
+ * @brief Initialize a statsCntLatencyCounter_t struct.
+ *
+ * @param counter The latency counter to initialize
+ * @param averagingIntervalMs The interval (in ms) between publications of the statistics
+ * @param binWidth Width of the histogram bins, in the unit of the samples
+ */
+void statsCntLatencyCounterInit(statsCntLatencyCounter_t* counter, uint32_t averagingIntervalMs, uint32_t binWidth);
+
+/**
+ * @brief Add a sample to a latency counter. Callable from ISRs.
+ *
+ * @param counter The latency counter to update
+ * @param sample The sample, in the unit of binWidth
+ */
+void statsCntLatencyCounterAdd(statsCntLatencyCounter_t* counter, uint32_t sample);
+
+/**
+ * @brief The statistics of the samples added since the previous publication are
+ * published if the time since then is longer than the configured interval time.
+ *
+ * @param counter The latency counter to update
+ * @param now_ms Current system time in ms
+ */
+void statsCntLatencyCounterUpdate(statsCntLatencyCounter_t* counter, uint32_t now_ms);
+
+/**
+ * @brief Struct to use a latency counter together with the log system, one
+ * logByFunction_t per published value.
+ */
+typedef struct {
+    statsCntLatencyCounter_t counter;
+    logByFunction_t logMin;
+    logByFunction_t logAvg;
+    logByFunction_t logMax;
+    logByFunction_t logP50;
+    logByFunction_t logP99;
+} statsCntLatencyLogger_t;
+
+uint32_t statsCntLatencyLogMin(uint32_t timestamp, void* data);
+uint32_t statsCntLatencyLogAvg(uint32_t timestamp, void* data);
+uint32_t statsCntLatencyLogMax(uint32_t timestamp, void* data);
+uint32_t statsCntLatencyLogP50(uint32_t timestamp, void* data);
+uint32_t statsCntLatencyLogP99(uint32_t timestamp, void* data);
+
+#define STATS_CNT_LATENCY_DEFINE(NAME, INTERVAL_MS, BIN_WIDTH) statsCntLatencyLogger_t NAME = { \
+    .counter = {.lock = portMUX_INITIALIZER_UNLOCKED, .binWidth = (BIN_WIDTH), .intervalMs = (INTERVAL_MS), .min = UINT32_MAX}, \
+    .logMin = {.data = &NAME.counter, .acquireUInt32 = statsCntLatencyLogMin}, \
+    .logAvg = {.data = &NAME.counter, .acquireUInt32 = statsCntLatencyLogAvg}, \
+    .logMax = {.data = &NAME.counter, .acquireUInt32 = statsCntLatencyLogMax}, \
+    .logP50 = {.data = &NAME.counter, .acquireUInt32 = statsCntLatencyLogP50}, \
+    .logP99 = {.data = &NAME.counter, .acquireUInt32 = statsCntLatencyLogP99}}
+
+/**
+ * @brief Macro to add a sample to a statsCntLatencyLogger_t
+ *
+ * @param LOGGER A pointer to a statsCntLatencyLogger_t
+ * @param SAMPLE The sample, in the unit of the bin width
+ */
+#define STATS_CNT_LATENCY_SAMPLE(LOGGER, SAMPLE) statsCntLatencyCounterAdd(&(LOGGER)->counter, SAMPLE)
+
+/**
+ * @brief Macro to add the statistics of a statsCntLatencyLogger_t as NAMEMin, NAMEAvg,
+ * NAMEMax, NAMEP50 and NAMEP99 logs, in the unit of the samples. Used in a similar
+ * way as LOG_ADD() in a LOG_GROUP_START() - LOG_GROUP_STOP() block
+ *
+ * @param LOGGER A pointer to a statsCntLatencyLogger_t
+ */
+#define STATS_CNT_LATENCY_LOG_ADD(NAME, LOGGER) \
+  LOG_ADD_BY_FUNCTION(LOG_UINT32, NAME##Min, &(LOGGER)->logMin) \
+  LOG_ADD_BY_FUNCTION(LOG_UINT32, NAME##Avg, &(LOGGER)->logAvg) \
+  LOG_ADD_BY_FUNCTION(LOG_UINT32, NAME##Max, &(LOGGER)->logMax) \
+  LOG_ADD_BY_FUNCTION(LOG_UINT32, NAME##P50, &(LOGGER)->logP50) \
+  LOG_ADD_BY_FUNCTION(LOG_UINT32, NAME##P99, &(LOGGER)->logP99)
@@ -8,12 +8,13 @@ typedef void (*tdoaEngineSendTdoaToEstimator)(tdoaMeasurement_t* tdoaMeasurement
 
 typedef struct {
   // State
-  tdaoAnchorInfoArray_t anchorInfoArray;
+  tdoaAnchorStorage_t anchorStorage;
   tdoaStats_t stats;
 
   // Configuration
   tdoaEngineSendTdoaToEstimator sendTdoaToEstimator;
   double locodeckTsFreq;
+  float metersPerTick;  // Distance light travels in a locodeck timestamp tick
 } tdoaEngineState_t;
 
 void tdoaEngineInit(tdoaEngineState_t* state, const uint32_t now_ms, tdoaEngineSendTdoaToEstimator sendTdoaToEstimator, const double locodeckTsFreq);
@@ -39,7 +39,13 @@ typedef struct {
   tdoaRemoteAnchorData_t remoteAnchorData[REMOTE_ANCHOR_DATA_COUNT];
 } tdoaAnchorInfo_t;
 
-typedef tdoaAnchorInfo_t tdaoAnchorInfoArray_t[ANCHOR_STORAGE_COUNT];
+// The anchor slots, and the slot of each anchor id so that an anchor is
+// found without searching the slots
+typedef struct {
+  tdoaAnchorInfo_t anchorInfo[ANCHOR_STORAGE_COUNT];
+  uint8_t slotOfAnchor[256]; // Slot + 1 of the anchor id, 0 if not in storage
+  uint8_t usedSlots; // Slots are used in order and never freed
+} tdoaAnchorStorage_t;
 
 
 // The anchor context is used to pass information about an anchor as well as
@@ -51,12 +57,12 @@ typedef struct {
 } tdoaAnchorContext_t;
 
 
-void tdoaStorageInitialize(tdoaAnchorInfo_t anchorStorage[]);
+void tdoaStorageInitialize(tdoaAnchorStorage_t* anchorStorage);
 
-bool tdoaStorageGetCreateAnchorCtx(tdoaAnchorInfo_t anchorStorage[], const uint8_t anchor, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx);
-bool tdoaStorageGetAnchorCtx(tdoaAnchorInfo_t anchorStorage[], const uint8_t anchor, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx);
-uint8_t tdoaStorageGetListOfAnchorIds(tdoaAnchorInfo_t anchorStorage[], uint8_t unorderedAnchorList[], const int maxListSize);
-uint8_t tdoaStorageGetListOfActiveAnchorIds(tdoaAnchorInfo_t anchorStorage[], uint8_t unorderedAnchorList[], const int maxListSize, const uint32_t currentTime_ms);
+bool tdoaStorageGetCreateAnchorCtx(tdoaAnchorStorage_t* anchorStorage, const uint8_t anchor, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx);
+bool tdoaStorageGetAnchorCtx(tdoaAnchorStorage_t* anchorStorage, const uint8_t anchor, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx);
+uint8_t tdoaStorageGetListOfAnchorIds(tdoaAnchorStorage_t* anchorStorage, uint8_t unorderedAnchorList[], const int maxListSize);
+uint8_t tdoaStorageGetListOfActiveAnchorIds(tdoaAnchorStorage_t* anchorStorage, uint8_t unorderedAnchorList[], const int maxListSize, const uint32_t currentTime_ms);
 
 uint8_t tdoaStorageGetId(const tdoaAnchorContext_t* anchorCtx);
 int64_t tdoaStorageGetRxTime(const tdoaAnchorContext_t* anchorCtx);
@@ -75,6 +81,6 @@ int64_t tdoaStorageGetTimeOfFlight(const tdoaAnchorContext_t* anchorCtx, const u
 void tdoaStorageSetTimeOfFlight(tdoaAnchorContext_t* anchorCtx, const uint8_t remoteAnchor, const int64_t tof);
 
 // Mainly for test
-bool tdoaStorageIsAnchorInStorage(tdoaAnchorInfo_t anchorStorage[], const uint8_t anchor);
+bool tdoaStorageIsAnchorInStorage(tdoaAnchorStorage_t* anchorStorage, const uint8_t anchor);
 
 #endif // __TDOA_STORAGE_H__
@@ -8,6 +8,23 @@
 #define CLOCK_CORRECTION_FILTER 0.1
 #define CLOCK_CORRECTION_BUCKET_MAX 4
 
+#if CLOCK_CORRECTION_FIXED_POINT
+#define CLOCK_CORRECTION_ONE (1LL << CLOCK_CORRECTION_FRACTION_BITS)
+// Ratio constant in Q32.32, folded at compile time
+#define CLOCK_CORRECTION_VALUE(ratio) ((int64_t)((ratio) * (double)CLOCK_CORRECTION_ONE))
+#define CLOCK_CORRECTION_FILTER_Q16 ((int64_t)(CLOCK_CORRECTION_FILTER * 65536))
+#else
+#define CLOCK_CORRECTION_VALUE(ratio) (ratio)
+#endif
+
+static double toRatio(const clockCorrection_t value) {
+#if CLOCK_CORRECTION_FIXED_POINT
+  return (double)value / CLOCK_CORRECTION_ONE;
+#else
+  return value;
+#endif
+}
+
 /**
  Logging all the clock correction information requires scaling the values repeatedly, which is computer intense. Thus, the logging functionality is enabled at compile time with the CLOCK_CORRECTION_ENABLE_LOGGING flag.
  */
@@ -30,7 +47,23 @@ static float scaleValueForLogging(double value) {
  Obtains the clock correction from a clockCorrectionStorage_t object. This is the recommended public API to obtain the clock correction, instead of getting it directly from the storage object.
  */
 double clockCorrectionEngineGet(const clockCorrectionStorage_t* storage) {
-  return storage->clockCorrection;
+  return toRatio(storage->clockCorrection);
+}
+
+/**
+ Converts a duration measured by clock x to the clock of reference, with the clock correction of a clockCorrectionStorage_t object. This is the recommended way to apply the clock correction, it never goes through double arithmetic on targets without a double precision FPU.
+
+ @param ticks_in_cl_x A duration measured by clock x, less than 2^33 ticks
+ @return The duration measured by the clock of reference
+ */
+int64_t clockCorrectionEngineApply(const clockCorrectionStorage_t* storage, const int64_t ticks_in_cl_x) {
+#if CLOCK_CORRECTION_FIXED_POINT
+  // ticks * (1 + deviation): the deviation stays within the spec, a few tens of ppm, so the product fits
+  const int64_t deviation = storage->clockCorrection - CLOCK_CORRECTION_ONE;
+  return ticks_in_cl_x + ((ticks_in_cl_x * deviation) >> CLOCK_CORRECTION_FRACTION_BITS);
+#else
+  return ticks_in_cl_x * storage->clockCorrection;
+#endif
 }
 
 /**
@@ -71,39 +104,64 @@ static bool emptyClockCorrectionBucket(clockCorrectionStorage_t* storage) {
  @param mask A mask as long as the number of bits used to represent the timestamps. Used to calculate a valid timestamp, even if wrapped arounds of the time counter happened at some point
  @return The necessary clock correction to apply to timestamps measured by clock x, in order to obtain their value like if the measurement was done by the reference clock. Or -1 if it was not possible to perform the computation. Example: timestamp_in_cl_reference = clockCorrection * timestamp_in_cl_x
  */
-double clockCorrectionEngineCalculate(const uint64_t new_t_in_cl_reference, const uint64_t old_t_in_cl_reference, const uint64_t new_t_in_cl_x, const uint64_t old_t_in_cl_x, const uint64_t mask) {
-  const uint64_t tickCount_in_cl_reference = truncateTimeStamp(new_t_in_cl_reference - old_t_in_cl_reference, mask);
-  const uint64_t tickCount_in_cl_x = truncateTimeStamp(new_t_in_cl_x - old_t_in_cl_x, mask);
+clockCorrection_t clockCorrectionEngineCalculate(const uint64_t new_t_in_cl_reference, const uint64_t old_t_in_cl_reference, const uint64_t new_t_in_cl_x, const uint64_t old_t_in_cl_x, const uint64_t mask) {
+  uint64_t tickCount_in_cl_reference = truncateTimeStamp(new_t_in_cl_reference - old_t_in_cl_reference, mask);
+  uint64_t tickCount_in_cl_x = truncateTimeStamp(new_t_in_cl_x - old_t_in_cl_x, mask);
+
+#if CLOCK_CORRECTION_FIXED_POINT
+  // The count of reference must fit in 32 bits to be shifted to Q32.32, the ratio is kept
+  while (tickCount_in_cl_reference > UINT32_MAX) {
+    tickCount_in_cl_reference >>= 1;
+    tickCount_in_cl_x >>= 1;
+  }
+#endif
 
   if (tickCount_in_cl_x == 0) {
-    return -1;
+    return CLOCK_CORRECTION_VALUE(-1);
   }
 
+#if CLOCK_CORRECTION_FIXED_POINT
+  const uint64_t ratio = (tickCount_in_cl_reference << CLOCK_CORRECTION_FRACTION_BITS) / tickCount_in_cl_x;
+  return ratio > INT64_MAX ? INT64_MAX : (int64_t)ratio;
+#else
   return (double)tickCount_in_cl_reference / (double)tickCount_in_cl_x;
+#endif
+}
+
+/**
+ Simple low pass filter of the clock correction.
+ */
+static clockCorrection_t filterClockCorrection(const clockCorrection_t current, const clockCorrection_t candidate) {
+#if CLOCK_CORRECTION_FIXED_POINT
+  // Within the accepted noise, the difference is a few hundred units at most
+  return current + (((candidate - current) * (65536 - CLOCK_CORRECTION_FILTER_Q16)) >> 16);
+#else
+  return current * CLOCK_CORRECTION_FILTER + candidate * (1.0 - CLOCK_CORRECTION_FILTER);
+#endif
 }
 
 /**
  Updates the clock correction only if the provided value follows certain conditions. This is used to discard wrong clock correction measurements.
  @return True if the provided clock correction sample ir reliable, false otherwise. A sample is reliable when it is in the accepted noise level (which means that we already have two or more samples that are similar) and has been LP filtered.
  */
-bool clockCorrectionEngineUpdate(clockCorrectionStorage_t* storage, const double clockCorrectionCandidate) {
+bool clockCorrectionEngineUpdate(clockCorrectionStorage_t* storage, const clockCorrection_t clockCorrectionCandidate) {
   bool sampleIsReliable = false;
 
-  const double currentClockCorrection = storage->clockCorrection;
-  const double difference = clockCorrectionCandidate - currentClockCorrection;
+  const clockCorrection_t currentClockCorrection = storage->clockCorrection;
+  const clockCorrection_t difference = clockCorrectionCandidate - currentClockCorrection;
+  const clockCorrection_t acceptedNoise = CLOCK_CORRECTION_VALUE(CLOCK_CORRECTION_ACCEPTED_NOISE);
 
 #ifdef CLOCK_CORRECTION_ENABLE_LOGGING
-  logMinAcceptedNoiseLimit = scaleValueForLogging(currentClockCorrection - CLOCK_CORRECTION_ACCEPTED_NOISE);
-  logMaxAcceptedNoiseLimit = scaleValueForLogging(currentClockCorrection + CLOCK_CORRECTION_ACCEPTED_NOISE);
+  logMinAcceptedNoiseLimit = scaleValueForLogging(toRatio(currentClockCorrection) - CLOCK_CORRECTION_ACCEPTED_NOISE);
+  logMaxAcceptedNoiseLimit = scaleValueForLogging(toRatio(currentClockCorrection) + CLOCK_CORRECTION_ACCEPTED_NOISE);
   logMinSpecLimit = scaleValueForLogging(CLOCK_CORRECTION_SPEC_MIN);
   logMaxSpecLimit = scaleValueForLogging(CLOCK_CORRECTION_SPEC_MAX);
-  logClockCorrection = scaleValueForLogging(currentClockCorrection);
-  logClockCorrectionCandidate = scaleValueForLogging(clockCorrectionCandidate);
+  logClockCorrection = scaleValueForLogging(toRatio(currentClockCorrection));
+  logClockCorrectionCandidate = scaleValueForLogging(toRatio(clockCorrectionCandidate));
 #endif
 
-  if (-CLOCK_CORRECTION_ACCEPTED_NOISE < difference && difference < CLOCK_CORRECTION_ACCEPTED_NOISE) {
-    // Simple low pass filter
-    const double newClockCorrection = currentClockCorrection * CLOCK_CORRECTION_FILTER + clockCorrectionCandidate * (1.0 - CLOCK_CORRECTION_FILTER);
+  if (-acceptedNoise < difference && difference < acceptedNoise) {
+    const clockCorrection_t newClockCorrection = filterClockCorrection(currentClockCorrection, clockCorrectionCandidate);
 
     sampleIsReliable = true;
     fillClockCorrectionBucket(storage);
@@ -111,7 +169,7 @@ bool clockCorrectionEngineUpdate(clockCorrectionStorage_t* storage, const double
   } else {
     const bool shouldAcceptANewClockReference = emptyClockCorrectionBucket(storage);
     if (shouldAcceptANewClockReference) {
-      if (CLOCK_CORRECTION_SPEC_MIN < clockCorrectionCandidate && clockCorrectionCandidate < CLOCK_CORRECTION_SPEC_MAX) {
+      if (CLOCK_CORRECTION_VALUE(CLOCK_CORRECTION_SPEC_MIN) < clockCorrectionCandidate && clockCorrectionCandidate < CLOCK_CORRECTION_VALUE(CLOCK_CORRECTION_SPEC_MAX)) {
         // We do not fill the bucket and accept the clock correction sample as reliable: a sample is reliable when it is in the accepted noise level (which means that we already have two or more samples that are similar) and has been LP filtered. See: https://github.com/bitcraze/crazyflie-firmware/pull/328
         storage->clockCorrection = clockCorrectionCandidate;
       }
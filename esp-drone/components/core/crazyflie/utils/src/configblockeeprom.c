@@ -37,6 +37,17 @@
 #include "configblock.h"
 #include "eeprom.h"
 
+#ifdef CONFIG_STORAGE_NVS
+#include "nvs.h"
+
+/**
+ * The ESP32 boards have no EEPROM, the config block is mirrored as a NVS
+ * blob. A valid mirror is used at boot without touching the I2C bus.
+ */
+#define CONFIGBLOCK_NVS_NAMESPACE "configblock"
+#define CONFIGBLOCK_NVS_KEY "cb"
+#endif
+
 
 /* Internal format of the config block */
 #define MAGIC 0x43427830
@@ -99,12 +110,22 @@ static const uint32_t configblockSizes[] =
 static bool isInit = false;
 static bool cb_ok = false;
 
+#ifdef CONFIG_STORAGE_NVS
+// The block as last read from or written to NVS, the same block is not written again
+static configblock_t configblockSaved;
+static bool configblockSavedIsValid = false;
+#endif
+
 static bool configblockCheckMagic(configblock_t *configblock);
 static bool configblockCheckVersion(configblock_t *configblock);
 static bool configblockCheckChecksum(configblock_t *configblock);
 static bool configblockCheckDataIntegrity(uint8_t *data, uint8_t version);
 static bool configblockWrite(configblock_t *configblock);
 static bool configblockCopyToNewVersion(configblock_t *configblockSaved, configblock_t *configblockNew);
+#ifdef CONFIG_STORAGE_NVS
+static bool configblockReadNvs(configblock_t *configblock);
+static bool configblockWriteNvs(configblock_t *configblock);
+#endif
 
 static uint8_t calculate_cksum(void* data, size_t len)
 {
@@ -123,6 +144,19 @@ int configblockInit(void)
   if(isInit)
     return 0;
 
+#ifdef CONFIG_STORAGE_NVS
+  if (configblockReadNvs(&configblock) &&
+      configblockCheckMagic(&configblock) &&
+      configblockCheckVersion(&configblock) &&
+      configblockCheckChecksum(&configblock))
+  {
+    DEBUG_PRINTD("v%d from NVS, verification [OK]\n", configblock.version);
+    cb_ok = true;
+    isInit = true;
+    return 0;
+  }
+#endif
+
   i2cdevInit(I2C1_DEV);
   eepromInit(I2C1_DEV);
 
@@ -144,6 +178,9 @@ int configblockInit(void)
             // Everything is fine
             DEBUG_PRINTD("v%d, verification [OK]\n", configblock.version);
             cb_ok = true;
+#ifdef CONFIG_STORAGE_NVS
+            configblockWriteNvs(&configblock);
+#endif
           }
           else
           {
@@ -239,13 +276,67 @@ static bool configblockWrite(configblock_t *configblock)
 {
   // Write default configuration to eeprom
   configblock->cksum = calculate_cksum(configblock, sizeof(configblock_t) - 1);
+#ifdef CONFIG_STORAGE_NVS
+  return configblockWriteNvs(configblock);
+#else
   if (!eepromWriteBuffer((uint8_t *)configblock, 0, sizeof(configblock_t)))
   {
     return false;
   }
 
   return true;
+#endif
+}
+
+#ifdef CONFIG_STORAGE_NVS
+static bool configblockReadNvs(configblock_t *configblock)
+{
+  nvs_handle_t handle;
+  size_t length = sizeof(configblock_t);
+  bool status = false;
+
+  if (nvs_open(CONFIGBLOCK_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+    status = (nvs_get_blob(handle, CONFIGBLOCK_NVS_KEY, configblock, &length) == ESP_OK &&
+              length == sizeof(configblock_t));
+    nvs_close(handle);
+  }
+
+  if (status) {
+    memcpy(&configblockSaved, configblock, sizeof(configblock_t));
+    configblockSavedIsValid = true;
+  }
+
+  return status;
+}
+
+static bool configblockWriteNvs(configblock_t *configblock)
+{
+  nvs_handle_t handle;
+  bool status = false;
+
+  if (configblockSavedIsValid && memcmp(&configblockSaved, configblock, sizeof(configblock_t)) == 0) {
+    return true;
+  }
+
+  if (nvs_open(CONFIGBLOCK_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+    DEBUG_PRINT("Error: cannot open NVS!\n");
+    return false;
+  }
+
+  status = (nvs_set_blob(handle, CONFIGBLOCK_NVS_KEY, configblock, sizeof(configblock_t)) == ESP_OK &&
+            nvs_commit(handle) == ESP_OK);
+  nvs_close(handle);
+
+  if (status) {
+    memcpy(&configblockSaved, configblock, sizeof(configblock_t));
+    configblockSavedIsValid = true;
+  } else {
+    DEBUG_PRINT("Error: cannot save config block to NVS!\n");
+  }
+
+  return status;
 }
+#endif
 
 static bool configblockCopyToNewVersion(configblock_t *configblockSaved, configblock_t *configblockNew)
 {
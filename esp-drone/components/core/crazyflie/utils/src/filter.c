@@ -107,3 +107,71 @@ float lpf2pReset(lpf2pData* lpfData, float sample)
   lpfData->delay_element_2 = dval;
   return lpf2pApply(lpfData, sample);
 }
+
+/**
+ * 2-pole notch filter, in the form of lpf2pData
+ */
+void notch2pSetCenterFreq(lpf2pData* data, float sample_freq, float center_freq, float q)
+{
+  float omega = 2.0f*M_PI_F*center_freq/sample_freq;
+  float cs = cosf(omega);
+  float alpha = sinf(omega)/(2.0f*q);
+  float a0 = 1.0f+alpha;
+  data->b0 = 1.0f/a0;
+  data->b1 = -2.0f*cs/a0;
+  data->b2 = data->b0;
+  data->a1 = data->b1;
+  data->a2 = (1.0f-alpha)/a0;
+}
+
+/**
+ * 2-pole low pass filter bank
+ */
+void lpf2pBankInit(lpf2pBank* bank, uint8_t channels, float sample_freq, float cutoff_freq)
+{
+  if (bank == NULL || cutoff_freq <= 0.0f || channels > LPF2P_BANK_MAX_CHANNELS) {
+    return;
+  }
+
+  float fr = sample_freq/cutoff_freq;
+  float ohm = tanf(M_PI_F/fr);
+  float c = 1.0f+2.0f*cosf(M_PI_F/4.0f)*ohm+ohm*ohm;
+  bank->b0 = ohm*ohm/c;
+  bank->b1 = 2.0f*bank->b0;
+  bank->b2 = bank->b0;
+  bank->a1 = 2.0f*(ohm*ohm-1.0f)/c;
+  bank->a2 = (1.0f-2.0f*cosf(M_PI_F/4.0f)*ohm+ohm*ohm)/c;
+  bank->channels = channels;
+  for (int i = 0; i < channels; i++) {
+    bank->delay_element_1[i] = 0.0f;
+    bank->delay_element_2[i] = 0.0f;
+  }
+}
+
+/**
+ * Filters one sample of each channel of the bank, in place.
+ */
+void lpf2pBankApply(lpf2pBank* bank, float* samples)
+{
+  const float a1 = bank->a1;
+  const float a2 = bank->a2;
+  const float b0 = bank->b0;
+  const float b1 = bank->b1;
+  const float b2 = bank->b2;
+
+  for (int i = 0; i < bank->channels; i++) {
+    float delay_element_1 = bank->delay_element_1[i];
+    float delay_element_2 = bank->delay_element_2[i];
+
+    float delay_element_0 = samples[i] - delay_element_1 * a1 - delay_element_2 * a2;
+    if (!isfinite(delay_element_0)) {
+      // don't allow bad values to propigate via the filter
+      delay_element_0 = samples[i];
+    }
+
+    samples[i] = delay_element_0 * b0 + delay_element_1 * b1 + delay_element_2 * b2;
+
+    bank->delay_element_2[i] = delay_element_1;
+    bank->delay_element_1[i] = delay_element_0;
+  }
+}
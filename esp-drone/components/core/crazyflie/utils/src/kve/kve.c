@@ -2,7 +2,7 @@
 #include "kve/kve.h"
 #include "kve/kve_storage.h"
 
-#include "debug.h"
+#include "debug_cf.h"
 
 #include <stdbool.h>
 #include <string.h>
@@ -22,6 +22,156 @@ static size_t min(size_t a, size_t b)
     }
 }
 
+// Index of the item addresses, open addressing with linear probing
+
+#define INDEX_EMPTY (0xffffu)
+#define INDEX_MASK (KVE_INDEX_SLOTS - 1)
+#define INDEX_MAX_COUNT (KVE_INDEX_SLOTS * 3 / 4)
+
+#if (KVE_INDEX_SLOTS & INDEX_MASK) != 0
+#error "KVE_INDEX_SLOTS must be a power of two"
+#endif
+
+static bool indexUsable(kveMemory_t *kve) {
+    return kve->index != NULL && kve->memorySize <= INDEX_EMPTY;
+}
+
+// FNV-1a, folded to 16 bits
+static uint16_t keyHash(const char* key, size_t keyLength) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < keyLength; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+    }
+    return (hash >> 16) ^ (hash & 0xffff);
+}
+
+static bool itemHasKey(kveMemory_t *kve, size_t address, const char* key, size_t keyLength) {
+    char itemKey[255];
+    kveItemHeader_t header = kveStorageGetItemInfo(kve, address);
+
+    if (header.key_length != keyLength) {
+        return false;
+    }
+    kveStorageGetKey(kve, address, header, itemKey, keyLength);
+    return memcmp(itemKey, key, keyLength) == 0;
+}
+
+// Slot of the key, or -1 if it is not in the index
+static int indexFindSlot(kveMemory_t *kve, const char* key, size_t keyLength, uint16_t hash) {
+    kveIndex_t *index = kve->index;
+    int slot = hash & INDEX_MASK;
+
+    while (index->address[slot] != INDEX_EMPTY) {
+        if (index->hash[slot] == hash && itemHasKey(kve, index->address[slot], key, keyLength)) {
+            return slot;
+        }
+        slot = (slot + 1) & INDEX_MASK;
+    }
+    return -1;
+}
+
+static void indexInsert(kveIndex_t *index, uint16_t hash, size_t address) {
+    if (index->count >= INDEX_MAX_COUNT) {
+        index->overflow = true;
+        return;
+    }
+
+    int slot = hash & INDEX_MASK;
+    while (index->address[slot] != INDEX_EMPTY) {
+        slot = (slot + 1) & INDEX_MASK;
+    }
+    index->hash[slot] = hash;
+    index->address[slot] = address;
+    index->count++;
+}
+
+// Empties the slot and moves up the following entries of the probe sequence
+// that would not be found anymore
+static void indexRemove(kveIndex_t *index, int slot) {
+    int hole = slot;
+    int next = slot;
+
+    while (true) {
+        next = (next + 1) & INDEX_MASK;
+        if (index->address[next] == INDEX_EMPTY) {
+            break;
+        }
+        int home = index->hash[next] & INDEX_MASK;
+        // The entry stays if its home slot is cyclically after the hole
+        bool stays = (hole <= next) ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!stays) {
+            index->hash[hole] = index->hash[next];
+            index->address[hole] = index->address[next];
+            hole = next;
+        }
+    }
+    index->address[hole] = INDEX_EMPTY;
+    index->count--;
+}
+
+static void indexBuild(kveMemory_t *kve) {
+    kveIndex_t *index = kve->index;
+    char key[255];
+    size_t address = FIRST_ITEM_ADDRESS;
+
+    memset(index->address, 0xff, sizeof(index->address));
+    index->count = 0;
+    index->overflow = false;
+
+    while (address < (kve->memorySize - 3)) {
+        kveItemHeader_t header = kveStorageGetItemInfo(kve, address);
+        if (header.full_length == END_TAG) {
+            break;
+        }
+        if (header.full_length < sizeof(header)) {
+            // Corrupted table, let the scans deal with it
+            index->overflow = true;
+            break;
+        }
+
+        if (header.key_length != 0) {
+            kveStorageGetKey(kve, address, header, key, header.key_length);
+            uint16_t hash = keyHash(key, header.key_length);
+            // A duplicated key is found at its first item, as by a scan
+            if (indexFindSlot(kve, key, header.key_length, hash) < 0) {
+                indexInsert(index, hash, address);
+            }
+        }
+        address += header.full_length;
+    }
+
+    index->built = true;
+}
+
+// Address of the item of the key, and its index slot or -1
+static size_t findItem(kveMemory_t *kve, const char* key, int *slot) {
+    *slot = -1;
+    if (!indexUsable(kve)) {
+        return kveStorageFindItemByKey(kve, FIRST_ITEM_ADDRESS, key);
+    }
+
+    if (!kve->index->built) {
+        indexBuild(kve);
+    }
+
+    size_t keyLength = strlen(key);
+    *slot = indexFindSlot(kve, key, keyLength, keyHash(key, keyLength));
+    if (*slot >= 0) {
+        return kve->index->address[*slot];
+    }
+    if (kve->index->overflow) {
+        return kveStorageFindItemByKey(kve, FIRST_ITEM_ADDRESS, key);
+    }
+    return KVE_STORAGE_INVALID_ADDRESS;
+}
+
+static void indexAdd(kveMemory_t *kve, const char* key, size_t address) {
+    // An index not built yet is built from the table, with this item
+    if (indexUsable(kve) && kve->index->built) {
+        indexInsert(kve->index, keyHash(key, strlen(key)), address);
+    }
+}
+
 // Utility function
 static bool appendItemToEnd(kveMemory_t *kve, size_t address, const char* key, const void* buffer, size_t length) {
     size_t itemAddress = kveStorageFindEnd(kve, address);
@@ -35,6 +185,7 @@ static bool appendItemToEnd(kveMemory_t *kve, size_t address, const char* key, c
 
     // Test that there is enough space to write the item
     if ((itemAddress + sizeof(kveItemHeader_t) + strlen(key) + length + END_TAG_LENDTH) < kve->memorySize) {
+        indexAdd(kve, key, itemAddress);
         itemAddress += kveStorageWriteItem(kve, itemAddress, key, buffer, length);
         kveStorageWriteEnd(kve, itemAddress);
     } else {
@@ -44,6 +195,7 @@ static bool appendItemToEnd(kveMemory_t *kve, size_t address, const char* key, c
         itemAddress = kveStorageFindEnd(kve, FIRST_ITEM_ADDRESS);
 
         if ((itemAddress + sizeof(kveItemHeader_t) + strlen(key) + length + END_TAG_LENDTH) < kve->memorySize) {
+            indexAdd(kve, key, itemAddress);
             itemAddress += kveStorageWriteItem(kve, itemAddress, key, buffer, length);
             kveStorageWriteEnd(kve, itemAddress);
         } else {
@@ -87,13 +239,94 @@ void kveDefrag(kveMemory_t *kve) {
 
         holeAddress = holeAddress + lenghtToMove;
     }
+
+    // The items moved, the index is rebuilt by the next access
+    if (kve->index != NULL) {
+        kve->index->built = false;
+    }
+}
+
+bool kveDefragStep(kveMemory_t *kve, size_t maxLength) {
+    size_t holeAddress = kveStorageFindHole(kve, FIRST_ITEM_ADDRESS);
+
+    // The search can stop on the end tag if the byte after it is 0
+    if (KVE_STORAGE_IS_VALID(holeAddress) == false ||
+        kveStorageGetItemInfo(kve, holeAddress).full_length == END_TAG) {
+        return false;
+    }
+
+    size_t itemAddress = kveStorageFindNextItem(kve, holeAddress);
+    if (KVE_STORAGE_IS_VALID(itemAddress) == false) {
+        // This hole is at the end, lets crop it
+        kveStorageWriteEnd(kve, holeAddress);
+        return false;
+    }
+
+    // Take the items up to the next hole or the end, at least one and then
+    // as many as fit in maxLength
+    size_t groupEnd = itemAddress;
+    while (true) {
+        kveItemHeader_t header = kveStorageGetItemInfo(kve, groupEnd);
+        if (header.full_length == END_TAG || header.key_length == 0) {
+            break;
+        }
+        if (groupEnd > itemAddress && (groupEnd + header.full_length - itemAddress) > maxLength) {
+            break;
+        }
+        groupEnd += header.full_length;
+    }
+
+    size_t lengthToMove = groupEnd - itemAddress;
+    size_t holeLength = itemAddress - holeAddress;
+
+    kveStorageMoveMemory(kve, itemAddress, holeAddress, lengthToMove);
+    kveStorageWriteHole(kve, holeAddress + lengthToMove, holeLength);
+
+    // Only the moved items changed address
+    if (indexUsable(kve) && kve->index->built) {
+        kveIndex_t *index = kve->index;
+        for (int slot = 0; slot < KVE_INDEX_SLOTS; slot++) {
+            if (index->address[slot] != INDEX_EMPTY &&
+                index->address[slot] >= itemAddress && index->address[slot] < groupEnd) {
+                index->address[slot] -= holeLength;
+            }
+        }
+    } else if (kve->index != NULL) {
+        kve->index->built = false;
+    }
+
+    return true;
+}
+
+void kveGetSpace(kveMemory_t *kve, size_t *holeLength, size_t *freeLength) {
+    size_t address = FIRST_ITEM_ADDRESS;
+
+    *holeLength = 0;
+    *freeLength = 0;
+
+    while (address < (kve->memorySize - 2)) {
+        kveItemHeader_t header = kveStorageGetItemInfo(kve, address);
+        if (header.full_length == END_TAG) {
+            *freeLength = kve->memorySize - address - END_TAG_LENDTH;
+            return;
+        }
+        if (header.full_length < sizeof(header)) {
+            // Corrupted table
+            return;
+        }
+        if (header.key_length == 0) {
+            *holeLength += header.full_length;
+        }
+        address += header.full_length;
+    }
 }
 
 bool kveStore(kveMemory_t *kve, char* key, const void* buffer, size_t length) {
     size_t itemAddress;
+    int slot;
 
     // Search if the key is already present in the table
-    itemAddress = kveStorageFindItemByKey(kve, FIRST_ITEM_ADDRESS, key);
+    itemAddress = findItem(kve, key, &slot);
     if (KVE_STORAGE_IS_VALID(itemAddress) == false) {
         // Item does not exit, find the end of the table to insert it
         return appendItemToEnd(kve, FIRST_ITEM_ADDRESS, key, buffer, length);
@@ -104,6 +337,9 @@ bool kveStore(kveMemory_t *kve, char* key, const void* buffer, size_t length) {
         if (currentItem.full_length != newLength) {
             // If not, delete the item and find the end of the table
             kveStorageWriteHole(kve, itemAddress, currentItem.full_length);
+            if (slot >= 0) {
+                indexRemove(kve->index, slot);
+            }
             return appendItemToEnd(kve, FIRST_ITEM_ADDRESS, key, buffer, length);
         } else {
             kveStorageWriteItem(kve, itemAddress, key, buffer, length);
@@ -116,7 +352,8 @@ bool kveStore(kveMemory_t *kve, char* key, const void* buffer, size_t length) {
 
 size_t kveFetch(kveMemory_t *kve, const char* key, void* buffer, size_t bufferLength)
 {
-    size_t itemAddress = kveStorageFindItemByKey(kve, FIRST_ITEM_ADDRESS, key);
+    int slot;
+    size_t itemAddress = findItem(kve, key, &slot);
 
     if (KVE_STORAGE_IS_VALID(itemAddress)) {
         kveItemHeader_t header = kveStorageGetItemInfo(kve, itemAddress);
@@ -128,11 +365,15 @@ size_t kveFetch(kveMemory_t *kve, const char* key, void* buffer, size_t bufferLe
 }
 
 bool kveDelete(kveMemory_t *kve, char* key) {
-    size_t itemAddress = kveStorageFindItemByKey(kve, FIRST_ITEM_ADDRESS, key);
+    int slot;
+    size_t itemAddress = findItem(kve, key, &slot);
 
     if (KVE_STORAGE_IS_VALID(itemAddress)) {
         kveItemHeader_t itemInfo = kveStorageGetItemInfo(kve, itemAddress);
         kveStorageWriteHole(kve, itemAddress, itemInfo.full_length);
+        if (slot >= 0) {
+            indexRemove(kve->index, slot);
+        }
         return true;
     }
 
@@ -143,6 +384,10 @@ void kveFormat(kveMemory_t *kve) {
     uint8_t version = KVE_VERSION;
     kve->write(VERSION_ADDRESS, &version, 1);
     kveStorageWriteEnd(kve, FIRST_ITEM_ADDRESS);
+
+    if (kve->index != NULL) {
+        kve->index->built = false;
+    }
 }
 
 bool kveCheck(kveMemory_t *kve) {
@@ -40,8 +40,6 @@ static size_t min(size_t a, size_t b)
     }
 }
 
-#define END_TAG (0xffffu)
-
 int kveStorageWriteItem(kveMemory_t *kve, size_t address, const char* key, const void* buffer, size_t length)
 {
   kveItemHeader_t header;
@@ -107,7 +105,8 @@ size_t kveStorageFindItemByKey(kveMemory_t *kve, size_t address, const char * ke
 
     while (currentAddress < (kve->memorySize - 3)) {
         kve->read(currentAddress, searchBuffer, 3);
-        length = searchBuffer[0] + (searchBuffer[1]<<8);
+        // Unsigned bytes, a sign extended length never matches the end tag
+        length = (uint8_t)searchBuffer[0] + ((uint8_t)searchBuffer[1] << 8);
         keyLength = searchBuffer[2];
 
         if (length == END_TAG) {
@@ -125,18 +125,23 @@ void lighthouseGeometryGetBaseStationPosition(baseStationGeometry_t* bs, vec3d b
 }
 
 void lighthouseGeometryGetRay(const baseStationGeometry_t* baseStationGeometry, const float angleH, const float angleV, vec3d ray) {
-    vec3d a = {arm_sin_f32(angleH), -arm_cos_f32(angleH), 0};  // Normal vector to X plane
-    vec3d b = {-arm_sin_f32(angleV), 0, arm_cos_f32(angleV)};  // Normal vector to Y plane
-
-    vec3d raw_ray = {};
-    vec_cross_product(b, a, raw_ray); // Intersection of two planes -> ray vector.
-    float len = vec_length(raw_ray);
-    arm_scale_f32(raw_ray, 1 / len, raw_ray, vec3d_size); // Normalize raw ray length.
-
-    arm_matrix_instance_f32 source_rotation_matrix = {3, 3, (float32_t *)baseStationGeometry->mat};
-    arm_matrix_instance_f32 ray_vec = {3, 1, raw_ray};
-    arm_matrix_instance_f32 ray_rotated_vec = {3, 1, ray};
-    arm_mat_mult_f32(&source_rotation_matrix, &ray_vec, &ray_rotated_vec);
+    const float sinH = arm_sin_f32(angleH);
+    const float cosH = arm_cos_f32(angleH);
+    const float sinV = arm_sin_f32(angleV);
+    const float cosV = arm_cos_f32(angleV);
+
+    // Intersection of the planes of normals a = (sinH, -cosH, 0) and
+    // b = (-sinV, 0, cosV), the cross product b x a written out
+    vec3d raw_ray = {cosV * cosH, cosV * sinH, sinV * cosH};
+
+    // |b x a|^2 = cosV^2 + sinV^2 * cosH^2, normalize with one division
+    const float lengthInv = 1.0f / sqrtf(cosV * cosV + sinV * sinV * cosH * cosH);
+
+    // Rotate with the base station matrix, unrolled
+    const float (*R)[3] = baseStationGeometry->mat;
+    for (int i = 0; i < 3; i++) {
+        ray[i] = (R[i][0] * raw_ray[0] + R[i][1] * raw_ray[1] + R[i][2] * raw_ray[2]) * lengthInv;
+    }
 }
 
 bool lighthouseGeometryIntersectionPlaneVector(const vec3d linePoint, const vec3d lineVec, const vec3d planePoint, const vec3d PlaneNormal, vec3d intersectionPoint) {
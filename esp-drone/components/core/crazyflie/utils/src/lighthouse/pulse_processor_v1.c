@@ -194,18 +194,21 @@ static bool processPreviousFrame(pulseProcessor_t *state, pulseProcessorResult_t
   bool anglesMeasured = false;
 
   if (state->sweepDataStored) {
+    // The frame is the same for all the sensors, the angle of a sweep is
+    // then one multiplication of its integer delta
+    const float frameWidth = state->frameWidth[state->currentBaseStation][state->currentAxis];
+    const float center = frameWidth/4.0f;
+    const float scale = 2*(float)M_PI/frameWidth;
+
     for (size_t sensor = 0; sensor < PULSE_PROCESSOR_N_SENSORS; sensor++) {
       if (state->sweeps[sensor].state == sweepStorageStateValid) {
         int delta = TS_DIFF(state->sweeps[sensor].timestamp, state->currentSync);
         if (delta < FRAME_LENGTH) {
-          float frameWidth = state->frameWidth[state->currentBaseStation][state->currentAxis];
-
           if ((frameWidth < FRAME_WIDTH_MIN) || (frameWidth > FRAME_WIDTH_MAX)) {
             return false;
           }
 
-          float center = frameWidth/4.0f;
-          float angle = (delta - center)*2*(float)M_PI/frameWidth;
+          float angle = (delta - center)*scale;
 
           *baseStation = state->currentBaseStation;
           *axis = state->currentAxis;
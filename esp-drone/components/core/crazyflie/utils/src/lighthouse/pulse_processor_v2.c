@@ -169,27 +169,26 @@ static bool processFrame(const pulseProcessorFrame_t* frameData, pulseProcessorV
     return result;
 }
 
-static void calculateAzimuthElevation(const float firstBeam, const float secondBeam, float* angles) {
+// The beam offsets are kept in timer ticks, summed and subtracted as integers,
+// and scaled to radians once, by scale = 2 * pi / period
+static void calculateAzimuthElevation(const uint32_t firstOffset, const uint32_t secondOffset, const float scale, float* angles) {
     const float a120 = M_PI_F * 120.0f / 180.0f;
     const float tan_p_2 = 0.5773502691896258f;   // tan(60 / 2)
 
-    angles[0] = ((firstBeam + secondBeam) / 2.0f) - M_PI_F;
-    float beta = (secondBeam - firstBeam) - a120;
-    angles[1] = atan(sinf(beta / 2.0f) / tan_p_2);
+    angles[0] = (float)(firstOffset + secondOffset) * (scale / 2.0f) - M_PI_F;
+    float beta = (float)(int32_t)(secondOffset - firstOffset) * scale - a120;
+    angles[1] = atanf(sinf(beta / 2.0f) / tan_p_2);
 }
 
 static void calculateAngles(const pulseProcessorV2SweepBlock_t* latestBlock, const pulseProcessorV2SweepBlock_t* previousBlock, pulseProcessorResult_t* angles) {
     const uint8_t channel = latestBlock->channel;
+    const float scale = 2 * M_PI_F / CYCLE_PERIODS[channel];
 
     for (int i = 0; i < PULSE_PROCESSOR_N_SENSORS; i++) {
         uint32_t firstOffset = previousBlock->offset[i];
         uint32_t secondOffset = latestBlock->offset[i];
-        uint32_t period = CYCLE_PERIODS[channel];
 
-        float firstBeam = firstOffset * 2 * M_PI_F / period;
-        float secondBeam = secondOffset * 2 * M_PI_F / period;
-
-        calculateAzimuthElevation(firstBeam, secondBeam, angles->sensorMeasurements[i].baseStatonMeasurements[channel].angles);
+        calculateAzimuthElevation(firstOffset, secondOffset, scale, angles->sensorMeasurements[i].baseStatonMeasurements[channel].angles);
         angles->sensorMeasurements[i].baseStatonMeasurements[channel].validCount = 2;
     }
 }
@@ -22,12 +22,18 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  *
  *
- * statsCnt.c - utitlity for logging rates
+ * statsCnt.c - utitlity for logging rates, costs and latencies
  */
 
+#include <string.h>
+
 #include "statsCnt.h"
 #include "debug_cf.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32_legacy.h"
+
 
 void statsCntRateCounterInit(statsCntRateCounter_t* counter, uint32_t averagingIntervalMs) {
     counter->intervalMs = averagingIntervalMs;
@@ -63,3 +69,148 @@ float statsCntRateLogHandler(uint32_t timestamp, void* data) {
     statsCntRateLogger_t* logger = (statsCntRateLogger_t*)data;
     return statsCntRateCounterUpdate(&logger->rateCounter, timestamp);
 }
+
+void statsCntCostCounterInit(statsCntCostCounter_t* counter, uint32_t averagingIntervalMs) {
+    counter->intervalMs = averagingIntervalMs;
+    counter->count = 0;
+    counter->sum = 0;
+    counter->min = UINT32_MAX;
+    counter->max = 0;
+    counter->latestAveragingMs = 0;
+    counter->latestMin = 0;
+    counter->latestAvg = 0;
+    counter->latestMax = 0;
+}
+
+void statsCntCostCounterAdd(statsCntCostCounter_t* counter, uint32_t cycles) {
+    counter->count++;
+    counter->sum += cycles;
+    if (cycles < counter->min) {
+        counter->min = cycles;
+    }
+    if (cycles > counter->max) {
+        counter->max = cycles;
+    }
+
+    uint32_t now_ms = T2M(xTaskGetTickCount());
+    if (now_ms - counter->latestAveragingMs > counter->intervalMs) {
+        counter->latestMin = counter->min;
+        counter->latestAvg = counter->sum / counter->count;
+        counter->latestMax = counter->max;
+
+        counter->count = 0;
+        counter->sum = 0;
+        counter->min = UINT32_MAX;
+        counter->max = 0;
+        counter->latestAveragingMs = now_ms;
+    }
+}
+
+void statsCntLatencyCounterInit(statsCntLatencyCounter_t* counter, uint32_t averagingIntervalMs, uint32_t binWidth) {
+    memset(counter, 0, sizeof(*counter));
+    portMUX_INITIALIZE(&counter->lock);
+    counter->binWidth = binWidth;
+    counter->intervalMs = averagingIntervalMs;
+    counter->min = UINT32_MAX;
+}
+
+void statsCntLatencyCounterAdd(statsCntLatencyCounter_t* counter, uint32_t sample) {
+    uint32_t bin = sample / counter->binWidth;
+    if (bin > STATS_CNT_LATENCY_BINS) {
+        bin = STATS_CNT_LATENCY_BINS;
+    }
+
+    portENTER_CRITICAL_SAFE(&counter->lock);
+    counter->count++;
+    counter->sum += sample;
+    if (sample < counter->min) {
+        counter->min = sample;
+    }
+    if (sample > counter->max) {
+        counter->max = sample;
+    }
+    counter->bins[bin]++;
+    portEXIT_CRITICAL_SAFE(&counter->lock);
+}
+
+// Upper edge of the bin holding the sample of the given rank, clamped to the
+// observed range
+static uint32_t latencyPercentile(const uint32_t* bins, uint32_t count, uint32_t binWidth,
+                                  uint32_t min, uint32_t max, uint32_t percent) {
+    uint32_t rank = ((uint64_t)count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int bin = 0; bin < STATS_CNT_LATENCY_BINS; bin++) {
+        seen += bins[bin];
+        if (seen >= rank) {
+            uint32_t edge = (bin + 1) * binWidth - 1;
+            return edge < min ? min : (edge > max ? max : edge);
+        }
+    }
+    return max;
+}
+
+void statsCntLatencyCounterUpdate(statsCntLatencyCounter_t* counter, uint32_t now_ms) {
+    if (now_ms - counter->latestAveragingMs <= counter->intervalMs) {
+        return;
+    }
+
+    // The percentiles are computed on a copy, the ISRs only wait for the copy
+    uint32_t bins[STATS_CNT_LATENCY_BINS + 1];
+    portENTER_CRITICAL_SAFE(&counter->lock);
+    uint32_t count = counter->count;
+    uint64_t sum = counter->sum;
+    uint32_t min = counter->min;
+    uint32_t max = counter->max;
+    memcpy(bins, counter->bins, sizeof(bins));
+    counter->count = 0;
+    counter->sum = 0;
+    counter->min = UINT32_MAX;
+    counter->max = 0;
+    memset(counter->bins, 0, sizeof(counter->bins));
+    portEXIT_CRITICAL_SAFE(&counter->lock);
+
+    counter->latestAveragingMs = now_ms;
+    if (count == 0) {
+        counter->latestMin = 0;
+        counter->latestAvg = 0;
+        counter->latestMax = 0;
+        counter->latestP50 = 0;
+        counter->latestP99 = 0;
+        return;
+    }
+    counter->latestMin = min;
+    counter->latestAvg = sum / count;
+    counter->latestMax = max;
+    counter->latestP50 = latencyPercentile(bins, count, counter->binWidth, min, max, 50);
+    counter->latestP99 = latencyPercentile(bins, count, counter->binWidth, min, max, 99);
+}
+
+uint32_t statsCntLatencyLogMin(uint32_t timestamp, void* data) {
+    statsCntLatencyCounter_t* counter = (statsCntLatencyCounter_t*)data;
+    statsCntLatencyCounterUpdate(counter, timestamp);
+    return counter->latestMin;
+}
+
+uint32_t statsCntLatencyLogAvg(uint32_t timestamp, void* data) {
+    statsCntLatencyCounter_t* counter = (statsCntLatencyCounter_t*)data;
+    statsCntLatencyCounterUpdate(counter, timestamp);
+    return counter->latestAvg;
+}
+
+uint32_t statsCntLatencyLogMax(uint32_t timestamp, void* data) {
+    statsCntLatencyCounter_t* counter = (statsCntLatencyCounter_t*)data;
+    statsCntLatencyCounterUpdate(counter, timestamp);
+    return counter->latestMax;
+}
+
+uint32_t statsCntLatencyLogP50(uint32_t timestamp, void* data) {
+    statsCntLatencyCounter_t* counter = (statsCntLatencyCounter_t*)data;
+    statsCntLatencyCounterUpdate(counter, timestamp);
+    return counter->latestP50;
+}
+
+uint32_t statsCntLatencyLogP99(uint32_t timestamp, void* data) {
+    statsCntLatencyCounter_t* counter = (statsCntLatencyCounter_t*)data;
+    statsCntLatencyCounterUpdate(counter, timestamp);
+    return counter->latestP99;
+}
@@ -56,10 +56,11 @@ The implementation must handle
 #define MEASUREMENT_NOISE_STD 0.15f
 
 void tdoaEngineInit(tdoaEngineState_t* engineState, const uint32_t now_ms, tdoaEngineSendTdoaToEstimator sendTdoaToEstimator, const double locodeckTsFreq, const tdoaEngineMatchingAlgorithm_t matchingAlgorithm) {
-  tdoaStorageInitialize(engineState->anchorInfoArray);
+  tdoaStorageInitialize(&engineState->anchorStorage);
   tdoaStatsInit(&engineState->stats, now_ms);
   engineState->sendTdoaToEstimator = sendTdoaToEstimator;
   engineState->locodeckTsFreq = locodeckTsFreq;
+  engineState->metersPerTick = SPEED_OF_LIGHT / locodeckTsFreq;
   engineState->matchingAlgorithm = matchingAlgorithm;
 
   engineState->matching.offset = 0;
@@ -70,7 +71,7 @@ static uint64_t truncateToAnchorTimeStamp(uint64_t fullTimeStamp) {
   return fullTimeStamp & TRUNCATE_TO_ANCHOR_TS_BITMAP;
 }
 
-static void enqueueTDOA(const tdoaAnchorContext_t* anchorACtx, const tdoaAnchorContext_t* anchorBCtx, double distanceDiff, tdoaEngineState_t* engineState) {
+static void enqueueTDOA(const tdoaAnchorContext_t* anchorACtx, const tdoaAnchorContext_t* anchorBCtx, float distanceDiff, tdoaEngineState_t* engineState) {
   tdoaStats_t* stats = &engineState->stats;
 
   tdoaMeasurement_t tdoa = {
@@ -101,7 +102,7 @@ static bool updateClockCorrection(tdoaAnchorContext_t* anchorCtx, const int64_t
   const int64_t latest_txAn_in_cl_An = tdoaStorageGetTxTime(anchorCtx);
 
   if (latest_rxAn_by_T_in_cl_T != 0 && latest_txAn_in_cl_An != 0) {
-    double clockCorrectionCandidate = clockCorrectionEngineCalculate(rxAn_by_T_in_cl_T, latest_rxAn_by_T_in_cl_T, txAn_in_cl_An, latest_txAn_in_cl_An, TRUNCATE_TO_ANCHOR_TS_BITMAP);
+    clockCorrection_t clockCorrectionCandidate = clockCorrectionEngineCalculate(rxAn_by_T_in_cl_T, latest_rxAn_by_T_in_cl_T, txAn_in_cl_An, latest_txAn_in_cl_An, TRUNCATE_TO_ANCHOR_TS_BITMAP);
     sampleIsReliable = clockCorrectionEngineUpdate(tdoaStorageGetClockCorrectionStorage(anchorCtx), clockCorrectionCandidate);
 
     if (sampleIsReliable){
@@ -120,19 +121,20 @@ static int64_t calcTDoA(const tdoaAnchorContext_t* otherAnchorCtx, const tdoaAnc
 
   const int64_t tof_Ar_to_An_in_cl_An = tdoaStorageGetTimeOfFlight(anchorCtx, otherAnchorId);
   const int64_t rxAr_by_An_in_cl_An = tdoaStorageGetRemoteRxTime(anchorCtx, otherAnchorId);
-  const double clockCorrection = tdoaStorageGetClockCorrection(anchorCtx);
+  const clockCorrectionStorage_t* clockCorrection = tdoaStorageGetClockCorrectionStorage(anchorCtx);
 
   const int64_t rxAr_by_T_in_cl_T = tdoaStorageGetRxTime(otherAnchorCtx);
 
   const int64_t delta_txAr_to_txAn_in_cl_An = (tof_Ar_to_An_in_cl_An + truncateToAnchorTimeStamp(txAn_in_cl_An - rxAr_by_An_in_cl_An));
-  const int64_t timeDiffOfArrival_in_cl_T =  truncateToAnchorTimeStamp(rxAn_by_T_in_cl_T - rxAr_by_T_in_cl_T) - delta_txAr_to_txAn_in_cl_An  * clockCorrection;
+  const int64_t timeDiffOfArrival_in_cl_T =  truncateToAnchorTimeStamp(rxAn_by_T_in_cl_T - rxAr_by_T_in_cl_T) - clockCorrectionEngineApply(clockCorrection, delta_txAr_to_txAn_in_cl_An);
 
   return timeDiffOfArrival_in_cl_T;
 }
 
-static double calcDistanceDiff(const tdoaAnchorContext_t* otherAnchorCtx, const tdoaAnchorContext_t* anchorCtx, const int64_t txAn_in_cl_An, const int64_t rxAn_by_T_in_cl_T, const double locodeckTsFreq) {
+// The TDoA is a few thousand ticks, exact in single precision, so is its distance to a fraction of a mm
+static float calcDistanceDiff(const tdoaAnchorContext_t* otherAnchorCtx, const tdoaAnchorContext_t* anchorCtx, const int64_t txAn_in_cl_An, const int64_t rxAn_by_T_in_cl_T, const float metersPerTick) {
   const int64_t tdoa = calcTDoA(otherAnchorCtx, anchorCtx, txAn_in_cl_An, rxAn_by_T_in_cl_T);
-  return SPEED_OF_LIGHT * tdoa / locodeckTsFreq;
+  return (float)tdoa * metersPerTick;
 }
 
 static bool matchRandomAnchor(tdoaEngineState_t* engineState, tdoaAnchorContext_t* otherAnchorCtx, const tdoaAnchorContext_t* anchorCtx) {
@@ -148,7 +150,7 @@ static bool matchRandomAnchor(tdoaEngineState_t* engineState, tdoaAnchorContext_
   for (int i = engineState->matching.offset; i < (remoteCount + engineState->matching.offset); i++) {
     uint8_t index = i % remoteCount;
     const uint8_t candidateAnchorId = engineState->matching.id[index];
-    if (tdoaStorageGetCreateAnchorCtx(engineState->anchorInfoArray, candidateAnchorId, now_ms, otherAnchorCtx)) {
+    if (tdoaStorageGetCreateAnchorCtx(&engineState->anchorStorage, candidateAnchorId, now_ms, otherAnchorCtx)) {
       if (engineState->matching.seqNr[index] == tdoaStorageGetSeqNr(otherAnchorCtx) && tdoaStorageGetTimeOfFlight(anchorCtx, candidateAnchorId)) {
         return true;
       }
@@ -165,25 +167,27 @@ static bool matchYoungestAnchor(tdoaEngineState_t* engineState, tdoaAnchorContex
 
     uint32_t now_ms = anchorCtx->currentTime_ms;
     uint32_t youmgestUpdateTime = 0;
-    int bestId = -1;
+    tdoaAnchorInfo_t* bestAnchorInfo = 0;
 
+    // One pass over the remote data of the anchor, the contexts are direct lookups
     for (int index = 0; index < remoteCount; index++) {
       const uint8_t candidateAnchorId = engineState->matching.id[index];
       if (tdoaStorageGetTimeOfFlight(anchorCtx, candidateAnchorId)) {
-        if (tdoaStorageGetCreateAnchorCtx(engineState->anchorInfoArray, candidateAnchorId, now_ms, otherAnchorCtx)) {
+        if (tdoaStorageGetCreateAnchorCtx(&engineState->anchorStorage, candidateAnchorId, now_ms, otherAnchorCtx)) {
           uint32_t updateTime = otherAnchorCtx->anchorInfo->lastUpdateTime;
           if (updateTime > youmgestUpdateTime) {
             if (engineState->matching.seqNr[index] == tdoaStorageGetSeqNr(otherAnchorCtx)) {
               youmgestUpdateTime = updateTime;
-              bestId = candidateAnchorId;
+              bestAnchorInfo = otherAnchorCtx->anchorInfo;
             }
           }
         }
       }
     }
 
-    if (bestId >= 0) {
-      tdoaStorageGetCreateAnchorCtx(engineState->anchorInfoArray, bestId, now_ms, otherAnchorCtx);
+    // A later candidate may have been created in the slot of the best one
+    if (bestAnchorInfo && bestAnchorInfo->lastUpdateTime == youmgestUpdateTime) {
+      otherAnchorCtx->anchorInfo = bestAnchorInfo;
       return true;
     }
 
@@ -194,7 +198,7 @@ static bool matchYoungestAnchor(tdoaEngineState_t* engineState, tdoaAnchorContex
 static bool findSuitableAnchor(tdoaEngineState_t* engineState, tdoaAnchorContext_t* otherAnchorCtx, const tdoaAnchorContext_t* anchorCtx) {
   bool result = false;
 
-  if (tdoaStorageGetClockCorrection(anchorCtx) > 0.0) {
+  if (tdoaStorageGetClockCorrectionStorage(anchorCtx)->clockCorrection > 0) {
     switch(engineState->matchingAlgorithm) {
       case TdoaEngineMatchingAlgorithmRandom:
         result = matchRandomAnchor(engineState, otherAnchorCtx, anchorCtx);
@@ -214,7 +218,7 @@ static bool findSuitableAnchor(tdoaEngineState_t* engineState, tdoaAnchorContext
 }
 
 void tdoaEngineGetAnchorCtxForPacketProcessing(tdoaEngineState_t* engineState, const uint8_t anchorId, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx) {
-  if (tdoaStorageGetCreateAnchorCtx(engineState->anchorInfoArray, anchorId, currentTime_ms, anchorCtx)) {
+  if (tdoaStorageGetCreateAnchorCtx(&engineState->anchorStorage, anchorId, currentTime_ms, anchorCtx)) {
     STATS_CNT_RATE_EVENT(&engineState->stats.contextHitCount);
   } else {
     STATS_CNT_RATE_EVENT(&engineState->stats.contextMissCount);
@@ -229,7 +233,7 @@ void tdoaEngineProcessPacket(tdoaEngineState_t* engineState, tdoaAnchorContext_t
     tdoaAnchorContext_t otherAnchorCtx;
     if (findSuitableAnchor(engineState, &otherAnchorCtx, anchorCtx)) {
       STATS_CNT_RATE_EVENT(&engineState->stats.suitableDataFound);
-      double tdoaDistDiff = calcDistanceDiff(&otherAnchorCtx, anchorCtx, txAn_in_cl_An, rxAn_by_T_in_cl_T, engineState->locodeckTsFreq);
+      float tdoaDistDiff = calcDistanceDiff(&otherAnchorCtx, anchorCtx, txAn_in_cl_An, rxAn_by_T_in_cl_T, engineState->metersPerTick);
       enqueueTDOA(&otherAnchorCtx, anchorCtx, tdoaDistDiff, engineState);
     }
   }
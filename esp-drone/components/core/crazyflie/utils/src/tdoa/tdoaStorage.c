@@ -42,84 +42,74 @@ Data storage encapsulation for the TDoA engine
 #define ANCHOR_ACTIVE_VALIDITY_PERIOD (2 * 1000)
 
 
-static tdoaAnchorInfo_t* initializeSlot(tdoaAnchorInfo_t anchorStorage[], const uint8_t slot, const uint8_t anchor);
+static tdoaAnchorInfo_t* initializeSlot(tdoaAnchorStorage_t* anchorStorage, const uint8_t slot, const uint8_t anchor);
 
-void tdoaStorageInitialize(tdoaAnchorInfo_t anchorStorage[]) {
-  memset(anchorStorage, 0, sizeof(tdoaAnchorInfo_t) * ANCHOR_STORAGE_COUNT);
+void tdoaStorageInitialize(tdoaAnchorStorage_t* anchorStorage) {
+  memset(anchorStorage, 0, sizeof(tdoaAnchorStorage_t));
 }
 
-bool tdoaStorageGetCreateAnchorCtx(tdoaAnchorInfo_t anchorStorage[], const uint8_t anchor, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx) {
+static tdoaAnchorInfo_t* findAnchor(tdoaAnchorStorage_t* anchorStorage, const uint8_t anchor) {
+  const uint8_t slotOfAnchor = anchorStorage->slotOfAnchor[anchor];
+  if (slotOfAnchor == 0) {
+    return 0;
+  }
+
+  return &anchorStorage->anchorInfo[slotOfAnchor - 1];
+}
+
+bool tdoaStorageGetCreateAnchorCtx(tdoaAnchorStorage_t* anchorStorage, const uint8_t anchor, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx) {
   anchorCtx->currentTime_ms = currentTime_ms;
-  uint32_t oldestUpdateTime = currentTime_ms;
-  int firstUninitializedSlot = -1;
-  int oldestSlot = 0;
-
-  for (int i = 0; i < ANCHOR_STORAGE_COUNT; i++) {
-    if (anchorStorage[i].isInitialized) {
-      if (anchor == anchorStorage[i].id) {
-        anchorCtx->anchorInfo = &anchorStorage[i];
-        return true;
-      }
 
-      if (anchorStorage[i].lastUpdateTime < oldestUpdateTime) {
-        oldestUpdateTime = anchorStorage[i].lastUpdateTime;
-        oldestSlot = i;
-      }
-    } else {
-      if (firstUninitializedSlot == -1) {
-        firstUninitializedSlot = i;
-      }
-    }
+  tdoaAnchorInfo_t* anchorInfo = findAnchor(anchorStorage, anchor);
+  if (anchorInfo) {
+    anchorCtx->anchorInfo = anchorInfo;
+    return true;
   }
 
-  // The anchor was not found in storage
-  tdoaAnchorInfo_t* newAnchorInfo = 0;
-  if (firstUninitializedSlot != -1) {
-    newAnchorInfo = initializeSlot(anchorStorage, firstUninitializedSlot, anchor);
+  // The anchor was not found in storage, use a free slot or the oldest one
+  uint8_t slot = anchorStorage->usedSlots;
+  if (slot < ANCHOR_STORAGE_COUNT) {
+    anchorStorage->usedSlots++;
   } else {
-    newAnchorInfo = initializeSlot(anchorStorage, oldestSlot, anchor);
+    uint32_t oldestUpdateTime = currentTime_ms;
+    slot = 0;
+    for (int i = 0; i < ANCHOR_STORAGE_COUNT; i++) {
+      if (anchorStorage->anchorInfo[i].lastUpdateTime < oldestUpdateTime) {
+        oldestUpdateTime = anchorStorage->anchorInfo[i].lastUpdateTime;
+        slot = i;
+      }
+    }
   }
 
-  anchorCtx->anchorInfo = newAnchorInfo;
+  anchorCtx->anchorInfo = initializeSlot(anchorStorage, slot, anchor);
   return false;
 }
 
-bool tdoaStorageGetAnchorCtx(tdoaAnchorInfo_t anchorStorage[], const uint8_t anchor, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx) {
+bool tdoaStorageGetAnchorCtx(tdoaAnchorStorage_t* anchorStorage, const uint8_t anchor, const uint32_t currentTime_ms, tdoaAnchorContext_t* anchorCtx) {
   anchorCtx->currentTime_ms = currentTime_ms;
+  anchorCtx->anchorInfo = findAnchor(anchorStorage, anchor);
 
-  for (int i = 0; i < ANCHOR_STORAGE_COUNT; i++) {
-    if (anchorStorage[i].isInitialized) {
-      if (anchor == anchorStorage[i].id) {
-        anchorCtx->anchorInfo = &anchorStorage[i];
-        return true;
-      }
-    }
-  }
-
-  anchorCtx->anchorInfo = 0;
-  return false;
+  return anchorCtx->anchorInfo != 0;
 }
 
-uint8_t tdoaStorageGetListOfAnchorIds(tdoaAnchorInfo_t anchorStorage[], uint8_t unorderedAnchorList[], const int maxListSize) {
+uint8_t tdoaStorageGetListOfAnchorIds(tdoaAnchorStorage_t* anchorStorage, uint8_t unorderedAnchorList[], const int maxListSize) {
   int count = 0;
 
-  for (int i = 0; i < ANCHOR_STORAGE_COUNT && count < maxListSize; i++) {
-    if (anchorStorage[i].isInitialized) {
-      unorderedAnchorList[count] = anchorStorage[i].id;
-      count++;
-    }
+  for (int i = 0; i < anchorStorage->usedSlots && count < maxListSize; i++) {
+    unorderedAnchorList[count] = anchorStorage->anchorInfo[i].id;
+    count++;
   }
 
   return count;
 }
 
-uint8_t tdoaStorageGetListOfActiveAnchorIds(tdoaAnchorInfo_t anchorStorage[], uint8_t unorderedAnchorList[], const int maxListSize, const uint32_t currentTime_ms) {
+uint8_t tdoaStorageGetListOfActiveAnchorIds(tdoaAnchorStorage_t* anchorStorage, uint8_t unorderedAnchorList[], const int maxListSize, const uint32_t currentTime_ms) {
   int count = 0;
 
   const uint32_t expiryTime = currentTime_ms - ANCHOR_ACTIVE_VALIDITY_PERIOD;
-  for (int i = 0; i < ANCHOR_STORAGE_COUNT && count < maxListSize; i++) {
-    if (anchorStorage[i].isInitialized && anchorStorage[i].lastUpdateTime > expiryTime) {
-      unorderedAnchorList[count] = anchorStorage[i].id;
+  for (int i = 0; i < anchorStorage->usedSlots && count < maxListSize; i++) {
+    if (anchorStorage->anchorInfo[i].lastUpdateTime > expiryTime) {
+      unorderedAnchorList[count] = anchorStorage->anchorInfo[i].id;
       count++;
     }
   }
@@ -289,22 +279,21 @@ void tdoaStorageSetTimeOfFlight(tdoaAnchorContext_t* anchorCtx, const uint8_t re
   anchorInfo->tof[indexToUpdate].endOfLife = now + TOF_VALIDITY_PERIOD;
 }
 
-bool tdoaStorageIsAnchorInStorage(tdoaAnchorInfo_t anchorStorage[], const uint8_t anchor) {
-  for (int i = 0; i < ANCHOR_STORAGE_COUNT; i++) {
-    if (anchorStorage[i].isInitialized) {
-      if (anchor == anchorStorage[i].id) {
-        return true;
-      }
-    }
-  }
-
-  return false;
+bool tdoaStorageIsAnchorInStorage(tdoaAnchorStorage_t* anchorStorage, const uint8_t anchor) {
+  return findAnchor(anchorStorage, anchor) != 0;
 }
 
-static tdoaAnchorInfo_t* initializeSlot(tdoaAnchorInfo_t anchorStorage[], const uint8_t slot, const uint8_t anchor) {
-  memset(&anchorStorage[slot], 0, sizeof(tdoaAnchorInfo_t));
-  anchorStorage[slot].id = anchor;
-  anchorStorage[slot].isInitialized = true;
+static tdoaAnchorInfo_t* initializeSlot(tdoaAnchorStorage_t* anchorStorage, const uint8_t slot, const uint8_t anchor) {
+  tdoaAnchorInfo_t* anchorInfo = &anchorStorage->anchorInfo[slot];
+
+  if (anchorInfo->isInitialized) {
+    anchorStorage->slotOfAnchor[anchorInfo->id] = 0;
+  }
+
+  memset(anchorInfo, 0, sizeof(tdoaAnchorInfo_t));
+  anchorInfo->id = anchor;
+  anchorInfo->isInitialized = true;
+  anchorStorage->slotOfAnchor[anchor] = slot + 1;
 
-  return &anchorStorage[slot];
+  return anchorInfo;
 }
@@ -26,6 +26,7 @@
 #include "deck_spi.h"
 #include "config.h"
 #include "cfassert.h"
+#include "static_mem.h"
 #include "nvicconf.h"
 #define DEBUG_MODULE "DECK_SPI"
 #include "debug_cf.h"
@@ -43,6 +44,7 @@
 
 static bool isInit = false;
 static SemaphoreHandle_t spiMutex;
+STATIC_MEM_SEMAPHORE_ALLOC(spiMutex);
 
 static void spiConfigureWithSpeed(uint32_t baudRatePrescaler);
 
@@ -55,7 +57,7 @@ void spiBegin(void)
         return;
     }
 
-    spiMutex = xSemaphoreCreateMutex();
+    spiMutex = STATIC_MEM_MUTEX_CREATE(spiMutex);
 
     esp_err_t ret;
     spi_bus_config_t buscfg = {
@@ -74,7 +76,7 @@ void spiBegin(void)
         /*.pre_cb = lcd_spi_pre_transfer_callback, //Specify pre-transfer callback to handle D/C line*/
     };
     //Initialize the SPI bus
-    spi_host_device_t host_id = SPI2_HOST;
+    spi_host_device_t host_id = SPI_DECK_HOST;
 #if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
     ret = spi_bus_initialize(host_id, &buscfg, SPI_DMA_CH_AUTO);
 #else
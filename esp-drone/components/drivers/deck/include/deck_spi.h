@@ -26,6 +26,8 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "driver/spi_master.h"
+
 // Based on 84MHz peripheral clock
 #define SPI_BAUDRATE_21MHZ  21*1000*1000
 #define SPI_BAUDRATE_12MHZ  12*1000*1000
@@ -33,6 +35,9 @@
 #define SPI_BAUDRATE_3MHZ   3*1000*1000
 #define SPI_BAUDRATE_2MHZ   2*1000*1000
 
+// Host of the deck SPI bus, for devices added to it with the IDF SPI master driver
+#define SPI_DECK_HOST SPI2_HOST
+
 /**
  * Initialize the SPI.
  */
@@ -42,8 +42,20 @@
 
 // Compensate thrust depending on battery voltage so it will produce about the same
 // amount of thrust independent of the battery voltage. Based on thrust measurement.
+#ifdef CONFIG_MOTORS_THRUST_BAT_COMPENSATED
+#define ENABLE_THRUST_BAT_COMPENSATED
+#endif
 
-//#define ENABLE_THRUST_BAT_COMPENSATED
+// Thrust of a full 16 bit ratio (g), and its motor voltage lookup table:
+// 1 << MOTORS_THRUST_LUT_BITS steps, linearly interpolated
+#define MOTORS_THRUST_MAX_GRAMS   40.0f
+#define MOTORS_THRUST_LUT_BITS    6
+#define MOTORS_THRUST_LUT_SHIFT   (16 - MOTORS_THRUST_LUT_BITS)
+#define MOTORS_THRUST_LUT_SIZE    ((1 << MOTORS_THRUST_LUT_BITS) + 1)
+// Motor updates between battery voltage reads, and the lowest voltage
+// compensated for (mV), below it the cell is unloaded or not measured yet
+#define MOTORS_BAT_UPDATE_PERIOD  10
+#define MOTORS_BAT_MIN_MV         3000
 
 
 #define NBR_OF_MOTORS 4
@@ -179,6 +191,13 @@ bool motorsTest(void);
  */
 void motorsSetRatio(uint32_t id, uint16_t ratio);
 
+/**
+ * Set the PWM ratio of all the motors, in motor id order. The duties are
+ * latched together, at the start of the same PWM period, and the channels
+ * whose duty does not change are not written.
+ */
+void motorsSetRatios(const uint16_t ratios[NBR_OF_MOTORS]);
+
 /**
  * Get the PWM ratio of the motor 'id'. Return -1 if wrong ID.
  */
@@ -38,6 +38,19 @@ static uint16_t motorsConvBitsTo16(uint16_t bits);
 static uint16_t motorsConv16ToBits(uint16_t bits);
 
 uint32_t motor_ratios[] = {0, 0, 0, 0};
+// Duty last written to each channel
+static uint32_t motorDuty[NBR_OF_MOTORS];
+#ifdef CONFIG_MOTORS_DITHER
+// Low bits of the ratios not yet output, carried to the next update
+static uint16_t ditherError[NBR_OF_MOTORS];
+#endif
+#ifdef ENABLE_THRUST_BAT_COMPENSATED
+// Motor voltage (mV) producing each thrust step of the table
+static uint16_t thrustToMillivolts[MOTORS_THRUST_LUT_SIZE];
+// 65535 / battery voltage (mV) in Q16, refreshed every MOTORS_BAT_UPDATE_PERIOD updates
+static uint32_t batteryScale;
+static uint32_t batteryUpdateCount;
+#endif
 
 void motorsPlayTone(uint16_t frequency, uint16_t duration_msec);
 void motorsPlayMelody(uint16_t *notes);
@@ -122,6 +135,39 @@ bool pwm_timmer_init()
     return FALSE;
 }
 
+#ifdef ENABLE_THRUST_BAT_COMPENSATED
+// The thrust to voltage curve is evaluated once here, the motor updates
+// only interpolate the table and scale by the battery voltage in integers
+static void motorsThrustLutInit(void)
+{
+    for (int i = 0; i < MOTORS_THRUST_LUT_SIZE; i++) {
+        float thrust = ((float)(i << MOTORS_THRUST_LUT_SHIFT) / 65536.0f) * MOTORS_THRUST_MAX_GRAMS; //根据实际重量修改
+        float volts = -0.0006239f * thrust * thrust + 0.088f * thrust;
+        thrustToMillivolts[i] = (uint16_t)(volts * 1000.0f + 0.5f);
+    }
+}
+
+static void motorsUpdateBatteryScale(void)
+{
+    uint32_t supply = (uint32_t)(pmGetBatteryVoltage() * 1000.0f);
+    if (supply < MOTORS_BAT_MIN_MV) {
+        supply = MOTORS_BAT_MIN_MV;
+    }
+    batteryScale = ((uint32_t)UINT16_MAX << 16) / supply;
+}
+
+static uint16_t motorsCompensateThrust(uint16_t ithrust)
+{
+    uint32_t index = ithrust >> MOTORS_THRUST_LUT_SHIFT;
+    int32_t fraction = ithrust & ((1 << MOTORS_THRUST_LUT_SHIFT) - 1);
+    int32_t step = (int32_t)thrustToMillivolts[index + 1] - thrustToMillivolts[index];
+    uint32_t millivolts = thrustToMillivolts[index] + ((step * fraction) >> MOTORS_THRUST_LUT_SHIFT);
+
+    uint64_t ratio = ((uint64_t)millivolts * batteryScale) >> 16;
+    return ratio > UINT16_MAX ? UINT16_MAX : (uint16_t)ratio;
+}
+#endif
+
 /* Public functions */
 
 //Initialization. Will set all motors ratio to 0%
@@ -144,6 +190,10 @@ void motorsInit(const MotorPerifDef **motorMapSelect)
         ledc_channel_config(&motors_channel[i]);
     }
 
+#ifdef ENABLE_THRUST_BAT_COMPENSATED
+    motorsThrustLutInit();
+    motorsUpdateBatteryScale();
+#endif
     isInit = true;
 }
 
@@ -151,6 +201,8 @@ void motorsDeInit(const MotorPerifDef **motorMapSelect)
 {
     for (int i = 0; i < NBR_OF_MOTORS; i++) {
         ledc_stop(motors_channel[i].speed_mode, motors_channel[i].channel, 0);
+        // No duty matches, the next update rewrites the channel
+        motorDuty[i] = MOTORS_PWM_PERIOD + 1;
     }
 }
 
@@ -177,35 +229,96 @@ bool motorsTest(void)
     return isInit;
 }
 
+/**
+ * Duty of the motor 'id' for a thrust ratio, also recording the ratio for the log
+ */
+static uint32_t motorsRatioToDuty(uint32_t id, uint16_t ithrust)
+{
+    uint16_t ratio;
+
+    ASSERT(id < NBR_OF_MOTORS);
+
+    ratio = ithrust;
+
+#ifdef ENABLE_THRUST_BAT_COMPENSATED
+
+    if (motorMap[id]->drvType == BRUSHED) {
+        ratio = motorsCompensateThrust(ithrust);
+    }
+
+#endif
+    motor_ratios[id] = ratio;
+#ifdef DEBUG_EP2
+    DEBUG_PRINT_LOCAL("motors ID = %d ,ithrust_10bit = %d", id, (uint32_t)motorsConv16ToBits(ratio));
+#endif
+
+#ifdef CONFIG_MOTORS_DITHER
+    if (ratio == 0) {
+        // Stopped motors get no dithered pulses
+        ditherError[id] = 0;
+        return 0;
+    }
+
+    uint32_t dithered = (uint32_t)ratio + ditherError[id];
+    uint32_t duty = dithered >> (16 - MOTORS_PWM_BITS);
+
+    if (duty > MOTORS_PWM_PERIOD) {
+        duty = MOTORS_PWM_PERIOD;
+        ditherError[id] = 0;
+    } else {
+        ditherError[id] = (uint16_t)(dithered - (duty << (16 - MOTORS_PWM_BITS)));
+    }
+
+    return duty;
+#else
+    return (uint32_t)motorsConv16ToBits(ratio);
+#endif
+}
+
 // Ithrust is thrust mapped for 65536 <==> 60 grams
 void motorsSetRatio(uint32_t id, uint16_t ithrust)
 {
     if (isInit) {
-        uint16_t ratio;
+        uint32_t duty = motorsRatioToDuty(id, ithrust);
 
-        ASSERT(id < NBR_OF_MOTORS);
+        ledc_set_duty(motors_channel[id].speed_mode, motors_channel[id].channel, duty);
+        ledc_update_duty(motors_channel[id].speed_mode, motors_channel[id].channel);
+        motorDuty[id] = duty;
+    }
+}
 
-        ratio = ithrust;
+void motorsSetRatios(const uint16_t ithrust[NBR_OF_MOTORS])
+{
+    if (isInit) {
+        uint32_t duty[NBR_OF_MOTORS];
+        bool changed[NBR_OF_MOTORS];
 
 #ifdef ENABLE_THRUST_BAT_COMPENSATED
+        if (++batteryUpdateCount >= MOTORS_BAT_UPDATE_PERIOD) {
+            batteryUpdateCount = 0;
+            motorsUpdateBatteryScale();
+        }
+#endif
 
-        if (motorMap[id]->drvType == BRUSHED) {
-            float thrust = ((float)ithrust / 65536.0f) * 40; //根据实际重量修改
-            float volts = -0.0006239f * thrust * thrust + 0.088f * thrust;
-            float supply_voltage = pmGetBatteryVoltage();
-            float percentage = volts / supply_voltage;
-            percentage = percentage > 1.0f ? 1.0f : percentage;
-            ratio = percentage * UINT16_MAX;
-            motor_ratios[id] = ratio;
+        for (int i = 0; i < NBR_OF_MOTORS; i++) {
+            duty[i] = motorsRatioToDuty(i, ithrust[i]);
+            changed[i] = duty[i] != motorDuty[i];
         }
 
-#endif
-        ledc_set_duty(motors_channel[id].speed_mode, motors_channel[id].channel, (uint32_t)motorsConv16ToBits(ratio));
-        ledc_update_duty(motors_channel[id].speed_mode, motors_channel[id].channel);
-        motor_ratios[id] = ratio;
-#ifdef DEBUG_EP2
-        DEBUG_PRINT_LOCAL("motors ID = %d ,ithrust_10bit = %d", id, (uint32_t)motorsConv16ToBits(ratio));
-#endif
+        // All the duties are written before any is latched, so that the
+        // updates, a few us apart, take effect at the same PWM period start
+        for (int i = 0; i < NBR_OF_MOTORS; i++) {
+            if (changed[i]) {
+                ledc_set_duty(motors_channel[i].speed_mode, motors_channel[i].channel, duty[i]);
+            }
+        }
+
+        for (int i = 0; i < NBR_OF_MOTORS; i++) {
+            if (changed[i]) {
+                ledc_update_duty(motors_channel[i].speed_mode, motors_channel[i].channel);
+                motorDuty[i] = duty[i];
+            }
+        }
     }
 }
 
@@ -230,7 +343,8 @@ void motorsBeep(int id, bool enable, uint16_t frequency, uint16_t ratio)
     }
     
     ledc_set_freq(LEDC_LOW_SPEED_MODE,LEDC_TIMER_0,freq_hz);
-    ledc_set_duty(motors_channel[id].speed_mode, motors_channel[id].channel, (uint32_t)motorsConv16ToBits(ratio));
+    motorDuty[id] = (uint32_t)motorsConv16ToBits(ratio);
+    ledc_set_duty(motors_channel[id].speed_mode, motors_channel[id].channel, motorDuty[id]);
     ledc_update_duty(motors_channel[id].speed_mode, motors_channel[id].channel);
 }
 
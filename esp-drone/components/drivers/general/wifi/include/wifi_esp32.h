@@ -3,25 +3,47 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-// 32 bytes is enough for CRTP packets (30+1) + checksum 1
-#define WIFI_RX_TX_PACKET_SIZE   (32)
+// Room for the largest CRTP packet (header 1 + data) + checksum 1
+#define WIFI_RX_PACKET_SIZE      (CONFIG_CRTP_MAX_DATA_SIZE + 2)
+// TX packets also carry batched telemetry, checksum 1 is appended on top
+#define WIFI_TX_PACKET_SIZE      (CONFIG_WIFI_TX_PACKET_SIZE)
 
-/* Structure used for in/out data via USB */
+/* Handler of the CRTP packets received over UDP, checksum removed */
+typedef void (*WifiRxHandler)(const uint8_t *data, uint16_t size);
+
+// UDPTxPacket flags: packet subject to each subscriber's rate divisor
+#define WIFI_TX_FLAG_RATE_LIMITED (1 << 0)
+
+/* Structure used for out data via UDP */
+typedef struct
+{
+  uint16_t size;
+  uint8_t flags;
+  uint8_t data[WIFI_TX_PACKET_SIZE + 1];
+} UDPTxPacket;
+
+/* Link health, read by the telemetry rate control */
 typedef struct
 {
-  uint8_t size;
-  uint8_t data[WIFI_RX_TX_PACKET_SIZE];
-} UDPPacket;
+  uint32_t txError;     // sendto failures since boot
+  uint32_t txFull;      // tx packets not sent since boot, no free packet
+  uint32_t txDrop;      // queued tx packets dropped since boot
+  uint16_t txWaiting;   // packets waiting in the tx queue
+  uint16_t txPoolSize;  // tx packets in the pool
+  uint8_t stations;     // stations connected to the access point
+  int8_t rssi;          // weakest station signal (dBm), 0 without station
+} WifiLinkStats;
 
 /**
- * Initialize the wifi.
+ * Initialize the wifi. The data queues are ready on return, the access point
+ * and the UDP server are brought up by a task of their own meanwhile.
  *
  * @note Initialize CRTP link only if USE_CRTP_WIFI is defined
  */
 void wifiInit(void);
 
 /**
- * Test the WIFI status.
+ * Test the WIFI status. Waits for the access point to be up, at most 5 s.
  *
  * @return true if the WIFI is initialized
  */
@@ -35,22 +57,79 @@ bool wifiTest(void);
 //struct crtpLinkOperations * wifiGetLink();
 
 /**
- * Get data from rx queue with timeout.
- * @param[out] c  Byte of data
- *
- * @return true if byte received, false if timout reached.
+ * Set the handler of the CRTP packets received over UDP. The UDP rx task
+ * calls it with the packet still in its socket buffer, once the checksum
+ * is checked and the time sync, external sample and handshake packets are
+ * handled: it must copy what it keeps and not block for long. Packets
+ * received before a handler is set are dropped.
+ * @param[in] handler  Packet handler
  */
-bool wifiGetDataBlocking(UDPPacket *in);
+void wifiSetRxHandler(WifiRxHandler handler);
 
 /**
  * Sends raw data using a lock. Should be used from
  * exception functions and for debugging when a lot of data
  * should be transfered.
- * @param[in] size  Number of bytes to send
+ * @param[in] size  Number of bytes to send, up to WIFI_TX_PACKET_SIZE
  * @param[in] data  Pointer to data
  *
  * @note If WIFI Crtp link is activated this function does nothing
  */
 bool wifiSendData(uint32_t size, uint8_t* data);
 
+/**
+ * Non-blocking variant of wifiSendData. If the tx pool is exhausted,
+ * the oldest packet waiting to be sent is dropped to make room.
+ * @param[in] size  Number of bytes to send, up to WIFI_TX_PACKET_SIZE
+ * @param[in] data  Pointer to data
+ *
+ * @return true if the packet was queued.
+ */
+bool wifiSendDataDropOldest(uint32_t size, uint8_t* data);
+
+/**
+ * Claim a free packet from the tx pool, to be filled in place.
+ * The claimed packet must be handed back with wifiSendTxPacket
+ * or wifiReleaseTxPacket.
+ * @param[in] timeout  Ticks to wait for a free packet
+ *
+ * @return Pointer to the packet, NULL if none was free before the timeout.
+ */
+UDPTxPacket *wifiClaimTxPacket(uint32_t timeout);
+
+/**
+ * Non-blocking variant of wifiClaimTxPacket. If the tx pool is exhausted,
+ * the oldest packet waiting to be sent is dropped and handed out instead.
+ *
+ * @return Pointer to the packet, NULL if every packet is in use.
+ */
+UDPTxPacket *wifiClaimTxPacketDropOldest(void);
+
+/**
+ * Queue a claimed packet for sending. The tx task sends it
+ * straight from the pool and then releases it.
+ * @param[in] packet  Packet claimed with wifiClaimTxPacket, size set
+ *
+ * @return true if the packet was queued.
+ */
+bool wifiSendTxPacket(UDPTxPacket *packet);
+
+/**
+ * Give a claimed packet back to the tx pool without sending it.
+ * @param[in] packet  Packet claimed with wifiClaimTxPacket
+ */
+void wifiReleaseTxPacket(UDPTxPacket *packet);
+
+/**
+ * Read the link health: tx losses since boot, tx queue fill and
+ * the signal of the stations connected to the access point.
+ * @param[out] link  Link health
+ */
+void wifiGetLinkStats(WifiLinkStats *link);
+
+/**
+ * @return Number of packets waiting in the tx queue
+ */
+uint16_t wifiGetTxWaiting(void);
+
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #include "esp_system.h"
 #include "esp_wifi.h"
@@ -14,8 +15,14 @@
 #include "lwip/netdb.h"
 
 #include "queuemonitor.h"
+#include "static_mem.h"
+#include "event_trace.h"
+#include "boot_profile.h"
+#include "log.h"
 #include "wifi_esp32.h"
 #include "stm32_legacy.h"
+#include "crtp_localization_service.h"
+#include "crtp_commander.h"
 #define DEBUG_MODULE  "WIFI_UDP"
 #include "debug_cf.h"
 
@@ -27,9 +34,35 @@
 #include "espnow_utils.h"
 
 #define UDP_SERVER_PORT         2390
-#define UDP_SERVER_BUFSIZE      64
-
-static struct sockaddr_storage source_addr;
+// One byte more than the largest packet, so oversized packets are detected
+#define UDP_SERVER_BUFSIZE      (WIFI_RX_PACKET_SIZE + 1)
+#define UDP_TX_POOL_SIZE        CONFIG_WIFI_UDP_TX_POOL_SIZE
+#define UDP_MAX_SUBSCRIBERS     CONFIG_WIFI_UDP_MAX_SUBSCRIBERS
+// Handshake: header, optional rate divisor, cksum
+#define UDP_HANDSHAKE_HEADER    0x01
+// Time sync request: header, client send time, cksum. Answered at once from
+// the rx task as a telemetry packet (see drone_telemetry.c), so the receive
+// and send times bracket only the time spent in the drone
+#define UDP_TIME_SYNC_HEADER    0x02
+#define UDP_TIME_SYNC_VERSION   3     // TELEMETRY_PACKET_VERSION
+#define UDP_TIME_SYNC_TYPE      0x07  // PACKET_ID_TIME_SYNC
+// External position/pose: header, ExtPositionSample or ExtPoseSample, cksum.
+// Enqueued into the estimator from the rx task, skipping the rx queue and CRTP
+#define UDP_EXT_SAMPLE_HEADER   0x03
+
+// Clients receiving the tx traffic, registered by their first packet
+// or by a handshake carrying their rate divisor
+typedef struct {
+    bool active;
+    struct sockaddr_in addr;
+    uint8_t rateDivisor;
+    uint8_t rateCounter;
+    uint32_t lastSeen;
+} UDPSubscriber;
+
+static UDPSubscriber subscribers[UDP_MAX_SUBSCRIBERS];
+static SemaphoreHandle_t subscribersMutex;
+STATIC_MEM_SEMAPHORE_ALLOC(subscribersMutex);
 
 static char WIFI_SSID[32] = "";
 static char WIFI_PWD[64] = CONFIG_WIFI_PASSWORD;
@@ -42,15 +75,98 @@ static uint8_t WIFI_CH = CONFIG_WIFI_CHANNEL;
 #endif
 
 static int sock;
-static xQueueHandle udpDataRx;
+static volatile WifiRxHandler rxHandler;
+// Queue of filled tx slots, and queue of free tx slots (both hold pointers)
 static xQueueHandle udpDataTx;
+STATIC_MEM_QUEUE_ALLOC(udpDataTx, UDP_TX_POOL_SIZE, sizeof(UDPTxPacket *));
+static xQueueHandle udpTxFree;
+STATIC_MEM_QUEUE_ALLOC(udpTxFree, UDP_TX_POOL_SIZE, sizeof(UDPTxPacket *));
+static UDPTxPacket udpTxPool[UDP_TX_POOL_SIZE];
+
+STATIC_MEM_TASK_ALLOC(udpServerTxTask, UDP_TX_TASK_STACKSIZE);
+STATIC_MEM_TASK_ALLOC(udpServerRxTask, UDP_RX_TASK_STACKSIZE);
+STATIC_MEM_TASK_ALLOC(wifiStartTask, WIFI_START_TASK_STACKSIZE);
+
+// Given once the access point and the UDP server are up
+static SemaphoreHandle_t wifiStarted;
+STATIC_MEM_SEMAPHORE_ALLOC(wifiStarted);
+
+// Longest wait of wifiTest for the access point
+#define WIFI_START_TIMEOUT M2T(5000)
+
+static struct {
+  uint32_t rxDrop;         // rx packets dropped, no rx handler set
+  uint32_t txFull;         // tx packets not sent, no free packet before the timeout
+  uint32_t txDrop;         // queued tx packets dropped to make room for newer ones
+  uint32_t txError;        // sendto failures, one per subscriber missed
+  uint16_t txHighWater;    // max packets seen waiting in the tx queue
+} stats;
 
 static bool isInit = false;
+static bool isStarting = false;
 static bool isUDPInit = false;
 static bool isUDPConnected = false;
 
 static esp_err_t udp_server_create(void *arg);
 
+static void updateHighWater(xQueueHandle queue, uint16_t *highWater)
+{
+    uint16_t waiting = uxQueueMessagesWaiting(queue);
+    if (waiting > *highWater) {
+        *highWater = waiting;
+    }
+}
+
+static bool isHandshake(const char *data, int len)
+{
+    return (len == 1 || len == 2) && (uint8_t)data[0] == UDP_HANDSHAKE_HEADER;
+}
+
+static void subscribe(const struct sockaddr_in *addr, const char *data, int len)
+{
+    bool handshake = isHandshake(data, len);
+    UDPSubscriber *slot = NULL;
+
+    xSemaphoreTake(subscribersMutex, portMAX_DELAY);
+    for (int i = 0; i < UDP_MAX_SUBSCRIBERS; i++) {
+        UDPSubscriber *sub = &subscribers[i];
+        if (sub->active && sub->addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
+            sub->addr.sin_port == addr->sin_port) {
+            slot = sub;
+            break;
+        }
+    }
+
+    if (slot == NULL) {
+        // New client, take a free entry or the least recently seen one
+        slot = &subscribers[0];
+        for (int i = 0; i < UDP_MAX_SUBSCRIBERS; i++) {
+            if (!subscribers[i].active) {
+                slot = &subscribers[i];
+                break;
+            }
+            if (subscribers[i].lastSeen < slot->lastSeen) {
+                slot = &subscribers[i];
+            }
+        }
+        if (slot->active) {
+            DEBUG_PRINT_LOCAL("subscriber table full, replacing oldest client");
+        }
+        slot->active = true;
+        slot->addr = *addr;
+        slot->rateDivisor = 1;
+        slot->rateCounter = 0;
+        DEBUG_PRINT_LOCAL("new subscriber, port %d", ntohs(addr->sin_port));
+    }
+
+    if (handshake) {
+        slot->rateDivisor = (len == 2 && data[1] != 0) ? (uint8_t)data[1] : 1;
+        slot->rateCounter = 0;
+    }
+    slot->lastSeen = xTaskGetTickCount();
+    xSemaphoreGive(subscribersMutex);
+}
+
 static uint8_t calculate_cksum(void *data, size_t len)
 {
     unsigned char *c = data;
@@ -64,6 +180,52 @@ static uint8_t calculate_cksum(void *data, size_t len)
     return cksum;
 }
 
+typedef struct __attribute__((packed)) {
+    uint8_t header;          // UDP_TIME_SYNC_HEADER
+    uint64_t clientSend;     // Client send time, echoed (client clock)
+} TimeSyncRequest;
+
+// Laid out as a telemetry packet: header, then payload, then cksum
+typedef struct __attribute__((packed)) {
+    uint8_t version;         // UDP_TIME_SYNC_VERSION
+    uint8_t type;            // UDP_TIME_SYNC_TYPE
+    uint16_t seq;
+    uint64_t droneSend;      // Answer send time (us since boot)
+    uint8_t rateDivisor;     // Always 1, answers are not rate controlled
+    uint64_t clientSend;     // Echoed from the request
+    uint64_t droneReceive;   // Request receive time (us since boot)
+    uint8_t cksum;
+} TimeSyncAnswer;
+
+static bool isTimeSync(const char *data, int len)
+{
+    return len == sizeof(TimeSyncRequest) && (uint8_t)data[0] == UDP_TIME_SYNC_HEADER;
+}
+
+static void answerTimeSync(const struct sockaddr_in *addr, const char *data, uint64_t receiveTime)
+{
+    static uint16_t seq = 0;
+    TimeSyncRequest request;
+    memcpy(&request, data, sizeof(request));
+
+    TimeSyncAnswer answer;
+    answer.version = UDP_TIME_SYNC_VERSION;
+    answer.type = UDP_TIME_SYNC_TYPE;
+    answer.seq = seq++;
+    answer.clientSend = request.clientSend;
+    answer.droneReceive = receiveTime;
+    answer.rateDivisor = 1;
+    answer.droneSend = usecTimestamp();
+    answer.cksum = calculate_cksum(&answer, sizeof(answer) - 1);
+    sendto(sock, &answer, sizeof(answer), 0, (const struct sockaddr *)addr, sizeof(*addr));
+}
+
+static bool isExtSample(const char *data, int len)
+{
+    return (len == 1 + sizeof(struct ExtPositionSample) || len == 1 + sizeof(struct ExtPoseSample)) &&
+           (uint8_t)data[0] == UDP_EXT_SAMPLE_HEADER;
+}
+
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                int32_t event_id, void *event_data)
 {
@@ -79,26 +241,117 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
 
 bool wifiTest(void)
 {
+    if (isStarting && xSemaphoreTake(wifiStarted, WIFI_START_TIMEOUT) == pdTRUE) {
+        xSemaphoreGive(wifiStarted);
+    }
     return isInit;
 };
 
-bool wifiGetDataBlocking(UDPPacket *in)
+void wifiSetRxHandler(WifiRxHandler handler)
 {
-    /* command step - receive  02  from udp rx queue */
-    while (xQueueReceive(udpDataRx, in, portMAX_DELAY) != pdTRUE) {
-        vTaskDelay(M2T(10));
-    }; // Don't return until we get some data on the UDP
+    rxHandler = handler;
+}
 
-    return true;
+UDPTxPacket *wifiClaimTxPacket(uint32_t timeout)
+{
+    UDPTxPacket *packet = NULL;
+    if (xQueueReceive(udpTxFree, &packet, timeout) != pdTRUE) {
+        stats.txFull++;
+        return NULL;
+    }
+    packet->size = 0;
+    packet->flags = 0;
+    return packet;
+};
+
+UDPTxPacket *wifiClaimTxPacketDropOldest(void)
+{
+    UDPTxPacket *packet = NULL;
+    if (xQueueReceive(udpTxFree, &packet, 0) != pdTRUE) {
+        // Pool exhausted, reuse the oldest packet still waiting to be sent
+        if (xQueueReceive(udpDataTx, &packet, 0) != pdTRUE) {
+            stats.txFull++;
+            return NULL;
+        }
+        stats.txDrop++;
+        DEBUG_QUEUE_MONITOR_SEND(udpDataTx, false);
+    }
+    packet->size = 0;
+    packet->flags = 0;
+    return packet;
+};
+
+bool wifiSendTxPacket(UDPTxPacket *packet)
+{
+    if (packet->size > WIFI_TX_PACKET_SIZE) {
+        wifiReleaseTxPacket(packet);
+        return false;
+    }
+    // There is always room, the tx queue is as deep as the pool
+    bool sent = (xQueueSend(udpDataTx, &packet, 0) == pdTRUE);
+    DEBUG_QUEUE_MONITOR_SEND(udpDataTx, sent);
+    updateHighWater(udpDataTx, &stats.txHighWater);
+    return sent;
+};
+
+void wifiReleaseTxPacket(UDPTxPacket *packet)
+{
+    xQueueSend(udpTxFree, &packet, 0);
+};
+
+void wifiGetLinkStats(WifiLinkStats *link)
+{
+    link->txError = stats.txError;
+    link->txFull = stats.txFull;
+    link->txDrop = stats.txDrop;
+    link->txWaiting = uxQueueMessagesWaiting(udpDataTx);
+    link->txPoolSize = UDP_TX_POOL_SIZE;
+    link->stations = 0;
+    link->rssi = 0;
+
+    wifi_sta_list_t staList;
+    if (isUDPInit && esp_wifi_ap_get_sta_list(&staList) == ESP_OK) {
+        for (int i = 0; i < staList.num; i++) {
+            if (link->stations == 0 || staList.sta[i].rssi < link->rssi) {
+                link->rssi = staList.sta[i].rssi;
+            }
+            link->stations++;
+        }
+    }
+};
+
+uint16_t wifiGetTxWaiting(void)
+{
+    return uxQueueMessagesWaiting(udpDataTx);
 };
 
 bool wifiSendData(uint32_t size, uint8_t *data)
 {
-    UDPPacket outStage = {0};
-    outStage.size = size;
-    memcpy(outStage.data, data, size);
+    if (size > WIFI_TX_PACKET_SIZE) {
+        return false;
+    }
     // Dont' block when sending
-    return (xQueueSend(udpDataTx, &outStage, M2T(100)) == pdTRUE);
+    UDPTxPacket *outStage = wifiClaimTxPacket(M2T(100));
+    if (outStage == NULL) {
+        return false;
+    }
+    outStage->size = size;
+    memcpy(outStage->data, data, size);
+    return wifiSendTxPacket(outStage);
+};
+
+bool wifiSendDataDropOldest(uint32_t size, uint8_t *data)
+{
+    if (size > WIFI_TX_PACKET_SIZE) {
+        return false;
+    }
+    UDPTxPacket *outStage = wifiClaimTxPacketDropOldest();
+    if (outStage == NULL) {
+        return false;
+    }
+    outStage->size = size;
+    memcpy(outStage->data, data, size);
+    return wifiSendTxPacket(outStage);
 };
 
 static esp_err_t udp_server_create(void *arg)
@@ -131,41 +384,56 @@ static esp_err_t udp_server_create(void *arg)
 
 static void udp_server_rx_task(void *pvParameters)
 {
-    socklen_t socklen = sizeof(source_addr);
+    struct sockaddr_in from_addr;
+    socklen_t socklen = sizeof(from_addr);
     char rx_buffer[UDP_SERVER_BUFSIZE];
-    UDPPacket inPacket = {0};
 
     while (true) {
         if(isUDPInit == false) {
             vTaskDelay(20);
             continue;
         }
-        int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer), 0, (struct sockaddr *)&source_addr, &socklen);
+        socklen = sizeof(from_addr);
+        int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer), 0, (struct sockaddr *)&from_addr, &socklen);
+        uint64_t receiveTime = usecTimestamp();
         /* command step - receive  01 from Wi-Fi UDP */
         if (len < 0) {
             DEBUG_PRINT_LOCAL("recvfrom failed: errno %d", errno);
             continue;
-        } else if(len > WIFI_RX_TX_PACKET_SIZE) {
-            DEBUG_PRINT_LOCAL("Received data length = %d > %d", len, WIFI_RX_TX_PACKET_SIZE);
+        } else if(len > WIFI_RX_PACKET_SIZE) {
+            DEBUG_PRINT_LOCAL("Received data length = %d > %d", len, WIFI_RX_PACKET_SIZE);
             continue;
         } else {
             uint8_t cksum = rx_buffer[len - 1];
             //remove cksum, do not belong to CRTP
             //check packet
-            if (cksum == calculate_cksum(rx_buffer, len - 1)) {
-                //copy part of the UDP packet, the size not include cksum
-                inPacket.size = len - 1;
-                memcpy(inPacket.data, rx_buffer, inPacket.size);
-                xQueueSend(udpDataRx, &inPacket, M2T(10));
+            bool valid = (cksum == calculate_cksum(rx_buffer, len - 1));
+            if (valid && isTimeSync(rx_buffer, len - 1)) {
+                answerTimeSync(&from_addr, rx_buffer, receiveTime);
+            } else if (valid && isExtSample(rx_buffer, len - 1)) {
+                locSrvEnqueueExtSample(&rx_buffer[1], len - 2, receiveTime);
+            } else if (valid) {
+                EVENT_TRACE_BEGIN(eventTraceWifiRx, len);
+                subscribe(&from_addr, rx_buffer, len - 1);
                 if(!isUDPConnected) isUDPConnected = true;
+                /* command step - receive  02 dispatch the CRTP part, the size not include cksum */
+                WifiRxHandler handler = rxHandler;
+                if (isHandshake(rx_buffer, len - 1)) {
+                    // Subscription only, not a CRTP packet
+                } else if (handler) {
+                    handler((const uint8_t *)rx_buffer, len - 1);
+                } else {
+                    stats.rxDrop++;
+                }
+                EVENT_TRACE_STOP(eventTraceWifiRx, len);
             }else{
                 DEBUG_PRINT_LOCAL("udp packet cksum unmatched");
             }
 
 #ifdef DEBUG_UDP
-            printf("\nReceived size = %d cksum = %02X\n", inPacket.size, cksum);
-            for (size_t i = 0; i < inPacket.size; i++) {
-                printf("%02X ", inPacket.data[i]);
+            printf("\nReceived size = %d cksum = %02X\n", len - 1, cksum);
+            for (size_t i = 0; i < len - 1; i++) {
+                printf("%02X ", (uint8_t)rx_buffer[i]);
             }
             printf("\n");
 #endif
@@ -175,30 +443,50 @@ static void udp_server_rx_task(void *pvParameters)
 
 static void udp_server_tx_task(void *pvParameters)
 {
-    UDPPacket outPacket = {0};
+    UDPTxPacket *outPacket = NULL;
     while (TRUE) {
         if(isUDPInit == false) {
             vTaskDelay(20);
             continue;
         }
-        if ((xQueueReceive(udpDataTx, &outPacket, portMAX_DELAY) == pdTRUE) && isUDPConnected) {
-            // append cksum to the packet
-            outPacket.data[outPacket.size] = calculate_cksum(outPacket.data, outPacket.size);
-            outPacket.size += 1;
-
-            int err = sendto(sock, outPacket.data, outPacket.size, 0, (struct sockaddr *)&source_addr, sizeof(source_addr));
-            if (err < 0) {
-                DEBUG_PRINT_LOCAL("Error occurred during sending: errno %d", errno);
-                continue;
+        if (xQueueReceive(udpDataTx, &outPacket, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        EVENT_TRACE_BEGIN(eventTraceWifiTx, outPacket->size);
+        if (isUDPConnected) {
+            // append cksum to the packet, sent straight from the slot
+            outPacket->data[outPacket->size] = calculate_cksum(outPacket->data, outPacket->size);
+            outPacket->size += 1;
+
+            xSemaphoreTake(subscribersMutex, portMAX_DELAY);
+            for (int i = 0; i < UDP_MAX_SUBSCRIBERS; i++) {
+                UDPSubscriber *sub = &subscribers[i];
+                if (!sub->active) {
+                    continue;
+                }
+                if (outPacket->flags & WIFI_TX_FLAG_RATE_LIMITED) {
+                    if (++sub->rateCounter < sub->rateDivisor) {
+                        continue;
+                    }
+                    sub->rateCounter = 0;
+                }
+                int err = sendto(sock, outPacket->data, outPacket->size, 0, (struct sockaddr *)&sub->addr, sizeof(sub->addr));
+                if (err < 0) {
+                    stats.txError++;
+                    DEBUG_PRINT_LOCAL("Error occurred during sending: errno %d", errno);
+                }
             }
+            xSemaphoreGive(subscribersMutex);
 #ifdef DEBUG_UDP
-            printf("\nSend size = %d checksum = %02X\n", outPacket.size, outPacket.data[outPacket.size - 1]);
-            for (size_t i = 0; i < outPacket.size; i++) {
-                printf("%02X ", outPacket.data[i]);
+            printf("\nSend size = %d checksum = %02X\n", outPacket->size, outPacket->data[outPacket->size - 1]);
+            for (size_t i = 0; i < outPacket->size; i++) {
+                printf("%02X ", outPacket->data[i]);
             }
             printf("\n");
 #endif
         }
+        EVENT_TRACE_STOP(eventTraceWifiTx, outPacket->size);
+        wifiReleaseTxPacket(outPacket);
     }
 }
 
@@ -213,16 +501,17 @@ static void espnow_ctrl_data_cb(espnow_attribute_t initiator_attribute,
                                        int channel_one_value,
                                        int channel_two_value)
 {
-    UDPPacket inPacket;
-    inPacket.size = 7;
-    inPacket.data[0] = 'n';
-    inPacket.data[1] = 'o';
-    inPacket.data[2] = 'w';
-    inPacket.data[3] = lx_value & 0xFF;
-    inPacket.data[4] = ly_value & 0xFF;
-    inPacket.data[5] = ry_value & 0xFF;
-    inPacket.data[6] = rx_value & 0xFF;
-    xQueueSend(udpDataRx, &inPacket, 0);
+    // Straight to the commander from the ESP-NOW task, instead of the UDP RX
+    // queue, the wifilink task and the CRTP RX queue
+    int8_t lx = lx_value & 0xFF;
+    int8_t ly = ly_value & 0xFF;
+    int8_t rx = rx_value & 0xFF;
+    int8_t ry = ry_value & 0xFF;
+    float roll = rx * 15.0f / 128;     //-15~+15
+    float pitch = ry * 15.0f / -128;   //-15~+15
+    float yaw = lx * 15.0f / 128;      //-15~+15
+    uint16_t thrust = ly < 0 ? 0 : ly * 59000.0f / 128;
+    crtpCommanderSetRpytSetpoint(roll, pitch, yaw, thrust);
 }
 
 static void app_espnow_event_handler(void *handler_args, esp_event_base_t base, int32_t id, void *event_data)
@@ -249,17 +538,10 @@ static void app_espnow_event_handler(void *handler_args, esp_event_base_t base,
     }
 }
 
-void wifiInit(void)
+// Brings up the access point and the UDP server, the slow part of the init,
+// while the system task goes on with the other modules
+static void wifiStartTask(void *param)
 {
-    if (isInit) {
-        return;
-    }
-    // This should probably be reduced to a CRTP packet size
-    udpDataRx = xQueueCreate(16, sizeof(UDPPacket));
-    DEBUG_QUEUE_MONITOR_REGISTER(udpDataRx);
-    udpDataTx = xQueueCreate(16, sizeof(UDPPacket));
-    DEBUG_QUEUE_MONITOR_REGISTER(udpDataTx);
-
     espnow_storage_init();
     esp_netif_t *ap_netif = NULL;
     ESP_ERROR_CHECK(esp_netif_init());
@@ -319,7 +601,40 @@ void wifiInit(void)
     } else {
         DEBUG_PRINT_LOCAL("UDP server create socket succeed");
     }
-    xTaskCreate(udp_server_tx_task, UDP_TX_TASK_NAME, UDP_TX_TASK_STACKSIZE, NULL, UDP_TX_TASK_PRI, NULL);
-    xTaskCreate(udp_server_rx_task, UDP_RX_TASK_NAME, UDP_RX_TASK_STACKSIZE, NULL, UDP_RX_TASK_PRI, NULL);
+    STATIC_MEM_TASK_CREATE_PINNED(udpServerTxTask, udp_server_tx_task, UDP_TX_TASK_NAME, NULL, UDP_TX_TASK_PRI, UDP_TX_TASK_CORE);
+    STATIC_MEM_TASK_CREATE_PINNED(udpServerRxTask, udp_server_rx_task, UDP_RX_TASK_NAME, NULL, UDP_RX_TASK_PRI, UDP_RX_TASK_CORE);
     isInit = true;
-}
\ No newline at end of file
+    bootProfileMark(bootPhaseWifiUp);
+    xSemaphoreGive(wifiStarted);
+
+    vTaskDelete(NULL);
+}
+
+void wifiInit(void)
+{
+    if (isStarting) {
+        return;
+    }
+    // This should probably be reduced to a CRTP packet size
+    subscribersMutex = STATIC_MEM_MUTEX_CREATE(subscribersMutex);
+    udpDataTx = STATIC_MEM_QUEUE_CREATE(udpDataTx);
+    DEBUG_QUEUE_MONITOR_REGISTER(udpDataTx);
+    udpTxFree = STATIC_MEM_QUEUE_CREATE(udpTxFree);
+    for (int i = 0; i < UDP_TX_POOL_SIZE; i++) {
+        UDPTxPacket *packet = &udpTxPool[i];
+        xQueueSend(udpTxFree, &packet, 0);
+    }
+
+    // The queues are ready for the link, the access point comes up later
+    wifiStarted = STATIC_MEM_BINARY_SEMAPHORE_CREATE(wifiStarted);
+    isStarting = true;
+    STATIC_MEM_TASK_CREATE_PINNED(wifiStartTask, wifiStartTask, WIFI_START_TASK_NAME, NULL, WIFI_START_TASK_PRI, WIFI_START_TASK_CORE);
+}
+
+LOG_GROUP_START(wifi)
+LOG_ADD(LOG_UINT32, rxDrop, &stats.rxDrop)
+LOG_ADD(LOG_UINT32, txFull, &stats.txFull)
+LOG_ADD(LOG_UINT32, txDrop, &stats.txDrop)
+LOG_ADD(LOG_UINT32, txError, &stats.txError)
+LOG_ADD(LOG_UINT16, txHighWater, &stats.txHighWater)
+LOG_GROUP_STOP(wifi)
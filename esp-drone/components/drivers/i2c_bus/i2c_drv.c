@@ -41,6 +41,7 @@
 #include "stm32_legacy.h"
 #include "i2c_drv.h"
 #include "config.h"
+#include "static_mem.h"
 #define DEBUG_MODULE "I2CDRV"
 #include "debug_cf.h"
 
@@ -50,7 +51,18 @@
 // Definition of eeprom and deck I2C buss,use two i2c with 400Khz clock simultaneously could trigger the watchdog
 #define I2C_DEFAULT_DECK_CLOCK_SPEED                100000
 
-static bool isinit_i2cPort[2] = {0, 0};
+#define I2C_TRANSACTION_QUEUE_LENGTH                4
+#define I2C_TRANSACTION_TIMEOUT                     5
+
+static bool isinit_i2cPort[I2C_NUM_MAX] = {0, 0};
+
+// Task and OS objects of each bus, by port. Named as the STATIC_MEM_* variables
+// to be counted in the static memory report.
+static StackType_t osSys_i2cdrvTaskStackBuffer[I2C_NUM_MAX][I2C_TASK_STACKSIZE];
+static StaticTask_t osSys_i2cdrvTaskTaskBuffer[I2C_NUM_MAX];
+static StaticSemaphore_t osSys_isBusFreeMutexMgm[I2C_NUM_MAX];
+static uint8_t osSys_transactionQueueStorage[I2C_NUM_MAX][I2C_TRANSACTION_QUEUE_LENGTH * sizeof(I2cTransaction *)];
+static StaticQueue_t osSys_transactionQueueMgm[I2C_NUM_MAX];
 
 // Cost definitions of busses
 static const I2cDef sensorBusDef = {
@@ -77,6 +89,33 @@ I2cDrv deckBus = {
     .def                = &deckBusDef,
 };
 
+// Carries out the asynchronous transactions of a bus, one at a time, as the blocking transfers do
+static void i2cdrvTask(void *param)
+{
+    I2cDrv *i2c = (I2cDrv *)param;
+    I2cTransaction *transaction;
+
+    while (1) {
+        if (xQueueReceive(i2c->transactionQueue, &transaction, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        esp_err_t err = ESP_ERR_TIMEOUT;
+        if (xSemaphoreTake(i2c->isBusFreeMutex, (TickType_t)I2C_TRANSACTION_TIMEOUT) == pdTRUE) {
+            err = i2c_master_cmd_begin(i2c->def->i2cPort, transaction->cmd, (TickType_t)I2C_TRANSACTION_TIMEOUT);
+            xSemaphoreGive(i2c->isBusFreeMutex);
+        }
+        i2c_cmd_link_delete_static(transaction->cmd);
+
+        transaction->success = (err == ESP_OK);
+        if (transaction->callback) {
+            transaction->callback(transaction->success, transaction->callbackArg);
+        }
+        // Last access to the transaction, the client may start it again once it is done
+        xSemaphoreGive(transaction->doneSemaphore);
+    }
+}
+
 static void i2cdrvInitBus(I2cDrv *i2c)
 {
     if (isinit_i2cPort[i2c->def->i2cPort]) {
@@ -97,7 +136,12 @@ static void i2cdrvInitBus(I2cDrv *i2c)
     }
 
     DEBUG_PRINTI(" i2c %d driver install return = %d", i2c->def->i2cPort, err);
-    i2c->isBusFreeMutex = xSemaphoreCreateMutex();
+    i2c_port_t port = i2c->def->i2cPort;
+    i2c->isBusFreeMutex = xSemaphoreCreateMutexStatic(&osSys_isBusFreeMutexMgm[port]);
+    i2c->transactionQueue = xQueueCreateStatic(I2C_TRANSACTION_QUEUE_LENGTH, sizeof(I2cTransaction *),
+                                               osSys_transactionQueueStorage[port], &osSys_transactionQueueMgm[port]);
+    xTaskCreateStaticPinnedToCore(i2cdrvTask, I2C_TASK_NAME, I2C_TASK_STACKSIZE, i2c, I2C_TASK_PRI,
+                                  osSys_i2cdrvTaskStackBuffer[port], &osSys_i2cdrvTaskTaskBuffer[port], I2C_TASK_CORE);
     isinit_i2cPort[i2c->def->i2cPort] = true;
 }
 
@@ -114,3 +158,20 @@ void i2cdrvTryToRestartBus(I2cDrv *i2c)
     i2cdrvInitBus(i2c);
 }
 
+bool i2cdrvTransactionStart(I2cDrv *i2c, I2cTransaction *transaction)
+{
+    transaction->success = false;
+    transaction->doneSemaphore = xSemaphoreCreateBinaryStatic(&transaction->doneSemaphoreBuffer);
+
+    if (xQueueSend(i2c->transactionQueue, &transaction, 0) != pdTRUE) {
+        i2c_cmd_link_delete_static(transaction->cmd);
+        return false;
+    }
+    return true;
+}
+
+bool i2cdrvTransactionWait(I2cTransaction *transaction, TickType_t timeout)
+{
+    return xSemaphoreTake(transaction->doneSemaphore, timeout) == pdTRUE;
+}
+
@@ -36,6 +36,71 @@
 #include "nvicconf.h"
 #include "debug_cf.h"
 
+// Command links are built in the static buffers of the bus or of the
+// transaction, sized for the longest transfer below, so no transfer allocates.
+// They can not be built once per register and reused: the driver counts down
+// the bytes of the commands while carrying them out. A build error, a link
+// that did not fit, is returned instead of running a truncated link.
+typedef esp_err_t (*LinkBuilder)(i2c_cmd_handle_t cmd, uint8_t devAddress, const uint8_t *memAddress,
+                                 size_t memAddressLen, uint16_t len, uint8_t *data);
+
+static esp_err_t buildRead(i2c_cmd_handle_t cmd, uint8_t devAddress, const uint8_t *memAddress,
+                           size_t memAddressLen, uint16_t len, uint8_t *data)
+{
+    esp_err_t err = ESP_OK;
+
+    if (memAddressLen > 0) {
+        err |= i2c_master_start(cmd);
+        err |= i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_WRITE, I2C_MASTER_ACK_EN);
+        err |= i2c_master_write(cmd, (uint8_t *)memAddress, memAddressLen, I2C_MASTER_ACK_EN);
+    }
+    err |= i2c_master_start(cmd);
+    err |= i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_READ, I2C_MASTER_ACK_EN);
+    err |= i2c_master_read(cmd, data, len, I2C_MASTER_LAST_NACK);
+    err |= i2c_master_stop(cmd);
+    return err == ESP_OK ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static esp_err_t buildWrite(i2c_cmd_handle_t cmd, uint8_t devAddress, const uint8_t *memAddress,
+                            size_t memAddressLen, uint16_t len, uint8_t *data)
+{
+    esp_err_t err = ESP_OK;
+
+    err |= i2c_master_start(cmd);
+    err |= i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_WRITE, I2C_MASTER_ACK_EN);
+    if (memAddressLen > 0) {
+        err |= i2c_master_write(cmd, (uint8_t *)memAddress, memAddressLen, I2C_MASTER_ACK_EN);
+    }
+    err |= i2c_master_write(cmd, data, len, I2C_MASTER_ACK_EN);
+    err |= i2c_master_stop(cmd);
+    return err == ESP_OK ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static esp_err_t buildReadReg8(i2c_cmd_handle_t cmd, uint8_t devAddress, uint8_t memAddress,
+                               uint16_t len, uint8_t *data)
+{
+    return buildRead(cmd, devAddress, &memAddress, memAddress != I2CDEV_NO_MEM_ADDR ? 1 : 0, len, data);
+}
+
+static esp_err_t buildWriteReg8(i2c_cmd_handle_t cmd, uint8_t devAddress, uint8_t memAddress,
+                                uint16_t len, uint8_t *data)
+{
+    return buildWrite(cmd, devAddress, &memAddress, memAddress != I2CDEV_NO_MEM_ADDR ? 1 : 0, len, data);
+}
+
+// Builds the link in the buffer of the bus and carries it out, with the mutex of the bus taken
+static esp_err_t runOnBus(I2C_Dev *dev, LinkBuilder build, uint8_t devAddress, const uint8_t *memAddress,
+                          size_t memAddressLen, uint16_t len, uint8_t *data)
+{
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(dev->linkBuffer, sizeof(dev->linkBuffer));
+    esp_err_t err = build(cmd, devAddress, memAddress, memAddressLen, len, data);
+    if (err == ESP_OK) {
+        err = i2c_master_cmd_begin(dev->def->i2cPort, cmd, (TickType_t)5);
+    }
+    i2c_cmd_link_delete_static(cmd);
+    return err;
+}
+
 int i2cdevInit(I2C_Dev *dev)
 {
     i2cdrvInit(dev);
@@ -88,18 +153,8 @@ bool i2cdevReadReg8(I2C_Dev *dev, uint8_t devAddress, uint8_t memAddress,
         return false;
     }
 
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    if (memAddress != I2CDEV_NO_MEM_ADDR) {
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_WRITE, I2C_MASTER_ACK_EN);
-        i2c_master_write_byte(cmd, memAddress, I2C_MASTER_ACK_EN);
-    }
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_READ, I2C_MASTER_ACK_EN);
-    i2c_master_read(cmd, data, len, I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t err = i2c_master_cmd_begin(dev->def->i2cPort, cmd, (TickType_t)5);
-    i2c_cmd_link_delete(cmd);
+    esp_err_t err = runOnBus(dev, buildRead, devAddress, &memAddress,
+                             memAddress != I2CDEV_NO_MEM_ADDR ? 1 : 0, len, data);
 
     xSemaphoreGive(dev->isBusFreeMutex);
 
@@ -147,18 +202,8 @@ bool i2cdevReadReg16(I2C_Dev *dev, uint8_t devAddress, uint16_t memAddress,
     uint8_t memAddress8[2];
     memAddress8[0] = (uint8_t)((memAddress >> 8) & 0x00FF);
     memAddress8[1] = (uint8_t)(memAddress & 0x00FF);
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    if (memAddress != I2C_NO_INTERNAL_ADDRESS) {
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_WRITE, I2C_MASTER_ACK_EN);
-        i2c_master_write(cmd, memAddress8, 2, I2C_MASTER_ACK_EN);
-    }
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_READ, I2C_MASTER_ACK_EN);
-    i2c_master_read(cmd, data, len, I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t err = i2c_master_cmd_begin(dev->def->i2cPort, cmd, (TickType_t)5);
-    i2c_cmd_link_delete(cmd);
+    esp_err_t err = runOnBus(dev, buildRead, devAddress, memAddress8,
+                             memAddress != I2C_NO_INTERNAL_ADDRESS ? 2 : 0, len, data);
 
     xSemaphoreGive(dev->isBusFreeMutex);
 
@@ -237,16 +282,8 @@ bool i2cdevWriteReg8(I2C_Dev *dev, uint8_t devAddress, uint8_t memAddress,
         return false;
     }
 
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_WRITE, I2C_MASTER_ACK_EN);
-    if (memAddress != I2CDEV_NO_MEM_ADDR) {
-        i2c_master_write_byte(cmd, memAddress, I2C_MASTER_ACK_EN);
-    }
-    i2c_master_write(cmd, (uint8_t *)data, len, I2C_MASTER_ACK_EN);
-    i2c_master_stop(cmd);
-    esp_err_t err = i2c_master_cmd_begin(dev->def->i2cPort, cmd, (TickType_t)5);
-    i2c_cmd_link_delete(cmd);
+    esp_err_t err = runOnBus(dev, buildWrite, devAddress, &memAddress,
+                             memAddress != I2CDEV_NO_MEM_ADDR ? 1 : 0, len, data);
 
     xSemaphoreGive(dev->isBusFreeMutex);
 
@@ -294,16 +331,8 @@ bool i2cdevWriteReg16(I2C_Dev *dev, uint8_t devAddress, uint16_t memAddress,
     uint8_t memAddress8[2];
     memAddress8[0] = (uint8_t)((memAddress >> 8) & 0x00FF);
     memAddress8[1] = (uint8_t)(memAddress & 0x00FF);
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (devAddress << 1) | I2C_MASTER_WRITE, I2C_MASTER_ACK_EN);
-    if (memAddress != I2C_NO_INTERNAL_ADDRESS) {
-        i2c_master_write(cmd, memAddress8, 2, I2C_MASTER_ACK_EN);
-    }
-    i2c_master_write(cmd, (uint8_t *)data, len, I2C_MASTER_ACK_EN);
-    i2c_master_stop(cmd);
-    esp_err_t err = i2c_master_cmd_begin(dev->def->i2cPort, cmd, (TickType_t)5);
-    i2c_cmd_link_delete(cmd);
+    esp_err_t err = runOnBus(dev, buildWrite, devAddress, memAddress8,
+                             memAddress != I2C_NO_INTERNAL_ADDRESS ? 2 : 0, len, data);
 
     xSemaphoreGive(dev->isBusFreeMutex);
 #if defined CONFIG_I2CBUS_LOG_READWRITES
@@ -340,3 +369,34 @@ bool i2cdevWriteReg16(I2C_Dev *dev, uint8_t devAddress, uint16_t memAddress,
         return false;
     }
 }
+
+bool i2cdevReadReg8Async(I2C_Dev *dev, I2cTransaction *transaction, uint8_t devAddress, uint8_t memAddress,
+                         uint16_t len, uint8_t *data, I2cTransactionCallback callback, void *arg)
+{
+    transaction->cmd = i2c_cmd_link_create_static(transaction->linkBuffer, sizeof(transaction->linkBuffer));
+    if (buildReadReg8(transaction->cmd, devAddress, memAddress, len, data) != ESP_OK) {
+        i2c_cmd_link_delete_static(transaction->cmd);
+        return false;
+    }
+    transaction->callback = callback;
+    transaction->callbackArg = arg;
+    return i2cdrvTransactionStart(dev, transaction);
+}
+
+bool i2cdevWriteReg8Async(I2C_Dev *dev, I2cTransaction *transaction, uint8_t devAddress, uint8_t memAddress,
+                          uint16_t len, uint8_t *data, I2cTransactionCallback callback, void *arg)
+{
+    transaction->cmd = i2c_cmd_link_create_static(transaction->linkBuffer, sizeof(transaction->linkBuffer));
+    if (buildWriteReg8(transaction->cmd, devAddress, memAddress, len, data) != ESP_OK) {
+        i2c_cmd_link_delete_static(transaction->cmd);
+        return false;
+    }
+    transaction->callback = callback;
+    transaction->callbackArg = arg;
+    return i2cdrvTransactionStart(dev, transaction);
+}
+
+bool i2cdevWaitAsync(I2cTransaction *transaction, TickType_t timeout)
+{
+    return i2cdrvTransactionWait(transaction, timeout) && transaction->success;
+}
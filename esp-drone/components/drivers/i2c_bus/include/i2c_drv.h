@@ -44,11 +44,34 @@ typedef struct {
     gpio_pullup_t       gpioPullup;
 } I2cDef;
 
+// Command link of one transaction: a register address write, then a read or write of the data
+#define I2C_TRANSACTION_LINK_SIZE I2C_LINK_RECOMMENDED_SIZE(2)
+
 typedef struct {
     const I2cDef *def;                    //< Definition of the i2c
     SemaphoreHandle_t isBusFreeMutex;     //< Mutex to protect buss
+    uint8_t linkBuffer[I2C_TRANSACTION_LINK_SIZE]; //< Command link of the blocking transfers, used with the mutex taken
+    QueueHandle_t transactionQueue;       //< Asynchronous transactions waiting for the bus
 } I2cDrv;
 
+typedef void (*I2cTransactionCallback)(bool success, void *arg);
+
+/**
+ * An asynchronous transfer, carried out by the task of the bus. The
+ * structure, and the data it points to, must stay valid until
+ * i2cdrvTransactionWait() returned true, which is also when it can be
+ * started again.
+ */
+typedef struct {
+    uint8_t             linkBuffer[I2C_TRANSACTION_LINK_SIZE];
+    i2c_cmd_handle_t    cmd;              //< Command link built in linkBuffer
+    I2cTransactionCallback callback;      //< Called by the task of the bus when done, NULL if none
+    void                *callbackArg;
+    SemaphoreHandle_t   doneSemaphore;
+    StaticSemaphore_t   doneSemaphoreBuffer;
+    bool                success;
+} I2cTransaction;
+
 // Definitions of i2c busses found in c file.
 extern I2cDrv deckBus;
 extern I2cDrv sensorsBus;
@@ -70,6 +93,26 @@ void i2cdrvInit(I2cDrv *i2c);
  */
 bool i2cdrvMessageTransfer(I2cDrv *i2c, I2cMessage *message);
 
+/**
+ * Queue a transaction, whose command link is built, to the task of the bus.
+ * Returns right away: completion is signaled by the callback of the
+ * transaction and by i2cdrvTransactionWait().
+ *
+ * @param i2c          i2c bus to use.
+ * @param transaction  Transaction to carry out.
+ * @return             true if queued, false if the queue of the bus is full.
+ */
+bool i2cdrvTransactionStart(I2cDrv *i2c, I2cTransaction *transaction);
+
+/**
+ * Wait for a queued transaction to be done.
+ *
+ * @param transaction  Transaction started with i2cdrvTransactionStart().
+ * @param timeout      Ticks to wait.
+ * @return             true if the transfer is done, whether successful is in transaction->success.
+ */
+bool i2cdrvTransactionWait(I2cTransaction *transaction, TickType_t timeout);
+
 
 /**
  * Create a message to transfer
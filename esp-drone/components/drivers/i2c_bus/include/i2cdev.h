@@ -203,4 +203,48 @@ bool i2cdevWriteBit(I2C_Dev *dev, uint8_t devAddress, uint8_t memAddress,
 bool i2cdevWriteBits(I2C_Dev *dev, uint8_t devAddress, uint8_t memAddress,
                      uint8_t bitStart, uint8_t length, uint8_t data);
 
+/**
+ * Start reading bytes from an I2C peripheral, without waiting for the transfer.
+ * The transfer is carried out by the task of the bus, in turn with the blocking
+ * transfers, and data is valid once it is done.
+ * @param dev  Pointer to I2C peripheral to read from
+ * @param transaction  Transaction to use, valid until i2cdevWaitAsync() returned
+ * @param devAddress  The device address to read from
+ * @param memAddress  The internal address to read from, I2CDEV_NO_MEM_ADDR if none.
+ * @param len  Number of bytes to read.
+ * @param data  Pointer to a buffer to read the data to.
+ * @param callback  Called from the task of the bus when the transfer is done, NULL if none.
+ * @param arg  Argument of the callback.
+ *
+ * @return TRUE if the transfer was queued, otherwise FALSE.
+ */
+bool i2cdevReadReg8Async(I2C_Dev *dev, I2cTransaction *transaction, uint8_t devAddress, uint8_t memAddress,
+                         uint16_t len, uint8_t *data, I2cTransactionCallback callback, void *arg);
+
+/**
+ * Start writing bytes to an I2C peripheral, without waiting for the transfer.
+ * @param dev  Pointer to I2C peripheral to write to
+ * @param transaction  Transaction to use, valid until i2cdevWaitAsync() returned
+ * @param devAddress  The device address to write to
+ * @param memAddress  The internal address to write to, I2CDEV_NO_MEM_ADDR if none.
+ * @param len  Number of bytes to write.
+ * @param data  Pointer to the data to write, valid until the transfer is done.
+ * @param callback  Called from the task of the bus when the transfer is done, NULL if none.
+ * @param arg  Argument of the callback.
+ *
+ * @return TRUE if the transfer was queued, otherwise FALSE.
+ */
+bool i2cdevWriteReg8Async(I2C_Dev *dev, I2cTransaction *transaction, uint8_t devAddress, uint8_t memAddress,
+                          uint16_t len, uint8_t *data, I2cTransactionCallback callback, void *arg);
+
+/**
+ * Wait for an asynchronous transfer. Must be called once for every transfer
+ * started, also when a callback is used, before the transaction is used again.
+ * @param transaction  Transaction of the transfer
+ * @param timeout  Ticks to wait.
+ *
+ * @return TRUE if the transfer is done and was successful, otherwise FALSE.
+ */
+bool i2cdevWaitAsync(I2cTransaction *transaction, TickType_t timeout);
+
 #endif //__I2CDEV_H__
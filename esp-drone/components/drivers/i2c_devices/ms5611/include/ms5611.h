@@ -48,6 +48,8 @@
 #define MS5611_OSR_2048 0x06
 #define MS5611_OSR_4096 0x08
 #define MS5611_OSR_DEFAULT MS5611_OSR_4096
+// Longest conversion time of the default OSR, 9.04 ms in the datasheet
+#define MS5611_CONVERSION_TIME_US 10000
 
 #define MS5611_PROM_BASE_ADDR 0xA2 // by adding ints from 0 to 6 we can read all the prom configuration values.
 // C1 will be at 0xA2 and all the subsequent are multiples of 2
@@ -83,5 +85,13 @@ void ms5611StartConversion(uint8_t command);
 int32_t ms5611GetConversion(uint8_t command);
 
 void ms5611GetData(float *pressure, float *temperature, float *asl);
+/**
+ * Reads the finished conversion and starts the next one, without the pacing
+ * of ms5611GetData(). The caller must leave MS5611_CONVERSION_TIME_US between
+ * the calls.
+ */
+void ms5611ConversionStep(float *pressure, float *temperature, float *asl);
+// Latest pressure and temperature, without a bus transfer
+void ms5611GetSavedData(float *pressure, float *temperature);
 float ms5611PressureToAltitude(float *pressure);
 #endif // MS5611_H
@@ -62,6 +62,7 @@ static int32_t  tempCache;
 static uint8_t readState = 0;
 static uint32_t lastConv = 0;
 static int32_t tempDeltaT;
+static float savedPress, savedTemp;
 
 bool ms5611Init(I2C_Dev *i2cPort)
 {
@@ -313,19 +314,27 @@ void ms5611Reset()
  */
 void ms5611GetData(float *pressure, float *temperature, float *asl)
 {
-    int32_t tempPressureRaw, tempTemperatureRaw;
-    static float savedPress, savedTemp;
-
     // Dont reader faster than we can
     uint32_t now = xTaskGetTickCount();
 
     if ((now - lastConv) < CONVERSION_TIME_MS) {
-        *pressure = savedPress;
-        *temperature = savedTemp;
+        ms5611GetSavedData(pressure, temperature);
         return;
     }
 
     lastConv = now;
+    ms5611ConversionStep(pressure, temperature, asl);
+}
+
+void ms5611GetSavedData(float *pressure, float *temperature)
+{
+    *pressure = savedPress;
+    *temperature = savedTemp;
+}
+
+void ms5611ConversionStep(float *pressure, float *temperature, float *asl)
+{
+    int32_t tempPressureRaw, tempTemperatureRaw;
 
     if (readState == 0) {
         // read temp
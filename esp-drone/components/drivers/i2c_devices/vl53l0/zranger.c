@@ -32,6 +32,7 @@
 #include "param.h"
 #include "range.h"
 #include "config.h"
+#include "static_mem.h"
 #include "i2cdev.h"
 #include "zranger.h"
 #include "vl53l0x.h"
@@ -52,6 +53,8 @@ static uint16_t range_last = 0;
 
 static bool isInit;
 
+STATIC_MEM_TASK_ALLOC(zRangerTask, ZRANGER_TASK_STACKSIZE);
+
 static VL53L0xDev dev;
 
 static uint8_t vl53l0dataReady = 0;
@@ -145,7 +148,7 @@ void zRangerInit(void)
 
   vl53l0xInit(&dev, I2C1_DEV, true);
 
-  xTaskCreate(zRangerTask, ZRANGER_TASK_NAME, ZRANGER_TASK_STACKSIZE, NULL, ZRANGER_TASK_PRI, NULL);
+  STATIC_MEM_TASK_CREATE_PINNED(zRangerTask, zRangerTask, ZRANGER_TASK_NAME, NULL, ZRANGER_TASK_PRI, ZRANGER_TASK_CORE);
 
   // pre-compute constant in the measurement noise model for kalman
   expCoeff = logf(expStdB / expStdA) / (expPointB - expPointA);
@@ -28,8 +28,13 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#ifdef CONFIG_ZRANGER2_INTERRUPT
+#include "driver/gpio.h"
+#endif
 
 #include "config.h"
+#include "static_mem.h"
 #include "system.h"
 #include "log.h"
 #include "param.h"
@@ -37,6 +42,10 @@
 #include "i2cdev.h"
 #include "zranger2.h"
 #include "vl53l1x.h"
+#ifdef CONFIG_ZRANGER2_INTERRUPT
+#include "vl53l1_register_map.h"
+#include "vl53l1_register_settings.h"
+#endif
 #include "cf_math.h"
 #define DEBUG_MODULE "ZR2"
 #include "debug_cf.h"
@@ -49,13 +58,86 @@ static const float expStdB = 0.2f; // STD at elevation expPointB [m]
 static float expCoeff;
 
 #define RANGE_OUTLIER_LIMIT 5000 // the measured range is in [mm]
+#define TIMING_BUDGET_MS 25 // measurement timing budget, also the measurement period
 
 static int16_t range_last = 0;
 
 static bool isInit;
 
+STATIC_MEM_TASK_ALLOC(zRanger2Task, ZRANGER2_TASK_STACKSIZE);
+
 static VL53L1_Dev_t dev;
 
+#ifdef CONFIG_ZRANGER2_INTERRUPT
+#define ZRANGER2_PIN_INT CONFIG_ZRANGER2_PIN_INT
+#define ESP_INTR_FLAG_DEFAULT 0
+// Wait for a range after which the ranging is restarted, in case an edge was missed
+#define RANGE_TIMEOUT_MS (4 * TIMING_BUDGET_MS)
+
+static xSemaphoreHandle rangeReady;
+static StaticSemaphore_t rangeReadyBuffer;
+static volatile uint32_t rangeReadyTick;
+static uint16_t rangeTimeouts = 0;
+
+static void IRAM_ATTR zRanger2IsrHandler(void *arg)
+{
+  portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+  rangeReadyTick = xTaskGetTickCountFromISR();
+  xSemaphoreGiveFromISR(rangeReady, &xHigherPriorityTaskWoken);
+
+  if (xHigherPriorityTaskWoken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+static void zRanger2InterruptInit(VL53L1_Dev_t *dev)
+{
+  uint8_t muxCtrl = 0;
+
+  // Polarity of GPIO1 as set by the static init
+  VL53L1_RdByte(dev, VL53L1_GPIO_HV_MUX__CTRL, &muxCtrl);
+  gpio_config_t io_conf = {
+    .intr_type = (muxCtrl & VL53L1_DEVICEINTERRUPTPOLARITY_BIT_MASK) ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE,
+    .pin_bit_mask = (1ULL << ZRANGER2_PIN_INT),
+    .mode = GPIO_MODE_INPUT,
+    .pull_down_en = 0,
+    .pull_up_en = 1,
+  };
+
+  rangeReady = xSemaphoreCreateBinaryStatic(&rangeReadyBuffer);
+  gpio_config(&io_conf);
+  // Fails harmlessly when the IMU interrupt has installed it already
+  gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
+  gpio_isr_handler_add(ZRANGER2_PIN_INT, zRanger2IsrHandler, NULL);
+}
+
+/**
+ * Reads only the range and its status, three bytes instead of the result blocks
+ * decoded by VL53L1_GetRangingMeasurementData(), and starts the next range.
+ *
+ * @return true if the range is valid
+ */
+static bool zRanger2FetchRange(VL53L1_Dev_t *dev, int16_t *range)
+{
+  uint8_t rangeStatus = 0;
+  uint16_t rawRange = 0;
+
+  VL53L1_Error status = VL53L1_RdByte(dev, VL53L1_RESULT__RANGE_STATUS, &rangeStatus);
+  if (status == VL53L1_ERROR_NONE) {
+    status = VL53L1_RdWord(dev, VL53L1_RESULT__FINAL_CROSSTALK_CORRECTED_RANGE_MM_SD0, &rawRange);
+  }
+  VL53L1_ClearInterruptAndStartMeasurement(dev);
+
+  // Correction gain, ufix 5.11, as applied by the API to the same register
+  int32_t gainFactor = VL53L1DevStructGetLLDriverHandle(dev)->gain_cal.standard_ranging_gain_factor;
+  *range = (int16_t)(((int32_t)rawRange * gainFactor + 0x0400) / 0x0800);
+
+  rangeStatus &= VL53L1_RANGE_STATUS__RANGE_STATUS_MASK;
+  return status == VL53L1_ERROR_NONE &&
+         (rangeStatus == VL53L1_DEVICEERROR_RANGECOMPLETE ||
+          rangeStatus == VL53L1_DEVICEERROR_RANGECOMPLETE_NO_WRAP_CHECK);
+}
+#else
 static uint16_t zRanger2GetMeasurementAndRestart(VL53L1_Dev_t *dev)
 {
     VL53L1_Error status = VL53L1_ERROR_NONE;
@@ -78,6 +160,22 @@ static uint16_t zRanger2GetMeasurementAndRestart(VL53L1_Dev_t *dev)
 
     return range;
 }
+#endif
+
+static void zRanger2PushRange(uint32_t measurementTick)
+{
+  rangeSet(rangeDown, range_last / 1000.0f);
+
+  // check if range is feasible and push into the estimator
+  // the sensor should not be able to measure >5 [m], and outliers typically
+  // occur as >8 [m] measurements
+  if (range_last < RANGE_OUTLIER_LIMIT) {
+    float distance = (float)range_last * 0.001f; // Scale from [mm] to [m]
+    float stdDev = expStdA * (1.0f  + expf( expCoeff * (distance - expPointA)));
+    // The range is averaged over the timing budget, timestamp the middle of it
+    rangeEnqueueDownRangeInEstimator(distance, stdDev, measurementTick - M2T(TIMING_BUDGET_MS / 2));
+  }
+}
 
 void zRanger2Init(void)
 {
@@ -94,7 +192,7 @@ void zRanger2Init(void)
     return;
   }
 
-  xTaskCreate(zRanger2Task, ZRANGER2_TASK_NAME, ZRANGER2_TASK_STACKSIZE, NULL, ZRANGER2_TASK_PRI, NULL);
+  STATIC_MEM_TASK_CREATE_PINNED(zRanger2Task, zRanger2Task, ZRANGER2_TASK_NAME, NULL, ZRANGER2_TASK_PRI, ZRANGER2_TASK_CORE);
 
   // pre-compute constant in the measurement noise model for kalman
   expCoeff = logf(expStdB / expStdA) / (expPointB - expPointA);
@@ -112,36 +210,54 @@ bool zRanger2Test(void)
 
 void zRanger2Task(void* arg)
 {
-  TickType_t lastWakeTime;
-
   systemWaitStart();
 
   // Restart sensor
   VL53L1_StopMeasurement(&dev);
   VL53L1_SetDistanceMode(&dev, VL53L1_DISTANCEMODE_MEDIUM);
-  VL53L1_SetMeasurementTimingBudgetMicroSeconds(&dev, 25000);
+  VL53L1_SetMeasurementTimingBudgetMicroSeconds(&dev, TIMING_BUDGET_MS * 1000);
+
+#ifdef CONFIG_ZRANGER2_INTERRUPT
+  zRanger2InterruptInit(&dev);
+
+  // Back to back ranging, GPIO1 signals each range
+  VL53L1_StartMeasurement(&dev);
+
+  while (1) {
+    if (xSemaphoreTake(rangeReady, M2T(RANGE_TIMEOUT_MS)) != pdTRUE) {
+      rangeTimeouts++;
+      VL53L1_ClearInterruptAndStartMeasurement(&dev);
+      continue;
+    }
+
+    int16_t range;
+    if (zRanger2FetchRange(&dev, &range)) {
+      range_last = range;
+      zRanger2PushRange(rangeReadyTick);
+    }
+  }
+#else
+  TickType_t lastWakeTime;
 
   VL53L1_StartMeasurement(&dev);
 
   lastWakeTime = xTaskGetTickCount();
 
   while (1) {
-    vTaskDelayUntil(&lastWakeTime, M2T(25));
+    vTaskDelayUntil(&lastWakeTime, M2T(TIMING_BUDGET_MS));
 
     range_last = zRanger2GetMeasurementAndRestart(&dev);
-    rangeSet(rangeDown, range_last / 1000.0f);
-
-    // check if range is feasible and push into the estimator
-    // the sensor should not be able to measure >5 [m], and outliers typically
-    // occur as >8 [m] measurements
-    if (range_last < RANGE_OUTLIER_LIMIT) {
-      float distance = (float)range_last * 0.001f; // Scale from [mm] to [m]
-      float stdDev = expStdA * (1.0f  + expf( expCoeff * (distance - expPointA)));
-      rangeEnqueueDownRangeInEstimator(distance, stdDev, xTaskGetTickCount());
-    }
+    zRanger2PushRange(xTaskGetTickCount());
   }
+#endif
 }
 
+#ifdef CONFIG_ZRANGER2_INTERRUPT
+LOG_GROUP_START(zranger2)
+LOG_ADD(LOG_UINT16, timeouts, &rangeTimeouts)
+LOG_GROUP_STOP(zranger2)
+#endif
+
 static uint8_t disable = 0;
 #define PARAM_CORE (1<<5)
 #define PARAM_PERSISTENT (1 << 8)
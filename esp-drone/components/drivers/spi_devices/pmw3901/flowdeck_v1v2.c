@@ -27,6 +27,9 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#ifdef CONFIG_FLOW_QUEUED_READS
+#include "esp_timer.h"
+#endif
 
 #include "pmw3901.h"
 #include "system.h"
@@ -34,6 +37,7 @@
 #include "param.h"
 #include "sleepus.h"
 #include "config.h"
+#include "static_mem.h"
 #include "stabilizer_types.h"
 #include "estimator.h"
 #include "cf_math.h"
@@ -63,6 +67,8 @@ static float stdFlow = 2.0f;
 static bool isInit1 = false;
 static bool isInit2 = false;
 
+STATIC_MEM_TASK_ALLOC(flowdeckTask, FLOW_TASK_STACKSIZE);
+
 motionBurst_t currentMotion;
 
 // Disables pushing the flow measurement in the EKF
@@ -77,6 +83,22 @@ static float flowStdFixed = 2.0f;
 
 #define NCS_PIN CONFIG_SPI_PIN_CS0
 
+#ifdef CONFIG_FLOW_QUEUED_READS
+// Reads are started by a timer and collected by the flow task
+#define FLOW_READ_PERIOD_US (1000000 / CONFIG_FLOW_READ_RATE_HZ)
+#define FLOW_READ_TIMEOUT M2T(100)
+
+static esp_timer_handle_t readTimer;
+// Timer periods in which the previous read was not collected yet
+static uint16_t lateReads = 0;
+
+static void readTimerCallback(void *arg)
+{
+    if (!pmw3901QueueMotion()) {
+        lateReads++;
+    }
+}
+#endif
 
 static void flowdeckTask(void *param)
 {
@@ -84,7 +106,22 @@ static void flowdeckTask(void *param)
     initUsecTimer();
     uint64_t lastTime  = usecTimestamp();
 
+#ifdef CONFIG_FLOW_QUEUED_READS
+    const esp_timer_create_args_t timerArgs = {
+        .callback = readTimerCallback,
+        .name = "flowRead",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &readTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(readTimer, FLOW_READ_PERIOD_US));
+#endif
+
     while (1) {
+        uint64_t readTime;
+#ifdef CONFIG_FLOW_QUEUED_READS
+        if (!pmw3901WaitMotion(&currentMotion, &readTime, FLOW_READ_TIMEOUT)) {
+            continue;
+        }
+#else
 // if task watchdog triggered,flow frequency should set lower
 #if CONFIG_FREERTOS_UNICORE
         vTaskDelay(10);
@@ -93,6 +130,11 @@ static void flowdeckTask(void *param)
 #endif
 
         pmw3901ReadMotion(NCS_PIN, &currentMotion);
+        readTime = usecTimestamp();
+#endif
+        // Reading the motion clears the accumulated pixels
+        const uint64_t interval = readTime - lastTime;
+        lastTime = readTime;
 
         // Flip motion information to comply with sensor mounting
         // (might need to be changed if mounted differently)
@@ -157,8 +199,10 @@ static void flowdeckTask(void *param)
 
             // Push measurements into the estimator
             if (!useFlowDisabled && currentMotion.motion == 0xB0) {
-                flowData.dt = (float)(usecTimestamp()-lastTime)/1000000.0f;
-                lastTime = usecTimestamp();
+                flowData.dt = (float)interval/1000000.0f;
+                // The pixels were accumulated since the last read, timestamp the middle of the interval
+                const uint64_t age = usecTimestamp() - readTime + interval / 2;
+                flowData.timestamp = xTaskGetTickCount() - M2T((uint32_t)(age / 1000));
                 estimatorEnqueueFlow(&flowData);
             }
         } else {
@@ -209,7 +253,12 @@ void flowdeck2Init()
     // zRanger->init(NULL);
 
     if (pmw3901Init(NCS_PIN)) {
-        xTaskCreate(flowdeckTask, FLOW_TASK_NAME, FLOW_TASK_STACKSIZE, NULL, FLOW_TASK_PRI, NULL);
+#ifdef CONFIG_FLOW_QUEUED_READS
+        if (!pmw3901InitMotionQueue(NCS_PIN)) {
+            return;
+        }
+#endif
+        STATIC_MEM_TASK_CREATE_PINNED(flowdeckTask, flowdeckTask, FLOW_TASK_NAME, NULL, FLOW_TASK_PRI, FLOW_TASK_CORE);
 
         isInit2 = true;
     }
@@ -238,6 +287,9 @@ LOG_ADD(LOG_UINT8, Rawsum, &currentMotion.rawDataSum)
 LOG_ADD(LOG_UINT8, outlierCount, &outlierCount)
 LOG_ADD(LOG_UINT8, squal, &currentMotion.squal)
 LOG_ADD(LOG_FLOAT, std, &stdFlow)
+#ifdef CONFIG_FLOW_QUEUED_READS
+LOG_ADD(LOG_UINT16, lateReads, &lateReads)
+#endif
 LOG_GROUP_STOP(motion)
 
 PARAM_GROUP_START(motion)
@@ -68,5 +68,34 @@ bool pmw3901Init(uint32_t csPin);
  */
 void pmw3901ReadMotion(uint32_t csPin, motionBurst_t *motion);
 
+/**
+ * Set up the motion burst reads of pmw3901QueueMotion(), done by DMA without
+ * waiting. pmw3901Init() must have succeeded.
+ *
+ * @param csPin Chip Select pin as defined in deck pinout driver.
+ *
+ * @return  true if the SPI device could be added.
+ */
+bool pmw3901InitMotionQueue(uint32_t csPin);
+
+/**
+ * Start reading the accumulated motion and return at once. Can be called from
+ * a timer callback.
+ *
+ * @return  false if the previous read has not been collected yet.
+ */
+bool pmw3901QueueMotion(void);
+
+/**
+ * Wait for the read started by pmw3901QueueMotion().
+ *
+ * @param motion     A filled in motionBurst_t structure with the motion information
+ * @param timestamp  Time the read started, when the sensor latched the motion, in us
+ * @param timeout    Ticks to wait for the read
+ *
+ * @return  true if a read was collected.
+ */
+bool pmw3901WaitMotion(motionBurst_t *motion, uint64_t *timestamp, uint32_t timeout);
+
 
 #endif /* PMW3901_H_ */
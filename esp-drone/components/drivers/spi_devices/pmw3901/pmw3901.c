@@ -24,6 +24,10 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+
 #include "pmw3901.h"
 #include "system.h"
 #include "log.h"
@@ -35,8 +39,18 @@
 #define DEBUG_MODULE "PMW"
 #include "debug_cf.h"
 
+#define MOTION_BURST_REG 0x16
+// Wait between the burst address and the data, as the sleepus(50) of pmw3901ReadMotion()
+#define MOTION_BURST_DUMMY_BITS (50 * (SPI_BAUDRATE_2MHZ / 1000000))
+
 static bool isInit = false;
 
+static spi_device_handle_t motionDevice;
+static spi_transaction_t motionTransaction;
+static DMA_ATTR WORD_ALIGNED_ATTR uint8_t motionBuffer[(sizeof(motionBurst_t) + 3) & ~3];
+static uint32_t motionCsPin;
+static volatile uint64_t motionTimestamp;
+
 static void registerWrite(uint32_t csPin, uint8_t reg, uint8_t value)
 {
     // Set MSB to 1 for write
@@ -214,6 +228,13 @@ bool pmw3901Init(uint32_t csPin)
     return isInit;
 }
 
+static void swapShutterBytes(motionBurst_t *motion)
+{
+    uint16_t realShutter = (motion->shutter >> 8) & 0x0FF;
+    realShutter |= (motion->shutter & 0x0ff) << 8;
+    motion->shutter = realShutter;
+}
+
 void pmw3901ReadMotion(uint32_t csPin, motionBurst_t *motion)
 {
     uint8_t address = 0x16;
@@ -229,7 +250,71 @@ void pmw3901ReadMotion(uint32_t csPin, motionBurst_t *motion)
     spiEndTransaction();
     sleepus(50);
 
-    uint16_t realShutter = (motion->shutter >> 8) & 0x0FF;
-    realShutter |= (motion->shutter & 0x0ff) << 8;
-    motion->shutter = realShutter;
+    swapShutterBytes(motion);
+}
+
+// Called by the SPI driver from its interrupt around the queued reads
+static void motionPreTransfer(spi_transaction_t *t)
+{
+    gpio_set_level(motionCsPin, 0);
+    motionTimestamp = esp_timer_get_time();
+}
+
+static void motionPostTransfer(spi_transaction_t *t)
+{
+    gpio_set_level(motionCsPin, 1);
+}
+
+bool pmw3901InitMotionQueue(uint32_t csPin)
+{
+    if (!isInit) {
+        return false;
+    }
+
+    // Half duplex, so that the register address and the wait before the data are
+    // the command and dummy phases of a single transaction
+    spi_device_interface_config_t devcfg = {
+        .command_bits = 8,
+        .dummy_bits = MOTION_BURST_DUMMY_BITS,
+        .mode = 3,
+        .clock_speed_hz = SPI_BAUDRATE_2MHZ,
+        .spics_io_num = -1,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+        .queue_size = 1,
+        .pre_cb = motionPreTransfer,
+        .post_cb = motionPostTransfer,
+    };
+
+    motionCsPin = csPin;
+    if (spi_bus_add_device(SPI_DECK_HOST, &devcfg, &motionDevice) != ESP_OK) {
+        DEBUG_PRINTW("Could not add the motion burst SPI device\n");
+        return false;
+    }
+
+    motionTransaction.cmd = MOTION_BURST_REG;
+    motionTransaction.rxlength = sizeof(motionBurst_t) * 8;
+    motionTransaction.rx_buffer = motionBuffer;
+
+    return true;
+}
+
+bool pmw3901QueueMotion(void)
+{
+    return spi_device_queue_trans(motionDevice, &motionTransaction, 0) == ESP_OK;
+}
+
+bool pmw3901WaitMotion(motionBurst_t *motion, uint64_t *timestamp, uint32_t timeout)
+{
+    spi_transaction_t *done;
+
+    if (spi_device_get_trans_result(motionDevice, &done, timeout) != ESP_OK) {
+        return false;
+    }
+
+    memcpy(motion, motionBuffer, sizeof(motionBurst_t));
+    *timestamp = motionTimestamp;
+
+    swapShutterBytes(motion);
+
+    return true;
 }
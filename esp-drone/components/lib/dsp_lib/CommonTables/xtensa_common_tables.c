@@ -164,6 +164,7 @@ const uint16_t xtensaBitRevTable[1024] = {
 * Cos and Sin values are in interleaved fashion
 *
 */
+#ifdef XTENSA_RFFT_LEN_32
 const float32_t twiddleCoef_16[32] = {
     1.000000000f,  0.000000000f,
     0.923879533f,  0.382683432f,
@@ -182,6 +183,7 @@ const float32_t twiddleCoef_16[32] = {
     0.707106781f, -0.707106781f,
     0.923879533f, -0.382683432f
 };
+#endif
 
 /**
 * \par
@@ -198,6 +200,7 @@ const float32_t twiddleCoef_16[32] = {
 * Cos and Sin values are in interleaved fashion
 *
 */
+#ifdef XTENSA_RFFT_LEN_64
 const float32_t twiddleCoef_32[64] = {
     1.000000000f,  0.000000000f,
     0.980785280f,  0.195090322f,
@@ -232,6 +235,7 @@ const float32_t twiddleCoef_32[64] = {
     0.923879533f, -0.382683432f,
     0.980785280f, -0.195090322f
 };
+#endif
 
 /**
 * \par
@@ -248,6 +252,7 @@ const float32_t twiddleCoef_32[64] = {
 * Cos and Sin values are in interleaved fashion
 *
 */
+#ifdef XTENSA_RFFT_LEN_128
 const float32_t twiddleCoef_64[128] = {
     1.000000000f,  0.000000000f,
     0.995184727f,  0.098017140f,
@@ -314,6 +319,7 @@ const float32_t twiddleCoef_64[128] = {
     0.980785280f, -0.195090322f,
     0.995184727f, -0.098017140f
 };
+#endif
 
 /**
 * \par
@@ -331,6 +337,7 @@ const float32_t twiddleCoef_64[128] = {
 *
 */
 
+#ifdef XTENSA_RFFT_LEN_256
 const float32_t twiddleCoef_128[256] = {
     1.000000000f,  0.000000000f,
     0.998795456f,  0.049067674f,
@@ -461,6 +468,7 @@ const float32_t twiddleCoef_128[256] = {
     0.995184727f, -0.098017140f,
     0.998795456f, -0.049067674f
 };
+#endif
 
 /**
 * \par
@@ -477,6 +485,7 @@ const float32_t twiddleCoef_128[256] = {
 * Cos and Sin values are in interleaved fashion
 *
 */
+#ifdef XTENSA_RFFT_LEN_512
 const float32_t twiddleCoef_256[512] = {
     1.000000000f,  0.000000000f,
     0.999698819f,  0.024541229f,
@@ -735,6 +744,7 @@ const float32_t twiddleCoef_256[512] = {
     0.998795456f, -0.049067674f,
     0.999698819f, -0.024541229f
 };
+#endif
 
 /**
 * \par
@@ -751,6 +761,7 @@ const float32_t twiddleCoef_256[512] = {
 * Cos and Sin values are in interleaved fashion
 *
 */
+#ifdef XTENSA_RFFT_LEN_1024
 const float32_t twiddleCoef_512[1024] = {
     1.000000000f,  0.000000000f,
     0.999924702f,  0.012271538f,
@@ -1265,6 +1276,7 @@ const float32_t twiddleCoef_512[1024] = {
     0.999698819f, -0.024541229f,
     0.999924702f, -0.012271538f
 };
+#endif
 /**
 * \par
 * Example code for Floating-point Twiddle factors Generation:
@@ -1280,6 +1292,7 @@ const float32_t twiddleCoef_512[1024] = {
 * Cos and Sin values are in interleaved fashion
 *
 */
+#ifdef XTENSA_RFFT_LEN_2048
 const float32_t twiddleCoef_1024[2048] = {
     1.000000000f,  0.000000000f,
     0.999981175f,  0.006135885f,
@@ -2306,6 +2319,7 @@ const float32_t twiddleCoef_1024[2048] = {
     0.999924702f, -0.012271538f,
     0.999981175f, -0.006135885f
 };
+#endif
 
 /**
 * \par
@@ -2322,6 +2336,7 @@ const float32_t twiddleCoef_1024[2048] = {
 * Cos and Sin values are in interleaved fashion
 *
 */
+#ifdef XTENSA_RFFT_LEN_4096
 const float32_t twiddleCoef_2048[4096] = {
     1.000000000f,  0.000000000f,
     0.999995294f,  0.003067957f,
@@ -4372,6 +4387,7 @@ const float32_t twiddleCoef_2048[4096] = {
     0.999981175f, -0.006135885f,
     0.999995294f, -0.003067957f
 };
+#endif
 
 /**
 * \par
@@ -8489,12 +8505,15 @@ const float32_t twiddleCoef_4096[8192] = {
 
 
 
+#ifdef XTENSA_RFFT_LEN_32
 const uint16_t xtensaBitRevIndexTable16[XTENSABITREVINDEXTABLE_16_TABLE_LENGTH] =
 {
    /* 8x2, size 20 */
    8,64, 24,72, 16,64, 40,80, 32,64, 56,88, 48,72, 88,104, 72,96, 104,112
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_64
 const uint16_t xtensaBitRevIndexTable32[XTENSABITREVINDEXTABLE_32_TABLE_LENGTH] =
 {
    /* 8x4, size 48 */
@@ -8502,7 +8521,9 @@ const uint16_t xtensaBitRevIndexTable32[XTENSABITREVINDEXTABLE_32_TABLE_LENGTH]
    80,144, 96,192, 104,208, 112,152, 120,216, 136,192, 144,160, 168,208,
    152,224, 176,208, 184,232, 216,240, 200,224, 232,240
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_128
 const uint16_t xtensaBitRevIndexTable64[XTENSABITREVINDEXTABLE_64_TABLE_LENGTH] =
 {
    /* radix 8, size 56 */
@@ -8511,7 +8532,9 @@ const uint16_t xtensaBitRevIndexTable64[XTENSABITREVINDEXTABLE_64_TABLE_LENGTH]
    184,464, 224,280, 232,344, 240,408, 248,472, 296,352, 304,416, 312,480,
    368,424, 376,488, 440,496
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_256
 const uint16_t xtensaBitRevIndexTable128[XTENSABITREVINDEXTABLE_128_TABLE_LENGTH] =
 {
    /* 8x2, size 208 */
@@ -8529,7 +8552,9 @@ const uint16_t xtensaBitRevIndexTable128[XTENSABITREVINDEXTABLE_128_TABLE_LENGTH
    792,864, 808,904, 816,864, 824,920, 840,864, 856,880, 872,944, 888,1008,
    904,928, 912,960, 920,992, 944,968, 952,1000, 968,992, 984,1008
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_512
 const uint16_t xtensaBitRevIndexTable256[XTENSABITREVINDEXTABLE_256_TABLE_LENGTH] =
 {
    /* 8x4, size 440 */
@@ -8567,7 +8592,9 @@ const uint16_t xtensaBitRevIndexTable256[XTENSABITREVINDEXTABLE_256_TABLE_LENGTH
    1880,1904, 1888,1984, 1896,2000, 1912,2032, 1904,2016, 1976,2032,
    1960,1968, 2008,2032, 1992,2016, 2024,2032
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_1024
 const uint16_t xtensaBitRevIndexTable512[XTENSABITREVINDEXTABLE_512_TABLE_LENGTH] =
 {
    /* radix 8, size 448 */
@@ -8607,7 +8634,9 @@ const uint16_t xtensaBitRevIndexTable512[XTENSABITREVINDEXTABLE_512_TABLE_LENGTH
    3064,4072, 3128,3632, 3192,3696, 3256,3760, 3320,3824, 3384,3888,
    3448,3952, 3512,4016, 3576,4080
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_2048
 const uint16_t xtensaBitRevIndexTable1024[XTENSABITREVINDEXTABLE_1024_TABLE_LENGTH] =
 {
    /* 8x2, size 1800 */
@@ -8759,7 +8788,9 @@ const uint16_t xtensaBitRevIndexTable1024[XTENSABITREVINDEXTABLE_1024_TABLE_LENG
    8008,8032, 8024,8048, 8056,8120, 8072,8096, 8080,8128, 8088,8160,
    8112,8136, 8120,8168, 8136,8160, 8152,8176
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_4096
 const uint16_t xtensaBitRevIndexTable2048[XTENSABITREVINDEXTABLE_2048_TABLE_LENGTH] =
 {
    /* 8x2, size 3808 */
@@ -9101,6 +9132,7 @@ const uint16_t xtensaBitRevIndexTable2048[XTENSABITREVINDEXTABLE_2048_TABLE_LENG
    16248,16368, 16264,16288, 16280,16296, 16296,16304, 16344,16368,
    16328,16352, 16360,16368
 };
+#endif
 
 const uint16_t xtensaBitRevIndexTable4096[XTENSABITREVINDEXTABLE_4096_TABLE_LENGTH] =
 {
@@ -10135,6 +10167,7 @@ const uint16_t xtensaBitRevIndexTable_fixed_4096[XTENSABITREVINDEXTABLE_FIXED_40
 * \par
 * Real and Imag values are in interleaved fashion
 */
+#ifdef XTENSA_RFFT_LEN_32
 const float32_t twiddleCoef_rfft_32[32] = {
     0.000000000f,  1.000000000f,
     0.195090322f,  0.980785280f,
@@ -10153,7 +10186,9 @@ const float32_t twiddleCoef_rfft_32[32] = {
     0.382683432f, -0.923879533f,
     0.195090322f, -0.980785280f
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_64
 const float32_t twiddleCoef_rfft_64[64] = {
     0.000000000000000f,  1.000000000000000f,
     0.098017140329561f,  0.995184726672197f,
@@ -10188,7 +10223,9 @@ const float32_t twiddleCoef_rfft_64[64] = {
     0.195090322016129f, -0.980785280403230f,
     0.098017140329561f, -0.995184726672197f
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_128
 const float32_t twiddleCoef_rfft_128[128] = {
     0.000000000f,  1.000000000f,
     0.049067674f,  0.998795456f,
@@ -10255,7 +10292,9 @@ const float32_t twiddleCoef_rfft_128[128] = {
     0.098017140f, -0.995184727f,
     0.049067674f, -0.998795456f
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_256
 const float32_t twiddleCoef_rfft_256[256] = {
     0.000000000f,  1.000000000f,
     0.024541229f,  0.999698819f,
@@ -10386,7 +10425,9 @@ const float32_t twiddleCoef_rfft_256[256] = {
     0.049067674f, -0.998795456f,
     0.024541229f, -0.999698819f
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_512
 const float32_t twiddleCoef_rfft_512[512] = {
     0.000000000f,  1.000000000f,
     0.012271538f,  0.999924702f,
@@ -10645,7 +10686,9 @@ const float32_t twiddleCoef_rfft_512[512] = {
     0.024541229f, -0.999698819f,
     0.012271538f, -0.999924702f
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_1024
 const float32_t twiddleCoef_rfft_1024[1024] = {
     0.000000000f,  1.000000000f,
     0.006135885f,  0.999981175f,
@@ -11160,7 +11203,9 @@ const float32_t twiddleCoef_rfft_1024[1024] = {
     0.012271538f, -0.999924702f,
     0.006135885f, -0.999981175f
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_2048
 const float32_t twiddleCoef_rfft_2048[2048] = {
     0.000000000f,  1.000000000f,
     0.003067957f,  0.999995294f,
@@ -12187,7 +12232,9 @@ const float32_t twiddleCoef_rfft_2048[2048] = {
     0.006135885f, -0.999981175f,
     0.003067957f, -0.999995294f
 };
+#endif
 
+#ifdef XTENSA_RFFT_LEN_4096
 const float32_t twiddleCoef_rfft_4096[4096] = {
     0.000000000f,  1.000000000f,
     0.001533980f,  0.999998823f,
@@ -14238,6 +14285,7 @@ const float32_t twiddleCoef_rfft_4096[4096] = {
     0.003067957f, -0.999995294f,
     0.001533980f, -0.999998823f
 };
+#endif
 
 
 /**
@@ -31,6 +31,22 @@
 
 #include "xtensa_math.h"
 
+/*
+ * Real FFT lengths xtensa_rfft_fast_init_f32() supports. A trimmed build
+ * defines XTENSA_RFFT_TRIM_TABLES and the XTENSA_RFFT_LEN_<N> of the lengths
+ * it uses, the twiddle and bit reversal tables of the others are left out.
+ */
+#ifndef XTENSA_RFFT_TRIM_TABLES
+#define XTENSA_RFFT_LEN_32
+#define XTENSA_RFFT_LEN_64
+#define XTENSA_RFFT_LEN_128
+#define XTENSA_RFFT_LEN_256
+#define XTENSA_RFFT_LEN_512
+#define XTENSA_RFFT_LEN_1024
+#define XTENSA_RFFT_LEN_2048
+#define XTENSA_RFFT_LEN_4096
+#endif
+
 extern const uint16_t xtensaBitRevTable[1024];
 extern const float32_t twiddleCoef_16[32];
 extern const float32_t twiddleCoef_32[64];
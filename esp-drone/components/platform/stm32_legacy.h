@@ -61,7 +61,7 @@ typedef enum {
 #define assert_param(e)  if (e) ; \
     else assertFail( #e, __FILE__, __LINE__ )
 
-uint64_t usecTimestamp(void);
+#include "usec_time.h"
 
 /* GPIO */
 
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""
+Converts a MEM_TYPE_EVENT_TRACE download to the Chrome trace event format,
+opened by chrome://tracing or https://ui.perfetto.dev.
+
+The trace memory, see event_trace.h, holds one ring of records per core.
+Every core is a process and every task a track in it, the stages become
+slices on the track of their task, the marks instant events. The record
+argument (the loop tick or the packet size) is kept in the slice arguments:
+
+    event_trace_json.py dump.bin trace.json
+
+The timestamps are the low 32 bits of the drone microsecond clock, they are
+unwrapped from the oldest record of the download.
+"""
+import argparse
+import json
+import struct
+import sys
+from typing import Dict, List, Tuple
+
+HEADER_SIZE = 16
+MAGIC = b"ET"
+VERSION = 1
+RECORD = struct.Struct("<IHH")
+TIMESTAMP_WRAP = 1 << 32
+
+END_FLAG = 0x8000
+MARK_FLAG = 0x4000
+ID_MASK = 0x3FFF
+
+# Event ids, as in eventTraceId_t of event_trace.h, with the task they run in.
+# The stages of a task nest, those of different tasks interleave when a task
+# preempts another one, so each task gets its own track.
+EVENTS: Dict[int, Tuple[str, str]] = {
+    1: ("loop", "stabilizer"),
+    2: ("estimator", "stabilizer"),
+    3: ("setpoint", "stabilizer"),
+    4: ("controller", "stabilizer"),
+    5: ("power", "stabilizer"),
+    6: ("task", "kalman"),
+    7: ("predict", "kalman"),
+    8: ("measurements", "kalman"),
+    9: ("finalize", "kalman"),
+    10: ("read", "sensors"),
+    11: ("rx", "wifi rx"),
+    12: ("tx", "wifi tx"),
+}
+TASKS: List[str] = sorted({task for _, task in EVENTS.values()}) + ["other"]
+
+
+def read_rings(data: bytes) -> Tuple[List[List[Tuple[int, int, int]]], int]:
+    """
+    Splits the trace memory into the records of each core.
+
+    Args:
+        data (bytes): Downloaded memory, header included.
+
+    Returns:
+        Tuple[List[List[Tuple[int, int, int]]], int]: Records (timestamp, id, argument)
+        of each core, oldest first, and the number of records overwritten.
+    """
+    if len(data) < HEADER_SIZE or data[0:2] != MAGIC:
+        raise ValueError("Not an event trace download")
+    if data[2] != VERSION:
+        raise ValueError(f"Unsupported event trace version {data[2]}")
+    cores = data[3]
+    (capacity,) = struct.unpack_from("<I", data, 4)
+    written = struct.unpack_from("<II", data, 8)[:cores]
+
+    rings = []
+    dropped = 0
+    for core in range(cores):
+        base = HEADER_SIZE + core * capacity * RECORD.size
+        first = max(0, written[core] - capacity)
+        dropped += first
+        records = []
+        for n in range(first, written[core]):
+            offset = base + (n % capacity) * RECORD.size
+            if offset + RECORD.size > len(data):
+                raise ValueError("Truncated event trace download")
+            records.append(RECORD.unpack_from(data, offset))
+        rings.append(records)
+    return rings, dropped
+
+
+def unwrap(rings: List[List[Tuple[int, int, int]]]) -> List[List[Tuple[int, int, int]]]:
+    """
+    Unwraps the 32 bit timestamps of all the cores against a common origin.
+
+    Args:
+        rings (List[List[Tuple[int, int, int]]]): Records of each core, oldest first.
+
+    Returns:
+        List[List[Tuple[int, int, int]]]: The records with their timestamps in us from the oldest record.
+    """
+    starts = [records[0][0] for records in rings if records]
+    if not starts:
+        return rings
+    # The oldest record of all cores, the rings span far less than a wrap
+    origin = min(starts, key=lambda start: (start - starts[0] + TIMESTAMP_WRAP // 2) % TIMESTAMP_WRAP)
+
+    result = []
+    for records in rings:
+        result.append([((stamp - origin) % TIMESTAMP_WRAP, event, arg) for stamp, event, arg in records])
+    return result
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Convert an event trace download to a Chrome trace.")
+    parser.add_argument("dump", help="downloaded MEM_TYPE_EVENT_TRACE memory")
+    parser.add_argument("output", help="trace JSON file to write")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        rings, dropped = read_rings(f.read())
+    if dropped:
+        print(f"{dropped} records were overwritten before the download", file=sys.stderr)
+
+    events = []
+    for core, records in enumerate(unwrap(rings)):
+        events.append({"ph": "M", "name": "process_name", "pid": core, "args": {"name": f"core {core}"}})
+        for tid, task in enumerate(TASKS):
+            events.append({"ph": "M", "name": "thread_name", "pid": core, "tid": tid, "args": {"name": task}})
+
+        # A task preempted on its core records out of timestamp order
+        for stamp, event, arg in sorted(records, key=lambda record: record[0]):
+            name, task = EVENTS.get(event & ID_MASK, (f"event {event & ID_MASK}", "other"))
+            if event & MARK_FLAG:
+                phase = "i"
+            elif event & END_FLAG:
+                phase = "E"
+            else:
+                phase = "B"
+            entry = {"ph": phase, "name": name, "pid": core, "tid": TASKS.index(task), "ts": stamp,
+                     "args": {"arg": arg}}
+            if phase == "i":
+                entry["s"] = "t"
+            events.append(entry)
+
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, f)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
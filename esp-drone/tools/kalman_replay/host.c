@@ -0,0 +1,285 @@
+/*
+ * host.c - Host runtime of the Kalman replay
+ *
+ * Implements the stand-ins declared in stubs/: the log and parameter
+ * registries, the coroutine running the kalman task, the semaphores, and the
+ * sensor and system functions the estimator calls.
+ */
+#define _XOPEN_SOURCE 700
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "esp_log.h"
+#include "log.h"
+#include "param.h"
+#include "sensors.h"
+#include "system.h"
+#include "host.h"
+
+#define MAX_GROUPS 128
+#define TASK_STACK_SIZE (256 * 1024)
+
+esp_log_level_t hostLogLevel = ESP_LOG_WARN;
+TickType_t hostTick;
+hostSensors_t hostSensors;
+
+/* Log and parameter registries */
+
+typedef struct {
+  const char *group;
+  const hostVar_t *vars;
+  int count;
+} hostGroup_t;
+
+static hostGroup_t logGroups[MAX_GROUPS];
+static int logGroupCount;
+static hostGroup_t paramGroups[MAX_GROUPS];
+static int paramGroupCount;
+
+static void registerGroup(hostGroup_t *groups, int *count, const char *group, const hostVar_t *vars, int n)
+{
+  if (*count >= MAX_GROUPS) {
+    fprintf(stderr, "Too many groups, %s ignored\n", group);
+    return;
+  }
+  groups[*count].group = group;
+  groups[*count].vars = vars;
+  groups[*count].count = n;
+  (*count)++;
+}
+
+static const hostVar_t *findVar(const hostGroup_t *groups, int count, const char *group, const char *name)
+{
+  for (int i = 0; i < count; i++) {
+    if (strcmp(groups[i].group, group) != 0) {
+      continue;
+    }
+    for (int j = 0; j < groups[i].count; j++) {
+      if (strcmp(groups[i].vars[j].name, name) == 0) {
+        return &groups[i].vars[j];
+      }
+    }
+  }
+  return NULL;
+}
+
+void hostLogRegister(const char *group, const hostVar_t *vars, int count)
+{
+  registerGroup(logGroups, &logGroupCount, group, vars, count);
+}
+
+void hostParamRegister(const char *group, const hostVar_t *vars, int count)
+{
+  registerGroup(paramGroups, &paramGroupCount, group, vars, count);
+}
+
+float hostLogGet(const char *group, const char *name)
+{
+  const hostVar_t *var = findVar(logGroups, logGroupCount, group, name);
+  if (var == NULL) {
+    return NAN;
+  }
+  if (var->type & LOG_BY_FUNCTION) {
+    const logByFunction_t *function = var->address;
+    if ((var->type & ~LOG_BY_FUNCTION) == LOG_UINT32) {
+      return function->acquireUInt32(hostTick * portTICK_PERIOD_MS, function->data);
+    }
+    return function->aquireFloat(hostTick * portTICK_PERIOD_MS, function->data);
+  }
+
+  switch (var->type) {
+    case LOG_UINT8: return *(uint8_t *)var->address;
+    case LOG_UINT16: return *(uint16_t *)var->address;
+    case LOG_UINT32: return *(uint32_t *)var->address;
+    case LOG_INT8: return *(int8_t *)var->address;
+    case LOG_INT16: return *(int16_t *)var->address;
+    case LOG_INT32: return *(int32_t *)var->address;
+    case LOG_FLOAT: return *(float *)var->address;
+    default: return NAN;
+  }
+}
+
+bool hostParamSet(const char *group, const char *name, const char *value)
+{
+  const hostVar_t *var = findVar(paramGroups, paramGroupCount, group, name);
+  if (var == NULL) {
+    return false;
+  }
+
+  switch (var->type & ~PARAM_RONLY) {
+    case PARAM_UINT8: *(uint8_t *)var->address = strtoul(value, NULL, 0); break;
+    case PARAM_UINT16: *(uint16_t *)var->address = strtoul(value, NULL, 0); break;
+    case PARAM_UINT32: *(uint32_t *)var->address = strtoul(value, NULL, 0); break;
+    case PARAM_INT8: *(int8_t *)var->address = strtol(value, NULL, 0); break;
+    case PARAM_INT16: *(int16_t *)var->address = strtol(value, NULL, 0); break;
+    case PARAM_INT32: *(int32_t *)var->address = strtol(value, NULL, 0); break;
+    case PARAM_FLOAT: *(float *)var->address = strtof(value, NULL); break;
+    default: return false;
+  }
+  return true;
+}
+
+/* Parameter ids are indexes in a flat table of the registered variables */
+
+static const hostVar_t *paramIds[1024];
+static int paramIdCount;
+
+paramVarId_t paramGetVarId(const char *group, const char *name)
+{
+  const hostVar_t *var = findVar(paramGroups, paramGroupCount, group, name);
+  if (var == NULL) {
+    return -1;
+  }
+  for (int i = 0; i < paramIdCount; i++) {
+    if (paramIds[i] == var) {
+      return i;
+    }
+  }
+  if (paramIdCount >= (int)(sizeof(paramIds) / sizeof(paramIds[0]))) {
+    return -1;
+  }
+  paramIds[paramIdCount] = var;
+  return paramIdCount++;
+}
+
+void paramSetInt(paramVarId_t varid, int value)
+{
+  if (varid < 0 || varid >= paramIdCount) {
+    return;
+  }
+  char text[16];
+  snprintf(text, sizeof(text), "%d", value);
+  const hostVar_t *var = paramIds[varid];
+  for (int i = 0; i < paramGroupCount; i++) {
+    if (var >= paramGroups[i].vars && var < paramGroups[i].vars + paramGroups[i].count) {
+      hostParamSet(paramGroups[i].group, var->name, text);
+      return;
+    }
+  }
+}
+
+/* Scheduler: one task, run as a coroutine until it blocks */
+
+struct hostSemaphore_s {
+  int count;
+  int max;
+};
+
+static ucontext_t replayContext;
+static ucontext_t taskContext;
+static TaskFunction_t taskFunction;
+static void *taskParameters;
+static bool taskCreated;
+static bool inTask;
+
+static void taskEntry(void)
+{
+  taskFunction(taskParameters);
+  fprintf(stderr, "Task returned\n");
+  exit(1);
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *task)
+{
+  if (taskCreated) {
+    fprintf(stderr, "Only one task is supported, %s not created\n", name);
+    return NULL;
+  }
+
+  taskFunction = function;
+  taskParameters = parameters;
+  getcontext(&taskContext);
+  // The host C library needs more stack than the firmware task is given
+  taskContext.uc_stack.ss_sp = malloc(TASK_STACK_SIZE);
+  taskContext.uc_stack.ss_size = TASK_STACK_SIZE;
+  taskContext.uc_link = NULL;
+  makecontext(&taskContext, taskEntry, 0);
+  taskCreated = true;
+  return &taskContext;
+}
+
+void hostRunTasks(void)
+{
+  if (taskCreated) {
+    inTask = true;
+    swapcontext(&replayContext, &taskContext);
+    inTask = false;
+  }
+}
+
+SemaphoreHandle_t hostSemaphoreCreate(int count, int max)
+{
+  SemaphoreHandle_t semaphore = malloc(sizeof(*semaphore));
+  semaphore->count = count;
+  semaphore->max = max;
+  return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout)
+{
+  while (semaphore->count == 0) {
+    if (!inTask) {
+      return pdFALSE;
+    }
+    swapcontext(&taskContext, &replayContext);
+  }
+  semaphore->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+  if (semaphore->count >= semaphore->max) {
+    return pdFALSE;
+  }
+  semaphore->count++;
+  return pdTRUE;
+}
+
+/* Sensors, read once per new sample as from the sensor queues */
+
+bool sensorsReadAccTimestamped(Axis3f *acc, uint64_t *timestamp)
+{
+  if (!hostSensors.accNew) {
+    return false;
+  }
+  *acc = hostSensors.acc;
+  *timestamp = hostSensors.accTimestamp;
+  hostSensors.accNew = false;
+  return true;
+}
+
+bool sensorsReadGyroTimestamped(Axis3f *gyro, uint64_t *timestamp)
+{
+  if (!hostSensors.gyroNew) {
+    return false;
+  }
+  *gyro = hostSensors.gyro;
+  *timestamp = hostSensors.gyroTimestamp;
+  hostSensors.gyroNew = false;
+  return true;
+}
+
+bool sensorsReadBaroTimestamped(baro_t *baro, uint64_t *timestamp)
+{
+  return false;
+}
+
+/* System */
+
+void systemWaitStart(void)
+{
+}
+
+void assertFail(char *exp, char *file, int line)
+{
+  fprintf(stderr, "Assert failed %s:%d (%s) at tick %u\n", file, line, exp, (unsigned)hostTick);
+  exit(1);
+}
@@ -0,0 +1,19 @@
+/*
+ * host.h - Host runtime of the Kalman replay
+ */
+#pragma once
+
+#include <stdbool.h>
+#include "stabilizer_types.h"
+
+/* Latest IMU samples, handed once to the estimator by sensorsReadAcc/GyroTimestamped() */
+typedef struct {
+  Axis3f acc;   // G
+  Axis3f gyro;  // deg/s
+  uint64_t accTimestamp;   // us, from the log timestamp
+  uint64_t gyroTimestamp;
+  bool accNew;
+  bool gyroNew;
+} hostSensors_t;
+
+extern hostSensors_t hostSensors;
@@ -0,0 +1,440 @@
+/*
+ * kalman_replay.c - Replay recorded sensor logs through the Kalman estimator on the host
+ *
+ * The firmware kalman_core.c and estimator_kalman.c are compiled unchanged
+ * against the stand-ins of stubs/ and host.c: the kalman task runs as a
+ * coroutine, stepped once per simulated 1 ms tick after estimatorKalman(),
+ * as the stabilizer loop does on board.
+ *
+ * The input is a CSV log, one row per log block packet, as produced by
+ * log_record_csv.py from a MEM_TYPE_LOG_RECORD download. The first row holds
+ * the column names, the log variables as "group.name", and a "timestamp"
+ * column in ms. Empty cells are variables not sent in that packet. Used
+ * columns:
+ *
+ *   acc.x acc.y acc.z             accelerometer [G]
+ *   gyro.x gyro.y gyro.z          gyro [deg/s]
+ *   stabilizer.thrust             thrust command, held between samples
+ *   motion.deltaX motion.deltaY   flow deck pixel counts, motion.motion and
+ *                                 motion.std used when present
+ *   range.zrange                  down range [mm]
+ *   <ref>.x <ref>.y <ref>.z       reference position [m], stateEstimate by default
+ *
+ * Flow and ranges are turned into measurements as the deck drivers do,
+ * timestamped at the middle of their integration time. The estimate is
+ * compared to the reference at every reference sample, and the wall time of
+ * every task step as well as the kalman_cost counters (in ns on the host) are
+ * reported.
+ *
+ * Usage: kalman_replay [-r ref] [-p group.name=value]... [-o estimate.csv] [-v] log.csv
+ */
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "esp_log.h"
+#include "log.h"
+#include "param.h"
+#include "estimator_kalman.h"
+#include "host.h"
+
+#define MAX_LINE 4096
+#define MAX_COLUMNS 128
+#define MAX_PARAMS 32
+
+// Flow deck driver model, see flowdeck_v1v2.c
+#define FLOW_OUTLIER_LIMIT 100
+#define FLOW_MOTION_OK 0xB0
+#define FLOW_STD_DEFAULT 2.0f
+
+// Down range driver model, see zranger2.c
+#define RANGE_OUTLIER_LIMIT 5000
+#define RANGE_LATENCY_MS 12
+static const float expPointA = 2.5f;
+static const float expStdA = 0.0025f;
+static const float expPointB = 4.0f;
+static const float expStdB = 0.2f;
+
+typedef enum {
+  COL_TIMESTAMP,
+  COL_ACC_X, COL_ACC_Y, COL_ACC_Z,
+  COL_GYRO_X, COL_GYRO_Y, COL_GYRO_Z,
+  COL_THRUST,
+  COL_FLOW_DX, COL_FLOW_DY, COL_FLOW_MOTION, COL_FLOW_STD,
+  COL_ZRANGE,
+  COL_REF_X, COL_REF_Y, COL_REF_Z,
+  COL_COUNT,
+} column_t;
+
+static const char *columnNames[COL_COUNT] = {
+  "timestamp",
+  "acc.x", "acc.y", "acc.z",
+  "gyro.x", "gyro.y", "gyro.z",
+  "stabilizer.thrust",
+  "motion.deltaX", "motion.deltaY", "motion.motion", "motion.std",
+  "range.zrange",
+  NULL, NULL, NULL,
+};
+
+typedef struct {
+  double value[COL_COUNT];
+  bool present[COL_COUNT];
+} row_t;
+
+typedef struct {
+  double min;
+  double max;
+  double sum;
+  uint32_t count;
+} summary_t;
+
+static const char *costNames[] = {
+  "pred", "updTdoa", "updPos", "updPose", "updDist", "updFlow", "updTof", "updHgt", "updYaw", "final", "ext", "replay",
+};
+#define COST_COUNT (sizeof(costNames) / sizeof(costNames[0]))
+
+static summary_t costs[COST_COUNT];
+static summary_t stepTime;
+static summary_t error[3];
+static double errorSquares[3];
+
+static void summaryAdd(summary_t *summary, double value)
+{
+  if (summary->count == 0 || value < summary->min) {
+    summary->min = value;
+  }
+  if (summary->count == 0 || value > summary->max) {
+    summary->max = value;
+  }
+  summary->sum += value;
+  summary->count++;
+}
+
+static double nowNs(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr, "Usage: %s [-r ref] [-p group.name=value]... [-o estimate.csv] [-v] log.csv\n", name);
+  fprintf(stderr, "  -r ref      group of the reference position columns (default stateEstimate)\n");
+  fprintf(stderr, "  -p g.n=v    set an estimator parameter before the replay\n");
+  fprintf(stderr, "  -o file     write the estimate and the reference at every reference sample\n");
+  fprintf(stderr, "  -v          print the estimator debug output\n");
+  exit(2);
+}
+
+/* CSV */
+
+static int columnMap[MAX_COLUMNS];
+static int columnCount;
+
+static int splitLine(char *line, char **fields)
+{
+  int n = 0;
+  char *p = line;
+  while (n < MAX_COLUMNS) {
+    fields[n++] = p;
+    char *comma = strchr(p, ',');
+    if (comma == NULL) {
+      break;
+    }
+    *comma = '\0';
+    p = comma + 1;
+  }
+  for (int i = 0; i < n; i++) {
+    fields[i][strcspn(fields[i], "\r\n")] = '\0';
+  }
+  return n;
+}
+
+static bool readHeader(FILE *file, const char *ref)
+{
+  char line[MAX_LINE];
+  char *fields[MAX_COLUMNS];
+  char refNames[3][64];
+
+  for (int i = 0; i < 3; i++) {
+    snprintf(refNames[i], sizeof(refNames[i]), "%s.%c", ref, 'x' + i);
+    columnNames[COL_REF_X + i] = refNames[i];
+  }
+
+  if (fgets(line, sizeof(line), file) == NULL) {
+    return false;
+  }
+  columnCount = splitLine(line, fields);
+
+  bool found[COL_COUNT] = {false};
+  for (int i = 0; i < columnCount; i++) {
+    columnMap[i] = -1;
+    for (int c = 0; c < COL_COUNT; c++) {
+      if (strcmp(fields[i], columnNames[c]) == 0) {
+        columnMap[i] = c;
+        found[c] = true;
+      }
+    }
+  }
+
+  for (int c = 0; c < COL_COUNT; c++) {
+    if (!found[c]) {
+      fprintf(stderr, "No %s column%s\n", columnNames[c], c == COL_TIMESTAMP ? "" : ", not replayed");
+    }
+  }
+  // Copied names do not outlive this function
+  for (int i = 0; i < 3; i++) {
+    columnNames[COL_REF_X + i] = NULL;
+  }
+  return found[COL_TIMESTAMP];
+}
+
+static bool readRow(FILE *file, row_t *row)
+{
+  char line[MAX_LINE];
+  char *fields[MAX_COLUMNS];
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    int n = splitLine(line, fields);
+    memset(row, 0, sizeof(*row));
+    for (int i = 0; i < n && i < columnCount; i++) {
+      if (columnMap[i] >= 0 && fields[i][0] != '\0') {
+        row->value[columnMap[i]] = strtod(fields[i], NULL);
+        row->present[columnMap[i]] = true;
+      }
+    }
+    if (row->present[COL_TIMESTAMP]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Replay */
+
+static float thrust;
+static uint32_t lastFlowTick;
+static bool flowStarted;
+static bool refPending;
+static double ref[3];
+
+static void consumeRow(const row_t *row, uint32_t tick)
+{
+  if (row->present[COL_ACC_X] && row->present[COL_ACC_Y] && row->present[COL_ACC_Z]) {
+    hostSensors.acc.x = row->value[COL_ACC_X];
+    hostSensors.acc.y = row->value[COL_ACC_Y];
+    hostSensors.acc.z = row->value[COL_ACC_Z];
+    hostSensors.accTimestamp = (uint64_t)row->value[COL_TIMESTAMP] * 1000;
+    hostSensors.accNew = true;
+  }
+  if (row->present[COL_GYRO_X] && row->present[COL_GYRO_Y] && row->present[COL_GYRO_Z]) {
+    hostSensors.gyro.x = row->value[COL_GYRO_X];
+    hostSensors.gyro.y = row->value[COL_GYRO_Y];
+    hostSensors.gyro.z = row->value[COL_GYRO_Z];
+    hostSensors.gyroTimestamp = (uint64_t)row->value[COL_TIMESTAMP] * 1000;
+    hostSensors.gyroNew = true;
+  }
+  if (row->present[COL_THRUST]) {
+    thrust = row->value[COL_THRUST];
+  }
+
+  if (row->present[COL_FLOW_DX] && row->present[COL_FLOW_DY]) {
+    // Sensor mounting, as in the flow deck driver
+    float accpx = -row->value[COL_FLOW_DY];
+    float accpy = -row->value[COL_FLOW_DX];
+    bool motion = !row->present[COL_FLOW_MOTION] || row->value[COL_FLOW_MOTION] == FLOW_MOTION_OK;
+    if (flowStarted && motion && fabsf(accpx) < FLOW_OUTLIER_LIMIT && fabsf(accpy) < FLOW_OUTLIER_LIMIT) {
+      flowMeasurement_t flow;
+      flow.dpixelx = accpx;
+      flow.dpixely = accpy;
+      flow.stdDevX = flow.stdDevY = row->present[COL_FLOW_STD] ? row->value[COL_FLOW_STD] : FLOW_STD_DEFAULT;
+      flow.dt = (tick - lastFlowTick) / 1000.0f;
+      flow.timestamp = tick - (tick - lastFlowTick) / 2;
+      estimatorKalmanEnqueueFlow(&flow);
+    }
+    lastFlowTick = tick;
+    flowStarted = true;
+  }
+
+  if (row->present[COL_ZRANGE] && row->value[COL_ZRANGE] < RANGE_OUTLIER_LIMIT) {
+    float expCoeff = logf(expStdB / expStdA) / (expPointB - expPointA);
+    tofMeasurement_t tof;
+    tof.distance = row->value[COL_ZRANGE] * 0.001f;
+    tof.stdDev = expStdA * (1.0f + expf(expCoeff * (tof.distance - expPointA)));
+    tof.timestamp = tick - RANGE_LATENCY_MS;
+    estimatorKalmanEnqueueTOF(&tof);
+  }
+
+  if (row->present[COL_REF_X] && row->present[COL_REF_Y] && row->present[COL_REF_Z]) {
+    ref[0] = row->value[COL_REF_X];
+    ref[1] = row->value[COL_REF_Y];
+    ref[2] = row->value[COL_REF_Z];
+    refPending = true;
+  }
+}
+
+static void sampleCosts(void)
+{
+  char name[32];
+  for (unsigned i = 0; i < COST_COUNT; i++) {
+    snprintf(name, sizeof(name), "%sAvg", costNames[i]);
+    float avg = hostLogGet("kalman_cost", name);
+    if (avg > 0) {
+      summaryAdd(&costs[i], avg);
+      snprintf(name, sizeof(name), "%sMin", costNames[i]);
+      float min = hostLogGet("kalman_cost", name);
+      snprintf(name, sizeof(name), "%sMax", costNames[i]);
+      float max = hostLogGet("kalman_cost", name);
+      costs[i].min = fmin(costs[i].min, min);
+      costs[i].max = fmax(costs[i].max, max);
+    }
+  }
+}
+
+static void report(void)
+{
+  printf("Task step wall time [ns]: min %.0f avg %.0f max %.0f over %u steps\n",
+         stepTime.min, stepTime.count ? stepTime.sum / stepTime.count : 0, stepTime.max, stepTime.count);
+
+  printf("Filter step cost [ns]:\n");
+  for (unsigned i = 0; i < COST_COUNT; i++) {
+    if (costs[i].count > 0) {
+      printf("  %-8s min %8.0f avg %8.0f max %8.0f\n", costNames[i], costs[i].min, costs[i].sum / costs[i].count,
+             costs[i].max);
+    }
+  }
+
+  if (error[0].count > 0) {
+    printf("Estimate error [m] over %u reference samples:\n", error[0].count);
+    double total = 0;
+    for (int i = 0; i < 3; i++) {
+      printf("  %c rms %.4f max %.4f\n", 'x' + i, sqrt(errorSquares[i] / error[i].count), error[i].max);
+      total += errorSquares[i] / error[i].count;
+    }
+    printf("  3D rms %.4f\n", sqrt(total));
+  } else {
+    printf("No reference samples, estimate error not computed\n");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char *refGroup = "stateEstimate";
+  const char *outputName = NULL;
+  char *params[MAX_PARAMS];
+  int paramCount = 0;
+
+  int arg;
+  for (arg = 1; arg < argc && argv[arg][0] == '-'; arg++) {
+    if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc) {
+      refGroup = argv[++arg];
+    } else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc && paramCount < MAX_PARAMS) {
+      params[paramCount++] = argv[++arg];
+    } else if (strcmp(argv[arg], "-o") == 0 && arg + 1 < argc) {
+      outputName = argv[++arg];
+    } else if (strcmp(argv[arg], "-v") == 0) {
+      hostLogLevel = ESP_LOG_DEBUG;
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (arg != argc - 1) {
+    usage(argv[0]);
+  }
+
+  FILE *file = fopen(argv[arg], "r");
+  if (file == NULL) {
+    fprintf(stderr, "Cannot open %s: %s\n", argv[arg], strerror(errno));
+    return 1;
+  }
+  if (!readHeader(file, refGroup)) {
+    fprintf(stderr, "No timestamp column in %s\n", argv[arg]);
+    return 1;
+  }
+
+  FILE *output = NULL;
+  if (outputName) {
+    output = fopen(outputName, "w");
+    if (output == NULL) {
+      fprintf(stderr, "Cannot open %s: %s\n", outputName, strerror(errno));
+      return 1;
+    }
+    fprintf(output, "timestamp,x,y,z,ref.x,ref.y,ref.z\n");
+  }
+
+  estimatorKalmanTaskInit();
+  estimatorKalmanInit();
+
+  for (int i = 0; i < paramCount; i++) {
+    char *name = strchr(params[i], '.');
+    char *value = strchr(params[i], '=');
+    if (name == NULL || value == NULL || value < name) {
+      usage(argv[0]);
+    }
+    *name++ = '\0';
+    *value++ = '\0';
+    if (!hostParamSet(params[i], name, value)) {
+      fprintf(stderr, "No parameter %s.%s\n", params[i], name);
+      return 1;
+    }
+  }
+
+  row_t row;
+  bool haveRow = readRow(file, &row);
+  if (!haveRow) {
+    fprintf(stderr, "No samples in %s\n", argv[arg]);
+    return 1;
+  }
+
+  // The log timestamps are in ms, one tick per ms as on board
+  hostTick = (uint32_t)row.value[COL_TIMESTAMP];
+  state_t state;
+  sensorData_t sensors;
+  control_t control = {0};
+
+  while (haveRow) {
+    while (haveRow && row.value[COL_TIMESTAMP] <= hostTick) {
+      consumeRow(&row, hostTick);
+      haveRow = readRow(file, &row);
+    }
+
+    control.thrust = thrust;
+    estimatorKalman(&state, &sensors, &control, hostTick);
+
+    if (refPending) {
+      double estimate[3] = {state.position.x, state.position.y, state.position.z};
+      for (int i = 0; i < 3; i++) {
+        double e = fabs(estimate[i] - ref[i]);
+        summaryAdd(&error[i], e);
+        errorSquares[i] += e * e;
+      }
+      if (output) {
+        fprintf(output, "%u,%f,%f,%f,%f,%f,%f\n", (unsigned)hostTick, estimate[0], estimate[1], estimate[2],
+                ref[0], ref[1], ref[2]);
+      }
+      refPending = false;
+    }
+
+    double start = nowNs();
+    hostRunTasks();
+    summaryAdd(&stepTime, nowNs() - start);
+
+    if (hostTick % 1000 == 999) {
+      sampleCosts();
+    }
+    hostTick++;
+  }
+
+  if (output) {
+    fclose(output);
+  }
+  fclose(file);
+
+  report();
+  return 0;
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Converts a MEM_TYPE_LOG_RECORD download to the CSV read by kalman_replay.
+
+The record memory, see log_record.h, holds the raw log block packets, so the
+variables of each block are given in the order and with the types they were
+added with:
+
+    log_record_csv.py dump.bin out.csv \\
+        --block 0=acc.x:float,acc.y:float,acc.z:float,gyro.x:float,gyro.y:float,gyro.z:float \\
+        --block 1=motion.deltaX:int16,motion.deltaY:int16,range.zrange:uint16
+
+Every record becomes one row with its unwrapped timestamp, the variables of
+other blocks are left empty.
+"""
+import argparse
+import csv
+import struct
+import sys
+from typing import Dict, List, Tuple
+
+HEADER_SIZE = 16
+MAGIC = b"LR"
+VERSION = 1
+TIMESTAMP_WRAP = 1 << 24
+
+# Log variable types, as in log.h
+TYPES: Dict[str, str] = {
+    "uint8": "B",
+    "uint16": "H",
+    "uint32": "I",
+    "int8": "b",
+    "int16": "h",
+    "int32": "i",
+    "float": "f",
+    "fp16": "e",
+}
+
+
+def parse_block(text: str) -> Tuple[int, List[str], struct.Struct]:
+    """
+    Parses a block layout argument.
+
+    Args:
+        text (str): Layout as "id=name:type,name:type,...".
+
+    Returns:
+        Tuple[int, List[str], struct.Struct]: Block id, variable names and value layout.
+    """
+    block_id, _, variables = text.partition("=")
+    names = []
+    layout = "<"
+    for variable in variables.split(","):
+        name, _, type_name = variable.partition(":")
+        if type_name not in TYPES:
+            raise argparse.ArgumentTypeError(f"Unknown type {type_name!r} of {name}")
+        names.append(name)
+        layout += TYPES[type_name]
+    return int(block_id, 0), names, struct.Struct(layout)
+
+
+def read_records(data: bytes) -> Tuple[List[bytes], int]:
+    """
+    Splits the record memory into log packets.
+
+    Args:
+        data (bytes): Downloaded memory, header included.
+
+    Returns:
+        Tuple[List[bytes], int]: Packets, oldest first, and the number of records overwritten.
+    """
+    if len(data) < HEADER_SIZE or data[0:2] != MAGIC:
+        raise ValueError("Not a log record download")
+    if data[2] != VERSION:
+        raise ValueError(f"Unsupported log record version {data[2]}")
+    used, dropped, _ = struct.unpack_from("<III", data, 4)
+
+    records = []
+    offset = HEADER_SIZE
+    end = min(HEADER_SIZE + used, len(data))
+    while offset < end:
+        size = data[offset]
+        records.append(data[offset + 1:offset + 1 + size])
+        offset += 1 + size
+    return records, dropped
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Convert a log record download to CSV.")
+    parser.add_argument("dump", help="downloaded MEM_TYPE_LOG_RECORD memory")
+    parser.add_argument("output", help="CSV file to write")
+    parser.add_argument("--block", action="append", type=parse_block, required=True,
+                        help="block layout as id=name:type,... in the order the variables were added")
+    args = parser.parse_args()
+
+    blocks = {block_id: (names, layout) for block_id, names, layout in args.block}
+    columns = ["timestamp"] + [name for names, _ in blocks.values() for name in names]
+
+    with open(args.dump, "rb") as f:
+        records, dropped = read_records(f.read())
+    if dropped:
+        print(f"{dropped} records were overwritten before the download", file=sys.stderr)
+
+    unknown = 0
+    last = None
+    timestamp_ms = 0
+    with open(args.output, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=columns)
+        writer.writeheader()
+        for record in records:
+            block = blocks.get(record[0]) if record else None
+            if block is None:
+                unknown += 1
+                continue
+            names, layout = block
+
+            # The 24 bit millisecond timestamp wraps every 4.6 hours
+            stamp = int.from_bytes(record[1:4], "little")
+            timestamp_ms += (stamp - last) % TIMESTAMP_WRAP if last is not None else stamp
+            last = stamp
+
+            values = layout.unpack_from(record, 4)
+            row = {"timestamp": timestamp_ms}
+            row.update(zip(names, values))
+            writer.writerow(row)
+
+    if unknown:
+        print(f"{unknown} records of blocks without a layout skipped", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
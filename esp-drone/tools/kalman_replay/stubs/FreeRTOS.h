@@ -0,0 +1,48 @@
+/*
+ * FreeRTOS.h - Host stand-in for the FreeRTOS kernel used by the Kalman replay
+ *
+ * Only what estimator_kalman.c uses is provided. The kalman task runs as a
+ * coroutine of the replay: it is resumed by hostRunTasks() and gives the hand
+ * back when it blocks on an empty semaphore. The tick is set by the replay.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef TickType_t portTickType;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef BaseType_t portBASE_TYPE;
+typedef uint8_t StackType_t;
+typedef struct { int unused; } StaticTask_t;
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#ifndef pdFALSE
+// Spelled as in stm32_legacy.h, which redefines them
+#define pdFALSE			( ( BaseType_t ) 0 )
+#define pdTRUE			( ( BaseType_t ) 1 )
+
+#define pdPASS			( pdTRUE )
+#define pdFAIL			( pdFALSE )
+#endif
+
+// A single thread runs the replay, the spinlocks have nothing to exclude
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portMUX_INITIALIZE(mux) ((void)(mux))
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux) ((void)(mux))
+
+/* Host scheduler, implemented by the replay */
+extern TickType_t hostTick;
+void hostRunTasks(void);
@@ -0,0 +1,9 @@
+/*
+ * console.h - Host stand-in for the Crazyflie console, printed on stderr
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define consolePrintf(FMT, ...) fprintf(stderr, FMT, ##__VA_ARGS__)
@@ -0,0 +1,17 @@
+/*
+ * esp_cpu.h - Host stand-in for the ESP-IDF CPU API
+ *
+ * The cycle counter counts nanoseconds of the host monotonic clock, so the
+ * cost counters of the estimator read in ns during a replay.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + now.tv_nsec);
+}
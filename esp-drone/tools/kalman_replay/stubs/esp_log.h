@@ -0,0 +1,20 @@
+/*
+ * esp_log.h - Host stand-in for the ESP-IDF logging, printed on stderr
+ */
+#pragma once
+
+#include <stdio.h>
+
+typedef enum {
+  ESP_LOG_NONE,
+  ESP_LOG_ERROR,
+  ESP_LOG_WARN,
+  ESP_LOG_INFO,
+  ESP_LOG_DEBUG,
+  ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+extern esp_log_level_t hostLogLevel;
+
+#define ESP_LOG_LEVEL_LOCAL(LEVEL, TAG, FMT, ...) \
+  do { if ((LEVEL) <= hostLogLevel) fprintf(stderr, "%s: " FMT, TAG, ##__VA_ARGS__); } while (0)
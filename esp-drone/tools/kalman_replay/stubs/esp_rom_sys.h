@@ -0,0 +1,12 @@
+/*
+ * esp_rom_sys.h - Host stand-in for the ESP-IDF ROM system functions
+ */
+#pragma once
+
+#include <stdint.h>
+
+// The host cycle counter of esp_cpu.h counts nanoseconds
+static inline uint32_t esp_rom_get_cpu_ticks_per_us(void)
+{
+  return 1000;
+}
@@ -0,0 +1,17 @@
+/*
+ * esp_timer.h - Host stand-in for the ESP-IDF high resolution timer
+ *
+ * Counts microseconds of the host monotonic clock, as the cycle counter of
+ * esp_cpu.h counts its nanoseconds.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+static inline int64_t esp_timer_get_time(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,50 @@
+/*
+ * log.h - Host stand-in for the Crazyflie log subsystem
+ *
+ * The log groups register themselves at startup, so the replay can read any
+ * log variable of the compiled modules by "group.name".
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define LOG_UINT8  1
+#define LOG_UINT16 2
+#define LOG_UINT32 3
+#define LOG_INT8   4
+#define LOG_INT16  5
+#define LOG_INT32  6
+#define LOG_FLOAT  7
+#define LOG_FP16   8
+
+#define LOG_BY_FUNCTION 0x40
+
+typedef uint32_t (*logAcquireUInt32)(uint32_t timestamp, void *data);
+typedef float (*logAcquireFloat)(uint32_t timestamp, void *data);
+
+typedef struct {
+  union {
+    logAcquireUInt32 acquireUInt32;
+    logAcquireFloat aquireFloat;
+  };
+  void *data;
+} logByFunction_t;
+
+typedef struct {
+  uint8_t type;
+  const char *name;
+  void *address;
+} hostVar_t;
+
+void hostLogRegister(const char *group, const hostVar_t *vars, int count);
+
+/* Value of a log variable, NAN if it does not exist */
+float hostLogGet(const char *group, const char *name);
+
+#define LOG_ADD(TYPE, NAME, ADDRESS) { .type = (TYPE), .name = #NAME, .address = (void *)(ADDRESS), },
+#define LOG_ADD_BY_FUNCTION(TYPE, NAME, ADDRESS) { .type = (TYPE) | LOG_BY_FUNCTION, .name = #NAME, .address = (void *)(ADDRESS), },
+
+#define LOG_GROUP_START(NAME) static const hostVar_t __logs_##NAME[] = {
+#define LOG_GROUP_STOP(NAME) }; \
+  __attribute__((constructor)) static void __logs_register_##NAME(void) \
+  { hostLogRegister(#NAME, __logs_##NAME, sizeof(__logs_##NAME) / sizeof(__logs_##NAME[0])); }
@@ -0,0 +1,36 @@
+/*
+ * param.h - Host stand-in for the Crazyflie parameter subsystem
+ *
+ * The parameter groups register themselves at startup, so the replay can set
+ * any parameter of the compiled modules by "group.name".
+ */
+#pragma once
+
+#include <stdbool.h>
+#include "log.h"
+
+#define PARAM_UINT8  0x08
+#define PARAM_UINT16 0x09
+#define PARAM_UINT32 0x0A
+#define PARAM_INT8   0x00
+#define PARAM_INT16  0x01
+#define PARAM_INT32  0x02
+#define PARAM_FLOAT  0x06
+#define PARAM_RONLY  0x40
+
+typedef int paramVarId_t;
+
+void hostParamRegister(const char *group, const hostVar_t *vars, int count);
+
+/* Set a parameter from its text value, false if it does not exist */
+bool hostParamSet(const char *group, const char *name, const char *value);
+
+paramVarId_t paramGetVarId(const char *group, const char *name);
+void paramSetInt(paramVarId_t varid, int value);
+
+#define PARAM_ADD(TYPE, NAME, ADDRESS) { .type = (TYPE), .name = #NAME, .address = (void *)(ADDRESS), },
+
+#define PARAM_GROUP_START(NAME) static const hostVar_t __params_##NAME[] = {
+#define PARAM_GROUP_STOP(NAME) }; \
+  __attribute__((constructor)) static void __params_register_##NAME(void) \
+  { hostParamRegister(#NAME, __params_##NAME, sizeof(__params_##NAME) / sizeof(__params_##NAME[0])); }
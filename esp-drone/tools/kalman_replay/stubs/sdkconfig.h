@@ -0,0 +1,21 @@
+/*
+ * sdkconfig.h - Host configuration of the Kalman replay
+ *
+ * The estimator options can be overridden from the make command line, for
+ * instance make CONFIG="-DCONFIG_KALMAN_HISTORY_LENGTH=0".
+ */
+#pragma once
+
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_BASE_STACK_SIZE 1024
+
+#ifndef CONFIG_KALMAN_PREDICT_RATE_HZ
+#define CONFIG_KALMAN_PREDICT_RATE_HZ 100
+#endif
+
+#ifndef CONFIG_KALMAN_HISTORY_LENGTH
+#define CONFIG_KALMAN_HISTORY_LENGTH 8
+#endif
+
+// As the menuconfig default, so the replay matches the estimate on board
+#define CONFIG_KALMAN_POSITION_DEADZONE 1
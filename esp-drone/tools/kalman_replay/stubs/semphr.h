@@ -0,0 +1,20 @@
+/*
+ * semphr.h - Host stand-in for the FreeRTOS semaphores
+ *
+ * Taking an empty semaphore from the task suspends it until the replay
+ * resumes it, taking one from the replay itself fails.
+ */
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct hostSemaphore_s *SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+typedef struct { int unused; } StaticSemaphore_t;
+
+SemaphoreHandle_t hostSemaphoreCreate(int count, int max);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#define vSemaphoreCreateBinary(SEMAPHORE) ((SEMAPHORE) = hostSemaphoreCreate(1, 1))
+#define xSemaphoreCreateMutexStatic(BUFFER) ((void)(BUFFER), hostSemaphoreCreate(1, 1))
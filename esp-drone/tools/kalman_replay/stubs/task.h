@@ -0,0 +1,21 @@
+/*
+ * task.h - Host stand-in for the FreeRTOS task API
+ */
+#pragma once
+
+#include "FreeRTOS.h"
+
+static inline TickType_t xTaskGetTickCount(void) { return hostTick; }
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *task);
+
+// A single core host, the core is not used
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+static inline TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth,
+                                                         void *parameters, UBaseType_t priority, StackType_t *stack,
+                                                         StaticTask_t *task, BaseType_t core)
+{
+  return xTaskCreateStatic(function, name, stackDepth, parameters, priority, stack, task);
+}
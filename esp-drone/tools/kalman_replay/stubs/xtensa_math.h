@@ -0,0 +1,120 @@
+/*
+ * xtensa_math.h - Host stand-in for the DSP library used by the Kalman filter
+ *
+ * Plain C versions of the few matrix and math functions of the estimator.
+ */
+#pragma once
+
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+typedef float float32_t;
+
+typedef enum {
+  XTENSA_MATH_SUCCESS = 0,
+  XTENSA_MATH_ARGUMENT_ERROR = -1,
+  XTENSA_MATH_SIZE_MISMATCH = -3,
+  XTENSA_MATH_SINGULAR = -5,
+} xtensa_status;
+
+typedef struct {
+  uint16_t numRows;
+  uint16_t numCols;
+  float32_t *pData;
+} xtensa_matrix_instance_f32;
+
+#ifndef PI
+#define PI 3.14159265358979f
+#endif
+
+static inline float32_t xtensa_sin_f32(float32_t x) { return sinf(x); }
+static inline float32_t xtensa_cos_f32(float32_t x) { return cosf(x); }
+
+static inline xtensa_status xtensa_sqrt_f32(float32_t in, float32_t *out)
+{
+  if (in < 0.0f) {
+    *out = 0.0f;
+    return XTENSA_MATH_ARGUMENT_ERROR;
+  }
+  *out = sqrtf(in);
+  return XTENSA_MATH_SUCCESS;
+}
+
+static inline xtensa_status xtensa_mat_trans_f32(const xtensa_matrix_instance_f32 *src, xtensa_matrix_instance_f32 *dst)
+{
+  if (src->numRows != dst->numCols || src->numCols != dst->numRows) {
+    return XTENSA_MATH_SIZE_MISMATCH;
+  }
+  for (int i = 0; i < src->numRows; i++) {
+    for (int j = 0; j < src->numCols; j++) {
+      dst->pData[j * dst->numCols + i] = src->pData[i * src->numCols + j];
+    }
+  }
+  return XTENSA_MATH_SUCCESS;
+}
+
+static inline xtensa_status xtensa_mat_mult_f32(const xtensa_matrix_instance_f32 *a, const xtensa_matrix_instance_f32 *b,
+                                                xtensa_matrix_instance_f32 *dst)
+{
+  if (a->numCols != b->numRows || dst->numRows != a->numRows || dst->numCols != b->numCols) {
+    return XTENSA_MATH_SIZE_MISMATCH;
+  }
+  for (int i = 0; i < a->numRows; i++) {
+    for (int j = 0; j < b->numCols; j++) {
+      float32_t sum = 0;
+      for (int k = 0; k < a->numCols; k++) {
+        sum += a->pData[i * a->numCols + k] * b->pData[k * b->numCols + j];
+      }
+      dst->pData[i * dst->numCols + j] = sum;
+    }
+  }
+  return XTENSA_MATH_SUCCESS;
+}
+
+// Gauss-Jordan elimination with partial pivoting, the source is overwritten as in the DSP library
+static inline xtensa_status xtensa_mat_inverse_f32(const xtensa_matrix_instance_f32 *src, xtensa_matrix_instance_f32 *dst)
+{
+  int n = src->numRows;
+  float32_t *a = src->pData;
+  float32_t *inv = dst->pData;
+  if (src->numCols != n || dst->numRows != n || dst->numCols != n) {
+    return XTENSA_MATH_SIZE_MISMATCH;
+  }
+
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      inv[i * n + j] = (i == j) ? 1.0f : 0.0f;
+    }
+  }
+  for (int c = 0; c < n; c++) {
+    int pivot = c;
+    for (int r = c + 1; r < n; r++) {
+      if (fabsf(a[r * n + c]) > fabsf(a[pivot * n + c])) {
+        pivot = r;
+      }
+    }
+    if (a[pivot * n + c] == 0.0f) {
+      return XTENSA_MATH_SINGULAR;
+    }
+    for (int j = 0; j < n; j++) {
+      float32_t t = a[c * n + j]; a[c * n + j] = a[pivot * n + j]; a[pivot * n + j] = t;
+      t = inv[c * n + j]; inv[c * n + j] = inv[pivot * n + j]; inv[pivot * n + j] = t;
+    }
+    float32_t d = a[c * n + c];
+    for (int j = 0; j < n; j++) {
+      a[c * n + j] /= d;
+      inv[c * n + j] /= d;
+    }
+    for (int r = 0; r < n; r++) {
+      if (r != c) {
+        float32_t f = a[r * n + c];
+        for (int j = 0; j < n; j++) {
+          a[r * n + j] -= f * a[c * n + j];
+          inv[r * n + j] -= f * inv[c * n + j];
+        }
+      }
+    }
+  }
+  return XTENSA_MATH_SUCCESS;
+}
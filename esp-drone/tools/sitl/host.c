@@ -0,0 +1,544 @@
+/*
+ * host.c - Host runtime of the SITL build
+ *
+ * Implements the stand-ins declared in stubs/: the log and parameter
+ * registries, the scheduler running the firmware tasks as coroutines, the
+ * queues and semaphores, the task load reported by the telemetry, and the
+ * system functions of the flight stack.
+ */
+#define _XOPEN_SOURCE 700
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "log.h"
+#include "param.h"
+#include "sysload.h"
+#include "system.h"
+#include "sitaw.h"
+#include "collision_avoidance.h"
+#include "host.h"
+
+#define MAX_GROUPS 128
+#define MAX_TASKS 16
+#define TASK_STACK_SIZE (256 * 1024)
+#define TICKS_PER_LOAD_PERIOD configTICK_RATE_HZ
+
+esp_log_level_t hostLogLevel = ESP_LOG_WARN;
+TickType_t hostTick;
+
+/* Log and parameter registries */
+
+typedef struct {
+  const char *group;
+  const hostVar_t *vars;
+  int count;
+} hostGroup_t;
+
+static hostGroup_t logGroups[MAX_GROUPS];
+static int logGroupCount;
+static hostGroup_t paramGroups[MAX_GROUPS];
+static int paramGroupCount;
+
+static void registerGroup(hostGroup_t *groups, int *count, const char *group, const hostVar_t *vars, int n)
+{
+  if (*count >= MAX_GROUPS) {
+    fprintf(stderr, "Too many groups, %s ignored\n", group);
+    return;
+  }
+  groups[*count].group = group;
+  groups[*count].vars = vars;
+  groups[*count].count = n;
+  (*count)++;
+}
+
+static const hostVar_t *findVar(const hostGroup_t *groups, int count, const char *group, const char *name)
+{
+  for (int i = 0; i < count; i++) {
+    if (strcmp(groups[i].group, group) != 0) {
+      continue;
+    }
+    for (int j = 0; j < groups[i].count; j++) {
+      if (strcmp(groups[i].vars[j].name, name) == 0) {
+        return &groups[i].vars[j];
+      }
+    }
+  }
+  return NULL;
+}
+
+void hostLogRegister(const char *group, const hostVar_t *vars, int count)
+{
+  registerGroup(logGroups, &logGroupCount, group, vars, count);
+}
+
+void hostParamRegister(const char *group, const hostVar_t *vars, int count)
+{
+  registerGroup(paramGroups, &paramGroupCount, group, vars, count);
+}
+
+float hostLogGet(const char *group, const char *name)
+{
+  const hostVar_t *var = findVar(logGroups, logGroupCount, group, name);
+  if (var == NULL) {
+    return NAN;
+  }
+  if (var->type & LOG_BY_FUNCTION) {
+    const logByFunction_t *function = var->address;
+    if ((var->type & ~LOG_BY_FUNCTION) == LOG_UINT32) {
+      return function->acquireUInt32(hostTick * portTICK_PERIOD_MS, function->data);
+    }
+    return function->aquireFloat(hostTick * portTICK_PERIOD_MS, function->data);
+  }
+
+  switch (var->type) {
+    case LOG_UINT8: return *(uint8_t *)var->address;
+    case LOG_UINT16: return *(uint16_t *)var->address;
+    case LOG_UINT32: return *(uint32_t *)var->address;
+    case LOG_INT8: return *(int8_t *)var->address;
+    case LOG_INT16: return *(int16_t *)var->address;
+    case LOG_INT32: return *(int32_t *)var->address;
+    case LOG_FLOAT: return *(float *)var->address;
+    default: return NAN;
+  }
+}
+
+bool hostParamSet(const char *group, const char *name, const char *value)
+{
+  const hostVar_t *var = findVar(paramGroups, paramGroupCount, group, name);
+  if (var == NULL) {
+    return false;
+  }
+
+  switch (var->type & ~PARAM_RONLY) {
+    case PARAM_UINT8: *(uint8_t *)var->address = strtoul(value, NULL, 0); break;
+    case PARAM_UINT16: *(uint16_t *)var->address = strtoul(value, NULL, 0); break;
+    case PARAM_UINT32: *(uint32_t *)var->address = strtoul(value, NULL, 0); break;
+    case PARAM_INT8: *(int8_t *)var->address = strtol(value, NULL, 0); break;
+    case PARAM_INT16: *(int16_t *)var->address = strtol(value, NULL, 0); break;
+    case PARAM_INT32: *(int32_t *)var->address = strtol(value, NULL, 0); break;
+    case PARAM_FLOAT: *(float *)var->address = strtof(value, NULL); break;
+    default: return false;
+  }
+  return true;
+}
+
+/* Parameter ids are indexes in a flat table of the registered variables */
+
+static const hostVar_t *paramIds[1024];
+static int paramIdCount;
+
+paramVarId_t paramGetVarId(const char *group, const char *name)
+{
+  const hostVar_t *var = findVar(paramGroups, paramGroupCount, group, name);
+  if (var == NULL) {
+    return -1;
+  }
+  for (int i = 0; i < paramIdCount; i++) {
+    if (paramIds[i] == var) {
+      return i;
+    }
+  }
+  if (paramIdCount >= (int)(sizeof(paramIds) / sizeof(paramIds[0]))) {
+    return -1;
+  }
+  paramIds[paramIdCount] = var;
+  return paramIdCount++;
+}
+
+void paramSetInt(paramVarId_t varid, int value)
+{
+  if (varid < 0 || varid >= paramIdCount) {
+    return;
+  }
+  char text[16];
+  snprintf(text, sizeof(text), "%d", value);
+  const hostVar_t *var = paramIds[varid];
+  for (int i = 0; i < paramGroupCount; i++) {
+    if (var >= paramGroups[i].vars && var < paramGroups[i].vars + paramGroups[i].count) {
+      hostParamSet(paramGroups[i].group, var->name, text);
+      return;
+    }
+  }
+}
+
+/* Scheduler: the tasks run as coroutines, highest priority first, until they block */
+
+struct hostTask_s {
+  const char *name;
+  UBaseType_t priority;
+  ucontext_t context;
+  TaskFunction_t function;
+  void *parameters;
+  // Resumed on every pass while waiting on a queue or a semaphore, from
+  // wakeTick on while delayed
+  bool waiting;
+  TickType_t wakeTick;
+  uint64_t runNs;          // Host time spent running the task
+  uint64_t periodStartNs;  // runNs at the start of the load period
+  uint16_t load;           // Load of the last period, in 0.01 % of one core
+};
+
+static struct hostTask_s *tasks[MAX_TASKS];
+static int taskCount;
+static struct hostTask_s *current;
+static ucontext_t schedulerContext;
+// Set when a queue or semaphore changed, the waiting tasks get another pass
+static bool progress;
+static uint64_t loadTimestamp;
+static uint64_t tickStartNs;
+
+uint64_t hostNowNs(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+void hostStartTick(void)
+{
+  tickStartNs = hostNowNs();
+}
+
+int64_t esp_timer_get_time(void)
+{
+  uint64_t inTick = (hostNowNs() - tickStartNs) / 1000;
+  return (int64_t)hostTick * 1000 + (inTick < 999 ? inTick : 999);
+}
+
+static void taskEntry(void)
+{
+  current->function(current->parameters);
+  fprintf(stderr, "Task %s returned\n", current->name);
+  exit(1);
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *buffer)
+{
+  if (taskCount >= MAX_TASKS) {
+    fprintf(stderr, "Too many tasks, %s not created\n", name);
+    return NULL;
+  }
+
+  // Kept sorted by decreasing priority, in creation order among equals
+  struct hostTask_s *task = calloc(1, sizeof(*task));
+  int slot = taskCount++;
+  for (; slot > 0 && tasks[slot - 1]->priority < priority; slot--) {
+    tasks[slot] = tasks[slot - 1];
+  }
+  tasks[slot] = task;
+  task->name = name;
+  task->priority = priority;
+  task->function = function;
+  task->parameters = parameters;
+  task->wakeTick = hostTick;
+
+  getcontext(&task->context);
+  // The host C library needs more stack than the firmware task is given
+  task->context.uc_stack.ss_sp = malloc(TASK_STACK_SIZE);
+  task->context.uc_stack.ss_size = TASK_STACK_SIZE;
+  task->context.uc_link = NULL;
+  makecontext(&task->context, taskEntry, 0);
+  return task;
+}
+
+static void resume(struct hostTask_s *task)
+{
+  uint64_t start = hostNowNs();
+  current = task;
+  swapcontext(&schedulerContext, &task->context);
+  current = NULL;
+  task->runNs += hostNowNs() - start;
+}
+
+// Gives the hand back to the scheduler, the task is resumed on the next pass
+// if waiting, from wakeTick on otherwise
+static void block(bool waiting, TickType_t wakeTick)
+{
+  struct hostTask_s *task = current;
+  task->waiting = waiting;
+  task->wakeTick = wakeTick;
+  swapcontext(&task->context, &schedulerContext);
+}
+
+static void updateLoad(void)
+{
+  if (hostTick % TICKS_PER_LOAD_PERIOD != 0) {
+    return;
+  }
+  // Load at real time: host time per simulated second
+  for (int i = 0; i < taskCount; i++) {
+    uint64_t ns = tasks[i]->runNs - tasks[i]->periodStartNs;
+    uint64_t load = ns / (1000000000u / 10000);
+    tasks[i]->load = load > UINT16_MAX ? UINT16_MAX : load;
+    tasks[i]->periodStartNs = tasks[i]->runNs;
+  }
+  loadTimestamp = (uint64_t)hostTick * 1000;
+}
+
+void hostRunTasks(void)
+{
+  do {
+    progress = false;
+    for (int i = 0; i < taskCount; i++) {
+      struct hostTask_s *task = tasks[i];
+      if (task->waiting || (int32_t)(hostTick - task->wakeTick) >= 0) {
+        resume(task);
+      }
+    }
+  } while (progress);
+  updateLoad();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  if (current != NULL) {
+    block(false, hostTick + (ticks > 0 ? ticks : 1));
+  }
+}
+
+void vTaskDelayUntil(TickType_t *previousWake, TickType_t period)
+{
+  *previousWake += period;
+  if (current != NULL && (int32_t)(*previousWake - hostTick) > 0) {
+    block(false, *previousWake);
+  }
+}
+
+// Waits for the next pass from a task, false once the timeout expired or
+// outside of the tasks
+static bool waitMore(TickType_t start, TickType_t timeout)
+{
+  if (current == NULL || timeout == 0) {
+    return false;
+  }
+  if (timeout != portMAX_DELAY && hostTick - start >= timeout) {
+    return false;
+  }
+  block(true, hostTick);
+  return true;
+}
+
+/* Queues */
+
+struct hostQueue_s {
+  uint8_t *storage;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+  UBaseType_t head;
+  UBaseType_t count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+  QueueHandle_t queue = calloc(1, sizeof(*queue));
+  queue->storage = calloc(length, itemSize);
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+static uint8_t *queueItem(QueueHandle_t queue, UBaseType_t index)
+{
+  return queue->storage + ((queue->head + index) % queue->length) * queue->itemSize;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout)
+{
+  TickType_t start = hostTick;
+  while (queue->count >= queue->length) {
+    if (!waitMore(start, timeout)) {
+      return pdFALSE;
+    }
+  }
+  memcpy(queueItem(queue, queue->count), item, queue->itemSize);
+  queue->count++;
+  progress = true;
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t timeout)
+{
+  TickType_t start = hostTick;
+  while (queue->count >= queue->length) {
+    if (!waitMore(start, timeout)) {
+      return pdFALSE;
+    }
+  }
+  queue->head = (queue->head + queue->length - 1) % queue->length;
+  memcpy(queueItem(queue, 0), item, queue->itemSize);
+  queue->count++;
+  progress = true;
+  return pdTRUE;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+  // Meant for length 1 queues, as in FreeRTOS
+  memcpy(queueItem(queue, 0), item, queue->itemSize);
+  queue->count = 1;
+  progress = true;
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t timeout)
+{
+  TickType_t start = hostTick;
+  while (queue->count == 0) {
+    if (!waitMore(start, timeout)) {
+      return pdFALSE;
+    }
+  }
+  memcpy(item, queueItem(queue, 0), queue->itemSize);
+  queue->head = (queue->head + 1) % queue->length;
+  queue->count--;
+  progress = true;
+  return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t timeout)
+{
+  TickType_t start = hostTick;
+  while (queue->count == 0) {
+    if (!waitMore(start, timeout)) {
+      return pdFALSE;
+    }
+  }
+  memcpy(item, queueItem(queue, 0), queue->itemSize);
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+  return queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+  queue->head = 0;
+  queue->count = 0;
+  progress = true;
+  return pdPASS;
+}
+
+/* Semaphores */
+
+struct hostSemaphore_s {
+  int count;
+  int max;
+};
+
+SemaphoreHandle_t hostSemaphoreCreate(int count, int max)
+{
+  SemaphoreHandle_t semaphore = malloc(sizeof(*semaphore));
+  semaphore->count = count;
+  semaphore->max = max;
+  return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout)
+{
+  TickType_t start = hostTick;
+  while (semaphore->count == 0) {
+    if (!waitMore(start, timeout)) {
+      return pdFALSE;
+    }
+  }
+  semaphore->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+  if (semaphore->count >= semaphore->max) {
+    return pdFALSE;
+  }
+  semaphore->count++;
+  progress = true;
+  return pdTRUE;
+}
+
+/* Load monitor: the host time of the tasks per simulated second. The stack
+ * and the heap of the host say nothing of those on board, they are reported
+ * as 0. */
+
+int sysLoadGetTasks(sysLoadTask_t *list, int maxTasks, uint64_t *timestamp)
+{
+  int count = taskCount < maxTasks ? taskCount : maxTasks;
+  for (int i = 0; i < count; i++) {
+    memset(&list[i], 0, sizeof(list[i]));
+    strncpy(list[i].name, tasks[i]->name, SYSLOAD_TASK_NAME_LEN - 1);
+    list[i].load = tasks[i]->load;
+    list[i].priority = tasks[i]->priority;
+  }
+  *timestamp = loadTimestamp;
+  return count;
+}
+
+void hostPrintTasks(FILE *file, uint64_t wallNs)
+{
+  fprintf(file, "Task host time [ms] over %.1f s of wall time:\n", wallNs / 1e9);
+  for (int i = 0; i < taskCount; i++) {
+    fprintf(file, "  %-20s pri %2u %10.1f\n", tasks[i]->name, tasks[i]->priority, tasks[i]->runNs / 1e6);
+  }
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+  return 0;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+  return 0;
+}
+
+/* System: armed from the start, without situation awareness nor collision avoidance */
+
+void systemWaitStart(void)
+{
+}
+
+bool systemIsArmed(void)
+{
+  return true;
+}
+
+void sitAwInit(void)
+{
+}
+
+void sitAwUpdateSetpoint(setpoint_t *setpoint, const sensorData_t *sensorData, const state_t *state)
+{
+}
+
+void collisionAvoidanceInit(void)
+{
+}
+
+bool collisionAvoidanceTest(void)
+{
+  return true;
+}
+
+void collisionAvoidanceUpdateSetpoint(setpoint_t *setpoint, sensorData_t const *sensorData, state_t const *state,
+                                      uint32_t tick)
+{
+}
+
+void assertFail(char *exp, char *file, int line)
+{
+  fprintf(stderr, "Assert failed %s:%d (%s) at tick %u\n", file, line, exp, (unsigned)hostTick);
+  exit(1);
+}
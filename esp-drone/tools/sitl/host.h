@@ -0,0 +1,24 @@
+/*
+ * host.h - Host runtime of the SITL build
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Host monotonic time, in ns */
+uint64_t hostNowNs(void);
+
+/* Starts the next simulated tick, call after advancing hostTick */
+void hostStartTick(void);
+
+/* Prints the host time spent in each task */
+void hostPrintTasks(FILE *file, uint64_t wallNs);
+
+/* UDP link of wifi.c, in place of the access point of the board */
+bool hostWifiOpen(uint16_t port);
+/* Handles the packets received since the last call */
+void hostWifiReceive(void);
+/* Sends the packets queued since the last call */
+void hostWifiSend(void);
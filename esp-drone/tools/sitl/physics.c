@@ -0,0 +1,433 @@
+/*
+ * physics.c - Simulated quadcopter of the SITL build
+ *
+ * Integrates the rigid body once per 1 ms tick and samples the IMU every
+ * tick and the barometer every BARO_PERIOD_TICKS, as the sensor task does on
+ * board. Implements the motor, sensor and power management functions the
+ * flight stack calls, in place of the drivers.
+ *
+ * Motors, seen from above, x forward and y left:
+ *
+ *   M4 (+x +y)   M1 (+x -y)
+ *   M3 (-x +y)   M2 (-x -y)
+ *
+ * M1 and M3 spin counter clockwise, M2 and M4 clockwise, as the yaw mixing
+ * of power_distribution_stock.c expects.
+ */
+#include <math.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "motors.h"
+#include "pm_esplane.h"
+#include "sensors.h"
+#include "physics.h"
+
+#define DT (1.0 / configTICK_RATE_HZ)
+#define GRAVITY 9.81
+// Motor distance to the body axes (m), yaw torque per thrust (m) and lag (s)
+#define ARM_LENGTH 0.0325
+#define YAW_TORQUE_PER_THRUST 0.006
+#define MOTOR_TIME_CONSTANT 0.015
+#define MOTOR_THRUST_MAX (MOTORS_THRUST_MAX_GRAMS / 1000.0 * GRAVITY)
+// Inertia of a 50 g frame (kg m^2), scaled with the mass, and drag (N / (m/s))
+#define INERTIA_XY_PER_KG 5.2e-4
+#define INERTIA_Z_PER_KG 8.2e-4
+#define DRAG 0.01
+
+#define BARO_PERIOD_TICKS 20
+#define SEA_LEVEL_PRESSURE 1013.25f
+
+// Battery: open circuit voltage over the charge, sag at full thrust and
+// charge used per second at full thrust
+#define BAT_EMPTY_VOLTAGE 3.3f
+#define BAT_FULL_VOLTAGE 4.2f
+#define BAT_SAG_FULL_THRUST 0.4f
+#define BAT_DRAIN_FULL_THRUST (1.0f / 180)
+
+physicsParams_t physicsParams = {
+  .mass = 0.050f,
+  .gyroNoise = 0.1f,
+  .accNoise = 0.005f,
+  .baroNoise = 0.05f,
+};
+physicsState_t physicsState;
+
+const uint16_t testsound[NBR_OF_MOTORS] = {0};
+
+static uint16_t motorRatios[NBR_OF_MOTORS];
+static uint32_t rngState;
+static uint32_t stepCount;
+
+static struct {
+  Axis3f acc;
+  Axis3f gyro;
+  baro_t baro;
+  uint64_t timestamp;
+  bool accNew;
+  bool gyroNew;
+  bool baroNew;
+} sample;
+static SemaphoreHandle_t dataReady;
+
+static struct {
+  float charge;              // 0 to 1
+  float voltage;
+  float voltageMin;
+  float voltageMax;
+  float thrustAverage;       // Fraction of full thrust, low pass filtered
+} cell = {.charge = 1.0f, .voltage = BAT_FULL_VOLTAGE, .voltageMin = BAT_FULL_VOLTAGE,
+          .voltageMax = BAT_FULL_VOLTAGE};
+
+/* Noise */
+
+static uint32_t xorshift(void)
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+float physicsNoise(float stdDev)
+{
+  // Box-Muller, one of the pair
+  double u1 = (xorshift() + 1.0) / 4294967297.0;
+  double u2 = xorshift() / 4294967296.0;
+  return stdDev * sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+/* Rigid body */
+
+// v_world = q v_body q*
+static void rotate(const double q[4], const double v[3], double out[3])
+{
+  double w = q[0], x = q[1], y = q[2], z = q[3];
+  out[0] = (1 - 2 * (y * y + z * z)) * v[0] + 2 * (x * y - w * z) * v[1] + 2 * (x * z + w * y) * v[2];
+  out[1] = 2 * (x * y + w * z) * v[0] + (1 - 2 * (x * x + z * z)) * v[1] + 2 * (y * z - w * x) * v[2];
+  out[2] = 2 * (x * z - w * y) * v[0] + 2 * (y * z + w * x) * v[1] + (1 - 2 * (x * x + y * y)) * v[2];
+}
+
+static void rotateInverse(const double q[4], const double v[3], double out[3])
+{
+  const double conjugate[4] = {q[0], -q[1], -q[2], -q[3]};
+  rotate(conjugate, v, out);
+}
+
+void physicsGetAttitude(float *roll, float *pitch, float *yaw)
+{
+  double w = physicsState.quat[0], x = physicsState.quat[1], y = physicsState.quat[2], z = physicsState.quat[3];
+  *roll = atan2(2 * (w * x + y * z), 1 - 2 * (x * x + y * y)) * 180 / M_PI;
+  // Nose up is positive, as in the state estimate
+  *pitch = -asin(fmax(-1, fmin(1, 2 * (w * y - x * z)))) * 180 / M_PI;
+  *yaw = atan2(2 * (w * z + x * y), 1 - 2 * (y * y + z * z)) * 180 / M_PI;
+}
+
+void physicsInit(uint32_t seed)
+{
+  memset(&physicsState, 0, sizeof(physicsState));
+  physicsState.quat[0] = 1;
+  physicsState.grounded = true;
+  physicsState.specificForce[2] = GRAVITY;
+  rngState = seed != 0 ? seed : 1;
+}
+
+static void updateMotors(double *force, double torque[3])
+{
+  double *thrust = physicsState.thrust;
+  for (int i = 0; i < NBR_OF_MOTORS; i++) {
+    double target = MOTOR_THRUST_MAX * motorRatios[i] / UINT16_MAX;
+    thrust[i] += (target - thrust[i]) * DT / MOTOR_TIME_CONSTANT;
+  }
+
+  *force = thrust[0] + thrust[1] + thrust[2] + thrust[3];
+  torque[0] = ARM_LENGTH * (-thrust[0] - thrust[1] + thrust[2] + thrust[3]);
+  torque[1] = ARM_LENGTH * (-thrust[0] + thrust[1] + thrust[2] - thrust[3]);
+  torque[2] = YAW_TORQUE_PER_THRUST * (-thrust[0] + thrust[1] - thrust[2] + thrust[3]);
+}
+
+static void integrateAttitude(const double torque[3])
+{
+  double *w = physicsState.rates;
+  const double inertia[3] = {
+    INERTIA_XY_PER_KG * physicsParams.mass,
+    INERTIA_XY_PER_KG * physicsParams.mass,
+    INERTIA_Z_PER_KG * physicsParams.mass,
+  };
+
+  // Euler's equations: I dw/dt = torque - w x (I w)
+  double dw[3] = {
+    (torque[0] - (inertia[2] - inertia[1]) * w[1] * w[2]) / inertia[0],
+    (torque[1] - (inertia[0] - inertia[2]) * w[2] * w[0]) / inertia[1],
+    (torque[2] - (inertia[1] - inertia[0]) * w[0] * w[1]) / inertia[2],
+  };
+  for (int i = 0; i < 3; i++) {
+    w[i] += dw[i] * DT;
+  }
+
+  double *q = physicsState.quat;
+  double dq[4] = {
+    0.5 * (-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]),
+    0.5 * (q[0] * w[0] + q[2] * w[2] - q[3] * w[1]),
+    0.5 * (q[0] * w[1] - q[1] * w[2] + q[3] * w[0]),
+    0.5 * (q[0] * w[2] + q[1] * w[1] - q[2] * w[0]),
+  };
+  double norm = 0;
+  for (int i = 0; i < 4; i++) {
+    q[i] += dq[i] * DT;
+    norm += q[i] * q[i];
+  }
+  norm = sqrt(norm);
+  for (int i = 0; i < 4; i++) {
+    q[i] /= norm;
+  }
+}
+
+// Puts the body back level on the ground, keeping its heading
+static void land(void)
+{
+  double *q = physicsState.quat;
+  double yaw = atan2(2 * (q[0] * q[3] + q[1] * q[2]), 1 - 2 * (q[2] * q[2] + q[3] * q[3]));
+  q[0] = cos(yaw / 2);
+  q[1] = 0;
+  q[2] = 0;
+  q[3] = sin(yaw / 2);
+  memset(physicsState.rates, 0, sizeof(physicsState.rates));
+  memset(physicsState.velocity, 0, sizeof(physicsState.velocity));
+  physicsState.position[2] = 0;
+  physicsState.grounded = true;
+}
+
+static void integrateBody(void)
+{
+  double force;
+  double torque[3];
+  updateMotors(&force, torque);
+
+  const double bodyThrust[3] = {0, 0, force};
+  double thrust[3];
+  rotate(physicsState.quat, bodyThrust, thrust);
+
+  const double mass = physicsParams.mass;
+  double *v = physicsState.velocity;
+  double acc[3] = {
+    (thrust[0] + physicsParams.windX - DRAG * v[0]) / mass,
+    (thrust[1] + physicsParams.windY - DRAG * v[1]) / mass,
+    (thrust[2] - DRAG * v[2]) / mass - GRAVITY,
+  };
+
+  // Resting on the ground until the thrust lifts the weight
+  if (physicsState.grounded && acc[2] <= 0) {
+    land();
+    const double up[3] = {0, 0, GRAVITY};
+    rotateInverse(physicsState.quat, up, physicsState.specificForce);
+    return;
+  }
+  physicsState.grounded = false;
+
+  integrateAttitude(torque);
+  for (int i = 0; i < 3; i++) {
+    v[i] += acc[i] * DT;
+    physicsState.position[i] += v[i] * DT;
+  }
+  if (physicsState.position[2] <= 0 && v[2] < 0) {
+    land();
+  }
+
+  const double specific[3] = {acc[0], acc[1], acc[2] + GRAVITY};
+  rotateInverse(physicsState.quat, specific, physicsState.specificForce);
+}
+
+static void updateBattery(void)
+{
+  float thrust = 0;
+  for (int i = 0; i < NBR_OF_MOTORS; i++) {
+    thrust += (float)motorRatios[i] / UINT16_MAX / NBR_OF_MOTORS;
+  }
+  cell.thrustAverage += (thrust - cell.thrustAverage) * 0.001f;
+  cell.charge = fmaxf(0, cell.charge - thrust * BAT_DRAIN_FULL_THRUST * DT);
+  cell.voltage = BAT_EMPTY_VOLTAGE + (BAT_FULL_VOLTAGE - BAT_EMPTY_VOLTAGE) * cell.charge -
+                    BAT_SAG_FULL_THRUST * thrust;
+  cell.voltageMin = fminf(cell.voltageMin, cell.voltage);
+  cell.voltageMax = fmaxf(cell.voltageMax, cell.voltage);
+}
+
+static void sampleSensors(void)
+{
+  const float degrees = 180 / M_PI;
+  sample.timestamp = (uint64_t)hostTick * 1000;
+
+  sample.gyro.x = physicsState.rates[0] * degrees + physicsNoise(physicsParams.gyroNoise);
+  sample.gyro.y = physicsState.rates[1] * degrees + physicsNoise(physicsParams.gyroNoise);
+  sample.gyro.z = physicsState.rates[2] * degrees + physicsNoise(physicsParams.gyroNoise);
+  sample.acc.x = physicsState.specificForce[0] / GRAVITY + physicsNoise(physicsParams.accNoise);
+  sample.acc.y = physicsState.specificForce[1] / GRAVITY + physicsNoise(physicsParams.accNoise);
+  sample.acc.z = physicsState.specificForce[2] / GRAVITY + physicsNoise(physicsParams.accNoise);
+  sample.accNew = true;
+  sample.gyroNew = true;
+
+  if (stepCount % BARO_PERIOD_TICKS == 0) {
+    sample.baro.asl = physicsState.position[2] + physicsNoise(physicsParams.baroNoise);
+    sample.baro.pressure = SEA_LEVEL_PRESSURE * powf(1 - sample.baro.asl / 44330, 5.255f);
+    sample.baro.temperature = 25;
+    sample.baroNew = true;
+  }
+}
+
+void physicsStep(void)
+{
+  integrateBody();
+  updateBattery();
+  sampleSensors();
+  stepCount++;
+
+  if (dataReady) {
+    xSemaphoreGive(dataReady);
+  }
+}
+
+/* Sensors, read once per new sample as from the sensor queues */
+
+void sensorsInit(void)
+{
+  dataReady = hostSemaphoreCreate(0, 1);
+}
+
+bool sensorsTest(void)
+{
+  return true;
+}
+
+bool sensorsAreCalibrated(void)
+{
+  return true;
+}
+
+void sensorsWaitDataReady(void)
+{
+  xSemaphoreTake(dataReady, portMAX_DELAY);
+}
+
+bool sensorsReadAccTimestamped(Axis3f *acc, uint64_t *timestamp)
+{
+  if (!sample.accNew) {
+    return false;
+  }
+  *acc = sample.acc;
+  *timestamp = sample.timestamp;
+  sample.accNew = false;
+  return true;
+}
+
+bool sensorsReadGyroTimestamped(Axis3f *gyro, uint64_t *timestamp)
+{
+  if (!sample.gyroNew) {
+    return false;
+  }
+  *gyro = sample.gyro;
+  *timestamp = sample.timestamp;
+  sample.gyroNew = false;
+  return true;
+}
+
+bool sensorsReadBaroTimestamped(baro_t *baro, uint64_t *timestamp)
+{
+  if (!sample.baroNew) {
+    return false;
+  }
+  *baro = sample.baro;
+  *timestamp = sample.timestamp;
+  sample.baroNew = false;
+  return true;
+}
+
+void sensorsAcquire(sensorData_t *sensors, const uint32_t tick)
+{
+  sensorsReadGyroTimestamped(&sensors->gyro, &sensors->gyroTimestamp);
+  sensorsReadAccTimestamped(&sensors->acc, &sensors->accTimestamp);
+  sensorsReadBaroTimestamped(&sensors->baro, &sensors->baroTimestamp);
+  sensors->interruptTimestamp = sample.timestamp;
+}
+
+void sensorsSetAccMode(accModes accMode)
+{
+}
+
+/* Motors */
+
+const MotorPerifDef **platformConfigGetMotorMapping()
+{
+  return NULL;
+}
+
+void motorsInit(const MotorPerifDef **motorMapSelect)
+{
+  memset(motorRatios, 0, sizeof(motorRatios));
+}
+
+bool motorsTest(void)
+{
+  return true;
+}
+
+void motorsSetRatio(uint32_t id, uint16_t ratio)
+{
+  if (id < NBR_OF_MOTORS) {
+    motorRatios[id] = ratio;
+  }
+}
+
+void motorsSetRatios(const uint16_t ratios[NBR_OF_MOTORS])
+{
+  memcpy(motorRatios, ratios, sizeof(motorRatios));
+}
+
+int motorsGetRatio(uint32_t id)
+{
+  return id < NBR_OF_MOTORS ? motorRatios[id] : 0;
+}
+
+void motorsBeep(int id, bool enable, uint16_t frequency, uint16_t ratio)
+{
+}
+
+/* Power management */
+
+float pmGetBatteryVoltage(void)
+{
+  return cell.voltage;
+}
+
+float pmGetBatteryVoltageCompensated(void)
+{
+  return BAT_EMPTY_VOLTAGE + (BAT_FULL_VOLTAGE - BAT_EMPTY_VOLTAGE) * cell.charge;
+}
+
+float pmGetBatteryCharge(void)
+{
+  return cell.charge * 100;
+}
+
+float pmGetRemainingFlightTime(void)
+{
+  if (cell.thrustAverage <= 0.01f) {
+    return -1;
+  }
+  return cell.charge / (cell.thrustAverage * BAT_DRAIN_FULL_THRUST);
+}
+
+float pmGetBatteryVoltageMin(void)
+{
+  return cell.voltageMin;
+}
+
+float pmGetBatteryVoltageMax(void)
+{
+  return cell.voltageMax;
+}
+
+PMStates pmUpdateState(void)
+{
+  return cell.charge > 0.1f ? battery : lowPower;
+}
@@ -0,0 +1,44 @@
+/*
+ * physics.h - Simulated quadcopter of the SITL build
+ *
+ * A rigid body in X formation, pushed by the four motors of motors.h with a
+ * first order lag, in a world frame with z up. The motors, the sensors and
+ * the battery of the flight stack are stand-ins reading and driving it.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  float mass;                 // kg
+  float gyroNoise;            // deg/s, standard deviation
+  float accNoise;             // G, standard deviation
+  float baroNoise;            // m, standard deviation
+  float windX, windY;         // Constant wind force (N)
+} physicsParams_t;
+
+typedef struct {
+  double position[3];         // m, world frame
+  double velocity[3];         // m/s, world frame
+  double quat[4];             // w, x, y, z, body to world
+  double rates[3];            // rad/s, body frame
+  double thrust[4];           // N, per motor
+  double specificForce[3];    // m/s^2, body frame, what the accelerometer reads
+  bool grounded;
+} physicsState_t;
+
+extern physicsParams_t physicsParams;
+extern physicsState_t physicsState;
+
+/* Rests the quadcopter on the ground at the origin, seeding the sensor noise */
+void physicsInit(uint32_t seed);
+
+/* Advances the simulation by one tick, and samples the sensors of that tick */
+void physicsStep(void);
+
+/* Gaussian noise of the given standard deviation, from the seeded generator */
+float physicsNoise(float stdDev);
+
+/* Roll, pitch and yaw of the body, in degrees as in the state estimate */
+void physicsGetAttitude(float *roll, float *pitch, float *yaw);
@@ -0,0 +1,314 @@
+/*
+ * sitl.c - The flight stack in the loop with a simulated quadcopter, on the host
+ *
+ * The stabilizer, the estimators, the controllers, the power distribution
+ * and the telemetry are compiled unchanged against the stand-ins of stubs/,
+ * host.c, physics.c and wifi.c. Every simulated 1 ms tick:
+ *
+ *   1. the quadcopter is advanced with the motor ratios of the last tick and
+ *      its sensors are sampled, which wakes the stabilizer up
+ *   2. the packets received on the UDP socket are handled
+ *   3. the firmware tasks run until they all wait for a later tick
+ *   4. the telemetry packets they queued are sent
+ *
+ * The ticks are paced to the wall clock times the speed factor, or run as
+ * fast as possible with -s 0. The commander is replaced by a flight plan:
+ * rest on the ground, take off to the hover height, then hover or fly a
+ * circle. With the Kalman estimator, a simulated motion capture feeds it the
+ * position at 100 Hz.
+ *
+ * The report gives the stabilizer timing histograms and the host time of the
+ * tasks, the speed reached against real time, and the RMS estimate and
+ * tracking errors against the simulated truth.
+ *
+ * Usage: sitl [-s speed] [-t seconds] [-u port] [-e estimator] [-f plan] [-z height]
+ *             [-p group.name=value]... [-S seed] [-v]
+ */
+#define _XOPEN_SOURCE 700
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "esp_log.h"
+#include "param.h"
+#include "commander.h"
+#include "estimator.h"
+#include "estimator_kalman.h"
+#include "stabilizer.h"
+#include "drone_telemetry.h"
+#include "host.h"
+#include "physics.h"
+
+#define MAX_PARAMS 32
+#define UDP_PORT 2390
+
+// Flight plan: rest, take off, then hover or circle
+#define REST_TICKS 1000
+#define TAKEOFF_TICKS 2000
+#define CIRCLE_RADIUS 0.5f
+#define CIRCLE_PERIOD_S 8.0f
+
+// Simulated motion capture
+#define MOCAP_PERIOD_TICKS 10
+#define MOCAP_NOISE 0.001f
+#define MOCAP_STD_DEV 0.01f
+
+// Errors are summed from the end of the take off on
+#define SETTLE_TICKS 1000
+
+// The flight stack starts a second after boot, as on board: the estimators
+// take the timestamps of samples never received (0) as stale only then
+#define BOOT_TICKS 1000
+
+typedef enum {
+  planHover,
+  planCircle,
+} flightPlan_t;
+
+static flightPlan_t plan = planHover;
+static float height = 0.5f;
+static bool useMocap;
+
+static void usage(const char *name)
+{
+  fprintf(stderr, "Usage: %s [-s speed] [-t seconds] [-u port] [-e estimator] [-f plan] [-z height]\n"
+                  "       [-p group.name=value]... [-S seed] [-v]\n", name);
+  fprintf(stderr, "  -s speed    simulated time per wall time, 0 as fast as possible (default 1)\n");
+  fprintf(stderr, "  -t seconds  simulated flight time (default 20)\n");
+  fprintf(stderr, "  -u port     UDP port of the telemetry (default %d)\n", UDP_PORT);
+  fprintf(stderr, "  -e name     kalman or complementary (default kalman)\n");
+  fprintf(stderr, "  -f plan     hover or circle (default hover)\n");
+  fprintf(stderr, "  -z height   hover height [m] (default 0.5)\n");
+  fprintf(stderr, "  -p g.n=v    set a firmware parameter before the flight\n");
+  fprintf(stderr, "  -S seed     seed of the sensor noise (default 1)\n");
+  fprintf(stderr, "  -v          print the firmware debug output\n");
+  exit(2);
+}
+
+/* Flight plan, in place of the commander */
+
+void commanderGetSetpoint(setpoint_t *setpoint, const state_t *state)
+{
+  memset(setpoint, 0, sizeof(*setpoint));
+  setpoint->timestamp = hostTick;
+  if (hostTick < BOOT_TICKS + REST_TICKS) {
+    return;
+  }
+
+  setpoint->mode.x = modeAbs;
+  setpoint->mode.y = modeAbs;
+  setpoint->mode.z = modeAbs;
+  setpoint->mode.yaw = modeAbs;
+
+  uint32_t flying = hostTick - BOOT_TICKS - REST_TICKS;
+  if (flying < TAKEOFF_TICKS) {
+    setpoint->position.z = height * flying / TAKEOFF_TICKS;
+  } else {
+    setpoint->position.z = height;
+  }
+
+  if (plan == planCircle && flying >= TAKEOFF_TICKS) {
+    // Starts from the origin, around a centre on -x
+    float w = 2 * (float)M_PI / CIRCLE_PERIOD_S;
+    float t = (flying - TAKEOFF_TICKS) / (float)configTICK_RATE_HZ;
+    setpoint->position.x = CIRCLE_RADIUS * (cosf(w * t) - 1);
+    setpoint->position.y = CIRCLE_RADIUS * sinf(w * t);
+    setpoint->velocity.x = -CIRCLE_RADIUS * w * sinf(w * t);
+    setpoint->velocity.y = CIRCLE_RADIUS * w * cosf(w * t);
+  }
+}
+
+static void feedMocap(void)
+{
+  if (!useMocap || hostTick % MOCAP_PERIOD_TICKS != 0) {
+    return;
+  }
+  positionMeasurement_t position = {
+    .x = physicsState.position[0] + physicsNoise(MOCAP_NOISE),
+    .y = physicsState.position[1] + physicsNoise(MOCAP_NOISE),
+    .z = physicsState.position[2] + physicsNoise(MOCAP_NOISE),
+    .stdDev = MOCAP_STD_DEV,
+  };
+  estimatorEnqueuePosition(&position);
+}
+
+/* Report */
+
+static double estimateSquares[3];
+static double trackingSquares[3];
+static uint32_t errorCount;
+
+static void sumErrors(void)
+{
+  if (hostTick < BOOT_TICKS + REST_TICKS + TAKEOFF_TICKS + SETTLE_TICKS) {
+    return;
+  }
+  const state_t *state = stabilizerGetState();
+  setpoint_t setpoint;
+  commanderGetSetpoint(&setpoint, state);
+
+  double estimate[3] = {state->position.x, state->position.y, state->position.z};
+  double target[3] = {setpoint.position.x, setpoint.position.y, setpoint.position.z};
+  for (int i = 0; i < 3; i++) {
+    double e = estimate[i] - physicsState.position[i];
+    double t = target[i] - physicsState.position[i];
+    estimateSquares[i] += e * e;
+    trackingSquares[i] += t * t;
+  }
+  errorCount++;
+}
+
+static void reportTiming(void)
+{
+  static const char *stages[stabilizerTimingCount] = {
+    "estimator", "setpoint", "controller", "power", "loop", "jitter",
+  };
+  stabilizerTimingHistogram_t histograms[stabilizerTimingCount];
+  stabilizerGetTimingHistograms(histograms);
+
+  printf("Stabilizer timing [us], iterations per bin:\n");
+  printf("  %-10s", "");
+  for (int b = 0; b < STABILIZER_TIMING_BINS - 1; b++) {
+    printf("  <%-6u", stabilizerTimingBinEdges[b]);
+  }
+  printf("   more\n");
+  for (int s = 0; s < stabilizerTimingCount; s++) {
+    printf("  %-10s", stages[s]);
+    for (int b = 0; b < STABILIZER_TIMING_BINS; b++) {
+      printf(" %8u", (unsigned)histograms[s].bins[b]);
+    }
+    printf("\n");
+  }
+}
+
+static void report(uint64_t wallNs)
+{
+  double simulated = (hostTick - BOOT_TICKS) / (double)configTICK_RATE_HZ;
+  printf("Simulated %.1f s in %.2f s of wall time, %.1fx real time\n", simulated, wallNs / 1e9,
+         simulated / (wallNs / 1e9));
+  reportTiming();
+  hostPrintTasks(stdout, wallNs);
+
+  if (errorCount == 0) {
+    printf("Flight too short, errors not computed\n");
+    return;
+  }
+  printf("RMS error [m] against the truth, after the take off:\n");
+  printf("  %-10s %8s %8s %8s\n", "", "x", "y", "z");
+  printf("  %-10s", "estimate");
+  for (int i = 0; i < 3; i++) {
+    printf(" %8.4f", sqrt(estimateSquares[i] / errorCount));
+  }
+  printf("\n  %-10s", "tracking");
+  for (int i = 0; i < 3; i++) {
+    printf(" %8.4f", sqrt(trackingSquares[i] / errorCount));
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+  double speed = 1;
+  double duration = 20;
+  int port = UDP_PORT;
+  StateEstimatorType estimator = kalmanEstimator;
+  uint32_t seed = 1;
+  char *params[MAX_PARAMS];
+  int paramCount = 0;
+
+  for (int arg = 1; arg < argc; arg++) {
+    const char *value = arg + 1 < argc ? argv[arg + 1] : NULL;
+    if (strcmp(argv[arg], "-v") == 0) {
+      hostLogLevel = ESP_LOG_DEBUG;
+      continue;
+    }
+    if (value == NULL) {
+      usage(argv[0]);
+    }
+    arg++;
+    if (strcmp(argv[arg - 1], "-s") == 0) {
+      speed = atof(value);
+    } else if (strcmp(argv[arg - 1], "-t") == 0) {
+      duration = atof(value);
+    } else if (strcmp(argv[arg - 1], "-u") == 0) {
+      port = atoi(value);
+    } else if (strcmp(argv[arg - 1], "-e") == 0 && strcmp(value, "kalman") == 0) {
+      estimator = kalmanEstimator;
+    } else if (strcmp(argv[arg - 1], "-e") == 0 && strcmp(value, "complementary") == 0) {
+      estimator = complementaryEstimator;
+    } else if (strcmp(argv[arg - 1], "-f") == 0 && strcmp(value, "hover") == 0) {
+      plan = planHover;
+    } else if (strcmp(argv[arg - 1], "-f") == 0 && strcmp(value, "circle") == 0) {
+      plan = planCircle;
+    } else if (strcmp(argv[arg - 1], "-z") == 0) {
+      height = atof(value);
+    } else if (strcmp(argv[arg - 1], "-p") == 0 && paramCount < MAX_PARAMS) {
+      params[paramCount++] = argv[arg];
+    } else if (strcmp(argv[arg - 1], "-S") == 0) {
+      seed = strtoul(value, NULL, 0);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (speed < 0 || duration <= 0 || port <= 0 || port > 65535) {
+    usage(argv[0]);
+  }
+
+  if (!hostWifiOpen(port)) {
+    fprintf(stderr, "Cannot open UDP port %d\n", port);
+    return 1;
+  }
+
+  // As system.c brings the flight stack up
+  hostTick = BOOT_TICKS;
+  physicsInit(seed);
+  estimatorKalmanTaskInit();
+  stabilizerInit(estimator);
+  startTelemetry();
+  useMocap = (getStateEstimator() == kalmanEstimator);
+
+  for (int i = 0; i < paramCount; i++) {
+    char *name = strchr(params[i], '.');
+    char *value = strchr(params[i], '=');
+    if (name == NULL || value == NULL || value < name) {
+      usage(argv[0]);
+    }
+    *name++ = '\0';
+    *value++ = '\0';
+    if (!hostParamSet(params[i], name, value)) {
+      fprintf(stderr, "No parameter %s.%s\n", params[i], name);
+      return 1;
+    }
+  }
+
+  printf("Flying %s with the %s estimator, telemetry on UDP port %d\n", plan == planCircle ? "a circle" : "a hover",
+         stateEstimatorGetName(), port);
+
+  const uint32_t ticks = BOOT_TICKS + (uint32_t)(duration * configTICK_RATE_HZ);
+  const uint64_t tickNs = speed > 0 ? (uint64_t)(1e9 / configTICK_RATE_HZ / speed) : 0;
+  const uint64_t start = hostNowNs();
+  uint64_t deadline = start;
+
+  while (hostTick < ticks) {
+    hostTick++;
+    hostStartTick();
+    physicsStep();
+    feedMocap();
+    hostWifiReceive();
+    hostRunTasks();
+    hostWifiSend();
+    sumErrors();
+
+    if (tickNs > 0) {
+      deadline += tickNs;
+      struct timespec wake = {.tv_sec = deadline / 1000000000u, .tv_nsec = deadline % 1000000000u};
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+    }
+  }
+
+  report(hostNowNs() - start);
+  return 0;
+}
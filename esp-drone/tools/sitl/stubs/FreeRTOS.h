@@ -0,0 +1,54 @@
+/*
+ * FreeRTOS.h - Host stand-in for the FreeRTOS kernel used by the SITL build
+ *
+ * The firmware tasks run as coroutines of the simulation: every simulated
+ * 1 ms tick, hostRunTasks() resumes the tasks that are ready, highest
+ * priority first, until each of them blocks again on a delay, a queue or a
+ * semaphore. The tick is advanced by the simulation.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef TickType_t portTickType;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef BaseType_t portBASE_TYPE;
+typedef uint8_t StackType_t;
+typedef struct { int unused; } StaticTask_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct hostTask_s *TaskHandle_t;
+typedef TaskHandle_t xTaskHandle;
+
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(MS) ((TickType_t)(MS) * configTICK_RATE_HZ / 1000)
+
+#ifndef pdFALSE
+// Spelled as in stm32_legacy.h, which redefines them
+#define pdFALSE			( ( BaseType_t ) 0 )
+#define pdTRUE			( ( BaseType_t ) 1 )
+
+#define pdPASS			( pdTRUE )
+#define pdFAIL			( pdFALSE )
+#endif
+
+// A single thread runs the simulation, the spinlocks have nothing to exclude
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portMUX_INITIALIZE(mux) ((void)(mux))
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux) ((void)(mux))
+#define taskENTER_CRITICAL(mux) ((void)(mux))
+#define taskEXIT_CRITICAL(mux) ((void)(mux))
+
+/* Host scheduler, implemented by host.c */
+extern TickType_t hostTick;
+void hostRunTasks(void);
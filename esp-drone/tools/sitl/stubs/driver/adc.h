@@ -0,0 +1,4 @@
+/*
+ * driver/adc.h - Host stand-in for the ESP-IDF ADC driver, for pm_esplane.h
+ */
+#pragma once
@@ -0,0 +1,8 @@
+/*
+ * driver/ledc.h - Host stand-in for the ESP-IDF LED PWM driver, for motors.h
+ */
+#pragma once
+
+typedef enum {
+  LEDC_TIMER_8_BIT = 8,
+} ledc_timer_bit_t;
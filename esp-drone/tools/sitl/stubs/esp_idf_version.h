@@ -0,0 +1,4 @@
+/*
+ * esp_idf_version.h - Host stand-in for the ESP-IDF version, for pm_esplane.h
+ */
+#pragma once
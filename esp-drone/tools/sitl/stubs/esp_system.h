@@ -0,0 +1,11 @@
+/*
+ * esp_system.h - Host stand-in for the ESP-IDF system API
+ *
+ * The heap of the host is not measured, the simulation reports no heap use.
+ */
+#pragma once
+
+#include <stdint.h>
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
@@ -0,0 +1,12 @@
+/*
+ * esp_timer.h - Host stand-in for the ESP-IDF high resolution timer
+ *
+ * Counts simulated microseconds: the tick, plus the host time spent in the
+ * current tick (at most 999 us), so the stage timings of the stabilizer loop
+ * measure the flight stack on the host.
+ */
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
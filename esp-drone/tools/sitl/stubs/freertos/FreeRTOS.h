@@ -0,0 +1,6 @@
+/*
+ * freertos/FreeRTOS.h - Include path of the ESP-IDF FreeRTOS headers
+ */
+#pragma once
+
+#include "../FreeRTOS.h"
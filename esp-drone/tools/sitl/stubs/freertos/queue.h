@@ -0,0 +1,6 @@
+/*
+ * freertos/queue.h - Include path of the ESP-IDF FreeRTOS headers
+ */
+#pragma once
+
+#include "../queue.h"
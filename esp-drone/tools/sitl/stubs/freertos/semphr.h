@@ -0,0 +1,6 @@
+/*
+ * freertos/semphr.h - Include path of the ESP-IDF FreeRTOS headers
+ */
+#pragma once
+
+#include "../semphr.h"
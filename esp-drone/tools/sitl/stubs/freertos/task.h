@@ -0,0 +1,6 @@
+/*
+ * freertos/task.h - Include path of the ESP-IDF FreeRTOS headers
+ */
+#pragma once
+
+#include "../task.h"
@@ -0,0 +1,28 @@
+/*
+ * queue.h - Host stand-in for the FreeRTOS queues
+ *
+ * Blocking on a queue from a task suspends it until the queue changes or the
+ * timeout expires, blocking outside of the tasks fails at once.
+ */
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct hostQueue_s *QueueHandle_t;
+typedef QueueHandle_t xQueueHandle;
+typedef struct { int unused; } StaticQueue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout);
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t timeout);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t timeout);
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t timeout);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+// The storage is allocated by the host, the static buffers are not used
+#define xQueueCreateStatic(LENGTH, ITEM_SIZE, STORAGE, BUFFER) ((void)(STORAGE), (void)(BUFFER), xQueueCreate((LENGTH), (ITEM_SIZE)))
+#define xQueueSendToBack xQueueSend
+#define xQueueSendFromISR(QUEUE, ITEM, WOKEN) xQueueSend((QUEUE), (ITEM), 0)
+#define xQueueOverwriteFromISR(QUEUE, ITEM, WOKEN) xQueueOverwrite((QUEUE), (ITEM))
@@ -0,0 +1,58 @@
+/*
+ * sdkconfig.h - Host configuration of the SITL build
+ *
+ * The menuconfig defaults of the flight stack and the telemetry. They can be
+ * overridden from the make command line, for instance
+ * make CONFIG="-DCONFIG_TELEMETRY_POSE_BATCH_SIZE=1".
+ */
+#pragma once
+
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_BASE_STACK_SIZE 1024
+#define CONFIG_TARGET_ESP32_S2_DRONE_V1_2 1
+
+#ifndef CONFIG_KALMAN_PREDICT_RATE_HZ
+#define CONFIG_KALMAN_PREDICT_RATE_HZ 100
+#endif
+
+#ifndef CONFIG_KALMAN_HISTORY_LENGTH
+#define CONFIG_KALMAN_HISTORY_LENGTH 8
+#endif
+
+// CONFIG_KALMAN_POSITION_DEADZONE is left out: the simulated motion capture
+// positions could not move the estimate within the dead zone
+
+#define CONFIG_CRTP_MAX_DATA_SIZE 30
+
+#ifndef CONFIG_WIFI_TX_PACKET_SIZE
+#define CONFIG_WIFI_TX_PACKET_SIZE 512
+#endif
+
+#ifndef CONFIG_WIFI_UDP_TX_POOL_SIZE
+#define CONFIG_WIFI_UDP_TX_POOL_SIZE 16
+#endif
+
+#ifndef CONFIG_WIFI_UDP_MAX_SUBSCRIBERS
+#define CONFIG_WIFI_UDP_MAX_SUBSCRIBERS 4
+#endif
+
+#define CONFIG_TELEMETRY_UDP_PACKETS 1
+#define CONFIG_TELEMETRY_POSE_EVENT_DRIVEN 1
+
+#ifndef CONFIG_TELEMETRY_POSE_RATE_HZ
+#define CONFIG_TELEMETRY_POSE_RATE_HZ 50
+#endif
+
+#ifndef CONFIG_TELEMETRY_POSE_BATCH_SIZE
+#define CONFIG_TELEMETRY_POSE_BATCH_SIZE 4
+#endif
+
+#ifndef CONFIG_TELEMETRY_POSE_BATCH_WINDOW_MS
+#define CONFIG_TELEMETRY_POSE_BATCH_WINDOW_MS 100
+#endif
+
+#define CONFIG_TELEMETRY_CONSOLE_PRINT 1
+
+#ifndef CONFIG_TELEMETRY_CONSOLE_VERBOSITY
+#define CONFIG_TELEMETRY_CONSOLE_VERBOSITY 0
+#endif
@@ -0,0 +1,26 @@
+/*
+ * semphr.h - Host stand-in for the FreeRTOS semaphores
+ *
+ * Taking an empty semaphore from a task suspends it until it is given or the
+ * timeout expires, taking one outside of the tasks fails at once. The mutexes
+ * are binary semaphores, a single thread runs the tasks.
+ */
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct hostSemaphore_s *SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+typedef struct { int unused; } StaticSemaphore_t;
+
+SemaphoreHandle_t hostSemaphoreCreate(int count, int max);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#define vSemaphoreCreateBinary(SEMAPHORE) ((SEMAPHORE) = hostSemaphoreCreate(1, 1))
+#define xSemaphoreCreateBinary() hostSemaphoreCreate(0, 1)
+#define xSemaphoreCreateMutex() hostSemaphoreCreate(1, 1)
+#define xSemaphoreCreateBinaryStatic(BUFFER) ((void)(BUFFER), hostSemaphoreCreate(0, 1))
+#define xSemaphoreCreateMutexStatic(BUFFER) ((void)(BUFFER), hostSemaphoreCreate(1, 1))
+#define xSemaphoreCreateCountingStatic(MAX, INITIAL, BUFFER) ((void)(BUFFER), hostSemaphoreCreate((INITIAL), (MAX)))
+#define xSemaphoreGiveFromISR(SEMAPHORE, WOKEN) xSemaphoreGive(SEMAPHORE)
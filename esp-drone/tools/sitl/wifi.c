@@ -0,0 +1,328 @@
+/*
+ * wifi.c - UDP link of the SITL build
+ *
+ * The API of wifi_esp32.h over a host UDP socket, with the packet format of
+ * the board: a client subscribes with its first valid packet, a handshake
+ * sets its rate divisor, time sync requests are answered at once, and every
+ * packet carries an additive checksum. The socket is polled once per tick by
+ * the main loop instead of by the rx and tx tasks.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "usec_time.h"
+#include "wifi_esp32.h"
+#include "host.h"
+
+#define UDP_TX_POOL_SIZE        CONFIG_WIFI_UDP_TX_POOL_SIZE
+#define UDP_MAX_SUBSCRIBERS     CONFIG_WIFI_UDP_MAX_SUBSCRIBERS
+#define UDP_HANDSHAKE_HEADER    0x01
+#define UDP_TIME_SYNC_HEADER    0x02
+#define UDP_TIME_SYNC_VERSION   3
+#define UDP_TIME_SYNC_TYPE      0x07
+#define UDP_EXT_SAMPLE_HEADER   0x03
+
+typedef struct {
+  bool active;
+  struct sockaddr_in addr;
+  uint8_t rateDivisor;
+  uint8_t rateCounter;
+  uint32_t lastSeen;
+} UDPSubscriber;
+
+typedef struct __attribute__((packed)) {
+  uint8_t header;
+  uint64_t clientSend;
+} TimeSyncRequest;
+
+typedef struct __attribute__((packed)) {
+  uint8_t version;
+  uint8_t type;
+  uint16_t seq;
+  uint64_t droneSend;
+  uint8_t rateDivisor;
+  uint64_t clientSend;
+  uint64_t droneReceive;
+  uint8_t cksum;
+} TimeSyncAnswer;
+
+static int sock = -1;
+static UDPSubscriber subscribers[UDP_MAX_SUBSCRIBERS];
+
+// The tx pool: free packets on a stack, queued ones in a ring, oldest first
+static UDPTxPacket txPool[UDP_TX_POOL_SIZE];
+static UDPTxPacket *txFree[UDP_TX_POOL_SIZE];
+static int txFreeCount;
+static UDPTxPacket *txQueue[UDP_TX_POOL_SIZE];
+static int txHead;
+static int txWaiting;
+
+static struct {
+  uint32_t txFull;
+  uint32_t txDrop;
+  uint32_t txError;
+  uint32_t rxIgnored;      // ext samples and CRTP, no consumer in the SITL
+} stats;
+
+static uint8_t calculateCksum(const void *data, size_t len)
+{
+  const uint8_t *c = data;
+  uint8_t cksum = 0;
+  for (size_t i = 0; i < len; i++) {
+    cksum += c[i];
+  }
+  return cksum;
+}
+
+bool hostWifiOpen(uint16_t port)
+{
+  for (int i = 0; i < UDP_TX_POOL_SIZE; i++) {
+    txFree[i] = &txPool[i];
+  }
+  txFreeCount = UDP_TX_POOL_SIZE;
+
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    perror("socket");
+    return false;
+  }
+  struct sockaddr_in addr = {0};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    perror("bind");
+    close(sock);
+    sock = -1;
+    return false;
+  }
+  fcntl(sock, F_SETFL, O_NONBLOCK);
+  return true;
+}
+
+static void subscribe(const struct sockaddr_in *addr, const uint8_t *data, int len)
+{
+  UDPSubscriber *slot = NULL;
+  for (int i = 0; i < UDP_MAX_SUBSCRIBERS; i++) {
+    UDPSubscriber *sub = &subscribers[i];
+    if (sub->active && sub->addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
+        sub->addr.sin_port == addr->sin_port) {
+      slot = sub;
+      break;
+    }
+  }
+
+  if (slot == NULL) {
+    // New client, take a free entry or the least recently seen one
+    slot = &subscribers[0];
+    for (int i = 0; i < UDP_MAX_SUBSCRIBERS; i++) {
+      if (!subscribers[i].active) {
+        slot = &subscribers[i];
+        break;
+      }
+      if (subscribers[i].lastSeen < slot->lastSeen) {
+        slot = &subscribers[i];
+      }
+    }
+    slot->active = true;
+    slot->addr = *addr;
+    slot->rateDivisor = 1;
+    slot->rateCounter = 0;
+    printf("New subscriber %s:%d\n", inet_ntoa(addr->sin_addr), ntohs(addr->sin_port));
+  }
+
+  if ((len == 1 || len == 2) && data[0] == UDP_HANDSHAKE_HEADER) {
+    slot->rateDivisor = (len == 2 && data[1] != 0) ? data[1] : 1;
+    slot->rateCounter = 0;
+  }
+  slot->lastSeen = xTaskGetTickCount();
+}
+
+static void answerTimeSync(const struct sockaddr_in *addr, const uint8_t *data, uint64_t receiveTime)
+{
+  static uint16_t seq = 0;
+  TimeSyncRequest request;
+  memcpy(&request, data, sizeof(request));
+
+  TimeSyncAnswer answer;
+  answer.version = UDP_TIME_SYNC_VERSION;
+  answer.type = UDP_TIME_SYNC_TYPE;
+  answer.seq = seq++;
+  answer.clientSend = request.clientSend;
+  answer.droneReceive = receiveTime;
+  answer.rateDivisor = 1;
+  answer.droneSend = usecTimestamp();
+  answer.cksum = calculateCksum(&answer, sizeof(answer) - 1);
+  sendto(sock, &answer, sizeof(answer), 0, (const struct sockaddr *)addr, sizeof(*addr));
+}
+
+void hostWifiReceive(void)
+{
+  uint8_t buffer[WIFI_RX_PACKET_SIZE + 1];
+  struct sockaddr_in from;
+  socklen_t fromLen = sizeof(from);
+  int len;
+
+  while (sock >= 0 &&
+         (len = recvfrom(sock, buffer, sizeof(buffer), 0, (struct sockaddr *)&from, &fromLen)) >= 0) {
+    uint64_t receiveTime = usecTimestamp();
+    fromLen = sizeof(from);
+    if (len < 2 || len > WIFI_RX_PACKET_SIZE || buffer[len - 1] != calculateCksum(buffer, len - 1)) {
+      continue;
+    }
+    len -= 1;
+    if (len == sizeof(TimeSyncRequest) && buffer[0] == UDP_TIME_SYNC_HEADER) {
+      answerTimeSync(&from, buffer, receiveTime);
+    } else if (buffer[0] == UDP_EXT_SAMPLE_HEADER) {
+      // The SITL feeds the estimator with the simulated positions itself
+      stats.rxIgnored++;
+    } else {
+      subscribe(&from, buffer, len);
+      if ((len != 1 && len != 2) || buffer[0] != UDP_HANDSHAKE_HEADER) {
+        stats.rxIgnored++;
+      }
+    }
+  }
+}
+
+void hostWifiSend(void)
+{
+  while (txWaiting > 0) {
+    UDPTxPacket *packet = txQueue[txHead];
+    txHead = (txHead + 1) % UDP_TX_POOL_SIZE;
+    txWaiting--;
+
+    packet->data[packet->size] = calculateCksum(packet->data, packet->size);
+    for (int i = 0; i < UDP_MAX_SUBSCRIBERS; i++) {
+      UDPSubscriber *sub = &subscribers[i];
+      if (!sub->active) {
+        continue;
+      }
+      if (packet->flags & WIFI_TX_FLAG_RATE_LIMITED) {
+        if (++sub->rateCounter < sub->rateDivisor) {
+          continue;
+        }
+        sub->rateCounter = 0;
+      }
+      if (sendto(sock, packet->data, packet->size + 1, 0, (struct sockaddr *)&sub->addr, sizeof(sub->addr)) < 0) {
+        stats.txError++;
+      }
+    }
+    wifiReleaseTxPacket(packet);
+  }
+}
+
+/* wifi_esp32.h */
+
+void wifiInit(void)
+{
+}
+
+bool wifiTest(void)
+{
+  return sock >= 0;
+}
+
+UDPTxPacket *wifiClaimTxPacket(uint32_t timeout)
+{
+  // Nothing frees a packet before the main loop sends them, no use waiting
+  if (txFreeCount == 0) {
+    stats.txFull++;
+    return NULL;
+  }
+  UDPTxPacket *packet = txFree[--txFreeCount];
+  packet->size = 0;
+  packet->flags = 0;
+  return packet;
+}
+
+UDPTxPacket *wifiClaimTxPacketDropOldest(void)
+{
+  UDPTxPacket *packet;
+  if (txFreeCount > 0) {
+    packet = txFree[--txFreeCount];
+  } else if (txWaiting > 0) {
+    // Pool exhausted, reuse the oldest packet still waiting to be sent
+    packet = txQueue[txHead];
+    txHead = (txHead + 1) % UDP_TX_POOL_SIZE;
+    txWaiting--;
+    stats.txDrop++;
+  } else {
+    stats.txFull++;
+    return NULL;
+  }
+  packet->size = 0;
+  packet->flags = 0;
+  return packet;
+}
+
+bool wifiSendTxPacket(UDPTxPacket *packet)
+{
+  if (packet->size > WIFI_TX_PACKET_SIZE) {
+    wifiReleaseTxPacket(packet);
+    return false;
+  }
+  txQueue[(txHead + txWaiting) % UDP_TX_POOL_SIZE] = packet;
+  txWaiting++;
+  return true;
+}
+
+void wifiReleaseTxPacket(UDPTxPacket *packet)
+{
+  txFree[txFreeCount++] = packet;
+}
+
+void wifiGetLinkStats(WifiLinkStats *link)
+{
+  link->txError = stats.txError;
+  link->txFull = stats.txFull;
+  link->txDrop = stats.txDrop;
+  link->txWaiting = txWaiting;
+  link->txPoolSize = UDP_TX_POOL_SIZE;
+  link->stations = 0;
+  link->rssi = 0;
+  for (int i = 0; i < UDP_MAX_SUBSCRIBERS; i++) {
+    link->stations += subscribers[i].active;
+  }
+}
+
+uint16_t wifiGetTxWaiting(void)
+{
+  return txWaiting;
+}
+
+bool wifiSendData(uint32_t size, uint8_t *data)
+{
+  if (size > WIFI_TX_PACKET_SIZE) {
+    return false;
+  }
+  UDPTxPacket *packet = wifiClaimTxPacket(0);
+  if (packet == NULL) {
+    return false;
+  }
+  packet->size = size;
+  memcpy(packet->data, data, size);
+  return wifiSendTxPacket(packet);
+}
+
+bool wifiSendDataDropOldest(uint32_t size, uint8_t *data)
+{
+  if (size > WIFI_TX_PACKET_SIZE) {
+    return false;
+  }
+  UDPTxPacket *packet = wifiClaimTxPacketDropOldest();
+  if (packet == NULL) {
+    return false;
+  }
+  packet->size = size;
+  memcpy(packet->data, data, size);
+  return wifiSendTxPacket(packet);
+}
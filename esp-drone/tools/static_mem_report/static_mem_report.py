@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""
+Reports the RAM taken by the statically allocated tasks, queues and
+semaphores of the firmware, read from the symbols of the ELF.
+
+The STATIC_MEM_* macros of static_mem.h name their variables osSys_<name>
+followed by the kind of memory: StackBuffer and TaskBuffer for a task,
+Storage and Mgm for a queue, Mgm alone for a semaphore. The objects are
+reported by name, the tasks first:
+
+    static_mem_report.py --nm xtensa-esp32s3-elf-nm build/ESPDrone.elf
+
+It is also run by the static_mem_report target of the build:
+
+    idf.py static_mem_report
+"""
+import argparse
+import subprocess
+import sys
+from typing import Dict, List, Tuple
+
+PREFIX = "osSys_"
+# Symbol suffix, and the column it is counted in
+KINDS = (
+    ("StackBuffer", "stack"),
+    ("TaskBuffer", "tcb"),
+    ("Storage", "storage"),
+    ("Mgm", "control"),
+)
+COLUMNS = ("stack", "tcb", "storage", "control")
+
+
+def read_symbols(nm: str, elf: str) -> List[Tuple[str, int]]:
+    output = subprocess.run([nm, "--print-size", elf], check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        fields = line.split()
+        # address, size, type, name; symbols without a size have no second field
+        if len(fields) == 4 and fields[3].startswith(PREFIX):
+            symbols.append((fields[3][len(PREFIX):], int(fields[1], 16)))
+    return symbols
+
+
+def group(symbols: List[Tuple[str, int]]) -> Dict[str, Dict[str, int]]:
+    objects: Dict[str, Dict[str, int]] = {}
+    for symbol, size in symbols:
+        for suffix, column in KINDS:
+            if symbol.endswith(suffix):
+                name = symbol[:-len(suffix)]
+                sizes = objects.setdefault(name, dict.fromkeys(COLUMNS, 0))
+                # Static objects of the same name in several files add up
+                sizes[column] += size
+                break
+    return objects
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="firmware ELF file")
+    parser.add_argument("--nm", default="nm", help="nm of the target toolchain")
+    args = parser.parse_args()
+
+    objects = group(read_symbols(args.nm, args.elf))
+    if not objects:
+        print(f"No {PREFIX}* symbols in {args.elf}", file=sys.stderr)
+        return 1
+
+    tasks = sorted((name for name, sizes in objects.items() if sizes["stack"]),
+                   key=lambda name: -objects[name]["stack"])
+    others = sorted((name for name, sizes in objects.items() if not sizes["stack"]),
+                    key=lambda name: -sum(objects[name].values()))
+
+    print(f"{'object':<28}" + "".join(f"{column:>9}" for column in COLUMNS) + f"{'total':>9}")
+    totals = dict.fromkeys(COLUMNS, 0)
+    for name in tasks + others:
+        sizes = objects[name]
+        print(f"{name:<28}" + "".join(f"{sizes[column]:>9}" for column in COLUMNS) + f"{sum(sizes.values()):>9}")
+        for column in COLUMNS:
+            totals[column] += sizes[column]
+    print(f"{'total':<28}" + "".join(f"{totals[column]:>9}" for column in COLUMNS) + f"{sum(totals.values()):>9}")
+
+    task_bytes = sum(sum(objects[name].values()) for name in tasks)
+    print(f"\ntasks ({len(tasks)}): {task_bytes} bytes, "
+          f"queues and semaphores ({len(others)}): {sum(totals.values()) - task_bytes} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())